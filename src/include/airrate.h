@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Time on air of a packet, worked out from the modulation parameters so the air rate
+ * tables in AirRateConfig.cpp are generated and checked at compile time rather than typed in.
+ * Everything is constexpr (C++11, one expression per function) and integer only.
+ *
+ * The packets are sent the way the drivers configure the radios: LoRa with an implicit
+ * header and no CRC, FLRC with a 32 bit sync word and 24 bit CRC, GFSK with a 16 bit
+ * sync word and no CRC. Coding rates are given as the denominator of 4/x.
+ */
+
+// Least time needed between the end of a packet and the start of the next slot, for the
+// radio to switch between TX and RX and for the RX's timer to land ahead of the packet
+#define AIRRATE_TURNAROUND_US 250
+
+constexpr uint32_t AirRateCeilDiv(uint32_t n, uint32_t d)
+{
+    return (n + d - 1) / d;
+}
+
+// Quarter symbols, to count the 4.25 symbol preamble overhead, to microseconds
+constexpr uint32_t AirRateQuarterSymbolsToUs(uint32_t quarterSymbols, uint8_t sf, uint32_t bwHz)
+{
+    return (uint32_t)((((uint64_t)quarterSymbols << sf) * 1000000ULL + 2ULL * bwHz) / (4ULL * bwHz));
+}
+
+constexpr uint32_t AirRateBitsToUs(uint32_t bits, uint32_t bitrate)
+{
+    return (uint32_t)(((uint64_t)bits * 1000000ULL + bitrate / 2) / bitrate);
+}
+
+// SX127x (AN1200.13), without low data rate optimisation
+constexpr uint32_t SX127xLoRaPayloadSymbols(uint8_t sf, uint8_t cr, uint8_t payloadLen)
+{
+    return 8 + ((8 * payloadLen + 28 - 20 > 4 * sf)
+        ? AirRateCeilDiv(8 * payloadLen + 28 - 20 - 4 * sf, 4 * sf) * cr
+        : 0);
+}
+
+constexpr uint32_t SX127xLoRaToaUs(uint32_t bwHz, uint8_t sf, uint8_t cr, uint8_t preambleLen, uint8_t payloadLen)
+{
+    return AirRateQuarterSymbolsToUs(4 * preambleLen + 17 + 4 * SX127xLoRaPayloadSymbols(sf, cr, payloadLen), sf, bwHz);
+}
+
+// SX126x, LR11xx and SX128x, which add 2 symbols to the preamble at SF5 and SF6 and
+// 8 bits to the payload above. The long interleaver codes the whole payload at 4/cr.
+constexpr uint32_t LoRaPayloadSymbols(uint8_t sf, uint8_t cr, bool longInterleave, uint8_t payloadLen)
+{
+    return longInterleave
+        ? AirRateCeilDiv((8 * payloadLen + (sf >= 7 ? 8 : 0)) * cr, 4 * sf)
+        : 8 + ((8 * payloadLen + (sf >= 7 ? 8 : 0) > 4 * sf)
+            ? AirRateCeilDiv(8 * payloadLen + (sf >= 7 ? 8 : 0) - 4 * sf, 4 * sf) * cr
+            : 0);
+}
+
+constexpr uint32_t LoRaToaUs(uint32_t bwHz, uint8_t sf, uint8_t cr, bool longInterleave, uint8_t preambleLen, uint8_t payloadLen)
+{
+    return AirRateQuarterSymbolsToUs(4 * preambleLen + (sf >= 7 ? 17 : 25) + 4 * LoRaPayloadSymbols(sf, cr, longInterleave, payloadLen), sf, bwHz);
+}
+
+// SX128x FLRC, crQuarters is the code rate in quarters: 2 for 1/2, 3 for 3/4 and 4 for uncoded.
+// The coded payload carries 6 tail bits.
+constexpr uint32_t FlrcToaUs(uint32_t bitrate, uint8_t crQuarters, uint8_t preambleBits, uint8_t payloadLen)
+{
+    return AirRateBitsToUs(preambleBits + 32 + ((crQuarters == 4)
+        ? 8 * (payloadLen + 3)
+        : AirRateCeilDiv((8 * (payloadLen + 3) + 6) * 4, crQuarters)), bitrate);
+}
+
+constexpr uint32_t GfskToaUs(uint32_t bitrate, uint8_t preambleBits, uint8_t payloadLen)
+{
+    return AirRateBitsToUs(preambleBits + 16 + 8 * payloadLen, bitrate);
+}
+
+// True if a packet of toaUs can be sent every interval, with the turnaround to spare
+constexpr bool AirRateIntervalFits(int32_t interval, uint32_t toaUs)
+{
+    return (int32_t)(toaUs + AIRRATE_TURNAROUND_US) <= interval;
+}
@@ -146,6 +146,8 @@ typedef enum : uint8_t
 #define DYNPOWER_SNR_THRESH_NONE -127
 #define SNR_SCALE(snr) ((int8_t)((float)snr * RADIO_SNR_SCALE))
 #define SNR_DESCALE(snrScaled) (snrScaled / RADIO_SNR_SCALE)
+// Packets failing the OTA CRC are only repaired if their SNR is this far over DynpowerSnrThreshUp
+#define OTA_REPAIR_SNR_MARGIN SNR_SCALE(3)
 // Bound is any of the last 4 bytes nonzero (unbound is all zeroes)
 #define UID_IS_BOUND(uid) (uid[2] != 0 || uid[3] != 0 || uid[4] != 0 || uid[5] != 0)
 
@@ -292,41 +294,21 @@ enum eAuxChannels : uint8_t
 
 #ifndef UNIT_TEST
 #if defined(RADIO_SX127X)
-#define RATE_MAX 6
-#define RATE_BINDING RATE_LORA_900_50HZ
-
 extern SX127xDriver Radio;
-
 #elif defined(RADIO_LR1121)
-#define RATE_MAX 20
-#define RATE_BINDING RATE_LORA_900_50HZ
-#define RATE_DUALBAND_BINDING RATE_LORA_2G4_50HZ
-
 extern LR1121Driver Radio;
-
 #elif defined(RADIO_SX128X)
-#define RATE_MAX 10     // 2xFLRC + 2xDVDA + 4xLoRa + 2xFullRes
-#define RATE_BINDING RATE_LORA_2G4_50HZ
-
 extern SX1280Driver Radio;
 #endif
 #endif // UNIT_TEST
 
-expresslrs_mod_settings_s *get_elrs_airRateConfig(uint8_t index);
-expresslrs_rf_pref_params_s *get_elrs_RFperfParams(uint8_t index);
-uint8_t get_elrs_HandsetRate_max(uint8_t rateIndex, uint32_t minInterval);
-
-uint8_t TLMratioEnumToValue(expresslrs_tlm_ratio_e const enumval);
-uint8_t TLMBurstMaxForRateRatio(uint16_t const rateHz, uint8_t const ratioDiv);
-uint8_t enumRatetoIndex(expresslrs_RFrates_e const eRate);
-
 extern uint8_t UID[UID_LEN];
 extern bool connectionHasModelMatch;
 extern bool teamraceHasModelMatch;
 extern bool InBindingMode;
 extern uint8_t ExpressLRS_currTlmDenom;
-extern expresslrs_mod_settings_s *ExpressLRS_currAirRate_Modparams;
-extern expresslrs_rf_pref_params_s *ExpressLRS_currAirRate_RFperfParams;
+extern expresslrs_mod_settings_s const *ExpressLRS_currAirRate_Modparams;
+extern expresslrs_rf_pref_params_s const *ExpressLRS_currAirRate_RFperfParams;
 extern uint32_t ChannelData[CRSF_NUM_CHANNELS]; // Current state of channels, CRSF format
 
 extern connectionState_e connectionState;
@@ -335,6 +317,8 @@ inline void setConnectionState(connectionState_e newState) {
     connectionState = newState;
     devicesTriggerEvent(EVENT_CONNECTION_CHANGED);
 }
+#else
+void setConnectionState(connectionState_e newState); // defined by the test
 #endif
 
 uint32_t uidMacSeedGet();
@@ -346,3 +330,5 @@ bool isSupportedRFRate(uint8_t index);
 #else
 inline bool isSupportedRFRate(uint8_t index) { return true; }
 #endif
+
+#include "AirRateConfig.h"
@@ -1,11 +1,28 @@
 #pragma once
 
-#include <functional>
+/**
+ * Call a function from the main loop once `us` microseconds have elapsed, passing it `ctx`.
+ * Neither form allocates, and both can be called from an ISR.
+ */
+void deferExecutionMicros(unsigned long us, void (*fn)(void *), void *ctx);
+void deferExecutionMicros(unsigned long us, void (*fn)());
 
-void deferExecutionMicros(unsigned long us, std::function<void()> f);
-void executeDeferredFunction(unsigned long now);
+/**
+ * Call a function that is normally called from an ISR, such as Radio.TXdoneCallback, once `us`
+ * microseconds have elapsed. It is called from a one-shot hardware timer's ISR where there is a
+ * spare timer (ESP32), otherwise from the main loop.
+ */
+void deferISRExecutionMicros(unsigned long us, void (*fn)());
 
-static inline void deferExecutionMillis(unsigned long ms, std::function<void()> f)
+// Returns the number of microseconds until the next deferred function is due, or -1 if there are none
+long executeDeferredFunction(unsigned long now);
+
+static inline void deferExecutionMillis(unsigned long ms, void (*fn)(void *), void *ctx)
+{
+    deferExecutionMicros(ms * 1000, fn, ctx);
+}
+
+static inline void deferExecutionMillis(unsigned long ms, void (*fn)())
 {
-    deferExecutionMicros(ms * 1000, f);
-}
\ No newline at end of file
+    deferExecutionMicros(ms * 1000, fn);
+}
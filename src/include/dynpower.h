@@ -6,9 +6,9 @@
 #include <CRSF.h>
 #include <logging.h>
 
-#if defined(TARGET_TX)
+#if defined(TARGET_TX) || defined(UNIT_TEST)
 
-#include <MeanAccumulator.h>
+#include <DynamicPowerController.h>
 
 #define DYNPOWER_UPDATE_NOUPDATE -128
 #define DYNPOWER_UPDATE_MISSED   -127
@@ -20,7 +20,7 @@ void DynamicPower_Update(uint32_t now);
 // Call DynamicPower_TelemetryUpdate from ISR with DYNPOWER_UPDATE_MISSED or ScaledSNR value
 void DynamicPower_TelemetryUpdate(int8_t snrScaled);
 
-#endif // TARGET_TX
+#endif // TARGET_TX || UNIT_TEST
 
 #if defined(TARGET_RX)
 
@@ -85,7 +85,16 @@ static Stream *SerialLogger = &Serial;
 inline void interrupts() {}
 inline void noInterrupts() {}
 
+// A test can run the firmware on its own clock by setting this
+typedef unsigned long (*native_micros_fn_t)();
+inline native_micros_fn_t &nativeMicrosSource() {
+    static native_micros_fn_t source = nullptr;
+    return source;
+}
+
 inline unsigned long micros() {
+    if (nativeMicrosSource())
+        return nativeMicrosSource()();
     struct timeval tv;
     gettimeofday(&tv,NULL);
     return tv.tv_sec*(uint64_t)1000000+tv.tv_usec;
@@ -96,7 +105,7 @@ inline void delay(int32_t time) {
 }
 
 #define bit(x) (1 << (x))
-inline unsigned long millis() { return 0; }
+inline unsigned long millis() { return nativeMicrosSource() ? nativeMicrosSource()() / 1000 : 0; }
 inline void delayMicroseconds(int delay) { }
 inline char *itoa(int32_t value, char *str, int base) { sprintf(str, "%d", value); return str; }
 inline char *utoa(uint32_t value, char *str, int base) { sprintf(str, "%u", value); return str; }
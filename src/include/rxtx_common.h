@@ -7,11 +7,28 @@
 #include "FHSS.h"
 #include "helpers.h"
 #include "hwTimer.h"
+#include "ISRProfile.h"
 #include "logging.h"
 #include "LBT.h"
 #include "LQCALC.h"
+#include "LQSTATS.h"
 #include "OTA.h"
 #include "POWERMGNT.h"
 #include "deferred.h"
 
 void setupTargetCommon();
+
+/**
+ * @brief Idle the CPU at the end of the main loop until the next device timeout or
+ * deferred function is due, for at most a millisecond, or until loopWakeFromISR().
+ *
+ * @param deviceDelayMs the return of devicesUpdate()
+ * @param deferredDelayUs the return of executeDeferredFunction()
+ */
+void loopIdle(int deviceDelayMs, long deferredDelayUs);
+
+/**
+ * @brief Wake the main loop from loopIdle(), called from the radio ISRs when there is
+ * work for the loop.
+ */
+void loopWakeFromISR();
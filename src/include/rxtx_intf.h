@@ -5,15 +5,45 @@
 
 #include "common.h"
 
+void loopWakeFromISR(); // rxtx_common.cpp
+
 /***
  * TX interface
  ***/
-#if defined(TARGET_TX)
+#if defined(TARGET_TX) || defined(UNIT_TEST)
+// Settings the TX link (lib/RFLink) reads from the TX config
+uint8_t getTxRate();
+expresslrs_tlm_ratio_e getTxTlm();
+uint8_t getTxSwitchMode();
+uint8_t getTxLinkMode();
+bool getTxModelMatch();
+uint8_t getTxAntennaMode();
+void setTxAntennaMode(uint8_t mode);
+void switchDiversityAntennas();
+// Called when the first telemetry is received after the link came up
+void OnDownlinkConnected();
 #endif
 
 /***
  * RX interface
  ***/
-#if defined(TARGET_RX)
+#if defined(TARGET_RX) || defined(UNIT_TEST)
 uint8_t getLq();
+// Settings the RX link (lib/RFLink) reads from the RX config
+bool getRxForceTlmOff();
+eSerialProtocol getRxSerialProtocol();
+uint8_t getRxModelId();
+bool getRxLockOnFirstConnection();
+void checkGeminiMode();
+void updateDiversity();
+void OnELRSBindMSP(uint8_t *newUid4);
+// A SYNC from the TX with the TX's link mode and antenna mode
+void OnRxSyncSettings(uint8_t otaProtocol, uint8_t geminiMode);
+void OnRxTentativeConnection();
+void OnRxGotConnection();
+
+void crsfRCFrameAvailable();      // devSerialIO.cpp
+void crsfRCFrameMissed();         // devSerialIO.cpp
+void sendImmediateRC();           // devSerialIO.cpp
+void servoNewChannelsAvailable(); // devServoOutput.cpp
 #endif
@@ -0,0 +1,271 @@
+#include "targets.h"
+#include "AirRateConfig.h"
+#include "OTA.h"
+#include "airrate.h"
+
+// The time on air of each rate is worked out from its ExpressLRS_AirRateConfig entry
+#define RATE_TOA(index) AirRateToaUs(ExpressLRS_AirRateConfig[index])
+
+#if defined(RADIO_SX127X)
+
+#include "SX127xDriver.h"
+
+constexpr expresslrs_mod_settings_s ExpressLRS_AirRateConfig[RATE_MAX] = {
+    {0, RADIO_TYPE_SX127x_LORA, RATE_LORA_900_200HZ,     SX127x_BW_500_00_KHZ, SX127x_SF_6, SX127x_CR_4_7,  8, TLM_RATIO_1_64, 4,  5000, OTA4_PACKET_SIZE, 1},
+    {1, RADIO_TYPE_SX127x_LORA, RATE_LORA_900_100HZ_8CH, SX127x_BW_500_00_KHZ, SX127x_SF_6, SX127x_CR_4_8,  8, TLM_RATIO_1_32, 4, 10000, OTA8_PACKET_SIZE, 1},
+    {2, RADIO_TYPE_SX127x_LORA, RATE_LORA_900_100HZ,     SX127x_BW_500_00_KHZ, SX127x_SF_7, SX127x_CR_4_7,  8, TLM_RATIO_1_32, 4, 10000, OTA4_PACKET_SIZE, 1},
+    {3, RADIO_TYPE_SX127x_LORA, RATE_LORA_900_50HZ,      SX127x_BW_500_00_KHZ, SX127x_SF_8, SX127x_CR_4_7, 10, TLM_RATIO_1_16, 4, 20000, OTA4_PACKET_SIZE, 1},
+    {4, RADIO_TYPE_SX127x_LORA, RATE_LORA_900_25HZ,      SX127x_BW_500_00_KHZ, SX127x_SF_9, SX127x_CR_4_7, 10, TLM_RATIO_1_8,  2, 40000, OTA4_PACKET_SIZE, 1},
+    {5, RADIO_TYPE_SX127x_LORA, RATE_LORA_900_50HZ_DVDA, SX127x_BW_500_00_KHZ, SX127x_SF_6, SX127x_CR_4_7,  8, TLM_RATIO_1_64, 2,  5000, OTA4_PACKET_SIZE, 4}};
+
+constexpr uint32_t AirRateToaUs(expresslrs_mod_settings_s const &ModParams)
+{
+    return SX127xLoRaToaUs(
+        ModParams.bw == SX127x_BW_125_00_KHZ ? 125000 : ModParams.bw == SX127x_BW_250_00_KHZ ? 250000 : 500000,
+        ModParams.sf >> 4,
+        ModParams.cr == SX127x_CR_4_5 ? 5 : ModParams.cr == SX127x_CR_4_6 ? 6 : ModParams.cr == SX127x_CR_4_7 ? 7 : 8,
+        ModParams.PreambleLen, ModParams.PayloadLength);
+}
+
+constexpr expresslrs_rf_pref_params_s ExpressLRS_AirRateRFperf[RATE_MAX] = {
+    {0, -112, RATE_TOA(0), 3000, 2500, 600, 5000, SNR_SCALE( 1), SNR_SCALE(3.0)},
+    {1, -112, RATE_TOA(1), 3500, 2500, 600, 5000, SNR_SCALE( 1), SNR_SCALE(3.0)},
+    {2, -117, RATE_TOA(2), 3500, 2500, 600, 5000, SNR_SCALE( 1), SNR_SCALE(2.5)},
+    {3, -120, RATE_TOA(3), 4000, 2500, 600, 5000, SNR_SCALE(-1), SNR_SCALE(1.5)},
+    {4, -123, RATE_TOA(4), 6000, 4000, 600, 5000, SNR_SCALE(-3), SNR_SCALE(0.5)},
+    {5, -112, RATE_TOA(5), 3000, 2500, 600, 5000, SNR_SCALE( 1), SNR_SCALE(3.0)}};
+#endif
+
+#if defined(RADIO_LR1121)
+
+#include "LR1121Driver.h"
+
+constexpr expresslrs_mod_settings_s ExpressLRS_AirRateConfig[RATE_MAX] = {
+    {0,  RADIO_TYPE_LR1121_GFSK_900,  RATE_FSK_900_1000HZ_8CH,  LR11XX_RADIO_GFSK_BITRATE_300k, LR11XX_RADIO_GFSK_BW_467000, LR11XX_RADIO_GFSK_FDEV_100k, 16, LR11XX_RADIO_GFSK_BITRATE_300k, LR11XX_RADIO_GFSK_BW_467000, LR11XX_RADIO_GFSK_FDEV_100k, 16, TLM_RATIO_1_128, 2,  1000, OTA8_PACKET_SIZE, 1},
+    {1,  RADIO_TYPE_LR1121_LORA_900,  RATE_LORA_900_250HZ,      LR11XX_RADIO_LORA_BW_500,       LR11XX_RADIO_LORA_SF5,       LR11XX_RADIO_LORA_CR_4_8,     8, LR11XX_RADIO_LORA_BW_500,       LR11XX_RADIO_LORA_SF5,       LR11XX_RADIO_LORA_CR_4_8,     8, TLM_RATIO_1_64,  4,  4000, OTA4_PACKET_SIZE, 1},
+    {2,  RADIO_TYPE_LR1121_LORA_900,  RATE_LORA_900_200HZ_8CH,  LR11XX_RADIO_LORA_BW_500,       LR11XX_RADIO_LORA_SF5,       LR11XX_RADIO_LORA_CR_4_7,     8, LR11XX_RADIO_LORA_BW_500,       LR11XX_RADIO_LORA_SF5,       LR11XX_RADIO_LORA_CR_4_7,     8, TLM_RATIO_1_64,  4,  5000, OTA8_PACKET_SIZE, 1},
+    {3,  RADIO_TYPE_LR1121_LORA_900,  RATE_LORA_900_200HZ,      LR11XX_RADIO_LORA_BW_500,       LR11XX_RADIO_LORA_SF6,       LR11XX_RADIO_LORA_CR_4_7,     8, LR11XX_RADIO_LORA_BW_500,       LR11XX_RADIO_LORA_SF6,       LR11XX_RADIO_LORA_CR_4_7,     8, TLM_RATIO_1_64,  4,  5000, OTA4_PACKET_SIZE, 1},
+    {4,  RADIO_TYPE_LR1121_LORA_900,  RATE_LORA_900_100HZ_8CH,  LR11XX_RADIO_LORA_BW_500,       LR11XX_RADIO_LORA_SF6,       LR11XX_RADIO_LORA_CR_4_8,     8, LR11XX_RADIO_LORA_BW_500,       LR11XX_RADIO_LORA_SF6,       LR11XX_RADIO_LORA_CR_4_8,     8, TLM_RATIO_1_32,  4, 10000, OTA8_PACKET_SIZE, 1},
+    {5,  RADIO_TYPE_LR1121_LORA_900,  RATE_LORA_900_100HZ,      LR11XX_RADIO_LORA_BW_500,       LR11XX_RADIO_LORA_SF7,       LR11XX_RADIO_LORA_CR_4_7,     8, LR11XX_RADIO_LORA_BW_500,       LR11XX_RADIO_LORA_SF7,       LR11XX_RADIO_LORA_CR_4_7,     8, TLM_RATIO_1_32,  4, 10000, OTA4_PACKET_SIZE, 1},
+    {6,  RADIO_TYPE_LR1121_LORA_900,  RATE_LORA_900_50HZ,       LR11XX_RADIO_LORA_BW_500,       LR11XX_RADIO_LORA_SF8,       LR11XX_RADIO_LORA_CR_4_7,    10, LR11XX_RADIO_LORA_BW_500,       LR11XX_RADIO_LORA_SF8,       LR11XX_RADIO_LORA_CR_4_7,    10, TLM_RATIO_1_16,  4, 20000, OTA4_PACKET_SIZE, 1},
+    {7,  RADIO_TYPE_LR1121_LORA_900,  RATE_LORA_900_25HZ,       LR11XX_RADIO_LORA_BW_500,       LR11XX_RADIO_LORA_SF9,       LR11XX_RADIO_LORA_CR_4_7,    10, LR11XX_RADIO_LORA_BW_500,       LR11XX_RADIO_LORA_SF9,       LR11XX_RADIO_LORA_CR_4_7,    10, TLM_RATIO_1_8,   2, 40000, OTA4_PACKET_SIZE, 1},
+    {8,  RADIO_TYPE_LR1121_LORA_900,  RATE_LORA_900_50HZ_DVDA,  LR11XX_RADIO_LORA_BW_500,       LR11XX_RADIO_LORA_SF6,       LR11XX_RADIO_LORA_CR_4_7,     8, LR11XX_RADIO_LORA_BW_500,       LR11XX_RADIO_LORA_SF6,       LR11XX_RADIO_LORA_CR_4_7,     8, TLM_RATIO_1_64,  2,  5000, OTA4_PACKET_SIZE, 4},
+    {9,  RADIO_TYPE_LR1121_GFSK_2G4,  RATE_FSK_2G4_1000HZ,      LR11XX_RADIO_GFSK_BITRATE_300k, LR11XX_RADIO_GFSK_BW_467000, LR11XX_RADIO_GFSK_FDEV_100k, 16, LR11XX_RADIO_GFSK_BITRATE_300k, LR11XX_RADIO_GFSK_BW_467000, LR11XX_RADIO_GFSK_FDEV_100k, 16, TLM_RATIO_1_128, 2,  1000, OTA4_PACKET_SIZE, 1},
+    {10, RADIO_TYPE_LR1121_GFSK_2G4,  RATE_FSK_2G4_500HZ_DVDA,  LR11XX_RADIO_GFSK_BITRATE_300k, LR11XX_RADIO_GFSK_BW_467000, LR11XX_RADIO_GFSK_FDEV_100k, 16, LR11XX_RADIO_GFSK_BITRATE_300k, LR11XX_RADIO_GFSK_BW_467000, LR11XX_RADIO_GFSK_FDEV_100k, 16, TLM_RATIO_1_128, 2,  1000, OTA4_PACKET_SIZE, 2},
+    {11, RADIO_TYPE_LR1121_GFSK_2G4,  RATE_FSK_2G4_250HZ_DVDA,  LR11XX_RADIO_GFSK_BITRATE_300k, LR11XX_RADIO_GFSK_BW_467000, LR11XX_RADIO_GFSK_FDEV_100k, 16, LR11XX_RADIO_GFSK_BITRATE_300k, LR11XX_RADIO_GFSK_BW_467000, LR11XX_RADIO_GFSK_FDEV_100k, 16, TLM_RATIO_1_128, 2,  1000, OTA4_PACKET_SIZE, 4},
+    {12, RADIO_TYPE_LR1121_LORA_2G4,  RATE_LORA_2G4_500HZ,      LR11XX_RADIO_LORA_BW_800,       LR11XX_RADIO_LORA_SF5,       LR11XX_RADIO_LORA_CR_LI_4_6, 12, LR11XX_RADIO_LORA_BW_800,       LR11XX_RADIO_LORA_SF5,       LR11XX_RADIO_LORA_CR_LI_4_6, 12, TLM_RATIO_1_128, 4,  2000, OTA4_PACKET_SIZE, 1},
+    {13, RADIO_TYPE_LR1121_LORA_2G4,  RATE_LORA_2G4_333HZ_8CH,  LR11XX_RADIO_LORA_BW_800,       LR11XX_RADIO_LORA_SF5,       LR11XX_RADIO_LORA_CR_LI_4_8, 12, LR11XX_RADIO_LORA_BW_800,       LR11XX_RADIO_LORA_SF5,       LR11XX_RADIO_LORA_CR_LI_4_8, 12, TLM_RATIO_1_128, 4,  3003, OTA8_PACKET_SIZE, 1},
+    {14, RADIO_TYPE_LR1121_LORA_2G4,  RATE_LORA_2G4_250HZ,      LR11XX_RADIO_LORA_BW_800,       LR11XX_RADIO_LORA_SF6,       LR11XX_RADIO_LORA_CR_LI_4_8, 14, LR11XX_RADIO_LORA_BW_800,       LR11XX_RADIO_LORA_SF6,       LR11XX_RADIO_LORA_CR_LI_4_8, 14, TLM_RATIO_1_64,  4,  4000, OTA4_PACKET_SIZE, 1},
+    {15, RADIO_TYPE_LR1121_LORA_2G4,  RATE_LORA_2G4_150HZ,      LR11XX_RADIO_LORA_BW_800,       LR11XX_RADIO_LORA_SF7,       LR11XX_RADIO_LORA_CR_LI_4_8, 12, LR11XX_RADIO_LORA_BW_800,       LR11XX_RADIO_LORA_SF7,       LR11XX_RADIO_LORA_CR_LI_4_8, 12, TLM_RATIO_1_32,  4,  6666, OTA4_PACKET_SIZE, 1},
+    {16, RADIO_TYPE_LR1121_LORA_2G4,  RATE_LORA_2G4_100HZ_8CH,  LR11XX_RADIO_LORA_BW_800,       LR11XX_RADIO_LORA_SF7,       LR11XX_RADIO_LORA_CR_LI_4_8, 12, LR11XX_RADIO_LORA_BW_800,       LR11XX_RADIO_LORA_SF7,       LR11XX_RADIO_LORA_CR_LI_4_8, 12, TLM_RATIO_1_32,  4, 10000, OTA8_PACKET_SIZE, 1},
+    {17, RADIO_TYPE_LR1121_LORA_2G4,  RATE_LORA_2G4_50HZ,       LR11XX_RADIO_LORA_BW_800,       LR11XX_RADIO_LORA_SF8,       LR11XX_RADIO_LORA_CR_LI_4_8, 12, LR11XX_RADIO_LORA_BW_800,       LR11XX_RADIO_LORA_SF8,       LR11XX_RADIO_LORA_CR_LI_4_8, 12, TLM_RATIO_1_16,  2, 20000, OTA4_PACKET_SIZE, 1},
+    {18, RADIO_TYPE_LR1121_LORA_DUAL, RATE_LORA_DUAL_150HZ,     LR11XX_RADIO_LORA_BW_500,       LR11XX_RADIO_LORA_SF6,       LR11XX_RADIO_LORA_CR_4_8,    12, LR11XX_RADIO_LORA_BW_800,       LR11XX_RADIO_LORA_SF7,       LR11XX_RADIO_LORA_CR_LI_4_6, 12, TLM_RATIO_1_32,  4,  6666, OTA4_PACKET_SIZE, 1},
+    {19, RADIO_TYPE_LR1121_LORA_DUAL, RATE_LORA_DUAL_100HZ_8CH, LR11XX_RADIO_LORA_BW_500,       LR11XX_RADIO_LORA_SF6,       LR11XX_RADIO_LORA_CR_4_8,    18, LR11XX_RADIO_LORA_BW_800,       LR11XX_RADIO_LORA_SF7,       LR11XX_RADIO_LORA_CR_LI_4_8, 14, TLM_RATIO_1_32,  4, 10000, OTA8_PACKET_SIZE, 1}};
+
+constexpr uint32_t LR1121LoRaToaUs(uint8_t bw, uint8_t sf, uint8_t cr, uint8_t PreambleLen, uint8_t PayloadLength)
+{
+    return LoRaToaUs(
+        bw == LR11XX_RADIO_LORA_BW_800 ? 812000 : bw == LR11XX_RADIO_LORA_BW_500 ? 500000 :
+        bw == LR11XX_RADIO_LORA_BW_400 ? 406000 : bw == LR11XX_RADIO_LORA_BW_250 ? 250000 :
+        bw == LR11XX_RADIO_LORA_BW_200 ? 203000 : 125000,
+        sf,
+        cr == LR11XX_RADIO_LORA_CR_LI_4_8 ? 8 : cr >= LR11XX_RADIO_LORA_CR_LI_4_5 ? cr : cr + 4,
+        cr >= LR11XX_RADIO_LORA_CR_LI_4_5, PreambleLen, PayloadLength);
+}
+
+constexpr uint32_t AirRateToaUs(expresslrs_mod_settings_s const &ModParams)
+{
+    // GFSK bw is the bitrate in 10kbps, sent with FEC on 2.4GHz as 14 bytes (see LR1121Driver::Config())
+    return (ModParams.radio_type == RADIO_TYPE_LR1121_GFSK_900 || ModParams.radio_type == RADIO_TYPE_LR1121_GFSK_2G4)
+        ? GfskToaUs(ModParams.bw * 10000, ModParams.PreambleLen, ModParams.radio_type == RADIO_TYPE_LR1121_GFSK_2G4 ? 14 : ModParams.PayloadLength)
+        // Dual band sends on both at once, the second radio with the bw2/sf2/cr2 settings
+        : (ModParams.radio_type == RADIO_TYPE_LR1121_LORA_DUAL &&
+           LR1121LoRaToaUs(ModParams.bw2, ModParams.sf2, ModParams.cr2, ModParams.PreambleLen2, ModParams.PayloadLength) >
+           LR1121LoRaToaUs(ModParams.bw, ModParams.sf, ModParams.cr, ModParams.PreambleLen, ModParams.PayloadLength))
+        ? LR1121LoRaToaUs(ModParams.bw2, ModParams.sf2, ModParams.cr2, ModParams.PreambleLen2, ModParams.PayloadLength)
+        : LR1121LoRaToaUs(ModParams.bw, ModParams.sf, ModParams.cr, ModParams.PreambleLen, ModParams.PayloadLength);
+}
+
+constexpr expresslrs_rf_pref_params_s ExpressLRS_AirRateRFperf[RATE_MAX] = {
+    {0,  -101, RATE_TOA( 0), 2500, 2500,   3,  5000, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE},
+    {1,  -111, RATE_TOA( 1), 3500, 2500, 600,  5000, SNR_SCALE( 1), SNR_SCALE(3.0)}, // These SNR_SCALE values all need to be checked!
+    {2,  -111, RATE_TOA( 2), 3500, 2500, 600,  5000, SNR_SCALE( 1), SNR_SCALE(3.0)},
+    {3,  -112, RATE_TOA( 3), 3000, 2500, 600,  5000, SNR_SCALE( 1), SNR_SCALE(3.0)},
+    {4,  -112, RATE_TOA( 4), 3500, 2500, 600,  5000, SNR_SCALE( 1), SNR_SCALE(3.0)},
+    {5,  -117, RATE_TOA( 5), 3500, 2500, 600,  5000, SNR_SCALE( 1), SNR_SCALE(2.5)},
+    {6,  -120, RATE_TOA( 6), 4000, 2500, 600,  5000, SNR_SCALE(-1), SNR_SCALE(1.5)},
+    {7,  -123, RATE_TOA( 7), 6000, 4000, 600,  5000, SNR_SCALE(-3), SNR_SCALE(0.5)},
+    {8,  -112, RATE_TOA( 8), 3000, 2500, 600,  5000, SNR_SCALE( 1), SNR_SCALE(3.0)},
+    {9,  -103, RATE_TOA( 9), 2500, 2500,   3,  5000, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE},
+    {10, -103, RATE_TOA(10), 2500, 2500,   3,  5000, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE},
+    {11, -103, RATE_TOA(11), 2500, 2500,   3,  5000, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE},
+    {12, -105, RATE_TOA(12), 2500, 2500,   3,  5000, SNR_SCALE( 5), SNR_SCALE(9.5)},
+    {13, -105, RATE_TOA(13), 2500, 2500,   4,  5000, SNR_SCALE( 5), SNR_SCALE(9.5)},
+    {14, -108, RATE_TOA(14), 3000, 2500,   6,  5000, SNR_SCALE( 3), SNR_SCALE(9.5)},
+    {15, -112, RATE_TOA(15), 3500, 2500,  10,  5000, SNR_SCALE( 0), SNR_SCALE(8.5)},
+    {16, -112, RATE_TOA(16), 3500, 2500,  11,  5000, SNR_SCALE( 0), SNR_SCALE(8.5)},
+    {17, -115, RATE_TOA(17), 4000, 2500,   0,  5000, SNR_SCALE(-1), SNR_SCALE(6.5)},
+    {18, -112, RATE_TOA(18), 3500, 2500,  10,  5000, SNR_SCALE( 0), SNR_SCALE(8.5)},
+    {19, -112, RATE_TOA(19), 3500, 2500,  11,  5000, SNR_SCALE( 0), SNR_SCALE(8.5)}};
+#endif
+
+#if defined(RADIO_SX128X)
+
+#include "SX1280Driver.h"
+
+constexpr expresslrs_mod_settings_s ExpressLRS_AirRateConfig[RATE_MAX] = {
+    {0, RADIO_TYPE_SX128x_FLRC, RATE_FLRC_2G4_1000HZ,     SX1280_FLRC_BR_0_650_BW_0_6, SX1280_FLRC_BT_1, SX1280_FLRC_CR_1_2,    32, TLM_RATIO_1_128, 2,  1000, OTA4_PACKET_SIZE, 1},
+    {1, RADIO_TYPE_SX128x_FLRC, RATE_FLRC_2G4_500HZ,      SX1280_FLRC_BR_0_650_BW_0_6, SX1280_FLRC_BT_1, SX1280_FLRC_CR_1_2,    32, TLM_RATIO_1_128, 2,  2000, OTA4_PACKET_SIZE, 1},
+    {2, RADIO_TYPE_SX128x_FLRC, RATE_FLRC_2G4_500HZ_DVDA, SX1280_FLRC_BR_0_650_BW_0_6, SX1280_FLRC_BT_1, SX1280_FLRC_CR_1_2,    32, TLM_RATIO_1_128, 2,  1000, OTA4_PACKET_SIZE, 2},
+    {3, RADIO_TYPE_SX128x_FLRC, RATE_FLRC_2G4_250HZ_DVDA, SX1280_FLRC_BR_0_650_BW_0_6, SX1280_FLRC_BT_1, SX1280_FLRC_CR_1_2,    32, TLM_RATIO_1_128, 2,  1000, OTA4_PACKET_SIZE, 4},
+    {4, RADIO_TYPE_SX128x_LORA, RATE_LORA_2G4_500HZ,      SX1280_LORA_BW_0800,         SX1280_LORA_SF5,  SX1280_LORA_CR_LI_4_6, 12, TLM_RATIO_1_128, 4,  2000, OTA4_PACKET_SIZE, 1},
+    {5, RADIO_TYPE_SX128x_LORA, RATE_LORA_2G4_333HZ_8CH,  SX1280_LORA_BW_0800,         SX1280_LORA_SF5,  SX1280_LORA_CR_LI_4_8, 12, TLM_RATIO_1_128, 4,  3003, OTA8_PACKET_SIZE, 1},
+    {6, RADIO_TYPE_SX128x_LORA, RATE_LORA_2G4_250HZ,      SX1280_LORA_BW_0800,         SX1280_LORA_SF6,  SX1280_LORA_CR_LI_4_8, 14, TLM_RATIO_1_64,  4,  4000, OTA4_PACKET_SIZE, 1},
+    {7, RADIO_TYPE_SX128x_LORA, RATE_LORA_2G4_150HZ,      SX1280_LORA_BW_0800,         SX1280_LORA_SF7,  SX1280_LORA_CR_LI_4_8, 12, TLM_RATIO_1_32,  4,  6666, OTA4_PACKET_SIZE, 1},
+    {8, RADIO_TYPE_SX128x_LORA, RATE_LORA_2G4_100HZ_8CH,  SX1280_LORA_BW_0800,         SX1280_LORA_SF7,  SX1280_LORA_CR_LI_4_8, 12, TLM_RATIO_1_32,  4, 10000, OTA8_PACKET_SIZE, 1},
+    {9, RADIO_TYPE_SX128x_LORA, RATE_LORA_2G4_50HZ,       SX1280_LORA_BW_0800,         SX1280_LORA_SF8,  SX1280_LORA_CR_LI_4_8, 12, TLM_RATIO_1_16,  2, 20000, OTA4_PACKET_SIZE, 1}};
+
+constexpr uint32_t AirRateToaUs(expresslrs_mod_settings_s const &ModParams)
+{
+    // FLRC preamble is rounded down to 4 bits, at least 8 (see SX1280Driver::SetPacketParamsFLRC())
+    return (ModParams.radio_type == RADIO_TYPE_SX128x_FLRC)
+        ? FlrcToaUs(
+            ModParams.bw == SX1280_FLRC_BR_1_300_BW_1_2 ? 1300000 : ModParams.bw == SX1280_FLRC_BR_1_000_BW_1_2 ? 1040000 :
+            ModParams.bw == SX1280_FLRC_BR_0_650_BW_0_6 ? 650000 : ModParams.bw == SX1280_FLRC_BR_0_520_BW_0_6 ? 520000 :
+            ModParams.bw == SX1280_FLRC_BR_0_325_BW_0_3 ? 325000 : 260000,
+            ModParams.cr == SX1280_FLRC_CR_1_2 ? 2 : ModParams.cr == SX1280_FLRC_CR_3_4 ? 3 : 4,
+            ModParams.PreambleLen < 8 ? 8 : ModParams.PreambleLen / 4 * 4,
+            ModParams.PayloadLength)
+        : LoRaToaUs(
+            ModParams.bw == SX1280_LORA_BW_1600 ? 1625000 : ModParams.bw == SX1280_LORA_BW_0800 ? 812000 :
+            ModParams.bw == SX1280_LORA_BW_0400 ? 406000 : 203000,
+            ModParams.sf >> 4,
+            ModParams.cr == SX1280_LORA_CR_LI_4_8 ? 8 : ModParams.cr >= SX1280_LORA_CR_LI_4_5 ? ModParams.cr : ModParams.cr + 4,
+            ModParams.cr >= SX1280_LORA_CR_LI_4_5, ModParams.PreambleLen, ModParams.PayloadLength);
+}
+
+constexpr expresslrs_rf_pref_params_s ExpressLRS_AirRateRFperf[RATE_MAX] = {
+    {0, -104, RATE_TOA(0), 2500, 2500,  3, 5000, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE},
+    {1, -104, RATE_TOA(1), 2500, 2500,  3, 5000, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE},
+    {2, -104, RATE_TOA(2), 2500, 2500,  3, 5000, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE},
+    {3, -104, RATE_TOA(3), 2500, 2500,  3, 5000, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE},
+    {4, -105, RATE_TOA(4), 2500, 2500,  3, 5000, SNR_SCALE( 5), SNR_SCALE(9.5)},
+    {5, -105, RATE_TOA(5), 2500, 2500,  4, 5000, SNR_SCALE( 5), SNR_SCALE(9.5)},
+    {6, -108, RATE_TOA(6), 3000, 2500,  6, 5000, SNR_SCALE( 3), SNR_SCALE(9.5)},
+    {7, -112, RATE_TOA(7), 3500, 2500, 10, 5000, SNR_SCALE( 0), SNR_SCALE(8.5)},
+    {8, -112, RATE_TOA(8), 3500, 2500, 11, 5000, SNR_SCALE( 0), SNR_SCALE(8.5)},
+    {9, -115, RATE_TOA(9), 4000, 2500,  0, 5000, SNR_SCALE(-1), SNR_SCALE(6.5)}};
+#endif
+
+constexpr bool AirRatesIndexed(uint8_t index)
+{
+    return index == RATE_MAX ||
+        (ExpressLRS_AirRateConfig[index].index == index && ExpressLRS_AirRateRFperf[index].index == index && AirRatesIndexed(index + 1));
+}
+
+constexpr bool AirRatesFit(uint8_t index)
+{
+    return index == RATE_MAX ||
+        (AirRateIntervalFits(ExpressLRS_AirRateConfig[index].interval, ExpressLRS_AirRateRFperf[index].TOA) && AirRatesFit(index + 1));
+}
+
+static_assert(AirRatesIndexed(0), "Air rate tables must have an entry for each index, in order");
+static_assert(AirRatesFit(0), "An air rate's interval is shorter than its time on air plus AIRRATE_TURNAROUND_US");
+
+expresslrs_mod_settings_s const *get_elrs_airRateConfig(uint8_t index)
+{
+    if (RATE_MAX <= index)
+    {
+        // Set to last usable entry in the array
+        index = RATE_MAX - 1;
+    }
+    return &ExpressLRS_AirRateConfig[index];
+}
+
+expresslrs_rf_pref_params_s const *get_elrs_RFperfParams(uint8_t index)
+{
+    if (RATE_MAX <= index)
+    {
+        // Set to last usable entry in the array
+        index = RATE_MAX - 1;
+    }
+    return &ExpressLRS_AirRateRFperf[index];
+}
+
+uint8_t get_elrs_HandsetRate_max(uint8_t rateIndex, uint32_t minInterval)
+{
+    while (rateIndex < RATE_MAX)
+    {
+        expresslrs_mod_settings_s const * const ModParams = &ExpressLRS_AirRateConfig[rateIndex];
+        // Handset interval = time between packets from handset, which is expected to be air rate * number of times it is sent
+        uint32_t handsetInterval = ModParams->interval * ModParams->numOfSends;
+        if (handsetInterval >= minInterval && isSupportedRFRate(rateIndex))
+            break;
+        ++rateIndex;
+    }
+
+    return rateIndex;
+}
+
+constexpr uint8_t AirRateIndexOf(uint8_t eRate, uint8_t index)
+{
+    // If 25Hz selected and not available, return the slowest rate available
+    // else return the fastest rate available (500Hz selected but not available)
+    return (index == RATE_MAX) ? ((eRate == RATE_LORA_900_25HZ) ? RATE_MAX - 1 : 0)
+        : (ExpressLRS_AirRateConfig[index].enum_rate == eRate) ? index
+        : AirRateIndexOf(eRate, index + 1);
+}
+
+// The index of every expresslrs_RFrates_e, built at compile time so enumRatetoIndex() is a lookup
+#define RATE_ENUM_COUNT (RATE_LORA_DUAL_150HZ + 1)
+
+template <uint8_t... eRates> struct RateIndexTable
+{
+    static constexpr uint8_t index[sizeof...(eRates)] = {AirRateIndexOf(eRates, 0)...};
+};
+template <uint8_t... eRates> constexpr uint8_t RateIndexTable<eRates...>::index[sizeof...(eRates)];
+
+template <uint8_t count, uint8_t... eRates> struct MakeRateIndexTable : MakeRateIndexTable<count - 1, count - 1, eRates...> {};
+template <uint8_t... eRates> struct MakeRateIndexTable<0, eRates...> : RateIndexTable<eRates...> {};
+
+uint8_t ICACHE_RAM_ATTR enumRatetoIndex(expresslrs_RFrates_e const eRate)
+{ // convert enum_rate to index
+    return (eRate < RATE_ENUM_COUNT) ? MakeRateIndexTable<RATE_ENUM_COUNT>::index[eRate] : 0;
+}
+
+uint8_t ICACHE_RAM_ATTR TLMratioEnumToValue(expresslrs_tlm_ratio_e const enumval)
+{
+    // !! TLM_RATIO_STD/TLM_RATIO_DISARMED should be converted by the caller !!
+    if (enumval == TLM_RATIO_NO_TLM)
+        return 1;
+
+    // 1 << (8 - (enumval - TLM_RATIO_NO_TLM))
+    // 1_128 = 128, 1_64 = 64, 1_32 = 32, etc
+    return 1 << (8 + TLM_RATIO_NO_TLM - enumval);
+}
+
+/***
+ * @brief: Calculate number of 'burst' telemetry frames for the specified air rate and tlm ratio
+ *
+ * When attempting to send a LinkStats telemetry frame at most every TELEM_MIN_LINK_INTERVAL_MS,
+ * calculate the number of sequential advanced telemetry frames before another LinkStats is due.
+ ****/
+uint8_t TLMBurstMaxForRateRatio(uint16_t const rateHz, uint8_t const ratioDiv)
+{
+    // Maximum ms between LINK_STATISTICS packets for determining burst max
+    constexpr uint32_t TELEM_MIN_LINK_INTERVAL_MS = 512U;
+
+    // telemInterval = 1000 / (hz / ratiodiv);
+    // burst = TELEM_MIN_LINK_INTERVAL_MS / telemInterval;
+    // This ^^^ rearranged to preserve precision vvv, using u32 because F1000 1:2 = 256
+    unsigned retVal = TELEM_MIN_LINK_INTERVAL_MS * rateHz / ratioDiv / 1000U;
+
+    // Reserve one slot for LINK telemetry. 256 becomes 255 here, safe for return in uint8_t
+    if (retVal > 1)
+        --retVal;
+    else
+        retVal = 1;
+    //DBGLN("TLMburst: %d", retVal);
+
+    return retVal;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "common.h"
+
+#if defined(RADIO_SX127X)
+#define RATE_MAX 6
+#define RATE_BINDING RATE_LORA_900_50HZ
+
+#elif defined(RADIO_LR1121)
+#define RATE_MAX 20
+#define RATE_BINDING RATE_LORA_900_50HZ
+#define RATE_DUALBAND_BINDING RATE_LORA_2G4_50HZ
+
+#elif defined(RADIO_SX128X)
+#define RATE_MAX 10     // 2xFLRC + 2xDVDA + 4xLoRa + 2xFullRes
+#define RATE_BINDING RATE_LORA_2G4_50HZ
+#endif
+
+expresslrs_mod_settings_s const *get_elrs_airRateConfig(uint8_t index);
+expresslrs_rf_pref_params_s const *get_elrs_RFperfParams(uint8_t index);
+uint8_t get_elrs_HandsetRate_max(uint8_t rateIndex, uint32_t minInterval);
+
+uint8_t TLMratioEnumToValue(expresslrs_tlm_ratio_e const enumval);
+uint8_t TLMBurstMaxForRateRatio(uint16_t const rateHz, uint8_t const ratioDiv);
+uint8_t enumRatetoIndex(expresslrs_RFrates_e const eRate);
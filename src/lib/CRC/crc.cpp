@@ -57,3 +57,34 @@ uint16_t ICACHE_RAM_ATTR Crc2Byte::calc(uint8_t *data, uint8_t len, uint16_t crc
     }
     return crc & _bitmask;
 }
+
+/***
+ * Compile time table generation for the fixed polynomial CRCs
+ ***/
+static constexpr uint16_t crcTableShift(uint16_t crc, uint16_t highbit, uint16_t poly, uint8_t n)
+{
+    return n == 0 ? crc : crcTableShift((uint16_t)((crc << 1) ^ ((crc & highbit) ? poly : 0)), highbit, poly, n - 1);
+}
+
+static constexpr uint16_t crcTableEntry(uint8_t bits, uint16_t poly, uint16_t i)
+{
+    return crcTableShift(i << (bits - 8), 1 << (bits - 1), poly, 8) & ((1UL << bits) - 1);
+}
+
+#define CRC_TABLE_4(bits, poly, i) \
+    crcTableEntry(bits, poly, (i)), crcTableEntry(bits, poly, (i) + 1), \
+    crcTableEntry(bits, poly, (i) + 2), crcTableEntry(bits, poly, (i) + 3)
+#define CRC_TABLE_16(bits, poly, i) \
+    CRC_TABLE_4(bits, poly, (i)), CRC_TABLE_4(bits, poly, (i) + 4), \
+    CRC_TABLE_4(bits, poly, (i) + 8), CRC_TABLE_4(bits, poly, (i) + 12)
+#define CRC_TABLE_64(bits, poly, i) \
+    CRC_TABLE_16(bits, poly, (i)), CRC_TABLE_16(bits, poly, (i) + 16), \
+    CRC_TABLE_16(bits, poly, (i) + 32), CRC_TABLE_16(bits, poly, (i) + 48)
+#define CRC_TABLE(bits, poly) \
+    CRC_TABLE_64(bits, poly, 0), CRC_TABLE_64(bits, poly, 64), \
+    CRC_TABLE_64(bits, poly, 128), CRC_TABLE_64(bits, poly, 192)
+
+template <> const uint8_t Crc8Fixed<ELRS_CRC_POLY>::_crctab[crclen] CRC_TABLE_ATTR = { CRC_TABLE(8, ELRS_CRC_POLY) };
+template <> const uint8_t Crc8Fixed<CRC8_DVB_S2_POLY>::_crctab[crclen] CRC_TABLE_ATTR = { CRC_TABLE(8, CRC8_DVB_S2_POLY) };
+template <> const uint16_t Crc2ByteFixed<14, ELRS_CRC14_POLY>::_crctab[crclen] CRC_TABLE_ATTR = { CRC_TABLE(14, ELRS_CRC14_POLY) };
+template <> const uint16_t Crc2ByteFixed<16, ELRS_CRC16_POLY>::_crctab[crclen] CRC_TABLE_ATTR = { CRC_TABLE(16, ELRS_CRC16_POLY) };
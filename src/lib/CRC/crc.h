@@ -4,6 +4,19 @@
 
 #define crclen 256
 
+// Value is implicit leading 1, comment is Koopman formatting (implicit trailing 1) https://users.ece.cmu.edu/~koopman/crc/
+#define ELRS_CRC_POLY 0x07 // 0x83
+#define ELRS_CRC14_POLY 0x2E57 // 0x372b
+#define ELRS_CRC16_POLY 0x3D65 // 0x9eb2
+#define CRC8_DVB_S2_POLY 0xD5 // CRSF and MSPv2
+
+// Tables used from ISRs must not be in flash on ESP32
+#if defined(PLATFORM_ESP32)
+#define CRC_TABLE_ATTR DRAM_ATTR
+#else
+#define CRC_TABLE_ATTR
+#endif
+
 class GENERIC_CRC8
 {
 private:
@@ -28,3 +41,91 @@ public:
     void init(uint8_t bits, uint16_t poly);
     uint16_t calc(uint8_t *data, uint8_t len, uint16_t crc);
 };
+
+/**
+ * CRC8 with a fixed polynomial, same results as GENERIC_CRC8 but the table is
+ * generated at compile time and shared, so there is nothing to construct.
+ * Only the polynomials with a table defined in crc.cpp can be used.
+ */
+template <uint8_t POLY>
+class Crc8Fixed
+{
+public:
+    static inline uint8_t calc(const uint8_t data)
+    {
+        return _crctab[data];
+    }
+
+    static inline uint8_t calc(const uint8_t *data, uint16_t len, uint8_t crc = 0)
+    {
+        while (len--)
+        {
+            crc = _crctab[crc ^ *data++];
+        }
+        return crc;
+    }
+
+private:
+    static const uint8_t _crctab[crclen];
+};
+
+template <> const uint8_t Crc8Fixed<ELRS_CRC_POLY>::_crctab[crclen];
+template <> const uint8_t Crc8Fixed<CRC8_DVB_S2_POLY>::_crctab[crclen];
+
+/**
+ * 2-byte CRC (9 to 16 bits) with a fixed width and polynomial, same results as
+ * Crc2Byte. The table is generated at compile time and all the shifts/masks are
+ * constants. calc<LEN>() is fully unrolled for fixed length data, such as the
+ * OTA packets which are checked in the RXdone ISR.
+ * Only the width/polynomials with a table defined in crc.cpp can be used.
+ */
+template <uint8_t BITS, uint16_t POLY>
+class Crc2ByteFixed
+{
+public:
+    static inline uint16_t calc(const uint8_t *data, uint8_t len, uint16_t crc)
+    {
+        while (len--)
+        {
+            crc = step(crc, *data++);
+        }
+        return crc & BITMASK;
+    }
+
+    template <uint8_t LEN>
+    static inline uint16_t calc(const uint8_t *data, uint16_t crc)
+    {
+        return Unroll<LEN, 0>::calc(data, crc) & BITMASK;
+    }
+
+private:
+    static const uint16_t BITMASK = (1 << BITS) - 1;
+    static const uint16_t _crctab[crclen];
+
+    static inline uint16_t step(uint16_t crc, uint8_t data)
+    {
+        return (crc << 8) ^ _crctab[((crc >> (BITS - 8)) ^ data) & 0xFF];
+    }
+
+    template <uint8_t LEN, uint8_t IDX, bool DONE = (IDX == LEN)>
+    struct Unroll
+    {
+        static inline uint16_t calc(const uint8_t *data, uint16_t crc)
+        {
+            return Unroll<LEN, IDX + 1>::calc(data, step(crc, data[IDX]));
+        }
+    };
+
+    template <uint8_t LEN, uint8_t IDX>
+    struct Unroll<LEN, IDX, true>
+    {
+        static inline uint16_t calc(const uint8_t *data, uint16_t crc)
+        {
+            (void)data;
+            return crc;
+        }
+    };
+};
+
+template <> const uint16_t Crc2ByteFixed<14, ELRS_CRC14_POLY>::_crctab[crclen];
+template <> const uint16_t Crc2ByteFixed<16, ELRS_CRC16_POLY>::_crctab[crclen];
@@ -15,7 +15,7 @@ void CROSSFIRE2MSP::reset()
     MSPvers = MSP_FRAME_UNKNOWN;
 }
 
-void CROSSFIRE2MSP::parse(const uint8_t *data)
+bool CROSSFIRE2MSP::parse(const uint8_t *data)
 {
     uint8_t CRSFpayloadLen = data[CRSF_FRAME_PAYLOAD_LEN_IDX] - CRSF_EXT_FRAME_PAYLOAD_LEN_SIZE_OFFSET;
     bool error = isError(data);
@@ -32,12 +32,19 @@ void CROSSFIRE2MSP::parse(const uint8_t *data)
     if ((!newFrame && seqError) || error)
     {
         reset();
-        return;
+        return false;
+    }
+
+    if (!newFrame && (frameComplete || MSPvers == MSP_FRAME_UNKNOWN))
+    {
+        // a continuation with no frame in progress
+        return false;
     }
 
     if (newFrame) // If it's a new frame then out a header on first
     {
         idx = 3; // skip the header start wiring at offset 3.
+        frameComplete = false;
         MSPvers = getVersion(data);
         src = data[CRSF_MSP_SRC_OFFSET];
         dest = data[CRSF_MSP_DEST_OFFSET];
@@ -45,6 +52,11 @@ void CROSSFIRE2MSP::parse(const uint8_t *data)
         outBuffer[1] = (MSPvers == MSP_FRAME_V1 || MSPvers == MSP_FRAME_V1_JUMBO) ? 'M' : 'X';
         outBuffer[2] = error ? '!' : getHeaderDir(data);
         pktLen = getFrameLen(data, MSPvers);
+        if (pktLen + 4 > MSP_FRAME_MAX_LEN) // +3 header, +1 crc
+        {
+            reset();
+            return false;
+        }
     }
 
     // process the chunk of MSP frame
@@ -61,12 +73,9 @@ void CROSSFIRE2MSP::parse(const uint8_t *data)
         // we need to append the MSP checksum
         outBuffer[idx] = getChecksum(outBuffer + 3, pktLen, MSPvers); // +3 because the header isn't in checksum
         frameComplete = true;
-
-        FIFOout.lock();
-        FIFOout.pushSize(idx + 1);
-        FIFOout.pushBytes(outBuffer, idx + 1);
-        FIFOout.unlock();
+        return true;
     }
+    return false;
 }
 
 bool CROSSFIRE2MSP::isNewFrame(const uint8_t *data)
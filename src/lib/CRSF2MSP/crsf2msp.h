@@ -1,7 +1,6 @@
 #pragma once
 
 #include <cstdint>
-#include "FIFO.h"
 #include "crsfmsp_common.h"
 #include "crc.h"
 #include "logging.h"
@@ -33,8 +32,7 @@ private:
 
 public:
     CROSSFIRE2MSP();
-    FIFO<MSP_FRAME_MAX_LEN> FIFOout;
-    void parse(const uint8_t *data); // accept crsf frame input
+    bool parse(const uint8_t *data); // accept crsf frame input, true when it completes an MSP frame
     bool isFrameReady();
     const uint8_t *getFrame();
     uint32_t getFrameLen();
@@ -0,0 +1,427 @@
+#include "mspbridge.h"
+
+extern GENERIC_CRC8 crsf_crc;
+
+#define MSP_V2_FRAME_ID 255 // MSPv2 function encapsulated in an MSPv1 frame
+
+MSPBRIDGE::MSPBRIDGE(MspBridgeTransport *transport, uint8_t maxInFlight)
+    : requestsForwarded(0), requestsShared(0), requestsExpired(0), repliesCopied(0),
+      transport(transport),
+      maxInFlight(maxInFlight > MSPBRIDGE_MAX_IN_FLIGHT ? MSPBRIDGE_MAX_IN_FLIGHT : maxInFlight),
+      clientCount(0), stagedLen(0), inFlightCount(0), inFlightBytes(0)
+{
+    for (uint8_t s = 0; s < MSPBRIDGE_MAX_CLIENTS; s++)
+    {
+        sessions[s].client = nullptr;
+        sessions[s].out = nullptr;
+        sessions[s].frame = nullptr;
+        sessions[s].generation = 0;
+    }
+}
+
+MSPBRIDGE::~MSPBRIDGE()
+{
+    for (uint8_t s = 0; s < MSPBRIDGE_MAX_CLIENTS; s++)
+    {
+        delete sessions[s].out;
+        delete[] sessions[s].frame;
+    }
+}
+
+int MSPBRIDGE::findSession(void *client) const
+{
+    for (uint8_t s = 0; s < MSPBRIDGE_MAX_CLIENTS; s++)
+    {
+        if (sessions[s].client == client)
+        {
+            return s;
+        }
+    }
+    return -1;
+}
+
+bool MSPBRIDGE::addClient(void *client)
+{
+    if (findSession(client) != -1)
+    {
+        return true;
+    }
+    int const s = findSession(nullptr);
+    if (s == -1)
+    {
+        DBGLN("MSP bridge: no room for another client");
+        return false;
+    }
+    session_t &session = sessions[s];
+    session.client = client;
+    session.out = new FIFO<MSPBRIDGE_OUTPUT_SIZE>();
+    session.frame = new uint8_t[MSP_FRAME_MAX_LEN];
+    session.idx = 0;
+    session.frameLen = 0;
+    session.generation++;
+    clientCount++;
+    return true;
+}
+
+void MSPBRIDGE::removeClient(void *client)
+{
+    int const s = findSession(client);
+    if (s == -1)
+    {
+        return;
+    }
+    // Requests in flight stay there so their replies are still matched, to no one
+    for (uint8_t i = 0; i < inFlightCount; i++)
+    {
+        inFlight[i].clients &= ~(1 << s);
+    }
+    if (stagedLen && stagedSession == s)
+    {
+        stagedLen = 0;
+    }
+    session_t &session = sessions[s];
+    delete session.out;
+    delete[] session.frame;
+    session.out = nullptr;
+    session.frame = nullptr;
+    session.client = nullptr;
+    session.generation++;
+    clientCount--;
+}
+
+uint16_t MSPBRIDGE::getFunction(const uint8_t *frame)
+{
+    if (frame[1] == 'X')
+    {
+        return frame[4] | (frame[5] << 8);
+    }
+    bool const jumbo = frame[3] == 0xFF;
+    uint8_t const cmd = frame[4];
+    if (cmd == MSP_V2_FRAME_ID && getPayloadLen(frame) >= 3)
+    {
+        const uint8_t *payload = &frame[jumbo ? 7 : 5];
+        return payload[1] | (payload[2] << 8); // after the V2 flags
+    }
+    return cmd;
+}
+
+uint32_t MSPBRIDGE::getPayloadLen(const uint8_t *frame)
+{
+    if (frame[1] == 'X')
+    {
+        return frame[6] | (frame[7] << 8);
+    }
+    if (frame[3] == 0xFF)
+    {
+        return frame[5] | (frame[6] << 8);
+    }
+    return frame[3];
+}
+
+/***
+ * @brief Frame the bytes from a client into MSP frames, which are queued for the FC once the checksum
+ * is checked. TCP is a stream, a frame can arrive in pieces or several at a time.
+ */
+void MSPBRIDGE::receiveByte(uint8_t s, uint8_t c)
+{
+    session_t &session = sessions[s];
+    uint8_t *frame = session.frame;
+
+    if ((session.idx == 0 && c != '$') ||
+        (session.idx == 1 && c != 'M' && c != 'X') ||
+        (session.idx == 2 && c != '<' && c != '>'))
+    {
+        session.idx = (c == '$') ? 1 : 0;
+        frame[0] = '$';
+        return;
+    }
+    frame[session.idx++] = c;
+
+    if (session.frameLen == 0)
+    {
+        // <$><M><dir><len><cmd> or jumbo <$><M><dir><0xFF><cmd><lenL><lenH>
+        // <$><X><dir><flags><funcL><funcH><lenL><lenH>
+        if (frame[1] == 'M' && session.idx == 5 && frame[3] != 0xFF)
+            session.frameLen = 5 + frame[3] + 1;
+        else if (frame[1] == 'M' && session.idx == 7)
+            session.frameLen = 7 + getPayloadLen(frame) + 1;
+        else if (frame[1] == 'X' && session.idx == 8)
+            session.frameLen = 8 + getPayloadLen(frame) + 1;
+
+        if (session.frameLen > MSP_FRAME_MAX_LEN)
+        {
+            DBGLN("MSP bridge: frame too long %u", session.frameLen);
+            session.idx = 0;
+            session.frameLen = 0;
+        }
+        return;
+    }
+
+    if (session.idx < session.frameLen)
+    {
+        return;
+    }
+
+    uint16_t const len = session.frameLen;
+    session.idx = 0;
+    session.frameLen = 0;
+
+    uint8_t checksum = 0;
+    if (frame[1] == 'X')
+    {
+        checksum = crsf_crc.calc(&frame[3], len - 4);
+    }
+    else
+    {
+        for (uint16_t i = 3; i < len - 1; i++)
+        {
+            checksum ^= frame[i];
+        }
+    }
+    if (checksum != frame[len - 1])
+    {
+        DBGLN("MSP bridge: bad checksum");
+        return;
+    }
+
+    if (requests.available(len + 4))
+    {
+        requests.pushSize(len + 2);
+        requests.push(s);
+        requests.push(session.generation);
+        requests.pushBytes(frame, len);
+    }
+    else
+    {
+        DBGLN("MSP bridge: request queue full");
+    }
+}
+
+void MSPBRIDGE::clientData(void *client, const uint8_t *data, uint32_t len)
+{
+    int const s = findSession(client);
+    if (s == -1)
+    {
+        return;
+    }
+    for (uint32_t i = 0; i < len; i++)
+    {
+        receiveByte(s, data[i]);
+    }
+}
+
+/***
+ * @brief Send the staged request to the FC, or let it share the reply to the same read already in flight
+ * @return false if it has to wait for a request in flight to be answered first
+ */
+bool MSPBRIDGE::forwardStaged(uint32_t now)
+{
+    uint16_t const function = getFunction(staged);
+    bool const isRead = getPayloadLen(staged) == 0;
+    uint8_t const clientBit = 1 << stagedSession;
+
+    if (isRead)
+    {
+        for (uint8_t i = 0; i < inFlightCount; i++)
+        {
+            if (inFlight[i].isRead && inFlight[i].function == function)
+            {
+                inFlight[i].clients |= clientBit;
+                requestsShared++;
+                return true;
+            }
+        }
+    }
+
+    // The same sums as MSP2CROSSFIRE::parse(), the MSP frame without $M< and checksum split into chunks
+    uint16_t const mspLen = stagedLen - 4;
+    uint8_t const chunks = mspLen / CRSF_MSP_MAX_BYTES_PER_CHUNK + 1;
+    uint16_t const crsfLen = mspLen + chunks * CRSF_MSP_LEN_TO_ENCAP_FRAME_OFFSET;
+    if (inFlightCount == maxInFlight ||
+        (inFlightCount && inFlightBytes + crsfLen > MSPBRIDGE_IN_FLIGHT_BUDGET))
+    {
+        return false;
+    }
+    msp2crsf.FIFOout.lock();
+    bool const fits = msp2crsf.FIFOout.free() >= crsfLen + chunks;
+    msp2crsf.FIFOout.unlock();
+    if (!fits)
+    {
+        return false;
+    }
+
+    msp2crsf.parse(staged, stagedLen);
+    request_t &request = inFlight[inFlightCount++];
+    request.function = function;
+    request.clients = clientBit;
+    request.isRead = isRead;
+    request.crsfLen = crsfLen;
+    request.sentAt = now;
+    inFlightBytes += crsfLen;
+    requestsForwarded++;
+    return true;
+}
+
+void MSPBRIDGE::retire(uint8_t index)
+{
+    inFlightBytes -= inFlight[index].crsfLen;
+    inFlightCount--;
+    for (uint8_t i = index; i < inFlightCount; i++)
+    {
+        inFlight[i] = inFlight[i + 1];
+    }
+}
+
+void MSPBRIDGE::handle(uint32_t now)
+{
+    for (uint8_t i = 0; i < inFlightCount;)
+    {
+        if (now - inFlight[i].sentAt > MSPBRIDGE_REQUEST_TIMEOUT_MS)
+        {
+            DBGLN("MSP bridge: no reply to function %u", inFlight[i].function);
+            retire(i);
+            requestsExpired++;
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    for (;;)
+    {
+        if (stagedLen == 0)
+        {
+            if (requests.size() == 0)
+            {
+                break;
+            }
+            uint16_t const len = requests.popSize() - 2;
+            uint8_t const s = requests.pop();
+            uint8_t const generation = requests.pop();
+            requests.popBytes(staged, len);
+            if (sessions[s].client == nullptr || sessions[s].generation != generation)
+            {
+                // The client that sent it has gone
+                continue;
+            }
+            stagedLen = len;
+            stagedSession = s;
+        }
+        if (!forwardStaged(now))
+        {
+            break;
+        }
+        stagedLen = 0;
+    }
+
+    for (uint8_t s = 0; s < MSPBRIDGE_MAX_CLIENTS; s++)
+    {
+        if (sessions[s].client)
+        {
+            flushOutput(s);
+        }
+    }
+}
+
+void MSPBRIDGE::deliver(uint8_t s, const uint8_t *frame, uint32_t len)
+{
+    session_t &session = sessions[s];
+    // Behind replies that are already waiting, so they stay in order
+    if (session.out->size() == 0 && transport->space(session.client) >= len)
+    {
+        transport->write(session.client, frame, len);
+    }
+    else if (session.out->available(len + 2))
+    {
+        session.out->pushSize(len);
+        session.out->pushBytes(frame, len);
+        repliesCopied++;
+    }
+    else
+    {
+        DBGLN("MSP bridge: client output full, dropped %u bytes", len);
+    }
+}
+
+void MSPBRIDGE::flushOutput(uint8_t s)
+{
+    session_t &session = sessions[s];
+    while (session.out->size() > 0)
+    {
+        uint16_t const len = session.out->peekSize();
+        if (transport->space(session.client) < len)
+        {
+            break;
+        }
+        session.out->popSize();
+        uint8_t data[len];
+        session.out->popBytes(data, len);
+        transport->write(session.client, data, len);
+    }
+}
+
+/***
+ * @brief An MSP-in-CRSF frame from the FC, completed MSP frames are written to the clients waiting for them
+ */
+void MSPBRIDGE::crsfMspIn(const uint8_t *data)
+{
+    if (!hasClient() || !crsf2msp.parse(data))
+    {
+        return;
+    }
+
+    const uint8_t *frame = crsf2msp.getFrame();
+    uint32_t const len = crsf2msp.getFrameLen();
+    uint16_t const function = getFunction(frame);
+
+    uint8_t clients = (1 << MSPBRIDGE_MAX_CLIENTS) - 1;
+    for (uint8_t i = 0; i < inFlightCount; i++)
+    {
+        if (inFlight[i].function == function)
+        {
+            clients = inFlight[i].clients;
+            retire(i);
+            break;
+        }
+    }
+
+    for (uint8_t s = 0; s < MSPBRIDGE_MAX_CLIENTS; s++)
+    {
+        if ((clients & (1 << s)) && sessions[s].client)
+        {
+            deliver(s, frame, len);
+        }
+    }
+}
+
+/***
+ * @brief Count of bytes waiting to send to FC in CRSF form
+ * @param maxLen maximum length the caller is willing to accept
+ */
+uint8_t MSPBRIDGE::crsfOutAvailable(uint32_t maxLen)
+{
+    msp2crsf.FIFOout.lock();
+    uint8_t len = msp2crsf.FIFOout.peek();
+    uint32_t const size = msp2crsf.FIFOout.size();
+    msp2crsf.FIFOout.unlock();
+    if (len >= size || len > maxLen)
+    {
+        return 0;
+    }
+
+    return len;
+}
+
+/***
+ * @brief Pop the next packet to send to the FC. There is no size passed
+ * as this function expects the caller to have at least crsfOutAvailable() bytes
+ * of space available in the data buffer
+ */
+void MSPBRIDGE::crsfOutPop(uint8_t *data)
+{
+    msp2crsf.FIFOout.lock();
+    uint8_t OutPktLen = msp2crsf.FIFOout.pop();
+    msp2crsf.FIFOout.popBytes(data, OutPktLen);
+    msp2crsf.FIFOout.unlock();
+}
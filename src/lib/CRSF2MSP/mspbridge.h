@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include "FIFO.h"
+#include "crsf2msp.h"
+#include "msp2crsf.h"
+
+#define MSPBRIDGE_MAX_CLIENTS 3
+#define MSPBRIDGE_MAX_IN_FLIGHT 4
+#define MSPBRIDGE_REQUEST_TIMEOUT_MS 500
+// Bytes of CRSF encapsulated requests the FC is sent before it has replied to them.
+// Betaflight buffers 128 bytes of MSP-over-CRSF and works through them one reply at a time.
+#define MSPBRIDGE_IN_FLIGHT_BUDGET 128
+#define MSPBRIDGE_INPUT_SIZE 1024
+#define MSPBRIDGE_OUTPUT_SIZE 1024
+
+/**
+ * @brief Where the bridge sends MSP frames to its clients, implemented by the socket server
+ */
+class MspBridgeTransport
+{
+public:
+    virtual ~MspBridgeTransport() {}
+    // Bytes that can be written to `client` right now without blocking
+    virtual uint32_t space(void *client) = 0;
+    virtual void write(void *client, const uint8_t *data, uint32_t len) = 0;
+};
+
+/**
+ * @brief Bridges MSP from several clients to the FC over MSP-in-CRSF.
+ *
+ * Each client's byte stream is framed into MSP requests, which are forwarded to the FC
+ * with up to MSPBRIDGE_MAX_IN_FLIGHT of them waiting for a reply at once. A reply goes
+ * to the clients that sent the oldest in flight request with the same function id;
+ * replies to nothing in flight go to all clients. A read (no payload) of a function that
+ * is already in flight isn't sent again, its sender gets the same reply. Replies are
+ * written to the clients straight out of the CRSF reassembly buffer, they are only
+ * copied if a client's socket can't take them.
+ *
+ * Not thread safe, everything but crsfOutAvailable()/crsfOutPop() must be called from the
+ * same task, TCPSOCKET queues the client events and the frames from the FC for it.
+ * crsfOutAvailable()/crsfOutPop() lock the CRSF output, so the serial task can drain it.
+ */
+class MSPBRIDGE
+{
+public:
+    MSPBRIDGE(MspBridgeTransport *transport, uint8_t maxInFlight = MSPBRIDGE_MAX_IN_FLIGHT);
+    ~MSPBRIDGE();
+
+    bool addClient(void *client);
+    void removeClient(void *client);
+    bool hasClient() const { return clientCount != 0; }
+
+    // Bytes received from a client, in any chunking
+    void clientData(void *client, const uint8_t *data, uint32_t len);
+    // An MSP-in-CRSF frame from the FC
+    void crsfMspIn(const uint8_t *data);
+    // Forward requests, retry blocked replies, expire requests the FC didn't answer
+    void handle(uint32_t now);
+
+    // CRSF frames to send to the FC
+    uint8_t crsfOutAvailable(uint32_t maxLen);
+    void crsfOutPop(uint8_t *data);
+
+    // Counters for testing and debugging
+    uint32_t requestsForwarded;
+    uint32_t requestsShared;
+    uint32_t requestsExpired;
+    uint32_t repliesCopied;
+
+    static uint16_t getFunction(const uint8_t *frame);
+    static uint32_t getPayloadLen(const uint8_t *frame);
+
+private:
+    typedef struct {
+        void *client;
+        FIFO<MSPBRIDGE_OUTPUT_SIZE> *out; // replies the socket couldn't take yet
+        uint8_t *frame;                   // the request being received
+        uint16_t idx;
+        uint16_t frameLen;
+        uint8_t generation;               // tells requests from a previous client in the slot apart
+    } session_t;
+
+    typedef struct {
+        uint16_t function;
+        uint8_t clients; // bitmask of sessions waiting for the reply
+        bool isRead;
+        uint16_t crsfLen;
+        uint32_t sentAt;
+    } request_t;
+
+    MspBridgeTransport *transport;
+    uint8_t const maxInFlight;
+    session_t sessions[MSPBRIDGE_MAX_CLIENTS];
+    uint8_t clientCount;
+    FIFO<MSPBRIDGE_INPUT_SIZE> requests; // [size][session][generation][frame] waiting to go to the FC
+    uint8_t staged[MSP_FRAME_MAX_LEN];    // the next request to send, popped from `requests`
+    uint16_t stagedLen;
+    uint8_t stagedSession;
+    request_t inFlight[MSPBRIDGE_MAX_IN_FLIGHT];
+    uint8_t inFlightCount;
+    uint16_t inFlightBytes;
+    CROSSFIRE2MSP crsf2msp;
+    MSP2CROSSFIRE msp2crsf;
+
+    int findSession(void *client) const;
+    void receiveByte(uint8_t session, uint8_t c);
+    bool forwardStaged(uint32_t now);
+    void retire(uint8_t index);
+    void deliver(uint8_t session, const uint8_t *frame, uint32_t len);
+    void flushOutput(uint8_t session);
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Pack and unpack COUNT channels of WIDTH bits, little-endian from bit 0 of
+ * the first byte, as used by the CRSF RC frame and SBUS (16x 11-bit) and the
+ * OTA packets (4x 10-bit).
+ *
+ * The position of every channel is a template constant, so the kernels are
+ * straight-line code with no loops or branches: pack ORs each channel into a
+ * 32-bit accumulator and stores the bytes it completes, unpack loads the 2-4
+ * bytes a channel spans into a word and shifts/masks it out. The bytes are
+ * read and written one at a time, so the buffer needs no alignment, and pack()
+ * writes every byte of the block so it does not need zeroing first. If the
+ * block doesn't end on a byte boundary the unused high bits of its last byte
+ * are left as they were.
+ *
+ * CONV converts between the channel value and the packed value:
+ *   static uint32_t toOta(uint32_t ch11bit);
+ *   static uint32_t fromOta(uint32_t chOta);
+ */
+
+// The recursion must be flattened for the kernels to be straight-line, -Os won't on its own
+#define CHANNELCODEC_INLINE inline __attribute__((always_inline))
+
+// Channel values are packed as is
+struct ChannelCodecIdentity
+{
+    static inline uint32_t toOta(uint32_t ch) { return ch; }
+    static inline uint32_t fromOta(uint32_t ch) { return ch; }
+};
+
+template <unsigned COUNT, unsigned WIDTH>
+class ChannelCodec
+{
+    // A channel plus the up to 7 bits held from the one before must fit the accumulator
+    static_assert(WIDTH > 0 && WIDTH <= 24, "ChannelCodec width must be 1-24 bits");
+
+public:
+    static constexpr unsigned BITS = COUNT * WIDTH;
+    static constexpr unsigned BYTES = (BITS + 7) / 8;
+    static constexpr uint32_t MASK = (1U << WIDTH) - 1;
+
+    template <typename CONV = ChannelCodecIdentity>
+    static CHANNELCODEC_INLINE void pack(uint8_t * const buf, uint32_t const * const src)
+    {
+        Channel<0>::template pack<CONV>(buf, src, 0);
+    }
+
+    template <typename CONV = ChannelCodecIdentity>
+    static CHANNELCODEC_INLINE void unpack(uint8_t const * const buf, uint32_t * const dst)
+    {
+        Channel<0>::template unpack<CONV>(buf, dst);
+    }
+
+private:
+    template <unsigned N, bool DONE = (N == COUNT)>
+    struct Channel
+    {
+        static constexpr unsigned BYTE = N * WIDTH / 8;         // byte holding the first bit
+        static constexpr unsigned SHIFT = N * WIDTH % 8;        // bits of the previous channel held
+        static constexpr unsigned COMPLETE = (SHIFT + WIDTH) / 8;
+        static constexpr unsigned SPAN = (SHIFT + WIDTH + 7) / 8;
+
+        template <typename CONV>
+        static CHANNELCODEC_INLINE void pack(uint8_t * const buf, uint32_t const * const src, uint32_t acc)
+        {
+            acc |= (CONV::toOta(src[N]) & MASK) << SHIFT;
+            Bytes<COMPLETE>::store(buf + BYTE, acc);
+            Channel<N + 1>::template pack<CONV>(buf, src, acc >> (8 * COMPLETE));
+        }
+
+        template <typename CONV>
+        static CHANNELCODEC_INLINE void unpack(uint8_t const * const buf, uint32_t * const dst)
+        {
+            dst[N] = CONV::fromOta((Bytes<SPAN>::load(buf + BYTE) >> SHIFT) & MASK);
+            Channel<N + 1>::template unpack<CONV>(buf, dst);
+        }
+    };
+
+    template <unsigned N>
+    struct Channel<N, true>
+    {
+        template <typename CONV>
+        static CHANNELCODEC_INLINE void pack(uint8_t * const buf, uint32_t const * const, uint32_t acc)
+        {
+            // Bits left over from the last channel
+            if (BITS % 8)
+            {
+                uint8_t const keep = (uint8_t)(0xff << (BITS % 8));
+                buf[BITS / 8] = (buf[BITS / 8] & keep) | (acc & ~keep);
+            }
+        }
+
+        template <typename CONV>
+        static CHANNELCODEC_INLINE void unpack(uint8_t const * const, uint32_t * const) {}
+    };
+
+    // The low LEN bytes of a little-endian word
+    template <unsigned LEN, unsigned I = 0, bool DONE = (I == LEN)>
+    struct Bytes
+    {
+        static CHANNELCODEC_INLINE void store(uint8_t * const buf, uint32_t const v)
+        {
+            buf[I] = v >> (8 * I);
+            Bytes<LEN, I + 1>::store(buf, v);
+        }
+
+        static CHANNELCODEC_INLINE uint32_t load(uint8_t const * const buf)
+        {
+            return ((uint32_t)buf[I] << (8 * I)) | Bytes<LEN, I + 1>::load(buf);
+        }
+    };
+
+    template <unsigned LEN, unsigned I>
+    struct Bytes<LEN, I, true>
+    {
+        static CHANNELCODEC_INLINE void store(uint8_t * const, uint32_t const) {}
+        static CHANNELCODEC_INLINE uint32_t load(uint8_t const * const) { return 0; }
+    };
+};
@@ -0,0 +1,243 @@
+#include "ConfigJournal.h"
+#include "crc.h"
+
+#include <string.h>
+
+typedef Crc2ByteFixed<16, ELRS_CRC16_POLY> journalCrc;
+
+ConfigJournal::ConfigJournal()
+    : bytesWritten(0), sectorsErased(0), flash(nullptr), image(nullptr), dirty(nullptr), size(0)
+{
+}
+
+ConfigJournal::~ConfigJournal()
+{
+    delete[] image;
+    delete[] dirty;
+}
+
+void ConfigJournal::begin(FlashSectors *newFlash, uint16_t newSize)
+{
+    delete[] image;
+    delete[] dirty;
+    flash = newFlash;
+    size = newSize;
+    image = new uint8_t[size];
+    dirty = new uint8_t[(size + 7) / 8];
+    memset(image, 0xff, size);
+    clearDirty();
+    used = 0;
+    sectorSize = flash->sectorSize();
+    reserve = sectorSize / 4;
+    activeSector = 0;
+    sequence = 0;
+    // Nowhere to append until there is a journal, the first commit compacts
+    writePos = sectorSize;
+    bytesWritten = 0;
+    sectorsErased = 0;
+}
+
+bool ConfigJournal::load()
+{
+    bool found = false;
+    for (uint8_t sector = 0; sector < flash->sectorCount(); ++sector)
+    {
+        uint32_t header[2];
+        flash->read(sector * sectorSize, (uint8_t *)header, sizeof(header));
+        if (header[0] == MAGIC && (!found || (int32_t)(header[1] - sequence) > 0))
+        {
+            found = true;
+            activeSector = sector;
+            sequence = header[1];
+        }
+    }
+    if (!found)
+    {
+        return false;
+    }
+
+    uint32_t const base = activeSector * sectorSize;
+    uint32_t pos = HEADER_LEN;
+    while (pos + RECORD_HEADER_LEN <= sectorSize)
+    {
+        uint8_t record[RECORD_HEADER_LEN + RECORD_MAX_DATA];
+        // Flash is read a word at a time, the rest of the header comes with the data
+        flash->read(base + pos, record, 4);
+        uint16_t const offset = record[0] | (record[1] << 8);
+        uint8_t const len = record[2];
+        if (offset == 0xffff && len == 0xff && record[3] == 0xff)
+        {
+            // Erased, the end of the journal
+            break;
+        }
+        if (len == 0 || len > RECORD_MAX_DATA || offset + len > size || pos + recordLen(len) > sectorSize)
+        {
+            // Corrupt, nothing more can be appended after it
+            pos = sectorSize;
+            break;
+        }
+        flash->read(base + pos + 4, &record[4], recordLen(len) - 4);
+        if (journalCrc::calc(&record[RECORD_HEADER_LEN], len, journalCrc::calc(record, 3, 0)) != (record[3] | (record[4] << 8)))
+        {
+            // Torn by a power loss during a commit
+            pos = sectorSize;
+            break;
+        }
+        memcpy(&image[offset], &record[RECORD_HEADER_LEN], len);
+        if (offset + len > used)
+        {
+            used = offset + len;
+        }
+        pos += recordLen(len);
+    }
+    writePos = pos;
+    clearDirty();
+    return true;
+}
+
+void ConfigJournal::import(const uint8_t *data, uint16_t len)
+{
+    if (len > size)
+    {
+        len = size;
+    }
+    for (uint16_t addr = 0; addr < len; ++addr)
+    {
+        image[addr] = data[addr];
+        dirty[addr / 8] |= 1 << (addr % 8);
+    }
+    if (len > used)
+    {
+        used = len;
+    }
+    dirtyCount = len;
+}
+
+void ConfigJournal::write(uint16_t addr, uint8_t value)
+{
+    if (addr >= size || image[addr] == value)
+    {
+        return;
+    }
+    image[addr] = value;
+    if (!isDirty(addr))
+    {
+        dirty[addr / 8] |= 1 << (addr % 8);
+        ++dirtyCount;
+    }
+    if (addr >= used)
+    {
+        used = addr + 1;
+    }
+}
+
+void ConfigJournal::clearDirty()
+{
+    memset(dirty, 0, (size + 7) / 8);
+    dirtyCount = 0;
+}
+
+bool ConfigJournal::nextDirtyRun(uint16_t from, uint16_t &start, uint16_t &len) const
+{
+    while (from < used && !isDirty(from))
+    {
+        ++from;
+    }
+    if (from >= used)
+    {
+        return false;
+    }
+    // Runs closer than a record header are joined, writing the unchanged bytes between them is cheaper
+    start = from;
+    uint16_t end = from + 1;
+    for (uint16_t addr = end; addr < used && addr - end < RECORD_HEADER_LEN; ++addr)
+    {
+        if (isDirty(addr))
+        {
+            end = addr + 1;
+        }
+    }
+    len = end - start;
+    return true;
+}
+
+uint32_t ConfigJournal::dirtyRecordsLen() const
+{
+    uint32_t total = 0;
+    uint16_t start, len;
+    for (uint16_t from = 0; nextDirtyRun(from, start, len); from = start + len)
+    {
+        total += (len / RECORD_MAX_DATA) * recordLen(RECORD_MAX_DATA);
+        if (len % RECORD_MAX_DATA)
+        {
+            total += recordLen(len % RECORD_MAX_DATA);
+        }
+    }
+    return total;
+}
+
+uint32_t ConfigJournal::writeRecords(uint32_t addr, uint16_t offset, uint16_t len)
+{
+    uint32_t const start = addr;
+    while (len)
+    {
+        uint8_t const chunk = len > RECORD_MAX_DATA ? RECORD_MAX_DATA : len;
+        uint16_t const total = recordLen(chunk);
+        uint8_t record[RECORD_HEADER_LEN + RECORD_MAX_DATA];
+        record[0] = offset & 0xff;
+        record[1] = offset >> 8;
+        record[2] = chunk;
+        memcpy(&record[RECORD_HEADER_LEN], &image[offset], chunk);
+        memset(&record[RECORD_HEADER_LEN + chunk], 0xff, total - RECORD_HEADER_LEN - chunk);
+        uint16_t const crc = journalCrc::calc(&record[RECORD_HEADER_LEN], chunk, journalCrc::calc(record, 3, 0));
+        record[3] = crc & 0xff;
+        record[4] = crc >> 8;
+        flash->write(addr, record, total);
+        bytesWritten += total;
+        addr += total;
+        offset += chunk;
+        len -= chunk;
+    }
+    return addr - start;
+}
+
+void ConfigJournal::commit()
+{
+    if (dirtyCount == 0)
+    {
+        return;
+    }
+    if (writePos + dirtyRecordsLen() > sectorSize)
+    {
+        compact();
+        return;
+    }
+
+    uint32_t const base = activeSector * sectorSize;
+    uint16_t start, len;
+    for (uint16_t from = 0; nextDirtyRun(from, start, len); from = start + len)
+    {
+        writePos += writeRecords(base + writePos, start, len);
+    }
+    clearDirty();
+}
+
+void ConfigJournal::compact()
+{
+    uint8_t const next = (activeSector + 1) % flash->sectorCount();
+    uint32_t const base = next * sectorSize;
+    flash->erase(next);
+    ++sectorsErased;
+
+    uint32_t pos = HEADER_LEN + writeRecords(base + HEADER_LEN, 0, used);
+
+    // The header goes last so a compaction cut short leaves the old sector active
+    uint32_t const header[2] = { MAGIC, sequence + 1 };
+    flash->write(base, (const uint8_t *)header, sizeof(header));
+    bytesWritten += sizeof(header);
+
+    activeSector = next;
+    ++sequence;
+    writePos = pos;
+    clearDirty();
+}
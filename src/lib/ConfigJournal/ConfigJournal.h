@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief The flash the journal is kept in, one or more whole erase sectors.
+ * Addresses are relative to the start of the first sector. write() is only ever
+ * called with 4-byte aligned addresses and lengths, into erased flash.
+ */
+class FlashSectors
+{
+public:
+    virtual ~FlashSectors() {}
+    virtual uint32_t sectorSize() const = 0;
+    virtual uint8_t sectorCount() const = 0;
+    virtual void read(uint32_t addr, uint8_t *data, uint32_t len) = 0;
+    virtual void write(uint32_t addr, const uint8_t *data, uint32_t len) = 0;
+    virtual void erase(uint8_t sector) = 0;
+};
+
+/**
+ * @brief A RAM image of the config, stored in flash as a journal of the bytes that changed.
+ *
+ * Writes to the image mark the bytes that changed, and commit() appends them to the
+ * active sector as records of an offset, a length, the bytes and a CRC16. Changed bytes
+ * close together are coalesced into one record, so a commit that follows a burst of
+ * changes costs a few words of flash writes and no erase.
+ *
+ * When the active sector is full the image is compacted: the next sector in the ring is
+ * erased and the whole image is written to it as records, with the sector header that
+ * makes it the active one written last. compact() can be called ahead of time when
+ * compactPending() is set, so a commit rarely has to compact.
+ *
+ * load() replays the records of the active sector, the one with the highest sequence
+ * number. Replay stops at the first erased or corrupt record, so a commit torn by a
+ * power loss is dropped as a whole and the next commit compacts past it. With a single
+ * sector, power lost during a compaction loses the config, the same as rewriting it.
+ */
+class ConfigJournal
+{
+public:
+    ConfigJournal();
+    ~ConfigJournal();
+
+    /**
+     * @brief Set the flash and the size of the image, which starts erased (0xFF)
+     */
+    void begin(FlashSectors *flash, uint16_t size);
+
+    /**
+     * @brief Load the image from the journal
+     * @return false if there is no journal, the image is left erased
+     */
+    bool load();
+
+    /**
+     * @brief Load the image from `len` raw bytes, such as the config stored before
+     * there was a journal. The next commit writes all of it.
+     */
+    void import(const uint8_t *data, uint16_t len);
+
+    uint8_t read(uint16_t addr) const { return addr < size ? image[addr] : 0; }
+    void write(uint16_t addr, uint8_t value);
+    bool isDirty() const { return dirtyCount != 0; }
+
+    /**
+     * @brief Write the changed bytes to flash, compacting if they don't fit
+     */
+    void commit();
+
+    /**
+     * @brief Set when the active sector is nearly full and compact() should be called
+     * at a convenient time
+     */
+    bool compactPending() const { return writePos + reserve > sectorSize; }
+
+    /**
+     * @brief Write the whole image to the next sector and make it the active one
+     */
+    void compact();
+
+    // Totals since begin(), for measuring wear
+    uint32_t bytesWritten;
+    uint32_t sectorsErased;
+
+private:
+    static const uint32_t MAGIC = 0x4A534C45; // "ELSJ"
+    static const uint16_t HEADER_LEN = 8;
+    // A record is the offset, the length and a CRC16 of them and the data, then the data,
+    // padded to a whole word. The longest is 256 bytes.
+    static const uint16_t RECORD_HEADER_LEN = 5;
+    static const uint16_t RECORD_MAX_DATA = 251;
+
+    FlashSectors *flash;
+    uint8_t *image;
+    uint8_t *dirty;         // bitmap of bytes changed since the last commit
+    uint16_t size;
+    uint16_t used;          // bytes of the image that have ever been written
+    uint16_t dirtyCount;
+    uint32_t sectorSize;
+    uint32_t reserve;       // free space below which a compaction is pending
+    uint8_t activeSector;
+    uint32_t sequence;
+    uint32_t writePos;      // where the next record goes in the active sector
+
+    bool isDirty(uint16_t addr) const { return dirty[addr / 8] & (1 << (addr % 8)); }
+    static uint16_t recordLen(uint16_t dataLen) { return (RECORD_HEADER_LEN + dataLen + 3) & ~3; }
+    bool nextDirtyRun(uint16_t from, uint16_t &start, uint16_t &len) const;
+    uint32_t dirtyRecordsLen() const;
+    uint32_t writeRecords(uint32_t addr, uint16_t offset, uint16_t len);
+    void clearDirty();
+};
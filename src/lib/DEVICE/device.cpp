@@ -3,6 +3,7 @@
 #include "logging.h"
 #include "helpers.h"
 #include "device.h"
+#include "TimerHeap.h"
 
 ///////////////////////////////////////
 // Even though we aren't using anything this keeps the PIO dependency analyzer happy!
@@ -30,7 +31,11 @@ static uint8_t deviceCount;
 static uint32_t eventFired[2] = {0, 0};
 static bool lastModelMatch[2] = {false, false};
 
-static unsigned long deviceTimeout[16] = {0};
+// The pending timeout() calls, one heap for each core the devices run on
+static TimerHeap deviceTimers[2];
+// Due devices are collected before any is called, so one that returns DURATION_IMMEDIATELY runs once per update
+static uint8_t *dueDevices[2] = {nullptr, nullptr};
+static device_stats_t *deviceStats;
 
 #if MULTICORE
 static TaskHandle_t xDeviceTask = NULL;
@@ -47,6 +52,15 @@ void devicesRegister(device_affinity_t *devices, uint8_t count)
     uiDevices = devices;
     deviceCount = count;
 
+    for (int i = 0; i < 2; i++)
+    {
+        deviceTimers[i].resize(count);
+        delete[] dueDevices[i];
+        dueDevices[i] = new uint8_t[count];
+    }
+    delete[] deviceStats;
+    deviceStats = new device_stats_t[count]();
+
     #if MULTICORE
         taskSemaphore = xSemaphoreCreateBinary();
         completeSemaphore = xSemaphoreCreateBinary();
@@ -77,19 +91,43 @@ void devicesInit()
     #endif
 }
 
+static void setTimeout(TimerHeap &timers, uint8_t i, unsigned long now, int delay)
+{
+    // Devices without a timeout() are never put in the heap
+    if (delay == DURATION_NEVER || !uiDevices[i].device->timeout)
+    {
+        timers.cancel(i);
+    }
+    else
+    {
+        timers.schedule(i, now + delay);
+    }
+}
+
+static int timedCall(int (*func)(), device_stats_t &stats, uint32_t &calls, uint32_t &totalMicros)
+{
+    uint32_t const start = micros();
+    int const delay = func();
+    uint32_t const spent = micros() - start;
+    ++calls;
+    totalMicros += spent;
+    stats.maxMicros = std::max(stats.maxMicros, spent);
+    return delay;
+}
+
 void devicesStart()
 {
     int32_t core = CURRENT_CORE;
+    TimerHeap &timers = deviceTimers[core == -1 ? 0 : core];
     unsigned long now = millis();
 
     for(size_t i=0 ; i<deviceCount ; i++)
     {
         if (uiDevices[i].core == core || core == -1) {
-            deviceTimeout[i] = 0xFFFFFFFF;
+            timers.cancel(i);
             if (uiDevices[i].device->start)
             {
-                int delay = (uiDevices[i].device->start)();
-                deviceTimeout[i] = delay == DURATION_NEVER ? 0xFFFFFFFF : now + delay;
+                setTimeout(timers, i, now, (uiDevices[i].device->start)());
             }
         }
     }
@@ -123,6 +161,7 @@ static int _devicesUpdate(unsigned long now)
 {
     const int32_t core = CURRENT_CORE;
     const int32_t coreMulti = (core == -1) ? 0 : core;
+    TimerHeap &timers = deviceTimers[coreMulti];
 
     bool newModelMatch = connectionHasModelMatch && teamraceHasModelMatch;
     uint32_t events = eventFired[coreMulti];
@@ -136,38 +175,51 @@ static int _devicesUpdate(unsigned long now)
         {
             if ((uiDevices[i].core == core || core == -1) && (uiDevices[i].device->event && (uiDevices[i].device->subscribe & events) != 0))
             {
-                int delay = (uiDevices[i].device->event)();
+                int delay = timedCall(uiDevices[i].device->event, deviceStats[i], deviceStats[i].eventCalls, deviceStats[i].eventMicros);
                 if (delay != DURATION_IGNORE)
                 {
-                    deviceTimeout[i] = delay == DURATION_NEVER ? 0xFFFFFFFF : now + delay;
+                    setTimeout(timers, i, now, delay);
                 }
             }
         }
     }
 
-    int smallest_delay = DURATION_NEVER;
-    for(size_t i=0 ; i<deviceCount ; i++)
+    // Take every device that is due out of the heap, then call them
+    uint8_t *due = dueDevices[coreMulti];
+    uint8_t dueCount = 0;
+    for (int i = timers.popDue(now); i != -1; i = timers.popDue(now))
     {
-        if ((uiDevices[i].core == core || core == -1) && uiDevices[i].device->timeout)
-        {
-            int delay = deviceTimeout[i] == 0xFFFFFFFF ? DURATION_NEVER : (int)(deviceTimeout[i]-now);
-            if (now >= deviceTimeout[i])
-            {
-                delay = (uiDevices[i].device->timeout)();
-                deviceTimeout[i] = delay == DURATION_NEVER ? 0xFFFFFFFF : now + delay;
-            }
-            if (delay != DURATION_NEVER)
-            {
-                smallest_delay = (smallest_delay == DURATION_NEVER) ? delay : std::min(smallest_delay, delay);
-            }
-        }
+        due[dueCount++] = i;
+    }
+    for (uint8_t n = 0; n < dueCount; n++)
+    {
+        uint8_t i = due[n];
+        int delay = timedCall(uiDevices[i].device->timeout, deviceStats[i], deviceStats[i].timeoutCalls, deviceStats[i].timeoutMicros);
+        setTimeout(timers, i, now, delay);
+    }
+
+    if (timers.empty())
+    {
+        return DURATION_NEVER;
     }
-    return smallest_delay;
+    return std::max((int32_t)(timers.nextDeadline() - now), (int32_t)0);
+}
+
+int devicesUpdate(unsigned long now)
+{
+    return _devicesUpdate(now);
 }
 
-void devicesUpdate(unsigned long now)
+const device_stats_t *devicesGetStats(const device_t *device)
 {
-    _devicesUpdate(now);
+    for (size_t i = 0; i < deviceCount; i++)
+    {
+        if (uiDevices[i].device == device)
+        {
+            return &deviceStats[i];
+        }
+    }
+    return nullptr;
 }
 
 #if MULTICORE
@@ -76,6 +76,14 @@ typedef struct {
   int8_t core; // 0 = alternate core or 1 = loop core
 } device_affinity_t;
 
+typedef struct {
+  uint32_t eventCalls;
+  uint32_t eventMicros;   // total time spent in event()
+  uint32_t timeoutCalls;
+  uint32_t timeoutMicros; // total time spent in timeout()
+  uint32_t maxMicros;     // longest single event() or timeout() call
+} device_stats_t;
+
 /**
  * @brief register a list of devices to be actioned
  *
@@ -98,10 +106,13 @@ void devicesStart();
  * @brief This function is called in the main loop of the application and only
  * processes devices register to the loop-core. Devices registered on alternate core(s)
  * are processing in a separate FreeRTOS task running on the alternate core(s).
+ * Only the devices whose timeout has expired are called, there is no limit on the
+ * number of registered devices.
  *
  * @param now current time in milliseconds
+ * @return the number of milliseconds until the next timeout() is due, or DURATION_NEVER
  */
-void devicesUpdate(unsigned long now);
+int devicesUpdate(unsigned long now);
 
 /**
  * @brief Notify the device framework that an event has occurred and on the next call to
@@ -109,6 +120,14 @@ void devicesUpdate(unsigned long now);
  */
 void devicesTriggerEvent(uint32_t events);
 
+/**
+ * @brief The number of calls to, and time spent in, the event() and timeout() functions
+ * of a registered device since it was registered.
+ *
+ * @return the accounting for the device, or nullptr if it is not registered
+ */
+const device_stats_t *devicesGetStats(const device_t *device);
+
 /**
  * @brief Stop all the devices.
  * This destroys the FreeRTOS task running on the alternate core(s).
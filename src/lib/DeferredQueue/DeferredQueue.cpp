@@ -0,0 +1,79 @@
+#include "DeferredQueue.h"
+
+DeferredQueue::DeferredQueue(uint8_t capacity)
+    : entries(new entry_t[capacity]), capacity(capacity), timers(capacity), armTimer(nullptr)
+{
+}
+
+void DeferredQueue::setTimer(armTimer_t arm)
+{
+    uint32_t const ps = lock();
+    armTimer = arm;
+    unlock(ps);
+}
+
+int32_t ICACHE_RAM_ATTR DeferredQueue::untilNextLocked(uint32_t now) const
+{
+    if (timers.empty())
+        return -1;
+    int32_t const until = (int32_t)(timers.nextDeadline() - now);
+    return until < 0 ? 0 : until;
+}
+
+void ICACHE_RAM_ATTR DeferredQueue::rearm(uint32_t now)
+{
+    if (armTimer)
+        armTimer(untilNextLocked(now));
+}
+
+bool ICACHE_RAM_ATTR DeferredQueue::add(uint32_t now, uint32_t us, callback_t fn, void *ctx)
+{
+    uint32_t const ps = lock();
+    for (uint8_t i = 0; i < capacity; ++i)
+    {
+        if (!timers.isScheduled(i))
+        {
+            entries[i].fn = fn;
+            entries[i].ctx = ctx;
+            // Due once more than `us` has elapsed
+            uint32_t const deadline = now + us + 1;
+            timers.schedule(i, deadline);
+            // Only a new earliest deadline moves the timer
+            if (timers.nextDeadline() == deadline)
+                rearm(now);
+            unlock(ps);
+            return true;
+        }
+    }
+    unlock(ps);
+    return false;
+}
+
+uint8_t ICACHE_RAM_ATTR DeferredQueue::run(uint32_t now)
+{
+    uint8_t called = 0;
+    for (;;)
+    {
+        uint32_t const ps = lock();
+        int const i = timers.popDue(now);
+        if (i == -1)
+        {
+            rearm(now);
+            unlock(ps);
+            return called;
+        }
+        // The slot is free as soon as it is popped, so take a copy before letting go
+        entry_t const e = entries[i];
+        unlock(ps);
+        e.fn(e.ctx);
+        ++called;
+    }
+}
+
+int32_t DeferredQueue::untilNext(uint32_t now)
+{
+    uint32_t const ps = lock();
+    int32_t const until = untilNextLocked(now);
+    unlock(ps);
+    return until;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "targets.h"
+#include "TimerHeap.h"
+
+/**
+ * @brief A queue of callbacks, each a function pointer and a context pointer, to be
+ * called once a number of microseconds have elapsed.
+ *
+ * The entries live in a fixed table ordered by a TimerHeap, so neither adding nor
+ * running a callback allocates. add() can be called from an ISR as well as the main
+ * loop: the table is only touched with interrupts masked, restoring the state they
+ * were in rather than enabling them. Callbacks are called without the lock held, so
+ * they may add() again.
+ *
+ * The owner can give the queue a one-shot timer with setTimer(). It is armed for the
+ * earliest deadline whenever that changes, and disarmed when the queue empties, so
+ * the timer's ISR only needs to call run().
+ */
+class DeferredQueue
+{
+public:
+    typedef void (*callback_t)(void *ctx);
+    // Arm the one-shot timer to fire in `us` microseconds, or disarm it if `us` is negative
+    typedef void (*armTimer_t)(int32_t us);
+
+    explicit DeferredQueue(uint8_t capacity);
+
+    void setTimer(armTimer_t armTimer);
+
+    /**
+     * @brief Call fn(ctx) once more than `us` microseconds after `now` have elapsed
+     * @return false if the queue is full
+     */
+    bool add(uint32_t now, uint32_t us, callback_t fn, void *ctx);
+
+    /**
+     * @brief Call the callbacks that are due, earliest first
+     * @return the number of callbacks called
+     */
+    uint8_t run(uint32_t now);
+
+    /**
+     * @brief The microseconds from `now` until the next callback is due, 0 if it
+     * is overdue, or -1 if the queue is empty
+     */
+    int32_t untilNext(uint32_t now);
+
+private:
+    struct entry_t {
+        callback_t fn;
+        void *ctx;
+    };
+
+    entry_t *entries;
+    uint8_t capacity;
+    TimerHeap timers;
+    armTimer_t armTimer;
+
+#if defined(PLATFORM_ESP32)
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+    ICACHE_RAM_ATTR inline uint32_t lock()
+    {
+#if defined(PLATFORM_ESP32)
+        portENTER_CRITICAL_SAFE(&mux);
+        return 0;
+#elif defined(PLATFORM_ESP8266)
+        return xt_rsil(15);
+#else
+        return 0;
+#endif
+    }
+
+    ICACHE_RAM_ATTR inline void unlock(uint32_t savedPS)
+    {
+#if defined(PLATFORM_ESP32)
+        portEXIT_CRITICAL_SAFE(&mux);
+#elif defined(PLATFORM_ESP8266)
+        xt_wsr_ps(savedPS);
+#endif
+    }
+
+    int32_t untilNextLocked(uint32_t now) const;
+    void rearm(uint32_t now);
+};
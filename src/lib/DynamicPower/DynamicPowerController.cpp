@@ -0,0 +1,203 @@
+#include "DynamicPowerController.h"
+
+#include <algorithm>
+#include "logging.h"
+
+#define DYNPOWER_LOSS_NONE INT16_MIN
+
+DynamicPowerController::DynamicPowerController(dynpowerMode_e mode) : mode(mode)
+{
+    reset();
+}
+
+void DynamicPowerController::reset()
+{
+    mavgLq = 100;
+    meanRssi.reset();
+    lossEst = DYNPOWER_LOSS_NONE;
+    extraMargin = 0;
+    goodLqCount = 0;
+    holdCount = 0;
+}
+
+PowerLevels_e DynamicPowerController::update(dynpower_tlm_t const &tlm, dynpower_rf_t const &rf, PowerLevels_e curr, PowerLevels_e minPower, PowerLevels_e maxPower)
+{
+    // =============  LQ-based power boost up ==============
+    // Quick boost up of power when detected any emergency LQ drops.
+    // It should be useful for bando or sudden lost of LoS cases.
+    uint32_t lq_current = tlm.lq;
+    uint32_t lq_avg = mavgLq;
+    int32_t lq_diff = lq_avg - lq_current;
+    mavgLq.add(lq_current);
+    // if LQ drops quickly (DYNPOWER_LQ_BOOST_THRESH_DIFF) or critically low below DYNPOWER_LQ_BOOST_THRESH_MIN, immediately boost to the configured max power.
+    if (lq_diff >= DYNPOWER_LQ_BOOST_THRESH_DIFF || lq_current <= DYNPOWER_LQ_BOOST_THRESH_MIN)
+    {
+        holdCount = DYNPOWER_MODEL_HOLD;
+        return maxPower;
+    }
+
+    if (mode == DYNPOWER_MODE_MODEL)
+    {
+        return updateModel(tlm, rf, curr, minPower, maxPower, lq_avg);
+    }
+    return updateThreshold(tlm, rf, curr, minPower, maxPower, lq_avg);
+}
+
+PowerLevels_e DynamicPowerController::updateThreshold(dynpower_tlm_t const &tlm, dynpower_rf_t const &rf, PowerLevels_e curr, PowerLevels_e minPower, PowerLevels_e maxPower, uint32_t lq_avg)
+{
+    // How much available power is left for incremental increases
+    int32_t powerHeadroom = (int32_t)maxPower - (int32_t)curr;
+    uint8_t power = curr;
+
+    if (rf.DynpowerSnrThreshUp == DYNPOWER_SNR_THRESH_NONE)
+    {
+        // =============  RSSI-based power increment ==============
+        // a simple threshold compared against N sample average of
+        // rssi vs the sensitivity limit +/- some thresholds
+        meanRssi.add(tlm.rssi);
+
+        if (meanRssi.getCount() >= DYNPOWER_RSSI_CNT)
+        {
+            int32_t expected_RXsensitivity = rf.RXsensitivity;
+            int8_t rssi_inc_threshold = expected_RXsensitivity + DYNPOWER_RSSI_THRESH_UP;
+            int8_t rssi_dec_threshold = expected_RXsensitivity + DYNPOWER_RSSI_THRESH_DN;
+            int8_t avg_rssi = meanRssi.mean(); // resets it too
+            if ((avg_rssi < rssi_inc_threshold) && (powerHeadroom > 0))
+            {
+                DBGLN("+power (rssi)");
+                ++power;
+                --powerHeadroom;
+            }
+            else if (avg_rssi > rssi_dec_threshold && lq_avg >= DYNPOWER_LQ_THRESH_DN && power > minPower)
+            {
+                DBGVLN("-power (rssi)"); // Verbose because this spams when idle
+                --power;
+            }
+        }
+    } // ^^ if RSSI-based
+    else
+    {
+        // =============  SNR-based power increment ==============
+        // Decrease the power if SNR above threshold and LQ is good
+        // Increase the power for each (X) SNR below the threshold
+        int8_t snrScaled = tlm.snrScaled;
+        if (snrScaled >= rf.DynpowerSnrThreshDn && lq_avg >= DYNPOWER_LQ_THRESH_DN && power > minPower)
+        {
+            DBGVLN("-power (snr)"); // Verbose because this spams when idle
+            --power;
+        }
+
+        while ((snrScaled <= rf.DynpowerSnrThreshUp) && (powerHeadroom > 0))
+        {
+            DBGLN("+power (snr)");
+            ++power;
+            // Every power doubling will theoretically increase the SNR by 3dB, but closer to 2dB in testing
+            snrScaled += 2 * DYNPOWER_SNR_SCALE;
+            --powerHeadroom;
+        }
+    } // ^^ if SNR-based
+
+    // If instant LQ is low, but the SNR/RSSI did nothing, inc power by one step
+    if ((powerHeadroom > 0) && (power == curr) && (tlm.lq <= DYNPOWER_LQ_THRESH_UP))
+    {
+        DBGLN("+power (lq)");
+        ++power;
+    }
+
+    return (PowerLevels_e)power;
+}
+
+/**
+ * The lowest level from minPower to maxPower that leaves `margin` (quarter dB) with the
+ * estimated loss, or maxPower if none of them do
+ */
+static PowerLevels_e lowestLevelFor(int32_t lossEst, int32_t margin, PowerLevels_e minPower, PowerLevels_e maxPower)
+{
+    for (uint8_t power = minPower; power < maxPower; ++power)
+    {
+        if ((int32_t)powerToDbm((PowerLevels_e)power) * DYNPOWER_SNR_SCALE - lossEst >= margin)
+        {
+            return (PowerLevels_e)power;
+        }
+    }
+    return maxPower;
+}
+
+PowerLevels_e DynamicPowerController::updateModel(dynpower_tlm_t const &tlm, dynpower_rf_t const &rf, PowerLevels_e curr, PowerLevels_e minPower, PowerLevels_e maxPower, uint32_t lq_avg)
+{
+    // The margin is measured from where the threshold rules would raise the power, in quarter dB (the SNR's units)
+    int32_t target = (DYNPOWER_MODEL_MARGIN + extraMargin) * DYNPOWER_SNR_SCALE;
+    int32_t margin = ((int32_t)tlm.rssi - rf.RXsensitivity - DYNPOWER_RSSI_THRESH_UP) * DYNPOWER_SNR_SCALE;
+    if (rf.DynpowerSnrThreshUp != DYNPOWER_SNR_THRESH_NONE)
+    {
+        // The SNR is what counts at these rates, it also sees a raised noise floor such as from
+        // a video TX nearby. It tops out well short of a strong signal though, so once it says
+        // there is enough to lower the power the RSSI can say by how much.
+        int32_t const snrMargin = (int32_t)tlm.snrScaled - rf.DynpowerSnrThreshUp;
+        if (snrMargin < target + DYNPOWER_MODEL_HYSTERESIS * DYNPOWER_SNR_SCALE)
+        {
+            margin = snrMargin;
+        }
+        else
+        {
+            margin = std::max(margin, snrMargin);
+        }
+    }
+
+    // Take a worse loss at once, and a better one gradually so a deep fade is not forgotten on the next update
+    int32_t const loss = (int32_t)powerToDbm(curr) * DYNPOWER_SNR_SCALE - margin;
+    if (lossEst == DYNPOWER_LOSS_NONE || loss > lossEst)
+    {
+        lossEst = loss;
+    }
+    else
+    {
+        lossEst -= (lossEst - loss + DYNPOWER_MODEL_RELEASE_K - 1) / DYNPOWER_MODEL_RELEASE_K;
+    }
+
+    int32_t const currMargin = (int32_t)powerToDbm(curr) * DYNPOWER_SNR_SCALE - lossEst;
+
+    // Losing packets with the margin there, so the margin is not enough for this link
+    if (tlm.lq <= DYNPOWER_LQ_THRESH_UP && currMargin >= target)
+    {
+        extraMargin = std::min(extraMargin + DYNPOWER_MODEL_LQ_MARGIN_STEP, DYNPOWER_MODEL_LQ_MARGIN_MAX);
+        target = (DYNPOWER_MODEL_MARGIN + extraMargin) * DYNPOWER_SNR_SCALE;
+        goodLqCount = 0;
+    }
+    else if (tlm.lq >= DYNPOWER_LQ_THRESH_DN && extraMargin && ++goodLqCount >= DYNPOWER_MODEL_LQ_MARGIN_DECAY)
+    {
+        --extraMargin;
+        goodLqCount = 0;
+    }
+
+    if (currMargin < target)
+    {
+        PowerLevels_e const power = lowestLevelFor(lossEst, target, minPower, maxPower);
+        holdCount = DYNPOWER_MODEL_HOLD;
+        if (power > curr)
+        {
+            DBGLN("+power (model) %u", power);
+            return power;
+        }
+        return curr;
+    }
+
+    if (holdCount)
+    {
+        --holdCount;
+        return curr;
+    }
+
+    if (lq_avg >= DYNPOWER_LQ_THRESH_DN)
+    {
+        PowerLevels_e const power = lowestLevelFor(lossEst, target + DYNPOWER_MODEL_HYSTERESIS * DYNPOWER_SNR_SCALE, minPower, maxPower);
+        if (power < curr)
+        {
+            DBGVLN("-power (model) %u", power);
+            holdCount = DYNPOWER_MODEL_HOLD;
+            return power;
+        }
+    }
+
+    return curr;
+}
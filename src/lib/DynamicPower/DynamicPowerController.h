@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stdint.h>
+#include "POWERMGNT.h"
+#include "MeanAccumulator.h"
+
+#if !defined(DYNPOWER_SNR_THRESH_NONE)
+#define DYNPOWER_SNR_THRESH_NONE -127
+#endif
+// RADIO_SNR_SCALE, which is the same for every radio
+#define DYNPOWER_SNR_SCALE 4
+
+// LQ-based boost defines
+#define DYNPOWER_LQ_BOOST_THRESH_DIFF 20  // If LQ is dropped suddenly for this amount (relative), immediately boost to the max power configured.
+#define DYNPOWER_LQ_BOOST_THRESH_MIN  50  // If LQ is below this value (absolute), immediately boost to the max power configured.
+#define DYNPOWER_LQ_MOVING_AVG_K      8   // Number of previous values for calculating moving average. Best with power of 2.
+#define DYNPOWER_LQ_THRESH_UP         85  // Below this LQ, the RSSI/SNR code will increase the power if RSSI/SNR did nothing
+
+// RSSI-based increment defines
+#define DYNPOWER_RSSI_CNT 5               // Number of RSSI readings to average (straight average) to make an RSSI-based adjustment
+#define DYNPOWER_RSSI_THRESH_UP 15        // RSSI < (Sensitivity+Up) -> raise power
+#define DYNPOWER_RSSI_THRESH_DN 21        // RSSI > (Sensitivity+Dn) >- lower power
+
+// SNR-based increment defines
+#define DYNPOWER_LQ_THRESH_DN 95          // Min LQ for lowering power using SNR-based power lowering
+
+// Model-based defines
+#define DYNPOWER_MODEL_MARGIN 0           // Margin to run at (dB) over the RSSI or SNR the power would be raised at
+#define DYNPOWER_MODEL_HYSTERESIS 1       // Only lower the power to a level that leaves this much more than the target (dB)
+#define DYNPOWER_MODEL_HOLD 4             // Updates after a change before the power can be lowered again
+#define DYNPOWER_MODEL_RELEASE_K 2        // A lower loss is followed 1/K per update, a higher one at once
+#define DYNPOWER_MODEL_LQ_MARGIN_STEP 3   // Margin added when LQ is low with the target margin met (dB)
+#define DYNPOWER_MODEL_LQ_MARGIN_MAX 12
+#define DYNPOWER_MODEL_LQ_MARGIN_DECAY 8  // Updates with LQ at DYNPOWER_LQ_THRESH_DN or better to take 1dB of that off
+
+// What the controller is told of each LinkStatistics telemetry
+typedef struct {
+    int8_t rssi;        // uplink RSSI of the active antenna, dBm
+    int8_t snrScaled;   // uplink SNR, SNR_SCALE()d
+    uint8_t lq;         // uplink LQ, scaled up for packets LBT did not send
+} dynpower_tlm_t;
+
+// The parts of the current air rate's expresslrs_rf_pref_params_s it uses
+typedef struct {
+    int16_t RXsensitivity;
+    int8_t DynpowerSnrThreshUp; // DYNPOWER_SNR_THRESH_NONE for RSSI-based
+    int8_t DynpowerSnrThreshDn;
+} dynpower_rf_t;
+
+typedef enum {
+    // Step the power one level at a time on RSSI or SNR thresholds
+    DYNPOWER_MODE_THRESHOLD,
+    // Estimate the path loss from the RSSI and SNR at the current power and go straight to the
+    // lowest level that leaves the target margin over the RSSI or SNR the power would be raised at
+    DYNPOWER_MODE_MODEL,
+} dynpowerMode_e;
+
+template<uint8_t K, uint8_t SHIFT>
+class MovingAvg
+{
+public:
+  void init(uint32_t v) { _shiftedVal = v << SHIFT; };
+  void add(uint32_t v) {  _shiftedVal = ((K - 1) * _shiftedVal + (v << SHIFT)) / K; };
+  uint32_t getValue() const { return _shiftedVal >> SHIFT; };
+
+  void operator=(const uint32_t &v) { init(v); };
+  operator uint32_t () const { return getValue(); };
+private:
+  uint32_t _shiftedVal;
+};
+
+/**
+ * The power decision for each new LinkStatistics, kept apart from POWERMGNT and the
+ * config so it can be replayed against recorded telemetry. Both modes share the
+ * boost to the configured power on a sudden or critical LQ drop.
+ */
+class DynamicPowerController
+{
+public:
+    explicit DynamicPowerController(dynpowerMode_e mode = DYNPOWER_MODE_THRESHOLD);
+
+    void reset();
+    dynpowerMode_e getMode() const { return mode; }
+
+    /**
+     * @brief Work out the power level after a new LinkStatistics
+     * @param curr the power level the telemetry was received at
+     * @param minPower the lowest level the hardware can do
+     * @param maxPower the configured power, which is never exceeded
+     * @return the power level to use, curr to leave it
+     */
+    PowerLevels_e update(dynpower_tlm_t const &tlm, dynpower_rf_t const &rf, PowerLevels_e curr, PowerLevels_e minPower, PowerLevels_e maxPower);
+
+    // The model's path loss estimate in quarter dB: the output power less the margin it gives
+    int16_t getLossEstimate() const { return lossEst; }
+    // Margin the model has added on top of its target for low LQ the margin did not account for, dB
+    uint8_t getExtraMargin() const { return extraMargin; }
+
+private:
+    PowerLevels_e updateThreshold(dynpower_tlm_t const &tlm, dynpower_rf_t const &rf, PowerLevels_e curr, PowerLevels_e minPower, PowerLevels_e maxPower, uint32_t lq_avg);
+    PowerLevels_e updateModel(dynpower_tlm_t const &tlm, dynpower_rf_t const &rf, PowerLevels_e curr, PowerLevels_e minPower, PowerLevels_e maxPower, uint32_t lq_avg);
+
+    dynpowerMode_e mode;
+    MovingAvg<DYNPOWER_LQ_MOVING_AVG_K, 16> mavgLq;
+    MeanAccumulator<int32_t, int8_t, -128> meanRssi;
+
+    int16_t lossEst;
+    uint8_t extraMargin;
+    uint8_t goodLqCount;
+    uint8_t holdCount;
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include "FHSS.h"
+
+// How long to wait for the TX to echo a proposal's generation before sending it again
+#define AFH_RESEND_INTERVAL 1000
+// Sends of one proposal before giving up on it, a TX without adaptive hopping never echoes it
+#define AFH_MAX_SENDS 5
+
+enum afhProposalAction_e {
+    afhIdle,        // Nothing in flight, a new proposal can be made
+    afhWaiting,     // Waiting for the TX to echo the generation
+    afhResend,      // The proposal was not echoed in time, send it again
+    afhGaveUp,      // Sent AFH_MAX_SENDS times without an echo, it has been dropped
+};
+
+/**
+ * The RX side of the adaptive hopping handshake: the channel mask proposed to
+ * the TX, waiting for the TX to echo its generation in a SYNC packet.
+ *
+ * The proposal goes to the TX in a telemetry frame which can be lost, so it is
+ * sent again every AFH_RESEND_INTERVAL ms until it is echoed, and dropped after
+ * AFH_MAX_SENDS so a TX that does not support adaptive hopping does not hold up
+ * the next one.
+ *
+ * start(), poll() and reset() are called from the loop, echoedBy() and finish() from the RX ISR.
+ * The loop fills in the proposal and sets pending last, the ISR only clears it,
+ * so each side only touches the other's data once the flag hands it over.
+ */
+class AfhProposal
+{
+public:
+    AfhProposal() { reset(); }
+
+    void reset()
+    {
+        pending = false;
+        gen = 0;
+        sends = 0;
+        lastSent = 0;
+        memset(mask, 0, sizeof(mask));
+    }
+
+    /**
+     * @brief Start proposing mask with generation newGen, the first send is due now
+     */
+    void start(uint8_t const *newMask, uint8_t newGen, uint32_t now)
+    {
+        memcpy(mask, newMask, sizeof(mask));
+        gen = newGen;
+        sends = 1;
+        lastSent = now;
+        std::atomic_signal_fence(std::memory_order_release);
+        pending = true;
+    }
+
+    /**
+     * @brief The TX's SYNC carries syncGen
+     * @return true if that accepts the pending proposal, call finish() once it is swapped in
+     */
+    bool echoedBy(uint8_t syncGen) const
+    {
+        if (!pending)
+            return false;
+        std::atomic_signal_fence(std::memory_order_acquire);
+        return syncGen == gen;
+    }
+
+    void finish() { pending = false; }
+
+    /**
+     * @brief Check on the proposal in flight, if any
+     */
+    afhProposalAction_e poll(uint32_t now)
+    {
+        if (!pending)
+            return afhIdle;
+        std::atomic_signal_fence(std::memory_order_acquire);
+        if (now - lastSent < AFH_RESEND_INTERVAL)
+            return afhWaiting;
+        if (sends >= AFH_MAX_SENDS)
+        {
+            pending = false;
+            return afhGaveUp;
+        }
+        ++sends;
+        lastSent = now;
+        return afhResend;
+    }
+
+    bool isPending() const { return pending; }
+    uint8_t getGen() const { return gen; }
+    uint8_t const *getMask() const { return mask; }
+
+private:
+    volatile bool pending;
+    uint8_t gen;
+    uint8_t sends;
+    uint32_t lastSent;
+    uint8_t mask[FHSS_CHANNEL_MASK_BYTES];
+};
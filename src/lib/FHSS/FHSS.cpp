@@ -46,10 +46,20 @@ const fhss_config_t domains[] = {
 const fhss_config_t *FHSSconfig;
 const fhss_config_t *FHSSconfigDualBand;
 
-// Actual sequence of hops as indexes into the frequency list
+// Actual sequence of hops as indexes into the frequency list, before any channels are substituted by FHSSapplyChannelMask()
 uint8_t FHSSsequence[FHSS_SEQUENCE_LEN];
 uint8_t FHSSsequence_DualBand[FHSS_SEQUENCE_LEN];
 
+// The primary band sequence with the blocked channels substituted. The hop uses one while the
+// other is built, so a new mask never changes the sequence under an ISR that is hopping through it.
+typedef struct {
+    uint8_t sequence[FHSS_SEQUENCE_LEN];
+    uint8_t mask[FHSS_CHANNEL_MASK_BYTES];
+} fhss_masked_sequence_t;
+static fhss_masked_sequence_t FHSSmasked[2];
+static uint8_t FHSSmaskedActive;
+uint8_t const *FHSSchannelMask = FHSSmasked[0].mask;
+
 // Which entry in the sequence we currently are on
 uint8_t volatile FHSSptr;
 
@@ -72,6 +82,30 @@ bool FHSSuseDualBand = false;
 uint16_t primaryBandCount;
 uint16_t secondaryBandCount;
 
+// Register values of every channel, so a hop is just table lookups
+fhss_freq_table_t FHSSfreqTable;
+fhss_freq_table_t FHSSfreqTable_DualBand;
+fhss_hop_t FHSShop;
+// The Dual Band frequencies are not corrected. The hop reads this through FHSShop, so it must not be in flash on ESP32
+#if defined(PLATFORM_ESP32)
+static DRAM_ATTR const int32_t FHSSnoFreqCorrection = 0;
+#else
+static const int32_t FHSSnoFreqCorrection = 0;
+#endif
+
+static void FHSSbuildFreqTable(const fhss_config_t *config, uint32_t spread, fhss_freq_table_t *table)
+{
+    uint32_t const freqCount = config->freq_count;
+    for (uint32_t ch = 0; ch < freqCount; ch++)
+    {
+        table->freq[ch] = config->freq_start + (spread * ch / FREQ_SPREAD_SCALE);
+    }
+    for (uint32_t ch = 0; ch < freqCount; ch++)
+    {
+        table->geminiFreq[ch] = table->freq[(ch + freqCount / 2) % freqCount];
+    }
+}
+
 void FHSSrandomiseFHSSsequence(const uint32_t seed)
 {
     FHSSconfig = &domains[firmwareOptions.domain];
@@ -83,7 +117,12 @@ void FHSSrandomiseFHSSsequence(const uint32_t seed)
     DBGLN("Number of FHSS frequencies = %u", FHSSconfig->freq_count);
     DBGLN("Sync channel = %u", sync_channel);
 
+    FHSSbuildFreqTable(FHSSconfig, freq_spread, &FHSSfreqTable);
     FHSSrandomiseFHSSsequenceBuild(seed, FHSSconfig->freq_count, sync_channel, FHSSsequence);
+    FHSSmaskedActive = 0;
+    memcpy(FHSSmasked[0].sequence, FHSSsequence, sizeof(FHSSsequence));
+    memset(FHSSmasked[0].mask, 0, sizeof(FHSSmasked[0].mask));
+    FHSSchannelMask = FHSSmasked[0].mask;
 
 #if defined(RADIO_LR1121)
     FHSSconfigDualBand = &domainsDualBand[0];
@@ -95,10 +134,59 @@ void FHSSrandomiseFHSSsequence(const uint32_t seed)
     DBGLN("Number of FHSS frequencies = %u", FHSSconfigDualBand->freq_count);
     DBGLN("Sync channel Dual Band = %u", sync_channel_DualBand);
 
+    FHSSbuildFreqTable(FHSSconfigDualBand, freq_spread_DualBand, &FHSSfreqTable_DualBand);
     FHSSusePrimaryFreqBand = false;
     FHSSrandomiseFHSSsequenceBuild(seed, FHSSconfigDualBand->freq_count, sync_channel_DualBand, FHSSsequence_DualBand);
     FHSSusePrimaryFreqBand = true;
 #endif
+
+    FHSSsetActiveBand(FHSSusePrimaryFreqBand, FHSSuseDualBand);
+}
+
+void FHSSsetActiveBand(bool usePrimaryFreqBand, bool useDualBand)
+{
+    FHSSusePrimaryFreqBand = usePrimaryFreqBand;
+    FHSSuseDualBand = useDualBand;
+
+    if (FHSSusePrimaryFreqBand)
+    {
+        FHSShop.sequence = FHSSmasked[FHSSmaskedActive].sequence;
+        FHSShop.freqs = FHSSfreqTable.freq;
+        FHSShop.freqCorrection = &FreqCorrection;
+        FHSShop.syncChannel = sync_channel;
+    }
+    else
+    {
+        FHSShop.sequence = FHSSsequence_DualBand;
+        FHSShop.freqs = FHSSfreqTable_DualBand.freq;
+        FHSShop.freqCorrection = &FHSSnoFreqCorrection;
+        FHSShop.syncChannel = sync_channel_DualBand;
+    }
+
+    if (FHSSuseDualBand)
+    {
+        // When using Dual Band there is no need to calculate an offset frequency. Unlike Gemini with 2 frequencies in the same band.
+        FHSShop.geminiSequence = FHSSsequence_DualBand;
+        FHSShop.geminiFreqs = FHSSfreqTable_DualBand.freq;
+        FHSShop.geminiFreqCorrection = &FHSSnoFreqCorrection;
+        FHSShop.geminiSyncChannel = sync_channel_DualBand;
+    }
+    else if (FHSSusePrimaryFreqBand)
+    {
+        FHSShop.geminiSequence = FHSSmasked[FHSSmaskedActive].sequence;
+        FHSShop.geminiFreqs = FHSSfreqTable.geminiFreq;
+        FHSShop.geminiFreqCorrection = &FreqCorrection_2;
+        FHSShop.geminiSyncChannel = sync_channel;
+    }
+    else
+    {
+        FHSShop.geminiSequence = FHSSsequence_DualBand;
+        FHSShop.geminiFreqs = FHSSfreqTable_DualBand.geminiFreq;
+        FHSShop.geminiFreqCorrection = &FHSSnoFreqCorrection;
+        FHSShop.geminiSyncChannel = sync_channel_DualBand;
+    }
+
+    FHSShop.sequenceCount = FHSSgetSequenceCount();
 }
 
 /**
@@ -157,6 +245,81 @@ void FHSSrandomiseFHSSsequenceBuild(const uint32_t seed, uint32_t freqCount, uin
     DBGCR;
 }
 
+/**
+Replace each blocked channel in the sequence with the next of the unblocked
+channels in turn, so the substitutes are spread evenly and both ends of the
+link derive the same sequence from the same mask. Only the blocked entries
+change, so a node still using the old sequence only misses the blocked hops.
+The sync channel can not be blocked and is never used as a substitute.
+The sequence is built in the buffer the hop is not using, the caller must
+not call this again until FHSSswapChannelMask() has been.
+*/
+bool FHSSprepareChannelMask(uint8_t const *blockedMask)
+{
+    uint32_t const freqCount = FHSSconfig->freq_count;
+    if (freqCount > FHSS_CHANNEL_MASK_BYTES * 8)
+        return false;
+
+    uint8_t good[FHSS_CHANNEL_MASK_BYTES * 8];
+    uint32_t goodCount = 0;
+    for (uint32_t ch = 0; ch < freqCount; ++ch)
+    {
+        bool const blocked = blockedMask && FHSSchannelIsBlocked(blockedMask, ch);
+        if (blocked && ch == sync_channel)
+            return false;
+        if (!blocked && ch != sync_channel)
+            good[goodCount++] = ch;
+    }
+    if (freqCount - 1 - goodCount > freqCount / FHSS_MAX_BLOCKED_DIVISOR)
+        return false;
+
+    fhss_masked_sequence_t * const spare = &FHSSmasked[FHSSmaskedActive ^ 1];
+    uint32_t next = 0;
+    for (uint16_t i = 0; i < primaryBandCount; i++)
+    {
+        uint8_t ch = FHSSsequence[i];
+        if (blockedMask && FHSSchannelIsBlocked(blockedMask, ch))
+        {
+            ch = good[next];
+            next = (next + 1) % goodCount;
+            // Do not dwell on the same channel for two hops
+            if (i > 0 && ch == spare->sequence[i - 1])
+            {
+                ch = good[next];
+                next = (next + 1) % goodCount;
+            }
+        }
+        spare->sequence[i] = ch;
+    }
+
+    if (blockedMask)
+        memcpy(spare->mask, blockedMask, sizeof(spare->mask));
+    else
+        memset(spare->mask, 0, sizeof(spare->mask));
+    return true;
+}
+
+void ICACHE_RAM_ATTR FHSSswapChannelMask()
+{
+    FHSSmaskedActive ^= 1;
+    fhss_masked_sequence_t const * const active = &FHSSmasked[FHSSmaskedActive];
+    if (FHSSusePrimaryFreqBand)
+    {
+        FHSShop.sequence = active->sequence;
+        if (!FHSSuseDualBand)
+            FHSShop.geminiSequence = active->sequence;
+    }
+    FHSSchannelMask = active->mask;
+}
+
+bool FHSSapplyChannelMask(uint8_t const *blockedMask)
+{
+    if (!FHSSprepareChannelMask(blockedMask))
+        return false;
+    FHSSswapChannelMask();
+    return true;
+}
+
 bool isDomain868()
 {
     return strcmp(FHSSconfig->domain, "EU868") == 0;
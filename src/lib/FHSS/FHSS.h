@@ -50,10 +50,58 @@ extern uint8_t FHSSsequence_DualBand[];
 extern uint_fast8_t sync_channel_DualBand;
 extern const fhss_config_t *FHSSconfigDualBand;
 
+// Largest freq_count of any domain
+#define FHSS_MAX_CHANNELS 80
+
+// Register values of each channel of a band, and of the channel half the band away from it (Gemini)
+typedef struct {
+    uint32_t freq[FHSS_MAX_CHANNELS];
+    uint32_t geminiFreq[FHSS_MAX_CHANNELS];
+} fhss_freq_table_t;
+
+// What each radio hops through, selected by FHSSsetActiveBand() so the hop needs no branches
+typedef struct {
+    uint8_t const *sequence;            // Radio 1
+    uint32_t const *freqs;
+    int32_t const *freqCorrection;
+    uint8_t const *geminiSequence;      // Radio 2
+    uint32_t const *geminiFreqs;
+    int32_t const *geminiFreqCorrection;
+    uint16_t sequenceCount;
+    uint8_t syncChannel;
+    uint8_t geminiSyncChannel;
+} fhss_hop_t;
+
+extern fhss_freq_table_t FHSSfreqTable;
+extern fhss_freq_table_t FHSSfreqTable_DualBand;
+extern fhss_hop_t FHSShop;
+
 // create and randomise an FHSS sequence
 void FHSSrandomiseFHSSsequence(uint32_t seed);
 void FHSSrandomiseFHSSsequenceBuild(uint32_t seed, uint32_t freqCount, uint_fast8_t sync_channel, uint8_t *sequence);
 
+// Adaptive hopping, one bit per channel of the primary band set if the channel is blocked
+#define FHSS_CHANNEL_MASK_BYTES 10
+// At most 1/FHSS_MAX_BLOCKED_DIVISOR of the channels can be blocked
+#define FHSS_MAX_BLOCKED_DIVISOR 4
+// The blocked channels of the sequence being hopped through
+extern uint8_t const *FHSSchannelMask;
+// Substitute the blocked channels in a copy of the primary band sequence, nullptr to unblock all,
+// which is not hopped through until FHSSswapChannelMask(). Not for an ISR, it rebuilds the sequence.
+// Returns false and leaves the sequence unchanged if the mask is not valid for the domain
+bool FHSSprepareChannelMask(uint8_t const *blockedMask);
+// Start hopping through the sequence FHSSprepareChannelMask() built, only a pointer swap for the ISR
+void FHSSswapChannelMask();
+// Both of the above, for when nothing is hopping
+bool FHSSapplyChannelMask(uint8_t const *blockedMask);
+// Set FHSSusePrimaryFreqBand/FHSSuseDualBand and point FHSShop at the tables they select
+void FHSSsetActiveBand(bool usePrimaryFreqBand, bool useDualBand);
+
+static inline bool FHSSchannelIsBlocked(uint8_t const *blockedMask, uint8_t channel)
+{
+    return blockedMask[channel / 8] & (1 << (channel % 8));
+}
+
 static inline uint32_t FHSSgetMinimumFreq(void)
 {
     return FHSSconfig->freq_start;
@@ -77,6 +125,21 @@ static inline uint32_t FHSSgetChannelCount(void)
     }
 }
 
+/**
+ * @brief The most CRC-passing packets out of 100 which could be received on a single channel,
+ * i.e. from another TX not on our FHSS sequence. The LQ must be GREATER THAN this value, not >=
+ * The amount of time we coexist on the same channel is 100 divided by the total number of
+ * packets in a FHSS loop (rounded up) and there would be hopInterval packets received each
+ * time it passes by so
+ * hopInterval * trunc((100 + (hopInterval * numfhss) - 1) / (hopInterval * numfhss))
+ * With a interval of 4 this works out to: 2.4=4, FCC915=4, AU915=8, EU868=8, EU/AU433=36
+ */
+static inline uint8_t FHSSminLqForChaos(uint8_t hopInterval)
+{
+    const uint32_t numfhss = FHSSgetChannelCount();
+    return hopInterval * ((hopInterval * numfhss + 99) / (hopInterval * numfhss));
+}
+
 // get the number of entries in the FHSS sequence
 static inline uint16_t FHSSgetSequenceCount()
 {
@@ -105,14 +168,7 @@ static inline uint16_t FHSSgetSequenceCount()
 // get the initial frequency, which is also the sync channel
 static inline uint32_t FHSSgetInitialFreq()
 {
-    if (FHSSusePrimaryFreqBand)
-    {
-        return FHSSconfig->freq_start + (sync_channel * freq_spread / FREQ_SPREAD_SCALE) - FreqCorrection;
-    }
-    else
-    {
-        return FHSSconfigDualBand->freq_start + (sync_channel_DualBand * freq_spread_DualBand / FREQ_SPREAD_SCALE);
-    }
+    return FHSShop.freqs[FHSShop.syncChannel] - *FHSShop.freqCorrection;
 }
 
 // Get the current sequence pointer
@@ -121,38 +177,31 @@ static inline uint8_t FHSSgetCurrIndex()
     return FHSSptr;
 }
 
+// Get the channel number of the current frequency within its band
+static inline uint8_t FHSSgetCurrChannel()
+{
+    return FHSShop.sequence[FHSSptr];
+}
+
 // Is the current frequency the sync frequency
 static inline uint8_t FHSSonSyncChannel()
 {
-    if (FHSSusePrimaryFreqBand)
-    {
-        return FHSSsequence[FHSSptr] == sync_channel;
-    }
-    else
-    {
-        return FHSSsequence_DualBand[FHSSptr] == sync_channel_DualBand;
-    }
+    return FHSShop.sequence[FHSSptr] == FHSShop.syncChannel;
 }
 
 // Set the sequence pointer, used by RX on SYNC
 static inline void FHSSsetCurrIndex(const uint8_t value)
 {
-    FHSSptr = value % FHSSgetSequenceCount();
+    FHSSptr = value % FHSShop.sequenceCount;
 }
 
 // Advance the pointer to the next hop and return the frequency of that channel
 static inline uint32_t FHSSgetNextFreq()
 {
-    FHSSptr = (FHSSptr + 1) % FHSSgetSequenceCount();
-
-    if (FHSSusePrimaryFreqBand)
-    {
-        return FHSSconfig->freq_start + (freq_spread * FHSSsequence[FHSSptr] / FREQ_SPREAD_SCALE) - FreqCorrection;
-    }
-    else
-    {
-        return FHSSconfigDualBand->freq_start + (freq_spread_DualBand * FHSSsequence_DualBand[FHSSptr] / FREQ_SPREAD_SCALE);
-    }
+    uint32_t ptr = FHSSptr + 1;
+    ptr = (ptr < FHSShop.sequenceCount) ? ptr : 0;
+    FHSSptr = ptr;
+    return FHSShop.freqs[FHSShop.sequence[ptr]] - *FHSShop.freqCorrection;
 }
 
 static inline const char *FHSSgetRegulatoryDomain()
@@ -167,60 +216,14 @@ static inline const char *FHSSgetRegulatoryDomain()
     }
 }
 
-// Get frequency offset by half of the domain frequency range
-static inline uint32_t FHSSGeminiFreq(uint8_t FHSSsequenceIdx)
-{
-    uint32_t freq;
-    uint32_t numfhss = FHSSgetChannelCount();
-    uint8_t offSetIdx = (FHSSsequenceIdx + (numfhss / 2)) % numfhss; 
-
-    if (FHSSusePrimaryFreqBand)
-    {
-        freq = FHSSconfig->freq_start + (freq_spread * offSetIdx / FREQ_SPREAD_SCALE) - FreqCorrection_2;
-    }
-    else
-    {
-        freq = FHSSconfigDualBand->freq_start + (freq_spread_DualBand * offSetIdx / FREQ_SPREAD_SCALE);
-    }
-
-    return freq;
-}
-
+// Get the frequency of radio 2 for the current hop, offset by half of the domain
+// frequency range in Gemini mode, or the secondary band channel in Dual Band mode
 static inline uint32_t FHSSgetGeminiFreq()
 {
-    if (FHSSuseDualBand)
-    {
-        // When using Dual Band there is no need to calculate an offset frequency. Unlike Gemini with 2 frequencies in the same band.
-        return FHSSconfigDualBand->freq_start + (FHSSsequence_DualBand[FHSSptr] * freq_spread_DualBand / FREQ_SPREAD_SCALE);
-    }
-    else
-    {
-        if (FHSSusePrimaryFreqBand)
-        {
-            return FHSSGeminiFreq(FHSSsequence[FHSSgetCurrIndex()]);
-        }
-        else
-        {
-            return FHSSGeminiFreq(FHSSsequence_DualBand[FHSSgetCurrIndex()]);
-        }
-    }
+    return FHSShop.geminiFreqs[FHSShop.geminiSequence[FHSSptr]] - *FHSShop.geminiFreqCorrection;
 }
 
 static inline uint32_t FHSSgetInitialGeminiFreq()
 {
-    if (FHSSuseDualBand)
-    {
-        return FHSSconfigDualBand->freq_start + (sync_channel_DualBand * freq_spread_DualBand / FREQ_SPREAD_SCALE);
-    }
-    else
-    {
-        if (FHSSusePrimaryFreqBand)
-        {
-            return FHSSGeminiFreq(sync_channel);
-        }
-        else
-        {
-            return FHSSGeminiFreq(sync_channel_DualBand);
-        }
-    }
+    return FHSShop.geminiFreqs[FHSShop.geminiSyncChannel] - *FHSShop.geminiFreqCorrection;
 }
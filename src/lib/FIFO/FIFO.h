@@ -252,7 +252,9 @@ public:
     {
         if (size() > 1)
         {
-            return (uint16_t)pop() + ((uint16_t)pop() << 8);
+            // The two pops have to be sequenced, the order operands are evaluated in is unspecified
+            uint16_t const low = pop();
+            return low + ((uint16_t)pop() << 8);
         }
         return 0;
     }
@@ -0,0 +1,207 @@
+#pragma once
+
+#include "targets.h"
+#include <algorithm>
+#include <atomic>
+#include <string.h>
+
+/**
+ * @brief A lock-free FIFO for exactly one producer and one consumer, e.g. the main loop and an ISR.
+ *
+ * Unlike FIFO, no interrupts are masked around the pushes and pops. `head` is only written by the
+ * producer and `tail` by the consumer, both count bytes freely and are masked into the buffer, so
+ * the size must be a power of two and bulk copies are at most two memcpy spans.
+ *
+ * An instance is used either as a byte stream (pushBytes/popBytes), which rejects data that does not
+ * fit, or as a queue of 8-bit length-prefixed packets (pushPacket/popPacket), which drops the oldest
+ * packets to make room for a new one. Dropping is the one case where the producer moves `tail`, so
+ * the consumer commits every pop with a compare-and-swap and retries if a packet was dropped under it.
+ *
+ * @tparam FIFO_SIZE size of the FIFO in bytes, a power of two
+ */
+template <uint32_t FIFO_SIZE>
+class SPSCFIFO
+{
+    static_assert(FIFO_SIZE && (FIFO_SIZE & (FIFO_SIZE - 1)) == 0, "SPSCFIFO size must be a power of two");
+    static const uint32_t MASK = FIFO_SIZE - 1;
+
+private:
+    uint8_t buffer[FIFO_SIZE] = {0};
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+
+    ICACHE_RAM_ATTR void inline copyIn(uint32_t pos, const uint8_t *data, uint32_t len)
+    {
+        uint32_t const idx = pos & MASK;
+        uint32_t const first = std::min(len, FIFO_SIZE - idx);
+        memcpy(&buffer[idx], data, first);
+        memcpy(buffer, data + first, len - first);
+    }
+
+    ICACHE_RAM_ATTR void inline copyOut(uint32_t pos, uint8_t *data, uint32_t len) const
+    {
+        uint32_t const idx = pos & MASK;
+        uint32_t const first = std::min(len, FIFO_SIZE - idx);
+        memcpy(data, &buffer[idx], first);
+        memcpy(data + first, buffer, len - first);
+    }
+
+    /**
+     * @brief Move `tail` from `expected` to `desired` if nobody else has moved it,
+     * otherwise `expected` is updated to the current `tail`
+     */
+    ICACHE_RAM_ATTR bool inline swapTail(uint32_t &expected, uint32_t desired)
+    {
+#if defined(PLATFORM_ESP8266)
+        // The lx106 has no compare-and-swap instruction, but the ISRs can only preempt
+        // the main loop so masking them for the compare alone is enough
+        noInterrupts();
+        uint32_t const current = tail.load(std::memory_order_relaxed);
+        bool const swapped = current == expected;
+        if (swapped)
+            tail.store(desired, std::memory_order_relaxed);
+        else
+            expected = current;
+        interrupts();
+        return swapped;
+#else
+        return tail.compare_exchange_strong(expected, desired, std::memory_order_acq_rel, std::memory_order_acquire);
+#endif
+    }
+
+public:
+    /**
+     * @brief Push all bytes to the FIFO, if they will not all fit then none are pushed. Producer only.
+     *
+     * @param data pointer to the bytes to be pushed onto the FIFO
+     * @param len number of bytes in `data` to push
+     * @return true if the bytes were pushed
+     */
+    ICACHE_RAM_ATTR bool inline pushBytes(const uint8_t *data, uint32_t len)
+    {
+        if (len > free())
+            return false;
+        uint32_t const h = head.load(std::memory_order_relaxed);
+        copyIn(h, data, len);
+        head.store(h + len, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Push a single byte, it is not pushed if the FIFO is full. Producer only.
+     */
+    ICACHE_RAM_ATTR bool inline push(const uint8_t data)
+    {
+        return pushBytes(&data, 1);
+    }
+
+    /**
+     * @brief Pop up to `len` bytes into the buffer pointed to by `data`. Consumer only.
+     *
+     * @return the number of bytes popped, less than `len` if the FIFO did not hold that many
+     */
+    ICACHE_RAM_ATTR uint32_t inline popBytes(uint8_t *data, uint32_t len)
+    {
+        uint32_t t = tail.load(std::memory_order_acquire);
+        for (;;)
+        {
+            uint32_t const count = std::min(len, head.load(std::memory_order_acquire) - t);
+            copyOut(t, data, count);
+            if (swapTail(t, t + count))
+                return count;
+        }
+    }
+
+    /**
+     * @brief Push `data` as a length-prefixed packet, dropping the oldest packets
+     * in the FIFO until it fits. Producer only.
+     *
+     * @param data pointer to the packet
+     * @param len length of the packet
+     * @return false if the packet can never fit in the FIFO
+     */
+    ICACHE_RAM_ATTR bool inline pushPacket(const uint8_t *data, uint8_t len)
+    {
+        if ((uint32_t)len + 1 > FIFO_SIZE)
+            return false;
+
+        uint32_t const h = head.load(std::memory_order_relaxed);
+        uint32_t t = tail.load(std::memory_order_acquire);
+        while (FIFO_SIZE - (h - t) < (uint32_t)len + 1)
+        {
+            // Only the producer writes the buffer, so the length at t is valid until the consumer moves
+            // tail, in which case the swap fails and the free space is checked again with the new tail
+            uint32_t const next = t + 1 + buffer[t & MASK];
+            if (swapTail(t, next))
+                t = next;
+        }
+
+        buffer[h & MASK] = len;
+        copyIn(h + 1, data, len);
+        head.store(h + 1 + len, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Pop the packet at the head of the FIFO into `data`. Consumer only.
+     *
+     * @param data pointer to a buffer of at least `maxLen` bytes
+     * @param maxLen the largest packet to pop, a larger packet is left in the FIFO
+     * @return the length of the packet popped, or 0 if there was none
+     */
+    ICACHE_RAM_ATTR uint8_t inline popPacket(uint8_t *data, uint32_t maxLen)
+    {
+        uint32_t t = tail.load(std::memory_order_acquire);
+        for (;;)
+        {
+            if (t == head.load(std::memory_order_acquire))
+                return 0;
+            // If the producer drops this packet while it is being copied the swap fails and the next one is read
+            uint8_t const len = buffer[t & MASK];
+            if (len > maxLen)
+                return 0;
+            copyOut(t + 1, data, len);
+            if (swapTail(t, t + 1 + len))
+                return len;
+        }
+    }
+
+    /**
+     * @brief return the length of the packet at the head of the FIFO without removing it, or 0 if empty.
+     * Consumer only, and the packet may still be dropped before it is popped
+     */
+    ICACHE_RAM_ATTR uint8_t inline peekPacketSize() const
+    {
+        uint32_t const t = tail.load(std::memory_order_acquire);
+        if (t == head.load(std::memory_order_acquire))
+            return 0;
+        return buffer[t & MASK];
+    }
+
+    /**
+     * @brief return the number of bytes in the FIFO, including the packet length prefixes
+     */
+    ICACHE_RAM_ATTR uint32_t inline size() const
+    {
+        // tail first, so head can only have moved further ahead of it
+        uint32_t const t = tail.load(std::memory_order_acquire);
+        return head.load(std::memory_order_acquire) - t;
+    }
+
+    /**
+     * @brief return the number of bytes free in the FIFO
+     */
+    ICACHE_RAM_ATTR uint32_t inline free() const
+    {
+        return FIFO_SIZE - size();
+    }
+
+    /**
+     * @brief discard everything in the FIFO. Safe to call from either side, a pop
+     * in progress on the consumer fails its swap and finds the FIFO empty
+     */
+    ICACHE_RAM_ATTR void inline flush()
+    {
+        tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+};
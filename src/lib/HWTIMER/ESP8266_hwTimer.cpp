@@ -14,7 +14,9 @@ volatile int32_t hwTimer::FreqOffset = 0;
 // Internal implementation specific variables
 static uint32_t NextTimeout;
 
+#if !defined(HWTIMER_TICKS_PER_US)
 #define HWTIMER_TICKS_PER_US 5
+#endif
 #define HWTIMER_PRESCALER (clockCyclesPerMicrosecond() / HWTIMER_TICKS_PER_US)
 
 void hwTimer::init(void (*callbackTick)(), void (*callbackTock)())
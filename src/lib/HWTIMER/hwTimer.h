@@ -7,6 +7,8 @@
 #define TimerIntervalUSDefault 4000
 #else
 #define TimerIntervalUSDefault 20000
+// Resolution of the RX timer, the frequency offset is in these units
+#define HWTIMER_TICKS_PER_US 5
 #endif
 
 /**
@@ -73,6 +75,11 @@ public:
      */
     static ICACHE_RAM_ATTR void inline decFreqOffset() { FreqOffset--; }
 
+    /**
+     * @brief Set the frequency offset, in timer ticks added to each half of the interval
+     */
+    static ICACHE_RAM_ATTR void inline setFreqOffset(int32_t offset) { FreqOffset = offset; }
+
     /**
      * @brief Get the frequency offset
      */
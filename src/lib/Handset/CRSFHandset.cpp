@@ -1,5 +1,6 @@
 #include "CRSF.h"
 #include "CRSFHandset.h"
+#include "ChannelCodec.h"
 #include "FIFO.h"
 #include "logging.h"
 #include "helpers.h"
@@ -242,28 +243,8 @@ void CRSFHandset::sendSyncPacketToTX() // in values in us.
 void CRSFHandset::RcPacketToChannelsData() // data is packed as 11 bits per channel
 {
     auto payload = (uint8_t const * const)&inBuffer.asRCPacket_t.channels;
-    constexpr unsigned srcBits = 11;
-    constexpr unsigned dstBits = 11;
-    constexpr unsigned inputChannelMask = (1 << srcBits) - 1;
-    constexpr unsigned precisionShift = dstBits - srcBits;
-
-    // code from BetaFlight rx/crsf.cpp / bitpacker_unpack
-    uint8_t bitsMerged = 0;
-    uint32_t readValue = 0;
-    unsigned readByteIndex = 0;
-    for (uint32_t & n : ChannelData)
-    {
-        while (bitsMerged < srcBits)
-        {
-            uint8_t readByte = payload[readByteIndex++];
-            readValue |= ((uint32_t) readByte) << bitsMerged;
-            bitsMerged += 8;
-        }
-        //printf("rv=%x(%x) bm=%u\n", readValue, (readValue & inputChannelMask), bitsMerged);
-        n = (readValue & inputChannelMask) << precisionShift;
-        readValue >>= srcBits;
-        bitsMerged -= srcBits;
-    }
+    typedef ChannelCodec<CRSF_NUM_CHANNELS, 11> codec;
+    codec::unpack(payload, ChannelData);
 
     // Call the registered RCdataCallback, if there is one, so it can modify the channel data if it needs to.
     if (RCdataCallback) RCdataCallback();
@@ -273,7 +254,7 @@ void CRSFHandset::RcPacketToChannelsData() // data is packed as 11 bits per chan
     // frame len 24 -> arming mode CH5: use channel 5 value
     // frame len 25 -> arming mode Switch: use commanded arming status in extra byte
     //
-    armCmd = inBuffer.asUint8_t[1] == 24 ? CRSF_to_BIT(ChannelData[4]) : payload[readByteIndex];
+    armCmd = inBuffer.asUint8_t[1] == 24 ? CRSF_to_BIT(ChannelData[4]) : payload[codec::BYTES];
 
     // monitoring arming state
     if (lastArmCmd != armCmd) {
@@ -0,0 +1,35 @@
+#include "ISRProfile.h"
+
+// Nothing is compiled into the firmware unless it is profiling, the unit tests use it directly
+#if defined(DEBUG_ISR_PROFILE) || defined(UNIT_TEST)
+#include <string.h>
+
+volatile uint32_t ISRProfile::lastTimerEvent;
+isrProfileStats_t ISRProfile::stats[ISRPROF_COUNT];
+
+uint32_t ISRProfile::cyclesPerUs()
+{
+#if defined(PLATFORM_ESP8266) || defined(PLATFORM_ESP32)
+    return ESP.getCpuFreqMHz();
+#else
+    return 1;
+#endif
+}
+
+void ISRProfile::snapshot(isrProfileStats_t *dest)
+{
+    // On the ESP32 this only blocks the ISRs on this core, the other core
+    // can still update a counter while it is being copied
+    noInterrupts();
+    memcpy(dest, stats, sizeof(stats));
+    interrupts();
+}
+
+void ISRProfile::reset()
+{
+    noInterrupts();
+    memset(stats, 0, sizeof(stats));
+    interrupts();
+}
+
+#endif
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "targets.h"
+
+/**
+ * Execution time profile of the radio and timer ISRs, enabled with DEBUG_ISR_PROFILE
+ *
+ * Each profiled function records the CPU cycles from its entry to its exit
+ * into min/max/histogram counters, and how late it exits relative to the most
+ * recent timer event, which shows how close it comes to the next one. All the
+ * storage is static and nothing is printed from the ISR, the counters are read
+ * from the main loop with ISRProfile::snapshot()
+ */
+
+enum isrProfileId_e {
+    ISRPROF_RXDONE,
+    ISRPROF_TXDONE,
+    ISRPROF_TIMER_TICK,
+    ISRPROF_TIMER_TOCK, // The only timer callback on the TX
+    ISRPROF_COUNT
+};
+
+// Histogram bucket N counts durations of 2^(N + ISRPROF_BUCKET_SHIFT) cycles and up
+// the first bucket also counts anything shorter
+#define ISRPROF_BUCKETS 12
+#define ISRPROF_BUCKET_SHIFT 8
+
+typedef struct {
+    uint32_t count;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint32_t maxSinceTimerCycles; // Latest exit after the last timer event
+    uint32_t histogram[ISRPROF_BUCKETS];
+} isrProfileStats_t;
+
+class ISRProfile
+{
+public:
+    static inline uint32_t ICACHE_RAM_ATTR now()
+    {
+#if defined(PLATFORM_ESP8266) || defined(PLATFORM_ESP32)
+        return ESP.getCycleCount();
+#else
+        return micros();
+#endif
+    }
+
+    // Cycle counter ticks per microsecond, for converting the snapshot
+    static uint32_t cyclesPerUs();
+
+    static inline void ICACHE_RAM_ATTR timerEvent(uint32_t start)
+    {
+        lastTimerEvent = start;
+    }
+
+    static inline void ICACHE_RAM_ATTR record(isrProfileId_e id, uint32_t start)
+    {
+        uint32_t const end = now();
+        uint32_t const cycles = end - start;
+        uint32_t const sinceTimer = end - lastTimerEvent;
+        isrProfileStats_t &s = stats[id];
+
+        if (s.count == 0 || cycles < s.minCycles)
+            s.minCycles = cycles;
+        ++s.count;
+        if (cycles > s.maxCycles)
+            s.maxCycles = cycles;
+        if (sinceTimer > s.maxSinceTimerCycles)
+            s.maxSinceTimerCycles = sinceTimer;
+        ++s.histogram[bucket(cycles)];
+    }
+
+    static inline uint8_t bucket(uint32_t cycles)
+    {
+        uint32_t const v = cycles >> ISRPROF_BUCKET_SHIFT;
+        if (v == 0)
+            return 0;
+        uint8_t const b = 32 - __builtin_clz(v);
+        return (b < ISRPROF_BUCKETS) ? b : ISRPROF_BUCKETS - 1;
+    }
+
+    // Copy the stats of all the ISRs out with interrupts disabled
+    static void snapshot(isrProfileStats_t *dest);
+    static void reset();
+
+private:
+    static volatile uint32_t lastTimerEvent;
+    static isrProfileStats_t stats[ISRPROF_COUNT];
+};
+
+/**
+ * Records the time from its construction to the end of the scope, so functions
+ * with several return paths only need a single ISR_PROFILE() at the top
+ */
+class ISRProfileScope
+{
+public:
+    inline ICACHE_RAM_ATTR ISRProfileScope(isrProfileId_e id, bool isTimer) : id(id), start(ISRProfile::now())
+    {
+        if (isTimer)
+            ISRProfile::timerEvent(start);
+    }
+    inline ICACHE_RAM_ATTR ~ISRProfileScope() { ISRProfile::record(id, start); }
+
+private:
+    isrProfileId_e const id;
+    uint32_t const start;
+};
+
+#if defined(DEBUG_ISR_PROFILE)
+#define ISR_PROFILE(id) ISRProfileScope isrProfileScope((id), false)
+#define ISR_PROFILE_TIMER(id) ISRProfileScope isrProfileScope((id), true)
+#else
+#define ISR_PROFILE(id)
+#define ISR_PROFILE_TIMER(id)
+#endif
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <stdint.h>
+
+// Largest FHSS channel count of any domain (ISM2G4)
+#define LQSTATS_MAX_CHANNELS 80
+// Loss run lengths 1, 2, 3-4, 5-8, 9-16, 17-32, 33-64, 65+
+#define LQSTATS_BURST_BUCKETS 8
+
+enum lqStatsWindow_e {
+    LQSTATS_WINDOW_10 = 0,
+    LQSTATS_WINDOW_100,
+    LQSTATS_WINDOW_1000,
+    LQSTATS_WINDOW_COUNT
+};
+
+/**
+ * Long term link quality statistics, fed once per packet period next to an
+ * LQCALC. Keeps the LQ over 10, 100 and 1000 periods, a histogram of the
+ * length of consecutive loss runs and the loss rate of each FHSS channel.
+ * Everything is updated in O(1) per inc()
+ */
+class LQSTATS
+{
+public:
+    LQSTATS(void)
+    {
+        reset();
+    }
+
+    /**
+     * @brief End the current period and start a new one
+     * @param received true if the period that just ended got its packet
+     * @param nextChannel the FHSS channel (not sequence index) of the new period
+     */
+    void ICACHE_RAM_ATTR inc(bool received, uint8_t nextChannel)
+    {
+        // Add the result to the history, and remove the result
+        // falling out of the end of each window from its count
+        for (unsigned w = 0; w < LQSTATS_WINDOW_COUNT; ++w)
+        {
+            windowCount[w] += received;
+            if (count >= windowSize(w))
+                windowCount[w] -= historyBit(index + HISTORY_BITS - windowSize(w));
+        }
+        if (received)
+            history[index / 32] |= 1U << (index % 32);
+        else
+            history[index / 32] &= ~(1U << (index % 32));
+        index = (index + 1) % HISTORY_BITS;
+        if (count < windowSize(LQSTATS_WINDOW_1000))
+            ++count;
+
+        // Loss run lengths
+        if (!received)
+        {
+            if (lossRun < UINT16_MAX)
+                ++lossRun;
+        }
+        else if (lossRun)
+        {
+            endLossRun();
+        }
+
+        // Per-channel loss, halve the counts as they fill up so old data ages out
+        if (channel < LQSTATS_MAX_CHANNELS)
+        {
+            if (channelTotal[channel] == UINT16_MAX)
+            {
+                channelTotal[channel] /= 2;
+                channelLost[channel] /= 2;
+            }
+            ++channelTotal[channel];
+            channelLost[channel] += !received;
+        }
+        channel = nextChannel;
+    }
+
+    /* Return the LQ over the window, in percent */
+    uint8_t getLQ(lqStatsWindow_e window) const
+    {
+        uint16_t const periods = (count < windowSize(window)) ? count : windowSize(window);
+        if (periods == 0)
+            return 100;
+        return (uint32_t)windowCount[window] * 100U / periods;
+    }
+
+    /* Return the number of loss runs of the length range of bucket */
+    uint32_t getBurstCount(uint8_t bucket) const
+    {
+        return burstHistogram[bucket];
+    }
+
+    /* Return the longest run of lost packets */
+    uint16_t getMaxBurst() const
+    {
+        return maxBurst;
+    }
+
+    /* Return the loss rate of the FHSS channel in percent, or 0 if no data */
+    uint8_t getChannelLoss(uint8_t ch) const
+    {
+        if (ch >= LQSTATS_MAX_CHANNELS || channelTotal[ch] == 0)
+            return 0;
+        return (uint32_t)channelLost[ch] * 100U / channelTotal[ch];
+    }
+
+    /* Return the number of periods recorded on the FHSS channel */
+    uint16_t getChannelPeriods(uint8_t ch) const
+    {
+        return (ch < LQSTATS_MAX_CHANNELS) ? channelTotal[ch] : 0;
+    }
+
+    /* Forget the loss history of a single FHSS channel */
+    void resetChannel(uint8_t ch)
+    {
+        if (ch < LQSTATS_MAX_CHANNELS)
+        {
+            channelTotal[ch] = 0;
+            channelLost[ch] = 0;
+        }
+    }
+
+    /* Zero all the statistics */
+    void reset()
+    {
+        index = 0;
+        count = 0;
+        lossRun = 0;
+        maxBurst = 0;
+        channel = UINT8_MAX;
+        for (unsigned i = 0; i < sizeof(history) / sizeof(history[0]); ++i)
+            history[i] = 0;
+        for (unsigned w = 0; w < LQSTATS_WINDOW_COUNT; ++w)
+            windowCount[w] = 0;
+        for (unsigned i = 0; i < LQSTATS_BURST_BUCKETS; ++i)
+            burstHistogram[i] = 0;
+        for (unsigned i = 0; i < LQSTATS_MAX_CHANNELS; ++i)
+        {
+            channelTotal[i] = 0;
+            channelLost[i] = 0;
+        }
+    }
+
+    /* Return the histogram bucket a loss run of the given length is counted in */
+    static uint8_t burstBucket(uint16_t run)
+    {
+        if (run <= 1)
+            return 0;
+        uint8_t const bucket = 32 - __builtin_clz(run - 1);
+        return (bucket < LQSTATS_BURST_BUCKETS) ? bucket : LQSTATS_BURST_BUCKETS - 1;
+    }
+
+private:
+    // Must be at least the largest window
+    static const uint16_t HISTORY_BITS = 1024;
+
+    static uint16_t windowSize(unsigned window)
+    {
+        return (window == LQSTATS_WINDOW_10) ? 10 : (window == LQSTATS_WINDOW_100) ? 100 : 1000;
+    }
+
+    uint8_t historyBit(uint16_t idx) const
+    {
+        idx %= HISTORY_BITS;
+        return (history[idx / 32] >> (idx % 32)) & 1;
+    }
+
+    void endLossRun()
+    {
+        ++burstHistogram[burstBucket(lossRun)];
+        if (lossRun > maxBurst)
+            maxBurst = lossRun;
+        lossRun = 0;
+    }
+
+    uint16_t index; // position of the current period in history
+    uint16_t count; // number of periods in history, up to the largest window
+    uint32_t history[HISTORY_BITS / 32];
+    uint16_t windowCount[LQSTATS_WINDOW_COUNT];
+    uint16_t lossRun;
+    uint16_t maxBurst;
+    uint32_t burstHistogram[LQSTATS_BURST_BUCKETS];
+    uint8_t channel; // FHSS channel of the current period
+    uint16_t channelTotal[LQSTATS_MAX_CHANNELS];
+    uint16_t channelLost[LQSTATS_MAX_CHANNELS];
+};
+
+// Statistics of the link in the direction this device receives, fed with the LQCalc periods
+extern LQSTATS LQStats;
@@ -563,21 +563,19 @@ void ICACHE_RAM_ATTR LR1121Driver::TXnbISR()
 
 void ICACHE_RAM_ATTR LR1121Driver::TXnb(uint8_t * data, uint8_t size, bool sendGeminiBuffer, uint8_t * dataGemini, SX12XX_Radio_Number_t radioNumber)
 {
-    transmittingRadio = radioNumber;
+    // Everything from here to the TX is queued and sent back to back
+    hal.BeginBatch();
+    TXnbLoad(data, size, sendGeminiBuffer, dataGemini, radioNumber);
+    TXnbStart();
+    hal.EndBatch();
+}
 
-    // //catch TX timeout
-    // if (currOpmode == SX1280_MODE_TX)
-    // {
-    //     DBGLN("Timeout!");
-    //     SetMode(SX1280_MODE_FS, SX12XX_Radio_All);
-    //     ClearIrqStatus(SX1280_IRQ_RADIO_ALL, SX12XX_Radio_All);
-    //     TXnbISR();
-    //     return;
-    // }
+void ICACHE_RAM_ATTR LR1121Driver::TXnbLoad(uint8_t * data, uint8_t size, bool sendGeminiBuffer, uint8_t * dataGemini, SX12XX_Radio_Number_t radioNumber)
+{
+    transmittingRadio = radioNumber;
 
     if (radioNumber == SX12XX_Radio_NONE)
     {
-        SetMode(fallBackMode, SX12XX_Radio_All);
         return;
     }
 
@@ -639,8 +637,27 @@ void ICACHE_RAM_ATTR LR1121Driver::TXnb(uint8_t * data, uint8_t size, bool sendG
             hal.WriteCommand(LR11XX_REGMEM_WRITE_BUFFER8_OC, data, size, radioNumber);
         }
     }
+}
 
-    SetMode(LR1121_MODE_TX, radioNumber);
+void ICACHE_RAM_ATTR LR1121Driver::TXnbStart()
+{
+    // //catch TX timeout
+    // if (currOpmode == SX1280_MODE_TX)
+    // {
+    //     DBGLN("Timeout!");
+    //     SetMode(SX1280_MODE_FS, SX12XX_Radio_All);
+    //     ClearIrqStatus(SX1280_IRQ_RADIO_ALL, SX12XX_Radio_All);
+    //     TXnbISR();
+    //     return;
+    // }
+
+    if (transmittingRadio == SX12XX_Radio_NONE)
+    {
+        SetMode(fallBackMode, SX12XX_Radio_All);
+        return;
+    }
+
+    SetMode(LR1121_MODE_TX, transmittingRadio);
 
 #ifdef DEBUG_LLCC68_OTA_TIMING
     beginTX = micros();
@@ -697,6 +714,18 @@ int8_t ICACHE_RAM_ATTR LR1121Driver::GetRssiInst(SX12XX_Radio_Number_t radioNumb
     return -(int8_t)(status[1] / 2);
 }
 
+// 8.3.7 GetPacketStatus (LoRa)
+int8_t ICACHE_RAM_ATTR LR1121Driver::GetLastPacketSNRRaw(SX12XX_Radio_Number_t radioNumber)
+{
+    if (useFSK)
+        return 0;
+
+    uint8_t status[3] = {0};
+    hal.WriteCommand(LR11XX_RADIO_GET_PKT_STATUS_OC, radioNumber);
+    hal.ReadCommand(status, sizeof(status), radioNumber);
+    return (int8_t)status[2];
+}
+
 void ICACHE_RAM_ATTR LR1121Driver::CheckForSecondPacket()
 {
     SX12XX_Radio_Number_t radio[2] = {SX12XX_Radio_1, SX12XX_Radio_2};
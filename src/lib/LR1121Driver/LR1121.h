@@ -41,12 +41,19 @@ public:
     bool FrequencyErrorAvailable() const { return false; }
 
     void TXnb(uint8_t * data, uint8_t size, bool sendGeminiBuffer, uint8_t * dataGemini, SX12XX_Radio_Number_t radioNumber);
+    // TXnb() in two halves: write the packet to the radio while it is idle, then start the TX later
+    void TXnbLoad(uint8_t * data, uint8_t size, bool sendGeminiBuffer, uint8_t * dataGemini, SX12XX_Radio_Number_t radioNumber);
+    // The LR1121 switches its RF path itself (SetDioAsRfSwitch), there is no PA to enable ahead of TXnbStart()
+    void TXnbEnablePA() {}
+    void TXnbStart();
     void RXnb(lr11xx_RadioOperatingModes_t rxMode = LR1121_MODE_RX);
 
     uint32_t GetIrqStatus(SX12XX_Radio_Number_t radioNumber);
     void ClearIrqStatus(SX12XX_Radio_Number_t radioNumber);
 
     int8_t GetRssiInst(SX12XX_Radio_Number_t radioNumber);
+    // SNR of the packet just received by one radio, without updating the LastPacket stats
+    int8_t GetLastPacketSNRRaw(SX12XX_Radio_Number_t radioNumber);
     void GetLastPacketStats();
     void CheckForSecondPacket();
 
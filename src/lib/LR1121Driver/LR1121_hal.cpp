@@ -7,7 +7,7 @@
 
 LR1121Hal *LR1121Hal::instance = NULL;
 
-LR1121Hal::LR1121Hal()
+LR1121Hal::LR1121Hal() : batching(false)
 {
     instance = this;
 }
@@ -129,8 +129,7 @@ void ICACHE_RAM_ATTR LR1121Hal::WriteCommand(uint16_t command, uint8_t *buffer,
 
     memcpy(OutBuffer + 2, buffer, size);
 
-    WaitOnBusy(radioNumber);
-    SPIEx.write(radioNumber, OutBuffer, size + 2);
+    Write(OutBuffer, size + 2, radioNumber);
 }
 
 void ICACHE_RAM_ATTR LR1121Hal::WriteCommand(uint16_t command, SX12XX_Radio_Number_t radioNumber)
@@ -140,8 +139,7 @@ void ICACHE_RAM_ATTR LR1121Hal::WriteCommand(uint16_t command, SX12XX_Radio_Numb
         (uint8_t)(command & 0x00FF)
     };
 
-    WaitOnBusy(radioNumber);
-    SPIEx.write(radioNumber, OutBuffer, 2);
+    Write(OutBuffer, 2, radioNumber);
 }
 
 void ICACHE_RAM_ATTR LR1121Hal::ReadCommand(uint8_t *buffer, uint8_t size, SX12XX_Radio_Number_t radioNumber)
@@ -150,12 +148,49 @@ void ICACHE_RAM_ATTR LR1121Hal::ReadCommand(uint8_t *buffer, uint8_t size, SX12X
 
     memcpy(InBuffer, buffer, size);
 
+    FlushBatch();
     WaitOnBusy(radioNumber);
     SPIEx.read(radioNumber, InBuffer, size);
 
     memcpy(buffer, InBuffer, size);
 }
 
+void ICACHE_RAM_ATTR LR1121Hal::Write(uint8_t *data, uint8_t size, SX12XX_Radio_Number_t radioNumber)
+{
+    if (batching)
+    {
+        if (batch.add(radioNumber, data, size))
+        {
+            return;
+        }
+        // Full, what is queued has to go first to keep the order
+        FlushBatch();
+    }
+
+    WaitOnBusy(radioNumber);
+    SPIEx.write(radioNumber, data, size);
+}
+
+void ICACHE_RAM_ATTR LR1121Hal::BatchBus::write(uint8_t csMask, uint8_t *data, uint32_t size)
+{
+    SPIEx.write(csMask, data, size);
+}
+
+void ICACHE_RAM_ATTR LR1121Hal::FlushBatch()
+{
+    if (!batch.empty())
+    {
+        BatchBus bus = {*this};
+        batch.run(bus);
+    }
+}
+
+void ICACHE_RAM_ATTR LR1121Hal::EndBatch()
+{
+    FlushBatch();
+    batching = false;
+}
+
 bool ICACHE_RAM_ATTR LR1121Hal::WaitOnBusy(SX12XX_Radio_Number_t radioNumber)
 {
     constexpr uint32_t wtimeoutUS = 1000U;
@@ -2,6 +2,7 @@
 
 #include "LR1121_Regs.h"
 #include "LR1121.h"
+#include "SPIQueue.h"
 
 class LR1121Hal
 {
@@ -21,11 +22,26 @@ public:
 
     bool ICACHE_RAM_ATTR WaitOnBusy(SX12XX_Radio_Number_t radioNumber);
 
+    // Writes between BeginBatch() and EndBatch() are queued and sent together, reads send what is queued first
+    void BeginBatch() { batching = true; }
+    void ICACHE_RAM_ATTR EndBatch();
+
     static ICACHE_RAM_ATTR void dioISR_1();
     static ICACHE_RAM_ATTR void dioISR_2();
     void (*IsrCallback_1)();
     void (*IsrCallback_2)();
 
 private:
-
+    struct BatchBus {
+        LR1121Hal &hal;
+        void waitBusy(uint8_t csMask) { hal.WaitOnBusy(csMask); }
+        void write(uint8_t csMask, uint8_t *data, uint32_t size);
+        void busyFor(uint8_t csMask, uint32_t us) {}
+    };
+
+    SPIQueue batch;
+    bool batching;
+
+    void ICACHE_RAM_ATTR Write(uint8_t *data, uint8_t size, SX12XX_Radio_Number_t radioNumber);
+    void ICACHE_RAM_ATTR FlushBatch();
 };
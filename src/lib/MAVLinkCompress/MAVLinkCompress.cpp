@@ -0,0 +1,536 @@
+#include "MAVLinkCompress.h"
+#include <algorithm>
+#include <string.h>
+
+#define MAVC_TYPE_MASK  0xC0
+#define MAVC_RAW        0x00
+#define MAVC_FULL       0x40
+#define MAVC_DELTA      0x80
+#define MAVC_CTRL       0xC0
+#define MAVC_CTRL_RESET MAVC_CTRL
+#define MAVC_RAW_MAX    0x3F
+#define MAVC_SEQ        0x20
+#define MAVC_SLOT_SHIFT 3
+#define MAVC_SLOT_MASK  0x03
+#define MAVC_IDX_MASK   0x07
+
+// The stream messages of a typical autopilot. The CRC is checked with crcExtra before
+// it is stripped, so a frame that doesn't match its entry is just sent raw
+static const mavlinkCompressMsg_t msgTable[MAVLINK_COMPRESS_OTHER] = {
+    {0, 50, 9},     // HEARTBEAT
+    {1, 124, 31},   // SYS_STATUS
+    {24, 24, 30},   // GPS_RAW_INT
+    {30, 39, 28},   // ATTITUDE
+    {33, 104, 28},  // GLOBAL_POSITION_INT
+    {65, 118, 42},  // RC_CHANNELS
+    {74, 20, 20},   // VFR_HUD
+};
+
+static inline uint16_t crcAccumulate(uint8_t data, uint16_t crc)
+{
+    // CRC-16/MCRF4XX as used by MAVLink
+    data ^= (uint8_t)(crc & 0xff);
+    data ^= (uint8_t)(data << 4);
+    return (crc >> 8) ^ ((uint16_t)data << 8) ^ ((uint16_t)data << 3) ^ (data >> 4);
+}
+
+static inline uint32_t frameMsgId(const uint8_t *frame)
+{
+    return frame[7] | (frame[8] << 8) | ((uint32_t)frame[9] << 16);
+}
+
+/***
+ * @brief: CRC of a v2 frame, from the len byte to the end of the payload plus crcExtra
+ ***/
+uint16_t MAVLinkCompressContext::crc(const uint8_t *frame, uint8_t crcExtra)
+{
+    uint16_t crc = 0xffff;
+    for (unsigned i = 1; i < MAVLINK_COMPRESS_HEADER_LEN + frame[1]; ++i)
+        crc = crcAccumulate(frame[i], crc);
+    return crcAccumulate(crcExtra, crc);
+}
+
+uint8_t MAVLinkCompressContext::msgIndex(uint32_t msgid)
+{
+    for (uint8_t idx = 0; idx < MAVLINK_COMPRESS_OTHER; ++idx)
+    {
+        if (msgTable[idx].msgid == msgid)
+            return idx;
+    }
+    return MAVLINK_COMPRESS_OTHER;
+}
+
+void MAVLinkCompressContext::resetContext()
+{
+    memset(sources, 0, sizeof(sources));
+    memset(refs, 0, sizeof(refs));
+    nextSource = 0;
+}
+
+void MAVLinkCompressContext::defineSource(uint8_t slot, uint8_t sysid, uint8_t compid)
+{
+    sources[slot].sysid = sysid;
+    sources[slot].compid = compid;
+    sources[slot].valid = true;
+    nextSource = (slot + 1) % MAVLINK_COMPRESS_SOURCES;
+    // The references were from the slot's previous source
+    for (unsigned i = 0; i < MAVLINK_COMPRESS_OTHER; ++i)
+    {
+        if (refs[i].source == slot)
+            refs[i].valid = false;
+    }
+}
+
+void MAVLinkCompressContext::updateRef(uint8_t idx, uint8_t slot, const uint8_t *payload, uint8_t len)
+{
+    if (idx == MAVLINK_COMPRESS_OTHER)
+        return;
+
+    deltaRef_t &ref = refs[idx];
+    ref.valid = len <= msgTable[idx].deltaLen;
+    if (ref.valid)
+    {
+        // Truncated v2 payloads end in zeros
+        memcpy(ref.payload, payload, len);
+        memset(&ref.payload[len], 0, sizeof(ref.payload) - len);
+        ref.source = slot;
+    }
+}
+
+const MAVLinkCompressContext::deltaRef_t *MAVLinkCompressContext::getRef(uint8_t idx, uint8_t slot, uint8_t len) const
+{
+    if (idx == MAVLINK_COMPRESS_OTHER || len > msgTable[idx].deltaLen)
+        return nullptr;
+    const deltaRef_t *ref = &refs[idx];
+    return (ref->valid && ref->source == slot) ? ref : nullptr;
+}
+
+void MAVLinkCompressor::reset()
+{
+    resetContext();
+    framePos = 0;
+    state = COLLECT;
+    payloadSeq = 0;
+    sinceReset = 0;
+    resetPending = true;
+}
+
+/***
+ * @brief: Take bytes into frame[] until a frame or a run of non-frame bytes is complete
+ * @returns: number of bytes taken
+ ***/
+uint16_t MAVLinkCompressor::collect(const uint8_t *in, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; ++i)
+    {
+        uint8_t const c = in[i];
+        if (framePos != 0 && frame[0] != MAVLINK_COMPRESS_STX)
+        {
+            // A run of bytes outside a v2 frame ends at the next STX
+            if (c == MAVLINK_COMPRESS_STX)
+            {
+                startRaw(framePos);
+                return i;
+            }
+            frame[framePos++] = c;
+            if (framePos == MAVC_RAW_MAX)
+            {
+                startRaw(framePos);
+                return i + 1;
+            }
+            continue;
+        }
+
+        frame[framePos++] = c;
+        if (framePos == MAVLINK_COMPRESS_HEADER_LEN)
+        {
+            // Signed frames (incompat flag 1) carry a 13 byte signature
+            frameLen = MAVLINK_COMPRESS_HEADER_LEN + frame[1] + 2 + ((frame[2] & 1) ? 13 : 0);
+        }
+        if (framePos >= MAVLINK_COMPRESS_HEADER_LEN && framePos == frameLen)
+        {
+            finishFrame();
+            return i + 1;
+        }
+    }
+    return len;
+}
+
+void MAVLinkCompressor::finishFrame()
+{
+    // Frames with any flags are not rebuilt, the far side would not get them back
+    if (frame[2] != 0 || frame[3] != 0)
+    {
+        startRaw(frameLen);
+        return;
+    }
+
+    frameIdx = msgIndex(frameMsgId(frame));
+    if (frameIdx != MAVLINK_COMPRESS_OTHER)
+    {
+        uint8_t const len = frame[1];
+        uint16_t const frameCrc = frame[MAVLINK_COMPRESS_HEADER_LEN + len] | (frame[MAVLINK_COMPRESS_HEADER_LEN + len + 1] << 8);
+        if (crc(frame, msgTable[frameIdx].crcExtra) != frameCrc)
+        {
+            startRaw(frameLen);
+            return;
+        }
+    }
+    state = READY;
+}
+
+void MAVLinkCompressor::startRaw(uint16_t len)
+{
+    frameLen = len;
+    rawPos = 0;
+    state = RAW;
+}
+
+/***
+ * @brief: Encode the frame in frame[] without changing the context
+ * @returns: length of the record(s) written to rec
+ ***/
+uint16_t MAVLinkCompressor::encodeFrame(uint8_t *rec) const
+{
+    uint8_t const len = frame[1];
+    uint8_t const seq = frame[4];
+    uint8_t const sysid = frame[5];
+    uint8_t const compid = frame[6];
+    uint8_t const *payload = &frame[MAVLINK_COMPRESS_HEADER_LEN];
+    uint16_t n = 0;
+
+    int slot = -1;
+    for (unsigned i = 0; i < MAVLINK_COMPRESS_SOURCES; ++i)
+    {
+        if (sources[i].valid && sources[i].sysid == sysid && sources[i].compid == compid)
+            slot = i;
+    }
+    bool const newSource = slot < 0;
+    if (newSource)
+    {
+        slot = nextSource;
+        rec[n++] = MAVC_CTRL | (slot + 1);
+        rec[n++] = sysid;
+        rec[n++] = compid;
+    }
+
+    uint16_t const hdrPos = n++;
+    uint8_t hdr = (slot << MAVC_SLOT_SHIFT) | frameIdx;
+    if (newSource || seq != (uint8_t)(sources[slot].seq + 1))
+    {
+        hdr |= MAVC_SEQ;
+        rec[n++] = seq;
+    }
+
+    if (frameIdx == MAVLINK_COMPRESS_OTHER)
+    {
+        rec[hdrPos] = MAVC_FULL | hdr;
+        memcpy(&rec[n], &frame[7], 3);
+        n += 3;
+        rec[n++] = len;
+        memcpy(&rec[n], payload, len + 2);
+        return n + len + 2;
+    }
+
+    const deltaRef_t *ref = newSource ? nullptr : getRef(frameIdx, slot, len);
+    if (ref)
+    {
+        uint16_t d = n;
+        rec[d++] = len;
+        uint8_t * const bitmap = &rec[d];
+        uint8_t const bitmapLen = (len + 7) / 8;
+        memset(bitmap, 0, bitmapLen);
+        d += bitmapLen;
+        for (unsigned i = 0; i < len; ++i)
+        {
+            if (payload[i] != ref->payload[i])
+            {
+                bitmap[i / 8] |= 1 << (i % 8);
+                rec[d++] = payload[i];
+            }
+        }
+        // len + payload is what the full record costs
+        if (d - n < 1 + len)
+        {
+            rec[hdrPos] = MAVC_DELTA | hdr;
+            return d;
+        }
+    }
+
+    rec[hdrPos] = MAVC_FULL | hdr;
+    rec[n++] = len;
+    memcpy(&rec[n], payload, len);
+    return n + len;
+}
+
+void MAVLinkCompressor::commitFrame()
+{
+    uint8_t const sysid = frame[5];
+    uint8_t const compid = frame[6];
+    int slot = -1;
+    for (unsigned i = 0; i < MAVLINK_COMPRESS_SOURCES; ++i)
+    {
+        if (sources[i].valid && sources[i].sysid == sysid && sources[i].compid == compid)
+            slot = i;
+    }
+    if (slot < 0)
+    {
+        slot = nextSource;
+        defineSource(slot, sysid, compid);
+    }
+    sources[slot].seq = frame[4];
+    updateRef(frameIdx, slot, &frame[MAVLINK_COMPRESS_HEADER_LEN], frame[1]);
+}
+
+bool MAVLinkCompressor::emitFrame(uint8_t *out, uint8_t &n, uint8_t maxLen)
+{
+    // Big enough for a new source and a full record of the largest payload
+    uint8_t rec[3 + 2 + 3 + 1 + 255 + 2];
+    uint16_t const len = encodeFrame(rec);
+    // Too big for any payload, it can go as raw bytes split over several
+    if (len > maxLen - 2)
+    {
+        startRaw(frameLen);
+        return true;
+    }
+    if (n + len > maxLen)
+        return false;
+
+    memcpy(&out[n], rec, len);
+    n += len;
+    commitFrame();
+    framePos = 0;
+    state = COLLECT;
+    return true;
+}
+
+bool MAVLinkCompressor::emitRaw(uint8_t *out, uint8_t &n, uint8_t maxLen)
+{
+    if (maxLen - n < 2)
+        return false;
+
+    uint16_t const count = std::min({(uint16_t)(frameLen - rawPos), (uint16_t)(maxLen - n - 1), (uint16_t)MAVC_RAW_MAX});
+    out[n++] = MAVC_RAW | count;
+    memcpy(&out[n], &frame[rawPos], count);
+    n += count;
+    rawPos += count;
+    if (rawPos == frameLen)
+    {
+        framePos = 0;
+        state = COLLECT;
+    }
+    return true;
+}
+
+uint8_t MAVLinkCompressor::compress(const uint8_t *in, uint16_t inLen, uint16_t *consumed, uint8_t *out, uint8_t maxLen)
+{
+    *consumed = 0;
+    if (maxLen < 4)
+        return 0;
+
+    // The context stays reset until a payload carrying the reset is returned
+    bool const sendReset = resetPending || sinceReset >= MAVLINK_COMPRESS_RESET_INTERVAL;
+    if (sendReset)
+    {
+        resetContext();
+        resetPending = true;
+    }
+
+    uint8_t n = 0;
+    out[n++] = payloadSeq;
+    if (sendReset)
+        out[n++] = MAVC_CTRL_RESET;
+    uint8_t const headerLen = n;
+
+    for (;;)
+    {
+        if (state == READY)
+        {
+            if (!emitFrame(out, n, maxLen))
+                break;
+        }
+        else if (state == RAW)
+        {
+            if (!emitRaw(out, n, maxLen))
+                break;
+        }
+        else if (*consumed < inLen)
+        {
+            *consumed += collect(&in[*consumed], inLen - *consumed);
+        }
+        else if (framePos != 0 && frame[0] != MAVLINK_COMPRESS_STX)
+        {
+            // Out of input, send the run of non-frame bytes. A partial frame waits for the rest
+            startRaw(framePos);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (n == headerLen)
+        return 0;
+
+    resetPending = false;
+    sinceReset = sendReset ? 1 : sinceReset + 1;
+    ++payloadSeq;
+    return n;
+}
+
+void MAVLinkDecompressor::reset()
+{
+    resetContext();
+    expectedSeq = 0;
+    synced = false;
+}
+
+uint16_t MAVLinkDecompressor::decompress(const uint8_t *in, uint8_t len, uint8_t *out, uint16_t maxLen)
+{
+    if (len == 0)
+        return 0;
+
+    uint8_t pos = 0;
+    uint16_t n = 0;
+    uint8_t const payloadSeq = in[pos++];
+    if (pos < len && in[pos] == MAVC_CTRL_RESET)
+    {
+        resetContext();
+        synced = true;
+        ++pos;
+    }
+    else if (payloadSeq != expectedSeq)
+    {
+        synced = false;
+    }
+    expectedSeq = payloadSeq + 1;
+
+    while (pos < len)
+    {
+        uint8_t const hdr = in[pos++];
+        uint8_t const type = hdr & MAVC_TYPE_MASK;
+
+        if (type == MAVC_RAW)
+        {
+            // Raw bytes need no context
+            uint8_t const count = hdr & MAVC_RAW_MAX;
+            if (pos + count > len)
+                break;
+            if (n + count <= maxLen)
+            {
+                memcpy(&out[n], &in[pos], count);
+                n += count;
+            }
+            pos += count;
+            continue;
+        }
+
+        if (type == MAVC_CTRL)
+        {
+            uint8_t const slot = (hdr & MAVC_RAW_MAX) - 1;
+            if (slot >= MAVLINK_COMPRESS_SOURCES || pos + 2 > len)
+                break;
+            if (synced)
+                defineSource(slot, in[pos], in[pos + 1]);
+            pos += 2;
+            continue;
+        }
+
+        uint8_t const slot = (hdr >> MAVC_SLOT_SHIFT) & MAVC_SLOT_MASK;
+        uint8_t const idx = hdr & MAVC_IDX_MASK;
+        uint8_t seq = sources[slot].seq + 1;
+        if (hdr & MAVC_SEQ)
+        {
+            if (pos >= len)
+                break;
+            seq = in[pos++];
+        }
+
+        uint8_t frame[MAVLINK_COMPRESS_MAX_FRAME];
+        uint32_t msgid;
+        if (idx == MAVLINK_COMPRESS_OTHER)
+        {
+            if (type != MAVC_FULL || pos + 4 > len)
+                break;
+            msgid = in[pos] | (in[pos + 1] << 8) | ((uint32_t)in[pos + 2] << 16);
+            pos += 3;
+        }
+        else
+        {
+            if (pos >= len)
+                break;
+            msgid = msgTable[idx].msgid;
+        }
+
+        uint8_t const payloadLen = in[pos++];
+        uint8_t * const payload = &frame[MAVLINK_COMPRESS_HEADER_LEN];
+        bool valid = synced && sources[slot].valid;
+        if (type == MAVC_DELTA)
+        {
+            uint8_t const bitmapLen = (payloadLen + 7) / 8;
+            if (pos + bitmapLen > len)
+                break;
+            const uint8_t *bitmap = &in[pos];
+            pos += bitmapLen;
+            const deltaRef_t *ref = getRef(idx, slot, payloadLen);
+            valid = valid && ref;
+            for (unsigned i = 0; i < payloadLen; ++i)
+            {
+                if (bitmap[i / 8] & (1 << (i % 8)))
+                {
+                    if (pos >= len)
+                        return n;
+                    payload[i] = in[pos++];
+                }
+                else
+                {
+                    payload[i] = ref ? ref->payload[i] : 0;
+                }
+            }
+        }
+        else
+        {
+            uint8_t const crcLen = (idx == MAVLINK_COMPRESS_OTHER) ? 2 : 0;
+            if (pos + payloadLen + crcLen > len)
+                break;
+            memcpy(payload, &in[pos], payloadLen + crcLen);
+            pos += payloadLen + crcLen;
+        }
+
+        // Without the context the frame can't be rebuilt, drop it until the next reset
+        if (!valid)
+        {
+            synced = false;
+            continue;
+        }
+
+        frame[0] = MAVLINK_COMPRESS_STX;
+        frame[1] = payloadLen;
+        frame[2] = 0;
+        frame[3] = 0;
+        frame[4] = seq;
+        frame[5] = sources[slot].sysid;
+        frame[6] = sources[slot].compid;
+        frame[7] = msgid;
+        frame[8] = msgid >> 8;
+        frame[9] = msgid >> 16;
+        if (idx != MAVLINK_COMPRESS_OTHER)
+        {
+            uint16_t const frameCrc = crc(frame, msgTable[idx].crcExtra);
+            payload[payloadLen] = frameCrc;
+            payload[payloadLen + 1] = frameCrc >> 8;
+        }
+
+        sources[slot].seq = seq;
+        updateRef(idx, slot, payload, payloadLen);
+
+        uint16_t const frameLen = MAVLINK_COMPRESS_HEADER_LEN + payloadLen + 2;
+        if (n + frameLen <= maxLen)
+        {
+            memcpy(&out[n], frame, frameLen);
+            n += frameLen;
+        }
+    }
+
+    return n;
+}
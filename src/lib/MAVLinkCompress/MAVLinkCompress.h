@@ -0,0 +1,137 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Link-local compression of the MAVLink stream tunnelled over the stubborn links
+ *
+ * The compressor splits the serial byte stream into MAVLink v2 frames and replaces
+ * each frame's STX, flags, seq, sysid/compid and, for the messages in its table,
+ * the CRC with a one byte record header. The table messages, the high rate
+ * ATTITUDE, GLOBAL_POSITION_INT and RC_CHANNELS among them, are sent as the bytes
+ * that changed since the last instance. The decompressor rebuilds the identical frames, checksums
+ * included. Anything that isn't an unsigned v2 frame, or fails its CRC, is passed
+ * through as raw bytes so the far side sees the same byte stream.
+ *
+ * Each payload starts with a sequence number. The encoder resets both contexts
+ * every MAVLINK_COMPRESS_RESET_INTERVAL payloads, and a decompressor that misses
+ * a payload drops the frames it can't rebuild until the next reset, rather than
+ * building frames with a valid CRC from a stale context.
+ *
+ * Payload: [seq] [CTRL reset]? record...
+ *  RAW    00nnnnnn: n bytes of the stream follow
+ *  CTRL   11000000: context reset, only directly after seq
+ *         110000ss + sysid + compid: (ss+1) defines source slot ss
+ *  FULL   01qssiii: [seq if q] then for table message iii: len payload,
+ *         for iii = 7: msgid(3) len payload crc(2)
+ *  DELTA  10qssiii: [seq if q] len bitmap(len/8 rounded up) changed bytes
+ * The seq of a frame without q is the previous seq of its source + 1
+ */
+
+#define MAVLINK_COMPRESS_STX            0xFD
+#define MAVLINK_COMPRESS_HEADER_LEN     10
+#define MAVLINK_COMPRESS_MAX_FRAME      (MAVLINK_COMPRESS_HEADER_LEN + 255 + 2 + 13)
+// Frames rebuilt per payload byte at most, for sizing the decompress buffer
+#define MAVLINK_COMPRESS_MAX_EXPANSION  7
+#define MAVLINK_COMPRESS_RESET_INTERVAL 32
+#define MAVLINK_COMPRESS_SOURCES        4
+#define MAVLINK_COMPRESS_DELTA_MAX      42
+// Table index of the messages not in the table, and the number of table messages
+#define MAVLINK_COMPRESS_OTHER          7
+
+typedef struct {
+    uint8_t msgid;
+    uint8_t crcExtra;
+    uint8_t deltaLen;   // largest payload delta encoded, longer ones are sent in full
+} mavlinkCompressMsg_t;
+
+class MAVLinkCompressContext
+{
+public:
+    static uint16_t crc(const uint8_t *frame, uint8_t crcExtra);
+    // Table index of msgid, MAVLINK_COMPRESS_OTHER if it is not in the table
+    static uint8_t msgIndex(uint32_t msgid);
+
+protected:
+    typedef struct {
+        uint8_t sysid;
+        uint8_t compid;
+        uint8_t seq;
+        bool valid;
+    } source_t;
+
+    typedef struct {
+        uint8_t payload[MAVLINK_COMPRESS_DELTA_MAX];
+        uint8_t source;
+        bool valid;
+    } deltaRef_t;
+
+    void resetContext();
+    void defineSource(uint8_t slot, uint8_t sysid, uint8_t compid);
+    void updateRef(uint8_t idx, uint8_t slot, const uint8_t *payload, uint8_t len);
+    const deltaRef_t *getRef(uint8_t idx, uint8_t slot, uint8_t len) const;
+
+    source_t sources[MAVLINK_COMPRESS_SOURCES];
+    uint8_t nextSource;
+    deltaRef_t refs[MAVLINK_COMPRESS_OTHER];
+};
+
+class MAVLinkCompressor : public MAVLinkCompressContext
+{
+public:
+    MAVLinkCompressor() { reset(); }
+    // Start over, the next payload resets the far side too
+    void reset();
+
+    /**
+     * @brief Compress bytes of the serial stream into one link payload. A frame is
+     * only sent once it is complete, the bytes of a partial one are kept internally
+     * @param in serial bytes, `consumed` is set to how many of them were used
+     * @return length written to `out`, 0 if there was nothing to send
+     */
+    uint8_t compress(const uint8_t *in, uint16_t inLen, uint16_t *consumed, uint8_t *out, uint8_t maxLen);
+
+private:
+    typedef enum {
+        COLLECT,    // frame[] holds a partial frame or a run of non-frame bytes
+        READY,      // frame[] holds a compressible frame
+        RAW,        // frame[rawPos..frameLen) is to be sent raw
+    } state_e;
+
+    uint16_t collect(const uint8_t *in, uint16_t len);
+    void finishFrame();
+    void startRaw(uint16_t len);
+    bool emitFrame(uint8_t *out, uint8_t &n, uint8_t maxLen);
+    bool emitRaw(uint8_t *out, uint8_t &n, uint8_t maxLen);
+    uint16_t encodeFrame(uint8_t *rec) const;
+    void commitFrame();
+
+    uint8_t frame[MAVLINK_COMPRESS_MAX_FRAME];
+    uint16_t framePos;
+    uint16_t frameLen;
+    uint16_t rawPos;
+    uint8_t frameIdx;
+    state_e state;
+    uint8_t payloadSeq;
+    uint8_t sinceReset;
+    bool resetPending;
+};
+
+class MAVLinkDecompressor : public MAVLinkCompressContext
+{
+public:
+    MAVLinkDecompressor() { reset(); }
+    // Drop everything but raw bytes until the compressor's next reset
+    void reset();
+
+    /**
+     * @brief Rebuild the serial stream from one link payload
+     * @param out buffer for the stream, MAVLINK_COMPRESS_MAX_EXPANSION * `len` bytes always fits
+     * @return length written to `out`
+     */
+    uint16_t decompress(const uint8_t *in, uint8_t len, uint8_t *out, uint16_t maxLen);
+
+private:
+    uint8_t expectedSeq;
+    bool synced;
+};
@@ -3,6 +3,8 @@
 #include "logging.h"
 #include "crc.h"
 
+#include <string.h>
+
 /* ==========================================
 MSP V2 Message Structure:
 Offset: Usage:         In CRC:  Comment:
@@ -20,114 +22,190 @@ n+8     checksum                uint8, (n= payload size), crc8_dvb_s2 checksum
 // CRC helper function.
 uint8_t crc8_dvb_s2(uint8_t crc, unsigned char a)
 {
-    static GENERIC_CRC8 crc8_dvb_s2_instance(0xD5);
-    return crc8_dvb_s2_instance.calc(crc ^ a);
+    return Crc8Fixed<CRC8_DVB_S2_POLY>::calc(crc ^ a);
 }
 
-bool
-MSP::processReceivedByte(uint8_t c)
+typedef Crc8Fixed<CRC8_DVB_S2_POLY> mspCrc;
+
+MSPParser::MSPParser(uint8_t *pool, uint16_t poolSize)
+    : crcErrors(0), droppedFrames(0), m_pool(pool), m_poolSize(poolSize),
+      m_onFrame(nullptr), m_onSlice(nullptr), m_ctx(nullptr), m_inputState(MSP_IDLE)
+{
+}
+
+void
+MSPParser::setCallbacks(frameCallback_t onFrame, sliceCallback_t onSlice, void *ctx)
+{
+    m_onFrame = onFrame;
+    m_onSlice = onSlice;
+    m_ctx = ctx;
+}
+
+uint32_t
+MSPParser::parse(const uint8_t *data, uint32_t len)
 {
-    switch (m_inputState) {
+    uint32_t frames = 0;
+    const uint8_t *end = data + len;
 
-        case MSP_IDLE:
-            // Wait for framing char
-            if (c == '$') {
+    while (data < end) {
+        switch (m_inputState) {
+
+            case MSP_IDLE: {
+                // Skip everything up to the framing char
+                const uint8_t *start = (const uint8_t *)memchr(data, '$', end - data);
+                if (start == nullptr) {
+                    return frames;
+                }
+                data = start + 1;
                 m_inputState = MSP_HEADER_START;
+                break;
             }
-            break;
-
-        case MSP_HEADER_START:
-            // Waiting for 'X' (MSPv2 native)
-            switch (c) {
-                case 'X':
-                    m_inputState = MSP_HEADER_X;
-                    break;
-                default:
-                    m_inputState = MSP_IDLE;
-                    break;
-            }
-            break;
-
-        case MSP_HEADER_X:
-            // Wait for the packet type (cmd or req)
-            m_inputState = MSP_HEADER_V2_NATIVE;
-
-            // Start of a new packet
-            // reset the packet, offset iterator, and CRC
-            m_packet.reset();
-            m_offset = 0;
-            m_crc = 0;
-
-            switch (c) {
-                case '<':
-                    m_packet.type = MSP_PACKET_COMMAND;
-                    break;
-                case '>':
-                    m_packet.type = MSP_PACKET_RESPONSE;
-                    break;
-                default:
-                    m_packet.type = MSP_PACKET_UNKNOWN;
-                    m_inputState = MSP_IDLE;
-                    break;
-            }
-            break;
-
-        case MSP_HEADER_V2_NATIVE:
-            // Read bytes until we have a full header
-            m_inputBuffer[m_offset++] = c;
-            m_crc = crc8_dvb_s2(m_crc, c);
-
-            // If we've received the correct amount of bytes for a full header
-            if (m_offset == sizeof(mspHeaderV2_t)) {
-                // Copy header values into packet
-                mspHeaderV2_t* header = (mspHeaderV2_t*)&m_inputBuffer[0];
-                m_packet.payloadSize = header->payloadSize;
-                m_packet.function = header->function;
-                m_packet.flags = header->flags;
-                // reset the offset iterator for re-use in payload below
-                m_offset = 0;
-				if (m_packet.payloadSize == 0)
-                	m_inputState = MSP_CHECKSUM_V2_NATIVE;
-				else
-                	m_inputState = MSP_PAYLOAD_V2_NATIVE;
-            }
-            break;
 
-        case MSP_PAYLOAD_V2_NATIVE:
-            // Read bytes until we reach payloadSize
-            m_packet.payload[m_offset++] = c;
-            m_crc = crc8_dvb_s2(m_crc, c);
+            case MSP_HEADER_START:
+                // Waiting for 'X' (MSPv2 native)
+                m_inputState = (*data == 'X') ? MSP_HEADER_X : MSP_IDLE;
+                if (*data != '$') {
+                    data++;
+                }
+                break;
 
-            // If we've received the correct amount of bytes for payload
-            if (m_offset == m_packet.payloadSize) {
-                // Then we're up to the CRC
-                m_inputState = MSP_CHECKSUM_V2_NATIVE;
+            case MSP_HEADER_X:
+                // Wait for the packet type (cmd or req)
+                switch (*data) {
+                    case '<':
+                        m_info.type = MSP_PACKET_COMMAND;
+                        break;
+                    case '>':
+                        m_info.type = MSP_PACKET_RESPONSE;
+                        break;
+                    default:
+                        m_inputState = MSP_IDLE;
+                        continue;
+                }
+                data++;
+                m_offset = 0;
+                m_crc = 0;
+                m_inputState = MSP_HEADER_V2_NATIVE;
+                break;
+
+            case MSP_HEADER_V2_NATIVE: {
+                uint16_t n = sizeof(m_header) - m_offset;
+                if (n > end - data) {
+                    n = end - data;
+                }
+                memcpy(&m_header[m_offset], data, n);
+                m_crc = mspCrc::calc(data, n, m_crc);
+                m_offset += n;
+                data += n;
+                if (m_offset == sizeof(m_header)) {
+                    mspHeaderV2_t *header = (mspHeaderV2_t *)m_header;
+                    m_info.flags = header->flags;
+                    m_info.function = header->function;
+                    m_info.payloadSize = header->payloadSize;
+                    m_offset = 0;
+                    m_inputState = m_info.payloadSize ? MSP_PAYLOAD_V2_NATIVE : MSP_CHECKSUM_V2_NATIVE;
+                }
+                break;
             }
-            break;
 
-        case MSP_CHECKSUM_V2_NATIVE:
-            // Assert that the checksums match
-            if (m_crc == c) {
-                m_inputState = MSP_COMMAND_RECEIVED;
+            case MSP_PAYLOAD_V2_NATIVE: {
+                // As much of the payload as this span has
+                uint32_t n = m_info.payloadSize - m_offset;
+                if (n > (uint32_t)(end - data)) {
+                    n = end - data;
+                }
+                m_crc = mspCrc::calc(data, n, m_crc);
+                if (m_info.payloadSize <= m_poolSize) {
+                    memcpy(&m_pool[m_offset], data, n);
+                }
+                else if (m_onSlice) {
+                    m_onSlice(m_ctx, m_info, m_offset, data, n);
+                }
+                m_offset += n;
+                data += n;
+                if (m_offset == m_info.payloadSize) {
+                    m_inputState = MSP_CHECKSUM_V2_NATIVE;
+                }
+                break;
             }
-            else {
-                DBGLN("CRC failure on MSP packet - Got %d expected %d", c, m_crc);
+
+            case MSP_CHECKSUM_V2_NATIVE: {
+                bool const inPool = m_info.payloadSize <= m_poolSize;
+                if (m_crc != *data) {
+                    DBGLN("CRC failure on MSP packet - Got %d expected %d", *data, m_crc);
+                    crcErrors++;
+                }
+                else if (!inPool && !m_onSlice) {
+                    DBGLN("MSP packet too big - %u bytes", m_info.payloadSize);
+                    droppedFrames++;
+                }
+                else {
+                    frames++;
+                    if (m_onFrame) {
+                        m_onFrame(m_ctx, m_info, inPool ? m_pool : nullptr);
+                    }
+                }
+                data++;
                 m_inputState = MSP_IDLE;
+                break;
             }
-            break;
-        
-        default:
-            m_inputState = MSP_IDLE;
-            break;
+
+            default:
+                m_inputState = MSP_IDLE;
+                break;
+        }
     }
+    return frames;
+}
+
+MSP::MSP()
+    : m_parser(m_packet.payload, sizeof(m_packet.payload)), m_packetReceived(false), m_handler(nullptr)
+{
+    m_packet.reset();
+    m_parser.setCallbacks(onFrame, nullptr, this);
+}
+
+void
+MSP::onFrame(void *ctx, const mspFrameInfo_t &info, const uint8_t *payload)
+{
+    // The payload has been assembled in place
+    MSP *msp = (MSP *)ctx;
+    msp->m_packet.type = info.type;
+    msp->m_packet.flags = info.flags;
+    msp->m_packet.function = info.function;
+    msp->m_packet.payloadSize = info.payloadSize;
+    msp->m_packet.payloadReadIterator = 0;
+    msp->m_packet.readError = false;
+    if (msp->m_handler) {
+        msp->m_handler(&msp->m_packet);
+    }
+    else {
+        msp->m_packetReceived = true;
+    }
+}
+
+bool
+MSP::processReceivedByte(uint8_t c)
+{
+    // A packet stays received until markPacketReceived()
+    if (m_packetReceived) {
+        return false;
+    }
+    m_parser.parse(&c, 1);
 
     // If we've successfully parsed a complete packet
     // return true so the calling function knows that
     // a new packet is ready.
-    if (m_inputState == MSP_COMMAND_RECEIVED) {
-        return true;
-    }
-    return false;
+    return m_packetReceived;
+}
+
+uint32_t
+MSP::processReceivedBytes(const uint8_t *data, uint32_t len, void (*handler)(mspPacket_t *packet))
+{
+    m_handler = handler;
+    uint32_t const packets = m_parser.parse(data, len);
+    m_handler = nullptr;
+    return packets;
 }
 
 mspPacket_t*
@@ -139,9 +217,9 @@ MSP::getReceivedPacket()
 void
 MSP::markPacketReceived()
 {
-    // Set input state to idle, ready to receive the next packet
+    // Ready to receive the next packet
     // The current packet data will be discarded internally
-    m_inputState = MSP_IDLE;
+    m_packetReceived = false;
 }
 
 bool
@@ -2,9 +2,8 @@
 
 #include "targets.h"
 
-// TODO: MSP_PORT_INBUF_SIZE should be changed to
-// dynamically allocate array length based on the payload size
-// Hardcoding payload size to 64 bytes for now, to match CRSF TLM
+// The payload size of an mspPacket_t, to match CRSF TLM. Bigger frames
+// can be parsed with an MSPParser with a bigger pool, or in slices
 #define MSP_PORT_INBUF_SIZE 64
 
 #define CHECK_PACKET_PARSING() \
@@ -82,20 +81,72 @@ typedef struct {
     }
 } mspPacket_t;
 
+typedef struct {
+    mspPacketType_e type;
+    uint8_t         flags;
+    uint16_t        function;
+    uint16_t        payloadSize;
+} mspFrameInfo_t;
+
 /////////////////////////////////////////////////
 
+/**
+ * @brief Parses MSPv2 frames from spans of bytes, such as whatever a UART read returned.
+ *
+ * The header is scanned for and the payload copied a span at a time rather than a byte at
+ * a time. The payload size comes from the header, up to the MSPv2 limit of 65535 bytes:
+ * payloads that fit in the pool are assembled there and handed to the frame callback,
+ * larger ones are handed to the slice callback a piece at a time straight out of the
+ * buffer being parsed. Without a slice callback, frames too big for the pool are dropped.
+ */
+class MSPParser
+{
+public:
+    // A piece of the payload of a frame too big for the pool, the CRC is only checked at the end of the frame
+    typedef void (*sliceCallback_t)(void *ctx, const mspFrameInfo_t &info, uint16_t offset, const uint8_t *data, uint16_t len);
+    // A frame that passed its CRC, `payload` is in the pool or nullptr if it was handed out in slices
+    typedef void (*frameCallback_t)(void *ctx, const mspFrameInfo_t &info, const uint8_t *payload);
+
+    MSPParser(uint8_t *pool, uint16_t poolSize);
+    void            setCallbacks(frameCallback_t onFrame, sliceCallback_t onSlice, void *ctx);
+    // Returns the number of frames completed
+    uint32_t        parse(const uint8_t *data, uint32_t len);
+    void            reset() { m_inputState = MSP_IDLE; }
+
+    uint32_t        crcErrors;
+    uint32_t        droppedFrames;
+
+private:
+    uint8_t         *m_pool;
+    uint16_t        m_poolSize;
+    frameCallback_t m_onFrame;
+    sliceCallback_t m_onSlice;
+    void            *m_ctx;
+
+    mspState_e      m_inputState;
+    mspFrameInfo_t  m_info;
+    uint8_t         m_header[sizeof(mspHeaderV2_t)];
+    uint16_t        m_offset;
+    uint8_t         m_crc;
+};
+
 class MSP
 {
 public:
+    MSP();
     bool            processReceivedByte(uint8_t c);
+    // `handler` is called for each packet completed by `data`
+    uint32_t        processReceivedBytes(const uint8_t *data, uint32_t len, void (*handler)(mspPacket_t *packet));
     mspPacket_t*    getReceivedPacket();
     void            markPacketReceived();
     static bool     sendPacket(mspPacket_t* packet, Stream* port);
 
 private:
-    mspState_e  m_inputState;
-    uint16_t    m_offset;
-    uint8_t     m_inputBuffer[MSP_PORT_INBUF_SIZE];
+    // Assembles payloads straight into m_packet
+    MSPParser   m_parser;
     mspPacket_t m_packet;
-    uint8_t     m_crc;
+    bool        m_packetReceived;
+    void        (*m_handler)(mspPacket_t *packet);
+
+    static void onFrame(void *ctx, const mspFrameInfo_t &info, const uint8_t *payload);
 };
@@ -32,6 +32,7 @@
 #define MSP_ELRS_POWER_CALI_SET             0x21
 
 #define MSP_ELRS_MAVLINK_TLM                0xFD
+#define MSP_ELRS_MAVLINK_TLM_COMPRESSED     0xFC
 
 #define MSP_ELRS_BACKPACK_CONFIG            0x30
 #define MSP_ELRS_BACKPACK_CONFIG_TLM_MODE   0x31
@@ -10,9 +10,17 @@
 #include "common.h"
 #include "CRSF.h"
 #include <cassert>
+#include <cstring>
 
 static_assert(sizeof(OTA_Packet4_s) == OTA4_PACKET_SIZE, "OTA4 packet stuct is invalid!");
 static_assert(sizeof(OTA_Packet8_s) == OTA8_PACKET_SIZE, "OTA8 packet stuct is invalid!");
+// The bit positions within the bytes are checked in test_ota
+static_assert(OtaRcSchemaStd::ch::BYTE == offsetof(OTA_Packet4_s, rc.ch), "OtaRcSchemaStd does not match OTA_Packet4_s");
+static_assert(OtaRcSchemaStd::switches::BYTE == offsetof(OTA_Packet4_s, rc.ch) + sizeof(OTA_Channels_4x10), "OtaRcSchemaStd does not match OTA_Packet4_s");
+static_assert(OtaRcSchemaStd::switches::BYTE + 1 == OTA4_CRC_CALC_LEN, "OtaRcSchemaStd does not match OTA_Packet4_s");
+static_assert(OtaRcSchemaFull::chLow::BYTE == offsetof(OTA_Packet8_s, rc.chLow), "OtaRcSchemaFull does not match OTA_Packet8_s");
+static_assert(OtaRcSchemaFull::chHigh::BYTE == offsetof(OTA_Packet8_s, rc.chHigh), "OtaRcSchemaFull does not match OTA_Packet8_s");
+static_assert(OtaRcSchemaFull::chHigh::BYTE + OtaRcSchemaFull::chHigh::BYTES == OTA8_CRC_CALC_LEN, "OtaRcSchemaFull does not match OTA_Packet8_s");
 
 bool OtaIsFullRes;
 volatile uint8_t OtaNonce;
@@ -20,9 +28,18 @@ uint16_t OtaCrcInitializer;
 OtaSwitchMode_e OtaSwitchModeCurrent;
 
 // CRC
-static Crc2Byte ota_crc;
+typedef Crc2ByteFixed<14, ELRS_CRC14_POLY> OtaCrc14;
+typedef Crc2ByteFixed<16, ELRS_CRC16_POLY> OtaCrc16;
 ValidatePacketCrc_t OtaValidatePacketCrc;
 GeneratePacketCrc_t OtaGeneratePacketCrc;
+int8_t OtaRepairSnrMin = DYNPOWER_SNR_THRESH_NONE;
+// CRC syndrome of a single bit error at each bit position of the packet, sorted by syndrome
+typedef struct {
+    uint16_t syndrome;
+    uint8_t bit;
+} OtaCrcSyndrome_t;
+static OtaCrcSyndrome_t OtaCrcSyndromes[OTA8_PACKET_SIZE * 8];
+static uint8_t OtaCrcSyndromeCnt;
 
 void OtaUpdateCrcInitFromUid()
 {
@@ -42,78 +59,52 @@ static inline uint8_t ICACHE_RAM_ATTR HybridWideNonceToSwitchIndex(uint8_t const
     return ((nonce & 0b111) + ((nonce >> 3) & 0b1)) % 8;
 }
 
+/******** 11bit CRSF <-> 10bit OTA channel conversions ********/
+// Hybrid/Wide: Discard the Extended Limits (E.Limits) range and use the full
+// 10bits to carry only 998us - 2012us
+struct OtaChannelLimited
+{
+    static inline uint32_t toOta(uint32_t ch11bit)
+    {
+        // Limit 10-bit result to the range CRSF_CHANNEL_VALUE_MIN/MAX
+        return CRSF_to_UINT10(constrain(ch11bit, CRSF_CHANNEL_VALUE_MIN, CRSF_CHANNEL_VALUE_MAX));
+    }
+    static inline uint32_t fromOta(uint32_t ch10bit)
+    {
+        return UINT10_to_CRSF(ch10bit);
+    }
+};
+
+// Full res: 10bit covering the entire CRSF extended range, simple divide-by-2 to discard the bit
+struct OtaChannelFullRange
+{
+    static inline uint32_t toOta(uint32_t ch11bit) { return ch11bit >> 1; }
+    static inline uint32_t fromOta(uint32_t ch10bit) { return ch10bit << 1; }
+};
+
 #if defined(TARGET_TX) || defined(UNIT_TEST)
 
 #include "handset.h"            // need access to handset data for arming
 
-// Current ChannelData generator function being used by TX
-PackChannelData_t OtaPackChannelData;
 #if defined(DEBUG_RCVR_LINKSTATS)
 static uint32_t packetCnt;
 #endif
 
-/******** Decimate 11bit to 10bit functions ********/
-typedef uint32_t (*Decimate11to10_fn)(uint32_t ch11bit);
-
-static uint32_t ICACHE_RAM_ATTR Decimate11to10_Limit(uint32_t ch11bit)
-{
-    // Limit 10-bit result to the range CRSF_CHANNEL_VALUE_MIN/MAX
-    return CRSF_to_UINT10(constrain(ch11bit, CRSF_CHANNEL_VALUE_MIN, CRSF_CHANNEL_VALUE_MAX));
-}
-
-static uint32_t ICACHE_RAM_ATTR Decimate11to10_Div2(uint32_t ch11bit)
+static inline void ICACHE_RAM_ATTR PackChannelDataHybridCommon(uint8_t * const buf, OTA_Packet4_s * const ota4, const uint32_t *channelData)
 {
-    // Simple divide-by-2 to discard the bit
-    return ch11bit >> 1;
-}
-
-/***
- * @brief: Pack 4x 11-bit channel array into 4x 10 bit channel struct
- * @desc: Values are packed little-endianish such that bits A987654321 -> 87654321, 000000A9
- *        which is compatible with the 10-bit CRSF subset RC frame structure (0x17) in
- *        Betaflight, but depends on which decimate function is used if it is legacy or CRSFv3 10-bit
- *        destChannels4x10 must be zeroed before this call, the channels are ORed into it
- ***/
-static void ICACHE_RAM_ATTR PackUInt11ToChannels4x10(uint32_t const * const src, OTA_Channels_4x10 * const destChannels4x10, Decimate11to10_fn decimate)
-{
-    const unsigned DEST_PRECISION = 10; // number of bits for each dest, must be <SRC
-    uint8_t *dest = (uint8_t *)destChannels4x10;
-    *dest = 0;
-    unsigned destShift = 0;
-    for (unsigned ch=0; ch<4; ++ch)
-    {
-        // Convert to DEST_PRECISION value
-        unsigned chVal = decimate(src[ch]);
-
-        // Put the low bits in any remaining dest capacity
-        *dest++ |= chVal << destShift;
-
-        // Shift the high bits down and place them into the next dest byte
-        unsigned srcBitsLeft = DEST_PRECISION - 8 + destShift;
-        *dest = chVal >> (DEST_PRECISION - srcBitsLeft);
-        // Next dest should be shifted up by the bits consumed
-        // if destShift == 8 then everything should reset for another set
-        // but this code only expects to do the 4 channels -> 5 bytes evenly
-        destShift = srcBitsLeft;
-    }
-}
-
-static void ICACHE_RAM_ATTR PackChannelDataHybridCommon(OTA_Packet4_s * const ota4, const uint32_t *channelData)
-{
-    ota4->type = PACKET_TYPE_RCDATA;
+    OtaRcSchemaStd::type::set(buf, PACKET_TYPE_RCDATA);
 #if defined(DEBUG_RCVR_LINKSTATS)
     // Incremental packet counter for verification on the RX side, 32 bits shoved into CH1-CH4
-    ota4->dbg_linkstats.packetNum = packetCnt++;
+    ota4->dbg_linkstats.packetNum = packetCnt;
 #else
-    // CRSF input is 11bit and OTA will carry only 10bit. Discard the Extended Limits (E.Limits)
-    // range and use the full 10bits to carry only 998us - 2012us
-    PackUInt11ToChannels4x10(&channelData[0], &ota4->rc.ch, &Decimate11to10_Limit);
+    (void)ota4;
+    OtaRcSchemaStd::ch::encode<OtaChannelLimited>(buf, &channelData[0]);
 
     // send armed status to receiver
     #if defined(UNIT_TEST)
-    ota4->rc.isArmed = CRSF_to_BIT(channelData[4]);
+    OtaRcSchemaStd::isArmed::set(buf, CRSF_to_BIT(channelData[4]));
     #else
-    ota4->rc.isArmed = handset->IsArmed();
+    OtaRcSchemaStd::isArmed::set(buf, handset->IsArmed());
     #endif
 #endif /* !DEBUG_RCVR_LINKSTATS */
 }
@@ -127,20 +118,18 @@ static void ICACHE_RAM_ATTR PackChannelDataHybridCommon(OTA_Packet4_s * const ot
  * in a round-robin fashion.
  *
  * Inputs: channelData, TelemetryStatus
- * Outputs: OTA_Packet4_s, side-effects the sentSwitch value
+ * Outputs: OTA_Packet4_s, OtaCommitChannelData() moves on to the next switch
  */
 // The next switch index to send, where 0=AUX2 and 6=AUX8
 static uint8_t Hybrid8NextSwitchIndex;
 #if defined(UNIT_TEST)
 void OtaSetHybrid8NextSwitchIndex(uint8_t idx) { Hybrid8NextSwitchIndex = idx; }
 #endif
-void ICACHE_RAM_ATTR GenerateChannelDataHybrid8(OTA_Packet_s * const otaPktPtr, const uint32_t *channelData,
-                                                bool const TelemetryStatus, uint8_t const tlmDenom)
+static inline void ICACHE_RAM_ATTR GenerateChannelDataHybrid8(OTA_Packet_s * const otaPktPtr, const uint32_t *channelData,
+                                                              bool const TelemetryStatus)
 {
-    (void)tlmDenom;
-
-    OTA_Packet4_s * const ota4 = &otaPktPtr->std;
-    PackChannelDataHybridCommon(ota4, channelData);
+    uint8_t * const buf = (uint8_t *)otaPktPtr;
+    PackChannelDataHybridCommon(buf, &otaPktPtr->std, channelData);
 
     // Actually send switchIndex - 1 in the packet, to shift down 1-7 (0b111) to 0-6 (0b110)
     // If the two high bits are 0b11, the receiver knows it is the last switch and can use
@@ -153,15 +142,12 @@ void ICACHE_RAM_ATTR GenerateChannelDataHybrid8(OTA_Packet_s * const otaPktPtr,
     else
         value = CRSF_to_SWITCH3b(channelData[bitclearedSwitchIndex + 1 + 4]);
 
-    ota4->rc.switches =
+    OtaRcSchemaStd::switches::set(buf,
         TelemetryStatus << 6 |
         // tell the receiver which switch index this is
         bitclearedSwitchIndex << 3 |
         // include the switch value
-        value;
-
-    // update the sent value
-    Hybrid8NextSwitchIndex = (bitclearedSwitchIndex + 1) % 7;
+        value);
 }
 
 /**
@@ -190,14 +176,14 @@ static uint8_t ICACHE_RAM_ATTR HybridWideSwitchToOta(const uint32_t *channelData
  * Inputs: cchannelData, TelemetryStatus
  * Outputs: OTA_Packet4_s
  **/
-void ICACHE_RAM_ATTR GenerateChannelDataHybridWide(OTA_Packet_s * const otaPktPtr, const uint32_t *channelData,
-                                                   bool const TelemetryStatus, uint8_t const tlmDenom)
+static inline void ICACHE_RAM_ATTR GenerateChannelDataHybridWide(OTA_Packet_s * const otaPktPtr, const uint32_t *channelData,
+                                                                 bool const TelemetryStatus, uint8_t const tlmDenom, uint8_t const nonce)
 {
-    OTA_Packet4_s * const ota4 = &otaPktPtr->std;
-    PackChannelDataHybridCommon(ota4, channelData);
+    uint8_t * const buf = (uint8_t *)otaPktPtr;
+    PackChannelDataHybridCommon(buf, &otaPktPtr->std, channelData);
 
     uint8_t telemBit = TelemetryStatus << 6;
-    uint8_t nextSwitchIndex = HybridWideNonceToSwitchIndex(OtaNonce);
+    uint8_t nextSwitchIndex = HybridWideNonceToSwitchIndex(nonce);
     uint8_t value;
     // Using index 7 means the telemetry bit will always be sent in the packet
     // preceding the RX's telemetry slot for all tlmDenom >= 8
@@ -216,26 +202,27 @@ void ICACHE_RAM_ATTR GenerateChannelDataHybridWide(OTA_Packet_s * const otaPktPt
             value |= telemBit;
     }
 
-    ota4->rc.switches = value;
+    OtaRcSchemaStd::switches::set(buf, value);
 }
 
-static void ICACHE_RAM_ATTR GenerateChannelData8ch12ch(OTA_Packet8_s * const ota8, const uint32_t *channelData, bool const TelemetryStatus, bool const isHighAux)
+static inline void ICACHE_RAM_ATTR GenerateChannelData8ch12ch(OTA_Packet_s * const otaPktPtr, const uint32_t *channelData, bool const TelemetryStatus, bool const isHighAux)
 {
+    uint8_t * const buf = (uint8_t *)otaPktPtr;
     // All channel data is 10 bit apart from AUX1 which is 1 bit
-    ota8->rc.packetType = PACKET_TYPE_RCDATA;
-    ota8->rc.telemetryStatus = TelemetryStatus;
+    OtaRcSchemaFull::type::set(buf, PACKET_TYPE_RCDATA);
+    OtaRcSchemaFull::telemetryStatus::set(buf, TelemetryStatus);
     // uplinkPower has 8 items but only 3 bits, but 0 is 0 power which we never use, shift 1-8 -> 0-7
-    ota8->rc.uplinkPower = constrain(CRSF::LinkStatistics.uplink_TX_Power, 1, 8) - 1;
-    ota8->rc.isHighAux = isHighAux;
+    OtaRcSchemaFull::uplinkPower::set(buf, constrain(CRSF::LinkStatistics.uplink_TX_Power, 1, 8) - 1);
+    OtaRcSchemaFull::isHighAux::set(buf, isHighAux);
     // send armed status to receiver
     #if defined(UNIT_TEST)
-    ota8->rc.isArmed = CRSF_to_BIT(channelData[4]);
+    OtaRcSchemaFull::isArmed::set(buf, CRSF_to_BIT(channelData[4]));
     #else
-    ota8->rc.isArmed = handset->IsArmed();
+    OtaRcSchemaFull::isArmed::set(buf, handset->IsArmed());
     #endif
 #if defined(DEBUG_RCVR_LINKSTATS)
     // Incremental packet counter for verification on the RX side, 32 bits shoved into CH1-CH4
-    ota8->dbg_linkstats.packetNum = packetCnt++;
+    otaPktPtr->full.dbg_linkstats.packetNum = packetCnt;
 #else
     // Sources:
     // 8ch always: low=0 high=5
@@ -264,31 +251,53 @@ static void ICACHE_RAM_ATTR GenerateChannelData8ch12ch(OTA_Packet8_s * const ota
         chSrcLow = 0;
         chSrcHigh = isHighAux ? 8 : 4;
     }
-    PackUInt11ToChannels4x10(&channelData[chSrcLow], &ota8->rc.chLow, &Decimate11to10_Div2);
-    PackUInt11ToChannels4x10(&channelData[chSrcHigh], &ota8->rc.chHigh, &Decimate11to10_Div2);
+    OtaRcSchemaFull::chLow::encode<OtaChannelFullRange>(buf, &channelData[chSrcLow]);
+    OtaRcSchemaFull::chHigh::encode<OtaChannelFullRange>(buf, &channelData[chSrcHigh]);
 #endif
 }
 
-static void ICACHE_RAM_ATTR GenerateChannelData8ch(OTA_Packet_s * const otaPktPtr, const uint32_t *channelData, bool const TelemetryStatus, uint8_t const tlmDenom)
-{
-    (void)tlmDenom;
-
-    GenerateChannelData8ch12ch((OTA_Packet8_s * const)otaPktPtr, channelData, TelemetryStatus, false);
-}
-
 static bool FullResIsHighAux;
 #if defined(UNIT_TEST)
 void OtaSetFullResNextChannelSet(bool next) { FullResIsHighAux = next; }
 #endif
-static void ICACHE_RAM_ATTR GenerateChannelData12ch(OTA_Packet_s * const otaPktPtr, const uint32_t *channelData, bool const TelemetryStatus, uint8_t const tlmDenom)
+
+void ICACHE_RAM_ATTR OtaPrepareChannelData(OTA_Packet_s * const otaPktPtr, const uint32_t *channelData, bool const TelemetryStatus, uint8_t const tlmDenom,
+                                            uint8_t const nonce)
 {
-    (void)tlmDenom;
+    if (OtaIsFullRes)
+    {
+        GenerateChannelData8ch12ch(otaPktPtr, channelData, TelemetryStatus,
+            OtaSwitchModeCurrent != smWideOr8ch && FullResIsHighAux);
+    }
+    else if (OtaSwitchModeCurrent == smWideOr8ch)
+        GenerateChannelDataHybridWide(otaPktPtr, channelData, TelemetryStatus, tlmDenom, nonce);
+    else
+        GenerateChannelDataHybrid8(otaPktPtr, channelData, TelemetryStatus);
+}
 
-    // Every time this function is called, the opposite high Aux channels are sent
-    // This tries to ensure a fair split of high and low aux channels packets even
-    // at 1:2 ratio and around sync packets
-    GenerateChannelData8ch12ch((OTA_Packet8_s * const)otaPktPtr, channelData, TelemetryStatus, FullResIsHighAux);
-    FullResIsHighAux = !FullResIsHighAux;
+void ICACHE_RAM_ATTR OtaCommitChannelData()
+{
+    if (OtaIsFullRes)
+    {
+        // Every time a packet is sent, the opposite high Aux channels are sent next
+        // This tries to ensure a fair split of high and low aux channels packets even
+        // at 1:2 ratio and around sync packets
+        if (OtaSwitchModeCurrent != smWideOr8ch)
+            FullResIsHighAux = !FullResIsHighAux;
+    }
+    else if (OtaSwitchModeCurrent != smWideOr8ch)
+    {
+        Hybrid8NextSwitchIndex = (Hybrid8NextSwitchIndex + 1) % 7;
+    }
+#if defined(DEBUG_RCVR_LINKSTATS)
+    ++packetCnt;
+#endif
+}
+
+void ICACHE_RAM_ATTR OtaPackChannelData(OTA_Packet_s * const otaPktPtr, const uint32_t *channelData, bool const TelemetryStatus, uint8_t const tlmDenom)
+{
+    OtaPrepareChannelData(otaPktPtr, channelData, TelemetryStatus, tlmDenom, OtaNonce);
+    OtaCommitChannelData();
 }
 #endif
 
@@ -297,59 +306,21 @@ static void ICACHE_RAM_ATTR GenerateChannelData12ch(OTA_Packet_s * const otaPktP
 
 bool isArmed;       // global arming status for other functions
 
-// Current ChannelData unpacker function being used by RX
-UnpackChannelData_t OtaUnpackChannelData;
-
 #if defined(DEBUG_RCVR_LINKSTATS)
 // Sequential PacketID from the TX
 uint32_t debugRcvrLinkstatsPacketId;
-#else
-
-static void UnpackChannels4x10ToUInt11(OTA_Channels_4x10 const * const srcChannels4x10, uint32_t * const dest)
-{
-    uint8_t const * const payload = (uint8_t const * const)srcChannels4x10;
-    constexpr unsigned numOfChannels = 4;
-    constexpr unsigned srcBits = 10;
-    constexpr unsigned dstBits = 11;
-    constexpr unsigned inputChannelMask = (1 << srcBits) - 1;
-    constexpr unsigned precisionShift = dstBits - srcBits;
-
-    // code from BetaFlight rx/crsf.cpp / bitpacker_unpack
-    uint8_t bitsMerged = 0;
-    uint32_t readValue = 0;
-    unsigned readByteIndex = 0;
-    for (uint8_t n = 0; n < numOfChannels; n++)
-    {
-        while (bitsMerged < srcBits)
-        {
-            uint8_t readByte = payload[readByteIndex++];
-            readValue |= ((uint32_t) readByte) << bitsMerged;
-            bitsMerged += 8;
-        }
-        //printf("rv=%x(%x) bm=%u\n", readValue, (readValue & channelMask), bitsMerged);
-        dest[n] = (readValue & inputChannelMask) << precisionShift;
-        readValue >>= srcBits;
-        bitsMerged -= srcBits;
-    }
-}
-#endif /* !DEBUG_RCVR_LINKSTATS */
+#endif
 
-static void ICACHE_RAM_ATTR UnpackChannelDataHybridCommon(OTA_Packet4_s const * const ota4, uint32_t *channelData)
+static inline void ICACHE_RAM_ATTR UnpackChannelDataHybridCommon(uint8_t const * const buf, OTA_Packet4_s const * const ota4, uint32_t *channelData)
 {
-    isArmed = ota4->rc.isArmed;
+    isArmed = OtaRcSchemaStd::isArmed::get(buf);
 
 #if defined(DEBUG_RCVR_LINKSTATS)
     debugRcvrLinkstatsPacketId = ota4->dbg_linkstats.packetNum;
 #else
+    (void)ota4;
     // The analog channels, encoded as 10bit where 0 = 998us and 1023 = 2012us
-    UnpackChannels4x10ToUInt11(&ota4->rc.ch, &channelData[0]);
-    // The unpacker simply does a << 1 to convert 10 to 11bit, but Hybrid/Wide modes
-    // only pack a subset of the full range CRSF data, so properly expand it
-    // This is ~80 bytes less code than passing an 10-to-11 expander fn to the unpacker
-    for (unsigned ch=0; ch<4; ++ch)
-    {
-        channelData[ch] = UINT10_to_CRSF(channelData[ch] >> 1);
-    }
+    OtaRcSchemaStd::ch::decode<OtaChannelLimited>(buf, &channelData[0]);
     channelData[4] = BIT_to_CRSF(isArmed);
 #endif
 }
@@ -365,18 +336,15 @@ static void ICACHE_RAM_ATTR UnpackChannelDataHybridCommon(OTA_Packet4_s const *
  * Output: channelData
  * Returns: TelemetryStatus bit
  */
-bool ICACHE_RAM_ATTR UnpackChannelDataHybridSwitch8(OTA_Packet_s const * const otaPktPtr, uint32_t *channelData,
-                                                    uint8_t const tlmDenom)
+static inline bool ICACHE_RAM_ATTR UnpackChannelDataHybridSwitch8(OTA_Packet_s const * const otaPktPtr, uint32_t *channelData)
 {
-    (void)tlmDenom;
-
-    OTA_Packet4_s const * const ota4 = (OTA_Packet4_s const * const)otaPktPtr;
-    UnpackChannelDataHybridCommon(ota4, channelData);
+    uint8_t const * const buf = (uint8_t const *)otaPktPtr;
+    UnpackChannelDataHybridCommon(buf, &otaPktPtr->std, channelData);
 
     // The round-robin switch, switchIndex is actually index-1
     // to leave the low bit open for switch 7 (sent as 0b11x)
     // where x is the high bit of switch 7
-    const uint8_t switchByte = ota4->rc.switches;
+    const uint8_t switchByte = OtaRcSchemaStd::switches::get(buf);
     uint8_t switchIndex = (switchByte & 0b111000) >> 3;
     if (switchIndex >= 6)
     {
@@ -405,16 +373,16 @@ bool ICACHE_RAM_ATTR UnpackChannelDataHybridSwitch8(OTA_Packet_s const * const o
  * Output: channelData
  * Returns: TelemetryStatus bit
  */
-bool ICACHE_RAM_ATTR UnpackChannelDataHybridWide(OTA_Packet_s const * const otaPktPtr, uint32_t *channelData,
-                                                 uint8_t const tlmDenom)
+static inline bool ICACHE_RAM_ATTR UnpackChannelDataHybridWide(OTA_Packet_s const * const otaPktPtr, uint32_t *channelData,
+                                                               uint8_t const tlmDenom)
 {
     static bool TelemetryStatus = false;
 
-    OTA_Packet4_s const * const ota4 = (OTA_Packet4_s const * const)otaPktPtr;
-    UnpackChannelDataHybridCommon(ota4, channelData);
+    uint8_t const * const buf = (uint8_t const *)otaPktPtr;
+    UnpackChannelDataHybridCommon(buf, &otaPktPtr->std, channelData);
 
     // The round-robin switch, 6-7 bits with the switch index implied by the nonce
-    const uint8_t switchByte = ota4->rc.switches;
+    const uint8_t switchByte = OtaRcSchemaStd::switches::get(buf);
     bool telemInEveryPacket = (tlmDenom > 1) && (tlmDenom < 8);
     uint8_t switchIndex = HybridWideNonceToSwitchIndex(OtaNonce);
     if (telemInEveryPacket || switchIndex == 7)
@@ -444,22 +412,21 @@ bool ICACHE_RAM_ATTR UnpackChannelDataHybridWide(OTA_Packet_s const * const otaP
     return TelemetryStatus;
 }
 
-bool ICACHE_RAM_ATTR UnpackChannelData8ch(OTA_Packet_s const * const otaPktPtr, uint32_t *channelData, uint8_t const tlmDenom)
+static inline bool ICACHE_RAM_ATTR UnpackChannelData8ch(OTA_Packet_s const * const otaPktPtr, uint32_t *channelData)
 {
-    (void)tlmDenom;
-
-    OTA_Packet8_s const * const ota8 = (OTA_Packet8_s const * const)otaPktPtr;
+    uint8_t const * const buf = (uint8_t const *)otaPktPtr;
 
-    isArmed = ota8->rc.isArmed;
+    isArmed = OtaRcSchemaFull::isArmed::get(buf);
 
 #if defined(DEBUG_RCVR_LINKSTATS)
-    debugRcvrLinkstatsPacketId = ota8->dbg_linkstats.packetNum;
+    debugRcvrLinkstatsPacketId = otaPktPtr->full.dbg_linkstats.packetNum;
 #else
+    bool const isHighAux = OtaRcSchemaFull::isHighAux::get(buf);
     uint8_t chDstLow;
     uint8_t chDstHigh;
     if (OtaSwitchModeCurrent == smHybridOr16ch)
     {
-        if (ota8->rc.isHighAux)
+        if (isHighAux)
         {
             chDstLow = 8;
             chDstHigh = 12;
@@ -473,27 +440,36 @@ bool ICACHE_RAM_ATTR UnpackChannelData8ch(OTA_Packet_s const * const otaPktPtr,
     else
     {
         chDstLow = 0;
-        chDstHigh = (ota8->rc.isHighAux) ? 8 : 4;
+        chDstHigh = isHighAux ? 8 : 4;
     }
 
     // Analog channels packed 10bit covering the entire CRSF extended range (i.e. not just 988-2012)
     // ** Different than the 10bit encoding in Hybrid/Wide mode **
-    UnpackChannels4x10ToUInt11(&ota8->rc.chLow, &channelData[chDstLow]);
-    UnpackChannels4x10ToUInt11(&ota8->rc.chHigh, &channelData[chDstHigh]);
+    OtaRcSchemaFull::chLow::decode<OtaChannelFullRange>(buf, &channelData[chDstLow]);
+    OtaRcSchemaFull::chHigh::decode<OtaChannelFullRange>(buf, &channelData[chDstHigh]);
 
     // enable this for legacy behavior (digital ch5) for 8ch and 12ch mode
     //channelData[4] = BIT_to_CRSF(isArmed); 
 #endif
     // Restore the uplink_TX_Power range 0-7 -> 1-8
-    CRSF::updateUplinkPower(ota8->rc.uplinkPower + 1);
-    return ota8->rc.telemetryStatus;
+    CRSF::updateUplinkPower(OtaRcSchemaFull::uplinkPower::get(buf) + 1);
+    return OtaRcSchemaFull::telemetryStatus::get(buf);
+}
+
+bool ICACHE_RAM_ATTR OtaUnpackChannelData(OTA_Packet_s const * const otaPktPtr, uint32_t *channelData, uint8_t const tlmDenom)
+{
+    if (OtaIsFullRes)
+        return UnpackChannelData8ch(otaPktPtr, channelData);
+    if (OtaSwitchModeCurrent == smWideOr8ch)
+        return UnpackChannelDataHybridWide(otaPktPtr, channelData, tlmDenom);
+    return UnpackChannelDataHybridSwitch8(otaPktPtr, channelData);
 }
 #endif
 
 bool ICACHE_RAM_ATTR ValidatePacketCrcFull(OTA_Packet_s * const otaPktPtr)
 {
     uint16_t const calculatedCRC =
-        ota_crc.calc((uint8_t*)otaPktPtr, OTA8_CRC_CALC_LEN, OtaCrcInitializer);
+        OtaCrc16::calc<OTA8_CRC_CALC_LEN>((uint8_t*)otaPktPtr, OtaCrcInitializer);
     return otaPktPtr->full.crc == calculatedCRC;
 }
 
@@ -515,7 +491,7 @@ bool ICACHE_RAM_ATTR ValidatePacketCrcStd(OTA_Packet_s * const otaPktPtr)
         otaPktPtr->std.crcHigh = 0;
     }
     uint16_t const calculatedCRC =
-        ota_crc.calc((uint8_t*)otaPktPtr, OTA4_CRC_CALC_LEN, OtaCrcInitializer);
+        OtaCrc14::calc<OTA4_CRC_CALC_LEN>((uint8_t*)otaPktPtr, OtaCrcInitializer);
 
     otaPktPtr->std.crcHigh = backupCrcHigh;
     
@@ -524,105 +500,188 @@ bool ICACHE_RAM_ATTR ValidatePacketCrcStd(OTA_Packet_s * const otaPktPtr)
 
 void ICACHE_RAM_ATTR GeneratePacketCrcFull(OTA_Packet_s * const otaPktPtr)
 {
-    otaPktPtr->full.crc = ota_crc.calc((uint8_t*)otaPktPtr, OTA8_CRC_CALC_LEN, OtaCrcInitializer);
+    otaPktPtr->full.crc = OtaCrc16::calc<OTA8_CRC_CALC_LEN>((uint8_t*)otaPktPtr, OtaCrcInitializer);
 }
 
-void ICACHE_RAM_ATTR GeneratePacketCrcStd(OTA_Packet_s * const otaPktPtr)
+static inline void ICACHE_RAM_ATTR GeneratePacketCrcStdNonce(OTA_Packet_s * const otaPktPtr, uint8_t const nonce)
 {
 #if defined(TARGET_TX)
     // artificially inject the low bits of the nonce on data packets, this will be overwritten with the CRC after it's calculated
     if (otaPktPtr->std.type == PACKET_TYPE_RCDATA && OtaSwitchModeCurrent == smWideOr8ch)
     {
-        otaPktPtr->std.crcHigh = (OtaNonce % ExpressLRS_currAirRate_Modparams->FHSShopInterval) + 1;
+        otaPktPtr->std.crcHigh = (nonce % ExpressLRS_currAirRate_Modparams->FHSShopInterval) + 1;
     }
+    else
 #endif
-    uint16_t crc = ota_crc.calc((uint8_t*)otaPktPtr, OTA4_CRC_CALC_LEN, OtaCrcInitializer);
+    {
+        otaPktPtr->std.crcHigh = 0;
+    }
+    uint16_t crc = OtaCrc14::calc<OTA4_CRC_CALC_LEN>((uint8_t*)otaPktPtr, OtaCrcInitializer);
     otaPktPtr->std.crcHigh = (crc >> 8);
     otaPktPtr->std.crcLow  = crc;
 }
 
+void ICACHE_RAM_ATTR GeneratePacketCrcStd(OTA_Packet_s * const otaPktPtr)
+{
+    GeneratePacketCrcStdNonce(otaPktPtr, OtaNonce);
+}
+
+#if defined(TARGET_TX) || defined(UNIT_TEST)
+void ICACHE_RAM_ATTR OtaGenerateRCdataPacketCrc(OTA_Packet_s * const otaPktPtr, uint8_t const nonce)
+{
+    if (OtaIsFullRes)
+        GeneratePacketCrcFull(otaPktPtr);
+    else
+        GeneratePacketCrcStdNonce(otaPktPtr, nonce);
+}
+#endif
+
+/***
+ * @brief: Build the CRC syndrome table for the current packet size
+ * @desc: The OTA CRCs are linear, so a bit error changes the CRC by the CRC of
+ *        the error alone (with a zero initializer) regardless of the data.
+ *        An error in the CRC itself changes only that bit of the CRC.
+ *        Bit N is bit (N % 8) of byte (N / 8) of the packet. The table is
+ *        kept sorted so the repair can binary search it in the RX ISR
+ ***/
+static void OtaUpdateCrcSyndromes()
+{
+    uint8_t errPkt[OTA8_PACKET_SIZE];
+    OtaCrcSyndromeCnt = 0;
+    for (unsigned bit = 0; bit < sizeof(OtaCrcSyndromes) / sizeof(OtaCrcSyndromes[0]); ++bit)
+    {
+        memset(errPkt, 0, sizeof(errPkt));
+        errPkt[bit / 8] = 1 << (bit % 8);
+        uint16_t syndrome;
+        if (OtaIsFullRes)
+        {
+            if (bit < OTA8_CRC_CALC_LEN * 8)
+                syndrome = OtaCrc16::calc<OTA8_CRC_CALC_LEN>(errPkt, 0);
+            else
+                syndrome = 1 << (bit - OTA8_CRC_CALC_LEN * 8);
+        }
+        else
+        {
+            OTA_Packet4_s * const ota4 = (OTA_Packet4_s *)errPkt;
+            if (bit >= OTA4_PACKET_SIZE * 8)
+                syndrome = 0;
+            else if (ota4->crcHigh)
+                syndrome = (uint16_t)ota4->crcHigh << 8;
+            else if (bit < OTA4_CRC_CALC_LEN * 8)
+                syndrome = OtaCrc14::calc<OTA4_CRC_CALC_LEN>(errPkt, 0);
+            else
+                syndrome = ota4->crcLow;
+        }
+        if (syndrome == 0)
+            continue;
+
+        // Insertion sort, this only runs when the packet size changes
+        unsigned pos = OtaCrcSyndromeCnt++;
+        while (pos > 0 && OtaCrcSyndromes[pos - 1].syndrome > syndrome)
+        {
+            OtaCrcSyndromes[pos] = OtaCrcSyndromes[pos - 1];
+            --pos;
+        }
+        OtaCrcSyndromes[pos].syndrome = syndrome;
+        OtaCrcSyndromes[pos].bit = bit;
+    }
+}
+
+bool ICACHE_RAM_ATTR OtaRepairPacketCrc(OTA_Packet_s * const otaPktPtr, int8_t const snrRaw)
+{
+    if (OtaRepairSnrMin == DYNPOWER_SNR_THRESH_NONE || snrRaw < OtaRepairSnrMin)
+        return false;
+
+    // Repaired in a copy, the caller's packet is only changed if the repair is kept
+    OTA_Packet_s pkt;
+    unsigned pktLen;
+    uint16_t syndrome;
+    if (OtaIsFullRes)
+    {
+        memcpy(&pkt, otaPktPtr, OTA8_PACKET_SIZE);
+        syndrome = pkt.full.crc ^ OtaCrc16::calc<OTA8_CRC_CALC_LEN>((uint8_t *)&pkt, OtaCrcInitializer);
+        pktLen = OTA8_PACKET_SIZE;
+    }
+    else
+    {
+        memcpy(&pkt, otaPktPtr, OTA4_PACKET_SIZE);
+        pkt.std.crcHigh = 0;
+        syndrome = ((uint16_t)otaPktPtr->std.crcHigh << 8 | pkt.std.crcLow)
+            ^ OtaCrc14::calc<OTA4_CRC_CALC_LEN>((uint8_t *)&pkt, OtaCrcInitializer);
+        pkt.std.crcHigh = otaPktPtr->std.crcHigh;
+        pktLen = OTA4_PACKET_SIZE;
+    }
+
+    if (syndrome == 0)
+        return false;
+
+    // Binary search for the single bit error with this syndrome
+    unsigned lo = 0;
+    unsigned hi = OtaCrcSyndromeCnt;
+    while (lo < hi)
+    {
+        unsigned const mid = (lo + hi) / 2;
+        if (OtaCrcSyndromes[mid].syndrome < syndrome)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == OtaCrcSyndromeCnt || OtaCrcSyndromes[lo].syndrome != syndrome)
+        return false;
+
+    uint8_t const bit = OtaCrcSyndromes[lo].bit;
+    ((uint8_t *)&pkt)[bit / 8] ^= 1 << (bit % 8);
+    // A miscorrected RC, SYNC or LINKSTATS packet would do more harm than a lost one
+    if (pkt.std.type != PACKET_TYPE_DATA)
+        return false;
+    memcpy(otaPktPtr, &pkt, pktLen);
+    return true;
+}
+
 void OtaUpdateSerializers(OtaSwitchMode_e const switchMode, uint8_t packetSize)
 {
     OtaIsFullRes = (packetSize == OTA8_PACKET_SIZE);
 
+    // The channel packers dispatch on OtaIsFullRes/OtaSwitchModeCurrent directly
     if (OtaIsFullRes)
     {
         OtaValidatePacketCrc = &ValidatePacketCrcFull;
         OtaGeneratePacketCrc = &GeneratePacketCrcFull;
-        ota_crc.init(16, ELRS_CRC16_POLY);
-
-        #if defined(TARGET_TX) || defined(UNIT_TEST)
-        if (switchMode == smWideOr8ch)
-            OtaPackChannelData = &GenerateChannelData8ch;
-        else
-            OtaPackChannelData = &GenerateChannelData12ch;
-        #endif
-        #if defined(TARGET_RX) || defined(UNIT_TEST)
-        OtaUnpackChannelData = &UnpackChannelData8ch;
-        #endif
-    } // is8ch
-
+    }
     else
     {
         OtaValidatePacketCrc = &ValidatePacketCrcStd;
         OtaGeneratePacketCrc = &GeneratePacketCrcStd;
-        ota_crc.init(14, ELRS_CRC14_POLY);
-
-        if (switchMode == smWideOr8ch)
-        {
-            #if defined(TARGET_TX) || defined(UNIT_TEST)
-            OtaPackChannelData = &GenerateChannelDataHybridWide;
-            #endif
-            #if defined(TARGET_RX) || defined(UNIT_TEST)
-            OtaUnpackChannelData = &UnpackChannelDataHybridWide;
-            #endif
-        } // !is8ch and smWideOr8ch
-
-        else
-        {
-            #if defined(TARGET_TX) || defined(UNIT_TEST)
-            OtaPackChannelData = &GenerateChannelDataHybrid8;
-            #endif
-            #if defined(TARGET_RX) || defined(UNIT_TEST)
-            OtaUnpackChannelData = &UnpackChannelDataHybridSwitch8;
-            #endif
-        } // !is8ch and smHybridOr16ch
     }
+    OtaUpdateCrcSyndromes();
 
     OtaSwitchModeCurrent = switchMode;
 }
 
-void OtaPackAirportData(OTA_Packet_s * const otaPktPtr, FIFO<AP_MAX_BUF_LEN> *inputBuffer)
+void OtaPackAirportData(OTA_Packet_s * const otaPktPtr, SPSCFIFO<AP_MAX_BUF_LEN> *inputBuffer)
 {
     otaPktPtr->std.type = PACKET_TYPE_DATA;
 
-    inputBuffer->lock();
-    uint8_t count = inputBuffer->size();
     if (OtaIsFullRes)
     {
-        count = std::min(count, (uint8_t)ELRS8_TELEMETRY_BYTES_PER_CALL);
-        otaPktPtr->full.airport.count = count;
-        inputBuffer->popBytes(otaPktPtr->full.airport.payload, count);
+        otaPktPtr->full.airport.count = inputBuffer->popBytes(otaPktPtr->full.airport.payload, ELRS8_TELEMETRY_BYTES_PER_CALL);
     }
     else
     {
-        count = std::min(count, (uint8_t)ELRS4_TELEMETRY_BYTES_PER_CALL);
-        otaPktPtr->std.airport.count = count;
-        inputBuffer->popBytes(otaPktPtr->std.airport.payload, count);
+        otaPktPtr->std.airport.count = inputBuffer->popBytes(otaPktPtr->std.airport.payload, ELRS4_TELEMETRY_BYTES_PER_CALL);
     }
-    inputBuffer->unlock();
 }
 
-void OtaUnpackAirportData(OTA_Packet_s const * const otaPktPtr, FIFO<AP_MAX_BUF_LEN> *outputBuffer)
+void OtaUnpackAirportData(OTA_Packet_s const * const otaPktPtr, SPSCFIFO<AP_MAX_BUF_LEN> *outputBuffer)
 {
     if (OtaIsFullRes)
     {
         uint8_t count = otaPktPtr->full.airport.count;
-        outputBuffer->atomicPushBytes(otaPktPtr->full.airport.payload, count);
+        outputBuffer->pushBytes(otaPktPtr->full.airport.payload, count);
     }
     else
     {
         uint8_t count = otaPktPtr->std.airport.count;
-        outputBuffer->atomicPushBytes(otaPktPtr->std.airport.payload, count);
+        outputBuffer->pushBytes(otaPktPtr->std.airport.payload, count);
     }
 }
@@ -8,6 +8,8 @@
 #include "crsf_protocol.h"
 #include "telemetry_protocol.h"
 #include "FIFO.h"
+#include "SPSCFIFO.h"
+#include "OtaSchema.h"
 
 #if TARGET_RX 
 extern bool isArmed;
@@ -37,7 +39,7 @@ typedef struct {
             newTlmRatio:3,
             geminiMode:1,
             otaProtocol:2,
-            free:1;
+            afhGen:1; // generation of the adaptive hopping channel mask in use
     uint8_t UID4;
     uint8_t UID5;
 } PACKED OTA_Sync_s;
@@ -89,7 +91,8 @@ typedef struct {
                 struct {
                     OTA_LinkStats_s stats;
                     uint8_t trueDiversityAvailable:1,
-                            free:7;
+                            mspWindowed:1, // RX accepts windowed MSP, mspAck and stats.tlmConfirm are its window ack
+                            mspAck:6;
                 } PACKED ul_link_stats;
                 uint8_t payload[ELRS4_TELEMETRY_BYTES_PER_CALL];
             };
@@ -146,7 +149,8 @@ typedef struct {
                 struct {
                     OTA_LinkStats_s stats;
                     uint8_t trueDiversityAvailable:1,
-                            free:7;
+                            mspWindowed:1, // RX accepts windowed MSP, mspAck and stats.tlmConfirm are its window ack
+                            mspAck:6;
                     uint8_t payload[ELRS8_TELEMETRY_BYTES_PER_CALL - sizeof(OTA_LinkStats_s) - 1];
                 } PACKED ul_link_stats;
                 uint8_t payload[ELRS8_TELEMETRY_BYTES_PER_CALL]; // containsLinkStats == false
@@ -170,6 +174,31 @@ typedef struct {
     };
 } PACKED OTA_Packet_s;
 
+/**
+ * Bit layout of the PACKET_TYPE_RCDATA packets, which the channel packers
+ * use to read and write the packet buffer directly. Must describe the same
+ * bits as the rc member of OTA_Packet4_s/OTA_Packet8_s (checked in OTA.cpp
+ * and test_ota)
+ */
+struct OtaRcSchemaStd
+{
+    typedef OtaField<0, 2> type;
+    typedef OtaChannelField<8, 4, 10> ch;
+    typedef OtaField<48, 7> switches;
+    typedef OtaField<55, 1> isArmed;
+};
+
+struct OtaRcSchemaFull
+{
+    typedef OtaField<0, 2> type;
+    typedef OtaField<2, 1> telemetryStatus;
+    typedef OtaField<3, 3> uplinkPower;
+    typedef OtaField<6, 1> isHighAux;
+    typedef OtaField<7, 1> isArmed;
+    typedef OtaChannelField<8, 4, 10> chLow;
+    typedef OtaChannelField<48, 4, 10> chHigh;
+};
+
 extern bool OtaIsFullRes;
 extern volatile uint8_t OtaNonce;
 extern uint16_t OtaCrcInitializer;
@@ -184,14 +213,32 @@ typedef bool (*ValidatePacketCrc_t)(OTA_Packet_s * const otaPktPtr);
 typedef void (*GeneratePacketCrc_t)(OTA_Packet_s * const otaPktPtr);
 extern ValidatePacketCrc_t OtaValidatePacketCrc;
 extern GeneratePacketCrc_t OtaGeneratePacketCrc;
-// Value is implicit leading 1, comment is Koopman formatting (implicit trailing 1) https://users.ece.cmu.edu/~koopman/crc/
-#define ELRS_CRC_POLY 0x07 // 0x83
-#define ELRS_CRC14_POLY 0x2E57 // 0x372b
-#define ELRS_CRC16_POLY 0x3D65 // 0x9eb2
+
+/**
+ * @brief Correct a single bit error in a packet which failed OtaValidatePacketCrc()
+ * The CRC syndrome of every single bit error is unique at the OTA packet lengths,
+ * so the bit in error can be located without any extra bytes in the air.
+ * Only PACKET_TYPE_DATA packets are repaired, their CRC does not include the nonce
+ * and a miscorrection costs less than a bad RC, SYNC or LINKSTATS packet would.
+ * @param snrRaw this packet's SNR in RADIO_SNR_SCALE units, the repair is not
+ * attempted below OtaRepairSnrMin, where multiple bit errors are more likely
+ * and a miscorrection would slip through
+ * @return true if the packet was repaired in place and now passes the CRC,
+ * the packet is left untouched otherwise
+ */
+bool OtaRepairPacketCrc(OTA_Packet_s * const otaPktPtr, int8_t const snrRaw);
+// Minimum SNR for OtaRepairPacketCrc(), DYNPOWER_SNR_THRESH_NONE to never repair
+extern int8_t OtaRepairSnrMin;
 
 #if defined(TARGET_TX) || defined(UNIT_TEST)
-typedef void (*PackChannelData_t)(OTA_Packet_s * const otaPktPtr, const uint32_t *channelData, bool TelemetryStatus, uint8_t tlmDenom);
-extern PackChannelData_t OtaPackChannelData;
+// Pack the ChannelData into an RCDATA packet using the mode set by OtaUpdateSerializers()
+void OtaPackChannelData(OTA_Packet_s * const otaPktPtr, const uint32_t *channelData, bool TelemetryStatus, uint8_t tlmDenom);
+// OtaPackChannelData() in two halves: pack for the packet sent with nonce without moving on to the
+// next switch or aux channels, which can be repeated with newer ChannelData, then move on once it is sent
+void OtaPrepareChannelData(OTA_Packet_s * const otaPktPtr, const uint32_t *channelData, bool TelemetryStatus, uint8_t tlmDenom, uint8_t nonce);
+void OtaCommitChannelData();
+// OtaGeneratePacketCrc() for an RCDATA packet which will be sent with nonce rather than OtaNonce
+void OtaGenerateRCdataPacketCrc(OTA_Packet_s * const otaPktPtr, uint8_t nonce);
 #if defined(UNIT_TEST)
 void OtaSetHybrid8NextSwitchIndex(uint8_t idx);
 void OtaSetFullResNextChannelSet(bool next);
@@ -199,12 +246,12 @@ void OtaSetFullResNextChannelSet(bool next);
 #endif
 
 #if defined(TARGET_RX) || defined(UNIT_TEST)
-typedef bool (*UnpackChannelData_t)(OTA_Packet_s const * const otaPktPtr, uint32_t *channelData, uint8_t tlmDenom);
-extern UnpackChannelData_t OtaUnpackChannelData;
+// Unpack an RCDATA packet into ChannelData, returns the TelemetryStatus bit
+bool OtaUnpackChannelData(OTA_Packet_s const * const otaPktPtr, uint32_t *channelData, uint8_t tlmDenom);
 #endif
 
-void OtaPackAirportData(OTA_Packet_s * const otaPktPtr, FIFO<AP_MAX_BUF_LEN> *inputBuffer);
-void OtaUnpackAirportData(OTA_Packet_s const * const otaPktPtr, FIFO<AP_MAX_BUF_LEN> *outputBuffer);
+void OtaPackAirportData(OTA_Packet_s * const otaPktPtr, SPSCFIFO<AP_MAX_BUF_LEN> *inputBuffer);
+void OtaUnpackAirportData(OTA_Packet_s const * const otaPktPtr, SPSCFIFO<AP_MAX_BUF_LEN> *outputBuffer);
 
 #if defined(DEBUG_RCVR_LINKSTATS)
 extern uint32_t debugRcvrLinkstatsPacketId;
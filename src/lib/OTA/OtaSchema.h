@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+#include "ChannelCodec.h"
+
+/**
+ * Compile-time descriptors for fields at fixed bit positions in an OTA packet
+ *
+ * Bit 0 is the LSB of byte 0 of the packet, which is the order GCC allocates
+ * the bitfields of the OTA_Packet structs on all supported (little-endian)
+ * targets. The accessors read and write the packet buffer directly, so the
+ * packers do not need a temporary copy of the packet and every offset, shift
+ * and mask is a constant the compiler can fold.
+ */
+template <unsigned BIT_OFFSET, unsigned WIDTH>
+struct OtaField
+{
+    static_assert(WIDTH > 0 && WIDTH <= 32, "OtaField width must be 1-32 bits");
+
+    static constexpr unsigned OFFSET = BIT_OFFSET;
+    static constexpr unsigned BITS = WIDTH;
+    static constexpr unsigned BYTE = BIT_OFFSET / 8;
+    static constexpr unsigned SHIFT = BIT_OFFSET % 8;
+    static constexpr unsigned BYTES = (SHIFT + WIDTH + 7) / 8;
+    static constexpr uint32_t MASK = (uint32_t)((1ULL << WIDTH) - 1);
+
+    static inline uint32_t get(uint8_t const * const buf)
+    {
+        uint64_t v = 0;
+        for (unsigned i = 0; i < BYTES; ++i)
+            v |= (uint64_t)buf[BYTE + i] << (8 * i);
+        return (uint32_t)(v >> SHIFT) & MASK;
+    }
+
+    static inline void set(uint8_t * const buf, uint32_t const val)
+    {
+        uint64_t const fieldMask = (uint64_t)MASK << SHIFT;
+        uint64_t const v = (uint64_t)(val & MASK) << SHIFT;
+        for (unsigned i = 0; i < BYTES; ++i)
+        {
+            uint8_t const byteMask = fieldMask >> (8 * i);
+            buf[BYTE + i] = (buf[BYTE + i] & ~byteMask) | (uint8_t)(v >> (8 * i));
+        }
+    }
+};
+
+/**
+ * COUNT channels of WIDTH bits each, packed little-endian starting on a byte
+ * boundary, e.g. 4x 10-bit: bits A987654321 -> 87654321, 000000A9
+ * which is compatible with the 10-bit CRSF subset RC frame structure (0x17)
+ * in Betaflight
+ *
+ * The block is packed by ChannelCodec, written (or read) a byte at a time,
+ * so it does not need to be zeroed beforehand. CONV provides
+ * the conversion between the 11-bit CRSF value and the OTA value:
+ *   static uint32_t toOta(uint32_t ch11bit);
+ *   static uint32_t fromOta(uint32_t chOta);
+ */
+template <unsigned BIT_OFFSET, unsigned COUNT, unsigned WIDTH>
+struct OtaChannelField
+{
+    static_assert(BIT_OFFSET % 8 == 0, "OtaChannelField must start on a byte boundary");
+    static_assert((COUNT * WIDTH) % 8 == 0, "OtaChannelField must be a whole number of bytes");
+
+    static constexpr unsigned OFFSET = BIT_OFFSET;
+    static constexpr unsigned BYTE = BIT_OFFSET / 8;
+    static constexpr unsigned BYTES = COUNT * WIDTH / 8;
+    static constexpr uint32_t MASK = (1U << WIDTH) - 1;
+
+    // Accessor for a single channel of the block
+    template <unsigned N>
+    struct Channel : OtaField<BIT_OFFSET + N * WIDTH, WIDTH>
+    {
+        static_assert(N < COUNT, "OtaChannelField channel out of range");
+    };
+
+    template <typename CONV>
+    static inline void encode(uint8_t * const buf, uint32_t const * const src)
+    {
+        ChannelCodec<COUNT, WIDTH>::template pack<CONV>(buf + BYTE, src);
+    }
+
+    template <typename CONV>
+    static inline void decode(uint8_t const * const buf, uint32_t * const dst)
+    {
+        ChannelCodec<COUNT, WIDTH>::template unpack<CONV>(buf + BYTE, dst);
+    }
+};
@@ -1,6 +1,5 @@
 #pragma once
-#include <Arduino.h>
-#include <stdio.h>
+#include <stdint.h>
 #include "../../src/include/targets.h"
 
 class PFD
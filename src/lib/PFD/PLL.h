@@ -0,0 +1,187 @@
+#pragma once
+
+#include <stdint.h>
+
+// Acquisition loop gains, Kp = 1/2 and Ki = 3/32 put both poles at 0.71
+// so the phase error falls by 100x within about 16 updates
+#define PLL_ACQ_KP_SHIFT 1
+#define PLL_ACQ_KI_Q8 24
+// Tracking loop gains once locked, 1/4 of the bandwidth to reject the packet timestamp jitter
+#define PLL_TRK_KP_SHIFT 3
+#define PLL_TRK_KI_Q8 1
+// Consecutive updates within PLL_LOCK_PHASE_US needed to declare lock
+#define PLL_LOCK_UPDATES 16
+#define PLL_LOCK_PHASE_US 10
+// Once locked, a phase error beyond this is taken as an outlier and not fed to the loop,
+// unless it happens PLL_UNLOCK_UPDATES times in a row, which drops back to acquisition
+#define PLL_REJECT_PHASE_US 100
+#define PLL_UNLOCK_UPDATES 4
+// Smoothed errors within which the RX is considered connected, see isSettled()
+#define PLL_SETTLED_FREQ_US 10
+#define PLL_SETTLED_PHASE_US 100
+// The frequency correction is limited to what the TX and RX crystals could be off by between them
+#define PLL_MAX_PPM 200
+
+/**
+ * Second order (proportional + integral) phase locked loop for the RX timer
+ *
+ * Fed with the PFD phase error of each received packet, it estimates both
+ * the phase error, corrected with a one time hwTimer::phaseShift(), and the
+ * frequency error between the TX and RX clocks, corrected with the hwTimer
+ * FreqOffset. Missed packets are accounted for so the frequency estimate
+ * stays in us per packet interval when packets are lost.
+ */
+class PLL
+{
+public:
+    /**
+     * @param freqOffsetPerUsQ8 hwTimer FreqOffset units per us of change in the packet interval,
+     *        in Q8. FreqOffset is in timer ticks and applied to each half of the interval, so
+     *        this is HWTIMER_TICKS_PER_US * 256 / 2
+     */
+    explicit PLL(int32_t freqOffsetPerUsQ8) : freqOffsetPerUsQ8(freqOffsetPerUsQ8), freqMaxQ8(0)
+    {
+        reset();
+    }
+
+    /**
+     * @brief Set the packet interval, which limits the frequency correction to PLL_MAX_PPM.
+     * There is no frequency correction until this is called.
+     */
+    void setInterval(uint32_t intervalUs)
+    {
+        freqMaxQ8 = (int32_t)((uint64_t)intervalUs * PLL_MAX_PPM * 256 / 1000000);
+        freqQ8 = clampFreq(freqQ8);
+    }
+
+    void reset()
+    {
+        freqQ8 = 0;
+        resync();
+    }
+
+    /**
+     * @brief Start acquiring the phase again, but keep the frequency estimate
+     */
+    void resync()
+    {
+        phaseShift = 0;
+        phaseRemQ8 = 0;
+        lastPhaseErr = 0;
+        phaseErrAvgQ4 = 0;
+        freqErrAvgQ4 = 0;
+        intervals = 1;
+        lockCount = 0;
+        rejectCount = 0;
+        hasPrev = false;
+    }
+
+    /**
+     * @brief Feed the PFD result of the packet received this interval
+     * @param phaseErr how late the packet arrived relative to the timer in us
+     */
+    inline void update(int32_t phaseErr)
+    {
+        if (isLocked() && (phaseErr > PLL_REJECT_PHASE_US || phaseErr < -PLL_REJECT_PHASE_US))
+        {
+            if (++rejectCount < PLL_UNLOCK_UPDATES)
+            {
+                missed();
+                return;
+            }
+            // Not an outlier, the TX timing has moved: acquire it again
+            lockCount = 0;
+        }
+        rejectCount = 0;
+
+        // Frequency error not yet corrected, the change in phase error since the
+        // last update once the phase shift applied in between is taken out
+        if (hasPrev)
+        {
+            int32_t const freqErr = (phaseErr - (lastPhaseErr - phaseShift)) / (int32_t)intervals;
+            freqErrAvgQ4 += ((freqErr * 16) - freqErrAvgQ4) / 4;
+        }
+        phaseErrAvgQ4 += ((phaseErr * 16) - phaseErrAvgQ4) / 4;
+
+        // The phase shift is in whole us, carry the remainder so small errors are still corrected
+        if (isLocked())
+        {
+            phaseRemQ8 += phaseErr * (256 >> PLL_TRK_KP_SHIFT);
+            freqQ8 = clampFreq(freqQ8 + phaseErr * PLL_TRK_KI_Q8 / (int32_t)intervals);
+        }
+        else
+        {
+            phaseRemQ8 += phaseErr * (256 >> PLL_ACQ_KP_SHIFT);
+            freqQ8 = clampFreq(freqQ8 + phaseErr * PLL_ACQ_KI_Q8 / (int32_t)intervals);
+            if (phaseErr <= PLL_LOCK_PHASE_US && phaseErr >= -PLL_LOCK_PHASE_US)
+                ++lockCount;
+            else
+                lockCount = 0;
+        }
+        phaseShift = phaseRemQ8 / 256;
+        phaseRemQ8 -= phaseShift * 256;
+
+        lastPhaseErr = phaseErr;
+        intervals = 1;
+        hasPrev = true;
+    }
+
+    /**
+     * @brief No packet was received this interval
+     */
+    inline void missed()
+    {
+        // No phase shift is applied when there's no update
+        if (hasPrev && intervals == 1)
+        {
+            lastPhaseErr -= phaseShift;
+            phaseShift = 0;
+        }
+        if (intervals < UINT8_MAX)
+            ++intervals;
+    }
+
+    /* Phase correction to apply once, in us */
+    int32_t getPhaseShift() const { return phaseShift; }
+    /* Frequency correction as an hwTimer FreqOffset, within PLL_MAX_PPM as freqQ8 is */
+    int32_t getFreqOffset() const
+    {
+        // freqQ8 is at most PLL_MAX_PPM of the interval, which keeps this well within int32_t
+        int32_t const offsetQ16 = freqQ8 * freqOffsetPerUsQ8;
+        return (offsetQ16 + ((offsetQ16 < 0) ? -32768 : 32768)) / 65536;
+    }
+    /* Estimated frequency correction in 1/256 us per packet interval */
+    int32_t getFreqEstimateQ8() const { return freqQ8; }
+    /* Smoothed phase error in us */
+    int32_t getPhaseError() const { return phaseErrAvgQ4 / 16; }
+    /* Smoothed uncorrected frequency error in us per packet interval */
+    int32_t getFreqError() const { return freqErrAvgQ4 / 16; }
+    /* Phase error of the last update in us */
+    int32_t getLastPhaseError() const { return lastPhaseErr; }
+    bool isLocked() const { return lockCount >= PLL_LOCK_UPDATES; }
+    /* Phase and frequency close enough to the TX to call the link connected, before it is locked */
+    bool isSettled() const
+    {
+        return (getFreqError() <= PLL_SETTLED_FREQ_US && getFreqError() >= -PLL_SETTLED_FREQ_US)
+            && (getPhaseError() < PLL_SETTLED_PHASE_US && getPhaseError() > -PLL_SETTLED_PHASE_US);
+    }
+
+private:
+    int32_t clampFreq(int32_t f) const
+    {
+        return (f > freqMaxQ8) ? freqMaxQ8 : (f < -freqMaxQ8) ? -freqMaxQ8 : f;
+    }
+
+    int32_t const freqOffsetPerUsQ8;
+    int32_t freqMaxQ8;
+    int32_t freqQ8;
+    int32_t phaseShift;
+    int32_t phaseRemQ8;
+    int32_t lastPhaseErr;
+    int32_t phaseErrAvgQ4;
+    int32_t freqErrAvgQ4;
+    uint8_t intervals;
+    uint8_t lockCount;
+    uint8_t rejectCount;
+    bool hasPrev;
+};
@@ -38,6 +38,23 @@ PowerLevels_e crsfPowerToPower(uint8_t crsfpower)
     }
 }
 
+uint8_t powerToDbm(PowerLevels_e Power)
+{
+    switch (Power)
+    {
+    case PWR_10mW: return 10;
+    case PWR_25mW: return 14;
+    case PWR_50mW: return 17;
+    case PWR_100mW: return 20;
+    case PWR_250mW: return 24;
+    case PWR_500mW: return 27;
+    case PWR_1000mW: return 30;
+    case PWR_2000mW: return 33;
+    default:
+        return 0;
+    }
+}
+
 #ifndef UNIT_TEST
 
 #include "common.h"
@@ -130,19 +147,7 @@ int8_t POWERMGNT::currentSX1280Output()
 
 uint8_t POWERMGNT::getPowerIndBm()
 {
-    switch (CurrentPower)
-    {
-    case PWR_10mW: return 10;
-    case PWR_25mW: return 14;
-    case PWR_50mW: return 17;
-    case PWR_100mW: return 20;
-    case PWR_250mW: return 24;
-    case PWR_500mW: return 27;
-    case PWR_1000mW: return 30;
-    case PWR_2000mW: return 33;
-    default:
-        return 0;
-    }
+    return powerToDbm(CurrentPower);
 }
 
 void POWERMGNT::SetPowerCaliValues(int8_t *values, size_t size)
@@ -23,6 +23,7 @@ typedef enum
 
 uint8_t powerToCrsfPower(PowerLevels_e Power);
 PowerLevels_e crsfPowerToPower(uint8_t crsfpower);
+uint8_t powerToDbm(PowerLevels_e Power);
 
 class PowerLevelContainer
 {
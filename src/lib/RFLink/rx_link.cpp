@@ -0,0 +1,1350 @@
+#if defined(TARGET_RX) || defined(UNIT_TEST)
+
+#include "rx_link.h"
+#include "rxtx_intf.h"
+#include "CRSF.h"
+#include "FHSS.h"
+#include "hwTimer.h"
+#include "ISRProfile.h"
+#include "logging.h"
+#include "LQSTATS.h"
+#include "OTA.h"
+#include "deferred.h"
+#include "options.h"
+#include "msptypes.h"
+#include "telemetry.h"
+#include "AfhProposal.h"
+#include "MeanAccumulator.h"
+#include "SPSCFIFO.h"
+
+#if defined(Regulatory_Domain_EU_CE_2400)
+#include "LBT.h"
+#endif
+#if defined(UNIT_TEST)
+#include "SX1280Driver.h"
+extern SX1280Driver Radio;
+#endif
+
+extern Telemetry telemetry;
+extern SPSCFIFO<AP_MAX_BUF_LEN> apInputBuffer;
+extern SPSCFIFO<AP_MAX_BUF_LEN> apOutputBuffer;
+
+//// CONSTANTS ////
+#define PACKET_TO_TOCK_SLACK 200 // Desired buffer time between Packet ISR and Tock ISR
+#define AFH_UPDATE_INTERVAL 10000 // How often the channel statistics are checked for channels to block
+#define AFH_RELEASE_INTERVAL 60000 // How often all the blocked channels are given another chance
+#define AFH_MIN_PERIODS 20 // Periods a channel must be seen before it can be blocked
+#define AFH_BLOCK_LOSS 50 // Loss % of a channel to block it
+
+uint8_t antenna = 0;    // which antenna is currently in use
+uint8_t geminiMode = 0;
+
+PFD PFDloop;
+PLL PhaseLock(HWTIMER_TICKS_PER_US * 256 / 2);
+
+StubbornSender TelemetrySender;
+static uint8_t telemetryBurstCount;
+static uint8_t telemetryBurstMax;
+
+StubbornReceiver MspReceiver;
+
+static bool tlmSent = false;
+static uint8_t NextTelemetryType = PACKET_TYPE_LINKSTATS;
+static bool telemBurstValid;
+
+/// LQ/RSSI/SNR Calculation //////////
+LQCALC<100> LQCalc;
+LQCALC<100> LQCalcDVDA;
+uint8_t uplinkLQ;
+LPF LPF_UplinkRSSI0(5);  // track rssi per antenna
+LPF LPF_UplinkRSSI1(5);
+MeanAccumulator<int32_t, int8_t, -16> SnrMean;
+
+/// Adaptive hopping //////////
+// The loop builds the proposed sequence with FHSSprepareChannelMask() before starting the
+// proposal, the ISR only swaps to it once the TX echoes it, see AfhProposal
+static volatile uint8_t afhActiveGen;
+static AfhProposal afhProposal;
+// The TX's SYNC has a generation this RX is not using or proposing
+static volatile bool afhGenMismatch;
+static uint32_t afhLastUpdate;
+static uint32_t afhLastRelease;
+
+static void resetAdaptiveHopping()
+{
+    FHSSapplyChannelMask(nullptr);
+    afhActiveGen = 0;
+    afhProposal.reset();
+    afhGenMismatch = false;
+}
+
+uint8_t scanIndex;
+uint8_t ExpressLRS_nextAirRateIndex;
+int8_t SwitchModePending;
+
+RXtimerState_e RXtimerState;
+uint32_t GotConnectionMillis = 0;
+bool doStartTimer = false;
+
+///////////////////////////////////////////////
+
+bool didFHSS = false;
+bool alreadyFHSS = false;
+bool alreadyTLMresp = false;
+
+//////////////////////////////////////////////////////////////
+
+///////Variables for Telemetry and Link Quality///////////////
+uint32_t LastValidPacket = 0;           //Time the last valid packet was recv
+uint32_t LastSyncPacket = 0;            //Time the last valid packet was recv
+
+uint32_t SendLinkStatstoFCintervalLastSent;
+uint8_t SendLinkStatstoFCForcedSends;
+
+#if defined(DEBUG_RX_SCOREBOARD)
+static bool lastPacketCrcError;
+#endif
+///////////////////////////////////////////////////////////////
+
+/// Variables for Sync Behaviour ////
+uint32_t cycleInterval; // in ms
+uint32_t RFmodeLastCycled = 0;
+#define RFmodeCycleMultiplierSlow 10
+uint8_t RFmodeCycleMultiplier;
+bool LockRFmode = false;
+///////////////////////////////////////
+
+#if defined(DEBUG_BF_LINK_STATS)
+// Debug vars
+uint8_t debug1 = 0;
+uint8_t debug2 = 0;
+uint8_t debug3 = 0;
+int8_t debug4 = 0;
+///////////////////////////////////////
+#endif
+
+#if defined(DEBUG_RCVR_LINKSTATS)
+bool debugRcvrLinkstatsPending;
+uint8_t debugRcvrLinkstatsFhssIdx;
+#endif
+
+uint8_t getLq()
+{
+    return LQCalc.getLQ();
+}
+
+void ICACHE_RAM_ATTR getRFlinkInfo()
+{
+    int32_t rssiDBM = Radio.LastPacketRSSI;
+
+    if (GPIO_PIN_NSS_2 != UNDEF_PIN)
+    {
+        int32_t rssiDBM2 = Radio.LastPacketRSSI2;
+
+        #if !defined(DEBUG_RCVR_LINKSTATS)
+        rssiDBM = LPF_UplinkRSSI0.update(rssiDBM);
+        rssiDBM2 = LPF_UplinkRSSI1.update(rssiDBM2);
+        #endif
+        rssiDBM = (rssiDBM > 0) ? 0 : rssiDBM;
+        rssiDBM2 = (rssiDBM2 > 0) ? 0 : rssiDBM2;
+
+        // BetaFlight/iNav expect positive values for -dBm (e.g. -80dBm -> sent as 80)
+        CRSF::LinkStatistics.uplink_RSSI_1 = -rssiDBM;
+        CRSF::LinkStatistics.uplink_RSSI_2 = -rssiDBM2;
+        antenna = (Radio.GetProcessingPacketRadio() == SX12XX_Radio_1) ? 0 : 1;
+    }
+    else if (antenna == 0)
+    {
+        #if !defined(DEBUG_RCVR_LINKSTATS)
+        rssiDBM = LPF_UplinkRSSI0.update(rssiDBM);
+        #endif
+        if (rssiDBM > 0) rssiDBM = 0;
+        // BetaFlight/iNav expect positive values for -dBm (e.g. -80dBm -> sent as 80)
+        CRSF::LinkStatistics.uplink_RSSI_1 = -rssiDBM;
+    }
+    else
+    {
+        #if !defined(DEBUG_RCVR_LINKSTATS)
+        rssiDBM = LPF_UplinkRSSI1.update(rssiDBM);
+        #endif
+        if (rssiDBM > 0) rssiDBM = 0;
+        // BetaFlight/iNav expect positive values for -dBm (e.g. -80dBm -> sent as 80)
+        // May be overwritten below if DEBUG_BF_LINK_STATS is set
+        CRSF::LinkStatistics.uplink_RSSI_2 = -rssiDBM;
+    }
+
+    SnrMean.add(Radio.LastPacketSNRRaw);
+
+    CRSF::LinkStatistics.active_antenna = antenna;
+    CRSF::LinkStatistics.uplink_SNR = SNR_DESCALE(Radio.LastPacketSNRRaw); // possibly overriden below
+    //CRSF::LinkStatistics.uplink_Link_quality = uplinkLQ; // handled in Tick
+    CRSF::LinkStatistics.rf_Mode = ExpressLRS_currAirRate_Modparams->enum_rate;
+    //DBGLN(CRSF::LinkStatistics.uplink_RSSI_1);
+    #if defined(DEBUG_BF_LINK_STATS)
+    CRSF::LinkStatistics.downlink_RSSI_1 = debug1;
+    CRSF::LinkStatistics.downlink_Link_quality = debug2;
+    CRSF::LinkStatistics.downlink_SNR = debug3;
+    CRSF::LinkStatistics.uplink_RSSI_2 = debug4;
+    #endif
+
+    #if defined(DEBUG_RCVR_LINKSTATS)
+    // DEBUG_RCVR_LINKSTATS gets full precision SNR, override the value
+    CRSF::LinkStatistics.uplink_SNR = Radio.LastPacketSNRRaw;
+    debugRcvrLinkstatsFhssIdx = FHSSgetCurrChannel();
+    #endif
+}
+
+void SetRFLinkRate(uint8_t index, bool bindMode) // Set speed of RF link
+{
+    expresslrs_mod_settings_s const *const ModParams = get_elrs_airRateConfig(index);
+    expresslrs_rf_pref_params_s const *const RFperf = get_elrs_RFperfParams(index);
+
+    // Binding always uses invertIQ
+    bool invertIQ = bindMode || (UID[5] & 0x01);
+
+    uint32_t interval = ModParams->interval;
+#if defined(DEBUG_FREQ_CORRECTION) && defined(RADIO_SX128X)
+    interval = interval * 12 / 10; // increase the packet interval by 20% to allow adding packet header
+#endif
+
+    hwTimer::updateInterval(interval);
+    PhaseLock.setInterval(interval);
+
+    FHSSsetActiveBand(!(ModParams->radio_type == RADIO_TYPE_LR1121_LORA_2G4) && !(ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_2G4),
+        ModParams->radio_type == RADIO_TYPE_LR1121_LORA_DUAL);
+
+    Radio.Config(ModParams->bw, ModParams->sf, ModParams->cr, FHSSgetInitialFreq(),
+                 ModParams->PreambleLen, invertIQ, ModParams->PayloadLength, 0
+#if defined(RADIO_SX128X)
+                 , uidMacSeedGet(), OtaCrcInitializer, (ModParams->radio_type == RADIO_TYPE_SX128x_FLRC)
+#endif
+#if defined(RADIO_LR1121)
+               , ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_900 || ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_2G4, (uint8_t)UID[5], (uint8_t)UID[4]
+#endif
+                 );
+
+#if defined(RADIO_LR1121)
+    if (FHSSuseDualBand)
+    {
+        Radio.Config(ModParams->bw2, ModParams->sf2, ModParams->cr2, FHSSgetInitialGeminiFreq(),
+                    ModParams->PreambleLen2, invertIQ, ModParams->PayloadLength, 0,
+                    ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_900 || ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_2G4,
+                    (uint8_t)UID[5], (uint8_t)UID[4], SX12XX_Radio_2);
+    }
+#endif
+
+    Radio.FuzzySNRThreshold = (RFperf->DynpowerSnrThreshUp == DYNPOWER_SNR_THRESH_NONE) ? 0 : (RFperf->DynpowerSnrThreshDn - RFperf->DynpowerSnrThreshUp);
+    OtaRepairSnrMin = (RFperf->DynpowerSnrThreshUp == DYNPOWER_SNR_THRESH_NONE) ? DYNPOWER_SNR_THRESH_NONE : (RFperf->DynpowerSnrThreshUp + OTA_REPAIR_SNR_MARGIN);
+
+    checkGeminiMode();
+    if (geminiMode)
+    {
+        Radio.SetFrequencyReg(FHSSgetInitialGeminiFreq(), SX12XX_Radio_2);
+    }
+
+    OtaUpdateSerializers(smWideOr8ch, ModParams->PayloadLength);
+    MspReceiver.setMaxPackageIndex(ELRS_MSP_MAX_PACKAGES);
+    MspReceiver.setWindowIndexBits(OtaIsFullRes ? ELRS8_MSP_INDEX_BITS : ELRS4_MSP_INDEX_BITS);
+    TelemetrySender.setMaxPackageIndex(OtaIsFullRes ? ELRS8_TELEMETRY_MAX_PACKAGES : ELRS4_TELEMETRY_MAX_PACKAGES);
+
+    // Wait for (11/10) 110% of time it takes to cycle through all freqs in FHSS table (in ms)
+    cycleInterval = ((uint32_t)11U * FHSSgetChannelCount() * ModParams->FHSShopInterval * interval) / (10U * 1000U);
+
+    ExpressLRS_currAirRate_Modparams = ModParams;
+    ExpressLRS_currAirRate_RFperfParams = RFperf;
+    ExpressLRS_nextAirRateIndex = index; // presumably we just handled this
+    telemBurstValid = false;
+    LQStats.reset();
+    resetAdaptiveHopping();
+}
+
+static bool ICACHE_RAM_ATTR HandleFHSS()
+{
+    uint8_t modresultFHSS = (OtaNonce + 1) % ExpressLRS_currAirRate_Modparams->FHSShopInterval;
+
+    if ((ExpressLRS_currAirRate_Modparams->FHSShopInterval == 0) || alreadyFHSS == true || InBindingMode || (modresultFHSS != 0) || (connectionState == disconnected))
+    {
+        return false;
+    }
+
+    alreadyFHSS = true;
+
+    if (geminiMode)
+    {
+        if ((((OtaNonce + 1)/ExpressLRS_currAirRate_Modparams->FHSShopInterval) % 2 == 0) || FHSSuseDualBand) // When in DualBand do not switch between radios.  The OTA modulation paramters and HighFreq/LowFreq Tx amps are set during Config.
+        {
+            Radio.SetFrequencyReg(FHSSgetNextFreq(), SX12XX_Radio_1);
+            Radio.SetFrequencyReg(FHSSgetGeminiFreq(), SX12XX_Radio_2);
+        }
+        else
+        {
+            // Write radio1 first. This optimises the SPI traffic order.
+            uint32_t freqRadio2 = FHSSgetNextFreq();
+            Radio.SetFrequencyReg(FHSSgetGeminiFreq(), SX12XX_Radio_1);
+            Radio.SetFrequencyReg(freqRadio2, SX12XX_Radio_2);
+        }
+    }
+    else
+    {
+        Radio.SetFrequencyReg(FHSSgetNextFreq());
+    }
+
+#if defined(RADIO_SX127X)
+    // SX127x radio has to reset receive mode after hopping
+    uint8_t modresultTLM = (OtaNonce + 1) % ExpressLRS_currTlmDenom;
+    if (modresultTLM != 0 || ExpressLRS_currTlmDenom == 1) // if we are about to send a tlm response don't bother going back to rx
+    {
+        Radio.RXnb();
+    }
+#endif
+#if defined(Regulatory_Domain_EU_CE_2400)
+    SetClearChannelAssessmentTime();
+#endif
+    return true;
+}
+
+void ICACHE_RAM_ATTR LinkStatsToOta(OTA_LinkStats_s * const ls)
+{
+    // The value in linkstatistics is "positivized" (inverted polarity)
+    // and must be inverted on the TX side. Positive values are used
+    // so save a bit to encode which antenna is in use
+    ls->uplink_RSSI_1 = CRSF::LinkStatistics.uplink_RSSI_1;
+    ls->uplink_RSSI_2 = CRSF::LinkStatistics.uplink_RSSI_2;
+    ls->antenna = antenna;
+    ls->modelMatch = connectionHasModelMatch;
+    ls->lq = CRSF::LinkStatistics.uplink_Link_quality;
+    ls->tlmConfirm = MspReceiver.GetCurrentConfirm() ? 1 : 0;
+#if defined(DEBUG_FREQ_CORRECTION)
+    ls->SNR = FreqCorrection * 127 / FreqCorrectionMax;
+#else
+    if (SnrMean.getCount())
+    {
+        ls->SNR = SnrMean.mean();
+    }
+    else
+    {
+        ls->SNR = SnrMean.previousMean();
+    }
+#endif
+}
+
+bool ICACHE_RAM_ATTR HandleSendTelemetryResponse()
+{
+    uint8_t modresult = (OtaNonce + 1) % ExpressLRS_currTlmDenom;
+
+    if ((connectionState == disconnected) || (ExpressLRS_currTlmDenom == 1) || (alreadyTLMresp == true) || (modresult != 0) || !teamraceHasModelMatch)
+    {
+        return false; // don't bother sending tlm if disconnected or TLM is off
+    }
+
+    // ESP requires word aligned buffer
+    WORD_ALIGNED_ATTR OTA_Packet_s otaPkt = {0};
+    WORD_ALIGNED_ATTR OTA_Packet_s otaPktGemini = {0};
+    alreadyTLMresp = true;
+    bool sendGeminiBuffer = false;
+
+    bool tlmQueued = false;
+    if (firmwareOptions.is_airport)
+    {
+        tlmQueued = apInputBuffer.size() > 0;
+    }
+    else
+    {
+        tlmQueued = TelemetrySender.IsActive();
+    }
+
+    if (NextTelemetryType == PACKET_TYPE_LINKSTATS || !tlmQueued)
+    {
+        otaPkt.std.type = PACKET_TYPE_LINKSTATS;
+
+        OTA_LinkStats_s * ls;
+
+        // Include some advanced telemetry in the extra space
+        // Note the use of `ul_link_stats.payload` vs just `payload`
+        if (OtaIsFullRes)
+        {
+            ls = &otaPkt.full.tlm_dl.ul_link_stats.stats;
+            otaPkt.full.tlm_dl.ul_link_stats.trueDiversityAvailable = isDualRadio();
+            otaPkt.full.tlm_dl.ul_link_stats.mspWindowed = 1;
+            otaPkt.full.tlm_dl.ul_link_stats.mspAck = MspReceiver.GetWindowAck();
+
+            otaPkt.full.tlm_dl.tlmConfirm = MspReceiver.GetCurrentConfirm() ? 1 : 0;
+
+            if (geminiMode)
+            {
+                sendGeminiBuffer = true;
+                WORD_ALIGNED_ATTR uint8_t tlmSenderDoubleBuffer[2 * sizeof(otaPkt.full.tlm_dl.ul_link_stats.payload)] = {0};
+
+                otaPkt.full.tlm_dl.packageIndex = TelemetrySender.GetCurrentPayload(tlmSenderDoubleBuffer, sizeof(tlmSenderDoubleBuffer));
+                memcpy(otaPkt.full.tlm_dl.ul_link_stats.payload, tlmSenderDoubleBuffer, sizeof(otaPkt.full.tlm_dl.ul_link_stats.payload));
+                LinkStatsToOta(ls);
+
+                otaPktGemini = otaPkt;
+                memcpy(otaPktGemini.full.tlm_dl.ul_link_stats.payload, &tlmSenderDoubleBuffer[sizeof(otaPktGemini.full.tlm_dl.ul_link_stats.payload)], sizeof(otaPktGemini.full.tlm_dl.ul_link_stats.payload));
+            }
+            else
+            {
+                otaPkt.full.tlm_dl.packageIndex = TelemetrySender.GetCurrentPayload(
+                    otaPkt.full.tlm_dl.ul_link_stats.payload,
+                    sizeof(otaPkt.full.tlm_dl.ul_link_stats.payload));
+                LinkStatsToOta(ls);
+            }
+        }
+        else
+        {
+            ls = &otaPkt.std.tlm_dl.ul_link_stats.stats;
+            otaPkt.std.tlm_dl.ul_link_stats.trueDiversityAvailable = isDualRadio();
+            otaPkt.std.tlm_dl.ul_link_stats.mspWindowed = 1;
+            otaPkt.std.tlm_dl.ul_link_stats.mspAck = MspReceiver.GetWindowAck();
+            LinkStatsToOta(ls);
+        }
+
+        NextTelemetryType = PACKET_TYPE_DATA;
+        // Start the count at 1 because the next will be DATA and doing +1 before checking
+        // against Max below is for some reason 10 bytes more code
+        telemetryBurstCount = 1;
+    }
+    else // if tlmQueued
+    {
+        if (telemetryBurstCount < telemetryBurstMax)
+        {
+            telemetryBurstCount++;
+        }
+        else
+        {
+            NextTelemetryType = PACKET_TYPE_LINKSTATS;
+        }
+
+        otaPkt.std.type = PACKET_TYPE_DATA;
+
+        if (firmwareOptions.is_airport)
+        {
+            OtaPackAirportData(&otaPkt, &apInputBuffer);
+        }
+        else
+        {
+            if (OtaIsFullRes)
+            {
+                otaPkt.full.tlm_dl.tlmConfirm = MspReceiver.GetCurrentConfirm() ? 1 : 0;
+
+                if (geminiMode)
+                {
+                    sendGeminiBuffer = true;
+                    WORD_ALIGNED_ATTR uint8_t tlmSenderDoubleBuffer[2 * sizeof(otaPkt.full.tlm_dl.payload)] = {0};
+
+                    otaPkt.full.tlm_dl.packageIndex = TelemetrySender.GetCurrentPayload(tlmSenderDoubleBuffer, sizeof(tlmSenderDoubleBuffer));
+                    memcpy(otaPkt.full.tlm_dl.payload, tlmSenderDoubleBuffer, sizeof(otaPkt.full.tlm_dl.payload));
+
+                    otaPktGemini = otaPkt;
+                    memcpy(otaPktGemini.full.tlm_dl.payload, &tlmSenderDoubleBuffer[sizeof(otaPktGemini.full.tlm_dl.payload)], sizeof(otaPktGemini.full.tlm_dl.payload));
+                }
+                else
+                {
+                    otaPkt.full.tlm_dl.packageIndex = TelemetrySender.GetCurrentPayload(otaPkt.full.tlm_dl.payload, sizeof(otaPkt.full.tlm_dl.payload));
+                }
+            }
+            else
+            {
+                otaPkt.std.tlm_dl.tlmConfirm = MspReceiver.GetCurrentConfirm() ? 1 : 0;
+
+                if (geminiMode)
+                {
+                    sendGeminiBuffer = true;
+                    WORD_ALIGNED_ATTR uint8_t tlmSenderDoubleBuffer[2 * sizeof(otaPkt.std.tlm_dl.payload)] = {0};
+
+                    otaPkt.std.tlm_dl.packageIndex = TelemetrySender.GetCurrentPayload(tlmSenderDoubleBuffer, sizeof(tlmSenderDoubleBuffer));
+                    memcpy(otaPkt.std.tlm_dl.payload, tlmSenderDoubleBuffer, sizeof(otaPkt.std.tlm_dl.payload));
+
+                    otaPktGemini = otaPkt;
+                    memcpy(otaPktGemini.std.tlm_dl.payload, &tlmSenderDoubleBuffer[sizeof(otaPktGemini.std.tlm_dl.payload)], sizeof(otaPktGemini.std.tlm_dl.payload));
+                }
+                else
+                {
+                    otaPkt.std.tlm_dl.packageIndex = TelemetrySender.GetCurrentPayload(otaPkt.std.tlm_dl.payload, sizeof(otaPkt.std.tlm_dl.payload));
+                }
+            }
+        }
+    }
+
+    OtaGeneratePacketCrc(&otaPkt);
+    if (sendGeminiBuffer)
+    {
+        OtaGeneratePacketCrc(&otaPktGemini);
+    }
+
+    SX12XX_Radio_Number_t transmittingRadio;
+    if (getRxForceTlmOff())
+    {
+        transmittingRadio = SX12XX_Radio_NONE;
+    }
+    else if (isDualRadio())
+    {
+        transmittingRadio = SX12XX_Radio_All;
+    }
+    else
+    {
+        transmittingRadio = Radio.GetLastSuccessfulPacketRadio();
+    }
+
+#if defined(Regulatory_Domain_EU_CE_2400)
+    transmittingRadio &= ChannelIsClear(transmittingRadio);   // weed out the radio(s) if channel in use
+#endif
+
+    if (!geminiMode && transmittingRadio == SX12XX_Radio_All) // If the receiver is in diversity mode, only send TLM on a single radio.
+    {
+        transmittingRadio = Radio.LastPacketRSSI > Radio.LastPacketRSSI2 ? SX12XX_Radio_1 : SX12XX_Radio_2; // Pick the radio with best rf connection to the tx.
+    }
+
+    // Gemini flips frequencies between radios on the rx side only.  This is to help minimise antenna cross polarization.
+    // The payloads need to be switch when this happens.
+    // GemX does not switch due to the time required to reconfigure the LR1121 params.
+    if (((OtaNonce + 1)/ExpressLRS_currAirRate_Modparams->FHSShopInterval) % 2 == 0 || !sendGeminiBuffer || FHSSuseDualBand)
+    {
+        Radio.TXnb((uint8_t*)&otaPkt, ExpressLRS_currAirRate_Modparams->PayloadLength, sendGeminiBuffer, (uint8_t*)&otaPktGemini, transmittingRadio);
+    }
+    else
+    {
+        Radio.TXnb((uint8_t*)&otaPktGemini, ExpressLRS_currAirRate_Modparams->PayloadLength, sendGeminiBuffer, (uint8_t*)&otaPkt, transmittingRadio);
+    }
+
+    if (transmittingRadio == SX12XX_Radio_NONE)
+    {
+        // No packet will be sent due to LBT / Telem forced off.
+        // Defer TXdoneCallback() to prepare for TLM when the IRQ is normally triggered.
+        deferISRExecutionMicros(ExpressLRS_currAirRate_RFperfParams->TOA, Radio.TXdoneCallback);
+    }
+
+    return true;
+}
+
+int32_t ICACHE_RAM_ATTR HandleFreqCorr(bool value, SX12XX_Radio_Number_t radio)
+{
+    int32_t tempFC = FreqCorrection;
+    if (radio == SX12XX_Radio_2)
+    {
+        tempFC = FreqCorrection_2;
+    }
+
+    if (value)
+    {
+        if (tempFC > FreqCorrectionMin)
+        {
+            tempFC--; // FREQ_STEP units
+            if (tempFC == FreqCorrectionMin)
+            {
+                DBGLN("Max -FreqCorrection reached!");
+            }
+        }
+    }
+    else
+    {
+        if (tempFC < FreqCorrectionMax)
+        {
+            tempFC++; // FREQ_STEP units
+            if (tempFC == FreqCorrectionMax)
+            {
+                DBGLN("Max +FreqCorrection reached!");
+            }
+        }
+    }
+
+    if (radio == SX12XX_Radio_1)
+    {
+        FreqCorrection = tempFC;
+    }
+    else
+    {
+        FreqCorrection_2 = tempFC;
+    }
+
+    return tempFC;
+}
+
+void ICACHE_RAM_ATTR updatePhaseLock()
+{
+    if (connectionState != disconnected && PFDloop.hasResult())
+    {
+        int32_t RawOffset = PFDloop.calcResult();
+        PhaseLock.update(RawOffset);
+        hwTimer::setFreqOffset(PhaseLock.getFreqOffset());
+        hwTimer::phaseShift(PhaseLock.getPhaseShift());
+
+        DBGVLN("%d:%d:%d:%d:%d", PhaseLock.getPhaseError(), RawOffset, PhaseLock.getFreqError(), hwTimer::getFreqOffset(), uplinkLQ);
+    }
+    else if (connectionState != disconnected)
+    {
+        PhaseLock.missed();
+    }
+
+    PFDloop.reset();
+}
+
+void ICACHE_RAM_ATTR HWtimerCallbackTick() // this is 180 out of phase with the other callback, occurs mid-packet reception
+{
+    ISR_PROFILE_TIMER(ISRPROF_TIMER_TICK);
+    updatePhaseLock();
+    OtaNonce++;
+
+    // if (!alreadyTLMresp && !alreadyFHSS && !LQCalc.currentIsSet()) // packet timeout AND didn't DIDN'T just hop or send TLM
+    // {
+    //     Radio.RXnb(); // put the radio cleanly back into RX in case of garbage data
+    // }
+
+
+    if (ExpressLRS_currAirRate_Modparams->numOfSends == 1)
+    {
+        // Save the LQ value before the inc() reduces it by 1
+        uplinkLQ = LQCalc.getLQ();
+    } else
+    if (!((OtaNonce - 1) % ExpressLRS_currAirRate_Modparams->numOfSends))
+    {
+        uplinkLQ = LQCalcDVDA.getLQ();
+        LQCalcDVDA.inc();
+    }
+
+    CRSF::LinkStatistics.uplink_Link_quality = uplinkLQ;
+    // Only advance the LQI period counter if we didn't send Telemetry this period
+    if (!alreadyTLMresp)
+    {
+        LQStats.inc(LQCalc.currentIsSet(), FHSSgetCurrChannel());
+        LQCalc.inc();
+    }
+
+    alreadyTLMresp = false;
+    alreadyFHSS = false;
+}
+
+void ICACHE_RAM_ATTR HWtimerCallbackTock()
+{
+    ISR_PROFILE_TIMER(ISRPROF_TIMER_TOCK);
+    PFDloop.intEvent(micros()); // our internal osc just fired
+
+    if (ExpressLRS_currAirRate_Modparams->numOfSends > 1 && !(OtaNonce % ExpressLRS_currAirRate_Modparams->numOfSends))
+    {
+        if (LQCalcDVDA.currentIsSet())
+        {
+            crsfRCFrameAvailable();
+            if (teamraceHasModelMatch)
+                servoNewChannelsAvailable();
+        }
+        else
+        {
+            crsfRCFrameMissed();
+        }
+    }
+    else if (ExpressLRS_currAirRate_Modparams->numOfSends == 1)
+    {
+        if (!LQCalc.currentIsSet())
+        {
+            crsfRCFrameMissed();
+        }
+    }
+
+    // For any serial drivers that need to send on a regular cadence (i.e. CRSF to betaflight)
+    sendImmediateRC();
+
+    if (!didFHSS)
+    {
+        HandleFHSS();
+    }
+    didFHSS = false;
+
+    updateDiversity();
+    tlmSent = HandleSendTelemetryResponse();
+
+    #if defined(DEBUG_RX_SCOREBOARD)
+    static bool lastPacketWasTelemetry = false;
+    if (!LQCalc.currentIsSet() && !lastPacketWasTelemetry)
+        DBGW(lastPacketCrcError ? '.' : '_');
+    lastPacketCrcError = false;
+    lastPacketWasTelemetry = tlmSent;
+    #endif
+}
+
+void LostConnection(bool resumeRx)
+{
+    DBGLN("lost conn fc=%d fo=%d", FreqCorrection, hwTimer::getFreqOffset());
+
+    setConnectionState(disconnected); //set lost connection
+    RXtimerState = tim_disconnected;
+    hwTimer::resetFreqOffset();
+    PhaseLock.reset();
+    GotConnectionMillis = 0;
+    uplinkLQ = 0;
+    LQCalc.reset();
+    LQCalcDVDA.reset();
+    alreadyTLMresp = false;
+    alreadyFHSS = false;
+
+    if (!InBindingMode)
+    {
+        if (hwTimer::running)
+        {
+            while(micros() - PFDloop.getIntEventTime() > 250); // time it just after the tock()
+            hwTimer::stop();
+        }
+        SetRFLinkRate(ExpressLRS_nextAirRateIndex, false); // also sets to initialFreq
+        // If not resumRx, Radio will be left in SX127x_OPMODE_STANDBY / SX1280_MODE_STDBY_XOSC
+        if (resumeRx)
+        {
+            Radio.RXnb();
+        }
+    }
+}
+
+void ICACHE_RAM_ATTR TentativeConnection(unsigned long now)
+{
+    PFDloop.reset();
+    setConnectionState(tentative);
+    connectionHasModelMatch = false;
+    RXtimerState = tim_disconnected;
+    DBGLN("tentative conn");
+    PhaseLock.resync();
+    SnrMean.reset();
+    RFmodeLastCycled = now; // give another 3 sec for lock to occur
+
+    OnRxTentativeConnection();
+
+    // The caller MUST call hwTimer::resume(). It is not done here because
+    // the timer ISR will fire immediately and preempt any other code
+}
+
+void GotConnection(unsigned long now)
+{
+    if (connectionState == connected)
+    {
+        return; // Already connected
+    }
+
+    LockRFmode = getRxLockOnFirstConnection();
+
+    setConnectionState(connected); //we got a packet, therefore no lost connection
+    RXtimerState = tim_tentative;
+    GotConnectionMillis = now;
+    OnRxGotConnection();
+
+    if (firmwareOptions.is_airport)
+    {
+        apInputBuffer.flush();
+        apOutputBuffer.flush();
+    }
+
+    DBGLN("got conn");
+}
+
+static void ICACHE_RAM_ATTR ProcessRfPacket_RC(OTA_Packet_s const * const otaPktPtr)
+{
+    // Must be fully connected to process RC packets, prevents processing RC
+    // during sync, where packets can be received before connection
+    if (connectionState != connected || SwitchModePending)
+        return;
+
+    bool telemetryConfirmValue = OtaUnpackChannelData(otaPktPtr, ChannelData, ExpressLRS_currTlmDenom);
+    TelemetrySender.ConfirmCurrentPayload(telemetryConfirmValue);
+
+    // No channels packets to the FC or PWM pins if no model match
+    if (connectionHasModelMatch)
+    {
+        if (ExpressLRS_currAirRate_Modparams->numOfSends == 1)
+        {
+            crsfRCFrameAvailable();
+            // teamrace is only checked for servos because the teamrace model select logic only runs
+            // when new frames are available, and will decide later if the frame will be forwarded
+            if (teamraceHasModelMatch)
+                servoNewChannelsAvailable();
+        }
+        else if (!LQCalcDVDA.currentIsSet())
+        {
+            LQCalcDVDA.add();
+        }
+        #if defined(DEBUG_RCVR_LINKSTATS)
+        debugRcvrLinkstatsPending = true;
+        #endif
+    }
+}
+
+static void ICACHE_RAM_ATTR ProcessRfPacket_MSP(OTA_Packet_s const * const otaPktPtr)
+{
+    uint8_t packageIndex;
+    uint8_t const * payload;
+    uint8_t dataLen;
+    bool tlmConfirm;
+    if (OtaIsFullRes)
+    {
+        packageIndex = otaPktPtr->full.msp_ul.packageIndex;
+        tlmConfirm = otaPktPtr->full.msp_ul.tlmConfirm;
+        payload = otaPktPtr->full.msp_ul.payload;
+        dataLen = sizeof(otaPktPtr->full.msp_ul.payload);
+    }
+    else
+    {
+        packageIndex = otaPktPtr->std.msp_ul.packageIndex;
+        tlmConfirm = otaPktPtr->std.msp_ul.tlmConfirm;
+        payload = otaPktPtr->std.msp_ul.payload;
+        dataLen = sizeof(otaPktPtr->std.msp_ul.payload);
+    }
+
+    // Windowed chunks carry the message parity in the tlmConfirm bit
+    bool const windowed = MspReceiver.IsWindowIndex(packageIndex);
+    if (!windowed)
+    {
+        if (getRxSerialProtocol() == PROTOCOL_MAVLINK)
+        {
+            TelemetrySender.ConfirmCurrentPayload(tlmConfirm);
+        }
+        else
+        {
+            packageIndex &= OtaIsFullRes ? ELRS8_TELEMETRY_MAX_PACKAGES : ELRS4_TELEMETRY_MAX_PACKAGES;
+        }
+    }
+
+    // Always examine MSP packets for bind information if in bind mode
+    // [1] is the package index, first packet of the MSP
+    if (InBindingMode && packageIndex == 1 && payload[0] == MSP_ELRS_BIND)
+    {
+        OnELRSBindMSP((uint8_t *)&payload[1]);
+        return;
+    }
+
+    // Must be fully connected to process MSP, prevents processing MSP
+    // during sync, where packets can be received before connection
+    if (connectionState == connected)
+    {
+        if (windowed)
+            MspReceiver.ReceiveWindowData(packageIndex, tlmConfirm, payload, dataLen);
+        else
+            MspReceiver.ReceiveData(packageIndex, payload, dataLen);
+    }
+}
+
+static void ICACHE_RAM_ATTR updateSwitchModePendingFromOta(uint8_t newSwitchMode)
+{
+    if (OtaSwitchModeCurrent == newSwitchMode)
+    {
+        // Cancel any switch if pending
+        SwitchModePending = 0;
+        return;
+    }
+
+    // One is added to the mode because SwitchModePending==0 means no switch pending
+    // and that's also a valid switch mode. The 1 is removed when this is handled.
+    // A negative SwitchModePending means not to switch yet
+    int8_t newSwitchModePending = -(int8_t)newSwitchMode - 1;
+
+    // Switch mode can be changed while disconnected
+    // OR there are two sync packets with the same new switch mode,
+    // as a "confirm". No RC packets are processed until
+    if (connectionState == disconnected ||
+        SwitchModePending == newSwitchModePending)
+    {
+        // Add one to the mode because SwitchModePending==0 means no switch pending
+        // and that's also a valid switch mode. The 1 is removed when this is handled
+        SwitchModePending = newSwitchMode + 1;
+    }
+    else
+    {
+        // Save the negative version of the new switch mode to compare
+        // against on the next SYNC packet, but do not switch yet
+        SwitchModePending = newSwitchModePending;
+    }
+}
+
+/**
+ * The RX chooses the blocked channels from what it receives and proposes them to
+ * the TX with a new generation number. The TX switches as soon as it gets the
+ * proposal and echoes the generation in its SYNC packets, and the RX switches when
+ * it sees it, so both ends are only out of step for the blocked hops.
+ */
+static void sendAdaptiveHoppingMask();
+
+static void ICACHE_RAM_ATTR updateAdaptiveHoppingFromSync(OTA_Sync_s const * const otaSync)
+{
+    if (afhProposal.isPending())
+    {
+        if (afhProposal.echoedBy(otaSync->afhGen))
+        {
+            FHSSswapChannelMask();
+            afhActiveGen = otaSync->afhGen;
+            afhProposal.finish();
+        }
+    }
+    else if (otaSync->afhGen != afhActiveGen)
+    {
+        afhGenMismatch = true;
+    }
+}
+
+/**
+ * Build the sequence for mask to be swapped in by the ISR when the TX echoes
+ * gen, and send it to the TX
+ */
+static void proposeAdaptiveHoppingMask(uint8_t const *mask, uint8_t gen, uint32_t now)
+{
+    if (!FHSSprepareChannelMask(mask))
+        return;
+    afhProposal.start(mask, gen, now);
+    sendAdaptiveHoppingMask();
+}
+
+static void sendAdaptiveHoppingMask()
+{
+    // Non CRSF, dest=a src=f -> adaptive hopping channel mask
+    uint8_t frame[CRSF_FRAME_SIZE(CRSF_EXT_FRAME_SIZE(1 + FHSS_CHANNEL_MASK_BYTES))];
+    frame[sizeof(crsf_ext_header_t)] = afhProposal.getGen();
+    memcpy(&frame[sizeof(crsf_ext_header_t) + 1], afhProposal.getMask(), FHSS_CHANNEL_MASK_BYTES);
+    CRSF::SetExtendedHeaderAndCrc(frame, CRSF_FRAMETYPE_COMMAND, CRSF_EXT_FRAME_SIZE(1 + FHSS_CHANNEL_MASK_BYTES),
+        (crsf_addr_e)'f', (crsf_addr_e)'a');
+    telemetry.AppendTelemetryPackage(frame);
+}
+
+/**
+ * Block the channels losing at least AFH_BLOCK_LOSS % of their packets, worst first,
+ * keeping the ones already blocked. Blocked channels are not visited so their loss
+ * does not change until they are all released again.
+ */
+static void buildAdaptiveHoppingMask(uint8_t *mask)
+{
+    uint32_t const freqCount = FHSSconfig->freq_count;
+    uint32_t blocked = 0;
+    memcpy(mask, FHSSchannelMask, FHSS_CHANNEL_MASK_BYTES);
+    for (uint32_t ch = 0; ch < freqCount; ++ch)
+        blocked += FHSSchannelIsBlocked(mask, ch);
+
+    while (blocked < freqCount / FHSS_MAX_BLOCKED_DIVISOR)
+    {
+        uint8_t worst = 0;
+        uint8_t worstLoss = 0;
+        for (uint32_t ch = 0; ch < freqCount; ++ch)
+        {
+            if (ch == sync_channel || FHSSchannelIsBlocked(mask, ch) || LQStats.getChannelPeriods(ch) < AFH_MIN_PERIODS)
+                continue;
+            uint8_t const loss = LQStats.getChannelLoss(ch);
+            if (loss >= AFH_BLOCK_LOSS && loss > worstLoss)
+            {
+                worst = ch;
+                worstLoss = loss;
+            }
+        }
+        if (worstLoss == 0)
+            break;
+        mask[worst / 8] |= 1 << (worst % 8);
+        ++blocked;
+    }
+}
+
+void updateAdaptiveHopping(uint32_t now)
+{
+    if (connectionState != connected || !FHSSusePrimaryFreqBand)
+    {
+        afhLastUpdate = now;
+        afhLastRelease = now;
+        return;
+    }
+
+    // Only one proposal in flight at a time. The frame carrying it can be lost, so it is sent
+    // again until the TX echoes it, and dropped after a few goes as the TX may not support it at all
+    switch (afhProposal.poll(now))
+    {
+    case afhWaiting:
+        return;
+    case afhResend:
+        sendAdaptiveHoppingMask();
+        return;
+    case afhGaveUp:
+        DBGLN("AFH gen %u not echoed", afhProposal.getGen());
+        return;
+    default:
+        break;
+    }
+
+    if (afhGenMismatch)
+    {
+        // The TX is using a mask this RX did not propose (or no longer has), put it back to ours.
+        // The generation is one bit, so the TX's is afhActiveGen ^ 1 and the new one is afhActiveGen
+        afhGenMismatch = false;
+        uint8_t mask[FHSS_CHANNEL_MASK_BYTES];
+        memcpy(mask, FHSSchannelMask, sizeof(mask));
+        proposeAdaptiveHoppingMask(mask, afhActiveGen, now);
+        return;
+    }
+
+    if (now - afhLastUpdate < AFH_UPDATE_INTERVAL)
+        return;
+    afhLastUpdate = now;
+
+    uint8_t mask[FHSS_CHANNEL_MASK_BYTES] = {0};
+    if (now - afhLastRelease >= AFH_RELEASE_INTERVAL)
+    {
+        afhLastRelease = now;
+        for (uint32_t ch = 0; ch < FHSSconfig->freq_count; ++ch)
+        {
+            if (FHSSchannelIsBlocked(FHSSchannelMask, ch))
+                LQStats.resetChannel(ch);
+        }
+    }
+    else
+    {
+        buildAdaptiveHoppingMask(mask);
+    }
+
+    if (memcmp(mask, FHSSchannelMask, sizeof(mask)) == 0)
+        return;
+
+    DBGLN("AFH propose gen %u", afhActiveGen ^ 1);
+    proposeAdaptiveHoppingMask(mask, afhActiveGen ^ 1, now);
+}
+
+static bool ICACHE_RAM_ATTR ProcessRfPacket_SYNC(uint32_t const now, OTA_Sync_s const * const otaSync)
+{
+    // Verify the first byte of the binding ID, which should always match
+    if (otaSync->UID4 != UID[4])
+        return false;
+
+    // The third byte will be XORed with inverse of the ModelId if ModelMatch is on
+    // Only require the first 18 bits of the UID to match to establish a connection
+    // but the last 6 bits must modelmatch before sending any data to the FC
+    if ((otaSync->UID5 & ~MODELMATCH_MASK) != (UID[5] & ~MODELMATCH_MASK))
+        return false;
+
+    LastSyncPacket = now;
+#if defined(DEBUG_RX_SCOREBOARD)
+    DBGW('s');
+#endif
+
+    OnRxSyncSettings(otaSync->otaProtocol, otaSync->geminiMode);
+
+    // Will change the packet air rate in loop() if this changes
+    ExpressLRS_nextAirRateIndex = enumRatetoIndex((expresslrs_RFrates_e)otaSync->rfRateEnum);
+    updateSwitchModePendingFromOta(otaSync->switchEncMode);
+    updateAdaptiveHoppingFromSync(otaSync);
+
+    // Update TLM ratio, should never be TLM_RATIO_STD/DISARMED, the TX calculates the correct value for the RX
+    expresslrs_tlm_ratio_e TLMrateIn = (expresslrs_tlm_ratio_e)(otaSync->newTlmRatio + (uint8_t)TLM_RATIO_NO_TLM);
+    uint8_t TlmDenom = TLMratioEnumToValue(TLMrateIn);
+    if (ExpressLRS_currTlmDenom != TlmDenom)
+    {
+        DBGLN("New TLMrate 1:%u", TlmDenom);
+        ExpressLRS_currTlmDenom = TlmDenom;
+        telemBurstValid = false;
+    }
+
+    // modelId = 0xff indicates modelMatch is disabled, the XOR does nothing in that case
+    uint8_t modelXor = (~getRxModelId()) & MODELMATCH_MASK;
+    bool modelMatched = otaSync->UID5 == (UID[5] ^ modelXor);
+    DBGVLN("MM %u=%u %d", otaSync->UID5, UID[5], modelMatched);
+
+    if (connectionState == disconnected
+        || OtaNonce != otaSync->nonce
+        || FHSSgetCurrIndex() != otaSync->fhssIndex
+        || connectionHasModelMatch != modelMatched)
+    {
+        //DBGLN("\r\n%ux%ux%u", OtaNonce, otaPktPtr->sync.nonce, otaPktPtr->sync.fhssIndex);
+        FHSSsetCurrIndex(otaSync->fhssIndex);
+        OtaNonce = otaSync->nonce;
+        TentativeConnection(now);
+        // connectionHasModelMatch must come after TentativeConnection, which resets it
+        connectionHasModelMatch = modelMatched;
+        return true;
+    }
+
+    return false;
+}
+
+bool ICACHE_RAM_ATTR ProcessRFPacket(SX12xxDriverCommon::rx_status const status)
+{
+    if (status != SX12xxDriverCommon::SX12XX_RX_OK)
+    {
+        DBGVLN("HW CRC error");
+        #if defined(DEBUG_RX_SCOREBOARD)
+            lastPacketCrcError = true;
+        #endif
+        return false;
+    }
+    uint32_t const beginProcessing = micros();
+
+    OTA_Packet_s * const otaPktPtr = (OTA_Packet_s * const)Radio.RXdataBuffer;
+    OTA_Packet_s * const otaPktPtrSecond = (OTA_Packet_s * const)Radio.RXdataBufferSecond;
+
+    // Only read this packet's SNR if it needs repairing, LastPacketSNRRaw is the previous good packet's
+    if (!OtaValidatePacketCrc(otaPktPtr) && !OtaRepairPacketCrc(otaPktPtr, Radio.GetLastPacketSNRRaw(Radio.GetProcessingPacketRadio())))
+    {
+        DBGVLN("CRC error");
+        #if defined(DEBUG_RX_SCOREBOARD)
+            lastPacketCrcError = true;
+        #endif
+        return false;
+    }
+
+    PFDloop.extEvent(beginProcessing + PACKET_TO_TOCK_SLACK);
+
+    doStartTimer = false;
+    unsigned long now = millis();
+
+    LastValidPacket = now;
+
+    Radio.CheckForSecondPacket();
+    if (Radio.hasSecondRadioGotData)
+    {
+        if (!OtaValidatePacketCrc(otaPktPtrSecond))
+        {
+            Radio.hasSecondRadioGotData = false;
+        }
+    }
+
+    switch (otaPktPtr->std.type)
+    {
+    case PACKET_TYPE_RCDATA: //Standard RC Data Packet
+        ProcessRfPacket_RC(otaPktPtr);
+        break;
+    case PACKET_TYPE_SYNC: //sync packet from master
+        doStartTimer = ProcessRfPacket_SYNC(now,
+            OtaIsFullRes ? &otaPktPtr->full.sync.sync : &otaPktPtr->std.sync)
+            && !InBindingMode;
+        break;
+    case PACKET_TYPE_DATA:
+        if (firmwareOptions.is_airport)
+        {
+            OtaUnpackAirportData(otaPktPtr, &apOutputBuffer);
+        }
+        else
+        {
+            ProcessRfPacket_MSP(otaPktPtr);
+        }
+        break;
+    default:
+        break;
+    }
+
+    // Store the LQ/RSSI/Antenna
+    Radio.GetLastPacketStats();
+    getRFlinkInfo();
+
+    // Adjusts FreqCorrection for RX freq offset
+    if (Radio.FrequencyErrorAvailable())
+    {
+    #if defined(RADIO_SX127X)
+        int32_t tempFreqCorrection = HandleFreqCorr(Radio.GetFrequencyErrorbool(Radio.GetProcessingPacketRadio()), Radio.GetProcessingPacketRadio());
+        // Teamp900 also needs to adjust its demood PPM
+        Radio.SetPPMoffsetReg(tempFreqCorrection, Radio.GetProcessingPacketRadio());
+
+        if (Radio.hasSecondRadioGotData)
+        {
+            SX12XX_Radio_Number_t secondRadio = Radio.GetProcessingPacketRadio() == SX12XX_Radio_1 ? SX12XX_Radio_2 : SX12XX_Radio_1;
+            tempFreqCorrection = HandleFreqCorr(Radio.GetFrequencyErrorbool(secondRadio), secondRadio);
+            Radio.SetPPMoffsetReg(tempFreqCorrection, secondRadio);
+        }
+    #else
+        HandleFreqCorr(Radio.GetFrequencyErrorbool(Radio.GetProcessingPacketRadio()), Radio.GetProcessingPacketRadio());
+
+        if (Radio.hasSecondRadioGotData)
+        {
+            SX12XX_Radio_Number_t secondRadio = Radio.GetProcessingPacketRadio() == SX12XX_Radio_1 ? SX12XX_Radio_2 : SX12XX_Radio_1;
+            HandleFreqCorr(Radio.GetFrequencyErrorbool(secondRadio), secondRadio);
+        }
+    #endif
+    }
+
+    // Received a packet, that's the definition of LQ
+    LQCalc.add();
+    // Extend sync duration since we've received a packet at this rate
+    // but do not extend it indefinitely
+    RFmodeCycleMultiplier = RFmodeCycleMultiplierSlow;
+
+#if defined(DEBUG_RX_SCOREBOARD)
+    if (otaPktPtr->std.type != PACKET_TYPE_SYNC) DBGW(connectionHasModelMatch ? 'R' : 'r');
+#endif
+
+    return true;
+}
+
+static bool ICACHE_RAM_ATTR RXdoneISR(SX12xxDriverCommon::rx_status const status)
+{
+    ISR_PROFILE(ISRPROF_RXDONE);
+    loopWakeFromISR();
+    if (LQCalc.currentIsSet() && connectionState == connected)
+    {
+        return false; // Already received a packet, do not run ProcessRFPacket() again.
+    }
+
+    if (ProcessRFPacket(status))
+    {
+        didFHSS = HandleFHSS();
+
+        if (doStartTimer)
+        {
+            doStartTimer = false;
+            hwTimer::resume(); // will throw an interrupt immediately
+        }
+
+        return true;
+    }
+    return false;
+}
+
+static void ICACHE_RAM_ATTR TXdoneISR()
+{
+    ISR_PROFILE(ISRPROF_TXDONE);
+    loopWakeFromISR();
+    Radio.RXnb();
+#if defined(Regulatory_Domain_EU_CE_2400)
+    SetClearChannelAssessmentTime();
+#endif
+#if defined(DEBUG_RX_SCOREBOARD)
+    DBGW('T');
+#endif
+}
+
+void updateTelemetryBurst()
+{
+    if (telemBurstValid)
+        return;
+    telemBurstValid = true;
+
+    uint16_t hz = 1000000 / ExpressLRS_currAirRate_Modparams->interval;
+    telemetryBurstMax = TLMBurstMaxForRateRatio(hz, ExpressLRS_currTlmDenom);
+
+    // Notify the sender to adjust its expected throughput
+    TelemetrySender.UpdateTelemetryRate(hz, ExpressLRS_currTlmDenom, telemetryBurstMax);
+}
+
+/* If not connected will rotate through the RF modes looking for sync
+ * and blink LED
+ */
+static void cycleRfMode(unsigned long now)
+{
+    if (connectionState == connected || connectionState == wifiUpdate || InBindingMode)
+        return;
+
+    // Actually cycle the RF mode if not LOCK_ON_FIRST_CONNECTION
+    if (LockRFmode == false && (now - RFmodeLastCycled) > (cycleInterval * RFmodeCycleMultiplier))
+    {
+        RFmodeLastCycled = now;
+        LastSyncPacket = now;           // reset this variable
+        SendLinkStatstoFCForcedSends = 2;
+        SetRFLinkRate(scanIndex % RATE_MAX, false); // switch between rates
+        LQCalc.reset100();
+        LQCalcDVDA.reset100();
+        // Display the current air rate to the user as an indicator something is happening
+        scanIndex++;
+        Radio.RXnb();
+        DBGLN("%u", ExpressLRS_currAirRate_Modparams->interval);
+
+        // Skip unsupported modes for hardware with only a single LR1121 or with a single RF path
+        while (!isSupportedRFRate(scanIndex % RATE_MAX))
+        {
+            DBGLN("Skip %u", get_elrs_airRateConfig(scanIndex % RATE_MAX)->interval);
+            scanIndex++;
+        }
+
+        // Switch to FAST_SYNC if not already in it (won't be if was just connected)
+        RFmodeCycleMultiplier = 1;
+    } // if time to switch RF mode
+}
+
+void updateSwitchMode()
+{
+    // Negative value means waiting for confirm of the new switch mode while connected
+    if (SwitchModePending <= 0)
+        return;
+
+    OtaUpdateSerializers((OtaSwitchMode_e)(SwitchModePending - 1), ExpressLRS_currAirRate_Modparams->PayloadLength);
+    SwitchModePending = 0;
+}
+
+
+void SetupRFLink(uint8_t initialIdx)
+{
+    Radio.RXdoneCallback = &RXdoneISR;
+    Radio.TXdoneCallback = &TXdoneISR;
+
+    // Start from the power on state so the link can be set up again
+    PFDloop.reset();
+    PhaseLock.reset();
+    TelemetrySender.ResetState();
+    MspReceiver.ResetState();
+    telemetryBurstCount = 0;
+    tlmSent = false;
+    NextTelemetryType = PACKET_TYPE_LINKSTATS;
+    LQCalc.reset100();
+    LQCalcDVDA.reset100();
+    uplinkLQ = 0;
+    LPF_UplinkRSSI0.reset();
+    LPF_UplinkRSSI1.reset();
+    SnrMean.reset();
+    afhLastUpdate = 0;
+    afhLastRelease = 0;
+    SwitchModePending = 0;
+    RXtimerState = tim_disconnected;
+    GotConnectionMillis = 0;
+    doStartTimer = false;
+    didFHSS = false;
+    alreadyFHSS = false;
+    alreadyTLMresp = false;
+    LastValidPacket = 0;
+    LastSyncPacket = 0;
+    SendLinkStatstoFCintervalLastSent = 0;
+    SendLinkStatstoFCForcedSends = 0;
+    RFmodeLastCycled = 0;
+    LockRFmode = false;
+
+    scanIndex = initialIdx;
+    for (int i=0 ; i<RATE_MAX ; i++)
+    {
+        if (isSupportedRFRate(scanIndex))
+        {
+            break;
+        }
+        scanIndex = (scanIndex + 1) % RATE_MAX;
+    }
+    SetRFLinkRate(scanIndex, false);
+    // Start slow on the selected rate to give it the best chance
+    // to connect before beginning rate cycling
+    RFmodeCycleMultiplier = RFmodeCycleMultiplierSlow / 2;
+}
+
+void UpdateConnectionState(uint32_t now)
+{
+    if ((connectionState != disconnected) && (ExpressLRS_currAirRate_Modparams->index != ExpressLRS_nextAirRateIndex)) // forced change
+    {
+        DBGLN("Req air rate change %u->%u", ExpressLRS_currAirRate_Modparams->index, ExpressLRS_nextAirRateIndex);
+        if (!isSupportedRFRate(ExpressLRS_nextAirRateIndex))
+        {
+            DBGLN("Mode %u not supported, ignoring", ExpressLRS_nextAirRateIndex);
+            ExpressLRS_nextAirRateIndex = ExpressLRS_currAirRate_Modparams->index;
+        }
+        LostConnection(true);
+        LastSyncPacket = now;           // reset this variable to stop rf mode switching and add extra time
+        RFmodeLastCycled = now;         // reset this variable to stop rf mode switching and add extra time
+        SendLinkStatstoFCintervalLastSent = 0;
+        SendLinkStatstoFCForcedSends = 2;
+    }
+
+    if (connectionState == tentative && (now - LastSyncPacket > ExpressLRS_currAirRate_RFperfParams->RxLockTimeoutMs))
+    {
+        DBGLN("Bad sync, aborting");
+        LostConnection(true);
+        RFmodeLastCycled = now;
+        LastSyncPacket = now;
+    }
+
+    cycleRfMode(now);
+
+    uint32_t localLastValidPacket = LastValidPacket; // Required to prevent race condition due to LastValidPacket getting updated from ISR
+    if ((connectionState == connected) && ((int32_t)ExpressLRS_currAirRate_RFperfParams->DisconnectTimeoutMs < (int32_t)(now - localLastValidPacket))) // check if we lost conn.
+    {
+        LostConnection(true);
+    }
+
+    if ((connectionState == tentative) && PhaseLock.isSettled() && (LQCalc.getLQRaw() > FHSSminLqForChaos(ExpressLRS_currAirRate_Modparams->FHSShopInterval))) //detects when we are connected
+    {
+        GotConnection(now);
+    }
+
+    if ((RXtimerState == tim_tentative) && PhaseLock.isLocked())
+    {
+        RXtimerState = tim_locked;
+        DBGLN("Timer locked");
+    }
+}
+
+#endif
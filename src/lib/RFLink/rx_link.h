@@ -0,0 +1,73 @@
+#pragma once
+
+#include "targets.h"
+#include "common.h"
+#include "LowPassFilter.h"
+#include "LQCALC.h"
+#include "PFD.h"
+#include "PLL.h"
+#include "stubborn_sender.h"
+#include "stubborn_receiver.h"
+
+/**
+ * The RX side of the RF link: packet handling, the tick/tock timer callbacks,
+ * FHSS, the telemetry downlink and the connection state machine.
+ *
+ * Anything that needs the RX config, the serial protocols or the devices is
+ * reached through the hooks in rxtx_intf.h, which rx_main.cpp implements.
+ */
+
+extern uint8_t antenna;
+extern uint8_t geminiMode;
+extern PFD PFDloop;
+extern PLL PhaseLock;
+
+extern StubbornSender TelemetrySender;
+extern StubbornReceiver MspReceiver;
+
+extern LQCALC<100> LQCalc;
+extern LQCALC<100> LQCalcDVDA;
+extern uint8_t uplinkLQ;
+extern LPF LPF_UplinkRSSI0;
+extern LPF LPF_UplinkRSSI1;
+
+extern uint8_t scanIndex;
+extern uint8_t ExpressLRS_nextAirRateIndex;
+extern int8_t SwitchModePending;
+extern RXtimerState_e RXtimerState;
+extern uint32_t LastValidPacket;
+extern uint32_t LastSyncPacket;
+extern uint32_t SendLinkStatstoFCintervalLastSent;
+extern uint8_t SendLinkStatstoFCForcedSends;
+
+extern uint32_t RFmodeLastCycled;
+extern uint8_t RFmodeCycleMultiplier;
+extern bool LockRFmode;
+
+#if defined(DEBUG_RCVR_LINKSTATS)
+extern bool debugRcvrLinkstatsPending;
+extern uint8_t debugRcvrLinkstatsFhssIdx;
+#endif
+
+/**
+ * @brief Set the radio callbacks and the first rate to scan, starting at initialIdx,
+ * and reset the link to disconnected. Radio.Begin() must have succeeded.
+ */
+void SetupRFLink(uint8_t initialIdx);
+
+/**
+ * @brief Connection state machine, called from the loop: rate changes requested
+ * by the TX, sync timeouts, rate cycling, lost connection and timer lock
+ */
+void UpdateConnectionState(uint32_t now);
+
+void SetRFLinkRate(uint8_t index, bool bindMode);
+void LostConnection(bool resumeRx);
+void getRFlinkInfo();
+
+void HWtimerCallbackTick();
+void HWtimerCallbackTock();
+
+void updateTelemetryBurst();
+void updateSwitchMode();
+void updateAdaptiveHopping(uint32_t now);
@@ -0,0 +1,988 @@
+#if defined(TARGET_TX) || defined(UNIT_TEST)
+
+#include "tx_link.h"
+#include "rxtx_intf.h"
+#include "CRSF.h"
+#include "CRSFHandset.h"
+#include "handset.h"
+#include "dynpower.h"
+#include "FHSS.h"
+#include "hwTimer.h"
+#include "ISRProfile.h"
+#include "logging.h"
+#include "LQCALC.h"
+#include "LQSTATS.h"
+#include "OTA.h"
+#include "deferred.h"
+#include "options.h"
+#include "SPSCFIFO.h"
+#include <atomic>
+
+#if defined(Regulatory_Domain_EU_CE_2400)
+#include "LBT.h"
+#endif
+#if defined(UNIT_TEST)
+#include "SX1280Driver.h"
+extern SX1280Driver Radio;
+#endif
+
+extern SPSCFIFO<AP_MAX_BUF_LEN> apInputBuffer;
+extern SPSCFIFO<AP_MAX_BUF_LEN> apOutputBuffer;
+
+//// MSP Data Handling ///////
+bool NextPacketIsMspData = false;  // if true the next packet will contain the msp data
+uint8_t packageIndexRadio1 = 0xFF;
+uint8_t packageIndexRadio2 = 0xFF;
+uint8_t tlmSenderDoubleBuffer[20] = {0};
+
+////////////SYNC PACKET/////////
+volatile uint8_t syncSpamCounter = 0;
+volatile uint8_t syncSpamCounterAfterRateChange = 0;
+uint32_t rfModeLastChangedMS = 0;
+uint32_t SyncPacketLastSent = 0;
+static enum { stbIdle, stbRequested, stbBoosting } syncTelemBoostState = stbIdle;
+
+volatile uint32_t LastTLMpacketRecvMillis = 0;
+bool commitInProgress = false;
+
+static LQCALC<25> LQCalc;
+// Generation of the adaptive hopping channel mask in use, echoed to the RX in the SYNC packet
+static uint8_t afhGen;
+// The loop builds the RX's proposed sequence and sets afhSwapPending last, the tock swaps to it
+static uint8_t afhNextGen;
+static volatile bool afhSwapPending;
+
+volatile bool busyTransmitting;
+// The next RC packet, loaded into the radio at TXdone for the tock to start
+static WORD_ALIGNED_ATTR OTA_Packet_s stagedPkt;
+volatile bool stagedPktReady;
+static uint8_t stagedPktNonce;
+static uint32_t stagedPktRCdataAt;
+static SX12XX_Radio_Number_t stagedPktRadio;
+
+uint8_t BindingSendCount;
+
+TxTlmRcvPhase_e TelemetryRcvPhase = ttrpTransmitting;
+StubbornReceiver TelemetryReceiver;
+StubbornSender MspSender;
+
+void ICACHE_RAM_ATTR LinkStatsFromOta(OTA_LinkStats_s * const ls)
+{
+  int8_t snrScaled = ls->SNR;
+  DynamicPower_TelemetryUpdate(snrScaled);
+
+  // Antenna is the high bit in the RSSI_1 value
+  // RSSI received is signed, inverted polarity (positive value = -dBm)
+  // OpenTX's value is signed and will display +dBm and -dBm properly
+  CRSF::LinkStatistics.uplink_RSSI_1 = -(ls->uplink_RSSI_1);
+  CRSF::LinkStatistics.uplink_RSSI_2 = -(ls->uplink_RSSI_2);
+  CRSF::LinkStatistics.uplink_Link_quality = ls->lq;
+#if defined(DEBUG_FREQ_CORRECTION)
+  // Don't descale the FreqCorrection value being send in SNR
+  CRSF::LinkStatistics.uplink_SNR = snrScaled;
+#else
+  CRSF::LinkStatistics.uplink_SNR = SNR_DESCALE(snrScaled);
+#endif
+  CRSF::LinkStatistics.active_antenna = ls->antenna;
+  connectionHasModelMatch = ls->modelMatch;
+  // -- downlink_SNR / downlink_RSSI is updated for any packet received, not just Linkstats
+  // -- uplink_TX_Power is updated when sending to the handset, so it updates when missing telemetry
+  // -- rf_mode is updated when we change rates
+  // -- downlink_Link_quality is updated before the LQ period is incremented
+  MspSender.ConfirmCurrentPayload(ls->tlmConfirm);
+}
+
+static void ICACHE_RAM_ATTR MspWindowFromOta(bool mspWindowed, bool parity, uint8_t ack)
+{
+  // RXs that do not set mspWindowed only take stop-and-wait MSP
+  if (mspWindowed)
+    MspSender.ConfirmWindow(parity, ack);
+  else
+    MspSender.SetPeerWindowed(false);
+}
+
+bool ICACHE_RAM_ATTR ProcessTLMpacket(SX12xxDriverCommon::rx_status const status)
+{
+  if (status != SX12xxDriverCommon::SX12XX_RX_OK)
+  {
+    DBGLN("TLM HW CRC error");
+    return false;
+  }
+
+  OTA_Packet_s * const otaPktPtr = (OTA_Packet_s * const)Radio.RXdataBuffer;
+  OTA_Packet_s * const otaPktPtrSecond = (OTA_Packet_s * const)Radio.RXdataBufferSecond;
+
+  // Only read this packet's SNR if it needs repairing, LastPacketSNRRaw is the previous good packet's
+  if (!OtaValidatePacketCrc(otaPktPtr) && !OtaRepairPacketCrc(otaPktPtr, Radio.GetLastPacketSNRRaw(Radio.GetProcessingPacketRadio())))
+  {
+    DBGLN("TLM crc error");
+    return false;
+  }
+
+  LastTLMpacketRecvMillis = millis();
+  LQCalc.add();
+
+  Radio.CheckForSecondPacket();
+  if (Radio.hasSecondRadioGotData)
+  {
+    if (!OtaValidatePacketCrc(otaPktPtrSecond))
+    {
+      Radio.hasSecondRadioGotData = false;
+    }
+  }
+
+  Radio.GetLastPacketStats();
+  CRSF::LinkStatistics.downlink_SNR = SNR_DESCALE(Radio.LastPacketSNRRaw);
+  CRSF::LinkStatistics.downlink_RSSI_1 = Radio.LastPacketRSSI;
+  CRSF::LinkStatistics.downlink_RSSI_2 = Radio.LastPacketRSSI2;
+
+  // Full res mode
+  if (OtaIsFullRes)
+  {
+    OTA_Packet8_s * const ota8 = (OTA_Packet8_s * const)otaPktPtr;
+    OTA_Packet8_s * const ota8Second = (OTA_Packet8_s * const)otaPktPtrSecond;
+    
+    switch (otaPktPtr->std.type)
+    {
+      case PACKET_TYPE_LINKSTATS:
+        LinkStatsFromOta(&ota8->tlm_dl.ul_link_stats.stats);
+        MspWindowFromOta(ota8->tlm_dl.ul_link_stats.mspWindowed, ota8->tlm_dl.ul_link_stats.stats.tlmConfirm, ota8->tlm_dl.ul_link_stats.mspAck);
+
+        // The Rx only has a single radio.  Force the Tx out of Gemini mode. 
+        if (getTxAntennaMode() == TX_RADIO_MODE_GEMINI && !ota8->tlm_dl.ul_link_stats.trueDiversityAvailable)
+        {
+            setTxAntennaMode(TX_RADIO_MODE_SWITCH);
+        }    
+
+        if (getTxAntennaMode() == TX_RADIO_MODE_GEMINI)
+        {
+            if (Radio.GetProcessingPacketRadio() == SX12XX_Radio_1)
+            {
+                packageIndexRadio1 = ota8->tlm_dl.packageIndex;
+                memcpy(tlmSenderDoubleBuffer, ota8->tlm_dl.ul_link_stats.payload, sizeof(ota8->tlm_dl.ul_link_stats.payload));
+            }
+            else
+            {
+                packageIndexRadio2 = ota8->tlm_dl.packageIndex;
+                memcpy(&tlmSenderDoubleBuffer[sizeof(ota8->tlm_dl.ul_link_stats.payload)], ota8->tlm_dl.ul_link_stats.payload, sizeof(ota8->tlm_dl.ul_link_stats.payload));
+            }
+
+            if (Radio.GetProcessingPacketRadio() == SX12XX_Radio_1 && Radio.hasSecondRadioGotData)
+            {
+                packageIndexRadio2 = ota8Second->tlm_dl.packageIndex;
+                memcpy(&tlmSenderDoubleBuffer[sizeof(ota8Second->tlm_dl.ul_link_stats.payload)], ota8Second->tlm_dl.ul_link_stats.payload, sizeof(ota8Second->tlm_dl.ul_link_stats.payload));
+            }
+            else if (Radio.GetProcessingPacketRadio() == SX12XX_Radio_2 && Radio.hasSecondRadioGotData)
+            {
+                packageIndexRadio1 = ota8Second->tlm_dl.packageIndex;
+                memcpy(tlmSenderDoubleBuffer, ota8Second->tlm_dl.ul_link_stats.payload, sizeof(ota8Second->tlm_dl.ul_link_stats.payload));
+            }
+            
+            if (packageIndexRadio1 == packageIndexRadio2 && packageIndexRadio1 != 0xFF)
+            {
+                TelemetryReceiver.ReceiveData(packageIndexRadio1 & ELRS8_TELEMETRY_MAX_PACKAGES, 
+                    tlmSenderDoubleBuffer, 2 * sizeof(ota8->tlm_dl.ul_link_stats.payload));
+                packageIndexRadio1 = 0xFF;
+                packageIndexRadio2 = 0xFF;
+            }
+        }
+        else
+        {
+            TelemetryReceiver.ReceiveData(ota8->tlm_dl.packageIndex & ELRS8_TELEMETRY_MAX_PACKAGES,
+                ota8->tlm_dl.ul_link_stats.payload, sizeof(ota8->tlm_dl.ul_link_stats.payload));
+        }
+        break;
+
+      case PACKET_TYPE_DATA:
+        if (firmwareOptions.is_airport)
+        {
+          OtaUnpackAirportData(otaPktPtr, &apOutputBuffer);
+        }
+        else
+        {
+            if (getTxAntennaMode() == TX_RADIO_MODE_GEMINI)
+            {
+                if (Radio.GetProcessingPacketRadio() == SX12XX_Radio_1)
+                {
+                    packageIndexRadio1 = ota8->tlm_dl.packageIndex;
+                    memcpy(tlmSenderDoubleBuffer, ota8->tlm_dl.payload, sizeof(ota8->tlm_dl.payload));
+                }
+                else
+                {
+                    packageIndexRadio2 = ota8->tlm_dl.packageIndex;
+                    memcpy(&tlmSenderDoubleBuffer[sizeof(ota8->tlm_dl.payload)], ota8->tlm_dl.payload, sizeof(ota8->tlm_dl.payload));
+                }
+
+                if (Radio.GetProcessingPacketRadio() == SX12XX_Radio_1 && Radio.hasSecondRadioGotData)
+                {
+                    packageIndexRadio2 = ota8Second->tlm_dl.packageIndex;
+                    memcpy(&tlmSenderDoubleBuffer[sizeof(ota8Second->tlm_dl.payload)], ota8Second->tlm_dl.payload, sizeof(ota8Second->tlm_dl.payload));
+                }
+                else if (Radio.GetProcessingPacketRadio() == SX12XX_Radio_2 && Radio.hasSecondRadioGotData)
+                {
+                    packageIndexRadio1 = ota8Second->tlm_dl.packageIndex;
+                    memcpy(tlmSenderDoubleBuffer, ota8Second->tlm_dl.payload, sizeof(ota8Second->tlm_dl.payload));
+                }
+                
+                if (packageIndexRadio1 == packageIndexRadio2 && packageIndexRadio1 != 0xFF)
+                {
+                    MspSender.ConfirmCurrentPayload(ota8->tlm_dl.tlmConfirm);
+                    TelemetryReceiver.ReceiveData(packageIndexRadio1 & ELRS8_TELEMETRY_MAX_PACKAGES, 
+                        tlmSenderDoubleBuffer, 2 * sizeof(ota8->tlm_dl.payload));
+                    packageIndexRadio1 = 0xFF;
+                    packageIndexRadio2 = 0xFF;
+                }
+            }
+            else
+            {
+                MspSender.ConfirmCurrentPayload(ota8->tlm_dl.tlmConfirm);
+                TelemetryReceiver.ReceiveData(ota8->tlm_dl.packageIndex & ELRS8_TELEMETRY_MAX_PACKAGES,
+                    ota8->tlm_dl.payload, sizeof(ota8->tlm_dl.payload));
+            }
+        }
+        break;
+    }
+  }
+  // Std res mode
+  else
+  {
+    switch (otaPktPtr->std.type)
+    {
+      case PACKET_TYPE_LINKSTATS:
+        LinkStatsFromOta(&otaPktPtr->std.tlm_dl.ul_link_stats.stats);
+        MspWindowFromOta(otaPktPtr->std.tlm_dl.ul_link_stats.mspWindowed, otaPktPtr->std.tlm_dl.ul_link_stats.stats.tlmConfirm, otaPktPtr->std.tlm_dl.ul_link_stats.mspAck);
+
+        // The Rx only has a single radio.  Force the Tx out of Gemini mode. 
+        if (getTxAntennaMode() == TX_RADIO_MODE_GEMINI && !otaPktPtr->std.tlm_dl.ul_link_stats.trueDiversityAvailable)
+        {
+            setTxAntennaMode(TX_RADIO_MODE_SWITCH);
+        }
+        break;
+
+      case PACKET_TYPE_DATA:
+        if (firmwareOptions.is_airport)
+        {
+          OtaUnpackAirportData(otaPktPtr, &apOutputBuffer);
+        }
+        else
+        {
+            if (getTxAntennaMode() == TX_RADIO_MODE_GEMINI)
+            {
+                if (Radio.GetProcessingPacketRadio() == SX12XX_Radio_1)
+                {
+                    packageIndexRadio1 = otaPktPtr->std.tlm_dl.packageIndex;
+                    memcpy(tlmSenderDoubleBuffer, otaPktPtr->std.tlm_dl.payload, sizeof(otaPktPtr->std.tlm_dl.payload));
+                }
+                else
+                {
+                    packageIndexRadio2 = otaPktPtr->std.tlm_dl.packageIndex;
+                    memcpy(&tlmSenderDoubleBuffer[sizeof(otaPktPtr->std.tlm_dl.payload)], otaPktPtr->std.tlm_dl.payload, sizeof(otaPktPtr->std.tlm_dl.payload));
+                }
+
+                if (Radio.GetProcessingPacketRadio() == SX12XX_Radio_1 && Radio.hasSecondRadioGotData)
+                {
+                    packageIndexRadio2 = otaPktPtrSecond->std.tlm_dl.packageIndex;
+                    memcpy(&tlmSenderDoubleBuffer[sizeof(otaPktPtrSecond->std.tlm_dl.payload)], otaPktPtrSecond->std.tlm_dl.payload, sizeof(otaPktPtrSecond->std.tlm_dl.payload));
+                }
+                else if (Radio.GetProcessingPacketRadio() == SX12XX_Radio_2 && Radio.hasSecondRadioGotData)
+                {
+                    packageIndexRadio1 = otaPktPtrSecond->std.tlm_dl.packageIndex;
+                    memcpy(tlmSenderDoubleBuffer, otaPktPtrSecond->std.tlm_dl.payload, sizeof(otaPktPtrSecond->std.tlm_dl.payload));
+                }
+                
+                if (packageIndexRadio1 == packageIndexRadio2 && packageIndexRadio1 != 0xFF)
+                {
+                    MspSender.ConfirmCurrentPayload(otaPktPtr->std.tlm_dl.tlmConfirm);
+                    TelemetryReceiver.ReceiveData(packageIndexRadio1 & ELRS4_TELEMETRY_MAX_PACKAGES, 
+                        tlmSenderDoubleBuffer, 2 * sizeof(otaPktPtr->std.tlm_dl.payload));
+                    packageIndexRadio1 = 0xFF;
+                    packageIndexRadio2 = 0xFF;
+                }
+            }
+            else
+            {
+                MspSender.ConfirmCurrentPayload(otaPktPtr->std.tlm_dl.tlmConfirm);
+                TelemetryReceiver.ReceiveData(otaPktPtr->std.tlm_dl.packageIndex & ELRS4_TELEMETRY_MAX_PACKAGES,
+                    otaPktPtr->std.tlm_dl.payload,
+                    sizeof(otaPktPtr->std.tlm_dl.payload));
+            }
+        }
+        break;
+    }
+  }
+
+  return true;
+}
+
+expresslrs_tlm_ratio_e ICACHE_RAM_ATTR UpdateTlmRatioEffective()
+{
+  expresslrs_tlm_ratio_e ratioConfigured = getTxTlm();
+  // default is suggested rate for TLM_RATIO_STD/TLM_RATIO_DISARMED
+  expresslrs_tlm_ratio_e retVal = ExpressLRS_currAirRate_Modparams->TLMinterval;
+  bool updateTelemDenom = true;
+
+  // TLM ratio is boosted until there is one complete sync cycle with no BoostRequest
+  if (syncTelemBoostState == stbBoosting)
+  {
+    syncTelemBoostState = stbIdle;
+  }
+
+  if (syncTelemBoostState == stbRequested)
+  {
+    syncTelemBoostState = stbBoosting;
+    // default to 1:2 telemetry ratio bump for non-wide modes and
+    // wide mode configured to 1:4
+    retVal = TLM_RATIO_1_2;
+
+    if (!OtaIsFullRes && getTxSwitchMode() == smWideOr8ch)
+    {
+      // avoid crossing the wide switch 7-bit to 6-bit boundary
+      if (ratioConfigured <= TLM_RATIO_1_8 || ratioConfigured == TLM_RATIO_DISARMED)
+      {
+        retVal = TLM_RATIO_1_8;
+      }
+    }
+  }
+  // If Armed, telemetry is disabled, otherwise use STD
+  else if (ratioConfigured == TLM_RATIO_DISARMED)
+  {
+    if (handset->IsArmed())
+    {
+      retVal = TLM_RATIO_NO_TLM;
+      // Avoid updating ExpressLRS_currTlmDenom until connectionState == disconnected
+      if (connectionState == connected)
+        updateTelemDenom = false;
+    }
+  }
+  else if (ratioConfigured != TLM_RATIO_STD)
+  {
+    retVal = ratioConfigured;
+  }
+
+  if (updateTelemDenom)
+  {
+    uint8_t newTlmDenom = TLMratioEnumToValue(retVal);
+    // Delay going into disconnected state when the TLM ratio increases
+    if (connectionState == connected && ExpressLRS_currTlmDenom > newTlmDenom)
+      LastTLMpacketRecvMillis = SyncPacketLastSent;
+    ExpressLRS_currTlmDenom = newTlmDenom;
+  }
+
+  return retVal;
+}
+
+void ICACHE_RAM_ATTR GenerateSyncPacketData(OTA_Sync_s * const syncPtr)
+{
+  const uint8_t SwitchEncMode = getTxSwitchMode();
+  const uint8_t Index = (syncSpamCounter) ? getTxRate() : ExpressLRS_currAirRate_Modparams->index;
+
+  if (syncSpamCounter)
+    --syncSpamCounter;
+
+  if (syncSpamCounterAfterRateChange && Index == ExpressLRS_currAirRate_Modparams->index)
+  {
+    --syncSpamCounterAfterRateChange;
+    if (connectionState == connected) // We are connected again after a rate change.  No need to keep spaming sync.
+      syncSpamCounterAfterRateChange = 0;
+  }
+
+  SyncPacketLastSent = millis();
+
+  expresslrs_tlm_ratio_e newTlmRatio = UpdateTlmRatioEffective();
+
+  syncPtr->fhssIndex = FHSSgetCurrIndex();
+  syncPtr->nonce = OtaNonce;
+  syncPtr->rfRateEnum = get_elrs_airRateConfig(Index)->enum_rate;
+  syncPtr->switchEncMode = SwitchEncMode;
+  syncPtr->newTlmRatio = newTlmRatio - TLM_RATIO_NO_TLM;
+  syncPtr->geminiMode = isDualRadio() && getTxAntennaMode() == TX_RADIO_MODE_GEMINI;
+  syncPtr->otaProtocol = getTxLinkMode();
+  syncPtr->afhGen = afhGen;
+  syncPtr->UID4 = UID[4];
+  syncPtr->UID5 = UID[5];
+
+  // For model match, the last byte of the binding ID is XORed with the inverse of the modelId
+  if (!InBindingMode && getTxModelMatch())
+  {
+    syncPtr->UID5 ^= (~CRSFHandset::getModelID()) & MODELMATCH_MASK;
+  }
+}
+
+void SetRFLinkRate(uint8_t index) // Set speed of RF link
+{
+  expresslrs_mod_settings_s const *const ModParams = get_elrs_airRateConfig(index);
+  expresslrs_rf_pref_params_s const *const RFperf = get_elrs_RFperfParams(index);
+  // Binding always uses invertIQ
+  bool invertIQ = InBindingMode || (UID[5] & 0x01);
+  OtaSwitchMode_e newSwitchMode = (OtaSwitchMode_e)getTxSwitchMode();
+
+  if ((ModParams == ExpressLRS_currAirRate_Modparams)
+    && (RFperf == ExpressLRS_currAirRate_RFperfParams)
+    && (OtaSwitchModeCurrent == newSwitchMode))
+    return;
+
+  DBGLN("set rate %u", index);
+  uint32_t interval = ModParams->interval;
+#if defined(DEBUG_FREQ_CORRECTION) && defined(RADIO_SX128X)
+  interval = interval * 12 / 10; // increase the packet interval by 20% to allow adding packet header
+#endif
+  hwTimer::updateInterval(interval);
+
+  FHSSsetActiveBand(!(ModParams->radio_type == RADIO_TYPE_LR1121_LORA_2G4) && !(ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_2G4),
+      ModParams->radio_type == RADIO_TYPE_LR1121_LORA_DUAL);
+
+  Radio.Config(ModParams->bw, ModParams->sf, ModParams->cr, FHSSgetInitialFreq(),
+               ModParams->PreambleLen, invertIQ, ModParams->PayloadLength, ModParams->interval
+#if defined(RADIO_SX128X)
+               , uidMacSeedGet(), OtaCrcInitializer, (ModParams->radio_type == RADIO_TYPE_SX128x_FLRC)
+#endif
+#if defined(RADIO_LR1121)
+               , (ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_900 || ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_2G4), (uint8_t)UID[5], (uint8_t)UID[4]
+#endif
+               );
+
+#if defined(RADIO_LR1121)
+  if (FHSSuseDualBand)
+  {
+    Radio.Config(ModParams->bw2, ModParams->sf2, ModParams->cr2, FHSSgetInitialGeminiFreq(),
+                ModParams->PreambleLen2, invertIQ, ModParams->PayloadLength, ModParams->interval,
+                (ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_900 || ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_2G4),
+                (uint8_t)UID[5], (uint8_t)UID[4], SX12XX_Radio_2);
+  }
+#endif
+
+  Radio.FuzzySNRThreshold = (RFperf->DynpowerSnrThreshUp == DYNPOWER_SNR_THRESH_NONE) ? 0 : (RFperf->DynpowerSnrThreshUp - RFperf->DynpowerSnrThreshDn);
+  OtaRepairSnrMin = (RFperf->DynpowerSnrThreshUp == DYNPOWER_SNR_THRESH_NONE) ? DYNPOWER_SNR_THRESH_NONE : (RFperf->DynpowerSnrThreshUp + OTA_REPAIR_SNR_MARGIN);
+
+  if ((isDualRadio() && getTxAntennaMode() == TX_RADIO_MODE_GEMINI) || FHSSuseDualBand) // Gemini mode
+  {
+    Radio.SetFrequencyReg(FHSSgetInitialGeminiFreq(), SX12XX_Radio_2);
+  }
+
+  // InitialFreq has been set, so lets also reset the FHSS Idx and Nonce.
+  FHSSsetCurrIndex(0);
+  OtaNonce = 0;
+  stagedPktReady = false;
+
+  OtaUpdateSerializers(newSwitchMode, ModParams->PayloadLength);
+  MspSender.setMaxPackageIndex(ELRS_MSP_MAX_PACKAGES);
+  MspSender.SetWindowIndexBits(OtaIsFullRes ? ELRS8_MSP_INDEX_BITS : ELRS4_MSP_INDEX_BITS);
+  TelemetryReceiver.setMaxPackageIndex(OtaIsFullRes ? ELRS8_TELEMETRY_MAX_PACKAGES : ELRS4_TELEMETRY_MAX_PACKAGES);
+
+  ExpressLRS_currAirRate_Modparams = ModParams;
+  ExpressLRS_currAirRate_RFperfParams = RFperf;
+  LQStats.reset();
+  FHSSapplyChannelMask(nullptr);
+  afhGen = 0;
+  afhSwapPending = false;
+  CRSF::LinkStatistics.rf_Mode = ModParams->enum_rate;
+
+  handset->setPacketInterval(interval * ExpressLRS_currAirRate_Modparams->numOfSends);
+  setConnectionState(disconnected);
+  rfModeLastChangedMS = millis();
+}
+
+static void ICACHE_RAM_ATTR HandleFHSS()
+{
+  uint8_t modresult = (OtaNonce + 1) % ExpressLRS_currAirRate_Modparams->FHSShopInterval;
+  // If the next packet should be on the next FHSS frequency, do the hop
+  if (!InBindingMode && modresult == 0)
+  {
+    // Gemini mode
+    // If using DualBand always set the correct frequency band to the radios.  The HighFreq/LowFreq Tx amp is set during config.
+    if ((isDualRadio() && getTxAntennaMode() == TX_RADIO_MODE_GEMINI) || FHSSuseDualBand)
+    {
+        // Optimises the SPI traffic order.
+        if (Radio.GetProcessingPacketRadio() == SX12XX_Radio_1)
+        {
+            uint32_t freqRadio = FHSSgetNextFreq();
+            Radio.SetFrequencyReg(FHSSgetGeminiFreq(), SX12XX_Radio_2);
+            Radio.SetFrequencyReg(freqRadio, SX12XX_Radio_1);
+        }
+        else
+        {
+            Radio.SetFrequencyReg(FHSSgetNextFreq(), SX12XX_Radio_1);
+            Radio.SetFrequencyReg(FHSSgetGeminiFreq(), SX12XX_Radio_2);
+        }
+    }
+    else
+    {
+      Radio.SetFrequencyReg(FHSSgetNextFreq());
+    }
+  }
+}
+
+void ICACHE_RAM_ATTR HandlePrepareForTLM()
+{
+  // If TLM enabled and next packet is going to be telemetry, start listening to have a large receive window (time-wise)
+  if (ExpressLRS_currTlmDenom != 1 && ((OtaNonce + 1) % ExpressLRS_currTlmDenom) == 0)
+  {
+    Radio.RXnb();
+    TelemetryRcvPhase = ttrpPreReceiveGap;
+  }
+}
+
+/***
+ * @return false if nothing should be sent, the handset has stopped sending RC data
+ * @param dontSendChannelData set if only sync and MSP packets should be sent
+ */
+static bool ICACHE_RAM_ATTR HandsetAllowsSend(bool &dontSendChannelData)
+{
+  // Do not send a stale channels packet to the RX if one has not been received from the handset
+  // *Do* send data if a packet has never been received from handset and the timer is running
+  // this is the case when bench testing and TXing without a handset
+  dontSendChannelData = false;
+  uint32_t lastRcData = handset->GetRCdataLastRecv();
+  if (lastRcData && (micros() - lastRcData > 1000000))
+  {
+    // The tx is in Mavlink mode and without a valid crsf or RC input.  Do not send stale or fake zero packet RC!
+    // Only send sync and MSP packets.
+    if (getTxLinkMode() == TX_MAVLINK_MODE)
+    {
+      dontSendChannelData = true;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+typedef enum : uint8_t {
+  tpkSyncSpam,
+  tpkSync,
+  tpkAirport,
+  tpkData,
+  tpkRCdata
+} txPacketKind_e;
+
+// The slot the next regular sync goes in, see NextPacketKind()
+static uint8_t syncSlot;
+
+/***
+ * @brief Which packet BuildRCdataPacket() builds for nonce, without building it
+ */
+static txPacketKind_e ICACHE_RAM_ATTR NextPacketKind(uint8_t const nonce, bool dontSendChannelData)
+{
+  uint32_t const now = millis();
+  const bool isTlmDisarmed = getTxTlm() == TLM_RATIO_DISARMED;
+  uint32_t SyncInterval = (connectionState == connected && !isTlmDisarmed) ? ExpressLRS_currAirRate_RFperfParams->SyncPktIntervalConnected : ExpressLRS_currAirRate_RFperfParams->SyncPktIntervalDisconnected;
+  bool skipSync = InBindingMode ||
+    // TLM_RATIO_DISARMED keeps sending sync packets even when armed until the RX stops sending telemetry and the TLM=Off has taken effect
+    (isTlmDisarmed && handset->IsArmed() && (ExpressLRS_currTlmDenom == 1));
+
+  uint8_t NonceFHSSresult = nonce % ExpressLRS_currAirRate_Modparams->FHSShopInterval;
+
+  // Sync spam only happens on slot 1 and 2 and can't be disabled
+  if ((syncSpamCounter || (syncSpamCounterAfterRateChange && FHSSonSyncChannel())) && (NonceFHSSresult == 1 || NonceFHSSresult == 2))
+    return tpkSyncSpam;
+  // Regular sync rotates through 4x slots, twice on each slot, and telemetry pushes it to the next slot up
+  // But only on the sync FHSS channel and with a timed delay between them
+  if ((!skipSync) && ((syncSlot / 2) <= NonceFHSSresult) && (now - SyncPacketLastSent > SyncInterval) && FHSSonSyncChannel())
+    return tpkSync;
+  if (firmwareOptions.is_airport)
+    return tpkAirport;
+  if ((NextPacketIsMspData && MspSender.IsActive()) || dontSendChannelData)
+    return tpkData;
+  return tpkRCdata;
+}
+
+/***
+ * @brief Build the packet for the current OtaNonce, with its CRC
+ */
+static void ICACHE_RAM_ATTR BuildRCdataPacket(OTA_Packet_s * const otaPktPtr, bool dontSendChannelData)
+{
+  OTA_Packet_s &otaPkt = *otaPktPtr;
+
+  switch (NextPacketKind(OtaNonce, dontSendChannelData))
+  {
+  case tpkSyncSpam:
+    otaPkt.std.type = PACKET_TYPE_SYNC;
+    GenerateSyncPacketData(OtaIsFullRes ? &otaPkt.full.sync.sync : &otaPkt.std.sync);
+    syncSlot = 0; // reset the sync slot in case the new rate (after the syncspam) has a lower FHSShopInterval
+    break;
+  case tpkSync:
+    otaPkt.std.type = PACKET_TYPE_SYNC;
+    GenerateSyncPacketData(OtaIsFullRes ? &otaPkt.full.sync.sync : &otaPkt.std.sync);
+    syncSlot = (syncSlot + 1) % (ExpressLRS_currAirRate_Modparams->FHSShopInterval * 2);
+    break;
+  case tpkAirport:
+    OtaPackAirportData(&otaPkt, &apInputBuffer);
+    break;
+  case tpkData:
+    otaPkt.std.type = PACKET_TYPE_DATA;
+    if (OtaIsFullRes)
+    {
+      otaPkt.full.msp_ul.packageIndex = MspSender.GetCurrentPayload(
+        otaPkt.full.msp_ul.payload,
+        sizeof(otaPkt.full.msp_ul.payload));
+      // Windowed chunks carry the message parity, the RC packets still carry the telemetry confirm
+      if (MspSender.IsWindowed())
+        otaPkt.full.msp_ul.tlmConfirm = MspSender.GetCurrentParity();
+      else if (getTxLinkMode() == TX_MAVLINK_MODE)
+        otaPkt.full.msp_ul.tlmConfirm = TelemetryReceiver.GetCurrentConfirm();
+    }
+    else
+    {
+      otaPkt.std.msp_ul.packageIndex = MspSender.GetCurrentPayload(
+        otaPkt.std.msp_ul.payload,
+        sizeof(otaPkt.std.msp_ul.payload));
+      // Windowed chunks carry the message parity, the RC packets still carry the telemetry confirm
+      if (MspSender.IsWindowed())
+        otaPkt.std.msp_ul.tlmConfirm = MspSender.GetCurrentParity();
+      else if (getTxLinkMode() == TX_MAVLINK_MODE)
+        otaPkt.std.msp_ul.tlmConfirm = TelemetryReceiver.GetCurrentConfirm();
+    }
+
+    // send channel data next so the channel messages also get sent during msp transmissions
+    NextPacketIsMspData = false;
+    // counter can be increased even for normal msp messages since it's reset if a real bind message should be sent
+    BindingSendCount++;
+    // If not in TlmBurst, request a sync packet soon to trigger higher download bandwidth for reply
+    if (syncTelemBoostState == stbIdle)
+      syncSpamCounter = 1;
+    syncTelemBoostState = stbRequested;
+    break;
+  case tpkRCdata:
+    // always enable msp after a channel package since the slot is only used if MspSender has data to send
+    NextPacketIsMspData = true;
+
+    OtaPackChannelData(&otaPkt, ChannelData, TelemetryReceiver.GetCurrentConfirm(), ExpressLRS_currTlmDenom);
+    break;
+  }
+
+  ///// Next, Calculate the CRC and put it into the buffer /////
+  OtaGeneratePacketCrc(&otaPkt);
+}
+
+static SX12XX_Radio_Number_t ICACHE_RAM_ATTR SelectTransmittingRadio(uint8_t const nonce)
+{
+  SX12XX_Radio_Number_t transmittingRadio = Radio.GetLastSuccessfulPacketRadio();
+
+  if (isDualRadio())
+  {
+    switch (getTxAntennaMode())
+    {
+    case TX_RADIO_MODE_GEMINI:
+      transmittingRadio = SX12XX_Radio_All; // Gemini mode
+      break;
+    case TX_RADIO_MODE_ANT_1:
+      transmittingRadio = SX12XX_Radio_1; // Single antenna tx and true diversity rx for tlm receiption.
+      break;
+    case TX_RADIO_MODE_ANT_2:
+      transmittingRadio = SX12XX_Radio_2; // Single antenna tx and true diversity rx for tlm receiption.
+      break;
+    case TX_RADIO_MODE_SWITCH:
+      if(nonce%2==0)   transmittingRadio = SX12XX_Radio_1; // Single antenna tx and true diversity rx for tlm receiption.
+      else   transmittingRadio = SX12XX_Radio_2; // Single antenna tx and true diversity rx for tlm receiption.
+      break;
+    default:
+      break;
+    }
+  }
+
+  return transmittingRadio;
+}
+
+/***
+ * @brief Build the packet for the next tock and load it into the radio, called at TXdone so
+ * the tock only has to start the TX. The FIFO is shared with RX, so not before a telemetry slot.
+ * Only RC data is staged, and it moves nothing on until the tock sends it: the tock can still
+ * drop it and build the packet itself.
+ */
+static void ICACHE_RAM_ATTR StageNextPacket()
+{
+  bool dontSendChannelData;
+  if (commitInProgress || !HandsetAllowsSend(dontSendChannelData))
+  {
+    return;
+  }
+
+  // Built for the nonce the tock will send it with, after it advances OtaNonce
+  uint8_t const nonce = OtaNonce + (InBindingMode ? 0 : 1);
+  if (NextPacketKind(nonce, dontSendChannelData) != tpkRCdata)
+  {
+    return;
+  }
+  memset(&stagedPkt, 0, sizeof(stagedPkt));
+  OtaPrepareChannelData(&stagedPkt, ChannelData, TelemetryReceiver.GetCurrentConfirm(), ExpressLRS_currTlmDenom, nonce);
+  OtaGenerateRCdataPacketCrc(&stagedPkt, nonce);
+  stagedPktRadio = SelectTransmittingRadio(nonce);
+  stagedPktNonce = nonce;
+  stagedPktRCdataAt = handset->GetRCdataLastRecv();
+
+  Radio.TXnbLoad((uint8_t*)&stagedPkt, ExpressLRS_currAirRate_Modparams->PayloadLength, false, (uint8_t*)&stagedPkt, stagedPktRadio);
+  stagedPktReady = true;
+}
+
+/***
+ * @param staged send the staged packet, the PA has been enabled for it
+ */
+void ICACHE_RAM_ATTR SendRCdataToRF(bool staged, bool dontSendChannelData)
+{
+  busyTransmitting = true;
+
+  if (staged)
+  {
+    if (handset->GetRCdataLastRecv() != stagedPktRCdataAt)
+    {
+      // Newer channels came in since it was staged, they go in the same packet
+      OtaPrepareChannelData(&stagedPkt, ChannelData, TelemetryReceiver.GetCurrentConfirm(), ExpressLRS_currTlmDenom, stagedPktNonce);
+      OtaGenerateRCdataPacketCrc(&stagedPkt, stagedPktNonce);
+      Radio.TXnb((uint8_t*)&stagedPkt, ExpressLRS_currAirRate_Modparams->PayloadLength, false, (uint8_t*)&stagedPkt, stagedPktRadio);
+    }
+    else
+    {
+      Radio.TXnbStart();
+    }
+    // Now it is sent, move on as BuildRCdataPacket() does
+    OtaCommitChannelData();
+    NextPacketIsMspData = true;
+    return;
+  }
+
+  // ESP requires word aligned buffer
+  WORD_ALIGNED_ATTR OTA_Packet_s otaPkt = {0};
+  BuildRCdataPacket(&otaPkt, dontSendChannelData);
+  SX12XX_Radio_Number_t transmittingRadio = SelectTransmittingRadio(OtaNonce);
+
+#if defined(Regulatory_Domain_EU_CE_2400)
+  transmittingRadio &= ChannelIsClear(transmittingRadio);   // weed out the radio(s) if channel in use
+
+  if (transmittingRadio == SX12XX_Radio_NONE)
+  {
+    // No packet will be sent due to LBT.
+    // Defer TXdoneCallback() to prepare for TLM when the IRQ is normally triggered.
+    deferISRExecutionMicros(ExpressLRS_currAirRate_RFperfParams->TOA, Radio.TXdoneCallback);
+  }
+  else
+#endif
+  {
+    Radio.TXnb((uint8_t*)&otaPkt, ExpressLRS_currAirRate_Modparams->PayloadLength, false, (uint8_t*)&otaPkt, transmittingRadio);
+  }
+}
+
+void ICACHE_RAM_ATTR nonceAdvance()
+{
+  OtaNonce++;
+  if ((OtaNonce + 1) % ExpressLRS_currAirRate_Modparams->FHSShopInterval == 0)
+  {
+    ++FHSSptr;
+  }
+}
+
+/*
+ * Called as the TOCK timer ISR when there is a CRSF connection from the handset
+ */
+void ICACHE_RAM_ATTR timerCallback()
+{
+  ISR_PROFILE_TIMER(ISRPROF_TIMER_TOCK);
+  if (afhSwapPending)
+  {
+    std::atomic_signal_fence(std::memory_order_acquire);
+    FHSSswapChannelMask();
+    afhGen = afhNextGen;
+    afhSwapPending = false;
+  }
+
+  // A staged packet is only good for the nonce it was built for
+  uint8_t const sendNonce = OtaNonce + (InBindingMode ? 0 : 1);
+  bool staged = stagedPktReady && stagedPktNonce == sendNonce;
+  stagedPktReady = false;
+
+  /* If we are busy writing to EEPROM (committing config changes) then we just advance the nonces, i.e. no SPI traffic */
+  if (commitInProgress)
+  {
+    nonceAdvance();
+    return;
+  }
+
+  // Sync OpenTX to this point
+  if (!(OtaNonce % ExpressLRS_currAirRate_Modparams->numOfSends))
+  {
+    handset->JustSentRFpacket();
+  }
+
+  // Do not transmit or advance FHSS/Nonce until in disconnected/connected state
+  if (connectionState == awaitingModelId)
+    return;
+
+  bool dontSendChannelData;
+  bool const allowSend = HandsetAllowsSend(dontSendChannelData);
+  // The staged packet only needs the TX started, so enable the PA now to let it settle
+  // while the tock catches up, as it did while the packet was written to the radio.
+  // The loop can have made a sync or MSP data due since it was staged, that goes first.
+  staged = staged && allowSend && !dontSendChannelData && TelemetryRcvPhase != ttrpPreReceiveGap &&
+           NextPacketKind(sendNonce, dontSendChannelData) == tpkRCdata;
+  if (staged)
+  {
+    Radio.TXnbEnablePA();
+  }
+
+  // Tx Antenna Diversity
+  if ((OtaNonce % ExpressLRS_currAirRate_Modparams->numOfSends == 0 || // Swicth with new packet data
+      OtaNonce % ExpressLRS_currAirRate_Modparams->numOfSends == ExpressLRS_currAirRate_Modparams->numOfSends / 2) && // Swicth in the middle of DVDA sends
+      TelemetryRcvPhase == ttrpTransmitting) // Only switch when transmitting.  A diversity rx will send tlm back on the best antenna.  So dont switch away from it.
+  {
+    switchDiversityAntennas();
+  }
+
+  // Nonce advances on every timer tick
+  if (!InBindingMode)
+    OtaNonce++;
+
+  // If HandleTLM has started Receive mode, TLM packet reception should begin shortly
+  // Skip transmitting on this slot
+  if (TelemetryRcvPhase == ttrpPreReceiveGap)
+  {
+    TelemetryRcvPhase = ttrpExpectingTelem;
+#if defined(Regulatory_Domain_EU_CE_2400)
+    // Use downlink LQ for LBT success ratio instead for EU/CE reg domain
+    CRSF::LinkStatistics.downlink_Link_quality = LBTSuccessCalc.getLQ();
+#else
+    CRSF::LinkStatistics.downlink_Link_quality = LQCalc.getLQ();
+#endif
+    LQStats.inc(LQCalc.currentIsSet(), FHSSgetCurrChannel());
+    LQCalc.inc();
+    return;
+  }
+  else if (TelemetryRcvPhase == ttrpExpectingTelem && !LQCalc.currentIsSet())
+  {
+    // Indicate no telemetry packet received to the DP system
+    DynamicPower_TelemetryUpdate(DYNPOWER_UPDATE_MISSED);
+  }
+
+  TelemetryRcvPhase = ttrpTransmitting;
+
+  if (allowSend)
+  {
+    SendRCdataToRF(staged, dontSendChannelData);
+  }
+}
+
+static bool ICACHE_RAM_ATTR RXdoneISR(SX12xxDriverCommon::rx_status const status)
+{
+  ISR_PROFILE(ISRPROF_RXDONE);
+  // busyTransmitting is required here to prevent accidental rxdone IRQs due to interference triggering RXdoneISR.
+  if (LQCalc.currentIsSet() || busyTransmitting)
+  {
+    return false; // Already received tlm, do not run ProcessTLMpacket() again.
+  }
+
+  bool packetSuccessful = ProcessTLMpacket(status);
+#if defined(Regulatory_Domain_EU_CE_2400)
+  if (packetSuccessful)
+  {
+    SetClearChannelAssessmentTime();
+  }
+#endif
+
+  return packetSuccessful;
+}
+
+static void ICACHE_RAM_ATTR TXdoneISR()
+{
+  ISR_PROFILE(ISRPROF_TXDONE);
+  if (!busyTransmitting)
+  {
+    return; // Already finished transmission and do not call HandleFHSS() a second time, which may hop the frequency!
+  }
+
+  if (connectionState != awaitingModelId)
+  {
+    HandleFHSS();
+    HandlePrepareForTLM();
+#if defined(Regulatory_Domain_EU_CE_2400)
+    if (TelemetryRcvPhase != ttrpPreReceiveGap)
+    {
+      // Start RX for Listen Before Talk early because it takes about 100us
+      // from RX enable to valid instant RSSI values are returned.
+      // If rx was already started by TLM prepare above, this call will let RX
+      // continue as normal.
+      SetClearChannelAssessmentTime();
+    }
+#else
+    // Not with LBT, which has to check the channel right before the TX
+    if (TelemetryRcvPhase != ttrpPreReceiveGap)
+    {
+      StageNextPacket();
+    }
+#endif // non-CE
+  }
+  busyTransmitting = false;
+}
+
+void UpdateConnectDisconnectStatus()
+{
+  // Number of telemetry packets which can be lost in a row before going to disconnected state
+  constexpr unsigned RX_LOSS_CNT = 5;
+  // Must be at least 512ms and +2 to account for any rounding down and partial millis()
+  const uint32_t msConnectionLostTimeout = std::max((uint32_t)512U,
+    (uint32_t)ExpressLRS_currTlmDenom * ExpressLRS_currAirRate_Modparams->interval / (1000U / RX_LOSS_CNT)
+    ) + 2U;
+  // Capture the last before now so it will always be <= now
+  const uint32_t lastTlmMillis = LastTLMpacketRecvMillis;
+  const uint32_t now = millis();
+  if (lastTlmMillis && ((now - lastTlmMillis) <= msConnectionLostTimeout))
+  {
+    if (connectionState != connected)
+    {
+      setConnectionState(connected);
+      CRSFHandset::ForwardDevicePings = true;
+      DBGLN("got downlink conn");
+
+      apInputBuffer.flush();
+      apOutputBuffer.flush();
+      OnDownlinkConnected();
+    }
+  }
+  // If past RX_LOSS_CNT, or in awaitingModelId state for longer than DisconnectTimeoutMs, go to disconnected
+  else if (connectionState == connected ||
+    (connectionState == awaitingModelId && (now - rfModeLastChangedMS) > ExpressLRS_currAirRate_RFperfParams->DisconnectTimeoutMs))
+  {
+    setConnectionState(disconnected);
+    connectionHasModelMatch = true;
+    CRSFHandset::ForwardDevicePings = false;
+  }
+}
+
+void OnAdaptiveHoppingProposal(uint8_t const *payload)
+{
+  if (!afhSwapPending && FHSSprepareChannelMask(&payload[1]))
+  {
+    afhNextGen = payload[0] & 1;
+    std::atomic_signal_fence(std::memory_order_release);
+    afhSwapPending = true;
+  }
+}
+
+void SetupRFLink()
+{
+  Radio.RXdoneCallback = &RXdoneISR;
+  Radio.TXdoneCallback = &TXdoneISR;
+
+  // Start from the power on state so the link can be set up again
+  NextPacketIsMspData = false;
+  packageIndexRadio1 = 0xFF;
+  packageIndexRadio2 = 0xFF;
+  syncSpamCounter = 0;
+  syncSpamCounterAfterRateChange = 0;
+  rfModeLastChangedMS = 0;
+  SyncPacketLastSent = 0;
+  syncTelemBoostState = stbIdle;
+  syncSlot = 0;
+  LastTLMpacketRecvMillis = 0;
+  commitInProgress = false;
+  LQCalc.reset100();
+  afhGen = 0;
+  afhSwapPending = false;
+  busyTransmitting = false;
+  stagedPktReady = false;
+  BindingSendCount = 0;
+  TelemetryRcvPhase = ttrpTransmitting;
+  TelemetryReceiver.ResetState();
+  MspSender.ResetState();
+}
+
+#endif // TARGET_TX || UNIT_TEST
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "targets.h"
+#include "common.h"
+#include "stubborn_sender.h"
+#include "stubborn_receiver.h"
+
+/**
+ * The TX side of the RF link: building and sending the RC/SYNC/MSP packets from
+ * the tock, FHSS, the telemetry downlink and the downlink connection state.
+ *
+ * Anything that needs the TX config or the UART is reached through the hooks
+ * in rxtx_intf.h, which tx_main.cpp implements.
+ */
+
+/// sync packet spamming on mode change ///
+#define syncSpamAmount 3
+#define syncSpamAmountAfterRateChange 10
+
+extern volatile uint8_t syncSpamCounter;
+extern volatile uint8_t syncSpamCounterAfterRateChange;
+extern uint32_t rfModeLastChangedMS;
+
+extern volatile uint32_t LastTLMpacketRecvMillis;
+extern bool commitInProgress;
+extern volatile bool busyTransmitting;
+extern volatile bool stagedPktReady;
+extern uint8_t BindingSendCount;
+extern TxTlmRcvPhase_e TelemetryRcvPhase;
+
+extern StubbornReceiver TelemetryReceiver;
+extern StubbornSender MspSender;
+
+/**
+ * @brief Set the radio callbacks and reset the link to its power on state,
+ * call before the first SetRFLinkRate()
+ */
+void SetupRFLink();
+
+/**
+ * @brief Move between connected and disconnected on the telemetry received,
+ * called from the loop
+ */
+void UpdateConnectDisconnectStatus();
+
+/**
+ * @brief An adaptive hopping channel mask proposed by the RX, payload is
+ * [generation][FHSS_CHANNEL_MASK_BYTES of blocked channels].
+ * The tock switches to it and the new generation goes out in the next SYNC,
+ * which is the RX's cue to switch too.
+ */
+void OnAdaptiveHoppingProposal(uint8_t const *payload);
+
+void SetRFLinkRate(uint8_t index);
+void timerCallback();
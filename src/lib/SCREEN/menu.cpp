@@ -224,6 +224,32 @@ static void decrementValueIndex(bool init)
     }
 }
 
+// The deferred config changes carry their values in the callback context
+static void applyRate(void *ctx)
+{
+    uint32_t const values = (uintptr_t)ctx;
+    uint8_t const newSwitchMode = values >> 8;
+    config.SetRate(values & 0xff);
+    config.SetSwitchMode(newSwitchMode);
+    config.SetAntennaMode(values >> 16);
+    OtaUpdateSerializers((OtaSwitchMode_e)newSwitchMode, ExpressLRS_currAirRate_Modparams->PayloadLength);
+    SetSyncSpam();
+}
+
+static void applySwitchMode(void *ctx)
+{
+    uint8_t const val = (uintptr_t)ctx;
+    config.SetSwitchMode(val);
+    OtaUpdateSerializers((OtaSwitchMode_e)val, ExpressLRS_currAirRate_Modparams->PayloadLength);
+    SetSyncSpam();
+}
+
+static void applyTlm(void *ctx)
+{
+    config.SetTlm((uintptr_t)ctx);
+    SetSyncSpam();
+}
+
 static void saveValueIndex(bool init)
 {
     auto val = values_index;
@@ -238,13 +264,7 @@ static void saveValueIndex(bool init)
             // If the switch mode is going to change, block the change while connected
             if (newSwitchMode == OtaSwitchModeCurrent || connectionState == disconnected)
             {
-                deferExecutionMillis(100, [actualRate, newSwitchMode, newAntennaMode](){
-                    config.SetRate(actualRate);
-                    config.SetSwitchMode(newSwitchMode);
-                    config.SetAntennaMode(newAntennaMode);
-                    OtaUpdateSerializers((OtaSwitchMode_e)newSwitchMode, ExpressLRS_currAirRate_Modparams->PayloadLength);
-                    SetSyncSpam();
-                });
+                deferExecutionMillis(100, applyRate, (void *)(uintptr_t)(actualRate | (newSwitchMode << 8) | (newAntennaMode << 16)));
             }
             break;
         }
@@ -253,11 +273,7 @@ static void saveValueIndex(bool init)
             // the pack and unpack functions are matched
             if (connectionState == disconnected)
             {
-                deferExecutionMillis(100, [val](){
-                    config.SetSwitchMode(val);
-                    OtaUpdateSerializers((OtaSwitchMode_e)val, ExpressLRS_currAirRate_Modparams->PayloadLength);
-                    SetSyncSpam();
-                });
+                deferExecutionMillis(100, applySwitchMode, (void *)(uintptr_t)val);
             }
             break;
         }
@@ -268,10 +284,7 @@ static void saveValueIndex(bool init)
             break;
         }
         case STATE_TELEMETRY:
-            deferExecutionMillis(100, [val](){
-                config.SetTlm(val);
-                SetSyncSpam();
-            });
+            deferExecutionMillis(100, applyTlm, (void *)(uintptr_t)val);
             break;
         case STATE_POWERSAVE:
             config.SetMotionMode(values_index);
@@ -0,0 +1,71 @@
+#include "SPIQueue.h"
+
+#include <string.h>
+
+SPIQueue::SPIQueue()
+{
+    clear();
+}
+
+void ICACHE_RAM_ATTR SPIQueue::clear()
+{
+    count = 0;
+    head = 0;
+    poolUsed = 0;
+}
+
+ICACHE_RAM_ATTR SPIQueue::transaction_t *SPIQueue::append(uint8_t csMask, const uint8_t *data, uint32_t size, uint32_t busyUs)
+{
+    if (count == SPIQUEUE_MAX_TRANSACTIONS || size > SPIQUEUE_MAX_TRANSFER || poolUsed + WORD_PADDED(size) > SPIQUEUE_POOL_SIZE)
+    {
+        return nullptr;
+    }
+
+    transaction_t &t = transactions[count++];
+    t.csMask = csMask;
+    t.headerLen = 0;
+    t.offset = poolUsed;
+    t.size = size;
+    t.busyUs = busyUs;
+    memcpy(&pool[poolUsed], data, size);
+    poolUsed += WORD_PADDED(size);
+    return &t;
+}
+
+bool ICACHE_RAM_ATTR SPIQueue::add(uint8_t csMask, const uint8_t *data, uint32_t size, uint32_t busyUs)
+{
+    return append(csMask, data, size, busyUs) != nullptr;
+}
+
+bool ICACHE_RAM_ATTR SPIQueue::addRegisterWrite(uint8_t csMask, uint32_t address, uint8_t headerLen, const uint8_t *data, uint32_t size, uint32_t busyUs)
+{
+    uint32_t const values = size - headerLen;
+    // Only while it is unsent, what runReady() has sent is gone
+    if (count > head)
+    {
+        transaction_t &last = transactions[count - 1];
+        // The last transaction is always at the end of the pool, so it can grow in place
+        if (last.headerLen == headerLen && last.csMask == csMask && last.nextAddress == address &&
+            last.size + values <= SPIQUEUE_MAX_TRANSFER && last.offset + WORD_PADDED(last.size + values) <= SPIQUEUE_POOL_SIZE)
+        {
+            memcpy(&pool[last.offset + last.size], data + headerLen, values);
+            last.size += values;
+            last.nextAddress += values;
+            if (busyUs > last.busyUs)
+            {
+                last.busyUs = busyUs;
+            }
+            poolUsed = last.offset + WORD_PADDED(last.size);
+            return true;
+        }
+    }
+
+    transaction_t *t = append(csMask, data, size, busyUs);
+    if (t == nullptr)
+    {
+        return false;
+    }
+    t->headerLen = headerLen;
+    t->nextAddress = address + values;
+    return true;
+}
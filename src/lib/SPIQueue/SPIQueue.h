@@ -0,0 +1,108 @@
+#pragma once
+
+#include "targets.h"
+
+#define SPIQUEUE_MAX_TRANSACTIONS 8
+#define SPIQUEUE_POOL_SIZE 192
+// The most a single transfer can carry, the SPI FIFO on the ESP32 and ESP8266 is 16 words
+#define SPIQUEUE_MAX_TRANSFER 64
+
+/**
+ * @brief A list of SPI write transactions for one or both radios, built up then sent in one go.
+ *
+ * Each transaction is a chip select mask and the bytes to write, copied word-aligned and
+ * word-padded into the queue's pool so they can go straight to the SPI FIFO. A register write
+ * that continues the previous one, to the same radios and at the next address, is merged into
+ * it so the radio's auto-increment does the work of a second transaction.
+ *
+ * run() is given the bus as a template parameter, anything with:
+ *   void waitBusy(uint8_t csMask)               wait until the radios can take a command
+ *   void write(uint8_t csMask, uint8_t *data, uint32_t size)
+ *   void busyFor(uint8_t csMask, uint32_t us)    how long the radios stay busy after it
+ * which keeps the radio HALs free of virtual calls from the ISR and lets the tests record it.
+ *
+ * runReady() also needs:
+ *   bool ready(uint8_t csMask)                   true if the radios can take a command now
+ * and sends only as far as the radios are ready, so the rest can be sent from the BUSY interrupt.
+ */
+class SPIQueue
+{
+public:
+    SPIQueue();
+
+    void clear();
+    bool empty() const { return head == count; }
+    // Transactions still to be sent
+    uint8_t size() const { return count - head; }
+    // The radios the next transaction is for
+    uint8_t nextCsMask() const { return transactions[head].csMask; }
+
+    /**
+     * @brief Queue a write of `size` bytes to the radios in `csMask`
+     * @param busyUs how long the radios are busy after it, for radios without a BUSY pin
+     * @return false if the queue is full, nothing is queued
+     */
+    bool add(uint8_t csMask, const uint8_t *data, uint32_t size, uint32_t busyUs = 0);
+
+    /**
+     * @brief Queue a write to auto-incrementing registers starting at `address`. `data` is the whole
+     * transaction, the first `headerLen` bytes the opcode and address, followed by the values.
+     * @return false if the queue is full, nothing is queued
+     */
+    bool addRegisterWrite(uint8_t csMask, uint32_t address, uint8_t headerLen, const uint8_t *data, uint32_t size, uint32_t busyUs = 0);
+
+    /**
+     * @brief Send the queued transactions in order, then empty the queue
+     */
+    template <class Bus>
+    void ICACHE_RAM_ATTR run(Bus &bus)
+    {
+        for (; head < count; head++)
+        {
+            transaction_t const &t = transactions[head];
+            bus.waitBusy(t.csMask);
+            bus.write(t.csMask, &pool[t.offset], t.size);
+            bus.busyFor(t.csMask, t.busyUs);
+        }
+        clear();
+    }
+
+    /**
+     * @brief Send the queued transactions in order for as long as the radios are ready, without waiting
+     * @return true if everything has been sent and the queue emptied, false if the radios went busy first
+     */
+    template <class Bus>
+    bool ICACHE_RAM_ATTR runReady(Bus &bus)
+    {
+        for (; head < count; head++)
+        {
+            transaction_t const &t = transactions[head];
+            if (!bus.ready(t.csMask))
+            {
+                return false;
+            }
+            bus.write(t.csMask, &pool[t.offset], t.size);
+            bus.busyFor(t.csMask, t.busyUs);
+        }
+        clear();
+        return true;
+    }
+
+private:
+    struct transaction_t {
+        uint8_t csMask;
+        uint8_t headerLen;     // non-zero for a register write that can be continued
+        uint16_t offset;
+        uint16_t size;
+        uint32_t nextAddress;  // the register after the last one written
+        uint32_t busyUs;
+    };
+
+    transaction_t *append(uint8_t csMask, const uint8_t *data, uint32_t size, uint32_t busyUs);
+
+    transaction_t transactions[SPIQUEUE_MAX_TRANSACTIONS];
+    WORD_ALIGNED_ATTR uint8_t pool[SPIQUEUE_POOL_SIZE];
+    uint16_t poolUsed;
+    uint8_t count;
+    uint8_t head;          // the next transaction to send
+};
@@ -150,6 +150,7 @@ void SX127xDriver::startCWTest(uint32_t freq, SX12XX_Radio_Number_t radioNumber)
 
 void SX127xDriver::ConfigLoraDefaults()
 {
+  hal.beginBatch();
   hal.writeRegister(SX127X_REG_OP_MODE, SX127x_OPMODE_SLEEP, SX12XX_Radio_All);
   hal.writeRegister(SX127X_REG_OP_MODE, ModFSKorLoRa, SX12XX_Radio_All); //must be written in sleep mode
   SetMode(SX127x_OPMODE_STANDBY, SX12XX_Radio_All);
@@ -163,6 +164,7 @@ void SX127xDriver::ConfigLoraDefaults()
   hal.writeRegister(SX1278_REG_MODEM_CONFIG_3, SX1278_AGC_AUTO_ON | SX1278_LOW_DATA_RATE_OPT_OFF, SX12XX_Radio_All);
   hal.writeRegisterBits(SX127X_REG_OCP, SX127X_OCP_ON | SX127X_OCP_150MA, SX127X_OCP_MASK, SX12XX_Radio_All); //150ma max current
   SetPreambleLength(SX127X_PREAMBLE_LENGTH_LSB);
+  hal.endBatch();
 }
 
 void SX127xDriver::SetBandwidthCodingRate(SX127x_Bandwidth bw, SX127x_CodingRate cr)
@@ -437,6 +439,17 @@ void ICACHE_RAM_ATTR SX127xDriver::TXnb(uint8_t * data, uint8_t size, bool sendG
   //   return; // we were already TXing so abort. this should never happen!!!
   // }
 
+  transmittingRadio = radioNumber;
+  TXnbEnablePA(); // do first to allow PA stablise
+
+  hal.beginBatch();
+  TXnbLoad(data, size, sendGeminiBuffer, dataGemini, radioNumber);
+  TXnbStart();
+  hal.endBatch();
+}
+
+void ICACHE_RAM_ATTR SX127xDriver::TXnbLoad(uint8_t * data, uint8_t size, bool sendGeminiBuffer, uint8_t * dataGemini, SX12XX_Radio_Number_t radioNumber)
+{
   transmittingRadio = radioNumber;
 
   SetMode(SX127x_OPMODE_STANDBY, SX12XX_Radio_All);
@@ -457,7 +470,7 @@ void ICACHE_RAM_ATTR SX127xDriver::TXnb(uint8_t * data, uint8_t size, bool sendG
     }
 #endif
 
-  RFAMP.TXenable(radioNumber);
+  // The FIFO keeps its contents in standby, until the TX is started
   hal.writeRegister(SX127X_REG_FIFO_ADDR_PTR, SX127X_FIFO_TX_BASE_ADDR_MAX, radioNumber);
   if (sendGeminiBuffer)
   {
@@ -468,8 +481,26 @@ void ICACHE_RAM_ATTR SX127xDriver::TXnb(uint8_t * data, uint8_t size, bool sendG
   {
     hal.writeRegister(SX127X_REG_FIFO, data, size, radioNumber);
   }
+}
 
-  SetMode(SX127x_OPMODE_TX, radioNumber);
+void ICACHE_RAM_ATTR SX127xDriver::TXnbEnablePA()
+{
+  if (transmittingRadio == SX12XX_Radio_NONE)
+  {
+      return;
+  }
+
+  RFAMP.TXenable(transmittingRadio);
+}
+
+void ICACHE_RAM_ATTR SX127xDriver::TXnbStart()
+{
+  if (transmittingRadio == SX12XX_Radio_NONE)
+  {
+      return;
+  }
+
+  SetMode(SX127x_OPMODE_TX, transmittingRadio);
 }
 
 ///////////////////////////////////RX Functions Non-Blocking///////////////////////////////////////////
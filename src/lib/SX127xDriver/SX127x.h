@@ -76,6 +76,11 @@ public:
 
     ////////////Non-blocking TX related Functions/////////////////
     void TXnb(uint8_t * data, uint8_t size, bool sendGeminiBuffer, uint8_t * dataGemini, SX12XX_Radio_Number_t radioNumber);
+    // TXnb() in two halves: write the packet to the radio while it is idle, then start the TX later
+    void TXnbLoad(uint8_t * data, uint8_t size, bool sendGeminiBuffer, uint8_t * dataGemini, SX12XX_Radio_Number_t radioNumber);
+    // Enable the PA for the radios TXnbLoad() loaded, some time ahead of TXnbStart() to let it settle
+    void TXnbEnablePA();
+    void TXnbStart();
     /////////////Non-blocking RX related Functions///////////////
     void RXnb();
 
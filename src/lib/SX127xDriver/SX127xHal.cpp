@@ -7,7 +7,7 @@
 
 SX127xHal *SX127xHal::instance = NULL;
 
-SX127xHal::SX127xHal()
+SX127xHal::SX127xHal() : batching(false)
 {
     instance = this;
 }
@@ -108,6 +108,7 @@ void ICACHE_RAM_ATTR SX127xHal::readRegister(uint8_t reg, uint8_t *data, uint8_t
     WORD_ALIGNED_ATTR uint8_t buf[WORD_PADDED(numBytes + 1)];
     buf[0] = reg | SPI_READ;
 
+    flushBatch();
     SPIEx.read(radioNumber, buf, numBytes + 1);
 
     memcpy(data, buf + 1, numBytes);
@@ -141,9 +142,43 @@ void ICACHE_RAM_ATTR SX127xHal::writeRegister(uint8_t reg, uint8_t *data, uint8_
     buf[0] = reg | SPI_WRITE;
     memcpy(buf + 1, data, numBytes);
 
+    if (batching)
+    {
+        // The FIFO register doesn't auto-increment, so writes to it are never merged
+        bool const queued = (reg == SX127X_REG_FIFO)
+            ? batch.add(radioNumber, buf, numBytes + 1)
+            : batch.addRegisterWrite(radioNumber, reg, 1, buf, numBytes + 1);
+        if (queued)
+        {
+            return;
+        }
+        // Full, what is queued has to go first to keep the order
+        flushBatch();
+    }
+
     SPIEx.write(radioNumber, buf, numBytes + 1);
 }
 
+void ICACHE_RAM_ATTR SX127xHal::BatchBus::write(uint8_t csMask, uint8_t *data, uint32_t size)
+{
+    SPIEx.write(csMask, data, size);
+}
+
+void ICACHE_RAM_ATTR SX127xHal::flushBatch()
+{
+    if (!batch.empty())
+    {
+        BatchBus bus;
+        batch.run(bus);
+    }
+}
+
+void ICACHE_RAM_ATTR SX127xHal::endBatch()
+{
+    flushBatch();
+    batching = false;
+}
+
 void ICACHE_RAM_ATTR SX127xHal::dioISR_1()
 {
     if (instance->IsrCallback_1)
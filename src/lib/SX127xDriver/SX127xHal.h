@@ -2,6 +2,7 @@
 
 #include "SX127xRegs.h"
 #include "SX12xxDriverCommon.h"
+#include "SPIQueue.h"
 
 class SX127xHal
 {
@@ -23,11 +24,26 @@ public:
     void ICACHE_RAM_ATTR writeRegister(uint8_t reg, uint8_t data, SX12XX_Radio_Number_t radioNumber);
     void ICACHE_RAM_ATTR writeRegister(uint8_t reg, uint8_t *data, uint8_t numBytes, SX12XX_Radio_Number_t radioNumber);
 
+    // Writes between beginBatch() and endBatch() are queued and sent together, adjacent registers
+    // in one transaction. Reads send what is queued first.
+    void beginBatch() { batching = true; }
+    void ICACHE_RAM_ATTR endBatch();
+
     static ICACHE_RAM_ATTR void dioISR_1();
     static ICACHE_RAM_ATTR void dioISR_2();
     void (*IsrCallback_1)(); // function pointer for callback
     void (*IsrCallback_2)(); // function pointer for callback
 
 private:
+    // The SX127x has no BUSY, it takes the next command as soon as NSS goes high
+    struct BatchBus {
+        void waitBusy(uint8_t csMask) {}
+        void write(uint8_t csMask, uint8_t *data, uint32_t size);
+        void busyFor(uint8_t csMask, uint32_t us) {}
+    };
+
+    SPIQueue batch;
+    bool batching;
 
+    void ICACHE_RAM_ATTR flushBatch();
 };
\ No newline at end of file
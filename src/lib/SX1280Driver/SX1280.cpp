@@ -409,7 +409,10 @@ void ICACHE_RAM_ATTR SX1280Driver::SetFrequencyReg(uint32_t regfreq, SX12XX_Radi
     buf[1] = (uint8_t)((regfreq >> 8) & 0xFF);
     buf[2] = (uint8_t)(regfreq & 0xFF);
 
+    // Called from the timer ISR on every hop, what the radios are not ready for is sent from BUSY
+    hal.BeginBatch();
     hal.WriteCommand(SX1280_RADIO_SET_RFFREQUENCY, buf, sizeof(buf), radioNumber);
+    hal.EndBatchAsync();
 
     currFreq = regfreq;
 }
@@ -471,20 +474,23 @@ void ICACHE_RAM_ATTR SX1280Driver::TXnbISR()
 void ICACHE_RAM_ATTR SX1280Driver::TXnb(uint8_t * data, uint8_t size, bool sendGeminiBuffer, uint8_t * dataGemini, SX12XX_Radio_Number_t radioNumber)
 {
     transmittingRadio = radioNumber;
-    
-    //catch TX timeout
-    if (currOpmode == SX1280_MODE_TX)
-    {
-        DBGLN("Timeout!");
-        SetMode(fallBackMode, SX12XX_Radio_All);
-        ClearIrqStatus(SX1280_IRQ_RADIO_ALL, SX12XX_Radio_All);
-        TXnbISR();
-        return;
-    }
+    TXnbEnablePA(); // do first to allow PA stablise
 
-    if (radioNumber == SX12XX_Radio_NONE)
+    // Everything from here to the TX is queued and sent back to back, as far as the radios are ready
+    // for it here and the rest from the BUSY interrupt, rather than waiting on BUSY in the ISR
+    hal.BeginBatch();
+    TXnbLoad(data, size, sendGeminiBuffer, dataGemini, radioNumber);
+    TXnbStart();
+    hal.EndBatchAsync();
+}
+
+void ICACHE_RAM_ATTR SX1280Driver::TXnbLoad(uint8_t * data, uint8_t size, bool sendGeminiBuffer, uint8_t * dataGemini, SX12XX_Radio_Number_t radioNumber)
+{
+    transmittingRadio = radioNumber;
+
+    // A TX that never finished is given up on by TXnbStart(), and nothing is sent this time
+    if (currOpmode == SX1280_MODE_TX || radioNumber == SX12XX_Radio_NONE)
     {
-        instance->SetMode(fallBackMode, SX12XX_Radio_All);
         return;
     }
 
@@ -513,7 +519,6 @@ void ICACHE_RAM_ATTR SX1280Driver::TXnb(uint8_t * data, uint8_t size, bool sendG
         }
     }
 
-    RFAMP.TXenable(radioNumber); // do first to allow PA stablise
     if (sendGeminiBuffer)
     {
         hal.WriteBuffer(0x00, data, size, SX12XX_Radio_1);
@@ -523,8 +528,38 @@ void ICACHE_RAM_ATTR SX1280Driver::TXnb(uint8_t * data, uint8_t size, bool sendG
     {
         hal.WriteBuffer(0x00, data, size, radioNumber);
     }
-    
-    instance->SetMode(SX1280_MODE_TX, radioNumber);
+}
+
+void ICACHE_RAM_ATTR SX1280Driver::TXnbEnablePA()
+{
+    // Not for a TX that never finished, TXnbStart() gives up on it
+    if (currOpmode == SX1280_MODE_TX || transmittingRadio == SX12XX_Radio_NONE)
+    {
+        return;
+    }
+
+    RFAMP.TXenable(transmittingRadio);
+}
+
+void ICACHE_RAM_ATTR SX1280Driver::TXnbStart()
+{
+    //catch TX timeout
+    if (currOpmode == SX1280_MODE_TX)
+    {
+        DBGLN("Timeout!");
+        SetMode(fallBackMode, SX12XX_Radio_All);
+        ClearIrqStatus(SX1280_IRQ_RADIO_ALL, SX12XX_Radio_All);
+        TXnbISR();
+        return;
+    }
+
+    if (transmittingRadio == SX12XX_Radio_NONE)
+    {
+        instance->SetMode(fallBackMode, SX12XX_Radio_All);
+        return;
+    }
+
+    instance->SetMode(SX1280_MODE_TX, transmittingRadio);
 
 #ifdef DEBUG_SX1280_OTA_TIMING
     beginTX = micros();
@@ -562,7 +597,9 @@ bool ICACHE_RAM_ATTR SX1280Driver::RXnbISR(uint16_t irqStatus, SX12XX_Radio_Numb
 void ICACHE_RAM_ATTR SX1280Driver::RXnb(SX1280_RadioOperatingModes_t rxMode, uint32_t incomingTimeout)
 {
     RFAMP.RXenable();
+    hal.BeginBatch();
     SetMode(rxMode, SX12XX_Radio_All, incomingTimeout);
+    hal.EndBatchAsync();
 }
 
 uint8_t ICACHE_RAM_ATTR SX1280Driver::GetRxBufferAddr(SX12XX_Radio_Number_t radioNumber)
@@ -598,6 +635,17 @@ int8_t ICACHE_RAM_ATTR SX1280Driver::GetRssiInst(SX12XX_Radio_Number_t radioNumb
     return -(int8_t)(status / 2);
 }
 
+int8_t ICACHE_RAM_ATTR SX1280Driver::GetLastPacketSNRRaw(SX12XX_Radio_Number_t radioNumber)
+{
+    // No SNR in FLRC mode
+    if (packet_mode == SX1280_PACKET_TYPE_FLRC)
+        return 0;
+
+    uint8_t status[2];
+    hal.ReadCommand(SX1280_RADIO_GET_PACKETSTATUS, status, 2, radioNumber);
+    return (int8_t)status[1];
+}
+
 void ICACHE_RAM_ATTR SX1280Driver::CheckForSecondPacket()
 {
     SX12XX_Radio_Number_t radio[2] = {SX12XX_Radio_1, SX12XX_Radio_2};
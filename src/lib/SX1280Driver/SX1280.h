@@ -41,6 +41,11 @@ public:
     bool FrequencyErrorAvailable() const { return modeSupportsFei && (LastPacketSNRRaw > 0); }
 
     void TXnb(uint8_t * data, uint8_t size, bool sendGeminiBuffer, uint8_t * dataGemini, SX12XX_Radio_Number_t radioNumber);
+    // TXnb() in two halves: write the packet to the radio while it is idle, then start the TX later
+    void TXnbLoad(uint8_t * data, uint8_t size, bool sendGeminiBuffer, uint8_t * dataGemini, SX12XX_Radio_Number_t radioNumber);
+    // Enable the PA for the radios TXnbLoad() loaded, some time ahead of TXnbStart() to let it settle
+    void TXnbEnablePA();
+    void TXnbStart();
     void RXnb(SX1280_RadioOperatingModes_t rxMode = SX1280_MODE_RX, uint32_t incomingTimeout = 0);
 
     uint16_t GetIrqStatus(SX12XX_Radio_Number_t radioNumber);
@@ -50,6 +55,8 @@ public:
 
     uint8_t GetRxBufferAddr(SX12XX_Radio_Number_t radioNumber);
     int8_t GetRssiInst(SX12XX_Radio_Number_t radioNumber);
+    // SNR of the packet just received by one radio, without updating the LastPacket stats
+    int8_t GetLastPacketSNRRaw(SX12XX_Radio_Number_t radioNumber);
     void GetLastPacketStats();
     void CheckForSecondPacket();
 
@@ -24,7 +24,7 @@ Modified and adapted by Alessandro Carcione for ELRS project
 
 SX1280Hal *SX1280Hal::instance = NULL;
 
-SX1280Hal::SX1280Hal()
+SX1280Hal::SX1280Hal() : batching(false), dispatching(false), batchDoneCallback(nullptr)
 {
     instance = this;
 }
@@ -36,6 +36,14 @@ void SX1280Hal::end()
     {
         detachInterrupt(GPIO_PIN_DIO1_2);
     }
+    if (HasBusyInterrupt())
+    {
+        detachInterrupt(GPIO_PIN_BUSY);
+        if (GPIO_PIN_BUSY_2 != UNDEF_PIN)
+        {
+            detachInterrupt(GPIO_PIN_BUSY_2);
+        }
+    }
     SPIEx.end();
     IsrCallback_1 = nullptr; // remove callbacks
     IsrCallback_2 = nullptr; // remove callbacks
@@ -84,7 +92,14 @@ void SX1280Hal::init()
     SPIEx.setFrequency(17500000);
 #endif
 
-    //attachInterrupt(digitalPinToInterrupt(GPIO_PIN_BUSY), this->busyISR, CHANGE); //not used atm
+    if (HasBusyInterrupt())
+    {
+        attachInterrupt(digitalPinToInterrupt(GPIO_PIN_BUSY), this->busyISR, FALLING);
+        if (GPIO_PIN_BUSY_2 != UNDEF_PIN)
+        {
+            attachInterrupt(digitalPinToInterrupt(GPIO_PIN_BUSY_2), this->busyISR, FALLING);
+        }
+    }
     attachInterrupt(digitalPinToInterrupt(GPIO_PIN_DIO1), this->dioISR_1, RISING);
     if (GPIO_PIN_DIO1_2 != UNDEF_PIN)
     {
@@ -134,10 +149,7 @@ void ICACHE_RAM_ATTR SX1280Hal::WriteCommand(SX1280_RadioCommands_t command, uin
 
     memcpy(OutBuffer + 1, buffer, size);
 
-    WaitOnBusy(radioNumber);
-    SPIEx.write(radioNumber, OutBuffer, size + 1);
-
-    BusyDelay(busyDelay);
+    Write(OutBuffer, size + 1, radioNumber, busyDelay);
 }
 
 void ICACHE_RAM_ATTR SX1280Hal::ReadCommand(SX1280_RadioCommands_t command, uint8_t *buffer, uint8_t size, SX12XX_Radio_Number_t radioNumber)
@@ -148,6 +160,7 @@ void ICACHE_RAM_ATTR SX1280Hal::ReadCommand(SX1280_RadioCommands_t command, uint
         0x00,
     };
 
+    FlushBatch();
     WaitOnBusy(radioNumber);
 
     if (command == SX1280_RADIO_GET_STATUS)
@@ -173,6 +186,16 @@ void ICACHE_RAM_ATTR SX1280Hal::WriteRegister(uint16_t address, uint8_t *buffer,
 
     memcpy(OutBuffer + 3, buffer, size);
 
+    if (batching)
+    {
+        if (batch.addRegisterWrite(radioNumber, address, 3, OutBuffer, size + 3, 15))
+        {
+            return;
+        }
+    }
+    // A batch still being sent from the BUSY interrupt goes first
+    FlushBatch();
+
     WaitOnBusy(radioNumber);
     SPIEx.write(radioNumber, OutBuffer, size + 3);
 
@@ -193,6 +216,7 @@ void ICACHE_RAM_ATTR SX1280Hal::ReadRegister(uint16_t address, uint8_t *buffer,
         0x00,
     };
 
+    FlushBatch();
     WaitOnBusy(radioNumber);
 
     SPIEx.read(radioNumber, OutBuffer, size + 4);
@@ -215,11 +239,7 @@ void ICACHE_RAM_ATTR SX1280Hal::WriteBuffer(uint8_t offset, uint8_t *buffer, uin
 
     memcpy(OutBuffer + 2, buffer, size);
 
-    WaitOnBusy(radioNumber);
-
-    SPIEx.write(radioNumber, OutBuffer, size + 2);
-
-    BusyDelay(15);
+    Write(OutBuffer, size + 2, radioNumber, 15);
 }
 
 void ICACHE_RAM_ATTR SX1280Hal::ReadBuffer(uint8_t offset, uint8_t *buffer, uint8_t size, SX12XX_Radio_Number_t radioNumber)
@@ -230,6 +250,7 @@ void ICACHE_RAM_ATTR SX1280Hal::ReadBuffer(uint8_t offset, uint8_t *buffer, uint
         0x00
     };
 
+    FlushBatch();
     WaitOnBusy(radioNumber);
 
     SPIEx.read(radioNumber, OutBuffer, size + 3);
@@ -237,6 +258,117 @@ void ICACHE_RAM_ATTR SX1280Hal::ReadBuffer(uint8_t offset, uint8_t *buffer, uint
     memcpy(buffer, OutBuffer + 3, size);
 }
 
+void ICACHE_RAM_ATTR SX1280Hal::Write(uint8_t *data, uint8_t size, SX12XX_Radio_Number_t radioNumber, uint32_t busyDelay)
+{
+    if (batching)
+    {
+        if (batch.add(radioNumber, data, size, busyDelay))
+        {
+            return;
+        }
+    }
+    // Full, or a batch still being sent from the BUSY interrupt, what is queued has to go first to keep the order
+    FlushBatch();
+
+    WaitOnBusy(radioNumber);
+    SPIEx.write(radioNumber, data, size);
+
+    BusyDelay(busyDelay);
+}
+
+void ICACHE_RAM_ATTR SX1280Hal::BatchBus::write(uint8_t csMask, uint8_t *data, uint32_t size)
+{
+    SPIEx.write(csMask, data, size);
+}
+
+void ICACHE_RAM_ATTR SX1280Hal::FlushBatch()
+{
+    if (!batch.empty())
+    {
+        bool const wasDispatching = dispatching;
+        dispatching = true;
+        BatchBus bus = {*this};
+        batch.run(bus);
+        dispatching = wasDispatching;
+    }
+    CompleteBatch();
+}
+
+void ICACHE_RAM_ATTR SX1280Hal::CompleteBatch()
+{
+    // Not while a batch is being built, the callback may start one of its own
+    if (batchDoneCallback && !batching && batch.empty())
+    {
+        void (*const onDone)() = batchDoneCallback;
+        batchDoneCallback = nullptr;
+        onDone();
+    }
+}
+
+void ICACHE_RAM_ATTR SX1280Hal::EndBatch()
+{
+    batching = false;
+    FlushBatch();
+    dispatching = false;
+}
+
+bool ICACHE_RAM_ATTR SX1280Hal::HasBusyInterrupt()
+{
+    return GPIO_PIN_BUSY != UNDEF_PIN && (GPIO_PIN_NSS_2 == UNDEF_PIN || GPIO_PIN_BUSY_2 != UNDEF_PIN);
+}
+
+void ICACHE_RAM_ATTR SX1280Hal::EndBatchAsync(void (*onDone)())
+{
+    // Without BUSY there is nothing to interrupt on, and there is only room for one callback
+    if (!HasBusyInterrupt() || (onDone && batchDoneCallback))
+    {
+        EndBatch();
+        if (onDone)
+        {
+            onDone();
+        }
+        return;
+    }
+
+    batching = false;
+    if (onDone)
+    {
+        batchDoneCallback = onDone;
+    }
+    DispatchReady();
+}
+
+void ICACHE_RAM_ATTR SX1280Hal::DispatchReady()
+{
+    BatchBus bus = {*this};
+    bool done;
+    do
+    {
+        dispatching = true;
+        done = batch.runReady(bus);
+        dispatching = false;
+        // BUSY may have fallen while its interrupt was kept out
+    } while (!done && IsReady(batch.nextCsMask()));
+
+    if (done)
+    {
+        CompleteBatch();
+    }
+}
+
+bool ICACHE_RAM_ATTR SX1280Hal::IsReady(uint8_t csMask)
+{
+    if ((csMask & SX12XX_Radio_1) && digitalRead(GPIO_PIN_BUSY) == HIGH)
+    {
+        return false;
+    }
+    if ((csMask & SX12XX_Radio_2) && GPIO_PIN_BUSY_2 != UNDEF_PIN && digitalRead(GPIO_PIN_BUSY_2) == HIGH)
+    {
+        return false;
+    }
+    return true;
+}
+
 bool ICACHE_RAM_ATTR SX1280Hal::WaitOnBusy(SX12XX_Radio_Number_t radioNumber)
 {
     if (GPIO_PIN_BUSY != UNDEF_PIN)
@@ -293,4 +425,11 @@ void ICACHE_RAM_ATTR SX1280Hal::dioISR_2()
         instance->IsrCallback_2();
 }
 
+void ICACHE_RAM_ATTR SX1280Hal::busyISR()
+{
+    // A radio can take the next command, unless the queue is in someone else's hands
+    if (!instance->dispatching)
+        instance->DispatchReady();
+}
+
 #endif // UNIT_TEST
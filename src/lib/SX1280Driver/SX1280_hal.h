@@ -20,6 +20,7 @@ Heavily modified/simplified by Alessandro Carcione 2020 for ELRS project
 
 #include "SX1280_Regs.h"
 #include "SX1280.h"
+#include "SPIQueue.h"
 
 enum SX1280_BusyState_
 {
@@ -52,8 +53,16 @@ public:
 
     bool ICACHE_RAM_ATTR WaitOnBusy(SX12XX_Radio_Number_t radioNumber);
 
+    // Writes between BeginBatch() and EndBatch() are queued and sent together, reads send what is queued first
+    void BeginBatch() { batching = true; dispatching = true; }
+    void ICACHE_RAM_ATTR EndBatch();
+    // As EndBatch(), but only sends what the radios are ready for and returns. The rest is sent from the
+    // BUSY falling edge, then onDone is called from that interrupt. Synchronous without a BUSY pin.
+    void ICACHE_RAM_ATTR EndBatchAsync(void (*onDone)() = nullptr);
+
     static ICACHE_RAM_ATTR void dioISR_1();
     static ICACHE_RAM_ATTR void dioISR_2();
+    static ICACHE_RAM_ATTR void busyISR();
     void (*IsrCallback_1)(); //function pointer for callback
     void (*IsrCallback_2)(); //function pointer for callback
 
@@ -69,5 +78,25 @@ public:
     }
 
 private:
-
+    struct BatchBus {
+        SX1280Hal &hal;
+        void waitBusy(uint8_t csMask) { hal.WaitOnBusy(csMask); }
+        void write(uint8_t csMask, uint8_t *data, uint32_t size);
+        void busyFor(uint8_t csMask, uint32_t us) { hal.BusyDelay(us); }
+        bool ready(uint8_t csMask) { return hal.IsReady(csMask); }
+    };
+
+    SPIQueue batch;
+    bool batching;
+    // Set while the queue is being built or sent outside the BUSY interrupt, which leaves it alone
+    volatile bool dispatching;
+    void (*volatile batchDoneCallback)();
+
+    bool ICACHE_RAM_ATTR HasBusyInterrupt();
+    bool ICACHE_RAM_ATTR IsReady(uint8_t csMask);
+    void ICACHE_RAM_ATTR DispatchReady();
+    void ICACHE_RAM_ATTR CompleteBatch();
+
+    void ICACHE_RAM_ATTR Write(uint8_t *data, uint8_t size, SX12XX_Radio_Number_t radioNumber, uint32_t busyDelay);
+    void ICACHE_RAM_ATTR FlushBatch();
 };
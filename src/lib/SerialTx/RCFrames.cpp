@@ -0,0 +1,44 @@
+#include "RCFrames.h"
+#include "crsf_protocol.h"
+#include "ChannelCodec.h"
+
+typedef ChannelCodec<16, 11> channels11;
+
+uint8_t ICACHE_RAM_ATTR RCFrames::crsf(uint8_t *frame, const uint32_t *channels)
+{
+    frame[0] = CRSF_ADDRESS_FLIGHT_CONTROLLER;
+    frame[1] = CRSF_FRAME_SIZE(sizeof(crsf_channels_t));
+    frame[2] = CRSF_FRAMETYPE_RC_CHANNELS_PACKED;
+    channels11::pack(&frame[3], channels);
+    // CRC covers the type and payload
+    frame[RCFRAMES_CRSF_LEN - 1] = Crc8Fixed<CRC8_DVB_S2_POLY>::calc(&frame[2], RCFRAMES_CRSF_LEN - 3);
+    return RCFRAMES_CRSF_LEN;
+}
+
+uint8_t ICACHE_RAM_ATTR RCFrames::sbus(uint8_t *frame, const uint32_t *channels, uint8_t flags)
+{
+    frame[0] = 0x0F; // HEADER
+    channels11::pack(&frame[1], channels);
+    frame[RCFRAMES_SBUS_LEN - 2] = flags;
+    frame[RCFRAMES_SBUS_LEN - 1] = 0x00; // FOOTER
+    return RCFRAMES_SBUS_LEN;
+}
+
+uint8_t ICACHE_RAM_ATTR RCFrames::sumd(uint8_t *frame, const uint32_t *channels, Crc2Byte &crc)
+{
+    static const uint8_t order[16] = { 0, 1, 2, 3, 7, 5, 6, 4, 8, 9, 10, 11, 12, 13, 14, 15 };
+
+    frame[0] = 0xA8; // Graupner
+    frame[1] = 0x01; // SUMD
+    frame[2] = 0x10; // 16CH
+    for (uint8_t i = 0; i < 16; ++i)
+    {
+        uint16_t const us = CRSF_to_US(channels[order[i]]) << 3;
+        frame[3 + i * 2] = us >> 8;
+        frame[4 + i * 2] = us & 0xff;
+    }
+    uint16_t const sum = crc.calc(frame, RCFRAMES_SUMD_LEN - 2, 0);
+    frame[RCFRAMES_SUMD_LEN - 2] = sum >> 8;
+    frame[RCFRAMES_SUMD_LEN - 1] = sum & 0xff;
+    return RCFRAMES_SUMD_LEN;
+}
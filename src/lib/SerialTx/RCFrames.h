@@ -0,0 +1,24 @@
+#pragma once
+
+#include "targets.h"
+#include "crc.h"
+
+#define RCFRAMES_CRSF_LEN   26
+#define RCFRAMES_SBUS_LEN   25
+#define RCFRAMES_SUMD_LEN   37
+
+/**
+ * Renderers for the RC frames the receiver sends to the FC, writing the whole
+ * frame into a buffer such as SerialTxPort::buffer(). Each takes the 16 channels
+ * as CRSF values and returns the length of the frame.
+ */
+class RCFrames
+{
+public:
+    // CRSF RC_CHANNELS_PACKED addressed to the flight controller
+    static uint8_t crsf(uint8_t *frame, const uint32_t *channels);
+    // SBUS, `flags` is the byte after the channels (ch17/18, lost frame, failsafe)
+    static uint8_t sbus(uint8_t *frame, const uint32_t *channels, uint8_t flags);
+    // Graupner SUMD with 16 channels, channels 5 and 8 are swapped to move arm away from the aileron function
+    static uint8_t sumd(uint8_t *frame, const uint32_t *channels, Crc2Byte &crc);
+};
@@ -0,0 +1,58 @@
+#include "SerialTxPort.h"
+
+#if defined(PLATFORM_ESP32)
+#include <hal/uart_ll.h>
+#endif
+
+#define UART_TX_FIFO_LEN 128
+
+SerialTxPort::SerialTxPort(Stream *stream) : _stream(stream), _uart(-1)
+{
+#if defined(PLATFORM_ESP32)
+    // Serial is the USB CDC port on targets that boot with it
+#if ARDUINO_USB_CDC_ON_BOOT
+    if (stream == &Serial0)
+#else
+    if (stream == &Serial)
+#endif
+    {
+        _uart = 0;
+    }
+    else if (stream == &Serial1)
+    {
+        _uart = 1;
+    }
+#elif defined(PLATFORM_ESP8266)
+    if (stream == &Serial)
+    {
+        _uart = 0;
+    }
+#endif
+}
+
+void ICACHE_RAM_ATTR SerialTxPort::send(uint8_t len)
+{
+#if defined(PLATFORM_ESP32)
+    // The Arduino driver has no TX ring buffer, so an idle UART has nothing else queued
+    if (_uart >= 0)
+    {
+        uart_dev_t *hw = UART_LL_GET_HW(_uart);
+        if (uart_ll_is_tx_idle(hw) && uart_ll_get_txfifo_len(hw) >= len)
+        {
+            uart_ll_write_txfifo(hw, _buffer, len);
+            return;
+        }
+    }
+#elif defined(PLATFORM_ESP8266)
+    // HardwareSerial writes synchronously into the FIFO, so the FIFO count covers everything queued
+    if (_uart >= 0 && UART_TX_FIFO_LEN - ((USS(_uart) >> USTXC) & 0xff) >= len)
+    {
+        for (uint8_t i = 0; i < len; ++i)
+        {
+            USF(_uart) = _buffer[i];
+        }
+        return;
+    }
+#endif
+    _stream->write(_buffer, len);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "targets.h"
+
+// Largest frame that can be rendered into a SerialTxPort
+#define SERIAL_TX_FRAME_MAX 64
+
+/**
+ * @brief Output path for frames that are sent whole, such as the RC frames sent from the tock ISR.
+ *
+ * The protocol renders its frame directly into buffer() and send() hands it to the UART in one go,
+ * instead of building it in a local and copying it out through several Stream::write() calls.
+ * On ESP32 and ESP8266 a frame that fits in the hardware TX FIFO of a UART that is not already
+ * busy is written straight into the FIFO, skipping the Stream and the driver, so the time from the
+ * tock to the first byte on the wire is just the render. Anything else goes out with a single write().
+ *
+ * send() is virtual so a test can substitute a mock backend and time the render on the host.
+ */
+class SerialTxPort
+{
+public:
+    explicit SerialTxPort(Stream *stream);
+    virtual ~SerialTxPort() {}
+
+    /**
+     * @brief the buffer to render the next frame into, SERIAL_TX_FRAME_MAX bytes long
+     */
+    uint8_t *buffer() { return _buffer; }
+
+    /**
+     * @brief transmit the first `len` bytes of buffer()
+     */
+    virtual void send(uint8_t len);
+
+protected:
+    Stream *_stream;
+    uint8_t _buffer[SERIAL_TX_FRAME_MAX];
+
+private:
+    // The hardware UART behind `_stream`, -1 if it can't be written directly
+    int8_t _uart;
+};
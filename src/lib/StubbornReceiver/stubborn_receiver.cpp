@@ -2,8 +2,10 @@
 #include <algorithm>
 #include <cstring>
 #include "stubborn_receiver.h"
+#include "telemetry_protocol.h"
 
 StubbornReceiver::StubbornReceiver()
+    : windowIndexBits(0)
 {
     ResetState();
     data = nullptr;
@@ -24,11 +26,13 @@ void StubbornReceiver::ResetState()
     currentPackage = 1;
     currentOffset = 0;
     telemetryConfirm = false;
+    windowed = false;
+    windowParity = false;
 }
 
 bool StubbornReceiver::GetCurrentConfirm()
 {
-    return telemetryConfirm;
+    return windowed ? windowParity : telemetryConfirm;
 }
 
 void StubbornReceiver::SetDataToReceive(uint8_t* dataToReceive, uint8_t maxLength)
@@ -42,6 +46,8 @@ void StubbornReceiver::SetDataToReceive(uint8_t* dataToReceive, uint8_t maxLengt
 
 void StubbornReceiver::ReceiveData(uint8_t const packageIndex, uint8_t const * const receiveData, uint8_t dataLen)
 {
+    windowed = false;
+
     // Resync
     if (packageIndex == maxPackageIndex)
     {
@@ -104,3 +110,76 @@ void StubbornReceiver::Unlock()
         finishedData = false;
     }
 }
+
+bool StubbornReceiver::IsWindowIndex(uint8_t packageIndex) const
+{
+    return windowIndexBits != 0 && (packageIndex & STUBBORN_WINDOW_FLAG(windowIndexBits));
+}
+
+/***
+ * Accept a windowed chunk in any order, each is placed by its chunk number
+ * @param parity: the message parity sent with the chunk, a change starts a new message
+ ***/
+void StubbornReceiver::ReceiveWindowData(uint8_t const packageIndex, bool parity, uint8_t const * const receiveData, uint8_t dataLen)
+{
+    // Held until Unlock(), the sender keeps resending until it's acked
+    if (finishedData)
+    {
+        return;
+    }
+
+    // The first windowed chunk after stop-and-wait data is always a new message
+    if (!windowed || parity != windowParity)
+    {
+        windowed = true;
+        windowParity = parity;
+        windowDone = false;
+        windowLast = 0;
+        windowReceived = 0;
+    }
+
+    uint8_t const chunk = packageIndex & STUBBORN_WINDOW_CHUNK_MASK(windowIndexBits);
+    if (windowDone || chunk == 0)
+    {
+        return;
+    }
+
+    uint16_t const offset = (chunk - 1) * dataLen;
+    if (offset < length)
+    {
+        memcpy(&data[offset], receiveData, std::min((uint16_t)(length - offset), (uint16_t)dataLen));
+    }
+    windowReceived |= 1U << chunk;
+    if (packageIndex & STUBBORN_WINDOW_LAST(windowIndexBits))
+    {
+        windowLast = chunk;
+    }
+
+    if (windowLast != 0 && windowReceivedCount() >= windowLast)
+    {
+        windowDone = true;
+        finishedData = true;
+    }
+}
+
+// Number of chunks received in sequence from the first
+uint8_t StubbornReceiver::windowReceivedCount() const
+{
+    uint32_t const missing = ~(windowReceived >> 1);
+    return missing ? __builtin_ctz(missing) : 31;
+}
+
+/***
+ * @returns: the ack for the sender's ConfirmWindow(), 0 when not windowed
+ ***/
+uint8_t StubbornReceiver::GetWindowAck() const
+{
+    if (!windowed)
+    {
+        return 0;
+    }
+
+    uint8_t const count = windowReceivedCount();
+    uint8_t const beyond = (count + 2 < 32) ? (windowReceived >> (count + 2)) & ((1 << (STUBBORN_WINDOW_SIZE - 1)) - 1) : 0;
+    return (count & STUBBORN_WINDOW_ACK_COUNT_MASK) | (beyond << STUBBORN_WINDOW_ACK_BITS_SHIFT);
+}
@@ -13,7 +13,15 @@ public:
     bool HasFinishedData();
     void Unlock();
     bool GetCurrentConfirm();
+
+    // Windowed (selective repeat) transport
+    void setWindowIndexBits(uint8_t indexBits) { windowIndexBits = indexBits; }
+    bool IsWindowIndex(uint8_t packageIndex) const;
+    void ReceiveWindowData(uint8_t const packageIndex, bool parity, uint8_t const * const receiveData, uint8_t dataLen);
+    uint8_t GetWindowAck() const;
 private:
+    uint8_t windowReceivedCount() const;
+
     uint8_t *data;
     bool finishedData;
     uint8_t length;
@@ -21,4 +29,11 @@ private:
     uint8_t currentPackage;
     bool telemetryConfirm;
     uint8_t maxPackageIndex;
+
+    uint8_t windowIndexBits;
+    bool windowed;          // the last data received was a windowed chunk
+    bool windowParity;
+    bool windowDone;        // the message with windowParity has been received
+    uint8_t windowLast;     // chunk number of the last chunk, 0 until it is received
+    uint32_t windowReceived; // bit N is set once chunk N has been received
 };
@@ -2,9 +2,10 @@
 #include <algorithm>
 #include <cstring>
 #include "stubborn_sender.h"
+#include "telemetry_protocol.h"
 
 StubbornSender::StubbornSender()
-    : data(nullptr), length(0)
+    : data(nullptr), length(0), windowIndexBits(0)
 {
     ResetState();
 }
@@ -18,6 +19,15 @@ void StubbornSender::setMaxPackageIndex(uint8_t maxPackageIndex)
     }
 }
 
+void StubbornSender::SetWindowIndexBits(uint8_t indexBits)
+{
+    if (windowIndexBits != indexBits)
+    {
+        windowIndexBits = indexBits;
+        ResetState();
+    }
+}
+
 void StubbornSender::ResetState()
 {
     bytesLastPayload = 0;
@@ -28,6 +38,10 @@ void StubbornSender::ResetState()
     // 80 corresponds to UpdateTelemetryRate(ANY, 2, 1), which is what the TX uses in boost mode
     maxWaitCount = 80;
     senderState = SENDER_IDLE;
+    peerWindowed = false;
+    peerParity = false;
+    windowed = false;
+    windowParity = false;
 }
 
 /***
@@ -45,6 +59,21 @@ void StubbornSender::SetDataToTransmit(uint8_t* dataToTransmit, uint8_t lengthTo
     currentOffset = 0;
     currentPackage = 1;
     waitCount = 0;
+
+    windowed = peerWindowed && windowIndexBits != 0;
+    if (windowed)
+    {
+        // The receiver takes a parity different from the one it reports as a new message,
+        // so no RESYNC is needed even if the previous message was abandoned
+        windowParity = !peerParity;
+        windowChunks = 0;
+        windowBase = 0;
+        windowNext = 1;
+        windowAcked = 0;
+        senderState = SEND_PENDING;
+        return;
+    }
+
     senderState = (senderState == SENDER_IDLE) ? SEND_PENDING : RESYNC_THEN_SEND;
 }
 
@@ -54,6 +83,11 @@ void StubbornSender::SetDataToTransmit(uint8_t* dataToTransmit, uint8_t lengthTo
  ***/
 uint8_t StubbornSender::GetCurrentPayload(uint8_t *outData, uint8_t maxLen)
 {
+    if (windowed)
+    {
+        return GetWindowPayload(outData, maxLen);
+    }
+
     uint8_t packageIndex;
 
     bytesLastPayload = 0;
@@ -87,8 +121,126 @@ uint8_t StubbornSender::GetCurrentPayload(uint8_t *outData, uint8_t maxLen)
     return packageIndex;
 }
 
+/**
+ * @brief: Copy the next unacked chunk in the window to outData, cycling through
+ * the window until the chunks are acked. Every call must use the same maxLen
+ * @returns: windowed packageIndex
+ ***/
+uint8_t StubbornSender::GetWindowPayload(uint8_t *outData, uint8_t maxLen)
+{
+    if (senderState == SENDER_IDLE)
+    {
+        return 0;
+    }
+
+    if (senderState == SEND_PENDING)
+    {
+        uint8_t const chunks = std::max(1, (length + maxLen - 1) / maxLen);
+        if (chunks > STUBBORN_WINDOW_CHUNK_MASK(windowIndexBits))
+        {
+            // Too long to number the chunks, fall back to stop-and-wait for this message
+            windowed = false;
+            senderState = RESYNC_THEN_SEND;
+            return GetCurrentPayload(outData, maxLen);
+        }
+        windowChunks = chunks;
+        senderState = SENDING;
+    }
+
+    uint8_t const windowEnd = std::min(windowBase + STUBBORN_WINDOW_SIZE, (int)windowChunks);
+    if (windowNext <= windowBase || windowNext > windowEnd)
+        windowNext = windowBase + 1;
+    while (windowAcked & (1U << windowNext))
+    {
+        windowNext = (windowNext >= windowEnd) ? windowBase + 1 : windowNext + 1;
+    }
+
+    uint8_t const chunk = windowNext++;
+    uint8_t const offset = (chunk - 1) * maxLen;
+    bytesLastPayload = std::min((uint8_t)(length - offset), maxLen);
+    memcpy(outData, &data[offset], bytesLastPayload);
+
+    uint8_t packageIndex = STUBBORN_WINDOW_FLAG(windowIndexBits) | chunk;
+    if (chunk == windowChunks)
+        packageIndex |= STUBBORN_WINDOW_LAST(windowIndexBits);
+    return packageIndex;
+}
+
+void StubbornSender::SetPeerWindowed(bool peerWindowed)
+{
+    this->peerWindowed = peerWindowed;
+}
+
+/***
+ * Process a window ack from the receiver, which also tells the sender the receiver supports windowing
+ * @param parity: parity of the message the receiver is working on
+ * @param ack: the receiver's window ack, see STUBBORN_WINDOW_ACK_COUNT_MASK
+ ***/
+void StubbornSender::ConfirmWindow(bool parity, uint8_t ack)
+{
+    peerWindowed = true;
+    peerParity = parity;
+
+    if (!windowed || senderState != SENDING)
+    {
+        return;
+    }
+
+    // Acks of the previous message or a receiver that has not seen this one yet
+    if (parity != windowParity)
+    {
+        WindowNoProgress();
+        return;
+    }
+
+    // Acks arrive in order and the receiver can't be more than a window ahead
+    uint8_t const advance = ((ack & STUBBORN_WINDOW_ACK_COUNT_MASK) - windowBase) & STUBBORN_WINDOW_ACK_COUNT_MASK;
+    if (advance > STUBBORN_WINDOW_SIZE || windowBase + advance > windowChunks)
+    {
+        WindowNoProgress();
+        return;
+    }
+
+    windowBase += advance;
+    if (windowBase == windowChunks)
+    {
+        senderState = SENDER_IDLE;
+        return;
+    }
+
+    // The chunk after windowBase is missing, the ack bits cover the ones after it
+    uint32_t acked = windowAcked | ((2U << windowBase) - 1);
+    if (windowBase + 2 < 32)
+        acked |= (uint32_t)(ack >> STUBBORN_WINDOW_ACK_BITS_SHIFT) << (windowBase + 2);
+    if (acked != windowAcked)
+    {
+        // Fill the holes first, the window can't move on until they're acked
+        windowAcked = acked;
+        windowNext = windowBase + 1;
+        waitCount = 0;
+    }
+    else
+    {
+        WindowNoProgress();
+    }
+}
+
+void StubbornSender::WindowNoProgress()
+{
+    // Give up on the message, the next one is sent with the other parity
+    if (++waitCount > maxWaitCount)
+    {
+        senderState = SENDER_IDLE;
+    }
+}
+
 void StubbornSender::ConfirmCurrentPayload(bool telemetryConfirmValue)
 {
+    if (windowed)
+    {
+        return;
+    }
+
     stubborn_sender_state_e nextSenderState = senderState;
 
     switch (senderState)
@@ -26,7 +26,18 @@ public:
     void ConfirmCurrentPayload(bool telemetryConfirmValue);
     bool IsActive() const { return senderState != SENDER_IDLE; }
     uint16_t GetMaxPacketsBeforeResync() const { return maxWaitCount; }
+
+    // Windowed (selective repeat) transport, used from the next message once the receiver has sent a window ack
+    void SetWindowIndexBits(uint8_t indexBits);
+    void SetPeerWindowed(bool peerWindowed);
+    void ConfirmWindow(bool parity, uint8_t ack);
+    bool IsWindowed() const { return windowed; }
+    // Sent in place of the tlmConfirm bit with each windowed chunk
+    bool GetCurrentParity() const { return windowParity; }
 private:
+    uint8_t GetWindowPayload(uint8_t *outData, uint8_t maxLen);
+    void WindowNoProgress();
+
     uint8_t *data;
     uint8_t length;
     uint8_t currentOffset;
@@ -37,4 +48,14 @@ private:
     uint16_t maxWaitCount;
     uint8_t maxPackageIndex;
     stubborn_sender_state_e senderState;
+
+    uint8_t windowIndexBits;
+    bool peerWindowed;      // the receiver supports windowed messages
+    bool peerParity;        // the message parity last reported by the receiver
+    bool windowed;          // the current message is sent windowed
+    bool windowParity;
+    uint8_t windowChunks;   // number of chunks in the message, known once the first is sent
+    uint8_t windowBase;     // chunks 1 to windowBase have been acked
+    uint8_t windowNext;     // next chunk to send
+    uint32_t windowAcked;   // bit N is set once chunk N has been acked
 };
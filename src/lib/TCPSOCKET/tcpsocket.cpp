@@ -4,6 +4,7 @@
 #include "logging.h"
 
 #define TCP_PORT_BETAFLIGHT 5761 //port 5761 as used by BF configurator
+#define TCP_IN_CHUNK_SIZE 256
 
 TCPSOCKET *TCPSOCKET::instance = NULL;
 
@@ -11,43 +12,108 @@ void TCPSOCKET::begin()
 {
     instance = this;
 
+    FIFOin = new FIFO<BUFFER_INPUT_SIZE>();
+    FIFOfc = new FIFO<BUFFER_FC_SIZE>();
+    bridge = new MSPBRIDGE(this);
+
     TCPserver = new AsyncServer(TCP_PORT_BETAFLIGHT);
     TCPserver->onClient(handleNewClient, TCPserver);
     TCPserver->begin();
 }
 
-void TCPSOCKET::pumpData()
+void TCPSOCKET::pushEvent(clientEvent_e event, AsyncClient *client, const uint8_t *data, uint16_t len)
 {
-    // Data going from FC -> MSP2CRSF -> socket
-    if (crsf2msp->FIFOout.peekSize() > 0)
+    uint16_t const size = 1 + sizeof(client) + len;
+    // Data leaves room for the connect and disconnect of every client accepted, so they always get through
+    uint16_t const reserve = (event == CLIENT_DATA) ? 2 * TCP_MAX_CLIENTS * (2 + 1 + sizeof(client)) : 0;
+    FIFOin->lock();
+    bool const queued = FIFOin->available(size + 2 + reserve);
+    if (queued)
     {
-        const uint16_t len = crsf2msp->FIFOout.popSize();
-        uint8_t data[len];
-        crsf2msp->FIFOout.popBytes(data, len);
-        write(data, len);
+        FIFOin->pushSize(size);
+        FIFOin->push(event);
+        FIFOin->pushBytes((const uint8_t *)&client, sizeof(client));
+        FIFOin->pushBytes(data, len);
     }
+    FIFOin->unlock();
 
-    // Data going from socket -> MSP2CRSF -> FC
-    if (FIFOin->peekSize() > 0)
+    if (!queued)
     {
-        const uint16_t len = FIFOin->popSize();
+        DBGLN("TCP IN: buffer full! wanted: %u", (size + 2));
+    }
+}
+
+void TCPSOCKET::pumpEvents()
+{
+    while (FIFOin->size() > 0)
+    {
+        FIFOin->lock();
+        const uint16_t len = FIFOin->popSize() - 1 - sizeof(AsyncClient *);
+        clientEvent_e const event = (clientEvent_e)FIFOin->pop();
+        AsyncClient *client;
+        FIFOin->popBytes((uint8_t *)&client, sizeof(client));
         uint8_t data[len];
         FIFOin->popBytes(data, len);
-        msp2crsf->parse(data, len);
+        FIFOin->unlock();
+
+        switch (event)
+        {
+        case CLIENT_CONNECTED:
+            if (!bridge->addClient(client))
+            {
+                client->close();
+            }
+            break;
+        case CLIENT_DATA:
+            bridge->clientData(client, data, len);
+            break;
+        case CLIENT_DISCONNECTED:
+            bridge->removeClient(client);
+            delete client;
+            FIFOin->lock();
+            clientsQueued--;
+            FIFOin->unlock();
+            break;
+        }
+    }
+
+    while (FIFOfc->size() > 0)
+    {
+        FIFOfc->lock();
+        const uint16_t len = FIFOfc->popSize();
+        uint8_t data[len];
+        FIFOfc->popBytes(data, len);
+        FIFOfc->unlock();
+
+        bridge->crsfMspIn(data);
     }
 }
 
 /***
- * @brief Add a new MSP-in-CRSF data packet read from serial to start its journey to the socket
+ * @brief Add a new MSP-in-CRSF data packet read from serial to start its journey to the socket,
+ * it is queued for handle() as this is called from the serial task
  */
 void TCPSOCKET::crsfMspIn(uint8_t *data)
 {
-    if (!hasClient())
+    if (!bridge)
     {
         return;
     }
 
-    crsf2msp->parse(data);
+    uint8_t const len = CRSF_FRAME_SIZE(data[1]);
+    FIFOfc->lock();
+    bool const queued = FIFOfc->available(len + 2);
+    if (queued)
+    {
+        FIFOfc->pushSize(len);
+        FIFOfc->pushBytes(data, len);
+    }
+    FIFOfc->unlock();
+
+    if (!queued)
+    {
+        DBGLN("TCP FC IN: buffer full! wanted: %u", (len + 2));
+    }
 }
 
 /***
@@ -56,18 +122,12 @@ void TCPSOCKET::crsfMspIn(uint8_t *data)
  */
 uint8_t TCPSOCKET::crsfCrsfOutAvailable(uint32_t maxLen)
 {
-    if (!hasClient())
+    if (!bridge)
     {
         return 0;
     }
 
-    uint8_t len = msp2crsf->FIFOout.peek();
-    if (len >= msp2crsf->FIFOout.size() || len > maxLen)
-    {
-        return 0;
-    }
-
-    return len;
+    return bridge->crsfOutAvailable(maxLen);
 }
 
 /***
@@ -77,75 +137,54 @@ uint8_t TCPSOCKET::crsfCrsfOutAvailable(uint32_t maxLen)
  */
 void TCPSOCKET::crsfCrsfOutPop(uint8_t *data)
 {
-    msp2crsf->FIFOout.lock();
-    uint8_t OutPktLen = msp2crsf->FIFOout.pop();
-    msp2crsf->FIFOout.popBytes(data, OutPktLen);
-    msp2crsf->FIFOout.unlock();
+    bridge->crsfOutPop(data);
 }
 
 void TCPSOCKET::handle()
 {
-    if (!hasClient())
+    if (!bridge)
     {
         return;
     }
 
-    pumpData();
-
-    // check if there is data to send out the TCP port
-    if ((FIFOout->size()) > 0)
-    {
-        const uint16_t len = FIFOout->peekSize();
-        if (TCPclient->canSend() && TCPclient->space() > len)
-        {
-            FIFOout->popSize();
-            uint8_t data[len];
-            FIFOout->popBytes(data, len);
-            TCPclient->write((const char *)data, len);
-            DBGLN("TCP OUT SENT: Sent!: len: %u", len);
-        }
-        else
-        {
-            DBGLN("TCP OUT SENT: Have data but TCP not ready!: len: %u", len);
-        }
-    }
+    pumpEvents();
+    bridge->handle(millis());
 }
 
-void TCPSOCKET::write(uint8_t *data, uint16_t len) // doesn't send, just ques it up.
+uint32_t TCPSOCKET::space(void *client)
 {
-    if (!hasClient())
-    {
-        return;
-    }
+    AsyncClient *c = (AsyncClient *)client;
+    return c->canSend() ? c->space() : 0;
+}
 
-    if (FIFOout->available(len + 2))
-    {
-        FIFOout->pushSize(len);
-        FIFOout->pushBytes(data, len);
-        DBGLN("TCP OUT QUE: queued %u bytes", len);
-    }
-    else
-    {
-        DBGLN("TCP OUT QUE: No space in FIFOout! len: %u", len);
-    }
+void TCPSOCKET::write(void *client, const uint8_t *data, uint32_t len)
+{
+    ((AsyncClient *)client)->write((const char *)data, len);
+    DBGLN("TCP OUT SENT: Sent!: len: %u", len);
 }
 
 void TCPSOCKET::handleDataIn(void *arg, AsyncClient *client, void *data, size_t len)
 {
-    instance->TCPclient = client;
-
-    if (instance->FIFOin->available(len + 2)) // +2 because it takes 2 bytes to store the size of the FIFO chunk
+    // In pieces so a whole TCP segment doesn't need to fit, the bridge frames MSP from the stream
+    const uint8_t *bytes = (const uint8_t *)data;
+    while (len)
     {
-        instance->FIFOin->pushSize(len);
-        instance->FIFOin->pushBytes((uint8_t *)data, len);
-        DBGLN("TCP IN: queued %u bytes", len);
-    }
-    else
-    {
-        DBGLN("TCP IN: buffer full! wanted: %u, free: %u", (len + 2), instance->FIFOin->free());
+        uint16_t const chunk = len > TCP_IN_CHUNK_SIZE ? TCP_IN_CHUNK_SIZE : len;
+        instance->pushEvent(CLIENT_DATA, client, bytes, chunk);
+        bytes += chunk;
+        len -= chunk;
     }
 }
 
+void TCPSOCKET::clientDisconnect(AsyncClient *client)
+{
+    // An error is followed by a disconnect, only the first is queued. The client is deleted
+    // once the bridge has let go of it.
+    client->onError(nullptr, nullptr);
+    client->onDisconnect(nullptr, nullptr);
+    pushEvent(CLIENT_DISCONNECTED, client);
+}
+
 void TCPSOCKET::handleError(void *arg, AsyncClient *client, int8_t error)
 {
     DBGLN("\nclient %x connection error %s", client, client->errorToString(error));
@@ -158,53 +197,38 @@ void TCPSOCKET::handleDisconnect(void *arg, AsyncClient *client)
     instance->clientDisconnect(client);
 }
 
+void TCPSOCKET::handleRefusedDisconnect(void *arg, AsyncClient *client)
+{
+    // Never queued, so there is nothing else that could use it
+    delete client;
+}
+
 void TCPSOCKET::handleTimeOut(void *arg, AsyncClient *client, uint32_t time)
 {
     DBGLN("\nclient ACK timeout ip: %s", client->remoteIP().toString().c_str());
 }
 
-void TCPSOCKET::clientConnect(AsyncClient *client)
+void TCPSOCKET::handleNewClient(void *arg, AsyncClient *client)
 {
-    if (!FIFOin)
-    {
-        FIFOin = new FIFO<BUFFER_INPUT_SIZE>();
-    }
-    if (!FIFOout)
-    {
-        FIFOout = new FIFO<BUFFER_OUTPUT_SIZE>();
-    }
-    if (!crsf2msp)
-    {
-        crsf2msp = new CROSSFIRE2MSP();
-    }
-    if (!msp2crsf)
-    {
-        msp2crsf = new MSP2CROSSFIRE();
-    }
+    DBGLN("\nTCPSOCKET client (%x) connected ip: %s", client, client->remoteIP().toString().c_str());
 
-    if (hasClient())
+    instance->FIFOin->lock();
+    bool const accepted = instance->clientsQueued < TCP_MAX_CLIENTS;
+    if (accepted)
     {
-        TCPclient->close();
+        instance->clientsQueued++;
     }
-    TCPclient = client;
-}
+    instance->FIFOin->unlock();
 
-void TCPSOCKET::clientDisconnect(AsyncClient *client)
-{
-    // NOTE: FIFO buffers / crsf2msp / msp2crsf stick around because the code doesn't account for multiple clients
-    if (client == TCPclient)
+    if (!accepted)
     {
-      TCPclient = nullptr;
+        DBGLN("TCPSOCKET: too many clients, closing %x", client);
+        client->onDisconnect(handleRefusedDisconnect, NULL);
+        client->close();
+        return;
     }
-    client->close();
-    delete client;
-}
-
-void TCPSOCKET::handleNewClient(void *arg, AsyncClient *client)
-{
-    DBGLN("\nTCPSOCKET client (%x) connected ip: %s", client, client->remoteIP().toString().c_str());
 
-    instance->clientConnect(client);
+    instance->pushEvent(CLIENT_CONNECTED, client);
 
     // register events
     client->onData(handleDataIn, NULL);
@@ -214,4 +238,4 @@ void TCPSOCKET::handleNewClient(void *arg, AsyncClient *client)
     client->setRxTimeout(clientTimeoutS);
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -4,23 +4,30 @@
 #include <cstdint>
 #include <cstring>
 #include "ESPAsyncWebServer.h"
-#include "crsf2msp.h"
-#include "msp2crsf.h"
+#include "mspbridge.h"
 #include "FIFO.h"
 
-#define BUFFER_OUTPUT_SIZE 1024
 #define BUFFER_INPUT_SIZE 1024
+#define BUFFER_FC_SIZE 512
+// Clients accepted at once, more are closed as soon as they connect
+#define TCP_MAX_CLIENTS MSPBRIDGE_MAX_CLIENTS
 
-// buffers reads and write to the specified TCP port
+// Bridges MSP from several TCP clients to the FC, see MSPBRIDGE.
+// The bridge is only used from the WiFi task: the TCP callbacks and the frames from the FC
+// (which come from the serial task, on the other core on ESP32) are queued for handle().
 
-class TCPSOCKET
+class TCPSOCKET : public MspBridgeTransport
 {
 private:
     static TCPSOCKET *instance;
-    //std::vector<AsyncClient *> clients; // a list to hold all clients for MSP to WIFI bridge nut not using multi-client for now
+
+    typedef enum : uint8_t {
+        CLIENT_CONNECTED,
+        CLIENT_DATA,
+        CLIENT_DISCONNECTED
+    } clientEvent_e;
 
     AsyncServer *TCPserver = nullptr;
-    AsyncClient *TCPclient = nullptr;
     static const uint32_t clientTimeoutS = 2U;
 
     static void handleNewClient(void *arg, AsyncClient *client);
@@ -28,17 +35,19 @@ private:
     static void handleDisconnect(void *arg, AsyncClient *client);
     static void handleTimeOut(void *arg, AsyncClient *client, uint32_t time);
     static void handleError(void *arg, AsyncClient *client, int8_t error);
+    static void handleRefusedDisconnect(void *arg, AsyncClient *client);
 
-    bool hasClient() const { return (TCPclient != nullptr); }
-    void pumpData();
-    void write(uint8_t *data, uint16_t len);
-    void clientConnect(AsyncClient *client);
+    void pushEvent(clientEvent_e event, AsyncClient *client, const uint8_t *data = nullptr, uint16_t len = 0);
+    void pumpEvents();
     void clientDisconnect(AsyncClient *client);
 
-    FIFO<BUFFER_OUTPUT_SIZE> *FIFOout = nullptr;
+    // The client callbacks come from the TCP task, they are queued here and handled from the loop
     FIFO<BUFFER_INPUT_SIZE> *FIFOin = nullptr;
-    CROSSFIRE2MSP *crsf2msp = nullptr;
-    MSP2CROSSFIRE *msp2crsf = nullptr;
+    // Clients accepted and not yet deleted, each has at most a connect and a disconnect in FIFOin
+    uint8_t clientsQueued = 0;
+    // MSP-in-CRSF frames from the FC
+    FIFO<BUFFER_FC_SIZE> *FIFOfc = nullptr;
+    MSPBRIDGE *bridge = nullptr;
 
 public:
     void begin();
@@ -46,6 +55,9 @@ public:
     void crsfMspIn(uint8_t *data);
     uint8_t crsfCrsfOutAvailable(uint32_t maxLen);
     void crsfCrsfOutPop(uint8_t *data);
+
+    uint32_t space(void *client) override;
+    void write(void *client, const uint8_t *data, uint32_t len) override;
 };
 
-#endif
\ No newline at end of file
+#endif
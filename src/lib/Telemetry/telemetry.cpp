@@ -1,7 +1,5 @@
 #include "telemetry.h"
 
-#include <functional>
-
 #if CRSF_RX_MODULE
 
 #if defined(TARGET_RX) // enable MSP2WIFI for RX only at the moment
@@ -13,73 +11,71 @@ extern TCPSOCKET wifi2tcp;
 
 #include "helpers.h"
 
-// Size byte in FIFO contains bit to indicate if the frame is deleted
-#define IS_DEL(size) (size & bit(7))
-#define SET_DEL(size) (size | bit(7))
-#define SIZE(size) (size & ~bit(7))
-
-enum action_e
-{
-    ACTION_NEXT,       // continue searching queue for other messages
-    ACTION_IGNORE,     // the message matches; ignore the new one
-    ACTION_OVERWRITE,  // overwrite the queued message with the new one
-    ACTION_APPEND      // append the message to the end of the queue
-};
+#define TELEMETRY_NO_SLOT 0xFF
 
-typedef std::function<action_e(const crsf_header_t *newMessage, const TelemetryFifo &payloads, uint16_t queuePosition)> comparator_t;
+static_assert(TELEMETRY_SLOT_COUNT <= 32, "pendingSlots has one bit per slot");
 
-// For broadcast messages that have a 'source_id' as the first byte of the payload.
-static action_e sourceId(const crsf_header_t *newMessage, const TelemetryFifo &payloads, const uint16_t queuePosition)
+/**
+ * @brief Get the key of a frame in the telemetry store
+ * @return true if a newer frame with the same type and key replaces this one,
+ * false if every frame of this type is sent
+ */
+static bool frameKey(const uint8_t *package, uint16_t *key)
 {
-    if (payloads[queuePosition + CRSF_TELEMETRY_TYPE_INDEX + 1] == newMessage->payload[0])
+    const crsf_ext_header_t *header = (crsf_ext_header_t *)package;
+    *key = 0;
+    switch (header->type)
     {
-        return ACTION_OVERWRITE;
+    case CRSF_FRAMETYPE_RPM:
+    case CRSF_FRAMETYPE_TEMP:
+    case CRSF_FRAMETYPE_CELLS:
+        // Broadcast messages that have a 'source_id' as the first byte of the payload
+        *key = package[CRSF_TELEMETRY_TYPE_INDEX + 1];
+        return true;
+    case CRSF_FRAMETYPE_ARDUPILOT_RESP:
+        // Only the latest Ardupilot status text, but all the passthrough frames
+        *key = CRSF_AP_CUSTOM_TELEM_STATUS_TEXT;
+        return package[CRSF_TELEMETRY_TYPE_INDEX + 1] == CRSF_AP_CUSTOM_TELEM_STATUS_TEXT;
+    case CRSF_FRAMETYPE_DEVICE_INFO:
+        *key = (header->dest_addr << 8) | header->orig_addr;
+        return true;
+    case CRSF_FRAMETYPE_PARAMETER_SETTINGS_ENTRY:
+        return true;
+    case CRSF_FRAMETYPE_COMMAND:
+        // Only the latest adaptive hopping proposal (Non CRSF, dest=a src=f), it is resent until echoed
+        return header->dest_addr == 'a' && header->orig_addr == 'f';
+    default:
+        // Only the latest of each broadcast message
+        return header->type < CRSF_FRAMETYPE_DEVICE_PING;
     }
-    return ACTION_NEXT;
 }
 
-// Comparator for Ardupilot Status Text message
-static action_e statusText(const crsf_header_t *newMessage, const TelemetryFifo &payloads, const uint16_t queuePosition)
+static inline uint8_t indexBucket(uint8_t type, uint16_t key)
 {
-    if (payloads[queuePosition + CRSF_TELEMETRY_TYPE_INDEX + 1] == CRSF_AP_CUSTOM_TELEM_STATUS_TEXT &&
-        newMessage->payload[0] == CRSF_AP_CUSTOM_TELEM_STATUS_TEXT)
-    {
-        return ACTION_OVERWRITE;
-    }
-    return ACTION_NEXT;
+    return (type ^ key ^ (key >> 8)) % TELEMETRY_INDEX_BUCKETS;
 }
 
-static action_e extended_dest_origin(const crsf_header_t *newMessage, const TelemetryFifo &payloads, const uint16_t queuePosition)
+inline bool isPrioritised(const crsf_frame_type_e frameType)
 {
-    if (payloads[queuePosition + 3] == ((crsf_ext_header_t *)newMessage)->dest_addr &&
-        payloads[queuePosition + 4] == ((crsf_ext_header_t *)newMessage)->orig_addr)
-    {
-        return ACTION_OVERWRITE;
-    }
-    return ACTION_NEXT;
+    return frameType >= CRSF_FRAMETYPE_DEVICE_PING && frameType <= CRSF_FRAMETYPE_PARAMETER_WRITE;
 }
 
-static action_e comp_OVERWRITE(const crsf_header_t *newMessage, const TelemetryFifo &payloads, const uint16_t queuePosition)
+// true if slot a should be sent before slot b: the parameter frames first, then in order of arrival
+static inline bool sendsBefore(const telemetrySlot_t &a, const telemetrySlot_t &b)
 {
-    return ACTION_OVERWRITE;
+    const bool aPrioritised = isPrioritised((crsf_frame_type_e)a.type);
+    if (aPrioritised != isPrioritised((crsf_frame_type_e)b.type))
+        return aPrioritised;
+    return (int16_t)(a.seq - b.seq) < 0;
 }
 
-static struct
+// true if slot a should be dropped before slot b to make room: the oldest, parameter frames last
+static inline bool dropsBefore(const telemetrySlot_t &a, const telemetrySlot_t &b)
 {
-    crsf_frame_type_e type;
-    comparator_t comparator;
-} comparators[] = {
-    {CRSF_FRAMETYPE_RPM, sourceId},
-    {CRSF_FRAMETYPE_TEMP, sourceId},
-    {CRSF_FRAMETYPE_CELLS, sourceId},
-    {CRSF_FRAMETYPE_ARDUPILOT_RESP, statusText},
-    {CRSF_FRAMETYPE_DEVICE_INFO, extended_dest_origin},
-    {CRSF_FRAMETYPE_PARAMETER_SETTINGS_ENTRY, comp_OVERWRITE },
-};
-
-inline bool isPrioritised(const crsf_frame_type_e frameType)
-{
-    return frameType >= CRSF_FRAMETYPE_DEVICE_PING && frameType <= CRSF_FRAMETYPE_PARAMETER_WRITE;
+    const bool aPrioritised = isPrioritised((crsf_frame_type_e)a.type);
+    if (aPrioritised != isPrioritised((crsf_frame_type_e)b.type))
+        return !aPrioritised;
+    return (int16_t)(a.seq - b.seq) < 0;
 }
 
 Telemetry::Telemetry()
@@ -146,8 +142,11 @@ void Telemetry::ResetState()
 {
     telemetry_state = TELEMETRY_IDLE;
     currentTelemetryByte = 0;
-    prioritizedCount = 0;
-    messagePayloads.flush();
+    memset(indexBuckets, TELEMETRY_NO_SLOT, sizeof(indexBuckets));
+    pendingSlots = 0;
+    nextSeq = 0;
+    poolEnd = 0;
+    poolUsed = 0;
 }
 
 bool Telemetry::RXhandleUARTin(uint8_t data)
@@ -286,157 +285,168 @@ void Telemetry::AppendTelemetryPackage(uint8_t *package)
 #endif
 
     const uint8_t messageSize = CRSF_FRAME_SIZE(package[CRSF_TELEMETRY_LENGTH_INDEX]);
-    auto action = ACTION_APPEND;
-    comparator_t comparator = nullptr;
-
-    // Find the comparator for this message type (if any)
-    for (size_t i = 0 ; i < ARRAY_SIZE(comparators) ; i++)
+    if (messageSize > CRSF_MAX_PACKET_LEN)
     {
-        if (comparators[i].type == header->type)
-        {
-            comparator = comparators[i].comparator;
-            break;
-        }
+        return;
     }
+    uint16_t key;
+    const bool keyed = frameKey(package, &key);
 
 #if defined(PLATFORM_ESP32) && SOC_CPU_CORES_NUM > 1
     std::lock_guard<std::mutex> lock(mutex);
 #endif
-    // If we have a comparator or this is a 'broadcast' message we will look for a matching message in the queue and default to overwrite if we find one
-    uint16_t overwritePosition = 0;
-    if (comparator != nullptr || header->type < CRSF_FRAMETYPE_DEVICE_PING)
+    uint8_t slot = keyed ? findSlot(header->type, key) : TELEMETRY_NO_SLOT;
+    uint16_t seq = nextSeq++;
+    if (slot != TELEMETRY_NO_SLOT)
     {
-        for (uint16_t i = 0; i < messagePayloads.size();)
+        // A frame that is already waiting keeps its place in the queue, only the contents are replaced
+        if (messageSize <= slots[slot].size)
         {
-            const auto size = messagePayloads[i];
-            // If the message at this point in the queue is not deleted, and it matches this comparator, then we check it
-            if (!IS_DEL(size) && messagePayloads[i + 1 + CRSF_TELEMETRY_TYPE_INDEX] == header->type)
-            {
-                const auto whatToDo = comparator == nullptr ? ACTION_OVERWRITE : comparator(header, messagePayloads, i + 1);
-                if (whatToDo != ACTION_NEXT)
-                {
-                    overwritePosition = i;
-                    action = whatToDo;
-                    break;
-                }
-            }
-            i += 1 + SIZE(size);
+            memcpy(&pool[slots[slot].offset], package, messageSize);
+            return;
         }
+        seq = slots[slot].seq;
+        freeSlot(slot);
     }
-    if (isPrioritised(header->type))
+
+    slot = allocSlot(messageSize);
+    telemetrySlot_t &s = slots[slot];
+    s.seq = seq;
+    s.key = key;
+    s.type = header->type;
+    s.keyed = keyed;
+    if (keyed)
     {
-        prioritizedCount++;
+        const uint8_t bucket = indexBucket(header->type, key);
+        s.next = indexBuckets[bucket];
+        indexBuckets[bucket] = slot;
     }
+    memcpy(&pool[s.offset], package, messageSize);
+    pendingSlots |= 1U << slot;
+}
 
-    switch (action)
+uint8_t Telemetry::findSlot(uint8_t type, uint16_t key) const
+{
+    for (uint8_t i = indexBuckets[indexBucket(type, key)]; i != TELEMETRY_NO_SLOT; i = slots[i].next)
     {
-    case ACTION_IGNORE:
-        break;
-    case ACTION_OVERWRITE:
-        // Check again because our initial check was performed without locking
-        if (!IS_DEL(messagePayloads[overwritePosition]))
+        if (slots[i].type == type && slots[i].key == key)
+            return i;
+    }
+    return TELEMETRY_NO_SLOT;
+}
+
+/**
+ * @brief Get an empty slot with size bytes of the pool. If the store is full, drop the
+ * oldest frames until there is room, keeping the parameter frames for as long as possible
+ */
+uint8_t Telemetry::allocSlot(uint8_t size)
+{
+    for (;;)
+    {
+        if (pendingSlots != UINT32_MAX >> (32 - TELEMETRY_SLOT_COUNT) && poolUsed + size <= TELEMETRY_POOL_SIZE)
         {
-            if (messagePayloads[overwritePosition] >= messageSize)
-            {
-                for (uint16_t i = 0 ; i<messageSize; i++)
-                {
-                    messagePayloads.set(overwritePosition + i + 1, package[i]);
-                }
-                break;
-            }
-            // Mark the current queued entry as deleted
-            messagePayloads.set(overwritePosition, SET_DEL(messagePayloads[overwritePosition]));
+            if (poolEnd + size > TELEMETRY_POOL_SIZE)
+                compactPool();
+            const uint8_t slot = __builtin_ctz(~pendingSlots);
+            slots[slot].offset = poolEnd;
+            slots[slot].size = size;
+            poolEnd += size;
+            poolUsed += size;
+            return slot;
         }
-        // fallthrough to APPEND
-    default:
-        // If there's NOT enough room on the FIFO for this message, pop until there is
-        while (!messagePayloads.available(messageSize + 1))
+
+        uint8_t victim = TELEMETRY_NO_SLOT;
+        for (uint32_t pending = pendingSlots; pending; pending &= pending - 1)
         {
-            const uint8_t sz = SIZE(messagePayloads.pop());
-            messagePayloads.skip(sz);
+            const uint8_t i = __builtin_ctz(pending);
+            if (victim == TELEMETRY_NO_SLOT || dropsBefore(slots[i], slots[victim]))
+                victim = i;
         }
-        messagePayloads.push(messageSize);
-        messagePayloads.pushBytes(package, messageSize);
-        break;
+        freeSlot(victim);
     }
 }
 
-bool Telemetry::GetNextPayload(uint8_t* nextPayloadSize, uint8_t *currentPayload)
+/**
+ * @brief Move all the frames to the start of the pool, so the space freed between them
+ * can be allocated again
+ */
+void Telemetry::compactPool()
 {
-#if defined(PLATFORM_ESP32) && SOC_CPU_CORES_NUM > 1
-    std::lock_guard<std::mutex> lock(mutex);
-#endif
-    if (prioritizedCount)
+    uint16_t end = 0;
+    uint32_t todo = pendingSlots;
+    while (todo)
     {
-        // handle prioritised messages first
-        for (uint16_t i = 0; i < messagePayloads.size();)
+        uint8_t lowest = __builtin_ctz(todo);
+        for (uint32_t rest = todo & (todo - 1); rest; rest &= rest - 1)
         {
-            const auto size = messagePayloads[i];
-            // If the message at this point in the queue is not deleted, and it's a SETTINGS_ENTRY then we're going to return it
-            if (isPrioritised((crsf_frame_type_e)messagePayloads[i + 1 + CRSF_TELEMETRY_TYPE_INDEX]))
-            {
-                if (!IS_DEL(size))
-                {
-                    prioritizedCount--;
-                    // If this is the first item in the queue, use pop() instead to free the space
-                    if (i == 0)
-                    {
-                        messagePayloads.pop();
-                        messagePayloads.popBytes(currentPayload, size);
-                    }
-                    else // Copy the frame to the current payload
-                    {
-                        for (uint16_t pos = 0 ; pos < size ; pos++)
-                        {
-                            currentPayload[pos] = messagePayloads[i + 1 + pos];
-                        }
-                        // Mark the current queued entry as deleted
-                        messagePayloads.set(i, SET_DEL(size));
-                    }
-                    // set the pointers to the payload
-                    *nextPayloadSize = CRSF_FRAME_SIZE(currentPayload[CRSF_TELEMETRY_LENGTH_INDEX]);
-                    return true;
-                }
-            }
-            i += 1 + SIZE(size);
+            const uint8_t i = __builtin_ctz(rest);
+            if (slots[i].offset < slots[lowest].offset)
+                lowest = i;
         }
-        // Didn't find one, so we'll reset the counter
-        prioritizedCount = 0;
+        memmove(&pool[end], &pool[slots[lowest].offset], slots[lowest].size);
+        slots[lowest].offset = end;
+        end += slots[lowest].size;
+        todo &= ~(1U << lowest);
     }
+    poolEnd = end;
+}
 
-    // return the 'head' of the queue
-    while (messagePayloads.size() > 0)
+void Telemetry::unlinkSlot(uint8_t slot)
+{
+    uint8_t *link = &indexBuckets[indexBucket(slots[slot].type, slots[slot].key)];
+    while (*link != TELEMETRY_NO_SLOT)
     {
-        const auto size = messagePayloads.pop();
-        if (IS_DEL(size))
+        if (*link == slot)
         {
-            // This message is deleted, skip it
-            messagePayloads.skip(SIZE(size));
-            continue;
+            *link = slots[slot].next;
+            return;
         }
-        messagePayloads.popBytes(currentPayload, size);
-        *nextPayloadSize = CRSF_FRAME_SIZE(currentPayload[CRSF_TELEMETRY_LENGTH_INDEX]);
-        return true;
+        link = &slots[*link].next;
+    }
+}
+
+void Telemetry::freeSlot(uint8_t slot)
+{
+    telemetrySlot_t &s = slots[slot];
+    if (s.keyed)
+        unlinkSlot(slot);
+    pendingSlots &= ~(1U << slot);
+    poolUsed -= s.size;
+    // The space at the end is reclaimed at once, anything else when the pool is compacted
+    if (s.offset + s.size == poolEnd)
+        poolEnd = s.offset;
+    if (pendingSlots == 0)
+        poolEnd = 0;
+}
+
+bool Telemetry::GetNextPayload(uint8_t* nextPayloadSize, uint8_t *currentPayload)
+{
+#if defined(PLATFORM_ESP32) && SOC_CPU_CORES_NUM > 1
+    std::lock_guard<std::mutex> lock(mutex);
+#endif
+    uint8_t best = TELEMETRY_NO_SLOT;
+    for (uint32_t pending = pendingSlots; pending; pending &= pending - 1)
+    {
+        const uint8_t i = __builtin_ctz(pending);
+        if (best == TELEMETRY_NO_SLOT || sendsBefore(slots[i], slots[best]))
+            best = i;
+    }
+    if (best == TELEMETRY_NO_SLOT)
+    {
+        return false;
     }
 
-    return false;
+    const uint8_t *data = &pool[slots[best].offset];
+    *nextPayloadSize = CRSF_FRAME_SIZE(data[CRSF_TELEMETRY_LENGTH_INDEX]);
+    memcpy(currentPayload, data, *nextPayloadSize);
+    freeSlot(best);
+    return true;
 }
 
 // This method is only used in unit testing!
 int Telemetry::UpdatedPayloadCount()
 {
-    int retVal = 0;
-    unsigned pos = 0;
-    while (pos < messagePayloads.size())
-    {
-        uint8_t sz = messagePayloads[pos];
-        if (!IS_DEL(sz))
-        {
-            retVal++;
-        }
-        pos += 1 + SIZE(sz);
-    }
-    return retVal;
+    return __builtin_popcount(pendingSlots);
 }
 
 #endif
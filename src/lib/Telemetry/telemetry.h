@@ -1,14 +1,28 @@
 #pragma once
 
 #include "CRSF.h"
-#include "FIFO.h"
 
 #if defined(PLATFORM_ESP32)
 #include <mutex>
 #endif
 
-#define TELEMETRY_FIFO_SIZE 512
-typedef FIFO<TELEMETRY_FIFO_SIZE> TelemetryFifo;
+// Bytes of frames the telemetry store can hold, shared by all the slots
+#define TELEMETRY_POOL_SIZE 512
+// Number of frames the telemetry store can hold, at most 32 (one bit each in the pending mask)
+#define TELEMETRY_SLOT_COUNT 32
+// Hash buckets of the (frame type, key) index of the slots
+#define TELEMETRY_INDEX_BUCKETS 16
+
+// A frame waiting to be sent, its bytes are in the pool
+typedef struct {
+    uint16_t seq;      // arrival order
+    uint16_t key;
+    uint16_t offset;   // of the frame in the pool
+    uint8_t size;      // pool bytes held, a keyed frame can be replaced by a shorter one in place
+    uint8_t type;
+    uint8_t next;      // next slot in the same index bucket
+    bool keyed;        // newer frames with the same type and key replace this one
+} telemetrySlot_t;
 
 enum CustomTelemSubTypeID : uint8_t {
     CRSF_AP_CUSTOM_TELEM_SINGLE_PACKET_PASSTHROUGH = 0xF0,
@@ -42,18 +56,28 @@ public:
     bool GetNextPayload(uint8_t* nextPayloadSize, uint8_t *payloadData);
     int UpdatedPayloadCount();
     void AppendTelemetryPackage(uint8_t *package);
-    uint8_t GetFifoFullPct() { return (TELEMETRY_FIFO_SIZE - messagePayloads.free()) * 100 / TELEMETRY_FIFO_SIZE; }
+    uint8_t GetFifoFullPct() { return poolUsed * 100 / TELEMETRY_POOL_SIZE; }
 private:
 #if defined(PLATFORM_ESP32) && SOC_CPU_CORES_NUM > 1
     std::mutex mutex;
 #endif
-    TelemetryFifo messagePayloads;
+    telemetrySlot_t slots[TELEMETRY_SLOT_COUNT];
+    uint8_t indexBuckets[TELEMETRY_INDEX_BUCKETS];
+    uint32_t pendingSlots;
+    uint16_t nextSeq;
+    uint8_t pool[TELEMETRY_POOL_SIZE];
+    uint16_t poolEnd;   // the pool is allocated from here, anything freed below it is reclaimed by compactPool()
+    uint16_t poolUsed;
 
     bool processInternalTelemetryPackage(uint8_t *package);
+    uint8_t findSlot(uint8_t type, uint16_t key) const;
+    uint8_t allocSlot(uint8_t size);
+    void compactPool();
+    void unlinkSlot(uint8_t slot);
+    void freeSlot(uint8_t slot);
     uint8_t CRSFinBuffer[CRSF_MAX_PACKET_LEN];
     telemetry_state_s telemetry_state;
     uint8_t currentTelemetryByte;
-    uint8_t prioritizedCount;
     bool callBootloader;
     bool callEnterBind;
     bool callUpdateModelMatch;
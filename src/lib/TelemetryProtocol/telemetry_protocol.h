@@ -12,4 +12,19 @@
 #define ELRS_MSP_BUFFER 65
 #define ELRS_MSP_MAX_PACKAGES ((ELRS_MSP_BUFFER/ELRS4_MSP_BYTES_PER_CALL)+1)
 
+// Width of the msp_ul packageIndex field
+#define ELRS4_MSP_INDEX_BITS 7
+#define ELRS8_MSP_INDEX_BITS 5
+// Windowed (selective repeat) packageIndex: the top bit marks the chunk as windowed, which a
+// stop-and-wait index never reaches, the next marks the last chunk and the rest is the chunk number from 1
+#define STUBBORN_WINDOW_FLAG(bits) (1 << ((bits) - 1))
+#define STUBBORN_WINDOW_LAST(bits) (1 << ((bits) - 2))
+#define STUBBORN_WINDOW_CHUNK_MASK(bits) (STUBBORN_WINDOW_LAST(bits) - 1)
+// Chunks in flight before the oldest unacked one must be acked
+#define STUBBORN_WINDOW_SIZE 4
+// Window ack: bits 0-2 are the count of chunks received in sequence (mod 8), bits 3-5 flag the receipt
+// of the STUBBORN_WINDOW_SIZE-1 chunks after the first missing one
+#define STUBBORN_WINDOW_ACK_COUNT_MASK 0x07
+#define STUBBORN_WINDOW_ACK_BITS_SHIFT 3
+
 #define AP_MAX_BUF_LEN  64
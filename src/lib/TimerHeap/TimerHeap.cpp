@@ -0,0 +1,133 @@
+#include "TimerHeap.h"
+
+TimerHeap::TimerHeap(uint8_t capacity)
+    : heap(nullptr), pos(nullptr), deadline(nullptr), capacity(0), count(0)
+{
+    resize(capacity);
+}
+
+TimerHeap::~TimerHeap()
+{
+    delete[] heap;
+    delete[] pos;
+    delete[] deadline;
+}
+
+void TimerHeap::resize(uint8_t newCapacity)
+{
+    // An id of 255 would collide with NOT_SCHEDULED
+    if (newCapacity == NOT_SCHEDULED)
+        --newCapacity;
+
+    if (newCapacity != capacity)
+    {
+        delete[] heap;
+        delete[] pos;
+        delete[] deadline;
+        heap = newCapacity ? new uint8_t[newCapacity] : nullptr;
+        pos = newCapacity ? new uint8_t[newCapacity] : nullptr;
+        deadline = newCapacity ? new uint32_t[newCapacity] : nullptr;
+        capacity = newCapacity;
+    }
+    clear();
+}
+
+void TimerHeap::clear()
+{
+    for (uint8_t id = 0; id < capacity; ++id)
+    {
+        pos[id] = NOT_SCHEDULED;
+    }
+    count = 0;
+}
+
+void ICACHE_RAM_ATTR TimerHeap::place(uint8_t at, uint8_t id)
+{
+    heap[at] = id;
+    pos[id] = at;
+}
+
+void ICACHE_RAM_ATTR TimerHeap::siftUp(uint8_t at)
+{
+    uint8_t const id = heap[at];
+    while (at > 0)
+    {
+        uint8_t const parent = (at - 1) / 2;
+        if (!before(id, heap[parent]))
+            break;
+        place(at, heap[parent]);
+        at = parent;
+    }
+    place(at, id);
+}
+
+void ICACHE_RAM_ATTR TimerHeap::siftDown(uint8_t at)
+{
+    uint8_t const id = heap[at];
+    for (;;)
+    {
+        unsigned child = 2 * at + 1;
+        if (child >= count)
+            break;
+        if (child + 1 < count && before(heap[child + 1], heap[child]))
+            ++child;
+        if (!before(heap[child], id))
+            break;
+        place(at, heap[child]);
+        at = child;
+    }
+    place(at, id);
+}
+
+void ICACHE_RAM_ATTR TimerHeap::removeAt(uint8_t at)
+{
+    uint8_t const removed = heap[at];
+    pos[removed] = NOT_SCHEDULED;
+    --count;
+    if (at == count)
+        return;
+
+    // Fill the hole with the last timer, which may belong above or below it
+    place(at, heap[count]);
+    if (at > 0 && before(heap[at], heap[(at - 1) / 2]))
+        siftUp(at);
+    else
+        siftDown(at);
+}
+
+void ICACHE_RAM_ATTR TimerHeap::schedule(uint8_t id, uint32_t when)
+{
+    if (id >= capacity)
+        return;
+
+    if (pos[id] == NOT_SCHEDULED)
+    {
+        deadline[id] = when;
+        place(count, id);
+        siftUp(count++);
+        return;
+    }
+
+    bool const earlier = (int32_t)(when - deadline[id]) < 0;
+    deadline[id] = when;
+    if (earlier)
+        siftUp(pos[id]);
+    else
+        siftDown(pos[id]);
+}
+
+void ICACHE_RAM_ATTR TimerHeap::cancel(uint8_t id)
+{
+    if (isScheduled(id))
+        removeAt(pos[id]);
+}
+
+int ICACHE_RAM_ATTR TimerHeap::popDue(uint32_t now)
+{
+    if (count == 0 || (int32_t)(now - deadline[heap[0]]) < 0)
+        return -1;
+
+    uint8_t const id = heap[0];
+    removeAt(0);
+    return id;
+}
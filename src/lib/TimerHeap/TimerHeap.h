@@ -0,0 +1,80 @@
+#pragma once
+
+#include "targets.h"
+
+/**
+ * @brief A min-heap of timers ordered by deadline, so finding what is due costs
+ * one compare instead of a pass over every timer.
+ *
+ * Timers are identified by an id from 0 to capacity-1, which the owner uses to
+ * index its own table of what to run. Each id is in the heap at most once and
+ * its position is tracked, so rescheduling or cancelling a timer moves it in
+ * place. Deadlines are compared as the signed difference, so the order holds
+ * across the wrap of millis() or micros() as long as all the pending deadlines
+ * are within 2^31 of each other. Timers with the same deadline come out
+ * lowest id first.
+ */
+class TimerHeap
+{
+public:
+    explicit TimerHeap(uint8_t capacity = 0);
+    ~TimerHeap();
+
+    /**
+     * @brief Make room for `capacity` ids, cancelling all the timers
+     */
+    void resize(uint8_t capacity);
+
+    /**
+     * @brief Cancel all the timers
+     */
+    void clear();
+
+    /**
+     * @brief Set the deadline of `id`, adding it if it is not already scheduled
+     */
+    void schedule(uint8_t id, uint32_t deadline);
+
+    /**
+     * @brief Remove `id` if it is scheduled
+     */
+    void cancel(uint8_t id);
+
+    bool isScheduled(uint8_t id) const { return id < capacity && pos[id] != NOT_SCHEDULED; }
+    bool empty() const { return count == 0; }
+    uint8_t size() const { return count; }
+
+    /**
+     * @brief The earliest deadline, only valid when not empty()
+     */
+    uint32_t nextDeadline() const { return deadline[heap[0]]; }
+
+    /**
+     * @brief Remove and return the id with the earliest deadline if that deadline
+     * is at or before `now`
+     * @return the id, or -1 if no timer is due
+     */
+    int popDue(uint32_t now);
+
+private:
+    static const uint8_t NOT_SCHEDULED = 0xff;
+
+    uint8_t *heap;          // ids in heap order
+    uint8_t *pos;           // position of each id in heap, or NOT_SCHEDULED
+    uint32_t *deadline;     // deadline of each id
+    uint8_t capacity;
+    uint8_t count;
+
+    TimerHeap(const TimerHeap &) = delete;
+    TimerHeap &operator=(const TimerHeap &) = delete;
+
+    bool before(uint8_t a, uint8_t b) const
+    {
+        int32_t const diff = (int32_t)(deadline[a] - deadline[b]);
+        return diff < 0 || (diff == 0 && a < b);
+    }
+    void place(uint8_t at, uint8_t id);
+    void siftUp(uint8_t at);
+    void siftDown(uint8_t at);
+    void removeAt(uint8_t at);
+};
@@ -34,7 +34,9 @@
 #include "common.h"
 #include "POWERMGNT.h"
 #include "FHSS.h"
+#include "LQSTATS.h"
 #include "hwTimer.h"
+#include "ISRProfile.h"
 #include "logging.h"
 #include "options.h"
 #include "helpers.h"
@@ -573,6 +575,61 @@ static void WebUpdateGetTarget(AsyncWebServerRequest *request)
   request->send(response);
 }
 
+static void WebUpdateGetLinkStats(AsyncWebServerRequest *request)
+{
+  JsonDocument json;
+  JsonArray lq = json["lq"].to<JsonArray>();
+  for (unsigned w = 0; w < LQSTATS_WINDOW_COUNT; ++w)
+    lq.add(LQStats.getLQ((lqStatsWindow_e)w));
+  JsonArray bursts = json["bursts"].to<JsonArray>();
+  for (unsigned b = 0; b < LQSTATS_BURST_BUCKETS; ++b)
+    bursts.add(LQStats.getBurstCount(b));
+  json["max-burst"] = LQStats.getMaxBurst();
+  JsonArray channels = json["channel-loss"].to<JsonArray>();
+  for (unsigned ch = 0; ch < FHSSgetChannelCount() && ch < LQSTATS_MAX_CHANNELS; ++ch)
+  {
+    JsonArray chStats = channels.add<JsonArray>();
+    chStats.add(LQStats.getChannelLoss(ch));
+    chStats.add(LQStats.getChannelPeriods(ch));
+  }
+
+  AsyncResponseStream *response = request->beginResponseStream("application/json");
+  serializeJson(json, *response);
+  request->send(response);
+}
+
+#if defined(DEBUG_ISR_PROFILE)
+static void WebUpdateGetISRProfile(AsyncWebServerRequest *request)
+{
+  static const char *const names[ISRPROF_COUNT] = { "rxdone", "txdone", "tick", "tock" };
+  isrProfileStats_t stats[ISRPROF_COUNT];
+  ISRProfile::snapshot(stats);
+  if (request->hasArg("reset"))
+    ISRProfile::reset();
+
+  // Everything is reported in us, the histogram buckets are in cycles
+  uint32_t const cyclesPerUs = ISRProfile::cyclesPerUs();
+  JsonDocument json;
+  json["cycles-per-us"] = cyclesPerUs;
+  json["bucket-shift"] = ISRPROF_BUCKET_SHIFT;
+  for (unsigned i = 0; i < ISRPROF_COUNT; ++i)
+  {
+    JsonObject isr = json[names[i]].to<JsonObject>();
+    isr["count"] = stats[i].count;
+    isr["min"] = stats[i].minCycles / cyclesPerUs;
+    isr["max"] = stats[i].maxCycles / cyclesPerUs;
+    isr["max-since-timer"] = stats[i].maxSinceTimerCycles / cyclesPerUs;
+    JsonArray histogram = isr["histogram"].to<JsonArray>();
+    for (unsigned b = 0; b < ISRPROF_BUCKETS; ++b)
+      histogram.add(stats[i].histogram[b]);
+  }
+
+  AsyncResponseStream *response = request->beginResponseStream("application/json");
+  serializeJson(json, *response);
+  request->send(response);
+}
+#endif
+
 static void WebUpdateSendNetworks(AsyncWebServerRequest *request)
 {
   int numNetworks = WiFi.scanComplete();
@@ -888,7 +945,7 @@ static void HandleContinuousWave(AsyncWebServerRequest *request) {
 #else
     Radio.startCWTest(FHSSconfig->freq_center, radio);
 #if defined(RADIO_SX127X)
-    deferExecutionMillis(50, [radio](){ Radio.cwRepeat(radio); });
+    deferExecutionMillis(50, [](void *ctx){ Radio.cwRepeat((SX12XX_Radio_Number_t)(uintptr_t)ctx); }, (void *)(uintptr_t)radio);
 #endif
 #endif
   } else {
@@ -1068,6 +1125,10 @@ static void startServices()
   server.on("/config", HTTP_GET, GetConfiguration);
   server.on("/access", WebUpdateAccessPoint);
   server.on("/target", WebUpdateGetTarget);
+  server.on("/linkstats.json", WebUpdateGetLinkStats);
+#if defined(DEBUG_ISR_PROFILE)
+  server.on("/isrprofile.json", WebUpdateGetISRProfile);
+#endif
   server.on("/firmware.bin", WebUpdateGetFirmware);
 
   server.on("/update", HTTP_POST, WebUploadResponseHandler, WebUploadDataHandler);
@@ -2,7 +2,106 @@
 #include "targets.h"
 #include "logging.h"
 
-#if !defined(TARGET_NATIVE)
+#if defined(PLATFORM_ESP8266)
+#include "ConfigJournal.h"
+
+extern "C" uint32_t _EEPROM_start;
+
+/**
+ * The EEPROM library rewrites its whole flash sector for every commit, which takes
+ * ~50ms during which nothing else runs. Instead the sector holds a journal of the
+ * bytes that changed, see ConfigJournal.
+ */
+class EepromSector : public FlashSectors
+{
+public:
+    uint32_t sectorSize() const override { return SPI_FLASH_SEC_SIZE; }
+    uint8_t sectorCount() const override { return 1; }
+
+    void read(uint32_t addr, uint8_t *data, uint32_t len) override
+    {
+        ESP.flashRead(base() + addr, data, len);
+    }
+
+    void write(uint32_t addr, const uint8_t *data, uint32_t len) override
+    {
+        ESP.flashWrite(base() + addr, data, len);
+    }
+
+    void erase(uint8_t sector) override
+    {
+        ESP.flashEraseSector(base() / SPI_FLASH_SEC_SIZE + sector);
+    }
+
+private:
+    static uint32_t base() { return (uint32_t)&_EEPROM_start - 0x40200000; }
+};
+
+static EepromSector sector;
+static ConfigJournal journal;
+
+void
+ELRS_EEPROM::Begin()
+{
+    journal.begin(&sector, RESERVED_EEPROM_SIZE);
+    if (!journal.load())
+    {
+        // The config as written by the EEPROM library, journalled on the next commit
+        uint8_t *legacy = new uint8_t[RESERVED_EEPROM_SIZE];
+        sector.read(0, legacy, RESERVED_EEPROM_SIZE);
+        uint16_t len = RESERVED_EEPROM_SIZE;
+        while (len && legacy[len - 1] == 0xff)
+        {
+            --len;
+        }
+        journal.import(legacy, len);
+        delete[] legacy;
+    }
+}
+
+uint8_t
+ELRS_EEPROM::ReadByte(const uint32_t address)
+{
+    if (address >= RESERVED_EEPROM_SIZE)
+    {
+        // address is out of bounds
+        ERRLN("EEPROM address is out of bounds");
+        return 0;
+    }
+    return journal.read(address);
+}
+
+void
+ELRS_EEPROM::WriteByte(const uint32_t address, const uint8_t value)
+{
+    if (address >= RESERVED_EEPROM_SIZE)
+    {
+        // address is out of bounds
+        ERRLN("EEPROM address is out of bounds");
+        return;
+    }
+    journal.write(address, value);
+}
+
+void
+ELRS_EEPROM::Commit()
+{
+    journal.commit();
+}
+
+bool
+ELRS_EEPROM::CompactPending()
+{
+    return journal.compactPending();
+}
+
+void
+ELRS_EEPROM::Compact()
+{
+    journal.compact();
+}
+
+#elif !defined(TARGET_NATIVE)
 #include <EEPROM.h>
 
 void
@@ -44,4 +143,16 @@ ELRS_EEPROM::Commit()
     }
 }
 
+bool
+ELRS_EEPROM::CompactPending()
+{
+    // NVS is already a log, the library compacts it
+    return false;
+}
+
+void
+ELRS_EEPROM::Compact()
+{
+}
+
 #endif /* !TARGET_NATIVE */
\ No newline at end of file
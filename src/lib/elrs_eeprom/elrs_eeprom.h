@@ -13,6 +13,10 @@ public:
     void WriteByte(const uint32_t address, const uint8_t value);
     void Commit();
 
+    // Set when a journal sector is nearly full, Compact() should be called while the link is idle
+    bool CompactPending();
+    void Compact();
+
     // The extEEPROM lib that we use for STM doesn't have the get and put templates
     // These templates need to be reimplemented here
     template <typename T> void Get(uint32_t addr, T &value)
@@ -4,36 +4,11 @@
 #include <handset.h>
 #include <LBT.h>
 
-// LQ-based boost defines
-#define DYNPOWER_LQ_BOOST_THRESH_DIFF 20  // If LQ is dropped suddenly for this amount (relative), immediately boost to the max power configured.
-#define DYNPOWER_LQ_BOOST_THRESH_MIN  50  // If LQ is below this value (absolute), immediately boost to the max power configured.
-#define DYNPOWER_LQ_MOVING_AVG_K      8   // Number of previous values for calculating moving average. Best with power of 2.
-#define DYNPOWER_LQ_THRESH_UP         85  // Below this LQ, the RSSI/SNR code will increase the power if RSSI/SNR did nothing
-
-// RSSI-based increment defines
-#define DYNPOWER_RSSI_CNT 5               // Number of RSSI readings to average (straight average) to make an RSSI-based adjustment
-#define DYNPOWER_RSSI_THRESH_UP 15        // RSSI < (Sensitivity+Up) -> raise power
-#define DYNPOWER_RSSI_THRESH_DN 21        // RSSI > (Sensitivity+Dn) >- lower power
-
-// SNR-based increment defines
-#define DYNPOWER_LQ_THRESH_DN 95          // Min LQ for lowering power using SNR-based power lowering
-
-template<uint8_t K, uint8_t SHIFT>
-class MovingAvg
-{
-public:
-  void init(uint32_t v) { _shiftedVal = v << SHIFT; };
-  void add(uint32_t v) {  _shiftedVal = ((K - 1) * _shiftedVal + (v << SHIFT)) / K; };
-  uint32_t getValue() const { return _shiftedVal >> SHIFT; };
-
-  void operator=(const uint32_t &v) { init(v); };
-  operator uint32_t () const { return getValue(); };
-private:
-  uint32_t _shiftedVal;
-};
-
-static MovingAvg<DYNPOWER_LQ_MOVING_AVG_K, 16> dynpower_mavg_lq;
-static MeanAccumulator<int32_t, int8_t, -128> dynpower_mean_rssi;
+#if defined(DYNPOWER_MODEL)
+static DynamicPowerController dynpower_controller(DYNPOWER_MODE_MODEL);
+#else
+static DynamicPowerController dynpower_controller(DYNPOWER_MODE_THRESHOLD);
+#endif
 static int8_t dynpower_updated;
 static uint32_t dynpower_last_linkstats_millis;
 
@@ -44,7 +19,7 @@ static void DynamicPower_SetToConfigPower()
 
 void DynamicPower_Init()
 {
-    dynpower_mavg_lq = 100;
+    dynpower_controller.reset();
     dynpower_updated = DYNPOWER_UPDATE_NOUPDATE;
 }
 
@@ -122,77 +97,23 @@ void DynamicPower_Update(uint32_t now)
     return;
   dynpower_last_linkstats_millis = now;
 
-  // =============  LQ-based power boost up ==============
-  // Quick boost up of power when detected any emergency LQ drops.
-  // It should be useful for bando or sudden lost of LoS cases.
   uint32_t lq_current = CRSF::LinkStatistics.uplink_Link_quality;
 #if defined(Regulatory_Domain_EU_CE_2400)
   // Scale up receiver LQ for packets not sent because the channel was not clear
   // the calculation could exceed 100% during a rate change or initial connect when the LQs are not synced
   lq_current = std::min(lq_current * 100 / std::max((uint32_t)LBTSuccessCalc.getLQ(), (uint32_t)1U), (uint32_t)100U);
 #endif
-  uint32_t lq_avg = dynpower_mavg_lq;
-  int32_t lq_diff = lq_avg - lq_current;
-  dynpower_mavg_lq.add(lq_current);
-  // if LQ drops quickly (DYNPOWER_LQ_BOOST_THRESH_DIFF) or critically low below DYNPOWER_LQ_BOOST_THRESH_MIN, immediately boost to the configured max power.
-  if (lq_diff >= DYNPOWER_LQ_BOOST_THRESH_DIFF || lq_current <= DYNPOWER_LQ_BOOST_THRESH_MIN)
-  {
-      DynamicPower_SetToConfigPower();
-      return;
-  }
-
-  PowerLevels_e startPowerLevel = POWERMGNT::currPower();
-  if (ExpressLRS_currAirRate_RFperfParams->DynpowerSnrThreshUp == DYNPOWER_SNR_THRESH_NONE)
-  {
-    // =============  RSSI-based power increment ==============
-    // a simple threshold compared against N sample average of
-    // rssi vs the sensitivity limit +/- some thresholds
-    dynpower_mean_rssi.add(rssi);
-
-    if (dynpower_mean_rssi.getCount() >= DYNPOWER_RSSI_CNT)
-    {
-      int32_t expected_RXsensitivity = ExpressLRS_currAirRate_RFperfParams->RXsensitivity;
-      int8_t rssi_inc_threshold = expected_RXsensitivity + DYNPOWER_RSSI_THRESH_UP;
-      int8_t rssi_dec_threshold = expected_RXsensitivity + DYNPOWER_RSSI_THRESH_DN;
-      int8_t avg_rssi = dynpower_mean_rssi.mean(); // resets it too
-      if ((avg_rssi < rssi_inc_threshold) && (powerHeadroom > 0))
-      {
-        DBGLN("+power (rssi)");
-        POWERMGNT::incPower();
-      }
-      else if (avg_rssi > rssi_dec_threshold && lq_avg >= DYNPOWER_LQ_THRESH_DN)
-      {
-        DBGVLN("-power (rssi)"); // Verbose because this spams when idle
-        POWERMGNT::decPower();
-      }
-    }
-  } // ^^ if RSSI-based
-  else
-  {
-    // =============  SNR-based power increment ==============
-    // Decrease the power if SNR above threshold and LQ is good
-    // Increase the power for each (X) SNR below the threshold
-    if (snrScaled >= ExpressLRS_currAirRate_RFperfParams->DynpowerSnrThreshDn && lq_avg >= DYNPOWER_LQ_THRESH_DN)
-    {
-      DBGVLN("-power (snr)"); // Verbose because this spams when idle
-      POWERMGNT::decPower();
-    }
-
-    while ((snrScaled <= ExpressLRS_currAirRate_RFperfParams->DynpowerSnrThreshUp) && (powerHeadroom > 0))
-    {
-      DBGLN("+power (snr)");
-      POWERMGNT::incPower();
-      // Every power doubling will theoretically increase the SNR by 3dB, but closer to 2dB in testing
-      snrScaled += SNR_SCALE(2);
-      --powerHeadroom;
-    }
-  } // ^^ if SNR-based
 
-  // If instant LQ is low, but the SNR/RSSI did nothing, inc power by one step
-  if ((powerHeadroom > 0) && (startPowerLevel == POWERMGNT::currPower()) && (lq_current <= DYNPOWER_LQ_THRESH_UP))
+  dynpower_tlm_t const tlm = { rssi, snrScaled, (uint8_t)lq_current };
+  dynpower_rf_t const rf = {
+    ExpressLRS_currAirRate_RFperfParams->RXsensitivity,
+    ExpressLRS_currAirRate_RFperfParams->DynpowerSnrThreshUp,
+    ExpressLRS_currAirRate_RFperfParams->DynpowerSnrThreshDn
+  };
+  PowerLevels_e newPower = dynpower_controller.update(tlm, rf, POWERMGNT::currPower(), POWERMGNT::getMinPower(), (PowerLevels_e)config.GetPower());
+  if (newPower != POWERMGNT::currPower())
   {
-    DBGLN("+power (lq)");
-    POWERMGNT::incPower();
+    POWERMGNT::setPower(newPower);
   }
 }
 
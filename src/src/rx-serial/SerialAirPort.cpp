@@ -5,8 +5,8 @@
 #include "common.h"
 
 // Variables / constants for Airport //
-FIFO<AP_MAX_BUF_LEN> apInputBuffer;
-FIFO<AP_MAX_BUF_LEN> apOutputBuffer;
+SPSCFIFO<AP_MAX_BUF_LEN> apInputBuffer;
+SPSCFIFO<AP_MAX_BUF_LEN> apOutputBuffer;
 
 
 uint32_t SerialAirPort::sendRCFrame(bool frameAvailable, bool frameMissed, uint32_t *channelData)
@@ -16,14 +16,14 @@ uint32_t SerialAirPort::sendRCFrame(bool frameAvailable, bool frameMissed, uint3
 
 int SerialAirPort::getMaxSerialReadSize()
 {
-    return AP_MAX_BUF_LEN - apInputBuffer.size();
+    return apInputBuffer.free();
 }
 
 void SerialAirPort::processBytes(uint8_t *bytes, u_int16_t size)
 {
     if (connectionState == connected)
     {
-        apInputBuffer.atomicPushBytes(bytes, size);
+        apInputBuffer.pushBytes(bytes, size);
     }
 }
 
@@ -33,9 +33,7 @@ void SerialAirPort::sendQueuedData(uint32_t maxBytesToSend)
     if (size != 0)
     {
         uint8_t buf[size];
-        apOutputBuffer.lock();
-        apOutputBuffer.popBytes(buf, size);
-        apOutputBuffer.unlock();
+        size = apOutputBuffer.popBytes(buf, size);
         _outputPort->write(buf, size);
     }
 }
@@ -1,10 +1,10 @@
 #include "SerialIO.h"
-#include "FIFO.h"
+#include "SPSCFIFO.h"
 #include "telemetry_protocol.h"
 
 // Variables / constants for Airport //
-extern FIFO<AP_MAX_BUF_LEN> apInputBuffer;
-extern FIFO<AP_MAX_BUF_LEN> apOutputBuffer;
+extern SPSCFIFO<AP_MAX_BUF_LEN> apInputBuffer;
+extern SPSCFIFO<AP_MAX_BUF_LEN> apOutputBuffer;
 
 class SerialAirPort : public SerialIO {
 public:
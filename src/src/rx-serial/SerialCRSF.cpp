@@ -1,4 +1,5 @@
 #include "SerialCRSF.h"
+#include "RCFrames.h"
 #include "common.h"
 #include "OTA.h"
 #include "device.h"
@@ -32,24 +33,15 @@ void SerialCRSF::queueLinkStatisticsPacket()
     // Note size of crsfLinkStatistics_t used, not full elrsLinkStatistics_t
     constexpr uint8_t payloadLen = sizeof(crsfLinkStatistics_t);
 
-    constexpr uint8_t outBuffer[] = {
-        payloadLen + 4,
+    uint8_t outBuffer[payloadLen + 4] = {
         CRSF_ADDRESS_FLIGHT_CONTROLLER,
         CRSF_FRAME_SIZE(payloadLen),
         CRSF_FRAMETYPE_LINK_STATISTICS
     };
+    memcpy(&outBuffer[3], (byte *)&CRSF::LinkStatistics, payloadLen);
+    outBuffer[payloadLen + 3] = crsf_crc.calc(&outBuffer[2], payloadLen + 1);
 
-    uint8_t crc = crsf_crc.calc(outBuffer[3]);
-    crc = crsf_crc.calc((byte *)&CRSF::LinkStatistics, payloadLen, crc);
-
-    _fifo.lock();
-    if (_fifo.ensure(outBuffer[0] + 1))
-    {
-        _fifo.pushBytes(outBuffer, sizeof(outBuffer));
-        _fifo.pushBytes((byte *)&CRSF::LinkStatistics, payloadLen);
-        _fifo.push(crc);
-    }
-    _fifo.unlock();
+    _fifo.pushPacket(outBuffer, sizeof(outBuffer));
 }
 
 uint32_t SerialCRSF::sendRCFrame(bool frameAvailable, bool frameMissed, uint32_t *channelData)
@@ -57,51 +49,24 @@ uint32_t SerialCRSF::sendRCFrame(bool frameAvailable, bool frameMissed, uint32_t
     if (!frameAvailable)
         return DURATION_IMMEDIATELY;
 
-    crsf_channels_s PackedRCdataOut;
-    PackedRCdataOut.ch0 = channelData[0];
-    PackedRCdataOut.ch1 = channelData[1];
-    PackedRCdataOut.ch2 = channelData[2];
-    PackedRCdataOut.ch3 = channelData[3];
-    PackedRCdataOut.ch4 = channelData[4];
-    PackedRCdataOut.ch5 = channelData[5];
-    PackedRCdataOut.ch6 = channelData[6];
-    PackedRCdataOut.ch7 = channelData[7];
-    PackedRCdataOut.ch8 = channelData[8];
-    PackedRCdataOut.ch9 = channelData[9];
-    PackedRCdataOut.ch10 = channelData[10];
-    PackedRCdataOut.ch11 = channelData[11];
-    PackedRCdataOut.ch12 = channelData[12];
-    PackedRCdataOut.ch13 = channelData[13];
+    const uint32_t *channels = channelData;
+    uint32_t linkChannels[CRSF_NUM_CHANNELS];
 
     // In 16ch mode, do not output RSSI/LQ on channels
-    if (OtaIsFullRes && OtaSwitchModeCurrent == smHybridOr16ch)
-    {
-        PackedRCdataOut.ch14 = channelData[14];
-        PackedRCdataOut.ch15 = channelData[15];
-    }
-    else
+    if (!(OtaIsFullRes && OtaSwitchModeCurrent == smHybridOr16ch))
     {
         // Not in 16-channel mode, send LQ and RSSI dBm
         int32_t rssiDBM = CRSF::LinkStatistics.active_antenna == 0 ? -CRSF::LinkStatistics.uplink_RSSI_1 : -CRSF::LinkStatistics.uplink_RSSI_2;
 
-        PackedRCdataOut.ch14 = UINT10_to_CRSF(fmap(CRSF::LinkStatistics.uplink_Link_quality, 0, 100, 0, 1023));
-        PackedRCdataOut.ch15 = UINT10_to_CRSF(map(constrain(rssiDBM, ExpressLRS_currAirRate_RFperfParams->RXsensitivity, -50),
-                                                   ExpressLRS_currAirRate_RFperfParams->RXsensitivity, -50, 0, 1023));
+        memcpy(linkChannels, channelData, 14 * sizeof(uint32_t));
+        linkChannels[14] = UINT10_to_CRSF(fmap(CRSF::LinkStatistics.uplink_Link_quality, 0, 100, 0, 1023));
+        linkChannels[15] = UINT10_to_CRSF(map(constrain(rssiDBM, ExpressLRS_currAirRate_RFperfParams->RXsensitivity, -50),
+                                              ExpressLRS_currAirRate_RFperfParams->RXsensitivity, -50, 0, 1023));
+        channels = linkChannels;
     }
 
-    constexpr uint8_t outBuffer[] = {
-        // No need for length prefix as we aren't using the FIFO
-        CRSF_ADDRESS_FLIGHT_CONTROLLER,
-        CRSF_FRAME_SIZE(sizeof(PackedRCdataOut)),
-        CRSF_FRAMETYPE_RC_CHANNELS_PACKED
-    };
-
-    uint8_t crc = crsf_crc.calc(outBuffer[2]);
-    crc = crsf_crc.calc((byte *)&PackedRCdataOut, sizeof(PackedRCdataOut), crc);
-
-    _outputPort->write(outBuffer, sizeof(outBuffer));
-    _outputPort->write((byte *)&PackedRCdataOut, sizeof(PackedRCdataOut));
-    _outputPort->write(crc);
+    // Rendered straight into the port's buffer and sent in one go, this is called from the tock ISR
+    _txPort.send(RCFrames::crsf(_txPort.buffer(), channels));
     return DURATION_IMMEDIATELY;
 }
 
@@ -111,10 +76,7 @@ void SerialCRSF::queueMSPFrameTransmission(uint8_t* data)
     if (totalBufferLen <= CRSF_FRAME_SIZE_MAX)
     {
         data[0] = CRSF_ADDRESS_FLIGHT_CONTROLLER;
-        _fifo.lock();
-        _fifo.push(totalBufferLen);
-        _fifo.pushBytes(data, totalBufferLen);
-        _fifo.unlock();
+        _fifo.pushPacket(data, totalBufferLen);
     }
 }
 
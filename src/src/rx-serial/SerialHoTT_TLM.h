@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "FIFO.h"
 #include "SerialIO.h"
 #include "device.h"
 
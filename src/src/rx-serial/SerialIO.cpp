@@ -17,14 +17,12 @@ void SerialIO::processSerialInput()
 void SerialIO::sendQueuedData(uint32_t maxBytesToSend)
 {
     uint32_t bytesWritten = 0;
+    uint8_t OutData[UINT8_MAX];
+    uint8_t OutPktLen;
 
-    while (_fifo.size() > _fifo.peek() && (bytesWritten + _fifo.peek()) < maxBytesToSend)
+    while (bytesWritten + 1 < maxBytesToSend
+        && (OutPktLen = _fifo.popPacket(OutData, maxBytesToSend - bytesWritten - 1)) != 0)
     {
-        _fifo.lock();
-        uint8_t OutPktLen = _fifo.pop();
-        uint8_t OutData[OutPktLen];
-        _fifo.popBytes(OutData, OutPktLen);
-        _fifo.unlock();
         noInterrupts();
         this->_outputPort->write(OutData, OutPktLen); // write the packet out
         interrupts();
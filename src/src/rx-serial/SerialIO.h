@@ -1,7 +1,8 @@
 #pragma once
 
 #include "targets.h"
-#include "FIFO.h"
+#include "SPSCFIFO.h"
+#include "SerialTxPort.h"
 #include "device.h"
 
 /**
@@ -18,7 +19,7 @@
 class SerialIO {
 public:
 
-    SerialIO(Stream *output, Stream *input) : _outputPort(output), _inputPort(input) {}
+    SerialIO(Stream *output, Stream *input) : _outputPort(output), _txPort(output), _inputPort(input) {}
     virtual ~SerialIO() {}
 
     /**
@@ -107,6 +108,11 @@ public:
 protected:
     /// @brief the output stream for the serial port
     Stream *_outputPort;
+    /**
+     * @brief zero-copy output for `_outputPort`, `sendRCFrame` implementations should
+     * render their frame into `_txPort.buffer()` and send it with a single `_txPort.send()`
+     */
+    SerialTxPort _txPort;
     /// @brief flag that indicates the receiver is in the failsafe state
     bool failsafe = false;
 
@@ -116,8 +122,9 @@ protected:
     /**
      * @brief the FIFO that should be used to queue serial data to in the
      * `queueLinkStatisticsPacket` and `queueMSPFrameTransmission` method implementations.
+     * Holds whole packets, the oldest are dropped if a new one does not fit.
      */
-    FIFO<SERIAL_OUTPUT_FIFO_SIZE> _fifo;
+    SPSCFIFO<SERIAL_OUTPUT_FIFO_SIZE> _fifo;
 
     /**
      * @brief Get the maximum number of bytes to read from the serial port per call
@@ -5,6 +5,7 @@
 #include "common.h"
 #include "CRSF.h"
 #include "config.h"
+#include "msptypes.h"
 
 #define MAVLINK_RC_PACKET_INTERVAL 10
 
@@ -55,12 +56,11 @@ uint32_t SerialMavlink::sendRCFrame(bool frameAvailable, bool frameMissed, uint3
         chan16_raw: CRSF_to_US(channelData[15]),
     };
 
-    uint8_t buf[MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES];
+    static_assert(MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES <= SERIAL_TX_FRAME_MAX, "RC_CHANNELS_OVERRIDE does not fit the serial TX buffer");
     mavlink_message_t msg;
     mavlink_msg_rc_channels_override_encode(this_system_id, this_component_id, &msg, &rc_override);
-    uint16_t len = mavlink_msg_to_send_buffer(buf, &msg);
-    _outputPort->write(buf, len);
-    
+    _txPort.send(mavlink_msg_to_send_buffer(_txPort.buffer(), &msg));
+
     return MAVLINK_RC_PACKET_INTERVAL;
 }
 
@@ -144,12 +144,67 @@ void SerialMavlink::forwardMessage(const uint8_t *data)
     mavlinkOutputBuffer.atomicPushBytes(data + 2, data[1]);
 }
 
+void SerialMavlink::forwardCompressedMessage(const uint8_t *data)
+{
+    // Any compressed message, including the TX's empty hello, means the TX can decompress too
+    if (!compressDownlink)
+    {
+        compressDownlink = true;
+        compressor.reset();
+    }
+    if (data[1] == 0)
+    {
+        return;
+    }
+
+    uint8_t buf[MAVLINK_COMPRESS_MAX_EXPANSION * CRSF_PAYLOAD_SIZE_MAX];
+    const uint16_t len = decompressor.decompress(data + 2, data[1], buf, sizeof(buf));
+    mavlinkOutputBuffer.atomicPushBytes(buf, len);
+}
+
+bool SerialMavlink::GetNextCompressedPayload(uint8_t* nextPayloadSize, uint8_t *payloadData)
+{
+    // Peek a block of the stream, the compressor keeps any partial frame itself
+    uint8_t buf[128];
+    mavlinkInputBuffer.lock();
+    const uint16_t size = std::min(mavlinkInputBuffer.size(), (uint16_t)sizeof(buf));
+    for (uint16_t i = 0; i < size; ++i)
+    {
+        buf[i] = mavlinkInputBuffer[i];
+    }
+    mavlinkInputBuffer.unlock();
+
+    uint16_t consumed = 0;
+    const uint8_t count = compressor.compress(buf, size, &consumed, payloadData + CRSF_FRAME_NOT_COUNTED_BYTES, CRSF_PAYLOAD_SIZE_MAX);
+    mavlinkInputBuffer.lock();
+    mavlinkInputBuffer.skip(consumed);
+    mavlinkInputBuffer.unlock();
+
+    if (count == 0)
+    {
+        return false;
+    }
+    payloadData[0] = MSP_ELRS_MAVLINK_TLM_COMPRESSED; // device_addr - tells the TX to decompress
+    payloadData[1] = count;
+    *nextPayloadSize = count + CRSF_FRAME_NOT_COUNTED_BYTES;
+    return true;
+}
+
 bool SerialMavlink::GetNextPayload(uint8_t* nextPayloadSize, uint8_t *payloadData)
 {
+    if (connectionState != connected)
+    {
+        // A new connection may be to a TX that can't decompress
+        compressDownlink = false;
+    }
     if (mavlinkInputBuffer.size() == 0)
     {
         return false;
     }
+    if (compressDownlink)
+    {
+        return GetNextCompressedPayload(nextPayloadSize, payloadData);
+    }
     const uint16_t count = std::min(mavlinkInputBuffer.size(), (uint16_t)CRSF_PAYLOAD_SIZE_MAX); // Constrain to CRSF max payload size to match SS
     payloadData[0] = CRSF_ADDRESS_USB; // device_addr - used on TX to differentiate between std tlm and mavlink
     payloadData[1] = count;
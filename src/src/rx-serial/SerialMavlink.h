@@ -1,5 +1,6 @@
 #include "FIFO.h"
 #include "SerialIO.h"
+#include "MAVLinkCompress.h"
 
 #define MAV_INPUT_BUF_LEN       1024
 #define MAV_OUTPUT_BUF_LEN      512
@@ -22,10 +23,12 @@ public:
     void sendQueuedData(uint32_t maxBytesToSend) override;
 
     void forwardMessage(const uint8_t *data);
+    void forwardCompressedMessage(const uint8_t *data);
     bool GetNextPayload(uint8_t *nextPayloadSize, uint8_t *payloadData);
 
 private:
     void processBytes(uint8_t *bytes, u_int16_t size) override;
+    bool GetNextCompressedPayload(uint8_t *nextPayloadSize, uint8_t *payloadData);
 
     const uint8_t this_system_id;
     const uint8_t this_component_id;
@@ -38,4 +41,9 @@ private:
     // Variables / constants for Mavlink //
     FIFO<MAV_INPUT_BUF_LEN> mavlinkInputBuffer;
     FIFO<MAV_OUTPUT_BUF_LEN> mavlinkOutputBuffer;
+
+    // The downlink is compressed once the TX has shown it can decompress
+    MAVLinkCompressor compressor;
+    MAVLinkDecompressor decompressor;
+    bool compressDownlink = false;
 };
@@ -40,11 +40,8 @@ void SerialTramp::sendQueuedData(uint32_t maxBytesToSend)
     uint32_t bytesWritten = 0;
     static unsigned long lastSendTime = 0; // OVTX only changes protocols on startup every 500ms; if we send our 3 packets in different 500ms windows, we have a better chance of success
     while (_fifo.size() > 0 && bytesWritten < maxBytesToSend && millis() - lastSendTime > 200){
-        _fifo.lock();
-        uint8_t frameSize = _fifo.pop() - 1;
-        uint8_t frame[frameSize];
-        _fifo.popBytes(frame, frameSize);
-        _fifo.unlock();
+        uint8_t frame[TRAMP_FRAME_SIZE];
+        uint8_t frameSize = _fifo.popPacket(frame, sizeof(frame));
         setTXMode();
         _outputPort->write(frame, frameSize);
         bytesWritten += frameSize;
@@ -97,10 +94,7 @@ void SerialTramp::queueMSPFrameTransmission(uint8_t* data)
     tempFrame[frameIndex++] = freq & 0xFF;
     tempFrame[frameIndex++] = (freq >> 8) & 0xFF;
     tempFrame[14] = checksum(tempFrame);
-    _fifo.lock();
-    _fifo.push(TRAMP_FRAME_SIZE + 1);
-    _fifo.pushBytes(tempFrame, TRAMP_FRAME_SIZE);
-    _fifo.unlock();
+    _fifo.pushPacket(tempFrame, TRAMP_FRAME_SIZE);
 
     // If packet has more than 4 bytes it also contains power idx and pitmode.
     bool havePowerAndPitmode = innerLength >= 4;
@@ -123,10 +117,7 @@ void SerialTramp::queueMSPFrameTransmission(uint8_t* data)
         tempFrame[frameIndex++] = power & 0xFF;
         tempFrame[frameIndex++] = (power >> 8) & 0xFF;
         tempFrame[14] = checksum(tempFrame);
-        _fifo.lock();
-        _fifo.push(TRAMP_FRAME_SIZE + 1);
-        _fifo.pushBytes(tempFrame, TRAMP_FRAME_SIZE);
-        _fifo.unlock();
+        _fifo.pushPacket(tempFrame, TRAMP_FRAME_SIZE);
 
         // Set pitmode
         uint8_t pitmode = data[11];
@@ -137,9 +128,6 @@ void SerialTramp::queueMSPFrameTransmission(uint8_t* data)
         tempFrame[frameIndex++] = 'I';
         tempFrame[frameIndex++] = pitmode ? 0 : 1; // Tramp uses inverted logic for pitmode
         tempFrame[14] = checksum(tempFrame);
-        _fifo.lock();
-        _fifo.push(TRAMP_FRAME_SIZE + 1);
-        _fifo.pushBytes(tempFrame, TRAMP_FRAME_SIZE);
-        _fifo.unlock();
+        _fifo.pushPacket(tempFrame, TRAMP_FRAME_SIZE);
     }
 }
\ No newline at end of file
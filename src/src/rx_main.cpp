@@ -1,19 +1,16 @@
 #include "rxtx_common.h"
-#include "LowPassFilter.h"
+#include "rxtx_intf.h"
+#include "rx_link.h"
 
 #include "crc.h"
 #include "telemetry_protocol.h"
 #include "telemetry.h"
-#include "stubborn_sender.h"
-#include "stubborn_receiver.h"
 
 #include "lua.h"
 #include "msp.h"
 #include "msptypes.h"
-#include "PFD.h"
 #include "options.h"
 #include "dynpower.h"
-#include "MeanAccumulator.h"
 #include "freqTable.h"
 
 #include "rx-serial/SerialIO.h"
@@ -74,7 +71,6 @@
 #define SEND_LINK_STATS_TO_FC_INTERVAL 100
 #define DIVERSITY_ANTENNA_INTERVAL 5
 #define DIVERSITY_ANTENNA_RSSI_TRIGGER 5
-#define PACKET_TO_TOCK_SLACK 200 // Desired buffer time between Packet ISR and Tock ISR
 ///////////////////
 
 device_affinity_t ui_devices[] = {
@@ -98,11 +94,6 @@ device_affinity_t ui_devices[] = {
 #endif
 };
 
-uint8_t antenna = 0;    // which antenna is currently in use
-uint8_t geminiMode = 0;
-
-PFD PFDloop;
-Crc2Byte ota_crc;
 ELRS_EEPROM eeprom;
 RxConfig config;
 Telemetry telemetry;
@@ -132,80 +123,10 @@ SerialIO *serialIO = nullptr;
 #define SERIAL1_PROTOCOL_RX Serial1
 
 uint8_t currentTelemetryPayload[CRSF_MAX_PACKET_LEN];
-StubbornSender TelemetrySender;
-static uint8_t telemetryBurstCount;
-static uint8_t telemetryBurstMax;
-
-StubbornReceiver MspReceiver;
 uint8_t MspData[ELRS_MSP_BUFFER];
 
-static bool tlmSent = false;
-static uint8_t NextTelemetryType = PACKET_TYPE_LINKSTATS;
-static bool telemBurstValid;
-/// PFD Filters ////////////////
-LPF LPF_Offset(2);
-LPF LPF_OffsetDx(4);
-
-/// LQ/RSSI/SNR Calculation //////////
-LQCALC<100> LQCalc;
-LQCALC<100> LQCalcDVDA;
-uint8_t uplinkLQ;
-LPF LPF_UplinkRSSI0(5);  // track rssi per antenna
-LPF LPF_UplinkRSSI1(5);
-MeanAccumulator<int32_t, int8_t, -16> SnrMean;
-
-static uint8_t scanIndex;
-uint8_t ExpressLRS_nextAirRateIndex;
-int8_t SwitchModePending;
-
-int32_t PfdPrevRawOffset;
-RXtimerState_e RXtimerState;
-uint32_t GotConnectionMillis = 0;
-const uint32_t ConsiderConnGoodMillis = 1000; // minimum time before we can consider a connection to be 'good'
-bool doStartTimer = false;
-
-///////////////////////////////////////////////
-
-bool didFHSS = false;
-bool alreadyFHSS = false;
-bool alreadyTLMresp = false;
-
-//////////////////////////////////////////////////////////////
-
-///////Variables for Telemetry and Link Quality///////////////
-uint32_t LastValidPacket = 0;           //Time the last valid packet was recv
-uint32_t LastSyncPacket = 0;            //Time the last valid packet was recv
-
-static uint32_t SendLinkStatstoFCintervalLastSent;
-static uint8_t SendLinkStatstoFCForcedSends;
-
+LQSTATS LQStats;
 int16_t RFnoiseFloor; //measurement of the current RF noise floor
-#if defined(DEBUG_RX_SCOREBOARD)
-static bool lastPacketCrcError;
-#endif
-///////////////////////////////////////////////////////////////
-
-/// Variables for Sync Behaviour ////
-uint32_t cycleInterval; // in ms
-uint32_t RFmodeLastCycled = 0;
-#define RFmodeCycleMultiplierSlow 10
-uint8_t RFmodeCycleMultiplier;
-bool LockRFmode = false;
-///////////////////////////////////////
-
-#if defined(DEBUG_BF_LINK_STATS)
-// Debug vars
-uint8_t debug1 = 0;
-uint8_t debug2 = 0;
-uint8_t debug3 = 0;
-int8_t debug4 = 0;
-///////////////////////////////////////
-#endif
-
-#if defined(DEBUG_RCVR_LINKSTATS)
-static bool debugRcvrLinkstatsPending;
-static uint8_t debugRcvrLinkstatsFhssIdx;
-#endif
 
 bool BindingModeRequest = false;
 #if defined(RADIO_LR1121)
@@ -216,12 +137,7 @@ static uint32_t BindingRateChangeTime;
 extern void setWifiUpdateMode();
 void reconfigureSerial();
 
-uint8_t getLq()
-{
-    return LQCalc.getLQ();
-}
-
-static inline void checkGeminiMode()
+void checkGeminiMode()
 {
     if (isDualRadio())
     {
@@ -229,514 +145,6 @@ static inline void checkGeminiMode()
     }
 }
 
-static uint8_t minLqForChaos()
-{
-    // Determine the most number of CRC-passing packets we could receive on
-    // a single channel out of 100 packets that fill the LQcalc span.
-    // The LQ must be GREATER THAN this value, not >=
-    // The amount of time we coexist on the same channel is
-    // 100 divided by the total number of packets in a FHSS loop (rounded up)
-    // and there would be 4x packets received each time it passes by so
-    // FHSShopInterval * ceil(100 / FHSShopInterval * numfhss) or
-    // FHSShopInterval * trunc((100 + (FHSShopInterval * numfhss) - 1) / (FHSShopInterval * numfhss))
-    // With a interval of 4 this works out to: 2.4=4, FCC915=4, AU915=8, EU868=8, EU/AU433=36
-    const uint32_t numfhss = FHSSgetChannelCount();
-    const uint8_t interval = ExpressLRS_currAirRate_Modparams->FHSShopInterval;
-    return interval * ((interval * numfhss + 99) / (interval * numfhss));
-}
-
-void ICACHE_RAM_ATTR getRFlinkInfo()
-{
-    int32_t rssiDBM = Radio.LastPacketRSSI;
-
-    if (GPIO_PIN_NSS_2 != UNDEF_PIN)
-    {
-        int32_t rssiDBM2 = Radio.LastPacketRSSI2;
-
-        #if !defined(DEBUG_RCVR_LINKSTATS)
-        rssiDBM = LPF_UplinkRSSI0.update(rssiDBM);
-        rssiDBM2 = LPF_UplinkRSSI1.update(rssiDBM2);
-        #endif
-        rssiDBM = (rssiDBM > 0) ? 0 : rssiDBM;
-        rssiDBM2 = (rssiDBM2 > 0) ? 0 : rssiDBM2;
-
-        // BetaFlight/iNav expect positive values for -dBm (e.g. -80dBm -> sent as 80)
-        CRSF::LinkStatistics.uplink_RSSI_1 = -rssiDBM;
-        CRSF::LinkStatistics.uplink_RSSI_2 = -rssiDBM2;
-        antenna = (Radio.GetProcessingPacketRadio() == SX12XX_Radio_1) ? 0 : 1;
-    }
-    else if (antenna == 0)
-    {
-        #if !defined(DEBUG_RCVR_LINKSTATS)
-        rssiDBM = LPF_UplinkRSSI0.update(rssiDBM);
-        #endif
-        if (rssiDBM > 0) rssiDBM = 0;
-        // BetaFlight/iNav expect positive values for -dBm (e.g. -80dBm -> sent as 80)
-        CRSF::LinkStatistics.uplink_RSSI_1 = -rssiDBM;
-    }
-    else
-    {
-        #if !defined(DEBUG_RCVR_LINKSTATS)
-        rssiDBM = LPF_UplinkRSSI1.update(rssiDBM);
-        #endif
-        if (rssiDBM > 0) rssiDBM = 0;
-        // BetaFlight/iNav expect positive values for -dBm (e.g. -80dBm -> sent as 80)
-        // May be overwritten below if DEBUG_BF_LINK_STATS is set
-        CRSF::LinkStatistics.uplink_RSSI_2 = -rssiDBM;
-    }
-
-    SnrMean.add(Radio.LastPacketSNRRaw);
-
-    CRSF::LinkStatistics.active_antenna = antenna;
-    CRSF::LinkStatistics.uplink_SNR = SNR_DESCALE(Radio.LastPacketSNRRaw); // possibly overriden below
-    //CRSF::LinkStatistics.uplink_Link_quality = uplinkLQ; // handled in Tick
-    CRSF::LinkStatistics.rf_Mode = ExpressLRS_currAirRate_Modparams->enum_rate;
-    //DBGLN(CRSF::LinkStatistics.uplink_RSSI_1);
-    #if defined(DEBUG_BF_LINK_STATS)
-    CRSF::LinkStatistics.downlink_RSSI_1 = debug1;
-    CRSF::LinkStatistics.downlink_Link_quality = debug2;
-    CRSF::LinkStatistics.downlink_SNR = debug3;
-    CRSF::LinkStatistics.uplink_RSSI_2 = debug4;
-    #endif
-
-    #if defined(DEBUG_RCVR_LINKSTATS)
-    // DEBUG_RCVR_LINKSTATS gets full precision SNR, override the value
-    CRSF::LinkStatistics.uplink_SNR = Radio.LastPacketSNRRaw;
-    debugRcvrLinkstatsFhssIdx = FHSSsequence[FHSSptr];
-    #endif
-}
-
-void SetRFLinkRate(uint8_t index, bool bindMode) // Set speed of RF link
-{
-    expresslrs_mod_settings_s *const ModParams = get_elrs_airRateConfig(index);
-    expresslrs_rf_pref_params_s *const RFperf = get_elrs_RFperfParams(index);
-
-    // Binding always uses invertIQ
-    bool invertIQ = bindMode || (UID[5] & 0x01);
-
-    uint32_t interval = ModParams->interval;
-#if defined(DEBUG_FREQ_CORRECTION) && defined(RADIO_SX128X)
-    interval = interval * 12 / 10; // increase the packet interval by 20% to allow adding packet header
-#endif
-
-    hwTimer::updateInterval(interval);
-
-    FHSSusePrimaryFreqBand = !(ModParams->radio_type == RADIO_TYPE_LR1121_LORA_2G4) && !(ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_2G4);
-    FHSSuseDualBand = ModParams->radio_type == RADIO_TYPE_LR1121_LORA_DUAL;
-
-    Radio.Config(ModParams->bw, ModParams->sf, ModParams->cr, FHSSgetInitialFreq(),
-                 ModParams->PreambleLen, invertIQ, ModParams->PayloadLength, 0
-#if defined(RADIO_SX128X)
-                 , uidMacSeedGet(), OtaCrcInitializer, (ModParams->radio_type == RADIO_TYPE_SX128x_FLRC)
-#endif
-#if defined(RADIO_LR1121)
-               , ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_900 || ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_2G4, (uint8_t)UID[5], (uint8_t)UID[4]
-#endif
-                 );
-
-#if defined(RADIO_LR1121)
-    if (FHSSuseDualBand)
-    {
-        Radio.Config(ModParams->bw2, ModParams->sf2, ModParams->cr2, FHSSgetInitialGeminiFreq(),
-                    ModParams->PreambleLen2, invertIQ, ModParams->PayloadLength, 0,
-                    ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_900 || ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_2G4,
-                    (uint8_t)UID[5], (uint8_t)UID[4], SX12XX_Radio_2);
-    }
-#endif
-
-    Radio.FuzzySNRThreshold = (RFperf->DynpowerSnrThreshUp == DYNPOWER_SNR_THRESH_NONE) ? 0 : (RFperf->DynpowerSnrThreshDn - RFperf->DynpowerSnrThreshUp);
-
-    checkGeminiMode();
-    if (geminiMode)
-    {
-        Radio.SetFrequencyReg(FHSSgetInitialGeminiFreq(), SX12XX_Radio_2);
-    }
-
-    OtaUpdateSerializers(smWideOr8ch, ModParams->PayloadLength);
-    MspReceiver.setMaxPackageIndex(ELRS_MSP_MAX_PACKAGES);
-    TelemetrySender.setMaxPackageIndex(OtaIsFullRes ? ELRS8_TELEMETRY_MAX_PACKAGES : ELRS4_TELEMETRY_MAX_PACKAGES);
-
-    // Wait for (11/10) 110% of time it takes to cycle through all freqs in FHSS table (in ms)
-    cycleInterval = ((uint32_t)11U * FHSSgetChannelCount() * ModParams->FHSShopInterval * interval) / (10U * 1000U);
-
-    ExpressLRS_currAirRate_Modparams = ModParams;
-    ExpressLRS_currAirRate_RFperfParams = RFperf;
-    ExpressLRS_nextAirRateIndex = index; // presumably we just handled this
-    telemBurstValid = false;
-}
-
-bool ICACHE_RAM_ATTR HandleFHSS()
-{
-    uint8_t modresultFHSS = (OtaNonce + 1) % ExpressLRS_currAirRate_Modparams->FHSShopInterval;
-
-    if ((ExpressLRS_currAirRate_Modparams->FHSShopInterval == 0) || alreadyFHSS == true || InBindingMode || (modresultFHSS != 0) || (connectionState == disconnected))
-    {
-        return false;
-    }
-
-    alreadyFHSS = true;
-
-    if (geminiMode)
-    {
-        if ((((OtaNonce + 1)/ExpressLRS_currAirRate_Modparams->FHSShopInterval) % 2 == 0) || FHSSuseDualBand) // When in DualBand do not switch between radios.  The OTA modulation paramters and HighFreq/LowFreq Tx amps are set during Config.
-        {
-            Radio.SetFrequencyReg(FHSSgetNextFreq(), SX12XX_Radio_1);
-            Radio.SetFrequencyReg(FHSSgetGeminiFreq(), SX12XX_Radio_2);
-        }
-        else
-        {
-            // Write radio1 first. This optimises the SPI traffic order.
-            uint32_t freqRadio2 = FHSSgetNextFreq();
-            Radio.SetFrequencyReg(FHSSgetGeminiFreq(), SX12XX_Radio_1);
-            Radio.SetFrequencyReg(freqRadio2, SX12XX_Radio_2);
-        }
-    }
-    else
-    {
-        Radio.SetFrequencyReg(FHSSgetNextFreq());
-    }
-
-#if defined(RADIO_SX127X)
-    // SX127x radio has to reset receive mode after hopping
-    uint8_t modresultTLM = (OtaNonce + 1) % ExpressLRS_currTlmDenom;
-    if (modresultTLM != 0 || ExpressLRS_currTlmDenom == 1) // if we are about to send a tlm response don't bother going back to rx
-    {
-        Radio.RXnb();
-    }
-#endif
-#if defined(Regulatory_Domain_EU_CE_2400)
-    SetClearChannelAssessmentTime();
-#endif
-    return true;
-}
-
-void ICACHE_RAM_ATTR LinkStatsToOta(OTA_LinkStats_s * const ls)
-{
-    // The value in linkstatistics is "positivized" (inverted polarity)
-    // and must be inverted on the TX side. Positive values are used
-    // so save a bit to encode which antenna is in use
-    ls->uplink_RSSI_1 = CRSF::LinkStatistics.uplink_RSSI_1;
-    ls->uplink_RSSI_2 = CRSF::LinkStatistics.uplink_RSSI_2;
-    ls->antenna = antenna;
-    ls->modelMatch = connectionHasModelMatch;
-    ls->lq = CRSF::LinkStatistics.uplink_Link_quality;
-    ls->tlmConfirm = MspReceiver.GetCurrentConfirm() ? 1 : 0;
-#if defined(DEBUG_FREQ_CORRECTION)
-    ls->SNR = FreqCorrection * 127 / FreqCorrectionMax;
-#else
-    if (SnrMean.getCount())
-    {
-        ls->SNR = SnrMean.mean();
-    }
-    else
-    {
-        ls->SNR = SnrMean.previousMean();
-    }
-#endif
-}
-
-bool ICACHE_RAM_ATTR HandleSendTelemetryResponse()
-{
-    uint8_t modresult = (OtaNonce + 1) % ExpressLRS_currTlmDenom;
-
-    if ((connectionState == disconnected) || (ExpressLRS_currTlmDenom == 1) || (alreadyTLMresp == true) || (modresult != 0) || !teamraceHasModelMatch)
-    {
-        return false; // don't bother sending tlm if disconnected or TLM is off
-    }
-
-    // ESP requires word aligned buffer
-    WORD_ALIGNED_ATTR OTA_Packet_s otaPkt = {0};
-    WORD_ALIGNED_ATTR OTA_Packet_s otaPktGemini = {0};
-    alreadyTLMresp = true;
-    bool sendGeminiBuffer = false;
-
-    bool tlmQueued = false;
-    if (firmwareOptions.is_airport)
-    {
-        tlmQueued = apInputBuffer.size() > 0;
-    }
-    else
-    {
-        tlmQueued = TelemetrySender.IsActive();
-    }
-
-    if (NextTelemetryType == PACKET_TYPE_LINKSTATS || !tlmQueued)
-    {
-        otaPkt.std.type = PACKET_TYPE_LINKSTATS;
-
-        OTA_LinkStats_s * ls;
-
-        // Include some advanced telemetry in the extra space
-        // Note the use of `ul_link_stats.payload` vs just `payload`
-        if (OtaIsFullRes)
-        {
-            ls = &otaPkt.full.tlm_dl.ul_link_stats.stats;
-            otaPkt.full.tlm_dl.ul_link_stats.trueDiversityAvailable = isDualRadio();
-
-            otaPkt.full.tlm_dl.tlmConfirm = MspReceiver.GetCurrentConfirm() ? 1 : 0;
-
-            if (geminiMode)
-            {
-                sendGeminiBuffer = true;
-                WORD_ALIGNED_ATTR uint8_t tlmSenderDoubleBuffer[2 * sizeof(otaPkt.full.tlm_dl.ul_link_stats.payload)] = {0};
-
-                otaPkt.full.tlm_dl.packageIndex = TelemetrySender.GetCurrentPayload(tlmSenderDoubleBuffer, sizeof(tlmSenderDoubleBuffer));
-                memcpy(otaPkt.full.tlm_dl.ul_link_stats.payload, tlmSenderDoubleBuffer, sizeof(otaPkt.full.tlm_dl.ul_link_stats.payload));
-                LinkStatsToOta(ls);
-
-                otaPktGemini = otaPkt;
-                memcpy(otaPktGemini.full.tlm_dl.ul_link_stats.payload, &tlmSenderDoubleBuffer[sizeof(otaPktGemini.full.tlm_dl.ul_link_stats.payload)], sizeof(otaPktGemini.full.tlm_dl.ul_link_stats.payload));
-            }
-            else
-            {
-                otaPkt.full.tlm_dl.packageIndex = TelemetrySender.GetCurrentPayload(
-                    otaPkt.full.tlm_dl.ul_link_stats.payload,
-                    sizeof(otaPkt.full.tlm_dl.ul_link_stats.payload));
-                LinkStatsToOta(ls);
-            }
-        }
-        else
-        {
-            ls = &otaPkt.std.tlm_dl.ul_link_stats.stats;
-            otaPkt.std.tlm_dl.ul_link_stats.trueDiversityAvailable = isDualRadio();
-            LinkStatsToOta(ls);
-        }
-
-        NextTelemetryType = PACKET_TYPE_DATA;
-        // Start the count at 1 because the next will be DATA and doing +1 before checking
-        // against Max below is for some reason 10 bytes more code
-        telemetryBurstCount = 1;
-    }
-    else // if tlmQueued
-    {
-        if (telemetryBurstCount < telemetryBurstMax)
-        {
-            telemetryBurstCount++;
-        }
-        else
-        {
-            NextTelemetryType = PACKET_TYPE_LINKSTATS;
-        }
-
-        otaPkt.std.type = PACKET_TYPE_DATA;
-
-        if (firmwareOptions.is_airport)
-        {
-            OtaPackAirportData(&otaPkt, &apInputBuffer);
-        }
-        else
-        {
-            if (OtaIsFullRes)
-            {
-                otaPkt.full.tlm_dl.tlmConfirm = MspReceiver.GetCurrentConfirm() ? 1 : 0;
-
-                if (geminiMode)
-                {
-                    sendGeminiBuffer = true;
-                    WORD_ALIGNED_ATTR uint8_t tlmSenderDoubleBuffer[2 * sizeof(otaPkt.full.tlm_dl.payload)] = {0};
-
-                    otaPkt.full.tlm_dl.packageIndex = TelemetrySender.GetCurrentPayload(tlmSenderDoubleBuffer, sizeof(tlmSenderDoubleBuffer));
-                    memcpy(otaPkt.full.tlm_dl.payload, tlmSenderDoubleBuffer, sizeof(otaPkt.full.tlm_dl.payload));
-
-                    otaPktGemini = otaPkt;
-                    memcpy(otaPktGemini.full.tlm_dl.payload, &tlmSenderDoubleBuffer[sizeof(otaPktGemini.full.tlm_dl.payload)], sizeof(otaPktGemini.full.tlm_dl.payload));
-                }
-                else
-                {
-                    otaPkt.full.tlm_dl.packageIndex = TelemetrySender.GetCurrentPayload(otaPkt.full.tlm_dl.payload, sizeof(otaPkt.full.tlm_dl.payload));
-                }
-            }
-            else
-            {
-                otaPkt.std.tlm_dl.tlmConfirm = MspReceiver.GetCurrentConfirm() ? 1 : 0;
-
-                if (geminiMode)
-                {
-                    sendGeminiBuffer = true;
-                    WORD_ALIGNED_ATTR uint8_t tlmSenderDoubleBuffer[2 * sizeof(otaPkt.std.tlm_dl.payload)] = {0};
-
-                    otaPkt.std.tlm_dl.packageIndex = TelemetrySender.GetCurrentPayload(tlmSenderDoubleBuffer, sizeof(tlmSenderDoubleBuffer));
-                    memcpy(otaPkt.std.tlm_dl.payload, tlmSenderDoubleBuffer, sizeof(otaPkt.std.tlm_dl.payload));
-
-                    otaPktGemini = otaPkt;
-                    memcpy(otaPktGemini.std.tlm_dl.payload, &tlmSenderDoubleBuffer[sizeof(otaPktGemini.std.tlm_dl.payload)], sizeof(otaPktGemini.std.tlm_dl.payload));
-                }
-                else
-                {
-                    otaPkt.std.tlm_dl.packageIndex = TelemetrySender.GetCurrentPayload(otaPkt.std.tlm_dl.payload, sizeof(otaPkt.std.tlm_dl.payload));
-                }
-            }
-        }
-    }
-
-    OtaGeneratePacketCrc(&otaPkt);
-    if (sendGeminiBuffer)
-    {
-        OtaGeneratePacketCrc(&otaPktGemini);
-    }
-
-    SX12XX_Radio_Number_t transmittingRadio;
-    if (config.GetForceTlmOff())
-    {
-        transmittingRadio = SX12XX_Radio_NONE;
-    }
-    else if (isDualRadio())
-    {
-        transmittingRadio = SX12XX_Radio_All;
-    }
-    else
-    {
-        transmittingRadio = Radio.GetLastSuccessfulPacketRadio();
-    }
-
-#if defined(Regulatory_Domain_EU_CE_2400)
-    transmittingRadio &= ChannelIsClear(transmittingRadio);   // weed out the radio(s) if channel in use
-#endif
-
-    if (!geminiMode && transmittingRadio == SX12XX_Radio_All) // If the receiver is in diversity mode, only send TLM on a single radio.
-    {
-        transmittingRadio = Radio.LastPacketRSSI > Radio.LastPacketRSSI2 ? SX12XX_Radio_1 : SX12XX_Radio_2; // Pick the radio with best rf connection to the tx.
-    }
-
-    // Gemini flips frequencies between radios on the rx side only.  This is to help minimise antenna cross polarization.
-    // The payloads need to be switch when this happens.
-    // GemX does not switch due to the time required to reconfigure the LR1121 params.
-    if (((OtaNonce + 1)/ExpressLRS_currAirRate_Modparams->FHSShopInterval) % 2 == 0 || !sendGeminiBuffer || FHSSuseDualBand)
-    {
-        Radio.TXnb((uint8_t*)&otaPkt, ExpressLRS_currAirRate_Modparams->PayloadLength, sendGeminiBuffer, (uint8_t*)&otaPktGemini, transmittingRadio);
-    }
-    else
-    {
-        Radio.TXnb((uint8_t*)&otaPktGemini, ExpressLRS_currAirRate_Modparams->PayloadLength, sendGeminiBuffer, (uint8_t*)&otaPkt, transmittingRadio);
-    }
-
-    if (transmittingRadio == SX12XX_Radio_NONE)
-    {
-        // No packet will be sent due to LBT / Telem forced off.
-        // Defer TXdoneCallback() to prepare for TLM when the IRQ is normally triggered.
-        deferExecutionMicros(ExpressLRS_currAirRate_RFperfParams->TOA, Radio.TXdoneCallback);
-    }
-
-    return true;
-}
-
-int32_t ICACHE_RAM_ATTR HandleFreqCorr(bool value, SX12XX_Radio_Number_t radio)
-{
-    int32_t tempFC = FreqCorrection;
-    if (radio == SX12XX_Radio_2)
-    {
-        tempFC = FreqCorrection_2;
-    }
-
-    if (value)
-    {
-        if (tempFC > FreqCorrectionMin)
-        {
-            tempFC--; // FREQ_STEP units
-            if (tempFC == FreqCorrectionMin)
-            {
-                DBGLN("Max -FreqCorrection reached!");
-            }
-        }
-    }
-    else
-    {
-        if (tempFC < FreqCorrectionMax)
-        {
-            tempFC++; // FREQ_STEP units
-            if (tempFC == FreqCorrectionMax)
-            {
-                DBGLN("Max +FreqCorrection reached!");
-            }
-        }
-    }
-
-    if (radio == SX12XX_Radio_1)
-    {
-        FreqCorrection = tempFC;
-    }
-    else
-    {
-        FreqCorrection_2 = tempFC;
-    }
-
-    return tempFC;
-}
-
-void ICACHE_RAM_ATTR updatePhaseLock()
-{
-    if (connectionState != disconnected && PFDloop.hasResult())
-    {
-        int32_t RawOffset = PFDloop.calcResult();
-        int32_t Offset = LPF_Offset.update(RawOffset);
-        int32_t OffsetDx = LPF_OffsetDx.update(RawOffset - PfdPrevRawOffset);
-        PfdPrevRawOffset = RawOffset;
-
-        if (RXtimerState == tim_locked)
-        {
-            // limit rate of freq offset adjustment, use slot 1
-            // because telemetry can fall on slot 1 and will
-            // never get here
-            if (OtaNonce % 8 == 1)
-            {
-                if (Offset > 0)
-                {
-                    hwTimer::incFreqOffset();
-                }
-                else if (Offset < 0)
-                {
-                    hwTimer::decFreqOffset();
-                }
-            }
-        }
-
-        if (connectionState != connected)
-        {
-            hwTimer::phaseShift(RawOffset >> 1);
-        }
-        else
-        {
-            hwTimer::phaseShift(Offset >> 2);
-        }
-
-        DBGVLN("%d:%d:%d:%d:%d", Offset, RawOffset, OffsetDx, hwTimer::getFreqOffset(), uplinkLQ);
-        UNUSED(OffsetDx); // complier warning if no debug
-    }
-
-    PFDloop.reset();
-}
-
-void ICACHE_RAM_ATTR HWtimerCallbackTick() // this is 180 out of phase with the other callback, occurs mid-packet reception
-{
-    updatePhaseLock();
-    OtaNonce++;
-
-    // if (!alreadyTLMresp && !alreadyFHSS && !LQCalc.currentIsSet()) // packet timeout AND didn't DIDN'T just hop or send TLM
-    // {
-    //     Radio.RXnb(); // put the radio cleanly back into RX in case of garbage data
-    // }
-
-
-    if (ExpressLRS_currAirRate_Modparams->numOfSends == 1)
-    {
-        // Save the LQ value before the inc() reduces it by 1
-        uplinkLQ = LQCalc.getLQ();
-    } else
-    if (!((OtaNonce - 1) % ExpressLRS_currAirRate_Modparams->numOfSends))
-    {
-        uplinkLQ = LQCalcDVDA.getLQ();
-        LQCalcDVDA.inc();
-    }
-
-    CRSF::LinkStatistics.uplink_Link_quality = uplinkLQ;
-    // Only advance the LQI period counter if we didn't send Telemetry this period
-    if (!alreadyTLMresp)
-        LQCalc.inc();
-
-    alreadyTLMresp = false;
-    alreadyFHSS = false;
-}
-
 //////////////////////////////////////////////////////////////
 // flip to the other antenna
 // no-op if GPIO_PIN_ANT_CTRL not defined
@@ -756,7 +164,7 @@ static inline void switchAntenna()
     }
 }
 
-static void ICACHE_RAM_ATTR updateDiversity()
+void ICACHE_RAM_ATTR updateDiversity()
 {
 
     if (GPIO_PIN_ANT_CTRL != UNDEF_PIN)
@@ -825,163 +233,6 @@ static void ICACHE_RAM_ATTR updateDiversity()
     }
 }
 
-void ICACHE_RAM_ATTR HWtimerCallbackTock()
-{
-    PFDloop.intEvent(micros()); // our internal osc just fired
-
-    if (ExpressLRS_currAirRate_Modparams->numOfSends > 1 && !(OtaNonce % ExpressLRS_currAirRate_Modparams->numOfSends))
-    {
-        if (LQCalcDVDA.currentIsSet())
-        {
-            crsfRCFrameAvailable();
-            if (teamraceHasModelMatch)
-                servoNewChannelsAvailable();
-        }
-        else
-        {
-            crsfRCFrameMissed();
-        }
-    }
-    else if (ExpressLRS_currAirRate_Modparams->numOfSends == 1)
-    {
-        if (!LQCalc.currentIsSet())
-        {
-            crsfRCFrameMissed();
-        }
-    }
-
-    // For any serial drivers that need to send on a regular cadence (i.e. CRSF to betaflight)
-    sendImmediateRC();
-
-    if (!didFHSS)
-    {
-        HandleFHSS();
-    }
-    didFHSS = false;
-
-    updateDiversity();
-    tlmSent = HandleSendTelemetryResponse();
-
-    #if defined(DEBUG_RX_SCOREBOARD)
-    static bool lastPacketWasTelemetry = false;
-    if (!LQCalc.currentIsSet() && !lastPacketWasTelemetry)
-        DBGW(lastPacketCrcError ? '.' : '_');
-    lastPacketCrcError = false;
-    lastPacketWasTelemetry = tlmSent;
-    #endif
-}
-
-void LostConnection(bool resumeRx)
-{
-    DBGLN("lost conn fc=%d fo=%d", FreqCorrection, hwTimer::getFreqOffset());
-
-    setConnectionState(disconnected); //set lost connection
-    RXtimerState = tim_disconnected;
-    hwTimer::resetFreqOffset();
-    PfdPrevRawOffset = 0;
-    GotConnectionMillis = 0;
-    uplinkLQ = 0;
-    LQCalc.reset();
-    LQCalcDVDA.reset();
-    LPF_Offset.init(0);
-    LPF_OffsetDx.init(0);
-    alreadyTLMresp = false;
-    alreadyFHSS = false;
-
-    if (!InBindingMode)
-    {
-        if (hwTimer::running)
-        {
-            while(micros() - PFDloop.getIntEventTime() > 250); // time it just after the tock()
-            hwTimer::stop();
-        }
-        SetRFLinkRate(ExpressLRS_nextAirRateIndex, false); // also sets to initialFreq
-        // If not resumRx, Radio will be left in SX127x_OPMODE_STANDBY / SX1280_MODE_STDBY_XOSC
-        if (resumeRx)
-        {
-            Radio.RXnb();
-        }
-    }
-}
-
-void ICACHE_RAM_ATTR TentativeConnection(unsigned long now)
-{
-    PFDloop.reset();
-    setConnectionState(tentative);
-    connectionHasModelMatch = false;
-    RXtimerState = tim_disconnected;
-    DBGLN("tentative conn");
-    PfdPrevRawOffset = 0;
-    LPF_Offset.init(0);
-    SnrMean.reset();
-    RFmodeLastCycled = now; // give another 3 sec for lock to occur
-
-    // Use this rate as the initial rate next time if we connected on it
-    config.SetRateInitialIdx(ExpressLRS_nextAirRateIndex);
-    // And stop counting toward binding mode
-    if (config.GetPowerOnCounter() != 0)
-    {
-        config.SetPowerOnCounter(0);
-    }
-
-    // The caller MUST call hwTimer::resume(). It is not done here because
-    // the timer ISR will fire immediately and preempt any other code
-}
-
-void GotConnection(unsigned long now)
-{
-    if (connectionState == connected)
-    {
-        return; // Already connected
-    }
-
-    LockRFmode = firmwareOptions.lock_on_first_connection;
-
-    setConnectionState(connected); //we got a packet, therefore no lost connection
-    RXtimerState = tim_tentative;
-    GotConnectionMillis = now;
-    webserverPreventAutoStart = true;
-
-    if (firmwareOptions.is_airport)
-    {
-        apInputBuffer.flush();
-        apOutputBuffer.flush();
-    }
-
-    DBGLN("got conn");
-}
-
-static void ICACHE_RAM_ATTR ProcessRfPacket_RC(OTA_Packet_s const * const otaPktPtr)
-{
-    // Must be fully connected to process RC packets, prevents processing RC
-    // during sync, where packets can be received before connection
-    if (connectionState != connected || SwitchModePending)
-        return;
-
-    bool telemetryConfirmValue = OtaUnpackChannelData(otaPktPtr, ChannelData, ExpressLRS_currTlmDenom);
-    TelemetrySender.ConfirmCurrentPayload(telemetryConfirmValue);
-
-    // No channels packets to the FC or PWM pins if no model match
-    if (connectionHasModelMatch)
-    {
-        if (ExpressLRS_currAirRate_Modparams->numOfSends == 1)
-        {
-            crsfRCFrameAvailable();
-            // teamrace is only checked for servos because the teamrace model select logic only runs
-            // when new frames are available, and will decide later if the frame will be forwarded
-            if (teamraceHasModelMatch)
-                servoNewChannelsAvailable();
-        }
-        else if (!LQCalcDVDA.currentIsSet())
-        {
-            LQCalcDVDA.add();
-        }
-        #if defined(DEBUG_RCVR_LINKSTATS)
-        debugRcvrLinkstatsPending = true;
-        #endif
-    }
-}
-
 void ICACHE_RAM_ATTR OnELRSBindMSP(uint8_t* newUid4)
 {
     // Binding over MSP only contains 4 bytes due to packet size limitations, clear out any leading bytes
@@ -999,106 +250,29 @@ void ICACHE_RAM_ATTR OnELRSBindMSP(uint8_t* newUid4)
     config.SetUID(UID);
 }
 
-static void ICACHE_RAM_ATTR ProcessRfPacket_MSP(OTA_Packet_s const * const otaPktPtr)
+bool ICACHE_RAM_ATTR getRxForceTlmOff()
 {
-    uint8_t packageIndex;
-    uint8_t const * payload;
-    uint8_t dataLen;
-    if (OtaIsFullRes)
-    {
-        packageIndex = otaPktPtr->full.msp_ul.packageIndex;
-        payload = otaPktPtr->full.msp_ul.payload;
-        dataLen = sizeof(otaPktPtr->full.msp_ul.payload);
-        if (config.GetSerialProtocol() == PROTOCOL_MAVLINK)
-        {
-            TelemetrySender.ConfirmCurrentPayload(otaPktPtr->full.msp_ul.tlmConfirm);
-        }
-        else
-        {
-            packageIndex &= ELRS8_TELEMETRY_MAX_PACKAGES;
-        }
-    }
-    else
-    {
-        packageIndex = otaPktPtr->std.msp_ul.packageIndex;
-        payload = otaPktPtr->std.msp_ul.payload;
-        dataLen = sizeof(otaPktPtr->std.msp_ul.payload);
-        if (config.GetSerialProtocol() == PROTOCOL_MAVLINK)
-        {
-            TelemetrySender.ConfirmCurrentPayload(otaPktPtr->std.msp_ul.tlmConfirm);
-        }
-        else
-        {
-            packageIndex &= ELRS4_TELEMETRY_MAX_PACKAGES;
-        }
-    }
-
-    // Always examine MSP packets for bind information if in bind mode
-    // [1] is the package index, first packet of the MSP
-    if (InBindingMode && packageIndex == 1 && payload[0] == MSP_ELRS_BIND)
-    {
-        OnELRSBindMSP((uint8_t *)&payload[1]);
-        return;
-    }
-
-    // Must be fully connected to process MSP, prevents processing MSP
-    // during sync, where packets can be received before connection
-    if (connectionState == connected)
-    {
-        MspReceiver.ReceiveData(packageIndex, payload, dataLen);
-    }
+    return config.GetForceTlmOff();
 }
 
-static void ICACHE_RAM_ATTR updateSwitchModePendingFromOta(uint8_t newSwitchMode)
+eSerialProtocol ICACHE_RAM_ATTR getRxSerialProtocol()
 {
-    if (OtaSwitchModeCurrent == newSwitchMode)
-    {
-        // Cancel any switch if pending
-        SwitchModePending = 0;
-        return;
-    }
-
-    // One is added to the mode because SwitchModePending==0 means no switch pending
-    // and that's also a valid switch mode. The 1 is removed when this is handled.
-    // A negative SwitchModePending means not to switch yet
-    int8_t newSwitchModePending = -(int8_t)newSwitchMode - 1;
+    return config.GetSerialProtocol();
+}
 
-    // Switch mode can be changed while disconnected
-    // OR there are two sync packets with the same new switch mode,
-    // as a "confirm". No RC packets are processed until
-    if (connectionState == disconnected ||
-        SwitchModePending == newSwitchModePending)
-    {
-        // Add one to the mode because SwitchModePending==0 means no switch pending
-        // and that's also a valid switch mode. The 1 is removed when this is handled
-        SwitchModePending = newSwitchMode + 1;
-    }
-    else
-    {
-        // Save the negative version of the new switch mode to compare
-        // against on the next SYNC packet, but do not switch yet
-        SwitchModePending = newSwitchModePending;
-    }
+uint8_t ICACHE_RAM_ATTR getRxModelId()
+{
+    return config.GetModelId();
 }
 
-static bool ICACHE_RAM_ATTR ProcessRfPacket_SYNC(uint32_t const now, OTA_Sync_s const * const otaSync)
+bool getRxLockOnFirstConnection()
 {
-    // Verify the first byte of the binding ID, which should always match
-    if (otaSync->UID4 != UID[4])
-        return false;
-
-    // The third byte will be XORed with inverse of the ModelId if ModelMatch is on
-    // Only require the first 18 bits of the UID to match to establish a connection
-    // but the last 6 bits must modelmatch before sending any data to the FC
-    if ((otaSync->UID5 & ~MODELMATCH_MASK) != (UID[5] & ~MODELMATCH_MASK))
-        return false;
-
-    LastSyncPacket = now;
-#if defined(DEBUG_RX_SCOREBOARD)
-    DBGW('s');
-#endif
+    return firmwareOptions.lock_on_first_connection;
+}
 
-    if (otaSync->otaProtocol == TX_MAVLINK_MODE)
+void ICACHE_RAM_ATTR OnRxSyncSettings(uint8_t otaProtocol, uint8_t geminiMode)
+{
+    if (otaProtocol == TX_MAVLINK_MODE)
     {
         config.SetSerialProtocol(PROTOCOL_MAVLINK);
     }
@@ -1117,182 +291,24 @@ static bool ICACHE_RAM_ATTR ProcessRfPacket_SYNC(uint32_t const now, OTA_Sync_s
 
     if (isDualRadio())
     {
-        config.SetAntennaMode(otaSync->geminiMode);
+        config.SetAntennaMode(geminiMode);
     }
-
-    // Will change the packet air rate in loop() if this changes
-    ExpressLRS_nextAirRateIndex = enumRatetoIndex((expresslrs_RFrates_e)otaSync->rfRateEnum);
-    updateSwitchModePendingFromOta(otaSync->switchEncMode);
-
-    // Update TLM ratio, should never be TLM_RATIO_STD/DISARMED, the TX calculates the correct value for the RX
-    expresslrs_tlm_ratio_e TLMrateIn = (expresslrs_tlm_ratio_e)(otaSync->newTlmRatio + (uint8_t)TLM_RATIO_NO_TLM);
-    uint8_t TlmDenom = TLMratioEnumToValue(TLMrateIn);
-    if (ExpressLRS_currTlmDenom != TlmDenom)
-    {
-        DBGLN("New TLMrate 1:%u", TlmDenom);
-        ExpressLRS_currTlmDenom = TlmDenom;
-        telemBurstValid = false;
-    }
-
-    // modelId = 0xff indicates modelMatch is disabled, the XOR does nothing in that case
-    uint8_t modelXor = (~config.GetModelId()) & MODELMATCH_MASK;
-    bool modelMatched = otaSync->UID5 == (UID[5] ^ modelXor);
-    DBGVLN("MM %u=%u %d", otaSync->UID5, UID[5], modelMatched);
-
-    if (connectionState == disconnected
-        || OtaNonce != otaSync->nonce
-        || FHSSgetCurrIndex() != otaSync->fhssIndex
-        || connectionHasModelMatch != modelMatched)
-    {
-        //DBGLN("\r\n%ux%ux%u", OtaNonce, otaPktPtr->sync.nonce, otaPktPtr->sync.fhssIndex);
-        FHSSsetCurrIndex(otaSync->fhssIndex);
-        OtaNonce = otaSync->nonce;
-        TentativeConnection(now);
-        // connectionHasModelMatch must come after TentativeConnection, which resets it
-        connectionHasModelMatch = modelMatched;
-        return true;
-    }
-
-    return false;
-}
-
-bool ICACHE_RAM_ATTR ProcessRFPacket(SX12xxDriverCommon::rx_status const status)
-{
-    if (status != SX12xxDriverCommon::SX12XX_RX_OK)
-    {
-        DBGVLN("HW CRC error");
-        #if defined(DEBUG_RX_SCOREBOARD)
-            lastPacketCrcError = true;
-        #endif
-        return false;
-    }
-    uint32_t const beginProcessing = micros();
-
-    OTA_Packet_s * const otaPktPtr = (OTA_Packet_s * const)Radio.RXdataBuffer;
-    OTA_Packet_s * const otaPktPtrSecond = (OTA_Packet_s * const)Radio.RXdataBufferSecond;
-
-    if (!OtaValidatePacketCrc(otaPktPtr))
-    {
-        DBGVLN("CRC error");
-        #if defined(DEBUG_RX_SCOREBOARD)
-            lastPacketCrcError = true;
-        #endif
-        return false;
-    }
-
-    PFDloop.extEvent(beginProcessing + PACKET_TO_TOCK_SLACK);
-
-    doStartTimer = false;
-    unsigned long now = millis();
-
-    LastValidPacket = now;
-
-    Radio.CheckForSecondPacket();
-    if (Radio.hasSecondRadioGotData)
-    {
-        if (!OtaValidatePacketCrc(otaPktPtrSecond))
-        {
-            Radio.hasSecondRadioGotData = false;
-        }
-    }
-
-    switch (otaPktPtr->std.type)
-    {
-    case PACKET_TYPE_RCDATA: //Standard RC Data Packet
-        ProcessRfPacket_RC(otaPktPtr);
-        break;
-    case PACKET_TYPE_SYNC: //sync packet from master
-        doStartTimer = ProcessRfPacket_SYNC(now,
-            OtaIsFullRes ? &otaPktPtr->full.sync.sync : &otaPktPtr->std.sync)
-            && !InBindingMode;
-        break;
-    case PACKET_TYPE_DATA:
-        if (firmwareOptions.is_airport)
-        {
-            OtaUnpackAirportData(otaPktPtr, &apOutputBuffer);
-        }
-        else
-        {
-            ProcessRfPacket_MSP(otaPktPtr);
-        }
-        break;
-    default:
-        break;
-    }
-
-    // Store the LQ/RSSI/Antenna
-    Radio.GetLastPacketStats();
-    getRFlinkInfo();
-
-    // Adjusts FreqCorrection for RX freq offset
-    if (Radio.FrequencyErrorAvailable())
-    {
-    #if defined(RADIO_SX127X)
-        int32_t tempFreqCorrection = HandleFreqCorr(Radio.GetFrequencyErrorbool(Radio.GetProcessingPacketRadio()), Radio.GetProcessingPacketRadio());
-        // Teamp900 also needs to adjust its demood PPM
-        Radio.SetPPMoffsetReg(tempFreqCorrection, Radio.GetProcessingPacketRadio());
-
-        if (Radio.hasSecondRadioGotData)
-        {
-            SX12XX_Radio_Number_t secondRadio = Radio.GetProcessingPacketRadio() == SX12XX_Radio_1 ? SX12XX_Radio_2 : SX12XX_Radio_1;
-            tempFreqCorrection = HandleFreqCorr(Radio.GetFrequencyErrorbool(secondRadio), secondRadio);
-            Radio.SetPPMoffsetReg(tempFreqCorrection, secondRadio);
-        }
-    #else
-        HandleFreqCorr(Radio.GetFrequencyErrorbool(Radio.GetProcessingPacketRadio()), Radio.GetProcessingPacketRadio());
-
-        if (Radio.hasSecondRadioGotData)
-        {
-            SX12XX_Radio_Number_t secondRadio = Radio.GetProcessingPacketRadio() == SX12XX_Radio_1 ? SX12XX_Radio_2 : SX12XX_Radio_1;
-            HandleFreqCorr(Radio.GetFrequencyErrorbool(secondRadio), secondRadio);
-        }
-    #endif
-    }
-
-    // Received a packet, that's the definition of LQ
-    LQCalc.add();
-    // Extend sync duration since we've received a packet at this rate
-    // but do not extend it indefinitely
-    RFmodeCycleMultiplier = RFmodeCycleMultiplierSlow;
-
-#if defined(DEBUG_RX_SCOREBOARD)
-    if (otaPktPtr->std.type != PACKET_TYPE_SYNC) DBGW(connectionHasModelMatch ? 'R' : 'r');
-#endif
-
-    return true;
 }
 
-bool ICACHE_RAM_ATTR RXdoneISR(SX12xxDriverCommon::rx_status const status)
+void ICACHE_RAM_ATTR OnRxTentativeConnection()
 {
-    if (LQCalc.currentIsSet() && connectionState == connected)
-    {
-        return false; // Already received a packet, do not run ProcessRFPacket() again.
-    }
-
-    if (ProcessRFPacket(status))
+    // Use this rate as the initial rate next time if we connected on it
+    config.SetRateInitialIdx(ExpressLRS_nextAirRateIndex);
+    // And stop counting toward binding mode
+    if (config.GetPowerOnCounter() != 0)
     {
-        didFHSS = HandleFHSS();
-
-        if (doStartTimer)
-        {
-            doStartTimer = false;
-            hwTimer::resume(); // will throw an interrupt immediately
-        }
-
-        return true;
+        config.SetPowerOnCounter(0);
     }
-    return false;
 }
 
-void ICACHE_RAM_ATTR TXdoneISR()
+void OnRxGotConnection()
 {
-    Radio.RXnb();
-#if defined(Regulatory_Domain_EU_CE_2400)
-    SetClearChannelAssessmentTime();
-#endif
-#if defined(DEBUG_RX_SCOREBOARD)
-    DBGW('T');
-#endif
+    webserverPreventAutoStart = true;
 }
 
 void UpdateModelMatch(uint8_t model)
@@ -1327,6 +343,13 @@ void MspReceiveComplete()
             ((SerialMavlink *)serialIO)->forwardMessage(MspData);
         }
         break;
+    case MSP_ELRS_MAVLINK_TLM_COMPRESSED: // 0xFC
+        // compressed mavlink data, or the TX's hello if empty
+        if (config.GetSerialProtocol() == PROTOCOL_MAVLINK)
+        {
+            ((SerialMavlink *)serialIO)->forwardCompressedMessage(MspData);
+        }
+        break;
     default:
         //handle received CRSF package
         crsf_ext_header_t *receivedHeader = (crsf_ext_header_t *) MspData;
@@ -1709,69 +732,7 @@ static void setupRadio()
     LBTEnabled = (config.GetPower() > PWR_10mW);
 #endif
 
-    Radio.RXdoneCallback = &RXdoneISR;
-    Radio.TXdoneCallback = &TXdoneISR;
-
-    scanIndex = config.GetRateInitialIdx();
-    for (int i=0 ; i<RATE_MAX ; i++)
-    {
-        if (isSupportedRFRate(scanIndex))
-        {
-            break;
-        }
-        scanIndex = (scanIndex + 1) % RATE_MAX;
-    }
-    SetRFLinkRate(scanIndex, false);
-    // Start slow on the selected rate to give it the best chance
-    // to connect before beginning rate cycling
-    RFmodeCycleMultiplier = RFmodeCycleMultiplierSlow / 2;
-}
-
-static void updateTelemetryBurst()
-{
-    if (telemBurstValid)
-        return;
-    telemBurstValid = true;
-
-    uint16_t hz = 1000000 / ExpressLRS_currAirRate_Modparams->interval;
-    telemetryBurstMax = TLMBurstMaxForRateRatio(hz, ExpressLRS_currTlmDenom);
-
-    // Notify the sender to adjust its expected throughput
-    TelemetrySender.UpdateTelemetryRate(hz, ExpressLRS_currTlmDenom, telemetryBurstMax);
-}
-
-/* If not connected will rotate through the RF modes looking for sync
- * and blink LED
- */
-static void cycleRfMode(unsigned long now)
-{
-    if (connectionState == connected || connectionState == wifiUpdate || InBindingMode)
-        return;
-
-    // Actually cycle the RF mode if not LOCK_ON_FIRST_CONNECTION
-    if (LockRFmode == false && (now - RFmodeLastCycled) > (cycleInterval * RFmodeCycleMultiplier))
-    {
-        RFmodeLastCycled = now;
-        LastSyncPacket = now;           // reset this variable
-        SendLinkStatstoFCForcedSends = 2;
-        SetRFLinkRate(scanIndex % RATE_MAX, false); // switch between rates
-        LQCalc.reset100();
-        LQCalcDVDA.reset100();
-        // Display the current air rate to the user as an indicator something is happening
-        scanIndex++;
-        Radio.RXnb();
-        DBGLN("%u", ExpressLRS_currAirRate_Modparams->interval);
-
-        // Skip unsupported modes for hardware with only a single LR1121 or with a single RF path
-        while (!isSupportedRFRate(scanIndex % RATE_MAX))
-        {
-            DBGLN("Skip %u", get_elrs_airRateConfig(scanIndex % RATE_MAX)->interval);
-            scanIndex++;
-        }
-
-        // Switch to FAST_SYNC if not already in it (won't be if was just connected)
-        RFmodeCycleMultiplier = 1;
-    } // if time to switch RF mode
+    SetupRFLink(config.GetRateInitialIdx());
 }
 
 static void EnterBindingMode()
@@ -1974,7 +935,7 @@ static void debugRcvrLinkstats()
         uint8_t fhss = debugRcvrLinkstatsFhssIdx;
         // actually the previous packet's offset since the update happens in tick, and this will
         // fire right after packet reception (a little before tock)
-        int32_t pfd = PfdPrevRawOffset;
+        int32_t pfd = PhaseLock.getLastPhaseError();
 
         // Use serial instead of DBG() because do not necessarily want all the debug in our logs
         char buf[50];
@@ -2029,16 +990,6 @@ static void debugRcvrSignalStats(uint32_t now)
 #endif
 }
 
-static void updateSwitchMode()
-{
-    // Negative value means waiting for confirm of the new switch mode while connected
-    if (SwitchModePending <= 0)
-        return;
-
-    OtaUpdateSerializers((OtaSwitchMode_e)(SwitchModePending - 1), ExpressLRS_currAirRate_Modparams->PayloadLength);
-    SwitchModePending = 0;
-}
-
 static void CheckConfigChangePending()
 {
     if (config.IsModified() && !InBindingMode && connectionState < NO_CONFIG_SAVE_STATES)
@@ -2051,6 +1002,14 @@ static void CheckConfigChangePending()
 #endif
         Radio.RXnb();
     }
+    else if (connectionState == disconnected && !InBindingMode && eeprom.CompactPending())
+    {
+        // Compact the config journal while there is no link to lose, so a commit doesn't have to.
+        // The erase stalls everything, so idle the radio through it like a commit
+        LostConnection(false);
+        eeprom.Compact();
+        Radio.RXnb();
+    }
 }
 
 #if defined(PLATFORM_ESP8266)
@@ -2178,7 +1137,7 @@ void loop()
         MspReceiveComplete();
     }
 
-    devicesUpdate(now);
+    int const deviceDelay = devicesUpdate(now);
 
     // read and process any data from serial ports, send any queued non-RC data
     handleSerialIO();
@@ -2189,57 +1148,16 @@ void loop()
     }
 
     CheckConfigChangePending();
-    executeDeferredFunction(micros());
+    long const deferredDelay = executeDeferredFunction(micros());
 
     if (connectionState > MODE_STATES)
     {
         return;
     }
 
-    if ((connectionState != disconnected) && (ExpressLRS_currAirRate_Modparams->index != ExpressLRS_nextAirRateIndex)) // forced change
-    {
-        DBGLN("Req air rate change %u->%u", ExpressLRS_currAirRate_Modparams->index, ExpressLRS_nextAirRateIndex);
-        if (!isSupportedRFRate(ExpressLRS_nextAirRateIndex))
-        {
-            DBGLN("Mode %u not supported, ignoring", ExpressLRS_nextAirRateIndex);
-            ExpressLRS_nextAirRateIndex = ExpressLRS_currAirRate_Modparams->index;
-        }
-        LostConnection(true);
-        LastSyncPacket = now;           // reset this variable to stop rf mode switching and add extra time
-        RFmodeLastCycled = now;         // reset this variable to stop rf mode switching and add extra time
-        SendLinkStatstoFCintervalLastSent = 0;
-        SendLinkStatstoFCForcedSends = 2;
-    }
-
-    if (connectionState == tentative && (now - LastSyncPacket > ExpressLRS_currAirRate_RFperfParams->RxLockTimeoutMs))
-    {
-        DBGLN("Bad sync, aborting");
-        LostConnection(true);
-        RFmodeLastCycled = now;
-        LastSyncPacket = now;
-    }
-
-    cycleRfMode(now);
-
-    uint32_t localLastValidPacket = LastValidPacket; // Required to prevent race condition due to LastValidPacket getting updated from ISR
-    if ((connectionState == connected) && ((int32_t)ExpressLRS_currAirRate_RFperfParams->DisconnectTimeoutMs < (int32_t)(now - localLastValidPacket))) // check if we lost conn.
-    {
-        LostConnection(true);
-    }
-
-    if ((connectionState == tentative) && (abs(LPF_OffsetDx.value()) <= 10) && (LPF_Offset.value() < 100) && (LQCalc.getLQRaw() > minLqForChaos())) //detects when we are connected
-    {
-        GotConnection(now);
-    }
-
+    UpdateConnectionState(now);
     checkSendLinkStatsToFc(now);
 
-    if ((RXtimerState == tim_tentative) && ((now - GotConnectionMillis) > ConsiderConnGoodMillis) && (abs(LPF_OffsetDx.value()) <= 5))
-    {
-        RXtimerState = tim_locked;
-        DBGLN("Timer locked");
-    }
-
     uint8_t nextPlayloadSize = 0;
     if (!TelemetrySender.IsActive() && telemetry.GetNextPayload(&nextPlayloadSize, currentTelemetryPayload))
     {
@@ -2254,10 +1172,14 @@ void loop()
     updateTelemetryBurst();
     updateBindingMode(now);
     updateSwitchMode();
+    updateAdaptiveHopping(now);
     checkGeminiMode();
     DynamicPower_UpdateRx(false);
     debugRcvrLinkstats();
     debugRcvrSignalStats(now);
+
+    // Nothing to do until a device or deferred function is due, or the radio has something for us
+    loopIdle(deviceDelay, deferredDelay);
 }
 
 #if defined(PLATFORM_ESP32_C3)
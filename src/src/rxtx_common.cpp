@@ -2,23 +2,51 @@
 #include "common.h"
 #include "config.h"
 #include "logging.h"
+#include "DeferredQueue.h"
 
-#include <functional>
 #include <Wire.h>
+#if defined(PLATFORM_ESP8266)
+#include <coredecls.h>
+#endif
+
+// The longest the main loop idles for, so the serial port is still serviced often enough
+static const uint32_t maxLoopIdleMs = 1;
 
-static const int maxDeferredFunctions = 3;
+// Callbacks run from the main loop, and ones that are normally called from an ISR
+static DeferredQueue loopDeferred(4);
+static DeferredQueue isrDeferred(2);
+
+#if defined(PLATFORM_ESP32)
+// hwTimer has timer 0, the one-shot runs the ISR callbacks on time
+static hw_timer_t *deferredTimer = nullptr;
+
+static void ICACHE_RAM_ATTR armDeferredTimer(int32_t us)
+{
+    if (us < 0)
+    {
+        timerAlarmDisable(deferredTimer);
+        return;
+    }
+    timerWrite(deferredTimer, 0);
+    timerAlarmWrite(deferredTimer, std::max(us, (int32_t)1), false);
+    timerAlarmEnable(deferredTimer);
+}
 
-struct deferred_t {
-    unsigned long started;
-    unsigned long timeout;
-    std::function<void()> function;
-};
+static void ICACHE_RAM_ATTR deferredTimerISR()
+{
+    isrDeferred.run(micros());
+}
 
-static deferred_t deferred[maxDeferredFunctions] = {
-    {0, 0, nullptr},
-    {0, 0, nullptr},
-    {0, 0, nullptr},
-};
+static void setupDeferredTimer()
+{
+    deferredTimer = timerBegin(1, (APB_CLK_FREQ / 1000000), true);
+    timerAttachInterrupt(deferredTimer, deferredTimerISR, true);
+    isrDeferred.setTimer(armDeferredTimer);
+}
+#else
+// The ESP8266's timers belong to hwTimer and the PWM waveform, so the ISR callbacks run from the loop
+static void setupDeferredTimer() {}
+#endif
 
 boolean i2c_enabled = false;
 
@@ -66,34 +94,112 @@ static void setupWire()
 void setupTargetCommon()
 {
     setupWire();
+    setupDeferredTimer();
 }
 
-void deferExecutionMicros(unsigned long us, std::function<void()> f)
+static void ICACHE_RAM_ATTR callPlain(void *fn)
 {
-    for (int i=0 ; i<maxDeferredFunctions ; i++)
+    ((void (*)())fn)();
+}
+
+void ICACHE_RAM_ATTR deferExecutionMicros(unsigned long us, void (*fn)(void *), void *ctx)
+{
+    if (!loopDeferred.add(micros(), us, fn, ctx))
     {
-        if (deferred[i].function == nullptr)
-        {
-            deferred[i].started = micros();
-            deferred[i].timeout = us;
-            deferred[i].function = f;
-            return;
-        }
+        // Bail out, there are no slots available!
+        DBGLN("No more deferred function slots available!");
     }
+}
 
-    // Bail out, there are no slots available!
-    DBGLN("No more deferred function slots available!");
+void ICACHE_RAM_ATTR deferExecutionMicros(unsigned long us, void (*fn)())
+{
+    deferExecutionMicros(us, callPlain, (void *)fn);
 }
 
-void executeDeferredFunction(unsigned long now)
+void ICACHE_RAM_ATTR deferISRExecutionMicros(unsigned long us, void (*fn)())
 {
-    // execute deferred function if its time has elapsed
-    for (int i=0 ; i<maxDeferredFunctions ; i++)
+    if (!isrDeferred.add(micros(), us, callPlain, (void *)fn))
+    {
+        DBGLN("No more deferred ISR slots available!");
+    }
+}
+
+long executeDeferredFunction(unsigned long now)
+{
+    loopDeferred.run(now);
+    long next = loopDeferred.untilNext(now);
+#if defined(PLATFORM_ESP32)
+    if (deferredTimer == nullptr)
+#endif
     {
-        if (deferred[i].function != nullptr && (now - deferred[i].started) > deferred[i].timeout)
+        // Without the one-shot timer the ISR callbacks are run from here
+        isrDeferred.run(now);
+        long const isrNext = isrDeferred.untilNext(now);
+        if (next == -1 || (isrNext != -1 && isrNext < next))
         {
-            deferred[i].function();
-            deferred[i].function = nullptr;
+            next = isrNext;
         }
     }
+    return next;
+}
+
+// The C3 runs its own loop that never blocks, see loop() in rx_main.cpp
+#if defined(PLATFORM_ESP32) && !defined(PLATFORM_ESP32_C3)
+#define LOOP_IDLE_TASK
+#endif
+
+#if defined(PLATFORM_ESP8266)
+static volatile bool loopWoken = false;
+#elif defined(LOOP_IDLE_TASK)
+static TaskHandle_t loopTask = nullptr;
+#endif
+
+void loopIdle(int deviceDelayMs, long deferredDelayUs)
+{
+    // Something is due before the CPU could usefully sleep
+    if (deviceDelayMs == 0 || (deferredDelayUs >= 0 && deferredDelayUs < 1000))
+    {
+        return;
+    }
+
+    uint32_t ms = maxLoopIdleMs;
+    if (deviceDelayMs > 0)
+    {
+        ms = std::min(ms, (uint32_t)deviceDelayMs);
+    }
+    if (deferredDelayUs >= 0)
+    {
+        ms = std::min(ms, (uint32_t)(deferredDelayUs / 1000));
+    }
+
+#if defined(PLATFORM_ESP8266)
+    // Suspend until the os timer expires or loopWakeFromISR() schedules the loop again
+    if (!loopWoken)
+    {
+        esp_delay(ms, []() { return !loopWoken; });
+    }
+    loopWoken = false;
+#elif defined(LOOP_IDLE_TASK)
+    if (loopTask == nullptr)
+    {
+        loopTask = xTaskGetCurrentTaskHandle();
+    }
+    // A wake given while the loop was running is still pending, so this returns immediately
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms));
+#endif
+}
+
+void ICACHE_RAM_ATTR loopWakeFromISR()
+{
+#if defined(PLATFORM_ESP8266)
+    loopWoken = true;
+    esp_schedule();
+#elif defined(LOOP_IDLE_TASK)
+    if (loopTask != nullptr)
+    {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(loopTask, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+#endif
 }
@@ -1,4 +1,6 @@
 #include "rxtx_common.h"
+#include "rxtx_intf.h"
+#include "tx_link.h"
 
 #include "CRSFHandset.h"
 #include "dynpower.h"
@@ -6,8 +8,6 @@
 #include "msp.h"
 #include "msptypes.h"
 #include "telemetry_protocol.h"
-#include "stubborn_receiver.h"
-#include "stubborn_sender.h"
 
 #include "devHandset.h"
 #include "devADC.h"
@@ -31,6 +31,7 @@ void sendMAVLinkTelemetryToBackpack(uint8_t *) {}
 #endif
 
 #include "MAVLink.h"
+#include "MAVLinkCompress.h"
 
 #if defined(PLATFORM_ESP32_S3)
 #include "USB.h"
@@ -52,51 +53,33 @@ Stream *TxBackpack;
 Stream *TxUSB;
 
 // Variables / constants for Airport //
-FIFO<AP_MAX_BUF_LEN> apInputBuffer;
-FIFO<AP_MAX_BUF_LEN> apOutputBuffer;
+SPSCFIFO<AP_MAX_BUF_LEN> apInputBuffer;
+SPSCFIFO<AP_MAX_BUF_LEN> apOutputBuffer;
 
 #define UART_INPUT_BUF_LEN 1024
 FIFO<UART_INPUT_BUF_LEN> uartInputBuffer;
 
 uint8_t mavlinkSSBuffer[CRSF_MAX_PACKET_LEN]; // Buffer for current stubbon sender packet (mavlink only)
+// The uplink is compressed once the RX has sent compressed downlink, until then it is offered with a hello
+MAVLinkCompressor mavlinkCompressor;
+MAVLinkDecompressor mavlinkDecompressor;
+bool mavlinkCompressUplink = false;
+uint32_t mavlinkHelloMillis = 0;
+#define MAVLINK_COMPRESS_HELLO_INTERVAL 1000
 
 unsigned long rebootTime = 0;
 extern bool webserverPreventAutoStart;
-//// MSP Data Handling ///////
-bool NextPacketIsMspData = false;  // if true the next packet will contain the msp data
 char backpackVersion[32] = "";
-uint8_t packageIndexRadio1 = 0xFF;
-uint8_t packageIndexRadio2 = 0xFF;
-uint8_t tlmSenderDoubleBuffer[20] = {0};
-
-////////////SYNC PACKET/////////
-/// sync packet spamming on mode change vars ///
-#define syncSpamAmount 3
-#define syncSpamAmountAfterRateChange 10
-volatile uint8_t syncSpamCounter = 0;
-volatile uint8_t syncSpamCounterAfterRateChange = 0;
-uint32_t rfModeLastChangedMS = 0;
-uint32_t SyncPacketLastSent = 0;
-static enum { stbIdle, stbRequested, stbBoosting } syncTelemBoostState = stbIdle;
-////////////////////////////////////////////////
-
-volatile uint32_t LastTLMpacketRecvMillis = 0;
-uint32_t TLMpacketReported = 0;
-static bool commitInProgress = false;
 
-LQCALC<25> LQCalc;
+uint32_t TLMpacketReported = 0;
 
-volatile bool busyTransmitting;
+LQSTATS LQStats;
 static volatile bool ModelUpdatePending;
 
 uint8_t MSPDataPackage[5];
 #define BindingSpamAmount 25
-static uint8_t BindingSendCount;
 bool RxWiFiReadyToSend = false;
 
-static TxTlmRcvPhase_e TelemetryRcvPhase = ttrpTransmitting;
-StubbornReceiver TelemetryReceiver;
-StubbornSender MspSender;
 uint8_t CRSFinBuffer[CRSF_MAX_PACKET_LEN+1];
 
 device_affinity_t ui_devices[] = {
@@ -133,333 +116,18 @@ void switchDiversityAntennas()
   }
 }
 
-void ICACHE_RAM_ATTR LinkStatsFromOta(OTA_LinkStats_s * const ls)
-{
-  int8_t snrScaled = ls->SNR;
-  DynamicPower_TelemetryUpdate(snrScaled);
-
-  // Antenna is the high bit in the RSSI_1 value
-  // RSSI received is signed, inverted polarity (positive value = -dBm)
-  // OpenTX's value is signed and will display +dBm and -dBm properly
-  CRSF::LinkStatistics.uplink_RSSI_1 = -(ls->uplink_RSSI_1);
-  CRSF::LinkStatistics.uplink_RSSI_2 = -(ls->uplink_RSSI_2);
-  CRSF::LinkStatistics.uplink_Link_quality = ls->lq;
-#if defined(DEBUG_FREQ_CORRECTION)
-  // Don't descale the FreqCorrection value being send in SNR
-  CRSF::LinkStatistics.uplink_SNR = snrScaled;
-#else
-  CRSF::LinkStatistics.uplink_SNR = SNR_DESCALE(snrScaled);
-#endif
-  CRSF::LinkStatistics.active_antenna = ls->antenna;
-  connectionHasModelMatch = ls->modelMatch;
-  // -- downlink_SNR / downlink_RSSI is updated for any packet received, not just Linkstats
-  // -- uplink_TX_Power is updated when sending to the handset, so it updates when missing telemetry
-  // -- rf_mode is updated when we change rates
-  // -- downlink_Link_quality is updated before the LQ period is incremented
-  MspSender.ConfirmCurrentPayload(ls->tlmConfirm);
-}
+uint8_t getTxRate() { return config.GetRate(); }
+expresslrs_tlm_ratio_e getTxTlm() { return (expresslrs_tlm_ratio_e)config.GetTlm(); }
+uint8_t getTxSwitchMode() { return config.GetSwitchMode(); }
+uint8_t getTxLinkMode() { return config.GetLinkMode(); }
+bool getTxModelMatch() { return config.GetModelMatch(); }
+uint8_t getTxAntennaMode() { return config.GetAntennaMode(); }
+void setTxAntennaMode(uint8_t mode) { config.SetAntennaMode(mode); }
 
-bool ICACHE_RAM_ATTR ProcessTLMpacket(SX12xxDriverCommon::rx_status const status)
+void OnDownlinkConnected()
 {
-  if (status != SX12xxDriverCommon::SX12XX_RX_OK)
-  {
-    DBGLN("TLM HW CRC error");
-    return false;
-  }
-
-  OTA_Packet_s * const otaPktPtr = (OTA_Packet_s * const)Radio.RXdataBuffer;
-  OTA_Packet_s * const otaPktPtrSecond = (OTA_Packet_s * const)Radio.RXdataBufferSecond;
-
-  if (!OtaValidatePacketCrc(otaPktPtr))
-  {
-    DBGLN("TLM crc error");
-    return false;
-  }
-
-  LastTLMpacketRecvMillis = millis();
-  LQCalc.add();
-
-  Radio.CheckForSecondPacket();
-  if (Radio.hasSecondRadioGotData)
-  {
-    if (!OtaValidatePacketCrc(otaPktPtrSecond))
-    {
-      Radio.hasSecondRadioGotData = false;
-    }
-  }
-
-  Radio.GetLastPacketStats();
-  CRSF::LinkStatistics.downlink_SNR = SNR_DESCALE(Radio.LastPacketSNRRaw);
-  CRSF::LinkStatistics.downlink_RSSI_1 = Radio.LastPacketRSSI;
-  CRSF::LinkStatistics.downlink_RSSI_2 = Radio.LastPacketRSSI2;
-
-  // Full res mode
-  if (OtaIsFullRes)
-  {
-    OTA_Packet8_s * const ota8 = (OTA_Packet8_s * const)otaPktPtr;
-    OTA_Packet8_s * const ota8Second = (OTA_Packet8_s * const)otaPktPtrSecond;
-    
-    switch (otaPktPtr->std.type)
-    {
-      case PACKET_TYPE_LINKSTATS:
-        LinkStatsFromOta(&ota8->tlm_dl.ul_link_stats.stats);
-
-        // The Rx only has a single radio.  Force the Tx out of Gemini mode. 
-        if (config.GetAntennaMode() == TX_RADIO_MODE_GEMINI && !ota8->tlm_dl.ul_link_stats.trueDiversityAvailable)
-        {
-            config.SetAntennaMode(TX_RADIO_MODE_SWITCH);
-        }    
-
-        if (config.GetAntennaMode() == TX_RADIO_MODE_GEMINI)
-        {
-            if (Radio.GetProcessingPacketRadio() == SX12XX_Radio_1)
-            {
-                packageIndexRadio1 = ota8->tlm_dl.packageIndex;
-                memcpy(tlmSenderDoubleBuffer, ota8->tlm_dl.ul_link_stats.payload, sizeof(ota8->tlm_dl.ul_link_stats.payload));
-            }
-            else
-            {
-                packageIndexRadio2 = ota8->tlm_dl.packageIndex;
-                memcpy(&tlmSenderDoubleBuffer[sizeof(ota8->tlm_dl.ul_link_stats.payload)], ota8->tlm_dl.ul_link_stats.payload, sizeof(ota8->tlm_dl.ul_link_stats.payload));
-            }
-
-            if (Radio.GetProcessingPacketRadio() == SX12XX_Radio_1 && Radio.hasSecondRadioGotData)
-            {
-                packageIndexRadio2 = ota8Second->tlm_dl.packageIndex;
-                memcpy(&tlmSenderDoubleBuffer[sizeof(ota8Second->tlm_dl.ul_link_stats.payload)], ota8Second->tlm_dl.ul_link_stats.payload, sizeof(ota8Second->tlm_dl.ul_link_stats.payload));
-            }
-            else if (Radio.GetProcessingPacketRadio() == SX12XX_Radio_2 && Radio.hasSecondRadioGotData)
-            {
-                packageIndexRadio1 = ota8Second->tlm_dl.packageIndex;
-                memcpy(tlmSenderDoubleBuffer, ota8Second->tlm_dl.ul_link_stats.payload, sizeof(ota8Second->tlm_dl.ul_link_stats.payload));
-            }
-            
-            if (packageIndexRadio1 == packageIndexRadio2 && packageIndexRadio1 != 0xFF)
-            {
-                TelemetryReceiver.ReceiveData(packageIndexRadio1 & ELRS8_TELEMETRY_MAX_PACKAGES, 
-                    tlmSenderDoubleBuffer, 2 * sizeof(ota8->tlm_dl.ul_link_stats.payload));
-                packageIndexRadio1 = 0xFF;
-                packageIndexRadio2 = 0xFF;
-            }
-        }
-        else
-        {
-            TelemetryReceiver.ReceiveData(ota8->tlm_dl.packageIndex & ELRS8_TELEMETRY_MAX_PACKAGES,
-                ota8->tlm_dl.ul_link_stats.payload, sizeof(ota8->tlm_dl.ul_link_stats.payload));
-        }
-        break;
-
-      case PACKET_TYPE_DATA:
-        if (firmwareOptions.is_airport)
-        {
-          OtaUnpackAirportData(otaPktPtr, &apOutputBuffer);
-        }
-        else
-        {
-            if (config.GetAntennaMode() == TX_RADIO_MODE_GEMINI)
-            {
-                if (Radio.GetProcessingPacketRadio() == SX12XX_Radio_1)
-                {
-                    packageIndexRadio1 = ota8->tlm_dl.packageIndex;
-                    memcpy(tlmSenderDoubleBuffer, ota8->tlm_dl.payload, sizeof(ota8->tlm_dl.payload));
-                }
-                else
-                {
-                    packageIndexRadio2 = ota8->tlm_dl.packageIndex;
-                    memcpy(&tlmSenderDoubleBuffer[sizeof(ota8->tlm_dl.payload)], ota8->tlm_dl.payload, sizeof(ota8->tlm_dl.payload));
-                }
-
-                if (Radio.GetProcessingPacketRadio() == SX12XX_Radio_1 && Radio.hasSecondRadioGotData)
-                {
-                    packageIndexRadio2 = ota8Second->tlm_dl.packageIndex;
-                    memcpy(&tlmSenderDoubleBuffer[sizeof(ota8Second->tlm_dl.payload)], ota8Second->tlm_dl.payload, sizeof(ota8Second->tlm_dl.payload));
-                }
-                else if (Radio.GetProcessingPacketRadio() == SX12XX_Radio_2 && Radio.hasSecondRadioGotData)
-                {
-                    packageIndexRadio1 = ota8Second->tlm_dl.packageIndex;
-                    memcpy(tlmSenderDoubleBuffer, ota8Second->tlm_dl.payload, sizeof(ota8Second->tlm_dl.payload));
-                }
-                
-                if (packageIndexRadio1 == packageIndexRadio2 && packageIndexRadio1 != 0xFF)
-                {
-                    MspSender.ConfirmCurrentPayload(ota8->tlm_dl.tlmConfirm);
-                    TelemetryReceiver.ReceiveData(packageIndexRadio1 & ELRS8_TELEMETRY_MAX_PACKAGES, 
-                        tlmSenderDoubleBuffer, 2 * sizeof(ota8->tlm_dl.payload));
-                    packageIndexRadio1 = 0xFF;
-                    packageIndexRadio2 = 0xFF;
-                }
-            }
-            else
-            {
-                MspSender.ConfirmCurrentPayload(ota8->tlm_dl.tlmConfirm);
-                TelemetryReceiver.ReceiveData(ota8->tlm_dl.packageIndex & ELRS8_TELEMETRY_MAX_PACKAGES,
-                    ota8->tlm_dl.payload, sizeof(ota8->tlm_dl.payload));
-            }
-        }
-        break;
-    }
-  }
-  // Std res mode
-  else
-  {
-    switch (otaPktPtr->std.type)
-    {
-      case PACKET_TYPE_LINKSTATS:
-        LinkStatsFromOta(&otaPktPtr->std.tlm_dl.ul_link_stats.stats);
-
-        // The Rx only has a single radio.  Force the Tx out of Gemini mode. 
-        if (config.GetAntennaMode() == TX_RADIO_MODE_GEMINI && !otaPktPtr->std.tlm_dl.ul_link_stats.trueDiversityAvailable)
-        {
-            config.SetAntennaMode(TX_RADIO_MODE_SWITCH);
-        }
-        break;
-
-      case PACKET_TYPE_DATA:
-        if (firmwareOptions.is_airport)
-        {
-          OtaUnpackAirportData(otaPktPtr, &apOutputBuffer);
-        }
-        else
-        {
-            if (config.GetAntennaMode() == TX_RADIO_MODE_GEMINI)
-            {
-                if (Radio.GetProcessingPacketRadio() == SX12XX_Radio_1)
-                {
-                    packageIndexRadio1 = otaPktPtr->std.tlm_dl.packageIndex;
-                    memcpy(tlmSenderDoubleBuffer, otaPktPtr->std.tlm_dl.payload, sizeof(otaPktPtr->std.tlm_dl.payload));
-                }
-                else
-                {
-                    packageIndexRadio2 = otaPktPtr->std.tlm_dl.packageIndex;
-                    memcpy(&tlmSenderDoubleBuffer[sizeof(otaPktPtr->std.tlm_dl.payload)], otaPktPtr->std.tlm_dl.payload, sizeof(otaPktPtr->std.tlm_dl.payload));
-                }
-
-                if (Radio.GetProcessingPacketRadio() == SX12XX_Radio_1 && Radio.hasSecondRadioGotData)
-                {
-                    packageIndexRadio2 = otaPktPtrSecond->std.tlm_dl.packageIndex;
-                    memcpy(&tlmSenderDoubleBuffer[sizeof(otaPktPtrSecond->std.tlm_dl.payload)], otaPktPtrSecond->std.tlm_dl.payload, sizeof(otaPktPtrSecond->std.tlm_dl.payload));
-                }
-                else if (Radio.GetProcessingPacketRadio() == SX12XX_Radio_2 && Radio.hasSecondRadioGotData)
-                {
-                    packageIndexRadio1 = otaPktPtrSecond->std.tlm_dl.packageIndex;
-                    memcpy(tlmSenderDoubleBuffer, otaPktPtrSecond->std.tlm_dl.payload, sizeof(otaPktPtrSecond->std.tlm_dl.payload));
-                }
-                
-                if (packageIndexRadio1 == packageIndexRadio2 && packageIndexRadio1 != 0xFF)
-                {
-                    MspSender.ConfirmCurrentPayload(otaPktPtr->std.tlm_dl.tlmConfirm);
-                    TelemetryReceiver.ReceiveData(packageIndexRadio1 & ELRS4_TELEMETRY_MAX_PACKAGES, 
-                        tlmSenderDoubleBuffer, 2 * sizeof(otaPktPtr->std.tlm_dl.payload));
-                    packageIndexRadio1 = 0xFF;
-                    packageIndexRadio2 = 0xFF;
-                }
-            }
-            else
-            {
-                MspSender.ConfirmCurrentPayload(otaPktPtr->std.tlm_dl.tlmConfirm);
-                TelemetryReceiver.ReceiveData(otaPktPtr->std.tlm_dl.packageIndex & ELRS4_TELEMETRY_MAX_PACKAGES,
-                    otaPktPtr->std.tlm_dl.payload,
-                    sizeof(otaPktPtr->std.tlm_dl.payload));
-            }
-        }
-        break;
-    }
-  }
-
-  return true;
-}
-
-expresslrs_tlm_ratio_e ICACHE_RAM_ATTR UpdateTlmRatioEffective()
-{
-  expresslrs_tlm_ratio_e ratioConfigured = (expresslrs_tlm_ratio_e)config.GetTlm();
-  // default is suggested rate for TLM_RATIO_STD/TLM_RATIO_DISARMED
-  expresslrs_tlm_ratio_e retVal = ExpressLRS_currAirRate_Modparams->TLMinterval;
-  bool updateTelemDenom = true;
-
-  // TLM ratio is boosted until there is one complete sync cycle with no BoostRequest
-  if (syncTelemBoostState == stbBoosting)
-  {
-    syncTelemBoostState = stbIdle;
-  }
-
-  if (syncTelemBoostState == stbRequested)
-  {
-    syncTelemBoostState = stbBoosting;
-    // default to 1:2 telemetry ratio bump for non-wide modes and
-    // wide mode configured to 1:4
-    retVal = TLM_RATIO_1_2;
-
-    if (!OtaIsFullRes && config.GetSwitchMode() == smWideOr8ch)
-    {
-      // avoid crossing the wide switch 7-bit to 6-bit boundary
-      if (ratioConfigured <= TLM_RATIO_1_8 || ratioConfigured == TLM_RATIO_DISARMED)
-      {
-        retVal = TLM_RATIO_1_8;
-      }
-    }
-  }
-  // If Armed, telemetry is disabled, otherwise use STD
-  else if (ratioConfigured == TLM_RATIO_DISARMED)
-  {
-    if (handset->IsArmed())
-    {
-      retVal = TLM_RATIO_NO_TLM;
-      // Avoid updating ExpressLRS_currTlmDenom until connectionState == disconnected
-      if (connectionState == connected)
-        updateTelemDenom = false;
-    }
-  }
-  else if (ratioConfigured != TLM_RATIO_STD)
-  {
-    retVal = ratioConfigured;
-  }
-
-  if (updateTelemDenom)
-  {
-    uint8_t newTlmDenom = TLMratioEnumToValue(retVal);
-    // Delay going into disconnected state when the TLM ratio increases
-    if (connectionState == connected && ExpressLRS_currTlmDenom > newTlmDenom)
-      LastTLMpacketRecvMillis = SyncPacketLastSent;
-    ExpressLRS_currTlmDenom = newTlmDenom;
-  }
-
-  return retVal;
-}
-
-void ICACHE_RAM_ATTR GenerateSyncPacketData(OTA_Sync_s * const syncPtr)
-{
-  const uint8_t SwitchEncMode = config.GetSwitchMode();
-  const uint8_t Index = (syncSpamCounter) ? config.GetRate() : ExpressLRS_currAirRate_Modparams->index;
-
-  if (syncSpamCounter)
-    --syncSpamCounter;
-
-  if (syncSpamCounterAfterRateChange && Index == ExpressLRS_currAirRate_Modparams->index)
-  {
-    --syncSpamCounterAfterRateChange;
-    if (connectionState == connected) // We are connected again after a rate change.  No need to keep spaming sync.
-      syncSpamCounterAfterRateChange = 0;
-  }
-
-  SyncPacketLastSent = millis();
-
-  expresslrs_tlm_ratio_e newTlmRatio = UpdateTlmRatioEffective();
-
-  syncPtr->fhssIndex = FHSSgetCurrIndex();
-  syncPtr->nonce = OtaNonce;
-  syncPtr->rfRateEnum = get_elrs_airRateConfig(Index)->enum_rate;
-  syncPtr->switchEncMode = SwitchEncMode;
-  syncPtr->newTlmRatio = newTlmRatio - TLM_RATIO_NO_TLM;
-  syncPtr->geminiMode = isDualRadio() && config.GetAntennaMode() == TX_RADIO_MODE_GEMINI;
-  syncPtr->otaProtocol = config.GetLinkMode();
-  syncPtr->UID4 = UID[4];
-  syncPtr->UID5 = UID[5];
-
-  // For model match, the last byte of the binding ID is XORed with the inverse of the modelId
-  if (!InBindingMode && config.GetModelMatch())
-  {
-    syncPtr->UID5 ^= (~CRSFHandset::getModelID()) & MODELMATCH_MASK;
-  }
+  uartInputBuffer.flush();
+  mavlinkCompressUplink = false;
 }
 
 uint8_t adjustPacketRateForBaud(uint8_t rateIndex)
@@ -467,319 +135,6 @@ uint8_t adjustPacketRateForBaud(uint8_t rateIndex)
   return rateIndex = get_elrs_HandsetRate_max(rateIndex, handset->getMinPacketInterval());
 }
 
-void SetRFLinkRate(uint8_t index) // Set speed of RF link
-{
-  expresslrs_mod_settings_s *const ModParams = get_elrs_airRateConfig(index);
-  expresslrs_rf_pref_params_s *const RFperf = get_elrs_RFperfParams(index);
-  // Binding always uses invertIQ
-  bool invertIQ = InBindingMode || (UID[5] & 0x01);
-  OtaSwitchMode_e newSwitchMode = (OtaSwitchMode_e)config.GetSwitchMode();
-
-  if ((ModParams == ExpressLRS_currAirRate_Modparams)
-    && (RFperf == ExpressLRS_currAirRate_RFperfParams)
-    && (OtaSwitchModeCurrent == newSwitchMode))
-    return;
-
-  DBGLN("set rate %u", index);
-  uint32_t interval = ModParams->interval;
-#if defined(DEBUG_FREQ_CORRECTION) && defined(RADIO_SX128X)
-  interval = interval * 12 / 10; // increase the packet interval by 20% to allow adding packet header
-#endif
-  hwTimer::updateInterval(interval);
-
-  FHSSusePrimaryFreqBand = !(ModParams->radio_type == RADIO_TYPE_LR1121_LORA_2G4) && !(ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_2G4);
-  FHSSuseDualBand = ModParams->radio_type == RADIO_TYPE_LR1121_LORA_DUAL;
-
-  Radio.Config(ModParams->bw, ModParams->sf, ModParams->cr, FHSSgetInitialFreq(),
-               ModParams->PreambleLen, invertIQ, ModParams->PayloadLength, ModParams->interval
-#if defined(RADIO_SX128X)
-               , uidMacSeedGet(), OtaCrcInitializer, (ModParams->radio_type == RADIO_TYPE_SX128x_FLRC)
-#endif
-#if defined(RADIO_LR1121)
-               , (ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_900 || ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_2G4), (uint8_t)UID[5], (uint8_t)UID[4]
-#endif
-               );
-
-#if defined(RADIO_LR1121)
-  if (FHSSuseDualBand)
-  {
-    Radio.Config(ModParams->bw2, ModParams->sf2, ModParams->cr2, FHSSgetInitialGeminiFreq(),
-                ModParams->PreambleLen2, invertIQ, ModParams->PayloadLength, ModParams->interval,
-                (ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_900 || ModParams->radio_type == RADIO_TYPE_LR1121_GFSK_2G4),
-                (uint8_t)UID[5], (uint8_t)UID[4], SX12XX_Radio_2);
-  }
-#endif
-
-  Radio.FuzzySNRThreshold = (RFperf->DynpowerSnrThreshUp == DYNPOWER_SNR_THRESH_NONE) ? 0 : (RFperf->DynpowerSnrThreshUp - RFperf->DynpowerSnrThreshDn);
-
-  if ((isDualRadio() && config.GetAntennaMode() == TX_RADIO_MODE_GEMINI) || FHSSuseDualBand) // Gemini mode
-  {
-    Radio.SetFrequencyReg(FHSSgetInitialGeminiFreq(), SX12XX_Radio_2);
-  }
-
-  // InitialFreq has been set, so lets also reset the FHSS Idx and Nonce.
-  FHSSsetCurrIndex(0);
-  OtaNonce = 0;
-
-  OtaUpdateSerializers(newSwitchMode, ModParams->PayloadLength);
-  MspSender.setMaxPackageIndex(ELRS_MSP_MAX_PACKAGES);
-  TelemetryReceiver.setMaxPackageIndex(OtaIsFullRes ? ELRS8_TELEMETRY_MAX_PACKAGES : ELRS4_TELEMETRY_MAX_PACKAGES);
-
-  ExpressLRS_currAirRate_Modparams = ModParams;
-  ExpressLRS_currAirRate_RFperfParams = RFperf;
-  CRSF::LinkStatistics.rf_Mode = ModParams->enum_rate;
-
-  handset->setPacketInterval(interval * ExpressLRS_currAirRate_Modparams->numOfSends);
-  setConnectionState(disconnected);
-  rfModeLastChangedMS = millis();
-}
-
-void ICACHE_RAM_ATTR HandleFHSS()
-{
-  uint8_t modresult = (OtaNonce + 1) % ExpressLRS_currAirRate_Modparams->FHSShopInterval;
-  // If the next packet should be on the next FHSS frequency, do the hop
-  if (!InBindingMode && modresult == 0)
-  {
-    // Gemini mode
-    // If using DualBand always set the correct frequency band to the radios.  The HighFreq/LowFreq Tx amp is set during config.
-    if ((isDualRadio() && config.GetAntennaMode() == TX_RADIO_MODE_GEMINI) || FHSSuseDualBand)
-    {
-        // Optimises the SPI traffic order.
-        if (Radio.GetProcessingPacketRadio() == SX12XX_Radio_1)
-        {
-            uint32_t freqRadio = FHSSgetNextFreq();
-            Radio.SetFrequencyReg(FHSSgetGeminiFreq(), SX12XX_Radio_2);
-            Radio.SetFrequencyReg(freqRadio, SX12XX_Radio_1);
-        }
-        else
-        {
-            Radio.SetFrequencyReg(FHSSgetNextFreq(), SX12XX_Radio_1);
-            Radio.SetFrequencyReg(FHSSgetGeminiFreq(), SX12XX_Radio_2);
-        }
-    }
-    else
-    {
-      Radio.SetFrequencyReg(FHSSgetNextFreq());
-    }
-  }
-}
-
-void ICACHE_RAM_ATTR HandlePrepareForTLM()
-{
-  // If TLM enabled and next packet is going to be telemetry, start listening to have a large receive window (time-wise)
-  if (ExpressLRS_currTlmDenom != 1 && ((OtaNonce + 1) % ExpressLRS_currTlmDenom) == 0)
-  {
-    Radio.RXnb();
-    TelemetryRcvPhase = ttrpPreReceiveGap;
-  }
-}
-
-void ICACHE_RAM_ATTR SendRCdataToRF()
-{
-  // Do not send a stale channels packet to the RX if one has not been received from the handset
-  // *Do* send data if a packet has never been received from handset and the timer is running
-  // this is the case when bench testing and TXing without a handset
-  bool dontSendChannelData = false;
-  uint32_t lastRcData = handset->GetRCdataLastRecv();
-  if (lastRcData && (micros() - lastRcData > 1000000))
-  {
-    // The tx is in Mavlink mode and without a valid crsf or RC input.  Do not send stale or fake zero packet RC!
-    // Only send sync and MSP packets.
-    if (config.GetLinkMode() == TX_MAVLINK_MODE)
-    {
-      dontSendChannelData = true;
-    }
-    else
-    {
-      return;
-    }
-  }
-
-  busyTransmitting = true;
-
-  uint32_t const now = millis();
-  // ESP requires word aligned buffer
-  WORD_ALIGNED_ATTR OTA_Packet_s otaPkt = {0};
-  static uint8_t syncSlot;
-
-  const bool isTlmDisarmed = config.GetTlm() == TLM_RATIO_DISARMED;
-  uint32_t SyncInterval = (connectionState == connected && !isTlmDisarmed) ? ExpressLRS_currAirRate_RFperfParams->SyncPktIntervalConnected : ExpressLRS_currAirRate_RFperfParams->SyncPktIntervalDisconnected;
-  bool skipSync = InBindingMode ||
-    // TLM_RATIO_DISARMED keeps sending sync packets even when armed until the RX stops sending telemetry and the TLM=Off has taken effect
-    (isTlmDisarmed && handset->IsArmed() && (ExpressLRS_currTlmDenom == 1));
-
-  uint8_t NonceFHSSresult = OtaNonce % ExpressLRS_currAirRate_Modparams->FHSShopInterval;
-
-  // Sync spam only happens on slot 1 and 2 and can't be disabled
-  if ((syncSpamCounter || (syncSpamCounterAfterRateChange && FHSSonSyncChannel())) && (NonceFHSSresult == 1 || NonceFHSSresult == 2))
-  {
-    otaPkt.std.type = PACKET_TYPE_SYNC;
-    GenerateSyncPacketData(OtaIsFullRes ? &otaPkt.full.sync.sync : &otaPkt.std.sync);
-    syncSlot = 0; // reset the sync slot in case the new rate (after the syncspam) has a lower FHSShopInterval
-  }
-  // Regular sync rotates through 4x slots, twice on each slot, and telemetry pushes it to the next slot up
-  // But only on the sync FHSS channel and with a timed delay between them
-  else if ((!skipSync) && ((syncSlot / 2) <= NonceFHSSresult) && (now - SyncPacketLastSent > SyncInterval) && FHSSonSyncChannel())
-  {
-    otaPkt.std.type = PACKET_TYPE_SYNC;
-    GenerateSyncPacketData(OtaIsFullRes ? &otaPkt.full.sync.sync : &otaPkt.std.sync);
-    syncSlot = (syncSlot + 1) % (ExpressLRS_currAirRate_Modparams->FHSShopInterval * 2);
-  }
-  else
-  {
-    if (firmwareOptions.is_airport)
-    {
-      OtaPackAirportData(&otaPkt, &apInputBuffer);
-    }
-    else if ((NextPacketIsMspData && MspSender.IsActive()) || dontSendChannelData)
-    {
-      otaPkt.std.type = PACKET_TYPE_DATA;
-      if (OtaIsFullRes)
-      {
-        otaPkt.full.msp_ul.packageIndex = MspSender.GetCurrentPayload(
-          otaPkt.full.msp_ul.payload,
-          sizeof(otaPkt.full.msp_ul.payload));
-        if (config.GetLinkMode() == TX_MAVLINK_MODE)
-          otaPkt.full.msp_ul.tlmConfirm = TelemetryReceiver.GetCurrentConfirm();
-      }
-      else
-      {
-        otaPkt.std.msp_ul.packageIndex = MspSender.GetCurrentPayload(
-          otaPkt.std.msp_ul.payload,
-          sizeof(otaPkt.std.msp_ul.payload));
-        if (config.GetLinkMode() == TX_MAVLINK_MODE)
-          otaPkt.std.msp_ul.tlmConfirm = TelemetryReceiver.GetCurrentConfirm();
-      }
-
-      // send channel data next so the channel messages also get sent during msp transmissions
-      NextPacketIsMspData = false;
-      // counter can be increased even for normal msp messages since it's reset if a real bind message should be sent
-      BindingSendCount++;
-      // If not in TlmBurst, request a sync packet soon to trigger higher download bandwidth for reply
-      if (syncTelemBoostState == stbIdle)
-        syncSpamCounter = 1;
-      syncTelemBoostState = stbRequested;
-    }
-    else
-    {
-      // always enable msp after a channel package since the slot is only used if MspSender has data to send
-      NextPacketIsMspData = true;
-
-      OtaPackChannelData(&otaPkt, ChannelData, TelemetryReceiver.GetCurrentConfirm(), ExpressLRS_currTlmDenom);
-    }
-  }
-
-  ///// Next, Calculate the CRC and put it into the buffer /////
-  OtaGeneratePacketCrc(&otaPkt);
-
-  SX12XX_Radio_Number_t transmittingRadio = Radio.GetLastSuccessfulPacketRadio();
-
-  if (isDualRadio())
-  {
-    switch (config.GetAntennaMode())
-    {
-    case TX_RADIO_MODE_GEMINI:
-      transmittingRadio = SX12XX_Radio_All; // Gemini mode
-      break;
-    case TX_RADIO_MODE_ANT_1:
-      transmittingRadio = SX12XX_Radio_1; // Single antenna tx and true diversity rx for tlm receiption.
-      break;
-    case TX_RADIO_MODE_ANT_2:
-      transmittingRadio = SX12XX_Radio_2; // Single antenna tx and true diversity rx for tlm receiption.
-      break;
-    case TX_RADIO_MODE_SWITCH:
-      if(OtaNonce%2==0)   transmittingRadio = SX12XX_Radio_1; // Single antenna tx and true diversity rx for tlm receiption.
-      else   transmittingRadio = SX12XX_Radio_2; // Single antenna tx and true diversity rx for tlm receiption.
-      break;
-    default:
-      break;
-    }
-  }
-
-#if defined(Regulatory_Domain_EU_CE_2400)
-  transmittingRadio &= ChannelIsClear(transmittingRadio);   // weed out the radio(s) if channel in use
-
-  if (transmittingRadio == SX12XX_Radio_NONE)
-  {
-    // No packet will be sent due to LBT.
-    // Defer TXdoneCallback() to prepare for TLM when the IRQ is normally triggered.
-    deferExecutionMicros(ExpressLRS_currAirRate_RFperfParams->TOA, Radio.TXdoneCallback);
-  }
-  else
-#endif
-  {
-    Radio.TXnb((uint8_t*)&otaPkt, ExpressLRS_currAirRate_Modparams->PayloadLength, false, (uint8_t*)&otaPkt, transmittingRadio);
-  }
-}
-
-void ICACHE_RAM_ATTR nonceAdvance()
-{
-  OtaNonce++;
-  if ((OtaNonce + 1) % ExpressLRS_currAirRate_Modparams->FHSShopInterval == 0)
-  {
-    ++FHSSptr;
-  }
-}
-
-/*
- * Called as the TOCK timer ISR when there is a CRSF connection from the handset
- */
-void ICACHE_RAM_ATTR timerCallback()
-{
-  /* If we are busy writing to EEPROM (committing config changes) then we just advance the nonces, i.e. no SPI traffic */
-  if (commitInProgress)
-  {
-    nonceAdvance();
-    return;
-  }
-
-  // Sync OpenTX to this point
-  if (!(OtaNonce % ExpressLRS_currAirRate_Modparams->numOfSends))
-  {
-    handset->JustSentRFpacket();
-  }
-
-  // Do not transmit or advance FHSS/Nonce until in disconnected/connected state
-  if (connectionState == awaitingModelId)
-    return;
-
-  // Tx Antenna Diversity
-  if ((OtaNonce % ExpressLRS_currAirRate_Modparams->numOfSends == 0 || // Swicth with new packet data
-      OtaNonce % ExpressLRS_currAirRate_Modparams->numOfSends == ExpressLRS_currAirRate_Modparams->numOfSends / 2) && // Swicth in the middle of DVDA sends
-      TelemetryRcvPhase == ttrpTransmitting) // Only switch when transmitting.  A diversity rx will send tlm back on the best antenna.  So dont switch away from it.
-  {
-    switchDiversityAntennas();
-  }
-
-  // Nonce advances on every timer tick
-  if (!InBindingMode)
-    OtaNonce++;
-
-  // If HandleTLM has started Receive mode, TLM packet reception should begin shortly
-  // Skip transmitting on this slot
-  if (TelemetryRcvPhase == ttrpPreReceiveGap)
-  {
-    TelemetryRcvPhase = ttrpExpectingTelem;
-#if defined(Regulatory_Domain_EU_CE_2400)
-    // Use downlink LQ for LBT success ratio instead for EU/CE reg domain
-    CRSF::LinkStatistics.downlink_Link_quality = LBTSuccessCalc.getLQ();
-#else
-    CRSF::LinkStatistics.downlink_Link_quality = LQCalc.getLQ();
-#endif
-    LQCalc.inc();
-    return;
-  }
-  else if (TelemetryRcvPhase == ttrpExpectingTelem && !LQCalc.currentIsSet())
-  {
-    // Indicate no telemetry packet received to the DP system
-    DynamicPower_TelemetryUpdate(DYNPOWER_UPDATE_MISSED);
-  }
-
-  TelemetryRcvPhase = ttrpTransmitting;
-
-  SendRCdataToRF();
-}
-
 static void UARTdisconnected()
 {
   hwTimer::stop();
@@ -875,6 +230,23 @@ static void ConfigChangeCommit()
   devicesTriggerEvent(changes);
 }
 
+static void BeginFlashWrite()
+{
+  // wait until no longer transmitting
+  while (busyTransmitting);
+  // Set the commitInProgress flag to prevent any other RF SPI traffic during the commit from RX or scheduled TX
+  commitInProgress = true;
+  // If telemetry expected in the next interval, the radio was in RX mode
+  // and will skip sending the next packet when the timer resumes.
+  // Return to normal send mode because if the skipped packet happened
+  // to be on the last slot of the FHSS the skip will prevent FHSS
+  if (TelemetryRcvPhase != ttrpTransmitting)
+  {
+    Radio.SetTxIdleMode();
+    TelemetryRcvPhase = ttrpTransmitting;
+  }
+}
+
 static void CheckConfigChangePending()
 {
   if (config.IsModified() || ModelUpdatePending)
@@ -883,98 +255,15 @@ static void CheckConfigChangePending()
     if (syncSpamCounter > 0)
       return;
 
-    // wait until no longer transmitting
-    while (busyTransmitting);
-    // Set the commitInProgress flag to prevent any other RF SPI traffic during the commit from RX or scheduled TX
-    commitInProgress = true;
-    // If telemetry expected in the next interval, the radio was in RX mode
-    // and will skip sending the next packet when the timer resumes.
-    // Return to normal send mode because if the skipped packet happened
-    // to be on the last slot of the FHSS the skip will prevent FHSS
-    if (TelemetryRcvPhase != ttrpTransmitting)
-    {
-      Radio.SetTxIdleMode();
-      TelemetryRcvPhase = ttrpTransmitting;
-    }
+    BeginFlashWrite();
     ConfigChangeCommit();
   }
-}
-
-bool ICACHE_RAM_ATTR RXdoneISR(SX12xxDriverCommon::rx_status const status)
-{
-  // busyTransmitting is required here to prevent accidental rxdone IRQs due to interference triggering RXdoneISR.
-  if (LQCalc.currentIsSet() || busyTransmitting)
-  {
-    return false; // Already received tlm, do not run ProcessTLMpacket() again.
-  }
-
-  bool packetSuccessful = ProcessTLMpacket(status);
-#if defined(Regulatory_Domain_EU_CE_2400)
-  if (packetSuccessful)
-  {
-    SetClearChannelAssessmentTime();
-  }
-#endif
-
-  return packetSuccessful;
-}
-
-void ICACHE_RAM_ATTR TXdoneISR()
-{
-  if (!busyTransmitting)
+  else if (connectionState == disconnected && eeprom.CompactPending())
   {
-    return; // Already finished transmission and do not call HandleFHSS() a second time, which may hop the frequency!
-  }
-
-  if (connectionState != awaitingModelId)
-  {
-    HandleFHSS();
-    HandlePrepareForTLM();
-#if defined(Regulatory_Domain_EU_CE_2400)
-    if (TelemetryRcvPhase != ttrpPreReceiveGap)
-    {
-      // Start RX for Listen Before Talk early because it takes about 100us
-      // from RX enable to valid instant RSSI values are returned.
-      // If rx was already started by TLM prepare above, this call will let RX
-      // continue as normal.
-      SetClearChannelAssessmentTime();
-    }
-#endif // non-CE
-  }
-  busyTransmitting = false;
-}
-
-static void UpdateConnectDisconnectStatus()
-{
-  // Number of telemetry packets which can be lost in a row before going to disconnected state
-  constexpr unsigned RX_LOSS_CNT = 5;
-  // Must be at least 512ms and +2 to account for any rounding down and partial millis()
-  const uint32_t msConnectionLostTimeout = std::max((uint32_t)512U,
-    (uint32_t)ExpressLRS_currTlmDenom * ExpressLRS_currAirRate_Modparams->interval / (1000U / RX_LOSS_CNT)
-    ) + 2U;
-  // Capture the last before now so it will always be <= now
-  const uint32_t lastTlmMillis = LastTLMpacketRecvMillis;
-  const uint32_t now = millis();
-  if (lastTlmMillis && ((now - lastTlmMillis) <= msConnectionLostTimeout))
-  {
-    if (connectionState != connected)
-    {
-      setConnectionState(connected);
-      CRSFHandset::ForwardDevicePings = true;
-      DBGLN("got downlink conn");
-
-      apInputBuffer.flush();
-      apOutputBuffer.flush();
-      uartInputBuffer.flush();
-    }
-  }
-  // If past RX_LOSS_CNT, or in awaitingModelId state for longer than DisconnectTimeoutMs, go to disconnected
-  else if (connectionState == connected ||
-    (connectionState == awaitingModelId && (now - rfModeLastChangedMS) > ExpressLRS_currAirRate_RFperfParams->DisconnectTimeoutMs))
-  {
-    setConnectionState(disconnected);
-    connectionHasModelMatch = true;
-    CRSFHandset::ForwardDevicePings = false;
+    // Compact the config journal while there is no link to lose, so a commit doesn't have to
+    BeginFlashWrite();
+    eeprom.Compact();
+    commitInProgress = false;
   }
 }
 
@@ -1060,6 +349,7 @@ static void EnterBindingMode()
   // Binding uses 50Hz, and InvertIQ
   OtaCrcInitializer = OTA_VERSION_ID;
   OtaNonce = 0; // Lock the OtaNonce to prevent syncspam packets
+  stagedPktReady = false;
   InBindingMode = true; // Set binding mode before SetRFLinkRate() for correct IQ
 
   // Start attempting to bind
@@ -1145,14 +435,9 @@ void ProcessMSPPacket(uint32_t now, mspPacket_t *packet)
 
 void ParseMSPData(uint8_t *buf, uint8_t size)
 {
-  for (uint8_t i = 0; i < size; ++i)
-  {
-    if (msp.processReceivedByte(buf[i]))
-    {
-      ProcessMSPPacket(millis(), msp.getReceivedPacket());
-      msp.markPacketReceived();
-    }
-  }
+  msp.processReceivedBytes(buf, size, [](mspPacket_t *packet) {
+    ProcessMSPPacket(millis(), packet);
+  });
 }
 
 static void HandleUARTout()
@@ -1163,9 +448,7 @@ static void HandleUARTout()
     if (size)
     {
       uint8_t buf[size];
-      apOutputBuffer.lock();
-      apOutputBuffer.popBytes(buf, size);
-      apOutputBuffer.unlock();
+      size = apOutputBuffer.popBytes(buf, size);
       TxUSB->write(buf, size);
     }
   }
@@ -1178,14 +461,12 @@ static void HandleUARTin()
   {
     if (firmwareOptions.is_airport)
     {
-      auto size = std::min(apInputBuffer.free(), (uint16_t)TxUSB->available());
+      auto size = std::min(apInputBuffer.free(), (uint32_t)TxUSB->available());
       if (size > 0)
       {
         uint8_t buf[size];
         TxUSB->readBytes(buf, size);
-        apInputBuffer.lock();
         apInputBuffer.pushBytes(buf, size);
-        apInputBuffer.unlock();
       }
     }
     else
@@ -1246,6 +527,45 @@ static void HandleUARTin()
   }
 }
 
+static void forwardMAVLinkTelemetry(uint8_t *frame)
+{
+  uint8_t count = frame[1];
+  // Convert to CRSF telemetry where we can
+  convert_mavlink_to_crsf_telem(frame, count, handset);
+  TxUSB->write(frame + CRSF_FRAME_NOT_COUNTED_BYTES, count);
+  // If we have a backpack
+  if (TxUSB != TxBackpack)
+  {
+    sendMAVLinkTelemetryToBackpack(frame);
+  }
+}
+
+static void sendCompressedMAVLink()
+{
+  // Peek a block of the stream, the compressor keeps any partial frame itself
+  uint8_t stream[128];
+  uartInputBuffer.lock();
+  uint16_t size = std::min(uartInputBuffer.size(), (uint16_t)sizeof(stream));
+  for (uint16_t i = 0; i < size; ++i)
+  {
+    stream[i] = uartInputBuffer[i];
+  }
+  uartInputBuffer.unlock();
+
+  uint16_t consumed = 0;
+  uint8_t count = mavlinkCompressor.compress(stream, size, &consumed, mavlinkSSBuffer + CRSF_FRAME_NOT_COUNTED_BYTES, CRSF_PAYLOAD_SIZE_MAX);
+  uartInputBuffer.lock();
+  uartInputBuffer.skip(consumed);
+  uartInputBuffer.unlock();
+
+  if (count > 0)
+  {
+    mavlinkSSBuffer[0] = MSP_ELRS_MAVLINK_TLM_COMPRESSED;
+    mavlinkSSBuffer[1] = count;
+    MspSender.SetDataToTransmit(mavlinkSSBuffer, count + CRSF_FRAME_NOT_COUNTED_BYTES);
+  }
+}
+
 static void setupSerial()
 {  /*
    * Setup the logging/backpack serial port, and the USB serial port.
@@ -1408,8 +728,7 @@ void setup()
     setupBindingFromConfig();
     FHSSrandomiseFHSSsequence(uidMacSeedGet());
 
-    Radio.RXdoneCallback = &RXdoneISR;
-    Radio.TXdoneCallback = &TXdoneISR;
+    SetupRFLink();
 
     handset->registerCallbacks(UARTconnected, firmwareOptions.is_airport ? nullptr : UARTdisconnected, ModelUpdateReq, EnterBindingModeSafely);
 
@@ -1542,17 +861,40 @@ void loop()
         if (config.GetLinkMode() == TX_MAVLINK_MODE)
         {
           // raw mavlink data - forward to USB rather than handset
-          uint8_t count = CRSFinBuffer[1];
-          // Convert to CRSF telemetry where we can
-          convert_mavlink_to_crsf_telem(CRSFinBuffer, count, handset);
-          TxUSB->write(CRSFinBuffer + CRSF_FRAME_NOT_COUNTED_BYTES, count);
-          // If we have a backpack
-          if (TxUSB != TxBackpack)
+          forwardMAVLinkTelemetry(CRSFinBuffer);
+        }
+      }
+      else if (CRSFinBuffer[0] == MSP_ELRS_MAVLINK_TLM_COMPRESSED)
+      {
+        if (config.GetLinkMode() == TX_MAVLINK_MODE)
+        {
+          // The RX can decompress, so compress the uplink from its next payload
+          if (!mavlinkCompressUplink)
+          {
+            mavlinkCompressUplink = true;
+            mavlinkCompressor.reset();
+          }
+          uint8_t stream[MAVLINK_COMPRESS_MAX_EXPANSION * CRSF_PAYLOAD_SIZE_MAX];
+          const uint16_t len = mavlinkDecompressor.decompress(CRSFinBuffer + CRSF_FRAME_NOT_COUNTED_BYTES, CRSFinBuffer[1], stream, sizeof(stream));
+          // Forward in frames of the same shape as the raw ones
+          uint8_t frame[CRSF_MAX_PACKET_LEN];
+          for (uint16_t pos = 0; pos < len;)
           {
-            sendMAVLinkTelemetryToBackpack(CRSFinBuffer);
+            uint8_t count = std::min((uint16_t)(len - pos), (uint16_t)CRSF_PAYLOAD_SIZE_MAX);
+            frame[0] = CRSF_ADDRESS_USB;
+            frame[1] = count;
+            memcpy(frame + CRSF_FRAME_NOT_COUNTED_BYTES, stream + pos, count);
+            forwardMAVLinkTelemetry(frame);
+            pos += count;
           }
         }
       }
+      else if (CRSFinBuffer[2] == CRSF_FRAMETYPE_COMMAND && CRSFinBuffer[3] == 'a' && CRSFinBuffer[4] == 'f'
+        && CRSFinBuffer[1] == CRSF_EXT_FRAME_SIZE(1 + FHSS_CHANNEL_MASK_BYTES))
+      {
+        // Non CRSF, dest=a src=f -> adaptive hopping channel mask proposed by the RX
+        OnAdaptiveHoppingProposal(&CRSFinBuffer[sizeof(crsf_ext_header_t)]);
+      }
       else
       {
         // Send all other tlm to handset
@@ -1609,7 +951,14 @@ void loop()
     uint8_t *nextPayload = 0;
     uint8_t nextPlayloadSize = 0;
     uint16_t count = uartInputBuffer.size();
-    if (count > 0 && !MspSender.IsActive())
+    if (mavlinkCompressUplink)
+    {
+      if (count > 0 && !MspSender.IsActive())
+      {
+        sendCompressedMAVLink();
+      }
+    }
+    else if (count > 0 && !MspSender.IsActive())
     {
         count = std::min(count, (uint16_t)CRSF_PAYLOAD_SIZE_MAX);
         mavlinkSSBuffer[0] = MSP_ELRS_MAVLINK_TLM; // Used on RX to differentiate between std msp opcodes and mavlink
@@ -1622,5 +971,15 @@ void loop()
         nextPlayloadSize = count + CRSF_FRAME_NOT_COUNTED_BYTES;
         MspSender.SetDataToTransmit(nextPayload, nextPlayloadSize);
     }
+    else if (connectionState == connected && !MspSender.IsActive() && (now - mavlinkHelloMillis) > MAVLINK_COMPRESS_HELLO_INTERVAL)
+    {
+        // Offer compression with an empty compressed message, an older RX ignores it.
+        // The third byte is sent so that RX doesn't read a stale CRSF frame type there
+        mavlinkHelloMillis = now;
+        mavlinkSSBuffer[0] = MSP_ELRS_MAVLINK_TLM_COMPRESSED;
+        mavlinkSSBuffer[1] = 0;
+        mavlinkSSBuffer[2] = 0;
+        MspSender.SetDataToTransmit(mavlinkSSBuffer, 3);
+    }
   }
 }
@@ -0,0 +1,71 @@
+#include <cstdint>
+#include <unity.h>
+#include "airrate.h"
+
+// OTA4_PACKET_SIZE and OTA8_PACKET_SIZE
+#define OTA4 8
+#define OTA8 13
+
+// Compile time, as the rate tables use it
+static_assert(SX127xLoRaToaUs(500000, 6, 7, 8, OTA4) == 4384, "SX127x 200Hz");
+static_assert(AirRateIntervalFits(5000, 4384), "200Hz fits");
+static_assert(!AirRateIntervalFits(4500, 4384), "no room to turn around");
+
+void test_sx127x_lora(void)
+{
+    // From the SX127x time on air calculator, these were the values in the rate table
+    TEST_ASSERT_EQUAL(4384, SX127xLoRaToaUs(500000, 6, 7, 8, OTA4));   // 200Hz
+    TEST_ASSERT_EQUAL(6688, SX127xLoRaToaUs(500000, 6, 8, 8, OTA8));   // 100Hz Full
+    TEST_ASSERT_EQUAL(8768, SX127xLoRaToaUs(500000, 7, 7, 8, OTA4));   // 100Hz
+    TEST_ASSERT_EQUAL(18560, SX127xLoRaToaUs(500000, 8, 7, 10, OTA4)); // 50Hz
+    TEST_ASSERT_EQUAL(29952, SX127xLoRaToaUs(500000, 9, 7, 10, OTA4)); // 25Hz
+}
+
+void test_sx128x_lora_long_interleave(void)
+{
+    // Rounded to the nearest us, where the table had 5871 and 7605
+    TEST_ASSERT_EQUAL(1507, LoRaToaUs(812000, 5, 6, true, 12, OTA4));  // 500Hz
+    TEST_ASSERT_EQUAL(2374, LoRaToaUs(812000, 5, 8, true, 12, OTA8));  // 333Hz Full
+    TEST_ASSERT_EQUAL(5872, LoRaToaUs(812000, 7, 8, true, 12, OTA4));  // 150Hz
+    TEST_ASSERT_EQUAL(7606, LoRaToaUs(812000, 7, 8, true, 12, OTA8));  // 100Hz Full
+    TEST_ASSERT_EQUAL(10798, LoRaToaUs(812000, 8, 8, true, 12, OTA4)); // 50Hz
+}
+
+void test_lora_short_interleave(void)
+{
+    // SF5 and SF6 have 2 more preamble symbols than SX127x, and no 8 bit header above
+    TEST_ASSERT_EQUAL(4640, LoRaToaUs(500000, 6, 7, false, 8, OTA4));
+    TEST_ASSERT_EQUAL(SX127xLoRaToaUs(500000, 7, 7, 8, OTA4), LoRaToaUs(500000, 7, 7, false, 8, OTA4));
+    TEST_ASSERT_EQUAL(SX127xLoRaToaUs(500000, 9, 7, 10, OTA4), LoRaToaUs(500000, 9, 7, false, 10, OTA4));
+}
+
+void test_flrc(void)
+{
+    // 32 bit preamble and sync word, then 11 bytes and the tail coded at 1/2
+    TEST_ASSERT_EQUAL(388, FlrcToaUs(650000, 2, 32, OTA4));
+    // Uncoded has no tail
+    TEST_ASSERT_EQUAL(117, FlrcToaUs(1300000, 4, 32, OTA4));
+}
+
+void test_gfsk(void)
+{
+    TEST_ASSERT_EQUAL(453, GfskToaUs(300000, 16, OTA8));
+    TEST_ASSERT_EQUAL(480, GfskToaUs(300000, 16, 14));
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_sx127x_lora);
+    RUN_TEST(test_sx128x_lora_long_interleave);
+    RUN_TEST(test_lora_short_interleave);
+    RUN_TEST(test_flrc);
+    RUN_TEST(test_gfsk);
+    UNITY_END();
+
+    return 0;
+}
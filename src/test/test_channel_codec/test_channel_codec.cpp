@@ -0,0 +1,275 @@
+#include <cstdint>
+#include <chrono>
+#include <unity.h>
+
+#include "targets.h"
+#include "crsf_protocol.h"
+#include "ChannelCodec.h"
+
+typedef ChannelCodec<16, 11> codec16x11;
+typedef ChannelCodec<4, 10> codec4x10;
+typedef ChannelCodec<8, 13> codec8x13;
+
+static uint32_t rng = 1;
+static uint32_t nextRand()
+{
+    rng = rng * 1103515245 + 12345;
+    return rng >> 8;
+}
+
+// The code ChannelCodec replaced, to check against and to benchmark
+
+// CRSFHandset::RcPacketToChannelsData, from Betaflight's bitpacker_unpack
+static void unpack11Legacy(uint8_t const *payload, uint32_t *channels)
+{
+    uint8_t bitsMerged = 0;
+    uint32_t readValue = 0;
+    unsigned readByteIndex = 0;
+    for (unsigned ch = 0; ch < 16; ++ch)
+    {
+        while (bitsMerged < 11)
+        {
+            uint8_t readByte = payload[readByteIndex++];
+            readValue |= ((uint32_t) readByte) << bitsMerged;
+            bitsMerged += 8;
+        }
+        channels[ch] = readValue & 0x7ff;
+        readValue >>= 11;
+        bitsMerged -= 11;
+    }
+}
+
+// SerialCRSF::sendRCFrame
+static void pack11Legacy(uint8_t *payload, uint32_t const *channels)
+{
+    crsf_channels_s *packed = (crsf_channels_s *)payload;
+    packed->ch0 = channels[0];
+    packed->ch1 = channels[1];
+    packed->ch2 = channels[2];
+    packed->ch3 = channels[3];
+    packed->ch4 = channels[4];
+    packed->ch5 = channels[5];
+    packed->ch6 = channels[6];
+    packed->ch7 = channels[7];
+    packed->ch8 = channels[8];
+    packed->ch9 = channels[9];
+    packed->ch10 = channels[10];
+    packed->ch11 = channels[11];
+    packed->ch12 = channels[12];
+    packed->ch13 = channels[13];
+    packed->ch14 = channels[14];
+    packed->ch15 = channels[15];
+}
+
+// OtaChannelField encode/decode with a single 64-bit word and runtime loops
+static void pack10Legacy(uint8_t *buf, uint32_t const *channels)
+{
+    uint64_t v = 0;
+    for (unsigned ch = 0; ch < 4; ++ch)
+        v |= (uint64_t)(channels[ch] & 0x3ff) << (ch * 10);
+    for (unsigned i = 0; i < 5; ++i)
+        buf[i] = v >> (8 * i);
+}
+
+static void unpack10Legacy(uint8_t const *buf, uint32_t *channels)
+{
+    uint64_t v = 0;
+    for (unsigned i = 0; i < 5; ++i)
+        v |= (uint64_t)buf[i] << (8 * i);
+    for (unsigned ch = 0; ch < 4; ++ch)
+        channels[ch] = (v >> (ch * 10)) & 0x3ff;
+}
+
+// Reference bit at a time packer for any width
+static void packBits(uint8_t *buf, uint32_t const *channels, unsigned count, unsigned width)
+{
+    for (unsigned bit = 0; bit < count * width; ++bit)
+    {
+        uint8_t const mask = 1 << (bit % 8);
+        if ((channels[bit / width] >> (bit % width)) & 1)
+            buf[bit / 8] |= mask;
+        else
+            buf[bit / 8] &= ~mask;
+    }
+}
+
+void test_channel_codec_crsf(void)
+{
+    for (unsigned n = 0; n < 1000; ++n)
+    {
+        uint32_t channels[16];
+        uint32_t out[16];
+        uint8_t legacy[codec16x11::BYTES];
+        uint8_t packed[codec16x11::BYTES];
+        for (unsigned ch = 0; ch < 16; ++ch)
+            channels[ch] = nextRand() & 0x7ff;
+
+        pack11Legacy(legacy, channels);
+        codec16x11::pack(packed, channels);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(legacy, packed, sizeof(packed));
+
+        codec16x11::unpack(packed, out);
+        TEST_ASSERT_EQUAL_UINT32_ARRAY(channels, out, 16);
+        unpack11Legacy(packed, out);
+        TEST_ASSERT_EQUAL_UINT32_ARRAY(channels, out, 16);
+    }
+    TEST_ASSERT_EQUAL(sizeof(crsf_channels_t), codec16x11::BYTES);
+}
+
+void test_channel_codec_ota(void)
+{
+    for (unsigned n = 0; n < 1000; ++n)
+    {
+        uint32_t channels[4];
+        uint32_t out[4];
+        uint8_t legacy[codec4x10::BYTES];
+        uint8_t packed[codec4x10::BYTES];
+        for (unsigned ch = 0; ch < 4; ++ch)
+            channels[ch] = nextRand() & 0x3ff;
+
+        pack10Legacy(legacy, channels);
+        codec4x10::pack(packed, channels);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(legacy, packed, sizeof(packed));
+
+        codec4x10::unpack(packed, out);
+        TEST_ASSERT_EQUAL_UINT32_ARRAY(channels, out, 4);
+    }
+}
+
+void test_channel_codec_13bit(void)
+{
+    for (unsigned n = 0; n < 1000; ++n)
+    {
+        uint32_t channels[8];
+        uint32_t out[8];
+        uint8_t ref[codec8x13::BYTES];
+        uint8_t packed[codec8x13::BYTES];
+        for (unsigned ch = 0; ch < 8; ++ch)
+            channels[ch] = nextRand() & 0x1fff;
+
+        packBits(ref, channels, 8, 13);
+        codec8x13::pack(packed, channels);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(ref, packed, sizeof(packed));
+
+        codec8x13::unpack(packed, out);
+        TEST_ASSERT_EQUAL_UINT32_ARRAY(channels, out, 8);
+    }
+}
+
+void test_channel_codec_partial_byte(void)
+{
+    // 3x 13-bit is 39 bits, the top bit of the last byte belongs to someone else
+    typedef ChannelCodec<3, 13> codec3x13;
+    uint32_t channels[3] = { 0x1fff, 0x0000, 0x1fff };
+    uint32_t out[3];
+    uint8_t packed[codec3x13::BYTES] = { 0, 0, 0, 0, 0x80 };
+
+    TEST_ASSERT_EQUAL(5, codec3x13::BYTES);
+    codec3x13::pack(packed, channels);
+    TEST_ASSERT_EQUAL_HEX8(0xff, packed[4]);
+    channels[2] = 0;
+    codec3x13::pack(packed, channels);
+    TEST_ASSERT_EQUAL_HEX8(0x80, packed[4]);
+
+    codec3x13::unpack(packed, out);
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(channels, out, 3);
+
+    // Values are masked to the width
+    channels[0] = 0xffffffff;
+    codec3x13::pack(packed, channels);
+    codec3x13::unpack(packed, out);
+    TEST_ASSERT_EQUAL(0x1fff, out[0]);
+    TEST_ASSERT_EQUAL(0, out[1]);
+}
+
+typedef std::chrono::steady_clock benchClock;
+
+static double nsPer(benchClock::time_point start, unsigned count)
+{
+    return std::chrono::duration<double, std::nano>(benchClock::now() - start).count() / count;
+}
+
+// The codec against the code it replaced, for every packet on both ends of the link
+void test_channel_codec_benchmark(void)
+{
+    const unsigned ROUNDS = 1000000;
+    uint32_t channels[16];
+    uint8_t packed[codec16x11::BYTES];
+    uint32_t sum = 0;
+
+    for (unsigned ch = 0; ch < 16; ++ch)
+        channels[ch] = nextRand() & 0x7ff;
+
+    benchClock::time_point start = benchClock::now();
+    for (unsigned i = 0; i < ROUNDS; ++i)
+    {
+        channels[i & 15] = i & 0x7ff;
+        pack11Legacy(packed, channels);
+        sum += packed[i % sizeof(packed)];
+    }
+    double const pack11Old = nsPer(start, ROUNDS);
+    start = benchClock::now();
+    for (unsigned i = 0; i < ROUNDS; ++i)
+    {
+        channels[i & 15] = i & 0x7ff;
+        codec16x11::pack(packed, channels);
+        sum += packed[i % sizeof(packed)];
+    }
+    double const pack11New = nsPer(start, ROUNDS);
+
+    start = benchClock::now();
+    for (unsigned i = 0; i < ROUNDS; ++i)
+    {
+        packed[i % sizeof(packed)] = i;
+        unpack11Legacy(packed, channels);
+        sum += channels[i & 15];
+    }
+    double const unpack11Old = nsPer(start, ROUNDS);
+    start = benchClock::now();
+    for (unsigned i = 0; i < ROUNDS; ++i)
+    {
+        packed[i % sizeof(packed)] = i;
+        codec16x11::unpack(packed, channels);
+        sum += channels[i & 15];
+    }
+    double const unpack11New = nsPer(start, ROUNDS);
+
+    start = benchClock::now();
+    for (unsigned i = 0; i < ROUNDS; ++i)
+    {
+        channels[i & 3] = i & 0x3ff;
+        pack10Legacy(packed, channels);
+        unpack10Legacy(packed, channels);
+        sum += channels[i & 3];
+    }
+    double const ota10Old = nsPer(start, ROUNDS);
+    start = benchClock::now();
+    for (unsigned i = 0; i < ROUNDS; ++i)
+    {
+        channels[i & 3] = i & 0x3ff;
+        codec4x10::pack(packed, channels);
+        codec4x10::unpack(packed, channels);
+        sum += channels[i & 3];
+    }
+    double const ota10New = nsPer(start, ROUNDS);
+
+    printf("ns per call (old -> codec): pack 16x11 %.1f -> %.1f, unpack 16x11 %.1f -> %.1f, pack+unpack 4x10 %.1f -> %.1f (%u)\n",
+        pack11Old, pack11New, unpack11Old, unpack11New, ota10Old, ota10New, sum & 1);
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_channel_codec_crsf);
+    RUN_TEST(test_channel_codec_ota);
+    RUN_TEST(test_channel_codec_13bit);
+    RUN_TEST(test_channel_codec_partial_byte);
+    RUN_TEST(test_channel_codec_benchmark);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,354 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <unity.h>
+
+#include "ConfigJournal.h"
+
+// The size of the EEPROM image the config is kept in
+#define IMAGE_SIZE 1024
+
+/**
+ * NOR flash: erase sets a sector to 0xFF, writes can only clear bits. The time
+ * each operation takes is estimated from the typical figures for the SPI flash
+ * on ESP8285 modules: 45ms to erase a sector, 0.7ms to program a 256 byte page.
+ */
+class MockFlash : public FlashSectors
+{
+public:
+    MockFlash(uint8_t count) : count(count), mem(count * 4096, 0xff) {}
+
+    uint32_t sectorSize() const override { return 4096; }
+    uint8_t sectorCount() const override { return count; }
+
+    void read(uint32_t addr, uint8_t *data, uint32_t len) override
+    {
+        memcpy(data, &mem[addr], len);
+    }
+
+    void write(uint32_t addr, const uint8_t *data, uint32_t len) override
+    {
+        TEST_ASSERT_EQUAL(0, addr % 4);
+        TEST_ASSERT_EQUAL(0, len % 4);
+        TEST_ASSERT_LESS_OR_EQUAL(mem.size(), addr + len);
+        if (dead)
+            return;
+        if (powerFailAfter >= 0 && written + len > (uint32_t)powerFailAfter)
+        {
+            // Only part of the write makes it
+            len = powerFailAfter - written;
+            dead = true;
+        }
+        for (uint32_t i = 0; i < len; ++i)
+        {
+            mem[addr + i] &= data[i];
+        }
+        written += len;
+        micros += 20 + len * 700 / 256;
+    }
+
+    void erase(uint8_t sector) override
+    {
+        TEST_ASSERT_LESS_THAN(count, sector);
+        if (dead)
+            return;
+        memset(&mem[sector * 4096], 0xff, 4096);
+        micros += 45000;
+    }
+
+    uint8_t count;
+    std::vector<uint8_t> mem;
+    uint32_t written = 0;
+    uint32_t micros = 0;
+    int32_t powerFailAfter = -1;
+    bool dead = false;
+};
+
+static void writeBytes(ConfigJournal &journal, uint16_t addr, const void *data, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; ++i)
+    {
+        journal.write(addr + i, ((const uint8_t *)data)[i]);
+    }
+}
+
+static void assertImage(ConfigJournal &a, ConfigJournal &b)
+{
+    for (uint16_t addr = 0; addr < IMAGE_SIZE; ++addr)
+    {
+        TEST_ASSERT_EQUAL(a.read(addr), b.read(addr));
+    }
+}
+
+void test_journal_empty(void)
+{
+    MockFlash flash(1);
+    ConfigJournal journal;
+    journal.begin(&flash, IMAGE_SIZE);
+
+    TEST_ASSERT_FALSE(journal.load());
+    TEST_ASSERT_EQUAL(0xff, journal.read(0));
+    TEST_ASSERT_FALSE(journal.isDirty());
+    // Nothing to write
+    journal.commit();
+    TEST_ASSERT_EQUAL(0, flash.written);
+}
+
+void test_journal_roundtrip(void)
+{
+    MockFlash flash(1);
+    ConfigJournal journal;
+    journal.begin(&flash, IMAGE_SIZE);
+    journal.load();
+
+    uint8_t config[300];
+    for (unsigned i = 0; i < sizeof(config); ++i)
+        config[i] = i * 7;
+    writeBytes(journal, 0, config, sizeof(config));
+    TEST_ASSERT_TRUE(journal.isDirty());
+    journal.commit();
+    TEST_ASSERT_FALSE(journal.isDirty());
+    TEST_ASSERT_EQUAL(1, journal.sectorsErased);
+
+    // Small changes are appended, not rewritten
+    journal.write(10, 0xAA);
+    journal.write(200, 0x55);
+    journal.commit();
+    journal.write(10, 0xBB);
+    journal.commit();
+    TEST_ASSERT_EQUAL(1, journal.sectorsErased);
+
+    ConfigJournal reloaded;
+    reloaded.begin(&flash, IMAGE_SIZE);
+    TEST_ASSERT_TRUE(reloaded.load());
+    assertImage(journal, reloaded);
+    TEST_ASSERT_EQUAL(0xBB, reloaded.read(10));
+    TEST_ASSERT_EQUAL(0x55, reloaded.read(200));
+    TEST_ASSERT_EQUAL(0xff, reloaded.read(300));
+}
+
+void test_journal_coalesce(void)
+{
+    MockFlash flash(1);
+    ConfigJournal journal;
+    journal.begin(&flash, IMAGE_SIZE);
+    uint8_t zeros[64] = {0};
+    writeBytes(journal, 0, zeros, sizeof(zeros));
+    journal.commit();
+    uint32_t const before = flash.written;
+
+    // A burst of nearby changes before the commit goes as one record
+    journal.write(20, 1);
+    journal.write(21, 2);
+    journal.write(23, 3);
+    journal.write(20, 4);
+    journal.commit();
+    TEST_ASSERT_EQUAL(12, flash.written - before);
+
+    // Changes far apart are separate records
+    journal.write(1, 1);
+    journal.write(60, 1);
+    journal.commit();
+    TEST_ASSERT_EQUAL(12 + 16, flash.written - before);
+
+    // Writing the same value is not a change
+    journal.write(60, 1);
+    TEST_ASSERT_FALSE(journal.isDirty());
+}
+
+void test_journal_compacts_when_full(void)
+{
+    MockFlash flash(2);
+    ConfigJournal journal;
+    journal.begin(&flash, IMAGE_SIZE);
+    uint8_t config[300] = {0};
+    writeBytes(journal, 0, config, sizeof(config));
+    journal.commit();
+
+    bool pendingSeen = false;
+    for (unsigned n = 0; n < 2000; ++n)
+    {
+        journal.write(n % 300, n & 0xff);
+        journal.commit();
+        pendingSeen |= journal.compactPending();
+    }
+    TEST_ASSERT_TRUE(pendingSeen);
+    TEST_ASSERT_GREATER_THAN(1, journal.sectorsErased);
+
+    ConfigJournal reloaded;
+    reloaded.begin(&flash, IMAGE_SIZE);
+    TEST_ASSERT_TRUE(reloaded.load());
+    assertImage(journal, reloaded);
+
+    // Compacting ahead of time clears the pending flag
+    while (!journal.compactPending())
+    {
+        journal.write(0, journal.read(0) + 1);
+        journal.commit();
+    }
+    journal.compact();
+    TEST_ASSERT_FALSE(journal.compactPending());
+}
+
+void test_journal_torn_commit(void)
+{
+    MockFlash flash(1);
+    ConfigJournal journal;
+    journal.begin(&flash, IMAGE_SIZE);
+    uint8_t config[100] = {0};
+    writeBytes(journal, 0, config, sizeof(config));
+    journal.commit();
+    journal.write(5, 5);
+    journal.commit();
+
+    // Power is lost part way through the next record
+    flash.powerFailAfter = flash.written + 5;
+    journal.write(50, 50);
+    journal.write(51, 51);
+    journal.commit();
+
+    ConfigJournal reloaded;
+    reloaded.begin(&flash, IMAGE_SIZE);
+    flash.dead = false;
+    flash.powerFailAfter = -1;
+    TEST_ASSERT_TRUE(reloaded.load());
+    TEST_ASSERT_EQUAL(5, reloaded.read(5));
+    TEST_ASSERT_EQUAL(0, reloaded.read(50));
+    TEST_ASSERT_EQUAL(0, reloaded.read(51));
+
+    // Nothing can go after the torn record, so the next commit compacts
+    uint32_t const erased = reloaded.sectorsErased;
+    reloaded.write(50, 50);
+    reloaded.commit();
+    TEST_ASSERT_EQUAL(erased + 1, reloaded.sectorsErased);
+    ConfigJournal again;
+    again.begin(&flash, IMAGE_SIZE);
+    TEST_ASSERT_TRUE(again.load());
+    TEST_ASSERT_EQUAL(50, again.read(50));
+    TEST_ASSERT_EQUAL(5, again.read(5));
+}
+
+void test_journal_torn_compaction(void)
+{
+    MockFlash flash(2);
+    ConfigJournal journal;
+    journal.begin(&flash, IMAGE_SIZE);
+    uint8_t config[100] = {0};
+    writeBytes(journal, 0, config, sizeof(config));
+    journal.commit();
+    journal.write(7, 7);
+    journal.commit();
+
+    // Power is lost before the new sector's header is written
+    flash.powerFailAfter = flash.written + 50;
+    journal.write(8, 8);
+    journal.compact();
+
+    ConfigJournal reloaded;
+    reloaded.begin(&flash, IMAGE_SIZE);
+    flash.dead = false;
+    flash.powerFailAfter = -1;
+    TEST_ASSERT_TRUE(reloaded.load());
+    TEST_ASSERT_EQUAL(7, reloaded.read(7));
+    TEST_ASSERT_EQUAL(0, reloaded.read(8));
+}
+
+void test_journal_import(void)
+{
+    MockFlash flash(1);
+    // The sector holds the config as the EEPROM library stored it
+    for (unsigned i = 0; i < 128; ++i)
+        flash.mem[i] = i;
+
+    ConfigJournal journal;
+    journal.begin(&flash, IMAGE_SIZE);
+    TEST_ASSERT_FALSE(journal.load());
+    uint8_t legacy[IMAGE_SIZE];
+    flash.read(0, legacy, sizeof(legacy));
+    journal.import(legacy, 128);
+    TEST_ASSERT_EQUAL(100, journal.read(100));
+    journal.commit();
+
+    ConfigJournal reloaded;
+    reloaded.begin(&flash, IMAGE_SIZE);
+    TEST_ASSERT_TRUE(reloaded.load());
+    assertImage(journal, reloaded);
+}
+
+/**
+ * The edits made from the LUA/web UI, each followed by a commit as CheckConfigChangePending()
+ * does, against an image laid out like tx_config_t: a 12 byte header then 64 4-byte models.
+ * The EEPROM library rewrites the whole 1KB sector image for every commit.
+ */
+void test_journal_lua_edit_cost(void)
+{
+    const unsigned EDITS = 1000;
+    MockFlash flash(1);
+    ConfigJournal journal;
+    journal.begin(&flash, IMAGE_SIZE);
+    uint8_t config[12 + 64 * 4 + 8];
+    for (unsigned i = 0; i < sizeof(config); ++i)
+        config[i] = rand();
+    writeBytes(journal, 0, config, sizeof(config));
+    journal.commit();
+
+    uint32_t const startBytes = flash.written;
+    uint32_t const startMicros = flash.micros;
+    uint32_t maxMicros = 0;
+    srand(1);
+    for (unsigned n = 0; n < EDITS; ++n)
+    {
+        switch (rand() % 4)
+        {
+        case 0: // rate, tlm or power of the current model, the low bits of its word
+        case 1:
+            journal.write(12 + (n % 8) * 4 + rand() % 2, rand());
+            break;
+        case 2: // vtx band/channel
+            journal.write(4 + rand() % 2, rand());
+            break;
+        default: // fan, motion, dvr
+            journal.write(12 + 64 * 4 + rand() % 4, rand());
+            break;
+        }
+        uint32_t const before = flash.micros;
+        journal.commit();
+        if (flash.micros - before > maxMicros)
+            maxMicros = flash.micros - before;
+        // While disconnected, the loop compacts before the next commit has to
+        if (journal.compactPending())
+            journal.compact();
+    }
+
+    double const bytesPerEdit = (double)(flash.written - startBytes) / EDITS;
+    double const microsPerEdit = (double)(flash.micros - startMicros) / EDITS;
+    uint32_t const legacyMicros = 45000 + 20 + IMAGE_SIZE * 700 / 256;
+    printf("per edit: journal %.1f bytes %.0fus (max %uus, %u erases), EEPROM %u bytes %uus\n",
+        bytesPerEdit, microsPerEdit, maxMicros, journal.sectorsErased - 1, IMAGE_SIZE, legacyMicros);
+
+    TEST_ASSERT_LESS_OR_EQUAL(12, bytesPerEdit);
+    TEST_ASSERT_LESS_OR_EQUAL(EDITS / 100, journal.sectorsErased);
+    TEST_ASSERT_LESS_THAN(legacyMicros / 20, microsPerEdit);
+    TEST_ASSERT_LESS_THAN(legacyMicros / 20, maxMicros);
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_journal_empty);
+    RUN_TEST(test_journal_roundtrip);
+    RUN_TEST(test_journal_coalesce);
+    RUN_TEST(test_journal_compacts_when_full);
+    RUN_TEST(test_journal_torn_commit);
+    RUN_TEST(test_journal_torn_compaction);
+    RUN_TEST(test_journal_import);
+    RUN_TEST(test_journal_lua_edit_cost);
+    UNITY_END();
+
+    return 0;
+}
@@ -276,6 +276,98 @@ void test_crc8(void)
     TEST_ASSERT_EQUAL_MESSAGE((int)(crc & 0xFF), c, genMsg(bytes, sizeof(bytes)));
 }
 
+template <uint8_t BITS, uint16_t POLY, uint8_t LEN>
+void test_crc_fixed_matches_generic(void)
+{
+    Crc2Byte ecrc;
+    ecrc.init(BITS, POLY);
+
+    for (int x = 0; x < NUM_ITERATIONS; x++)
+    {
+        uint8_t bytes[LEN];
+        for (int i = 0; i < LEN; i++)
+            bytes[i] = random() % 256;
+        uint16_t init = random() % (1 << BITS);
+
+        uint16_t expected = ecrc.calc(bytes, LEN, init);
+        TEST_ASSERT_EQUAL_MESSAGE(expected, (Crc2ByteFixed<BITS, POLY>::calc(bytes, LEN, init)), genMsg(bytes, LEN));
+        TEST_ASSERT_EQUAL_MESSAGE(expected, (Crc2ByteFixed<BITS, POLY>::template calc<LEN>(bytes, init)), genMsg(bytes, LEN));
+    }
+}
+
+void test_crc14_fixed(void)
+{
+    test_crc_fixed_matches_generic<14, ELRS_CRC14_POLY, OTA4_CRC_CALC_LEN>();
+}
+
+void test_crc16_fixed(void)
+{
+    test_crc_fixed_matches_generic<16, ELRS_CRC16_POLY, OTA8_CRC_CALC_LEN>();
+}
+
+void test_crc8_fixed(void)
+{
+    GENERIC_CRC8 elrs = GENERIC_CRC8(ELRS_CRC_POLY);
+    GENERIC_CRC8 dvbs2 = GENERIC_CRC8(CRC8_DVB_S2_POLY);
+
+    for (unsigned i = 0; i < 256; i++)
+    {
+        TEST_ASSERT_EQUAL(elrs.calc((uint8_t)i), Crc8Fixed<ELRS_CRC_POLY>::calc((uint8_t)i));
+        TEST_ASSERT_EQUAL(dvbs2.calc((uint8_t)i), Crc8Fixed<CRC8_DVB_S2_POLY>::calc((uint8_t)i));
+    }
+
+    uint8_t bytes[64];
+    for (unsigned i = 0; i < sizeof(bytes); i++)
+        bytes[i] = random() % 256;
+    TEST_ASSERT_EQUAL(dvbs2.calc(bytes, sizeof(bytes), 0x5a), (Crc8Fixed<CRC8_DVB_S2_POLY>::calc(bytes, sizeof(bytes), 0x5a)));
+}
+
+/**
+ * Not a pass/fail test, reports the time taken per OTA packet for the
+ * runtime table CRC vs the fixed polynomial unrolled CRC
+ */
+void test_crc_benchmark(void)
+{
+    const unsigned iterations = 2000000;
+    uint8_t bytes[OTA8_CRC_CALC_LEN];
+    for (unsigned i = 0; i < sizeof(bytes); i++)
+        bytes[i] = random() % 256;
+
+    Crc2Byte crc14, crc16;
+    crc14.init(14, ELRS_CRC14_POLY);
+    crc16.init(16, ELRS_CRC16_POLY);
+
+    // Feed each result back in as the init value so the calls can't be optimised away
+    uint16_t c = 0;
+    unsigned long start = micros();
+    for (unsigned i = 0; i < iterations; i++)
+        c = crc14.calc(bytes, OTA4_CRC_CALC_LEN, c);
+    unsigned long generic14 = micros() - start;
+
+    uint16_t f = 0;
+    start = micros();
+    for (unsigned i = 0; i < iterations; i++)
+        f = Crc2ByteFixed<14, ELRS_CRC14_POLY>::calc<OTA4_CRC_CALC_LEN>(bytes, f);
+    unsigned long fixed14 = micros() - start;
+    TEST_ASSERT_EQUAL(c, f);
+
+    c = 0;
+    start = micros();
+    for (unsigned i = 0; i < iterations; i++)
+        c = crc16.calc(bytes, OTA8_CRC_CALC_LEN, c);
+    unsigned long generic16 = micros() - start;
+
+    f = 0;
+    start = micros();
+    for (unsigned i = 0; i < iterations; i++)
+        f = Crc2ByteFixed<16, ELRS_CRC16_POLY>::calc<OTA8_CRC_CALC_LEN>(bytes, f);
+    unsigned long fixed16 = micros() - start;
+    TEST_ASSERT_EQUAL(c, f);
+
+    printf("CRC14 x%u: Crc2Byte %luus, Crc2ByteFixed %luus\n", iterations, generic14, fixed14);
+    printf("CRC16 x%u: Crc2Byte %luus, Crc2ByteFixed %luus\n", iterations, generic16, fixed16);
+}
+
 // Unity setup/teardown
 void setUp() {}
 void tearDown() {}
@@ -290,6 +382,10 @@ int main(int argc, char **argv)
     RUN_TEST(test_crc16_implementation_compatibility);
     RUN_TEST(test_crc16_flip5);
     RUN_TEST(test_crc8);
+    RUN_TEST(test_crc14_fixed);
+    RUN_TEST(test_crc16_fixed);
+    RUN_TEST(test_crc8_fixed);
+    RUN_TEST(test_crc_benchmark);
     UNITY_END();
 #endif
 #ifdef BIG_TEST
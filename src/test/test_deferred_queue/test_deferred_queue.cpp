@@ -0,0 +1,215 @@
+#include <cstdint>
+#include <vector>
+#include <unity.h>
+
+#include "DeferredQueue.h"
+
+// What the callbacks saw, in the order they were called
+static std::vector<uintptr_t> calledCtx;
+static std::vector<uint32_t> calledAt;
+static uint32_t clockNow;
+
+static void record(void *ctx)
+{
+    calledCtx.push_back((uintptr_t)ctx);
+    calledAt.push_back(clockNow);
+}
+
+// A one-shot timer: fires once at `timerAt` if armed
+static bool timerArmed;
+static uint32_t timerAt;
+static unsigned timerArms;
+
+static void armMockTimer(int32_t us)
+{
+    timerArmed = us >= 0;
+    timerAt = clockNow + us;
+    ++timerArms;
+}
+
+void setUp()
+{
+    calledCtx.clear();
+    calledAt.clear();
+    clockNow = 0;
+    timerArmed = false;
+    timerAt = 0;
+    timerArms = 0;
+}
+void tearDown() {}
+
+// Step the clock to the timer and run the queue from its "ISR", as the ESP32 backend does
+static void fireTimer(DeferredQueue &queue)
+{
+    TEST_ASSERT_TRUE(timerArmed);
+    timerArmed = false;
+    clockNow = timerAt;
+    queue.run(clockNow);
+}
+
+void test_deferred_order(void)
+{
+    DeferredQueue queue(5);
+    uint32_t const delays[] = {500, 100, 300, 200, 400};
+    for (uintptr_t i = 0; i < 5; ++i)
+    {
+        TEST_ASSERT_TRUE(queue.add(clockNow, delays[i], record, (void *)i));
+    }
+
+    // Nothing runs before its time has elapsed
+    TEST_ASSERT_EQUAL(0, queue.run(100));
+    TEST_ASSERT_EQUAL(1, queue.untilNext(100));
+    TEST_ASSERT_EQUAL(2, queue.run(300));
+    TEST_ASSERT_EQUAL(3, queue.run(1000));
+    TEST_ASSERT_EQUAL(-1, queue.untilNext(1000));
+
+    uintptr_t const expected[] = {1, 3, 2, 4, 0};
+    TEST_ASSERT_EQUAL(5, calledCtx.size());
+    for (int i = 0; i < 5; ++i)
+    {
+        TEST_ASSERT_EQUAL(expected[i], calledCtx[i]);
+    }
+}
+
+void test_deferred_full(void)
+{
+    DeferredQueue queue(2);
+    TEST_ASSERT_TRUE(queue.add(0, 10, record, (void *)1));
+    TEST_ASSERT_TRUE(queue.add(0, 20, record, (void *)2));
+    TEST_ASSERT_FALSE(queue.add(0, 5, record, (void *)3));
+
+    // A slot is free again once its callback has been run
+    TEST_ASSERT_EQUAL(1, queue.run(11));
+    TEST_ASSERT_TRUE(queue.add(11, 5, record, (void *)3));
+    TEST_ASSERT_EQUAL(2, queue.run(100));
+    TEST_ASSERT_EQUAL(3, calledCtx[1]);
+    TEST_ASSERT_EQUAL(2, calledCtx[2]);
+}
+
+// With a timer every callback is called at its deadline, not whenever run() next happens
+void test_deferred_timer_on_time(void)
+{
+    DeferredQueue queue(4);
+    queue.setTimer(armMockTimer);
+
+    clockNow = 1000;
+    queue.add(clockNow, 250, record, (void *)1);
+    TEST_ASSERT_TRUE(timerArmed);
+    TEST_ASSERT_EQUAL(1251, timerAt);
+    // A later deadline leaves the timer alone, an earlier one moves it
+    unsigned const arms = timerArms;
+    queue.add(clockNow, 700, record, (void *)2);
+    TEST_ASSERT_EQUAL(arms, timerArms);
+    clockNow = 1100;
+    queue.add(clockNow, 50, record, (void *)3);
+    TEST_ASSERT_EQUAL(1151, timerAt);
+
+    fireTimer(queue);
+    fireTimer(queue);
+    fireTimer(queue);
+    TEST_ASSERT_FALSE(timerArmed);
+
+    TEST_ASSERT_EQUAL(3, calledCtx.size());
+    TEST_ASSERT_EQUAL(3, calledCtx[0]);
+    TEST_ASSERT_EQUAL(1151, calledAt[0]);
+    TEST_ASSERT_EQUAL(1, calledCtx[1]);
+    TEST_ASSERT_EQUAL(1251, calledAt[1]);
+    TEST_ASSERT_EQUAL(2, calledCtx[2]);
+    TEST_ASSERT_EQUAL(1701, calledAt[2]);
+}
+
+static DeferredQueue *chainQueue;
+static unsigned chainCount;
+
+static void chain(void *ctx)
+{
+    record(ctx);
+    if (++chainCount < 5)
+    {
+        chainQueue->add(clockNow, 0, chain, ctx);
+    }
+}
+
+// A callback deferring itself again, like an ISR would, runs on the next pass and not in a loop
+void test_deferred_readd_from_callback(void)
+{
+    DeferredQueue queue(1);
+    queue.setTimer(armMockTimer);
+    chainQueue = &queue;
+    chainCount = 0;
+
+    queue.add(clockNow, 10, chain, (void *)7);
+    for (unsigned i = 0; i < 5; ++i)
+    {
+        fireTimer(queue);
+        TEST_ASSERT_EQUAL(i + 1, calledCtx.size());
+    }
+    TEST_ASSERT_FALSE(timerArmed);
+    TEST_ASSERT_EQUAL(11, calledAt[0]);
+    for (unsigned i = 1; i < 5; ++i)
+    {
+        TEST_ASSERT_EQUAL(calledAt[i - 1] + 1, calledAt[i]);
+    }
+}
+
+void test_deferred_wrap(void)
+{
+    DeferredQueue queue(2);
+    queue.setTimer(armMockTimer);
+
+    clockNow = 0xFFFFFF00;
+    queue.add(clockNow, 0x200, record, (void *)1);
+    queue.add(clockNow, 0x20, record, (void *)2);
+    TEST_ASSERT_EQUAL(0xFFFFFF21, timerAt);
+    fireTimer(queue);
+    TEST_ASSERT_EQUAL(0x101, timerAt);
+    fireTimer(queue);
+    TEST_ASSERT_EQUAL(2, calledCtx[0]);
+    TEST_ASSERT_EQUAL(1, calledCtx[1]);
+    TEST_ASSERT_EQUAL(0x101, calledAt[1]);
+}
+
+// Polled from a loop which only comes round every `loopUs`, the lateness is up to a loop
+void test_deferred_polled_vs_timer(void)
+{
+    const uint32_t loopUs = 1000;
+    DeferredQueue polled(1);
+    DeferredQueue timed(1);
+    timed.setTimer(armMockTimer);
+    uint32_t polledLate = 0;
+    uint32_t timedLate = 0;
+
+    for (uint32_t n = 0; n < 100; ++n)
+    {
+        uint32_t const start = n * 10000;
+        uint32_t const us = 137 + n * 13;
+        clockNow = start;
+        polled.add(start, us, record, nullptr);
+        timed.add(start, us, record, nullptr);
+
+        while (polled.run(clockNow) == 0)
+        {
+            clockNow += loopUs;
+        }
+        polledLate += clockNow - (start + us + 1);
+
+        fireTimer(timed);
+        timedLate += clockNow - (start + us + 1);
+    }
+    TEST_ASSERT_EQUAL(0, timedLate);
+    TEST_ASSERT_GREATER_THAN(0, polledLate);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_deferred_order);
+    RUN_TEST(test_deferred_full);
+    RUN_TEST(test_deferred_timer_on_time);
+    RUN_TEST(test_deferred_readd_from_callback);
+    RUN_TEST(test_deferred_wrap);
+    RUN_TEST(test_deferred_polled_vs_timer);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,399 @@
+#include <cstdint>
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include <unity.h>
+
+#include "DynamicPowerController.h"
+
+// A 2.4GHz LoRa rate with SNR thresholds, and a 900MHz one using RSSI
+static dynpower_rf_t const rfSnr = {-112, 1 * DYNPOWER_SNR_SCALE, 3 * DYNPOWER_SNR_SCALE};
+static dynpower_rf_t const rfRssi = {-103, DYNPOWER_SNR_THRESH_NONE, DYNPOWER_SNR_THRESH_NONE};
+
+#define CONFIG_POWER PWR_1000mW
+
+/***
+ * Link model: the noise floor sits 8dB above the sensitivity (SNR -8dB at sensitivity)
+ * and the LQ falls from 100% at 2dB over the sensitivity to nothing 6dB under it
+ */
+#define LINK_NOISE_OVER_SENS 8
+#define LINK_SNR_MAX 12
+
+static int linkLq(int margin)
+{
+    if (margin >= 2)
+        return 100;
+    if (margin <= -6)
+        return 0;
+    return 100 * (margin + 6) / 8;
+}
+
+/***
+ * A LinkStatistics trace as it was recorded, at TRACE_TX_DBM, one row per telemetry
+ */
+#define TRACE_TX_DBM 30
+typedef struct {
+    int8_t rssi;
+    int8_t snrScaled;
+    uint8_t lq;
+} trace_row_t;
+typedef std::vector<trace_row_t> trace_t;
+
+// What a trace says about the channel, at any power
+typedef struct {
+    int pathLoss;   // dB
+    int noiseRise;  // dB above the normal noise floor
+    int lqLoss;     // LQ lost that the margin does not explain
+} channel_t;
+
+static channel_t channelFromRow(trace_row_t const &row, dynpower_rf_t const &rf)
+{
+    channel_t ch;
+    ch.pathLoss = TRACE_TX_DBM - row.rssi;
+    // A topped out SNR says nothing of the noise floor
+    int const noise = row.rssi - row.snrScaled / DYNPOWER_SNR_SCALE;
+    ch.noiseRise = row.snrScaled < LINK_SNR_MAX * DYNPOWER_SNR_SCALE ? noise - (rf.RXsensitivity + LINK_NOISE_OVER_SENS) : 0;
+    int const margin = row.rssi - rf.RXsensitivity - ch.noiseRise;
+    ch.lqLoss = linkLq(margin) - row.lq;
+    return ch;
+}
+
+// What the link would have reported with the TX at txDbm
+static trace_row_t rowAtPower(channel_t const &ch, int txDbm, dynpower_rf_t const &rf)
+{
+    trace_row_t row;
+    int const rssi = txDbm - ch.pathLoss;
+    int const snr = rssi - (rf.RXsensitivity + LINK_NOISE_OVER_SENS) - ch.noiseRise;
+    int const lq = linkLq(rssi - rf.RXsensitivity - ch.noiseRise) - ch.lqLoss;
+    row.rssi = rssi;
+    row.snrScaled = std::min(snr, LINK_SNR_MAX) * DYNPOWER_SNR_SCALE;
+    row.lq = std::max(0, std::min(lq, 100));
+    return row;
+}
+
+/***
+ * The traces. These are synthesised rather than flown, recorded through the link model
+ * above at TRACE_TX_DBM so the replay sees them as it would a log.
+ */
+static uint32_t lcgState;
+static int fading(int depth)
+{
+    lcgState = lcgState * 1664525U + 1013904223U;
+    return (int)((lcgState >> 16) % (2 * depth + 1)) - depth;
+}
+
+static trace_t recordTrace(std::vector<channel_t> const &channel, dynpower_rf_t const &rf)
+{
+    trace_t trace;
+    for (auto const &ch : channel)
+        trace.push_back(rowAtPower(ch, TRACE_TX_DBM, rf));
+    return trace;
+}
+
+// Out to long range and back, slowly, with a few dB of fading
+static std::vector<channel_t> longRange()
+{
+    std::vector<channel_t> ch;
+    lcgState = 1;
+    for (int i = 0; i < 600; ++i)
+    {
+        int const distance = i < 300 ? i : 600 - i;
+        ch.push_back({80 + distance * 55 / 300 + fading(3), 0, 0});
+    }
+    return ch;
+}
+
+// Close in, with short deep dips as the body of the aircraft gets in the way
+static std::vector<channel_t> parkFlying()
+{
+    std::vector<channel_t> ch;
+    lcgState = 2;
+    for (int i = 0; i < 600; ++i)
+    {
+        int const blocked = (i % 40) >= 37 ? 18 : 0;
+        ch.push_back({72 + (i % 120 < 60 ? i % 60 : 60 - i % 60) / 3 + blocked + fading(2), 0, 0});
+    }
+    return ch;
+}
+
+// Diving behind a building every so often
+static std::vector<channel_t> bando()
+{
+    std::vector<channel_t> ch;
+    lcgState = 3;
+    for (int i = 0; i < 600; ++i)
+    {
+        int const behind = (i % 100) >= 90 ? 30 : 0;
+        ch.push_back({95 + behind + fading(2), 0, 0});
+    }
+    return ch;
+}
+
+// Flying behind a hill and back out, the loss rising 20dB over a few seconds
+static std::vector<channel_t> hill()
+{
+    std::vector<channel_t> ch;
+    lcgState = 5;
+    for (int i = 0; i < 600; ++i)
+    {
+        int const t = i % 100;
+        int const behind = t < 50 ? 0 : t < 60 ? (t - 50) * 2 : t < 90 ? 20 : (100 - t) * 2;
+        ch.push_back({100 + behind + fading(2), 0, 0});
+    }
+    return ch;
+}
+
+// Mid range, with our own video TX raising the noise floor and knocking out packets in bursts
+static std::vector<channel_t> videoTx()
+{
+    std::vector<channel_t> ch;
+    lcgState = 4;
+    for (int i = 0; i < 600; ++i)
+    {
+        bool const burst = (i % 60) >= 45;
+        ch.push_back({105 + fading(2), burst ? 14 : 0, burst ? 8 : 0});
+    }
+    return ch;
+}
+
+/***
+ * Replay a trace against a controller, at the power it picks
+ */
+#define LQ_DIP 70
+
+typedef struct {
+    uint32_t avgMw;
+    unsigned lqDips;      // times the LQ fell under LQ_DIP
+    unsigned lqDipRows;   // telemetry the LQ was under LQ_DIP for
+    unsigned changes;
+} replay_result_t;
+
+static uint32_t const levelMw[PWR_COUNT] = {10, 25, 50, 100, 250, 500, 1000, 2000};
+
+static replay_result_t replay(trace_t const &trace, dynpower_rf_t const &rf, DynamicPowerController &controller)
+{
+    replay_result_t res = {};
+    PowerLevels_e power = CONFIG_POWER;
+    uint64_t totalMw = 0;
+    bool inDip = false;
+    controller.reset();
+
+    for (auto const &recorded : trace)
+    {
+        trace_row_t const row = rowAtPower(channelFromRow(recorded, rf), powerToDbm(power), rf);
+        totalMw += levelMw[power];
+
+        bool const dip = row.lq < LQ_DIP;
+        res.lqDips += dip && !inDip;
+        res.lqDipRows += dip;
+        inDip = dip;
+
+        PowerLevels_e next;
+        if (row.lq == 0)
+        {
+            // No telemetry, DynamicPower_Update() raises the power by a level while armed
+            next = (PowerLevels_e)std::min(power + 1, (int)CONFIG_POWER);
+        }
+        else
+        {
+            dynpower_tlm_t const tlm = {row.rssi, row.snrScaled, row.lq};
+            next = controller.update(tlm, rf, power, PWR_10mW, CONFIG_POWER);
+        }
+        res.changes += next != power;
+        power = next;
+    }
+
+    res.avgMw = totalMw / trace.size();
+    return res;
+}
+
+static void compareReplay(char const *name, std::vector<channel_t> const &channel, dynpower_rf_t const &rf)
+{
+    trace_t const trace = recordTrace(channel, rf);
+    DynamicPowerController threshold(DYNPOWER_MODE_THRESHOLD);
+    DynamicPowerController model(DYNPOWER_MODE_MODEL);
+    replay_result_t const t = replay(trace, rf, threshold);
+    replay_result_t const m = replay(trace, rf, model);
+
+    printf("%-12s %s threshold: %4umW dips %2u (%3u) changes %3u  model: %4umW dips %2u (%3u) changes %3u\n",
+        name, rf.DynpowerSnrThreshUp == DYNPOWER_SNR_THRESH_NONE ? "rssi" : "snr ",
+        t.avgMw, t.lqDips, t.lqDipRows, t.changes, m.avgMw, m.lqDips, m.lqDipRows, m.changes);
+
+    // Never more time with the link struggling
+    TEST_ASSERT_LESS_OR_EQUAL(t.lqDipRows, m.lqDipRows);
+    if (rf.DynpowerSnrThreshUp == DYNPOWER_SNR_THRESH_NONE)
+    {
+        // The RSSI rules wait on 5 readings for each step
+        TEST_ASSERT_LESS_OR_EQUAL(t.avgMw, m.avgMw);
+    }
+    else
+    {
+        // The SNR rules step on every telemetry, hunting a level up and down around the threshold.
+        // The model gives a little power for a lot fewer changes.
+        TEST_ASSERT_LESS_OR_EQUAL(t.avgMw * 115 / 100, m.avgMw);
+        TEST_ASSERT_LESS_OR_EQUAL(t.changes, m.changes);
+    }
+}
+
+void test_dynpower_replay_long_range(void)
+{
+    compareReplay("long range", longRange(), rfSnr);
+    compareReplay("long range", longRange(), rfRssi);
+}
+
+void test_dynpower_replay_park(void)
+{
+    compareReplay("park", parkFlying(), rfSnr);
+    compareReplay("park", parkFlying(), rfRssi);
+}
+
+void test_dynpower_replay_bando(void)
+{
+    compareReplay("bando", bando(), rfSnr);
+    compareReplay("bando", bando(), rfRssi);
+}
+
+void test_dynpower_replay_hill(void)
+{
+    compareReplay("hill", hill(), rfSnr);
+    compareReplay("hill", hill(), rfRssi);
+}
+
+void test_dynpower_replay_video_tx(void)
+{
+    compareReplay("video tx", videoTx(), rfSnr);
+}
+
+/***
+ * The model controller on its own
+ */
+static PowerLevels_e updateAt(DynamicPowerController &controller, channel_t const &ch, dynpower_rf_t const &rf, PowerLevels_e power)
+{
+    trace_row_t const row = rowAtPower(ch, powerToDbm(power), rf);
+    dynpower_tlm_t const tlm = {row.rssi, row.snrScaled, row.lq};
+    return controller.update(tlm, rf, power, PWR_10mW, CONFIG_POWER);
+}
+
+void test_dynpower_model_jumps(void)
+{
+    DynamicPowerController model(DYNPOWER_MODE_MODEL);
+    // The target is DYNPOWER_RSSI_THRESH_UP over the sensitivity, 8dB over at 10mW is 7dB short
+    channel_t const ch = {10 - (rfRssi.RXsensitivity + 8), 0, 0};
+    TEST_ASSERT_EQUAL(PWR_50mW, updateAt(model, ch, rfRssi, PWR_10mW));
+
+    // The threshold controller goes a level at a time, once it has 5 readings
+    DynamicPowerController threshold(DYNPOWER_MODE_THRESHOLD);
+    PowerLevels_e power = PWR_10mW;
+    for (int i = 0; i < DYNPOWER_RSSI_CNT; ++i)
+        power = updateAt(threshold, ch, rfRssi, power);
+    TEST_ASSERT_EQUAL(PWR_25mW, power);
+}
+
+void test_dynpower_model_hysteresis(void)
+{
+    DynamicPowerController model(DYNPOWER_MODE_MODEL);
+    // 18dB over at 100mW: 50mW would leave 15dB, on the target but not over it by the hysteresis
+    channel_t const ch = {20 - (rfRssi.RXsensitivity + 18), 0, 0};
+    PowerLevels_e power = PWR_100mW;
+    for (int i = 0; i < 50; ++i)
+    {
+        power = updateAt(model, ch, rfRssi, power);
+        TEST_ASSERT_EQUAL(PWR_100mW, power);
+    }
+
+    // A fade puts it up to the configured power, 10dB over at 250mW
+    channel_t const worse = {24 - (rfRssi.RXsensitivity + 10), 0, 0};
+    TEST_ASSERT_EQUAL(CONFIG_POWER, updateAt(model, worse, rfRssi, PWR_250mW));
+
+    // 25dB over at 100mW: 25mW leaves 19dB and it can go there, but not before the hold from the last
+    // change. 10mW would leave 15dB, not enough over the target.
+    channel_t const best = {20 - (rfRssi.RXsensitivity + 25), 0, 0};
+    power = CONFIG_POWER;
+    unsigned updates = 0;
+    while (power == CONFIG_POWER && updates < 100)
+    {
+        power = updateAt(model, best, rfRssi, power);
+        ++updates;
+    }
+    TEST_ASSERT_TRUE(updates > DYNPOWER_MODEL_HOLD);
+    for (int i = 0; i < 100; ++i)
+        power = updateAt(model, best, rfRssi, power);
+    TEST_ASSERT_EQUAL(PWR_25mW, power);
+}
+
+void test_dynpower_model_follows_fade(void)
+{
+    DynamicPowerController model(DYNPOWER_MODE_MODEL);
+    channel_t ch = {115, 0, 0};
+    PowerLevels_e power = CONFIG_POWER;
+    for (int i = 0; i < 100; ++i)
+        power = updateAt(model, ch, rfSnr, power);
+    PowerLevels_e const settled = power;
+    TEST_ASSERT_TRUE(settled < CONFIG_POWER);
+
+    // A fade is taken at once, and forgotten slowly
+    ch.pathLoss += 9;
+    power = updateAt(model, ch, rfSnr, power);
+    TEST_ASSERT_TRUE(power > settled);
+    ch.pathLoss -= 9;
+    power = updateAt(model, ch, rfSnr, power);
+    TEST_ASSERT_TRUE(power > settled);
+    for (int i = 0; i < 100; ++i)
+        power = updateAt(model, ch, rfSnr, power);
+    TEST_ASSERT_EQUAL(settled, power);
+}
+
+void test_dynpower_model_lq_margin(void)
+{
+    DynamicPowerController model(DYNPOWER_MODE_MODEL);
+    // Packets lost to interference the RSSI does not show, 33dB over the sensitivity at 1000mW
+    channel_t const ch = {100, 0, 15};
+    PowerLevels_e power = CONFIG_POWER;
+    for (int i = 0; i < 20; ++i)
+        power = updateAt(model, ch, rfRssi, power);
+    TEST_ASSERT_EQUAL(DYNPOWER_MODEL_LQ_MARGIN_MAX, model.getExtraMargin());
+    // 18dB over where the power would be raised at 30dBm, 24dBm still leaves the 12dB
+    TEST_ASSERT_EQUAL(PWR_250mW, power);
+
+    // Gone, so the margin is given back
+    channel_t const clear = {100, 0, 0};
+    for (int i = 0; i < 200; ++i)
+        power = updateAt(model, clear, rfRssi, power);
+    TEST_ASSERT_EQUAL(0, model.getExtraMargin());
+    // 14dBm leaves 2dB, enough over the target to get there
+    TEST_ASSERT_EQUAL(PWR_25mW, power);
+}
+
+void test_dynpower_lq_boost(void)
+{
+    DynamicPowerController controllers[] = {DynamicPowerController(DYNPOWER_MODE_THRESHOLD), DynamicPowerController(DYNPOWER_MODE_MODEL)};
+    for (auto &controller : controllers)
+    {
+        dynpower_tlm_t const good = {-70, 10 * DYNPOWER_SNR_SCALE, 100};
+        dynpower_tlm_t const drop = {-70, 10 * DYNPOWER_SNR_SCALE, 75};
+        TEST_ASSERT_TRUE(controller.update(good, rfSnr, PWR_50mW, PWR_10mW, CONFIG_POWER) <= PWR_50mW);
+        TEST_ASSERT_EQUAL(CONFIG_POWER, controller.update(drop, rfSnr, PWR_50mW, PWR_10mW, CONFIG_POWER));
+    }
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_dynpower_model_jumps);
+    RUN_TEST(test_dynpower_model_hysteresis);
+    RUN_TEST(test_dynpower_model_follows_fade);
+    RUN_TEST(test_dynpower_model_lq_margin);
+    RUN_TEST(test_dynpower_lq_boost);
+    RUN_TEST(test_dynpower_replay_long_range);
+    RUN_TEST(test_dynpower_replay_park);
+    RUN_TEST(test_dynpower_replay_bando);
+    RUN_TEST(test_dynpower_replay_hill);
+    RUN_TEST(test_dynpower_replay_video_tx);
+    UNITY_END();
+
+    return 0;
+}
@@ -1,8 +1,10 @@
 #include <cstdint>
 #include <SX1280_Regs.h>
 #include <FHSS.h>
+#include <AfhProposal.h>
 #include <unity.h>
 #include <set>
+#include <cstring>
 
 void test_fhss_first(void)
 {
@@ -84,6 +86,238 @@ void test_fhss_reg_same(void)
     }
 }
 
+// The per-hop arithmetic the frequency table replaces
+static uint32_t calcFreq(uint8_t channel, int32_t correction)
+{
+    return FHSSconfig->freq_start + (freq_spread * channel / FREQ_SPREAD_SCALE) - correction;
+}
+
+static uint32_t calcGeminiFreq(uint8_t channel, int32_t correction)
+{
+    return calcFreq((channel + FHSSconfig->freq_count / 2) % FHSSconfig->freq_count, correction);
+}
+
+void test_fhss_freq_table(void)
+{
+    FHSSrandomiseFHSSsequence(0x01020304L);
+    FreqCorrection = 12;
+    FreqCorrection_2 = -7;
+
+    TEST_ASSERT_EQUAL(calcFreq(sync_channel, FreqCorrection), FHSSgetInitialFreq());
+    TEST_ASSERT_EQUAL(calcGeminiFreq(sync_channel, FreqCorrection_2), FHSSgetInitialGeminiFreq());
+
+    // Walk the sequence twice to check the wrap
+    for (unsigned int i = 1; i < 2 * FHSSgetSequenceCount(); i++) {
+        uint32_t freq = FHSSgetNextFreq();
+        uint8_t channel = FHSSsequence[i % FHSSgetSequenceCount()];
+        TEST_ASSERT_EQUAL(i % FHSSgetSequenceCount(), FHSSgetCurrIndex());
+        TEST_ASSERT_EQUAL(calcFreq(channel, FreqCorrection), freq);
+        TEST_ASSERT_EQUAL(calcGeminiFreq(channel, FreqCorrection_2), FHSSgetGeminiFreq());
+    }
+
+    FreqCorrection = 0;
+    FreqCorrection_2 = 0;
+}
+
+/**
+ * Not a pass/fail test, reports the time taken per hop for the
+ * frequency table vs calculating the frequency on every hop
+ */
+void test_fhss_benchmark(void)
+{
+    const unsigned iterations = 2000000;
+    FHSSrandomiseFHSSsequence(0x01020304L);
+
+    // Sum the results so the calls can't be optimised away
+    uint32_t c = 0;
+    uint8_t ptr = 0;
+    unsigned long start = micros();
+    for (unsigned i = 0; i < iterations; i++)
+    {
+        ptr = (ptr + 1) % FHSSgetSequenceCount();
+        uint8_t channel = FHSSusePrimaryFreqBand ? FHSSsequence[ptr] : FHSSsequence_DualBand[ptr];
+        c += calcFreq(channel, FreqCorrection) + calcGeminiFreq(channel, FreqCorrection_2);
+    }
+    unsigned long calculated = micros() - start;
+
+    uint32_t t = 0;
+    start = micros();
+    for (unsigned i = 0; i < iterations; i++)
+    {
+        t += FHSSgetNextFreq();
+        t += FHSSgetGeminiFreq();
+    }
+    unsigned long table = micros() - start;
+    TEST_ASSERT_EQUAL(c, t);
+
+    printf("FHSS x%u: calculated %luus, table %luus\n", iterations, calculated, table);
+}
+
+static const uint8_t noMask[FHSS_CHANNEL_MASK_BYTES] = {0};
+
+void test_fhss_channel_mask(void)
+{
+    FHSSrandomiseFHSSsequence(0x01020304L);
+
+    const uint32_t numChannels = FHSSconfig->freq_count;
+    uint8_t base[FHSS_SEQUENCE_LEN];
+    memcpy(base, FHSSsequence, sizeof(base));
+
+    // Block the two channels after the sync channel
+    uint8_t mask[FHSS_CHANNEL_MASK_BYTES] = {0};
+    const uint8_t blocked1 = (sync_channel + 1) % numChannels;
+    const uint8_t blocked2 = (sync_channel + 2) % numChannels;
+    mask[blocked1 / 8] |= 1 << (blocked1 % 8);
+    mask[blocked2 / 8] |= 1 << (blocked2 % 8);
+    TEST_ASSERT_TRUE(FHSSapplyChannelMask(mask));
+    TEST_ASSERT_EQUAL_MEMORY(mask, FHSSchannelMask, sizeof(mask));
+
+    for (unsigned int i = 0; i < FHSSgetSequenceCount(); i++) {
+        const bool wasBlocked = base[i] == blocked1 || base[i] == blocked2;
+        if (wasBlocked) {
+            TEST_ASSERT_NOT_EQUAL(blocked1, FHSShop.sequence[i]);
+            TEST_ASSERT_NOT_EQUAL(blocked2, FHSShop.sequence[i]);
+            TEST_ASSERT_NOT_EQUAL(sync_channel, FHSShop.sequence[i]);
+            TEST_ASSERT_NOT_EQUAL(FHSShop.sequence[i - 1], FHSShop.sequence[i]);
+        } else {
+            // Everything else, including the sync channel positions, is untouched
+            TEST_ASSERT_EQUAL(base[i], FHSShop.sequence[i]);
+        }
+    }
+
+    // Both ends must derive the same sequence from the same mask
+    uint8_t masked[FHSS_SEQUENCE_LEN];
+    memcpy(masked, FHSShop.sequence, sizeof(masked));
+    TEST_ASSERT_TRUE(FHSSapplyChannelMask(nullptr));
+    TEST_ASSERT_EQUAL_MEMORY(base, FHSShop.sequence, FHSSgetSequenceCount());
+    TEST_ASSERT_TRUE(FHSSapplyChannelMask(mask));
+    TEST_ASSERT_EQUAL_MEMORY(masked, FHSShop.sequence, FHSSgetSequenceCount());
+
+    // A new seed starts unmasked
+    FHSSrandomiseFHSSsequence(0x01020304L);
+    TEST_ASSERT_EQUAL_MEMORY(base, FHSShop.sequence, FHSSgetSequenceCount());
+    TEST_ASSERT_EQUAL_MEMORY(noMask, FHSSchannelMask, sizeof(noMask));
+}
+
+void test_fhss_channel_mask_rejected(void)
+{
+    FHSSrandomiseFHSSsequence(0x01020304L);
+
+    const uint32_t numChannels = FHSSconfig->freq_count;
+    uint8_t base[FHSS_SEQUENCE_LEN];
+    memcpy(base, FHSSsequence, sizeof(base));
+
+    // The sync channel can not be blocked
+    uint8_t mask[FHSS_CHANNEL_MASK_BYTES] = {0};
+    mask[sync_channel / 8] |= 1 << (sync_channel % 8);
+    TEST_ASSERT_FALSE(FHSSapplyChannelMask(mask));
+
+    // Nor can more than 1/FHSS_MAX_BLOCKED_DIVISOR of the channels
+    memset(mask, 0, sizeof(mask));
+    uint32_t blocked = 0;
+    for (uint32_t ch = 0; ch < numChannels && blocked <= numChannels / FHSS_MAX_BLOCKED_DIVISOR; ch++) {
+        if (ch != sync_channel) {
+            mask[ch / 8] |= 1 << (ch % 8);
+            blocked++;
+        }
+    }
+    TEST_ASSERT_FALSE(FHSSapplyChannelMask(mask));
+    TEST_ASSERT_EQUAL_MEMORY(base, FHSShop.sequence, FHSSgetSequenceCount());
+    TEST_ASSERT_EQUAL_MEMORY(noMask, FHSSchannelMask, sizeof(noMask));
+
+    // Removing one gets it down to the limit
+    for (uint32_t ch = 0; ch < numChannels; ch++) {
+        if (FHSSchannelIsBlocked(mask, ch)) {
+            mask[ch / 8] &= ~(1 << (ch % 8));
+            break;
+        }
+    }
+    TEST_ASSERT_TRUE(FHSSapplyChannelMask(mask));
+}
+
+// The hop keeps its sequence while the next one is built, until the swap
+void test_fhss_channel_mask_swap(void)
+{
+    FHSSrandomiseFHSSsequence(0x01020304L);
+
+    uint8_t const * const unmasked = FHSShop.sequence;
+    uint8_t base[FHSS_SEQUENCE_LEN];
+    memcpy(base, unmasked, sizeof(base));
+
+    uint8_t mask[FHSS_CHANNEL_MASK_BYTES] = {0};
+    const uint8_t blocked = (sync_channel + 1) % FHSSconfig->freq_count;
+    mask[blocked / 8] |= 1 << (blocked % 8);
+    TEST_ASSERT_TRUE(FHSSprepareChannelMask(mask));
+    TEST_ASSERT_TRUE(FHSShop.sequence == unmasked);
+    TEST_ASSERT_EQUAL_MEMORY(base, FHSShop.sequence, FHSSgetSequenceCount());
+    TEST_ASSERT_EQUAL_MEMORY(noMask, FHSSchannelMask, sizeof(noMask));
+
+    FHSSswapChannelMask();
+    TEST_ASSERT_TRUE(FHSShop.sequence != unmasked);
+    TEST_ASSERT_TRUE(FHSShop.geminiSequence == FHSShop.sequence);
+    TEST_ASSERT_EQUAL_MEMORY(mask, FHSSchannelMask, sizeof(mask));
+    for (unsigned int i = 0; i < FHSSgetSequenceCount(); i++) {
+        TEST_ASSERT_NOT_EQUAL(blocked, FHSShop.sequence[i]);
+    }
+    // The base sequence is never changed
+    TEST_ASSERT_EQUAL_MEMORY(base, FHSSsequence, FHSSgetSequenceCount());
+
+    // The next one is built in the buffer it swapped away from
+    TEST_ASSERT_TRUE(FHSSprepareChannelMask(nullptr));
+    TEST_ASSERT_EQUAL_MEMORY(mask, FHSSchannelMask, sizeof(mask));
+    FHSSswapChannelMask();
+    TEST_ASSERT_TRUE(FHSShop.sequence == unmasked);
+    TEST_ASSERT_EQUAL_MEMORY(base, FHSShop.sequence, FHSSgetSequenceCount());
+}
+
+// The proposal is swapped in once the TX echoes its generation
+void test_afh_proposal_echoed(void)
+{
+    AfhProposal proposal;
+    uint8_t mask[FHSS_CHANNEL_MASK_BYTES] = {0x06};
+
+    TEST_ASSERT_EQUAL(afhIdle, proposal.poll(0));
+    proposal.start(mask, 1, 1000);
+    TEST_ASSERT_TRUE(proposal.isPending());
+    TEST_ASSERT_EQUAL_MEMORY(mask, proposal.getMask(), sizeof(mask));
+    TEST_ASSERT_EQUAL(afhWaiting, proposal.poll(1000 + AFH_RESEND_INTERVAL - 1));
+
+    // A SYNC still on the old generation does not accept it
+    TEST_ASSERT_FALSE(proposal.echoedBy(0));
+    TEST_ASSERT_TRUE(proposal.echoedBy(1));
+    proposal.finish();
+    TEST_ASSERT_FALSE(proposal.echoedBy(1));
+    TEST_ASSERT_EQUAL(afhIdle, proposal.poll(1000 + AFH_RESEND_INTERVAL));
+}
+
+// A proposal whose frame never reaches the TX is sent again, then given up on
+void test_afh_proposal_dropped(void)
+{
+    AfhProposal proposal;
+    uint8_t mask[FHSS_CHANNEL_MASK_BYTES] = {0x06};
+
+    uint32_t now = 5000;
+    proposal.start(mask, 1, now);
+    for (unsigned send = 2; send <= AFH_MAX_SENDS; ++send)
+    {
+        TEST_ASSERT_EQUAL(afhWaiting, proposal.poll(now + AFH_RESEND_INTERVAL / 2));
+        now += AFH_RESEND_INTERVAL;
+        TEST_ASSERT_EQUAL(afhResend, proposal.poll(now));
+        TEST_ASSERT_TRUE(proposal.isPending());
+    }
+
+    now += AFH_RESEND_INTERVAL;
+    TEST_ASSERT_EQUAL(afhGaveUp, proposal.poll(now));
+    TEST_ASSERT_FALSE(proposal.isPending());
+    TEST_ASSERT_FALSE(proposal.echoedBy(1));
+    TEST_ASSERT_EQUAL(afhIdle, proposal.poll(now));
+
+    // A resend that gets through is accepted like the first
+    proposal.start(mask, 0, now);
+    TEST_ASSERT_EQUAL(afhResend, proposal.poll(now + AFH_RESEND_INTERVAL));
+    TEST_ASSERT_TRUE(proposal.echoedBy(0));
+}
+
 // Unity setup/teardown
 void setUp() {}
 void tearDown() {}
@@ -96,6 +330,13 @@ int main(int argc, char **argv)
     RUN_TEST(test_fhss_unique);
     RUN_TEST(test_fhss_same);
     RUN_TEST(test_fhss_reg_same);
+    RUN_TEST(test_fhss_channel_mask);
+    RUN_TEST(test_fhss_channel_mask_rejected);
+    RUN_TEST(test_fhss_channel_mask_swap);
+    RUN_TEST(test_afh_proposal_echoed);
+    RUN_TEST(test_afh_proposal_dropped);
+    RUN_TEST(test_fhss_freq_table);
+    RUN_TEST(test_fhss_benchmark);
     UNITY_END();
 
     return 0;
@@ -1,5 +1,6 @@
 #include <cstdint>
 #include <FIFO.h>
+#include <SPSCFIFO.h>
 #include <unity.h>
 #include <set>
 
@@ -58,6 +59,85 @@ void test_fifo_ensure()
         TEST_ASSERT_EQUAL(10, f.pop()); // and that all the bytes in the head packet are what we expect
 }
 
+void test_spscfifo_bytes_wrap()
+{
+    SPSCFIFO<64> s;
+    uint8_t in[48];
+    uint8_t out[64];
+    for (unsigned i = 0; i < sizeof(in); i++)
+        in[i] = i;
+
+    // Move the indexes so the next push wraps around the end of the buffer
+    TEST_ASSERT_TRUE(s.pushBytes(in, 40));
+    TEST_ASSERT_EQUAL(40, s.popBytes(out, 40));
+
+    TEST_ASSERT_TRUE(s.pushBytes(in, sizeof(in)));
+    TEST_ASSERT_EQUAL(48, s.size());
+    TEST_ASSERT_EQUAL(16, s.free());
+    // Data that doesn't fit is rejected without touching the contents
+    TEST_ASSERT_FALSE(s.pushBytes(in, 17));
+    TEST_ASSERT_EQUAL(48, s.size());
+
+    // Popping more than is queued returns what there is
+    TEST_ASSERT_EQUAL(48, s.popBytes(out, sizeof(out)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(in, out, sizeof(in));
+    TEST_ASSERT_EQUAL(0, s.size());
+    TEST_ASSERT_EQUAL(0, s.popBytes(out, sizeof(out)));
+}
+
+void test_spscfifo_packets_drop_oldest()
+{
+    SPSCFIFO<64> s;
+    uint8_t pkt[20];
+    uint8_t out[32];
+
+    // Three 21 byte packets fill 63 of the 64 bytes
+    for (int p = 0; p < 3; p++)
+    {
+        memset(pkt, p, sizeof(pkt));
+        TEST_ASSERT_TRUE(s.pushPacket(pkt, sizeof(pkt)));
+    }
+    TEST_ASSERT_EQUAL(63, s.size());
+
+    // The fourth drops the first, not the whole FIFO
+    memset(pkt, 3, sizeof(pkt));
+    TEST_ASSERT_TRUE(s.pushPacket(pkt, sizeof(pkt)));
+    TEST_ASSERT_EQUAL(63, s.size());
+
+    for (int p = 1; p < 4; p++)
+    {
+        TEST_ASSERT_EQUAL(20, s.peekPacketSize());
+        TEST_ASSERT_EQUAL(20, s.popPacket(out, sizeof(out)));
+        for (int i = 0; i < 20; i++)
+            TEST_ASSERT_EQUAL(p, out[i]);
+    }
+    TEST_ASSERT_EQUAL(0, s.peekPacketSize());
+    TEST_ASSERT_EQUAL(0, s.popPacket(out, sizeof(out)));
+
+    // A packet larger than the FIFO is refused
+    uint8_t big[64] = {0};
+    TEST_ASSERT_FALSE(s.pushPacket(big, sizeof(big)));
+}
+
+void test_spscfifo_packet_too_big_to_pop()
+{
+    SPSCFIFO<64> s;
+    uint8_t pkt[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    uint8_t out[10];
+
+    s.pushPacket(pkt, sizeof(pkt));
+    // Left in the FIFO if the caller can't take it yet
+    TEST_ASSERT_EQUAL(0, s.popPacket(out, 9));
+    TEST_ASSERT_EQUAL(11, s.size());
+    TEST_ASSERT_EQUAL(10, s.popPacket(out, sizeof(out)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(pkt, out, sizeof(pkt));
+
+    s.pushPacket(pkt, sizeof(pkt));
+    s.flush();
+    TEST_ASSERT_EQUAL(0, s.size());
+    TEST_ASSERT_EQUAL(0, s.popPacket(out, sizeof(out)));
+}
+
 // Unity setup/teardown
 void setUp() {}
 void tearDown() {}
@@ -68,6 +148,9 @@ int main(int argc, char **argv)
     RUN_TEST(test_fifo_pop_wrap);
     RUN_TEST(test_fifo_popBytes_wrap);
     RUN_TEST(test_fifo_ensure);
+    RUN_TEST(test_spscfifo_bytes_wrap);
+    RUN_TEST(test_spscfifo_packets_drop_oldest);
+    RUN_TEST(test_spscfifo_packet_too_big_to_pop);
     UNITY_END();
 
     return 0;
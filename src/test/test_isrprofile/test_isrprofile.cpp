@@ -0,0 +1,81 @@
+#include <cstdint>
+#include <unity.h>
+
+#include "targets.h"
+#include "ISRProfile.h"
+
+void test_isrprofile_bucket(void)
+{
+    TEST_ASSERT_EQUAL(0, ISRProfile::bucket(0));
+    TEST_ASSERT_EQUAL(0, ISRProfile::bucket((1 << ISRPROF_BUCKET_SHIFT) - 1));
+    TEST_ASSERT_EQUAL(1, ISRProfile::bucket(1 << ISRPROF_BUCKET_SHIFT));
+    TEST_ASSERT_EQUAL(2, ISRProfile::bucket(2 << ISRPROF_BUCKET_SHIFT));
+    TEST_ASSERT_EQUAL(2, ISRProfile::bucket((4 << ISRPROF_BUCKET_SHIFT) - 1));
+    TEST_ASSERT_EQUAL(ISRPROF_BUCKETS - 1, ISRProfile::bucket(UINT32_MAX));
+}
+
+void test_isrprofile_record(void)
+{
+    isrProfileStats_t stats[ISRPROF_COUNT];
+    ISRProfile::reset();
+
+    // The start times are in the past so the durations are at least this long
+    uint32_t const now = ISRProfile::now();
+    ISRProfile::timerEvent(now - 50000);
+    ISRProfile::record(ISRPROF_RXDONE, now - 10000);
+    ISRProfile::record(ISRPROF_RXDONE, now - 1000);
+    ISRProfile::record(ISRPROF_RXDONE, now - 5000);
+
+    ISRProfile::snapshot(stats);
+    TEST_ASSERT_EQUAL(3, stats[ISRPROF_RXDONE].count);
+    TEST_ASSERT_UINT32_WITHIN(500, 1000, stats[ISRPROF_RXDONE].minCycles);
+    TEST_ASSERT_UINT32_WITHIN(500, 10000, stats[ISRPROF_RXDONE].maxCycles);
+    TEST_ASSERT_UINT32_WITHIN(500, 50000, stats[ISRPROF_RXDONE].maxSinceTimerCycles);
+    uint32_t total = 0;
+    for (unsigned b = 0; b < ISRPROF_BUCKETS; ++b)
+        total += stats[ISRPROF_RXDONE].histogram[b];
+    TEST_ASSERT_EQUAL(3, total);
+
+    // Other ISRs are untouched
+    TEST_ASSERT_EQUAL(0, stats[ISRPROF_TXDONE].count);
+    TEST_ASSERT_EQUAL(0, stats[ISRPROF_TXDONE].maxCycles);
+
+    ISRProfile::reset();
+    ISRProfile::snapshot(stats);
+    TEST_ASSERT_EQUAL(0, stats[ISRPROF_RXDONE].count);
+    TEST_ASSERT_EQUAL(0, stats[ISRPROF_RXDONE].maxCycles);
+}
+
+void test_isrprofile_scope(void)
+{
+    isrProfileStats_t stats[ISRPROF_COUNT];
+    ISRProfile::reset();
+
+    {
+        ISRProfileScope scope(ISRPROF_TIMER_TOCK, true);
+    }
+    {
+        ISRProfileScope scope(ISRPROF_TXDONE, false);
+    }
+
+    ISRProfile::snapshot(stats);
+    TEST_ASSERT_EQUAL(1, stats[ISRPROF_TIMER_TOCK].count);
+    TEST_ASSERT_EQUAL(1, stats[ISRPROF_TXDONE].count);
+    TEST_ASSERT_EQUAL(0, stats[ISRPROF_RXDONE].count);
+    TEST_ASSERT_LESS_OR_EQUAL(stats[ISRPROF_TXDONE].maxSinceTimerCycles, stats[ISRPROF_TXDONE].maxCycles);
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_isrprofile_bucket);
+    RUN_TEST(test_isrprofile_record);
+    RUN_TEST(test_isrprofile_scope);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,1250 @@
+/**
+ * This file is part of ExpressLRS
+ * See https://github.com/AlessandroAU/ExpressLRS
+ *
+ * Host-side link simulator, see link_sim.h
+ */
+
+#include "link_sim.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+#include "targets.h"
+#include "common.h"
+#include "rxtx_intf.h"
+#include "deferred.h"
+#include "CRSF.h"
+#include "CRSFHandset.h"
+#include "handset.h"
+#include "FHSS.h"
+#include "OTA.h"
+#include "LQSTATS.h"
+#include "SX1280Driver.h"
+#include "SX1280_hal.h"
+#include "RFAMP_hal.h"
+#include "hwTimer.h"
+#include "telemetry.h"
+#include "rx_link.h"
+#include "tx_link.h"
+
+#define LOOP_INTERVAL_US 500        // How often the main loop() of each side is run
+#define LOOP_FREE_MICROS_CALLS 32   // micros() calls per loop() before each one costs a microsecond
+#define RX_POWERUP_MAX_US 50000     // The RX powers up at a random time up to this long after the TX
+#define FC_BATTERY_INTERVAL_MS 100  // How often the RX's flight controller sends a battery frame
+#define RX_TIMEOUT_PERIOD_US 15.625 // SX1280 RX timeout step, RX_TIMEOUT_PERIOD_BASE_NANOS
+#define RADIO_IRQ_LATENCY_US 20     // From the end of a packet to the DIO interrupt running
+#define RADIO_ISR_US 10             // How long the DIO interrupt runs, a timer resumed from it fires after
+
+/***
+ * Firmware globals normally defined by common.cpp/rx_main.cpp/tx_main.cpp
+ ***/
+uint8_t UID[UID_LEN] = {1, 2, 3, 4, 5, 6};
+bool connectionHasModelMatch;
+bool teamraceHasModelMatch = true;
+bool InBindingMode;
+uint8_t ExpressLRS_currTlmDenom = 1;
+expresslrs_mod_settings_s const *ExpressLRS_currAirRate_Modparams;
+expresslrs_rf_pref_params_s const *ExpressLRS_currAirRate_RFperfParams;
+uint32_t ChannelData[CRSF_NUM_CHANNELS];
+connectionState_e connectionState;
+
+SX1280Driver Radio;
+LQSTATS LQStats;
+Telemetry telemetry;
+SPSCFIFO<AP_MAX_BUF_LEN> apInputBuffer;
+SPSCFIFO<AP_MAX_BUF_LEN> apOutputBuffer;
+Handset *handset;
+
+uint8_t CRSFHandset::modelId = 0;
+bool CRSFHandset::ForwardDevicePings = false;
+
+uint32_t uidMacSeedGet()
+{
+    const uint32_t macSeed = ((uint32_t)UID[2] << 24) + ((uint32_t)UID[3] << 16) +
+                             ((uint32_t)UID[4] << 8) + (UID[5]^OTA_VERSION_ID);
+    return macSeed;
+}
+
+bool isDualRadio()
+{
+    return false;
+}
+
+void DynamicPower_TelemetryUpdate(int8_t snrScaled) {}
+
+void loopWakeFromISR() {}
+
+// Channel values cycled through by the handset, the 10-bit OTA encodings lose the low bit
+#define RC_VALUE_TOLERANCE 2
+static const uint32_t RcTestValues[] = {
+    CRSF_CHANNEL_VALUE_MIN, CRSF_CHANNEL_VALUE_1000, CRSF_CHANNEL_VALUE_MID, CRSF_CHANNEL_VALUE_2000, CRSF_CHANNEL_VALUE_MAX
+};
+#define RC_TEST_VALUE_COUNT (sizeof(RcTestValues) / sizeof(RcTestValues[0]))
+
+enum sim_event_e {
+    EV_TIMER,       // hwTimer interrupt
+    EV_TX_END,      // end of a packet on air
+    EV_RADIO_IRQ,   // DIO interrupt of a radio
+    EV_LOOP,        // main loop() iteration
+    EV_HANDSET,     // new RC data from the handset
+    EV_DEFERRED,    // deferISRExecutionMicros() callback
+    EV_RX_POWERUP,
+};
+
+typedef struct {
+    double at;      // true time in us
+    uint32_t seq;   // insertion order, keeps simultaneous events deterministic
+    uint8_t type;
+    uint8_t node;
+    uint32_t gen;   // timer/TX generation, stale events are discarded
+    void (*fn)();
+} sim_event_t;
+
+struct SimEventLater
+{
+    bool operator()(sim_event_t const &a, sim_event_t const &b) const
+    {
+        return (a.at > b.at) || (a.at == b.at && a.seq > b.seq);
+    }
+};
+
+enum sim_radio_mode_e { srmStandby, srmFs, srmRx, srmTx };
+
+// What one SX1280 is doing on air, driven by the commands the driver writes
+typedef struct {
+    sim_radio_mode_e mode;
+    uint8_t packetType;
+    uint8_t modParams[3];
+    uint8_t packetParams[7];
+    uint32_t freq;
+    double rxSince;     // listening with the current settings since
+    double rxUntil;     // RX timeout, INFINITY in continuous RX
+    uint32_t txGen;     // bumped when a packet is started or aborted
+    double txStart;
+    uint16_t irq;
+    uint8_t fifo[256];
+    int8_t pktRssi;
+    int8_t pktSnr;      // dB
+    bool pktCorrupted;
+} sim_radio_t;
+
+// One side of the link, with its copy of the firmware globals while the other side runs
+struct SimNode
+{
+    bool isTx;
+    int32_t ppm;
+    bool poweredUp;
+
+    uint8_t otaNonce;
+    bool otaIsFullRes;
+    OtaSwitchMode_e otaSwitchMode;
+    ValidatePacketCrc_t otaValidatePacketCrc;
+    GeneratePacketCrc_t otaGeneratePacketCrc;
+    int8_t otaRepairSnrMin;
+    uint8_t fhssPtr;
+    bool modelMatch;
+    uint8_t tlmDenom;
+    connectionState_e connState;
+    expresslrs_mod_settings_s const *modParams;
+    expresslrs_rf_pref_params_s const *rfPerf;
+    uint32_t channelData[CRSF_NUM_CHANNELS];
+    elrsLinkStatistics_t linkStatistics;
+    LQSTATS lqStats;
+    SX1280Driver radio;
+    bool timerRunning;
+    bool timerIsTick;
+    int32_t timerFreqOffset;
+
+    // hwTimer, in ticks of the node's timer
+    uint32_t ticksPerUs;
+    uint32_t timerInterval;
+    int32_t timerPhaseShift;
+    void (*timerTick)();
+    void (*timerTock)();
+    uint32_t timerGen;
+    double timerDue;            // true time of the next interrupt, INFINITY when stopped
+
+    bool (*rxDoneCallback)(SX12xxDriverCommon::rx_status);
+    sim_radio_t air;
+};
+
+class SimHandset : public Handset
+{
+public:
+    void Begin() {}
+    void End() {}
+    void handleInput() {}
+    bool IsArmed() { return false; }
+    void JustSentRFpacket();
+    void reset() { RCdataLastRecv = 0; }
+    void setRCdataReceived(uint32_t us) { RCdataLastRecv = us; }
+};
+
+class LinkSim
+{
+public:
+    LinkSim(uint8_t rateIndex, link_sim_channel_t const *channel, link_sim_result_t *result);
+    void run(uint32_t durationUs);
+
+    // Firmware hooks
+    unsigned long micros();
+    void radioWrite(uint8_t opcode, uint8_t const *buf, uint8_t size);
+    void radioRead(uint8_t opcode, uint8_t *buf, uint8_t size);
+    void radioWriteBuffer(uint8_t offset, uint8_t const *buf, uint8_t size);
+    void radioReadBuffer(uint8_t offset, uint8_t *buf, uint8_t size);
+    void timerInit(void (*tick)(), void (*tock)());
+    void timerStop();
+    void timerResume();
+    void timerUpdateInterval(uint32_t time);
+    void timerPhaseShift(int32_t newPhaseShift);
+    void deferISR(unsigned long us, void (*fn)());
+    void onConnectionState(connectionState_e newState);
+    bool onRXdone(SX12xxDriverCommon::rx_status status);
+    void onJustSentRFpacket();
+    void onRCFrameAvailable();
+    void onRCFrameMissed();
+
+    uint8_t rateIndex;
+    link_sim_channel_t const *channel;
+
+private:
+    // Simulation infrastructure
+    void schedule(double at, uint8_t type, uint8_t node, uint32_t gen = 0, void (*fn)() = nullptr);
+    uint32_t random();
+    float randomFloat();
+    void enter(SimNode *node);
+    uint8_t nodeIndex(SimNode const *node) const { return node == &tx ? 0 : 1; }
+    SimNode *nodeAt(uint8_t idx) { return idx == 0 ? &tx : &rx; }
+    uint32_t localMicros(SimNode const *node) const;
+    double fromLocalUs(SimNode const *node, double us) const { return us * 1e6 / (1e6 + node->ppm); }
+
+    // Radio air model
+    void radioSetMode(sim_radio_mode_e mode);
+    void radioRx(uint16_t timeout);
+    void radioTx();
+    void radioTxEnd(SimNode *sender, uint32_t gen);
+    bool channelDelivers(SimNode const *sender, float *fadeDb);
+    bool isListening(SimNode const *receiver, SimNode const *sender) const;
+    void raiseIrq(SimNode *node);
+
+    // hwTimer model
+    void timerSchedule(SimNode *node, double localUs);
+    void timerFire(SimNode *node);
+
+    // The link parts of the main loops
+    void txSetup();
+    void txLoop();
+    void rxPowerUp();
+    void rxLoop();
+    void handsetSendRCdata();
+
+    link_sim_result_t *result;
+    SimNode tx;
+    SimNode rx;
+    SimNode *cur;
+    SimHandset simHandset;
+
+    std::priority_queue<sim_event_t, std::vector<sim_event_t>, SimEventLater> events;
+    double now;
+    uint32_t seq;
+    uint32_t rngState;
+    bool burstBad;
+    uint32_t loopMicrosCalls;
+    bool inLoop;
+    uint32_t missedRun;
+
+    uint32_t rcFrameIdx;
+    uint32_t fcLastBatteryMs;
+    uint16_t fcBatteryCount;
+    uint8_t mspSeq;
+    uint8_t mspOut[ELRS_MSP_BUFFER];
+    uint8_t mspIn[ELRS_MSP_BUFFER];
+    uint8_t tlmIn[CRSF_MAX_PACKET_LEN + 1];
+    uint8_t tlmOut[CRSF_MAX_PACKET_LEN];
+};
+
+static LinkSim *sim;
+
+/***
+ * SX1280 HAL, the driver's SPI traffic goes to the air model of the current node
+ ***/
+SX1280Hal *SX1280Hal::instance = NULL;
+
+SX1280Hal::SX1280Hal() : batching(false), dispatching(false), batchDoneCallback(nullptr)
+{
+    instance = this;
+}
+
+void SX1280Hal::init() {}
+void SX1280Hal::end() {}
+void SX1280Hal::reset() {}
+
+void SX1280Hal::WriteCommand(SX1280_RadioCommands_t command, uint8_t val, SX12XX_Radio_Number_t radioNumber, uint32_t busyDelay)
+{
+    sim->radioWrite(command, &val, 1);
+}
+
+void SX1280Hal::WriteCommand(SX1280_RadioCommands_t opcode, uint8_t *buffer, uint8_t size, SX12XX_Radio_Number_t radioNumber, uint32_t busyDelay)
+{
+    sim->radioWrite(opcode, buffer, size);
+}
+
+void SX1280Hal::WriteRegister(uint16_t address, uint8_t *buffer, uint8_t size, SX12XX_Radio_Number_t radioNumber) {}
+void SX1280Hal::WriteRegister(uint16_t address, uint8_t value, SX12XX_Radio_Number_t radioNumber) {}
+
+void SX1280Hal::ReadCommand(SX1280_RadioCommands_t opcode, uint8_t *buffer, uint8_t size, SX12XX_Radio_Number_t radioNumber)
+{
+    sim->radioRead(opcode, buffer, size);
+}
+
+void SX1280Hal::ReadRegister(uint16_t address, uint8_t *buffer, uint8_t size, SX12XX_Radio_Number_t radioNumber)
+{
+    for (uint8_t i = 0; i < size; ++i)
+        buffer[i] = ReadRegister(address + i, radioNumber);
+}
+
+uint8_t SX1280Hal::ReadRegister(uint16_t address, SX12XX_Radio_Number_t radioNumber)
+{
+    // Begin() wants a firmware version which is neither 0 nor 0xFFFF
+    if (address == REG_LR_FIRMWARE_VERSION_MSB || address == REG_LR_FIRMWARE_VERSION_MSB + 1)
+        return 0xA9;
+    return 0;
+}
+
+void SX1280Hal::WriteBuffer(uint8_t offset, uint8_t *buffer, uint8_t size, SX12XX_Radio_Number_t radioNumber)
+{
+    sim->radioWriteBuffer(offset, buffer, size);
+}
+
+void SX1280Hal::ReadBuffer(uint8_t offset, uint8_t *buffer, uint8_t size, SX12XX_Radio_Number_t radioNumber)
+{
+    sim->radioReadBuffer(offset, buffer, size);
+}
+
+bool SX1280Hal::WaitOnBusy(SX12XX_Radio_Number_t radioNumber)
+{
+    return true;
+}
+
+void SX1280Hal::EndBatch()
+{
+    batching = false;
+    dispatching = false;
+}
+
+void SX1280Hal::EndBatchAsync(void (*onDone)())
+{
+    EndBatch();
+    if (onDone)
+        onDone();
+}
+
+RFAMP_hal *RFAMP_hal::instance = NULL;
+
+RFAMP_hal::RFAMP_hal()
+{
+    instance = this;
+}
+
+void RFAMP_hal::init() {}
+void RFAMP_hal::TXenable(SX12XX_Radio_Number_t radioNumber) {}
+void RFAMP_hal::RXenable() {}
+void RFAMP_hal::TXRXdisable() {}
+
+/***
+ * hwTimer, on the simulated clock of the current node
+ ***/
+volatile bool hwTimer::running = false;
+volatile bool hwTimer::isTick = false;
+volatile int32_t hwTimer::FreqOffset = 0;
+
+void hwTimer::init(void (*callbackTick)(), void (*callbackTock)())
+{
+    sim->timerInit(callbackTick, callbackTock);
+}
+
+void hwTimer::stop()
+{
+    sim->timerStop();
+}
+
+void hwTimer::resume()
+{
+    sim->timerResume();
+}
+
+void hwTimer::updateInterval(uint32_t time)
+{
+    sim->timerUpdateInterval(time);
+}
+
+void hwTimer::phaseShift(int32_t newPhaseShift)
+{
+    sim->timerPhaseShift(newPhaseShift);
+}
+
+void deferISRExecutionMicros(unsigned long us, void (*fn)())
+{
+    sim->deferISR(us, fn);
+}
+
+void setConnectionState(connectionState_e newState)
+{
+    sim->onConnectionState(newState);
+}
+
+void SimHandset::JustSentRFpacket()
+{
+    sim->onJustSentRFpacket();
+}
+
+static bool SimRXdoneISR(SX12xxDriverCommon::rx_status status)
+{
+    return sim->onRXdone(status);
+}
+
+static unsigned long SimMicros()
+{
+    return sim->micros();
+}
+
+/***
+ * TX interface, the TX config
+ ***/
+uint8_t getTxRate() { return sim->rateIndex; }
+expresslrs_tlm_ratio_e getTxTlm() { return sim->channel->tlmRatio; }
+uint8_t getTxSwitchMode() { return smWideOr8ch; }
+uint8_t getTxLinkMode() { return TX_NORMAL_MODE; }
+bool getTxModelMatch() { return false; }
+uint8_t getTxAntennaMode() { return TX_RADIO_MODE_ANT_1; }
+void setTxAntennaMode(uint8_t mode) {}
+void switchDiversityAntennas() {}
+void OnDownlinkConnected() {}
+
+/***
+ * RX interface, the RX config and the serial/servo outputs
+ ***/
+bool getRxForceTlmOff() { return false; }
+eSerialProtocol getRxSerialProtocol() { return PROTOCOL_CRSF; }
+uint8_t getRxModelId() { return 0xff; }
+bool getRxLockOnFirstConnection() { return false; }
+void checkGeminiMode() {}
+void updateDiversity() {}
+void OnELRSBindMSP(uint8_t *newUid4) {}
+void OnRxSyncSettings(uint8_t otaProtocol, uint8_t geminiMode) {}
+void OnRxTentativeConnection() {}
+void OnRxGotConnection() {}
+void sendImmediateRC() {}
+void servoNewChannelsAvailable() {}
+
+void crsfRCFrameAvailable()
+{
+    sim->onRCFrameAvailable();
+}
+
+void crsfRCFrameMissed()
+{
+    sim->onRCFrameMissed();
+}
+
+void LinkSimChannelDefaults(link_sim_channel_t *channel)
+{
+    memset(channel, 0, sizeof(*channel));
+    channel->seed = 0x12345678;
+    channel->linkMarginDb = 20.0f;
+    channel->snrDb = 20;
+    channel->rssiDbm = -60;
+    channel->tlmRatio = TLM_RATIO_STD;
+}
+
+static void SimNodeInit(SimNode *node, bool isTx, int32_t ppm)
+{
+    node->isTx = isTx;
+    node->ppm = ppm;
+    node->poweredUp = false;
+    node->otaNonce = 0;
+    node->otaIsFullRes = false;
+    node->otaSwitchMode = smWideOr8ch;
+    node->otaValidatePacketCrc = nullptr;
+    node->otaGeneratePacketCrc = nullptr;
+    node->otaRepairSnrMin = DYNPOWER_SNR_THRESH_NONE;
+    node->fhssPtr = 0;
+    node->modelMatch = false;
+    node->tlmDenom = 1;
+    node->connState = disconnected;
+    node->modParams = nullptr;
+    node->rfPerf = nullptr;
+    memset(node->channelData, 0, sizeof(node->channelData));
+    memset(&node->linkStatistics, 0, sizeof(node->linkStatistics));
+    node->lqStats.reset();
+    node->timerRunning = false;
+    node->timerIsTick = false;
+    node->timerFreqOffset = 0;
+    // The TX timer counts in microseconds, the RX one in HWTIMER_TICKS_PER_US
+    node->ticksPerUs = isTx ? 1 : HWTIMER_TICKS_PER_US;
+    node->timerInterval = TimerIntervalUSDefault * node->ticksPerUs;
+    node->timerPhaseShift = 0;
+    node->timerTick = nullptr;
+    node->timerTock = nullptr;
+    node->timerGen = 0;
+    node->timerDue = INFINITY;
+    node->rxDoneCallback = nullptr;
+    memset(&node->air, 0, sizeof(node->air));
+    node->air.mode = srmStandby;
+    node->air.rxUntil = INFINITY;
+}
+
+LinkSim::LinkSim(uint8_t rateIndex, link_sim_channel_t const *channel, link_sim_result_t *result)
+    : rateIndex(rateIndex), channel(channel), result(result), cur(&tx),
+      now(0), seq(0), rngState(channel->seed ? channel->seed : 1), burstBad(false),
+      loopMicrosCalls(0), inLoop(false), missedRun(0),
+      rcFrameIdx(0), fcLastBatteryMs(0), fcBatteryCount(0), mspSeq(0)
+{
+    memset(result, 0, sizeof(*result));
+    SimNodeInit(&tx, true, channel->txPpm);
+    SimNodeInit(&rx, false, channel->rxPpm);
+
+    // Globals which are the same on both sides, and the TX's copy of the rest
+    connectionHasModelMatch = false;
+    InBindingMode = false;
+    ExpressLRS_currTlmDenom = 1;
+    ExpressLRS_currAirRate_Modparams = nullptr;
+    ExpressLRS_currAirRate_RFperfParams = nullptr;
+    memset(ChannelData, 0, sizeof(ChannelData));
+    connectionState = disconnected;
+    memset(&CRSF::LinkStatistics, 0, sizeof(CRSF::LinkStatistics));
+    LQStats.reset();
+    Radio = tx.radio;
+    SX1280Driver::instance = &Radio;
+    hwTimer::running = false;
+    hwTimer::isTick = false;
+    hwTimer::resetFreqOffset();
+    OtaNonce = 0;
+    OtaIsFullRes = false;
+    OtaSwitchModeCurrent = smWideOr8ch;
+    OtaValidatePacketCrc = nullptr;
+    OtaGeneratePacketCrc = nullptr;
+    OtaRepairSnrMin = DYNPOWER_SNR_THRESH_NONE;
+    OtaSetFullResNextChannelSet(false);
+    OtaSetHybrid8NextSwitchIndex(0);
+    OtaUpdateCrcInitFromUid();
+    FHSSrandomiseFHSSsequence(uidMacSeedGet());
+    FHSSptr = 0;
+    telemetry.ResetState();
+    apInputBuffer.flush();
+    apOutputBuffer.flush();
+    simHandset.reset();
+    handset = &simHandset;
+}
+
+uint32_t LinkSim::random()
+{
+    // xorshift32, private so the channel does not disturb the FHSS rng
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+float LinkSim::randomFloat()
+{
+    return (random() >> 8) / (float)(1 << 24);
+}
+
+void LinkSim::schedule(double at, uint8_t type, uint8_t node, uint32_t gen, void (*fn)())
+{
+    sim_event_t ev = { at, seq++, type, node, gen, fn };
+    events.push(ev);
+}
+
+uint32_t LinkSim::localMicros(SimNode const *node) const
+{
+    return (uint32_t)(uint64_t)(now * (1e6 + node->ppm) / 1e6);
+}
+
+/**
+ * Make node the one whose firmware runs, swapping the globals both sides share
+ */
+void LinkSim::enter(SimNode *node)
+{
+    if (node == cur)
+        return;
+
+    cur->otaNonce = OtaNonce;
+    cur->otaIsFullRes = OtaIsFullRes;
+    cur->otaSwitchMode = OtaSwitchModeCurrent;
+    cur->otaValidatePacketCrc = OtaValidatePacketCrc;
+    cur->otaGeneratePacketCrc = OtaGeneratePacketCrc;
+    cur->otaRepairSnrMin = OtaRepairSnrMin;
+    cur->fhssPtr = FHSSptr;
+    cur->modelMatch = connectionHasModelMatch;
+    cur->tlmDenom = ExpressLRS_currTlmDenom;
+    cur->connState = connectionState;
+    cur->modParams = ExpressLRS_currAirRate_Modparams;
+    cur->rfPerf = ExpressLRS_currAirRate_RFperfParams;
+    memcpy(cur->channelData, ChannelData, sizeof(ChannelData));
+    cur->linkStatistics = CRSF::LinkStatistics;
+    cur->lqStats = LQStats;
+    cur->radio = Radio;
+    cur->timerRunning = hwTimer::running;
+    cur->timerIsTick = hwTimer::isTick;
+    cur->timerFreqOffset = hwTimer::getFreqOffset();
+
+    const bool syndromesFullRes = OtaIsFullRes;
+    cur = node;
+
+    OtaNonce = cur->otaNonce;
+    OtaIsFullRes = cur->otaIsFullRes;
+    OtaSwitchModeCurrent = cur->otaSwitchMode;
+    OtaValidatePacketCrc = cur->otaValidatePacketCrc;
+    OtaGeneratePacketCrc = cur->otaGeneratePacketCrc;
+    OtaRepairSnrMin = cur->otaRepairSnrMin;
+    FHSSptr = cur->fhssPtr;
+    connectionHasModelMatch = cur->modelMatch;
+    ExpressLRS_currTlmDenom = cur->tlmDenom;
+    connectionState = cur->connState;
+    ExpressLRS_currAirRate_Modparams = cur->modParams;
+    ExpressLRS_currAirRate_RFperfParams = cur->rfPerf;
+    memcpy(ChannelData, cur->channelData, sizeof(ChannelData));
+    CRSF::LinkStatistics = cur->linkStatistics;
+    LQStats = cur->lqStats;
+    Radio = cur->radio;
+    SX1280Driver::instance = &Radio;
+    hwTimer::running = cur->timerRunning;
+    hwTimer::isTick = cur->timerIsTick;
+    hwTimer::setFreqOffset(cur->timerFreqOffset);
+
+    // The CRC repair syndromes are built for the packet size, one table for both sides
+    if (OtaIsFullRes != syndromesFullRes && OtaValidatePacketCrc != nullptr)
+    {
+        OtaUpdateSerializers(OtaSwitchModeCurrent, OtaIsFullRes ? OTA8_PACKET_SIZE : OTA4_PACKET_SIZE);
+        OtaValidatePacketCrc = cur->otaValidatePacketCrc;
+        OtaGeneratePacketCrc = cur->otaGeneratePacketCrc;
+        OtaRepairSnrMin = cur->otaRepairSnrMin;
+    }
+}
+
+/**
+ * The local clock of the current node. The main loop is not free: past the first
+ * few calls each micros() costs a microsecond, so loops which spin on it make
+ * progress, and the node's own timer interrupts them. Anything else due during the
+ * spin is handled once the loop returns.
+ */
+unsigned long LinkSim::micros()
+{
+    if (inLoop && ++loopMicrosCalls > LOOP_FREE_MICROS_CALLS)
+    {
+        now += 1.0;
+        if (now >= cur->timerDue)
+        {
+            inLoop = false;
+            cur->timerGen++;
+            timerFire(cur);
+            inLoop = true;
+        }
+    }
+    return localMicros(cur);
+}
+
+/***
+ * Radio air model
+ ***/
+void LinkSim::radioSetMode(sim_radio_mode_e mode)
+{
+    sim_radio_t &air = cur->air;
+    // Anything which takes the radio out of TX aborts the packet on air
+    if (air.mode == srmTx && mode != srmTx)
+    {
+        air.txGen++;
+    }
+    air.mode = mode;
+}
+
+void LinkSim::radioRx(uint16_t timeout)
+{
+    sim_radio_t &air = cur->air;
+    radioSetMode(srmRx);
+    // SetRx restarts the receiver even when it is already listening
+    air.rxSince = now;
+    air.rxUntil = (timeout == 0xFFFF) ? INFINITY : now + timeout * RX_TIMEOUT_PERIOD_US;
+}
+
+void LinkSim::radioTx()
+{
+    sim_radio_t &air = cur->air;
+    radioSetMode(srmTx);
+    air.txGen++;
+    air.txStart = now;
+    if (cur->isTx && cur->modParams)
+    {
+        OTA_Packet_s const * const otaPktPtr = (OTA_Packet_s *)air.fifo;
+        if (otaPktPtr->std.type == PACKET_TYPE_RCDATA)
+            result->rcSent++;
+    }
+    schedule(now + fromLocalUs(cur, ExpressLRS_currAirRate_RFperfParams->TOA), EV_TX_END, nodeIndex(cur), air.txGen);
+}
+
+void LinkSim::radioWrite(uint8_t opcode, uint8_t const *buf, uint8_t size)
+{
+    sim_radio_t &air = cur->air;
+    switch (opcode)
+    {
+    case SX1280_RADIO_SET_SLEEP:
+    case SX1280_RADIO_SET_STANDBY:
+        radioSetMode(srmStandby);
+        break;
+    case SX1280_RADIO_SET_FS:
+        radioSetMode(srmFs);
+        break;
+    case SX1280_RADIO_SET_RX:
+        radioRx((buf[1] << 8) | buf[2]);
+        break;
+    case SX1280_RADIO_SET_TX:
+        radioTx();
+        break;
+    case SX1280_RADIO_SET_PACKETTYPE:
+        air.packetType = buf[0];
+        air.rxSince = now;
+        break;
+    case SX1280_RADIO_SET_MODULATIONPARAMS:
+        memcpy(air.modParams, buf, std::min(size, (uint8_t)sizeof(air.modParams)));
+        air.rxSince = now;
+        break;
+    case SX1280_RADIO_SET_PACKETPARAMS:
+        memcpy(air.packetParams, buf, std::min(size, (uint8_t)sizeof(air.packetParams)));
+        air.rxSince = now;
+        break;
+    case SX1280_RADIO_SET_RFFREQUENCY:
+        {
+            uint32_t freq = ((uint32_t)buf[0] << 16) | ((uint32_t)buf[1] << 8) | buf[2];
+            if (freq != air.freq)
+            {
+                air.freq = freq;
+                air.rxSince = now;
+                if (air.mode == srmTx)
+                    air.txGen++;
+            }
+        }
+        break;
+    case SX1280_RADIO_CLR_IRQSTATUS:
+        air.irq &= ~((buf[0] << 8) | buf[1]);
+        break;
+    default:
+        break;
+    }
+}
+
+void LinkSim::radioRead(uint8_t opcode, uint8_t *buf, uint8_t size)
+{
+    sim_radio_t const &air = cur->air;
+    memset(buf, 0, size);
+    switch (opcode)
+    {
+    case SX1280_RADIO_GET_IRQSTATUS:
+        buf[0] = air.irq >> 8;
+        buf[1] = air.irq & 0xFF;
+        break;
+    case SX1280_RADIO_GET_PACKETSTATUS:
+        if (air.packetType == SX1280_PACKET_TYPE_FLRC)
+        {
+            buf[1] = -air.pktRssi * 2;
+        }
+        else
+        {
+            buf[0] = -air.pktRssi * 2;
+            buf[1] = (uint8_t)(int8_t)(air.pktSnr * RADIO_SNR_SCALE);
+        }
+        break;
+    case SX1280_RADIO_GET_RSSIINST:
+        buf[0] = -channel->rssiDbm * 2;
+        break;
+    default:
+        // GET_RXBUFFERSTATUS: packets are always at offset 0
+        break;
+    }
+}
+
+void LinkSim::radioWriteBuffer(uint8_t offset, uint8_t const *buf, uint8_t size)
+{
+    memcpy(&cur->air.fifo[offset], buf, std::min<size_t>(size, sizeof(cur->air.fifo) - offset));
+}
+
+void LinkSim::radioReadBuffer(uint8_t offset, uint8_t *buf, uint8_t size)
+{
+    memcpy(buf, &cur->air.fifo[offset], std::min<size_t>(size, sizeof(cur->air.fifo) - offset));
+}
+
+static uint32_t hashFreq(uint32_t freq, uint32_t seed)
+{
+    uint32_t h = freq ^ seed;
+    h ^= h >> 16;
+    h *= 0x7feb352d;
+    h ^= h >> 15;
+    h *= 0x846ca68b;
+    h ^= h >> 16;
+    return h;
+}
+
+static uint8_t payloadLength(sim_radio_t const &air)
+{
+    return air.packetType == SX1280_PACKET_TYPE_FLRC ? air.packetParams[4] : air.packetParams[2];
+}
+
+/**
+ * The receiver must have been listening with the same settings for the whole packet
+ */
+bool LinkSim::isListening(SimNode const *receiver, SimNode const *sender) const
+{
+    sim_radio_t const &r = receiver->air;
+    sim_radio_t const &s = sender->air;
+    return receiver->poweredUp && r.mode == srmRx
+        && r.packetType == s.packetType && r.freq == s.freq
+        && memcmp(r.modParams, s.modParams, sizeof(r.modParams)) == 0
+        && memcmp(r.packetParams, s.packetParams, sizeof(r.packetParams)) == 0
+        && r.rxSince <= s.txStart && s.txStart <= r.rxUntil;
+}
+
+bool LinkSim::channelDelivers(SimNode const *sender, float *fadeDb)
+{
+    if (channel->outageLengthUs && now >= channel->outageStartUs && now < (double)channel->outageStartUs + channel->outageLengthUs)
+        return false;
+
+    // Gilbert-Elliott two state burst model, one transition per packet
+    if (burstBad)
+        burstBad = randomFloat() >= channel->burstExit;
+    else
+        burstBad = randomFloat() < channel->burstEnter;
+    if (burstBad && randomFloat() < channel->burstLoss)
+        return false;
+
+    if (randomFloat() < channel->lossRandom)
+        return false;
+
+    // Frequency selective fading, fixed per channel for the duration of the run
+    *fadeDb = channel->fadeMaxDb * (hashFreq(sender->air.freq, channel->seed) >> 8) / (float)(1 << 24);
+    if (*fadeDb > channel->linkMarginDb)
+        return false;
+
+    return true;
+}
+
+void LinkSim::raiseIrq(SimNode *node)
+{
+    enter(node);
+    SX1280Hal::instance->IsrCallback_1();
+}
+
+void LinkSim::radioTxEnd(SimNode *sender, uint32_t gen)
+{
+    if (sender->air.mode != srmTx || sender->air.txGen != gen)
+    {
+        return;
+    }
+
+    SimNode *receiver = (sender == &tx) ? &rx : &tx;
+    float fadeDb = 0.0f;
+    // Always draw from the channel, so the loss pattern does not depend on the receiver
+    bool delivered = channelDelivers(sender, &fadeDb) && isListening(receiver, sender);
+
+    // AUTOFS, both sides go to FS after a packet
+    sender->air.mode = srmFs;
+    sender->air.irq |= SX1280_IRQ_TX_DONE;
+
+    if (delivered)
+    {
+        sim_radio_t &air = receiver->air;
+        const uint8_t len = payloadLength(sender->air);
+        memcpy(air.fifo, sender->air.fifo, len);
+        air.pktCorrupted = false;
+        air.pktRssi = channel->rssiDbm - (int8_t)fadeDb;
+        air.pktSnr = channel->snrDb - (int8_t)fadeDb;
+        air.irq |= SX1280_IRQ_RX_DONE;
+        if (air.packetType == SX1280_PACKET_TYPE_FLRC)
+            air.irq |= SX1280_IRQ_SYNCWORD_VALID;
+        if (randomFloat() < channel->corruptProb)
+        {
+            // FLRC has a hardware CRC, LoRa packets are passed on with the bit error
+            uint32_t bit = random() % (len * 8);
+            air.fifo[bit / 8] ^= 1 << (bit % 8);
+            air.pktCorrupted = true;
+            if (air.packetType == SX1280_PACKET_TYPE_FLRC)
+                air.irq |= SX1280_IRQ_CRC_ERROR;
+        }
+        if (air.rxUntil != INFINITY)
+            air.mode = srmFs;
+        schedule(now + RADIO_IRQ_LATENCY_US, EV_RADIO_IRQ, nodeIndex(receiver));
+    }
+
+    schedule(now + RADIO_IRQ_LATENCY_US, EV_RADIO_IRQ, nodeIndex(sender));
+}
+
+bool LinkSim::onRXdone(SX12xxDriverCommon::rx_status status)
+{
+    const bool corrupted = cur->air.pktCorrupted;
+    cur->air.pktCorrupted = false;
+    const bool accepted = cur->rxDoneCallback(status);
+    if (corrupted)
+    {
+        if (accepted)
+            result->crcRepaired++;
+        else
+            result->crcRejected++;
+    }
+    return accepted;
+}
+
+/***
+ * hwTimer model, mirrors ESP32_hwTimer.cpp: the TX only uses the tock, the RX
+ * alternates tick and tock at half the interval each
+ ***/
+void LinkSim::timerInit(void (*tick)(), void (*tock)())
+{
+    cur->timerTick = tick;
+    cur->timerTock = tock;
+    cur->timerGen++;
+    cur->timerDue = INFINITY;
+    hwTimer::running = false;
+}
+
+void LinkSim::timerStop()
+{
+    cur->timerGen++;
+    cur->timerDue = INFINITY;
+    hwTimer::running = false;
+}
+
+void LinkSim::timerResume()
+{
+    if (hwTimer::running)
+        return;
+    hwTimer::running = true;
+    cur->timerGen++;
+    if (cur->isTx)
+    {
+        timerSchedule(cur, (double)cur->timerInterval / cur->ticksPerUs);
+    }
+    else
+    {
+        // Fires a tock as soon as the calling ISR has completed
+        hwTimer::isTick = false;
+        timerSchedule(cur, RADIO_ISR_US);
+    }
+}
+
+void LinkSim::timerUpdateInterval(uint32_t time)
+{
+    cur->timerInterval = time * cur->ticksPerUs;
+}
+
+void LinkSim::timerPhaseShift(int32_t newPhaseShift)
+{
+    const int32_t minVal = -(cur->timerInterval >> 2);
+    const int32_t maxVal = (cur->timerInterval >> 2);
+    cur->timerPhaseShift = constrain(newPhaseShift, minVal, maxVal) * (int32_t)cur->ticksPerUs;
+}
+
+void LinkSim::timerSchedule(SimNode *node, double localUs)
+{
+    node->timerDue = now + fromLocalUs(node, localUs);
+    schedule(node->timerDue, EV_TIMER, nodeIndex(node), node->timerGen);
+}
+
+void LinkSim::timerFire(SimNode *node)
+{
+    enter(node);
+    if (node->isTx)
+    {
+        timerSchedule(node, (double)(node->timerInterval + hwTimer::getFreqOffset()) / node->ticksPerUs);
+        node->timerTock();
+        if (connectionState == connected)
+        {
+            result->downlinkLqSum += CRSF::LinkStatistics.downlink_Link_quality;
+            result->downlinkLqCount++;
+        }
+        return;
+    }
+
+    int32_t nextInterval = (node->timerInterval >> 1) + hwTimer::getFreqOffset();
+    const bool tick = hwTimer::isTick;
+    if (!tick)
+    {
+        nextInterval += node->timerPhaseShift;
+        node->timerPhaseShift = 0;
+    }
+    timerSchedule(node, (double)nextInterval / node->ticksPerUs);
+    if (tick)
+    {
+        node->timerTick();
+        if (RXtimerState == tim_locked)
+        {
+            result->uplinkLqSum += uplinkLQ;
+            result->uplinkLqCount++;
+        }
+    }
+    else
+    {
+        node->timerTock();
+    }
+    hwTimer::isTick = !tick;
+}
+
+void LinkSim::deferISR(unsigned long us, void (*fn)())
+{
+    schedule(now + fromLocalUs(cur, us), EV_DEFERRED, nodeIndex(cur), 0, fn);
+}
+
+void LinkSim::onConnectionState(connectionState_e newState)
+{
+    const connectionState_e oldState = connectionState;
+    connectionState = newState;
+    if (cur->isTx)
+    {
+        if (newState == connected && result->tlmConnectUs == 0)
+            result->tlmConnectUs = now;
+        return;
+    }
+
+    if (newState == connected && oldState != connected && result->connectUs == 0)
+        result->connectUs = now;
+    if (oldState == connected && newState != connected)
+        result->disconnects++;
+}
+
+void LinkSim::onRCFrameAvailable()
+{
+    result->rcReceived++;
+    missedRun = 0;
+
+    // The channels cycle through the test values, each offset by its index
+    for (unsigned idx = 0; idx < RC_TEST_VALUE_COUNT; ++idx)
+    {
+        bool match = true;
+        for (unsigned ch = 0; ch < 4; ++ch)
+        {
+            int32_t diff = (int32_t)ChannelData[ch] - (int32_t)RcTestValues[(idx + ch) % RC_TEST_VALUE_COUNT];
+            if (abs(diff) > RC_VALUE_TOLERANCE)
+            {
+                match = false;
+                break;
+            }
+        }
+        if (match)
+            return;
+    }
+    result->rcMismatch++;
+}
+
+void LinkSim::onRCFrameMissed()
+{
+    if (connectionState != connected)
+        return;
+    missedRun++;
+    result->maxMissedRun = std::max(result->maxMissedRun, missedRun);
+}
+
+/***
+ * Handset: a new set of channels half a packet after each RC packet, as the
+ * CRSF handset does once synced
+ ***/
+void LinkSim::onJustSentRFpacket()
+{
+    const uint32_t frameUs = ExpressLRS_currAirRate_Modparams->interval * ExpressLRS_currAirRate_Modparams->numOfSends;
+    schedule(now + fromLocalUs(&tx, frameUs / 2), EV_HANDSET, nodeIndex(&tx));
+}
+
+void LinkSim::handsetSendRCdata()
+{
+    enter(&tx);
+    for (unsigned ch = 0; ch < CRSF_NUM_CHANNELS; ++ch)
+        ChannelData[ch] = CRSF_CHANNEL_VALUE_MID;
+    for (unsigned ch = 0; ch < 4; ++ch)
+        ChannelData[ch] = RcTestValues[(rcFrameIdx + ch) % RC_TEST_VALUE_COUNT];
+    // Disarmed
+    ChannelData[4] = CRSF_CHANNEL_VALUE_MIN;
+    rcFrameIdx++;
+    simHandset.setRCdataReceived(localMicros(&tx));
+}
+
+/***
+ * TX side, the link parts of tx_main.cpp
+ ***/
+void LinkSim::txSetup()
+{
+    enter(&tx);
+    tx.poweredUp = true;
+    Radio.currFreq = FHSSgetInitialFreq();
+    Radio.Begin(FHSSgetMinimumFreq(), FHSSgetMaximumFreq());
+    SetupRFLink();
+    tx.rxDoneCallback = Radio.RXdoneCallback;
+    Radio.RXdoneCallback = &SimRXdoneISR;
+    TelemetryReceiver.SetDataToReceive(tlmIn, sizeof(tlmIn));
+    SetRFLinkRate(rateIndex);
+    hwTimer::init(nullptr, timerCallback);
+    rfModeLastChangedMS = millis();
+    hwTimer::resume();
+    schedule(now + LOOP_INTERVAL_US, EV_LOOP, nodeIndex(&tx));
+}
+
+void LinkSim::txLoop()
+{
+    UpdateConnectDisconnectStatus();
+
+    if (TelemetryReceiver.HasFinishedData())
+    {
+        // The only telemetry is the FC's battery frames
+        const uint8_t len = tlmIn[1];
+        if (len >= 2 && len <= CRSF_MAX_PACKET_LEN - 2
+            && crsf_crc.calc(&tlmIn[2], len - 1, 0) == tlmIn[len + 1]
+            && tlmIn[2] == CRSF_FRAMETYPE_BATTERY_SENSOR)
+            result->tlmReceived++;
+        else
+            result->tlmMismatch++;
+        TelemetryReceiver.Unlock();
+    }
+
+    // MSP messages are [length][sequence][payload derived from the sequence]
+    if (channel->mspLen && !MspSender.IsActive())
+    {
+        const uint8_t len = std::min(std::max(channel->mspLen, (uint8_t)2), (uint8_t)ELRS_MSP_BUFFER);
+        mspOut[0] = len;
+        mspOut[1] = mspSeq;
+        for (uint8_t i = 2; i < len; ++i)
+            mspOut[i] = mspSeq * 7 + i;
+        mspSeq++;
+        MspSender.SetDataToTransmit(mspOut, len);
+    }
+}
+
+/***
+ * RX side, the link parts of rx_main.cpp
+ ***/
+void LinkSim::rxPowerUp()
+{
+    enter(&rx);
+    rx.poweredUp = true;
+    Radio.currFreq = FHSSgetInitialFreq();
+    Radio.Begin(FHSSgetMinimumFreq(), FHSSgetMaximumFreq());
+    SetupRFLink(rateIndex);
+    rx.rxDoneCallback = Radio.RXdoneCallback;
+    Radio.RXdoneCallback = &SimRXdoneISR;
+    MspReceiver.SetDataToReceive(mspIn, ELRS_MSP_BUFFER);
+    Radio.RXnb();
+    hwTimer::init(HWtimerCallbackTick, HWtimerCallbackTock);
+    RFmodeLastCycled = millis();
+    fcLastBatteryMs = millis();
+    schedule(now + LOOP_INTERVAL_US, EV_LOOP, nodeIndex(&rx));
+}
+
+void LinkSim::rxLoop()
+{
+    const uint32_t nowMs = millis();
+
+    if (MspReceiver.HasFinishedData())
+    {
+        const uint8_t len = mspIn[0];
+        bool match = len >= 2 && len <= ELRS_MSP_BUFFER;
+        for (uint8_t i = 2; match && i < len; ++i)
+            match = mspIn[i] == (uint8_t)(mspIn[1] * 7 + i);
+        if (match)
+            result->mspReceived++;
+        else
+            result->mspMismatch++;
+        MspReceiver.Unlock();
+    }
+
+    UpdateConnectionState(nowMs);
+
+    uint8_t nextPayloadSize;
+    if (!TelemetrySender.IsActive() && telemetry.GetNextPayload(&nextPayloadSize, tlmOut))
+        TelemetrySender.SetDataToTransmit(tlmOut, nextPayloadSize);
+
+    updateTelemetryBurst();
+    updateSwitchMode();
+
+    if (result->lockUs == 0 && RXtimerState == tim_locked)
+        result->lockUs = now;
+
+    // The flight controller
+    if (nowMs - fcLastBatteryMs >= FC_BATTERY_INTERVAL_MS)
+    {
+        fcLastBatteryMs = nowMs;
+        CRSF_MK_FRAME_T(crsf_sensor_battery_t) battery = {0};
+        battery.p.voltage = ((fcBatteryCount >> 8) & 0xFF) | ((fcBatteryCount & 0xFF) << 8); // big endian
+        fcBatteryCount++;
+        CRSF::SetHeaderAndCrc((uint8_t *)&battery, CRSF_FRAMETYPE_BATTERY_SENSOR, CRSF_FRAME_SIZE(sizeof(crsf_sensor_battery_t)), CRSF_ADDRESS_CRSF_TRANSMITTER);
+        telemetry.AppendTelemetryPackage((uint8_t *)&battery);
+    }
+}
+
+void LinkSim::run(uint32_t durationUs)
+{
+    sim = this;
+    nativeMicrosSource() = &SimMicros;
+
+    txSetup();
+    schedule(random() % RX_POWERUP_MAX_US, EV_RX_POWERUP, nodeIndex(&rx));
+
+    while (!events.empty() && events.top().at <= durationUs)
+    {
+        sim_event_t ev = events.top();
+        events.pop();
+        now = std::max(now, ev.at);
+        SimNode *node = nodeAt(ev.node);
+
+        switch (ev.type)
+        {
+        case EV_TIMER:
+            if (ev.gen == node->timerGen)
+                timerFire(node);
+            break;
+        case EV_TX_END:
+            radioTxEnd(node, ev.gen);
+            break;
+        case EV_RADIO_IRQ:
+            raiseIrq(node);
+            break;
+        case EV_LOOP:
+            enter(node);
+            loopMicrosCalls = 0;
+            inLoop = true;
+            if (node->isTx)
+                txLoop();
+            else
+                rxLoop();
+            inLoop = false;
+            schedule(now + LOOP_INTERVAL_US, EV_LOOP, ev.node);
+            break;
+        case EV_HANDSET:
+            handsetSendRCdata();
+            break;
+        case EV_DEFERRED:
+            enter(node);
+            ev.fn();
+            break;
+        case EV_RX_POWERUP:
+            rxPowerUp();
+            break;
+        }
+    }
+
+    enter(&rx);
+    result->rxFreqOffset = hwTimer::getFreqOffset();
+    result->finalConnected = connectionState == connected;
+    enter(&tx);
+    result->tlmFinalConnected = connectionState == connected;
+
+    nativeMicrosSource() = nullptr;
+    sim = nullptr;
+}
+
+void LinkSimRun(uint8_t rateIndex, uint32_t durationUs, link_sim_channel_t const *channel, link_sim_result_t *result)
+{
+    LinkSim *linkSim = new LinkSim(rateIndex, channel, result);
+    linkSim->run(durationUs);
+    delete linkSim;
+}
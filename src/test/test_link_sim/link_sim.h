@@ -0,0 +1,103 @@
+/**
+ * This file is part of ExpressLRS
+ * See https://github.com/AlessandroAU/ExpressLRS
+ *
+ * Host-side link simulator
+ *
+ * Runs the real TX and RX link code from lib/RFLink against a simulated
+ * SX1280 HAL, hwTimer and clock, with the real air rate tables, so connect
+ * time, sync-to-lock latency, LQ and the telemetry/MSP transfers can be
+ * measured for each air rate without hardware.
+ *
+ * The main loops are cut down to what rx_main.cpp/tx_main.cpp do for the
+ * link: the connection state, the telemetry and MSP senders/receivers, the
+ * switch mode and the telemetry burst. The handset is a stub producing a new
+ * set of channels for every RC frame, and a flight controller which sends a
+ * battery sensor frame every 100ms. Adaptive hopping is not simulated, the
+ * FHSS channel masks are shared by both nodes.
+ *
+ * Both nodes share the firmware globals (OtaNonce, FHSSptr, Radio,
+ * connectionState...), so each node's copy is swapped in before any of its
+ * code runs.
+ */
+#pragma once
+
+#include <stdint.h>
+#include "common.h"
+
+typedef struct {
+    // Random seed for the channel, the FHSS sequence is always seeded from the UID
+    uint32_t seed;
+    // Oscillator error of each side in parts per million
+    int32_t txPpm;
+    int32_t rxPpm;
+    // Independent packet loss probability (0.0 - 1.0)
+    float lossRandom;
+    // Gilbert-Elliott burst interference: per-packet probability of entering
+    // and leaving the bad state, and the loss probability while in it
+    float burstEnter;
+    float burstExit;
+    float burstLoss;
+    // Per-hop frequency fading: each FHSS channel gets a fixed fade in dB,
+    // drawn uniformly from 0 to fadeMaxDb. Packets on channels whose fade
+    // exceeds the link margin are lost
+    float fadeMaxDb;
+    float linkMarginDb;
+    // Probability a packet is received with a single bit error
+    float corruptProb;
+    // Full outage window (all packets lost), in us of simulated time
+    uint32_t outageStartUs;
+    uint32_t outageLengthUs;
+    // Signal reported by the radio for every packet, the SNR less the fade
+    int8_t snrDb;
+    int8_t rssiDbm;
+    // Telemetry ratio configured on the TX
+    expresslrs_tlm_ratio_e tlmRatio;
+    // Length of the MSP messages sent from the TX, 0 for none
+    uint8_t mspLen;
+} link_sim_channel_t;
+
+typedef struct {
+    uint32_t connectUs;         // RX tentative -> connected, 0 if never
+    uint32_t lockUs;            // RX timer locked, 0 if never
+    uint32_t disconnects;       // RX connected -> disconnected transitions
+    uint32_t rcSent;            // RC packets transmitted by the TX
+    uint32_t rcReceived;        // RC frames passed on by the RX
+    uint32_t rcMismatch;        // RC frames whose channel data did not match what was sent
+    uint32_t crcRejected;       // Packets delivered corrupted and rejected, either direction
+    uint32_t crcRepaired;       // Packets delivered corrupted and repaired by OtaRepairPacketCrc
+    uint32_t maxMissedRun;      // Longest run of missed RC frames while connected
+    uint32_t uplinkLqSum;       // Sum/count of uplink LQ sampled every RX tick after lock
+    uint32_t uplinkLqCount;
+    int32_t rxFreqOffset;       // RX hwTimer frequency offset at the end of the run
+    uint8_t finalConnected;     // RX is connected at the end of the run
+    uint8_t tlmFinalConnected;  // TX is connected at the end of the run
+    uint32_t tlmConnectUs;      // TX got its first telemetry, 0 if never
+    uint32_t downlinkLqSum;     // Sum/count of downlink LQ sampled every TX tock while connected
+    uint32_t downlinkLqCount;
+    uint32_t tlmReceived;       // Battery frames from the RX's FC received by the TX
+    uint32_t tlmMismatch;       // Telemetry frames received with a bad CRSF CRC or type
+    uint32_t mspReceived;       // MSP messages from the TX received by the RX
+    uint32_t mspMismatch;       // MSP messages received with the wrong content
+} link_sim_result_t;
+
+void LinkSimChannelDefaults(link_sim_channel_t *channel);
+
+/**
+ * @brief Run a simulated link for the specified rate index and duration
+ * @param rateIndex index into the air rate table, both sides start on it
+ * @param durationUs length of the run in simulated microseconds
+ * @param channel channel model parameters
+ * @param result filled with the statistics of the run
+ */
+void LinkSimRun(uint8_t rateIndex, uint32_t durationUs, link_sim_channel_t const *channel, link_sim_result_t *result);
+
+static inline uint32_t LinkSimUplinkLq(link_sim_result_t const *result)
+{
+    return result->uplinkLqCount ? result->uplinkLqSum / result->uplinkLqCount : 0;
+}
+
+static inline uint32_t LinkSimDownlinkLq(link_sim_result_t const *result)
+{
+    return result->downlinkLqCount ? result->downlinkLqSum / result->downlinkLqCount : 0;
+}
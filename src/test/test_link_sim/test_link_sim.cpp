@@ -0,0 +1,242 @@
+/**
+ * This file is part of ExpressLRS
+ * See https://github.com/AlessandroAU/ExpressLRS
+ *
+ * End-to-end link tests using the host-side link simulator
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <unity.h>
+
+#include "targets.h"
+#include "AirRateConfig.h"
+#include "FHSS.h"
+#include "link_sim.h"
+
+#define SIM_DURATION_US (6U * 1000U * 1000U)
+
+static void printResult(uint8_t rateIndex, link_sim_result_t const *res)
+{
+    printf("rate %u (%uHz): connect %ums lock %ums LQ %u rc %u/%u missedRun %u fo %d tlm %ums LQ %u %u/%u msp %u/%u crc %u/%u\n",
+        rateIndex, 1000000U / get_elrs_airRateConfig(rateIndex)->interval,
+        res->connectUs / 1000, res->lockUs / 1000,
+        LinkSimUplinkLq(res), res->rcReceived, res->rcSent,
+        res->maxMissedRun, res->rxFreqOffset,
+        res->tlmConnectUs / 1000, LinkSimDownlinkLq(res), res->tlmReceived, res->tlmMismatch,
+        res->mspReceived, res->mspMismatch, res->crcRepaired, res->crcRejected);
+}
+
+void test_link_sim_all_rates_connect(void)
+{
+    link_sim_channel_t channel;
+    LinkSimChannelDefaults(&channel);
+
+    for (uint8_t rate = 0; rate < RATE_MAX; ++rate)
+    {
+        link_sim_result_t res;
+        LinkSimRun(rate, SIM_DURATION_US, &channel, &res);
+        printResult(rate, &res);
+
+        TEST_ASSERT_TRUE(res.finalConnected);
+        TEST_ASSERT_EQUAL(0, res.disconnects);
+        TEST_ASSERT_NOT_EQUAL(0, res.connectUs);
+        TEST_ASSERT_NOT_EQUAL(0, res.lockUs);
+        // The sync channel comes around once per FHSS cycle, the connection must come up within two
+        expresslrs_mod_settings_s const *modParams = get_elrs_airRateConfig(rate);
+        uint32_t cycleUs = FHSSgetChannelCount() * modParams->FHSShopInterval * modParams->interval;
+        TEST_ASSERT_LESS_THAN(2 * cycleUs, res.connectUs);
+        // The PLL locks the RX timer in a bounded number of packets
+        TEST_ASSERT_LESS_THAN(res.connectUs + 48 * modParams->interval, res.lockUs);
+        TEST_ASSERT_GREATER_OR_EQUAL(99, LinkSimUplinkLq(&res));
+        TEST_ASSERT_EQUAL(0, res.rcMismatch);
+        TEST_ASSERT_LESS_OR_EQUAL(1, res.maxMissedRun);
+
+        // The telemetry downlink comes up after the RX connects and carries the FC's frames intact
+        TEST_ASSERT_TRUE(res.tlmFinalConnected);
+        TEST_ASSERT_NOT_EQUAL(0, res.tlmConnectUs);
+        TEST_ASSERT_NOT_EQUAL(0, res.tlmReceived);
+        TEST_ASSERT_EQUAL(0, res.tlmMismatch);
+    }
+}
+
+void test_link_sim_telemetry(void)
+{
+    link_sim_channel_t channel;
+    LinkSimChannelDefaults(&channel);
+    channel.tlmRatio = TLM_RATIO_1_4;
+    channel.mspLen = 20;
+
+    link_sim_result_t res;
+    LinkSimRun(4, SIM_DURATION_US, &channel, &res);
+    printResult(4, &res);
+
+    TEST_ASSERT_TRUE(res.tlmFinalConnected);
+    TEST_ASSERT_GREATER_OR_EQUAL(95, LinkSimDownlinkLq(&res));
+    TEST_ASSERT_GREATER_OR_EQUAL(99, LinkSimUplinkLq(&res));
+    // The telemetry queue only keeps the FC's latest battery frame, but one must get through every 500ms
+    TEST_ASSERT_GREATER_OR_EQUAL((SIM_DURATION_US - res.tlmConnectUs) / 500000, res.tlmReceived);
+    TEST_ASSERT_EQUAL(0, res.tlmMismatch);
+    TEST_ASSERT_NOT_EQUAL(0, res.mspReceived);
+    TEST_ASSERT_EQUAL(0, res.mspMismatch);
+}
+
+void test_link_sim_clock_drift(void)
+{
+    link_sim_channel_t channel;
+    LinkSimChannelDefaults(&channel);
+
+    // One hwTimer FreqOffset step at 50Hz is 20ppm
+    const int32_t ppms[] = { -100, -60, 60, 100 };
+    for (unsigned i = 0; i < sizeof(ppms) / sizeof(ppms[0]); ++i)
+    {
+        channel.txPpm = ppms[i] / 2;
+        channel.rxPpm = -ppms[i] / 2;
+        link_sim_result_t res;
+        LinkSimRun(9, 4 * SIM_DURATION_US, &channel, &res);
+        printResult(9, &res);
+
+        TEST_ASSERT_TRUE(res.finalConnected);
+        TEST_ASSERT_EQUAL(0, res.disconnects);
+        TEST_ASSERT_NOT_EQUAL(0, res.lockUs);
+        TEST_ASSERT_GREATER_OR_EQUAL(98, LinkSimUplinkLq(&res));
+        // RX clock fast relative to the TX must lengthen the RX timer interval
+        if (ppms[i] < 0)
+            TEST_ASSERT_GREATER_THAN(ppms[i] / -40, res.rxFreqOffset);
+        else
+            TEST_ASSERT_LESS_THAN(ppms[i] / -40, res.rxFreqOffset);
+    }
+}
+
+void test_link_sim_burst_loss(void)
+{
+    link_sim_channel_t channel;
+    LinkSimChannelDefaults(&channel);
+    // Average burst of 10 packets, 10% of the time
+    channel.burstEnter = 0.011f;
+    channel.burstExit = 0.1f;
+    channel.burstLoss = 1.0f;
+
+    link_sim_result_t res;
+    LinkSimRun(4, SIM_DURATION_US, &channel, &res);
+    printResult(4, &res);
+
+    TEST_ASSERT_TRUE(res.finalConnected);
+    TEST_ASSERT_EQUAL(0, res.disconnects);
+    TEST_ASSERT_LESS_THAN(99, LinkSimUplinkLq(&res));
+    TEST_ASSERT_GREATER_THAN(75, LinkSimUplinkLq(&res));
+    TEST_ASSERT_GREATER_OR_EQUAL(3, res.maxMissedRun);
+}
+
+void test_link_sim_per_hop_fading(void)
+{
+    link_sim_channel_t channel;
+    LinkSimChannelDefaults(&channel);
+    // Fades are uniform 0-30dB with a 20dB margin, so 1/3 of the channels are unusable
+    channel.fadeMaxDb = 30.0f;
+
+    link_sim_result_t res;
+    LinkSimRun(0, SIM_DURATION_US, &channel, &res);
+    printResult(0, &res);
+
+    TEST_ASSERT_EQUAL(0, res.disconnects);
+    TEST_ASSERT_LESS_THAN(90, LinkSimUplinkLq(&res));
+    TEST_ASSERT_GREATER_THAN(40, LinkSimUplinkLq(&res));
+    // Each faded channel loses a whole dwell of FHSShopInterval packets
+    TEST_ASSERT_GREATER_OR_EQUAL(get_elrs_airRateConfig(0)->FHSShopInterval, res.maxMissedRun);
+}
+
+void test_link_sim_corruption_rejected(void)
+{
+    link_sim_channel_t channel;
+    LinkSimChannelDefaults(&channel);
+    channel.corruptProb = 0.05f;
+
+    for (uint8_t rate = 0; rate < RATE_MAX; ++rate)
+    {
+        link_sim_result_t res;
+        LinkSimRun(rate, SIM_DURATION_US, &channel, &res);
+
+        TEST_ASSERT_TRUE(res.finalConnected);
+        TEST_ASSERT_NOT_EQUAL(0, res.crcRejected);
+        TEST_ASSERT_EQUAL(0, res.rcMismatch);
+        TEST_ASSERT_EQUAL(0, res.tlmMismatch);
+    }
+}
+
+void test_link_sim_repair(void)
+{
+    link_sim_channel_t channel;
+    LinkSimChannelDefaults(&channel);
+    // Single bit errors on a link carrying MSP up and telemetry down, the
+    // data packets get repaired, the RC and SYNC packets are only ever rejected
+    channel.corruptProb = 0.05f;
+    channel.tlmRatio = TLM_RATIO_1_4;
+    channel.mspLen = 20;
+
+    link_sim_result_t res;
+    LinkSimRun(4, SIM_DURATION_US, &channel, &res);
+    printResult(4, &res);
+
+    TEST_ASSERT_TRUE(res.finalConnected);
+    TEST_ASSERT_NOT_EQUAL(0, res.crcRepaired);
+    TEST_ASSERT_NOT_EQUAL(0, res.crcRejected);
+    TEST_ASSERT_NOT_EQUAL(0, res.tlmReceived);
+    TEST_ASSERT_NOT_EQUAL(0, res.mspReceived);
+    TEST_ASSERT_EQUAL(0, res.rcMismatch);
+    TEST_ASSERT_EQUAL(0, res.tlmMismatch);
+    TEST_ASSERT_EQUAL(0, res.mspMismatch);
+}
+
+void test_link_sim_outage_reconnect(void)
+{
+    link_sim_channel_t channel;
+    LinkSimChannelDefaults(&channel);
+    channel.outageStartUs = 3U * 1000U * 1000U;
+    channel.outageLengthUs = 3U * 1000U * 1000U;
+
+    link_sim_result_t res;
+    LinkSimRun(0, 10U * 1000U * 1000U, &channel, &res);
+    printResult(0, &res);
+
+    TEST_ASSERT_EQUAL(1, res.disconnects);
+    TEST_ASSERT_TRUE(res.finalConnected);
+}
+
+void test_link_sim_deterministic(void)
+{
+    link_sim_channel_t channel;
+    LinkSimChannelDefaults(&channel);
+    channel.lossRandom = 0.1f;
+    channel.rxPpm = 25;
+
+    link_sim_result_t res1, res2;
+    LinkSimRun(7, SIM_DURATION_US, &channel, &res1);
+    LinkSimRun(7, SIM_DURATION_US, &channel, &res2);
+    TEST_ASSERT_EQUAL_MEMORY(&res1, &res2, sizeof(res1));
+
+    channel.seed += 1;
+    LinkSimRun(7, SIM_DURATION_US, &channel, &res2);
+    TEST_ASSERT_NOT_EQUAL(res1.rcReceived, res2.rcReceived);
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_link_sim_all_rates_connect);
+    RUN_TEST(test_link_sim_telemetry);
+    RUN_TEST(test_link_sim_clock_drift);
+    RUN_TEST(test_link_sim_burst_loss);
+    RUN_TEST(test_link_sim_per_hop_fading);
+    RUN_TEST(test_link_sim_corruption_rejected);
+    RUN_TEST(test_link_sim_repair);
+    RUN_TEST(test_link_sim_outage_reconnect);
+    RUN_TEST(test_link_sim_deterministic);
+    UNITY_END();
+
+    return 0;
+}
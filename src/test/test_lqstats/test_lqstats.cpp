@@ -0,0 +1,129 @@
+#include <cstdint>
+#include <unity.h>
+
+#include "targets.h"
+#include "LQSTATS.h"
+
+void test_lqstats_windows(void)
+{
+    LQSTATS stats;
+    TEST_ASSERT_EQUAL(100, stats.getLQ(LQSTATS_WINDOW_10));
+
+    // 1000 periods with every 4th lost
+    for (unsigned i = 0; i < 1000; ++i)
+        stats.inc(i % 4 != 3, 0);
+    TEST_ASSERT_EQUAL(75, stats.getLQ(LQSTATS_WINDOW_100));
+    TEST_ASSERT_EQUAL(75, stats.getLQ(LQSTATS_WINDOW_1000));
+
+    // The short window follows a change immediately, the long one slowly
+    for (unsigned i = 0; i < 10; ++i)
+        stats.inc(true, 0);
+    TEST_ASSERT_EQUAL(100, stats.getLQ(LQSTATS_WINDOW_10));
+    TEST_ASSERT_EQUAL(77, stats.getLQ(LQSTATS_WINDOW_100));
+    TEST_ASSERT_EQUAL(75, stats.getLQ(LQSTATS_WINDOW_1000));
+
+    // Run long enough to wrap the history a few times
+    for (unsigned i = 0; i < 5000; ++i)
+        stats.inc(false, 0);
+    TEST_ASSERT_EQUAL(0, stats.getLQ(LQSTATS_WINDOW_10));
+    TEST_ASSERT_EQUAL(0, stats.getLQ(LQSTATS_WINDOW_1000));
+    for (unsigned i = 0; i < 500; ++i)
+        stats.inc(true, 0);
+    TEST_ASSERT_EQUAL(100, stats.getLQ(LQSTATS_WINDOW_100));
+    TEST_ASSERT_EQUAL(50, stats.getLQ(LQSTATS_WINDOW_1000));
+}
+
+void test_lqstats_partial_window(void)
+{
+    LQSTATS stats;
+    for (unsigned i = 0; i < 50; ++i)
+        stats.inc(i < 25, 0);
+    // Only the periods recorded so far count
+    TEST_ASSERT_EQUAL(0, stats.getLQ(LQSTATS_WINDOW_10));
+    TEST_ASSERT_EQUAL(50, stats.getLQ(LQSTATS_WINDOW_100));
+    TEST_ASSERT_EQUAL(50, stats.getLQ(LQSTATS_WINDOW_1000));
+}
+
+void test_lqstats_burst_bucket(void)
+{
+    TEST_ASSERT_EQUAL(0, LQSTATS::burstBucket(1));
+    TEST_ASSERT_EQUAL(1, LQSTATS::burstBucket(2));
+    TEST_ASSERT_EQUAL(2, LQSTATS::burstBucket(3));
+    TEST_ASSERT_EQUAL(2, LQSTATS::burstBucket(4));
+    TEST_ASSERT_EQUAL(3, LQSTATS::burstBucket(5));
+    TEST_ASSERT_EQUAL(3, LQSTATS::burstBucket(8));
+    TEST_ASSERT_EQUAL(6, LQSTATS::burstBucket(64));
+    TEST_ASSERT_EQUAL(7, LQSTATS::burstBucket(65));
+    TEST_ASSERT_EQUAL(7, LQSTATS::burstBucket(UINT16_MAX));
+}
+
+void test_lqstats_burst_histogram(void)
+{
+    LQSTATS stats;
+    const uint16_t runs[] = { 1, 1, 2, 4, 7, 100 };
+    for (unsigned r = 0; r < sizeof(runs) / sizeof(runs[0]); ++r)
+    {
+        for (unsigned i = 0; i < runs[r]; ++i)
+            stats.inc(false, 0);
+        stats.inc(true, 0);
+    }
+    // A run still in progress is not counted
+    stats.inc(false, 0);
+
+    TEST_ASSERT_EQUAL(2, stats.getBurstCount(0));
+    TEST_ASSERT_EQUAL(1, stats.getBurstCount(1));
+    TEST_ASSERT_EQUAL(1, stats.getBurstCount(2));
+    TEST_ASSERT_EQUAL(1, stats.getBurstCount(3));
+    TEST_ASSERT_EQUAL(0, stats.getBurstCount(4));
+    TEST_ASSERT_EQUAL(1, stats.getBurstCount(7));
+    TEST_ASSERT_EQUAL(100, stats.getMaxBurst());
+}
+
+void test_lqstats_channel_loss(void)
+{
+    LQSTATS stats;
+    // Hop across 4 channels, channel 2 loses everything and channel 3 half
+    uint8_t channel = 0;
+    stats.inc(true, channel);
+    for (unsigned i = 0; i < 400; ++i)
+    {
+        bool received = (channel != 2) && !(channel == 3 && (i / 4) % 2);
+        channel = (i + 1) % 4;
+        stats.inc(received, channel);
+    }
+    TEST_ASSERT_EQUAL(0, stats.getChannelLoss(0));
+    TEST_ASSERT_EQUAL(0, stats.getChannelLoss(1));
+    TEST_ASSERT_EQUAL(100, stats.getChannelLoss(2));
+    TEST_ASSERT_EQUAL(50, stats.getChannelLoss(3));
+    TEST_ASSERT_EQUAL(100, stats.getChannelPeriods(2));
+    TEST_ASSERT_EQUAL(0, stats.getChannelPeriods(4));
+    TEST_ASSERT_EQUAL(0, stats.getChannelLoss(LQSTATS_MAX_CHANNELS));
+
+    // The counts age out instead of overflowing
+    for (unsigned i = 0; i < 70000; ++i)
+        stats.inc(true, 2);
+    TEST_ASSERT_GREATER_THAN(UINT16_MAX / 2, stats.getChannelPeriods(2));
+    TEST_ASSERT_EQUAL(0, stats.getChannelLoss(2));
+
+    stats.reset();
+    TEST_ASSERT_EQUAL(0, stats.getChannelPeriods(2));
+    TEST_ASSERT_EQUAL(0, stats.getMaxBurst());
+    TEST_ASSERT_EQUAL(100, stats.getLQ(LQSTATS_WINDOW_1000));
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_lqstats_windows);
+    RUN_TEST(test_lqstats_partial_window);
+    RUN_TEST(test_lqstats_burst_bucket);
+    RUN_TEST(test_lqstats_burst_histogram);
+    RUN_TEST(test_lqstats_channel_loss);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,357 @@
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+#include <unity.h>
+
+#include "MAVLinkCompress.h"
+
+// CRSF_PAYLOAD_SIZE_MAX, the address and count bytes of the stubborn message are outside it
+#define PAYLOAD_MAX 62
+
+typedef std::vector<uint8_t> bytes_t;
+
+static uint8_t crcExtraFor(uint32_t msgid)
+{
+    switch (msgid)
+    {
+    case 0: return 50;
+    case 1: return 124;
+    case 22: return 220;
+    case 24: return 24;
+    case 30: return 39;
+    case 33: return 104;
+    case 65: return 118;
+    case 74: return 20;
+    default: return 0;
+    }
+}
+
+static bytes_t makeFrame(uint8_t seq, uint8_t sysid, uint8_t compid, uint32_t msgid, const bytes_t &payload)
+{
+    // v2 truncates the trailing zeros of the payload
+    uint8_t len = payload.size();
+    while (len > 1 && payload[len - 1] == 0)
+        --len;
+    bytes_t frame = {MAVLINK_COMPRESS_STX, len, 0, 0, seq, sysid, compid,
+                     (uint8_t)msgid, (uint8_t)(msgid >> 8), (uint8_t)(msgid >> 16)};
+    frame.insert(frame.end(), payload.begin(), payload.begin() + len);
+    uint16_t const crc = MAVLinkCompressContext::crc(frame.data(), crcExtraFor(msgid));
+    frame.push_back(crc);
+    frame.push_back(crc >> 8);
+    return frame;
+}
+
+template <typename T>
+static void put(bytes_t &p, T v)
+{
+    uint8_t b[sizeof(T)];
+    memcpy(b, &v, sizeof(T));
+    p.insert(p.end(), b, b + sizeof(T));
+}
+
+/*
+ * A tlog of a 60s flight from an autopilot streaming at typical rates. tlog records
+ * are an 8 byte big endian timestamp in us followed by the frame
+ */
+static bytes_t makeFlightTlog()
+{
+    bytes_t tlog;
+    uint8_t seq = 0;
+    auto record = [&](uint32_t ms, uint32_t msgid, const bytes_t &payload) {
+        uint64_t const us = (uint64_t)ms * 1000;
+        for (int i = 7; i >= 0; --i)
+            tlog.push_back(us >> (i * 8));
+        bytes_t const frame = makeFrame(seq++, 1, 1, msgid, payload);
+        tlog.insert(tlog.end(), frame.begin(), frame.end());
+    };
+
+    for (uint32_t ms = 0; ms < 60000; ms += 20)
+    {
+        float const t = ms / 1000.0f;
+        float const roll = 0.3f * sinf(t * 0.7f);
+        float const pitch = 0.1f * sinf(t * 0.3f);
+        float const yaw = fmodf(t * 0.2f, 6.28f);
+        int32_t const lat = 473977000 + (int32_t)(t * 80);
+        int32_t const lon = 85456000 + (int32_t)(t * 120);
+        int32_t const alt = 120000 + (int32_t)(5000 * sinf(t * 0.1f));
+
+        if (ms % 1000 == 0)
+        {
+            bytes_t p;
+            put<uint32_t>(p, 3); // custom_mode
+            p.insert(p.end(), {2, 3, 209, 4, 3});
+            record(ms, 0, p);
+        }
+        if (ms % 500 == 0)
+        {
+            bytes_t p;
+            put<uint32_t>(p, 0x0361fc2f);
+            put<uint32_t>(p, 0x0361fc2f);
+            put<uint32_t>(p, 0x0361ec2f);
+            put<uint16_t>(p, 180 + (ms / 500) % 40);        // load
+            put<uint16_t>(p, 16200 - ms / 100);             // voltage
+            put<int16_t>(p, 1500 + (int16_t)(200 * sinf(t)));  // current
+            for (int i = 0; i < 6; ++i)
+                put<uint16_t>(p, 0);
+            p.push_back(95 - ms / 3000);                    // battery_remaining
+            record(ms, 1, p);
+        }
+        if (ms % 200 == 0)
+        {
+            bytes_t p;
+            put<uint64_t>(p, (uint64_t)ms * 1000 + 1600000000000000ULL);
+            put<int32_t>(p, lat);
+            put<int32_t>(p, lon);
+            put<int32_t>(p, alt + 48000);
+            put<uint16_t>(p, 121);
+            put<uint16_t>(p, 200);
+            put<uint16_t>(p, 1250 + (ms / 200) % 7);
+            put<uint16_t>(p, (uint16_t)(yaw * 5729));
+            p.insert(p.end(), {3, 14});
+            record(ms, 24, p);
+        }
+        if (ms % 40 == 0)
+        {
+            bytes_t p;
+            put<uint32_t>(p, ms);
+            put<float>(p, roll);
+            put<float>(p, pitch);
+            put<float>(p, yaw);
+            put<float>(p, 0.21f * cosf(t * 0.7f));
+            put<float>(p, 0.03f * cosf(t * 0.3f));
+            put<float>(p, 0.2f);
+            record(ms, 30, p);
+        }
+        if (ms % 100 == 0)
+        {
+            bytes_t p;
+            put<uint32_t>(p, ms);
+            put<int32_t>(p, lat);
+            put<int32_t>(p, lon);
+            put<int32_t>(p, alt + 48000);
+            put<int32_t>(p, alt);
+            put<int16_t>(p, 1200);
+            put<int16_t>(p, 310);
+            put<int16_t>(p, (int16_t)(-50 * sinf(t * 0.1f)));
+            put<uint16_t>(p, (uint16_t)(yaw * 5729));
+            record(ms, 33, p);
+
+            bytes_t h;
+            put<float>(h, 12.5f);
+            put<float>(h, 12.9f);
+            put<float>(h, alt / 1000.0f);
+            put<float>(h, -0.5f * sinf(t * 0.1f));
+            put<int16_t>(h, (int16_t)(yaw * 57.29f));
+            put<uint16_t>(h, 48);
+            record(ms, 74, h);
+        }
+        if (ms % 200 == 0)
+        {
+            bytes_t p;
+            put<uint32_t>(p, ms);
+            put<uint16_t>(p, 1500 + (uint16_t)(300 * roll));
+            put<uint16_t>(p, 1500 + (uint16_t)(300 * pitch));
+            put<uint16_t>(p, 1550);
+            put<uint16_t>(p, 1500);
+            for (int i = 4; i < 8; ++i)
+                put<uint16_t>(p, 1000);
+            for (int i = 8; i < 18; ++i)
+                put<uint16_t>(p, 0);
+            p.push_back(8);
+            p.push_back(254);
+            record(ms, 65, p);
+        }
+        // Parameter download at the start
+        if (ms < 2000 && ms % 40 == 20)
+        {
+            bytes_t p;
+            put<float>(p, ms / 7.0f);
+            put<uint16_t>(p, 50);
+            put<uint16_t>(p, ms / 40);
+            char name[16] = {0};
+            snprintf(name, sizeof(name), "PARAM_%u", (unsigned)(ms / 40));
+            p.insert(p.end(), name, name + sizeof(name));
+            p.push_back(9);
+            record(ms, 22, p);
+        }
+    }
+    return tlog;
+}
+
+// The serial stream of a tlog and its frames
+static bytes_t replayTlog(const bytes_t &tlog, std::vector<bytes_t> *frames)
+{
+    bytes_t stream;
+    size_t pos = 0;
+    while (pos + 8 + MAVLINK_COMPRESS_HEADER_LEN <= tlog.size())
+    {
+        pos += 8;
+        size_t const len = MAVLINK_COMPRESS_HEADER_LEN + tlog[pos + 1] + 2;
+        bytes_t const frame(tlog.begin() + pos, tlog.begin() + pos + len);
+        stream.insert(stream.end(), frame.begin(), frame.end());
+        if (frames)
+            frames->push_back(frame);
+        pos += len;
+    }
+    return stream;
+}
+
+/*
+ * Push the stream through the codec as the RX does, a payload is filled each time the
+ * stubborn sender is free and `serialChunk` more bytes have arrived from the FC.
+ * Every `dropEvery`th payload is lost
+ */
+static bytes_t runLink(const bytes_t &stream, size_t serialChunk, unsigned dropEvery, size_t *linkBytes)
+{
+    MAVLinkCompressor compressor;
+    MAVLinkDecompressor decompressor;
+    bytes_t out;
+    bytes_t pending;
+    uint8_t payload[PAYLOAD_MAX];
+    uint8_t unpacked[MAVLINK_COMPRESS_MAX_EXPANSION * PAYLOAD_MAX];
+    size_t fed = 0;
+    unsigned payloads = 0;
+    *linkBytes = 0;
+
+    while (fed < stream.size() || !pending.empty())
+    {
+        size_t const chunk = std::min(serialChunk, stream.size() - fed);
+        pending.insert(pending.end(), stream.begin() + fed, stream.begin() + fed + chunk);
+        fed += chunk;
+
+        uint16_t consumed;
+        uint8_t const len = compressor.compress(pending.data(), pending.size(), &consumed, payload, sizeof(payload));
+        pending.erase(pending.begin(), pending.begin() + consumed);
+        if (len == 0)
+        {
+            if (fed == stream.size() && consumed == 0)
+                break;
+            continue;
+        }
+
+        // The address and count bytes of the stubborn message
+        *linkBytes += len + 2;
+        if (dropEvery && (++payloads % dropEvery) == 0)
+            continue;
+        uint16_t const n = decompressor.decompress(payload, len, unpacked, sizeof(unpacked));
+        out.insert(out.end(), unpacked, unpacked + n);
+    }
+    return out;
+}
+
+void test_mavlink_compress_tlog_replay(void)
+{
+    std::vector<bytes_t> frames;
+    bytes_t const stream = replayTlog(makeFlightTlog(), &frames);
+
+    size_t linkBytes;
+    bytes_t const out = runLink(stream, 40, 0, &linkBytes);
+    TEST_ASSERT_EQUAL(stream.size(), out.size());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(stream.data(), out.data(), stream.size());
+
+    // Uncompressed, each payload of PAYLOAD_MAX bytes goes with the same 2 bytes
+    size_t const rawBytes = stream.size() + 2 * ((stream.size() + PAYLOAD_MAX - 1) / PAYLOAD_MAX);
+    std::cout << "tlog replay: " << frames.size() << " frames, " << rawBytes << " bytes raw, "
+              << linkBytes << " bytes compressed, " << (100 - linkBytes * 100 / rawBytes) << "% saved" << std::endl;
+    TEST_ASSERT_LESS_THAN(rawBytes * 2 / 3, linkBytes);
+}
+
+void test_mavlink_compress_delta(void)
+{
+    bytes_t p;
+    put<uint32_t>(p, 1000);
+    for (int i = 0; i < 6; ++i)
+        put<float>(p, 0.1f * i);
+    bytes_t stream = makeFrame(10, 1, 1, 30, p);
+    p[0] = 0x14; // time_boot_ms 1020
+    bytes_t const second = makeFrame(11, 1, 1, 30, p);
+    stream.insert(stream.end(), second.begin(), second.end());
+
+    MAVLinkCompressor compressor;
+    MAVLinkDecompressor decompressor;
+    uint8_t payload[PAYLOAD_MAX];
+    uint8_t unpacked[MAVLINK_COMPRESS_MAX_EXPANSION * PAYLOAD_MAX];
+    uint16_t consumed;
+    uint8_t const len = compressor.compress(stream.data(), stream.size(), &consumed, payload, sizeof(payload));
+    TEST_ASSERT_EQUAL(stream.size(), consumed);
+    // seq, reset, source, full header with seq, len, payload, then delta header, len, bitmap and the 1 byte changed
+    TEST_ASSERT_EQUAL(2 + 3 + 2 + 1 + 28 + 1 + 1 + 4 + 1, len);
+
+    uint16_t const n = decompressor.decompress(payload, len, unpacked, sizeof(unpacked));
+    TEST_ASSERT_EQUAL(stream.size(), n);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(stream.data(), unpacked, n);
+}
+
+void test_mavlink_compress_passthrough(void)
+{
+    bytes_t p = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    // Junk, a v1 frame, a signed v2 frame, a table frame with a bad CRC and a message not in the table
+    bytes_t stream = {0x00, 0x55, 0xaa};
+    bytes_t const v1 = {0xfe, 9, 0, 1, 1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0x12, 0x34};
+    stream.insert(stream.end(), v1.begin(), v1.end());
+    bytes_t signedFrame = makeFrame(1, 1, 1, 0, p);
+    signedFrame[2] = 1;
+    signedFrame.insert(signedFrame.end(), 13, 0x5a);
+    stream.insert(stream.end(), signedFrame.begin(), signedFrame.end());
+    bytes_t badCrc = makeFrame(2, 1, 1, 0, p);
+    badCrc.back() ^= 0xff;
+    stream.insert(stream.end(), badCrc.begin(), badCrc.end());
+    bytes_t const other = makeFrame(3, 1, 1, 253, p);
+    stream.insert(stream.end(), other.begin(), other.end());
+
+    size_t linkBytes;
+    for (size_t chunk : {1, 7, 300})
+    {
+        bytes_t const out = runLink(stream, chunk, 0, &linkBytes);
+        TEST_ASSERT_EQUAL(stream.size(), out.size());
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(stream.data(), out.data(), stream.size());
+    }
+}
+
+void test_mavlink_compress_lost_payload(void)
+{
+    std::vector<bytes_t> frames;
+    bytes_t const stream = replayTlog(makeFlightTlog(), &frames);
+    std::set<std::string> sent;
+    for (const bytes_t &f : frames)
+        sent.insert(std::string(f.begin(), f.end()));
+
+    size_t linkBytes;
+    bytes_t const out = runLink(stream, 40, 100, &linkBytes);
+
+    // Frames are lost, but every frame that comes out is one that went in
+    size_t pos = 0;
+    unsigned received = 0;
+    while (pos + MAVLINK_COMPRESS_HEADER_LEN + 2 <= out.size())
+    {
+        TEST_ASSERT_EQUAL_HEX8(MAVLINK_COMPRESS_STX, out[pos]);
+        size_t const len = MAVLINK_COMPRESS_HEADER_LEN + out[pos + 1] + 2;
+        TEST_ASSERT_TRUE(sent.count(std::string(out.begin() + pos, out.begin() + pos + len)) == 1);
+        ++received;
+        pos += len;
+    }
+    TEST_ASSERT_EQUAL(out.size(), pos);
+    // 1% of the payloads are lost, and the frames that follow each until the next reset
+    TEST_ASSERT_GREATER_THAN(frames.size() / 2, received);
+    TEST_ASSERT_LESS_THAN(frames.size(), received);
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_mavlink_compress_tlog_replay);
+    RUN_TEST(test_mavlink_compress_delta);
+    RUN_TEST(test_mavlink_compress_passthrough);
+    RUN_TEST(test_mavlink_compress_lost_payload);
+    UNITY_END();
+
+    return 0;
+}
@@ -0,0 +1,200 @@
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+#include <unity.h>
+#include "msp.h"
+#include "crc.h"
+
+typedef std::vector<uint8_t> bytes;
+
+static bytes buildFrame(char type, uint16_t function, const bytes &payload)
+{
+    bytes frame = {'$', 'X', (uint8_t)type, 0, (uint8_t)function, (uint8_t)(function >> 8),
+                   (uint8_t)payload.size(), (uint8_t)(payload.size() >> 8)};
+    uint8_t const crc = Crc8Fixed<CRC8_DVB_S2_POLY>::calc(&frame[3], 5);
+    frame.insert(frame.end(), payload.begin(), payload.end());
+    frame.push_back(Crc8Fixed<CRC8_DVB_S2_POLY>::calc(payload.data(), payload.size(), crc));
+    return frame;
+}
+
+static bytes pattern(size_t len, uint8_t seed)
+{
+    bytes payload(len);
+    for (size_t i = 0; i < len; i++)
+        payload[i] = seed + i * 7;
+    return payload;
+}
+
+// What the callbacks were given
+struct received_t {
+    std::vector<mspFrameInfo_t> frames;
+    std::vector<bytes> payloads;
+    bytes sliced;
+    const uint8_t *spanStart;
+    const uint8_t *spanEnd;
+    bool slicesInSpan;
+};
+
+static void onFrame(void *ctx, const mspFrameInfo_t &info, const uint8_t *payload)
+{
+    received_t *rx = (received_t *)ctx;
+    rx->frames.push_back(info);
+    rx->payloads.push_back(payload ? bytes(payload, payload + info.payloadSize) : bytes());
+}
+
+static void onSlice(void *ctx, const mspFrameInfo_t &info, uint16_t offset, const uint8_t *data, uint16_t len)
+{
+    received_t *rx = (received_t *)ctx;
+    TEST_ASSERT_EQUAL(rx->sliced.size(), offset);
+    rx->sliced.insert(rx->sliced.end(), data, data + len);
+    // Zero copy: the slice is in the buffer being parsed
+    rx->slicesInSpan &= data >= rx->spanStart && data + len <= rx->spanEnd;
+}
+
+// Feed `stream` to the parser in spans of random length, as a UART would return it
+static uint32_t feed(MSPParser &parser, received_t &rx, const bytes &stream, uint32_t maxSpan)
+{
+    uint32_t frames = 0;
+    for (size_t pos = 0; pos < stream.size();)
+    {
+        uint32_t n = 1 + rand() % maxSpan;
+        if (n > stream.size() - pos)
+            n = stream.size() - pos;
+        rx.spanStart = &stream[pos];
+        rx.spanEnd = &stream[pos] + n;
+        frames += parser.parse(&stream[pos], n);
+        pos += n;
+    }
+    return frames;
+}
+
+void test_msp_parser_large_frame(void)
+{
+    // Bigger than an mspPacket_t, e.g. an OSD config or VTX table
+    uint8_t pool[4096];
+    MSPParser parser(pool, sizeof(pool));
+    received_t rx = {};
+    parser.setCallbacks(onFrame, nullptr, &rx);
+
+    bytes const large = pattern(2000, 1);
+    bytes const small = pattern(3, 2);
+    bytes stream = buildFrame('>', 0x1234, large);
+    bytes const second = buildFrame('<', 88, small);
+    stream.insert(stream.end(), second.begin(), second.end());
+
+    srand(1);
+    TEST_ASSERT_EQUAL(2, feed(parser, rx, stream, 200));
+    TEST_ASSERT_EQUAL(2, rx.frames.size());
+    TEST_ASSERT_EQUAL(MSP_PACKET_RESPONSE, rx.frames[0].type);
+    TEST_ASSERT_EQUAL(0x1234, rx.frames[0].function);
+    TEST_ASSERT_EQUAL(2000, rx.frames[0].payloadSize);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(large.data(), rx.payloads[0].data(), large.size());
+    TEST_ASSERT_EQUAL(MSP_PACKET_COMMAND, rx.frames[1].type);
+    TEST_ASSERT_EQUAL(88, rx.frames[1].function);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(small.data(), rx.payloads[1].data(), small.size());
+}
+
+void test_msp_parser_slices(void)
+{
+    // Up to the MSPv2 limit with only a small pool
+    uint8_t pool[64];
+    MSPParser parser(pool, sizeof(pool));
+    received_t rx = {};
+    rx.slicesInSpan = true;
+    parser.setCallbacks(onFrame, onSlice, &rx);
+
+    bytes const payload = pattern(65535, 3);
+    bytes const stream = buildFrame('>', 300, payload);
+    srand(2);
+    TEST_ASSERT_EQUAL(1, feed(parser, rx, stream, 512));
+
+    TEST_ASSERT_EQUAL(1, rx.frames.size());
+    TEST_ASSERT_EQUAL(65535, rx.frames[0].payloadSize);
+    TEST_ASSERT_EQUAL(0, rx.payloads[0].size()); // handed out in slices, not in the pool
+    TEST_ASSERT_EQUAL(payload.size(), rx.sliced.size());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(payload.data(), rx.sliced.data(), payload.size());
+    TEST_ASSERT_TRUE(rx.slicesInSpan);
+}
+
+void test_msp_parser_resync(void)
+{
+    uint8_t pool[64];
+    MSPParser parser(pool, sizeof(pool));
+    received_t rx = {};
+    parser.setCallbacks(onFrame, nullptr, &rx);
+
+    bytes bad = buildFrame('<', 1, pattern(10, 4));
+    bad[10] ^= 1;
+    bytes const good = buildFrame('<', 2, pattern(10, 5));
+    bytes const tooBig = buildFrame('>', 3, pattern(100, 6));
+
+    // Noise with false starts, a corrupt frame, one too big for the pool, then a good one
+    bytes stream = {'x', '$', '$', 'M', '<', '$', 'X', '!', '$'};
+    stream.insert(stream.end(), bad.begin(), bad.end());
+    stream.insert(stream.end(), tooBig.begin(), tooBig.end());
+    stream.insert(stream.end(), good.begin(), good.end());
+    TEST_ASSERT_EQUAL(1, parser.parse(stream.data(), stream.size()));
+
+    TEST_ASSERT_EQUAL(1, parser.crcErrors);
+    TEST_ASSERT_EQUAL(1, parser.droppedFrames);
+    TEST_ASSERT_EQUAL(1, rx.frames.size());
+    TEST_ASSERT_EQUAL(2, rx.frames[0].function);
+}
+
+// The MSP class used to write whatever payload size the header said into its 64 byte packet
+void test_msp_receive_oversize(void)
+{
+    MSP msp;
+    bytes stream = buildFrame('<', 1, pattern(1000, 7));
+    bytes const good = buildFrame('<', 2, pattern(64, 8));
+    stream.insert(stream.end(), good.begin(), good.end());
+
+    static unsigned packets;
+    static uint16_t function;
+    packets = 0;
+    msp.processReceivedBytes(stream.data(), stream.size(), [](mspPacket_t *packet) {
+        packets++;
+        function = packet->function;
+        TEST_ASSERT_EQUAL(64, packet->payloadSize);
+    });
+    TEST_ASSERT_EQUAL(1, packets);
+    TEST_ASSERT_EQUAL(2, function);
+}
+
+void test_msp_parser_throughput(void)
+{
+    // A stream of typical frames, as from a backpack or displayport
+    bytes stream;
+    uint32_t frames = 0;
+    for (unsigned i = 0; stream.size() < 1000000; i++)
+    {
+        bytes const frame = buildFrame('>', 100 + i % 50, pattern(8 + i % 120, i));
+        stream.insert(stream.end(), frame.begin(), frame.end());
+        frames++;
+    }
+    uint8_t pool[256];
+    received_t rx = {};
+
+    MSPParser bytewise(pool, sizeof(pool));
+    clock_t start = clock();
+    uint32_t counted = 0;
+    for (size_t i = 0; i < stream.size(); i++)
+        counted += bytewise.parse(&stream[i], 1);
+    clock_t const bytewiseTicks = clock() - start;
+    TEST_ASSERT_EQUAL(frames, counted);
+
+    MSPParser spans(pool, sizeof(pool));
+    spans.setCallbacks(onFrame, nullptr, &rx);
+    start = clock();
+    counted = 0;
+    for (size_t i = 0; i < stream.size(); i += 64)
+        counted += spans.parse(&stream[i], std::min((size_t)64, stream.size() - i));
+    clock_t const spanTicks = clock() - start;
+    TEST_ASSERT_EQUAL(frames, counted);
+    TEST_ASSERT_EQUAL(frames, rx.frames.size());
+
+    printf("%u frames, %u bytes: a byte at a time %.1fms, 64 byte spans %.1fms\n", frames, (unsigned)stream.size(),
+        bytewiseTicks * 1000.0 / CLOCKS_PER_SEC, spanTicks * 1000.0 / CLOCKS_PER_SEC);
+    TEST_ASSERT_LESS_OR_EQUAL(bytewiseTicks, spanTicks);
+}
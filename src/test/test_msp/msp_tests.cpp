@@ -107,6 +107,11 @@ void test_msp_send(void)
 
 extern void test_encapsulated_msp_send(void);
 extern void test_encapsulated_msp_send_too_long(void);
+extern void test_msp_parser_large_frame(void);
+extern void test_msp_parser_slices(void);
+extern void test_msp_parser_resync(void);
+extern void test_msp_receive_oversize(void);
+extern void test_msp_parser_throughput(void);
 
 // Unity setup/teardown
 void setUp() {}
@@ -121,6 +126,12 @@ int main(int argc, char **argv)
     RUN_TEST(test_encapsulated_msp_send);
     RUN_TEST(test_encapsulated_msp_send_too_long);
 
+    RUN_TEST(test_msp_parser_large_frame);
+    RUN_TEST(test_msp_parser_slices);
+    RUN_TEST(test_msp_parser_resync);
+    RUN_TEST(test_msp_receive_oversize);
+    RUN_TEST(test_msp_parser_throughput);
+
     UNITY_END();
 
     return 0;
@@ -0,0 +1,412 @@
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <vector>
+#include <unity.h>
+#include "crsf_protocol.h"
+#include "mspbridge.h"
+
+GENERIC_CRC8 crsf_crc(CRSF_CRC_POLY);
+
+typedef std::vector<uint8_t> bytes;
+
+static bytes mspV1(char dir, uint8_t cmd, const bytes &payload)
+{
+    bytes frame = {'$', 'M', (uint8_t)dir, (uint8_t)payload.size(), cmd};
+    frame.insert(frame.end(), payload.begin(), payload.end());
+    uint8_t checksum = 0;
+    for (size_t i = 3; i < frame.size(); i++)
+        checksum ^= frame[i];
+    frame.push_back(checksum);
+    return frame;
+}
+
+static bytes mspV2(char dir, uint16_t function, const bytes &payload)
+{
+    bytes frame = {'$', 'X', (uint8_t)dir, 0, (uint8_t)function, (uint8_t)(function >> 8),
+                   (uint8_t)payload.size(), (uint8_t)(payload.size() >> 8)};
+    frame.insert(frame.end(), payload.begin(), payload.end());
+    frame.push_back(crsf_crc.calc(&frame[3], frame.size() - 3));
+    return frame;
+}
+
+// What the FC replies to `function`, long enough to need several CRSF chunks for some
+static bytes replyPayload(uint16_t function)
+{
+    bytes payload(function % 2 ? 150 : 10);
+    for (size_t i = 0; i < payload.size(); i++)
+        payload[i] = function + i;
+    return payload;
+}
+
+static bytes replyTo(const bytes &request)
+{
+    uint16_t const function = MSPBRIDGE::getFunction(request.data());
+    if (request[1] == 'X')
+        return mspV2('>', function, replyPayload(function));
+    return mspV1('>', function, replyPayload(function));
+}
+
+/**
+ * The sockets: what each client received, and how much each can take
+ */
+class FakeTransport : public MspBridgeTransport
+{
+public:
+    uint32_t space(void *client) override { return spaceFor.count(client) ? spaceFor[client] : 4096; }
+    void write(void *client, const uint8_t *data, uint32_t len) override
+    {
+        TEST_ASSERT_LESS_OR_EQUAL(space(client), len);
+        bytes &rx = received[client];
+        rx.insert(rx.end(), data, data + len);
+    }
+
+    std::map<void *, bytes> received;
+    std::map<void *, uint32_t> spaceFor;
+};
+
+/**
+ * A flight controller on the other end of the CRSF UART. Each reply goes `latencyMs` after
+ * the request arrived, but only `serviceMs` after the previous reply as the FC works through
+ * its buffer one request at a time. Like Betaflight it only has room for 128 bytes of
+ * requests it hasn't replied to.
+ */
+class FakeFC
+{
+public:
+    FakeFC(MSPBRIDGE &bridge) : bridge(bridge) {}
+
+    void tick(uint32_t now)
+    {
+        uint8_t len;
+        while ((len = bridge.crsfOutAvailable(64)))
+        {
+            uint8_t crsf[64];
+            bridge.crsfOutPop(crsf);
+            pendingBytes += len;
+            TEST_ASSERT_LESS_OR_EQUAL(MSPBRIDGE_IN_FLIGHT_BUDGET, pendingBytes);
+            requestBytes.push_back(len);
+            if (!crsf2msp.parse(crsf))
+                continue;
+            bytes request(crsf2msp.getFrame(), crsf2msp.getFrame() + crsf2msp.getFrameLen());
+            requests.push_back(request);
+            uint32_t due = now + latencyMs;
+            if (!replies.empty() && replies.back().due + serviceMs > due)
+                due = replies.back().due + serviceMs;
+            replies.push_back({due, request, requestBytes});
+            requestBytes.clear();
+        }
+
+        while (!replies.empty() && (int32_t)(now - replies.front().due) >= 0)
+        {
+            reply_t const reply = replies.front();
+            replies.pop_front();
+            for (uint8_t b : reply.crsfBytes)
+                pendingBytes -= b;
+            if (dropReplies)
+                continue;
+            bytes const frame = replyTo(reply.request);
+            msp2crsf.parse(frame.data(), frame.size(), CRSF_ADDRESS_FLIGHT_CONTROLLER, CRSF_ADDRESS_CRSF_RECEIVER);
+            while (msp2crsf.FIFOout.size())
+            {
+                uint8_t crsf[64];
+                uint8_t const crsfLen = msp2crsf.FIFOout.pop();
+                msp2crsf.FIFOout.popBytes(crsf, crsfLen);
+                bridge.crsfMspIn(crsf);
+            }
+        }
+    }
+
+    uint32_t latencyMs = 20;
+    uint32_t serviceMs = 2;
+    bool dropReplies = false;
+    std::vector<bytes> requests;
+
+private:
+    typedef struct {
+        uint32_t due;
+        bytes request;
+        std::vector<uint8_t> crsfBytes;
+    } reply_t;
+
+    MSPBRIDGE &bridge;
+    CROSSFIRE2MSP crsf2msp;
+    MSP2CROSSFIRE msp2crsf;
+    std::deque<reply_t> replies;
+    std::vector<uint8_t> requestBytes;
+    uint32_t pendingBytes = 0;
+};
+
+static void *const clientA = (void *)0xA;
+static void *const clientB = (void *)0xB;
+static uint32_t now;
+
+static void run(MSPBRIDGE &bridge, FakeFC &fc, uint32_t ms)
+{
+    for (uint32_t end = now + ms; now != end; now++)
+    {
+        bridge.handle(now);
+        fc.tick(now);
+    }
+}
+
+static void send(MSPBRIDGE &bridge, void *client, const bytes &frame)
+{
+    bridge.clientData(client, frame.data(), frame.size());
+}
+
+static void assertReceived(FakeTransport &transport, void *client, const std::vector<bytes> &frames)
+{
+    bytes expected;
+    for (const bytes &f : frames)
+        expected.insert(expected.end(), f.begin(), f.end());
+    bytes &rx = transport.received[client];
+    TEST_ASSERT_EQUAL(expected.size(), rx.size());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected.data(), rx.data(), expected.size());
+}
+
+void setUp()
+{
+    now = 1000;
+}
+void tearDown() {}
+
+void test_bridge_roundtrip(void)
+{
+    FakeTransport transport;
+    MSPBRIDGE bridge(&transport);
+    FakeFC fc(bridge);
+    TEST_ASSERT_FALSE(bridge.hasClient());
+    bridge.addClient(clientA);
+    TEST_ASSERT_TRUE(bridge.hasClient());
+
+    bytes const v1 = mspV1('<', 1, {});
+    bytes const v2 = mspV2('<', 0x3003, {1, 2, 3});
+    send(bridge, clientA, v1);
+    send(bridge, clientA, v2);
+    run(bridge, fc, 100);
+
+    TEST_ASSERT_EQUAL(2, fc.requests.size());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(v1.data(), fc.requests[0].data(), v1.size());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(v2.data(), fc.requests[1].data(), v2.size());
+    // The 150 byte reply to the odd function is reassembled from three chunks
+    assertReceived(transport, clientA, {replyTo(v1), replyTo(v2)});
+    TEST_ASSERT_EQUAL(0, bridge.repliesCopied);
+}
+
+void test_bridge_stream_framing(void)
+{
+    FakeTransport transport;
+    MSPBRIDGE bridge(&transport);
+    FakeFC fc(bridge);
+    bridge.addClient(clientA);
+
+    bytes const first = mspV2('<', 100, {});
+    bytes const second = mspV1('<', 102, {9, 8, 7});
+    bytes bad = mspV1('<', 104, {});
+    bad.back() ^= 0xFF;
+
+    // Noise, then a frame a byte at a time, then one with a bad checksum and one more in a single read
+    bytes stream = {'x', '$', '$', 'M'};
+    stream.insert(stream.end(), first.begin(), first.end());
+    for (uint8_t b : stream)
+        bridge.clientData(clientA, &b, 1);
+    stream = bad;
+    stream.insert(stream.end(), second.begin(), second.end());
+    send(bridge, clientA, stream);
+    run(bridge, fc, 100);
+
+    TEST_ASSERT_EQUAL(2, fc.requests.size());
+    assertReceived(transport, clientA, {replyTo(first), replyTo(second)});
+}
+
+void test_bridge_clients_get_their_replies(void)
+{
+    FakeTransport transport;
+    MSPBRIDGE bridge(&transport);
+    FakeFC fc(bridge);
+    bridge.addClient(clientA);
+    bridge.addClient(clientB);
+
+    bytes const a = mspV2('<', 101, {});
+    bytes const b = mspV2('<', 102, {});
+    send(bridge, clientA, a);
+    send(bridge, clientB, b);
+    run(bridge, fc, 100);
+
+    assertReceived(transport, clientA, {replyTo(a)});
+    assertReceived(transport, clientB, {replyTo(b)});
+}
+
+void test_bridge_shared_read(void)
+{
+    FakeTransport transport;
+    MSPBRIDGE bridge(&transport);
+    FakeFC fc(bridge);
+    bridge.addClient(clientA);
+    bridge.addClient(clientB);
+
+    // Both poll the same status while the first is in flight
+    bytes const status = mspV2('<', 101, {});
+    send(bridge, clientA, status);
+    run(bridge, fc, 5);
+    send(bridge, clientB, status);
+    run(bridge, fc, 100);
+
+    TEST_ASSERT_EQUAL(1, fc.requests.size());
+    TEST_ASSERT_EQUAL(1, bridge.requestsShared);
+    assertReceived(transport, clientA, {replyTo(status)});
+    assertReceived(transport, clientB, {replyTo(status)});
+
+    // Writes aren't shared
+    bytes const write = mspV2('<', 200, {1});
+    send(bridge, clientA, write);
+    send(bridge, clientB, write);
+    run(bridge, fc, 100);
+    TEST_ASSERT_EQUAL(3, fc.requests.size());
+}
+
+static uint32_t timeToComplete(uint8_t maxInFlight, unsigned count)
+{
+    FakeTransport transport;
+    MSPBRIDGE bridge(&transport, maxInFlight);
+    FakeFC fc(bridge);
+    bridge.addClient(clientA);
+
+    std::vector<bytes> expected;
+    for (unsigned i = 0; i < count; i++)
+    {
+        bytes const request = mspV2('<', 100 + 2 * i, {});
+        send(bridge, clientA, request);
+        expected.push_back(replyTo(request));
+    }
+    uint32_t const start = now;
+    size_t expectedLen = 0;
+    for (const bytes &f : expected)
+        expectedLen += f.size();
+    while (transport.received[clientA].size() < expectedLen && now - start < 10000)
+    {
+        run(bridge, fc, 1);
+    }
+    assertReceived(transport, clientA, expected);
+    return now - start;
+}
+
+// The configurator reads many things at once, waiting for each reply in turn is slow
+void test_bridge_pipelining(void)
+{
+    const unsigned count = 16;
+    uint32_t const lockstep = timeToComplete(1, count);
+    uint32_t const pipelined = timeToComplete(MSPBRIDGE_MAX_IN_FLIGHT, count);
+    printf("%u requests: lockstep %ums, pipelined %ums\n", count, lockstep, pipelined);
+    TEST_ASSERT_LESS_THAN(lockstep / 2, pipelined);
+}
+
+// Requests are held back so the FC never has more than its buffer's worth waiting
+void test_bridge_in_flight_budget(void)
+{
+    FakeTransport transport;
+    MSPBRIDGE bridge(&transport);
+    FakeFC fc(bridge);
+    bridge.addClient(clientA);
+
+    std::vector<bytes> expected;
+    for (unsigned i = 0; i < 4; i++)
+    {
+        bytes const request = mspV2('<', 300 + 2 * i, bytes(60, i));
+        send(bridge, clientA, request);
+        expected.push_back(replyTo(request));
+    }
+    run(bridge, fc, 300);
+    TEST_ASSERT_EQUAL(4, fc.requests.size());
+    assertReceived(transport, clientA, expected);
+}
+
+void test_bridge_timeout(void)
+{
+    FakeTransport transport;
+    MSPBRIDGE bridge(&transport, 1);
+    FakeFC fc(bridge);
+    bridge.addClient(clientA);
+
+    fc.dropReplies = true;
+    send(bridge, clientA, mspV2('<', 100, {}));
+    bytes const next = mspV2('<', 102, {});
+    send(bridge, clientA, next);
+    run(bridge, fc, MSPBRIDGE_REQUEST_TIMEOUT_MS / 2);
+    TEST_ASSERT_EQUAL(1, fc.requests.size());
+
+    // The slot frees up once the first has had no reply for the timeout
+    fc.dropReplies = false;
+    run(bridge, fc, MSPBRIDGE_REQUEST_TIMEOUT_MS + 50);
+    TEST_ASSERT_EQUAL(1, bridge.requestsExpired);
+    TEST_ASSERT_EQUAL(2, fc.requests.size());
+    assertReceived(transport, clientA, {replyTo(next)});
+}
+
+void test_bridge_disconnect(void)
+{
+    FakeTransport transport;
+    MSPBRIDGE bridge(&transport);
+    FakeFC fc(bridge);
+    bridge.addClient(clientA);
+
+    // A disconnects with one request in flight and another queued
+    send(bridge, clientA, mspV2('<', 101, {}));
+    run(bridge, fc, 1);
+    send(bridge, clientA, mspV2('<', 103, {}));
+    bridge.removeClient(clientA);
+    TEST_ASSERT_FALSE(bridge.hasClient());
+
+    // B takes the same slot and doesn't get A's replies
+    bridge.addClient(clientB);
+    bytes const b = mspV2('<', 102, {});
+    send(bridge, clientB, b);
+    run(bridge, fc, 100);
+    TEST_ASSERT_EQUAL(2, fc.requests.size());
+    TEST_ASSERT_EQUAL(0, transport.received[clientA].size());
+    assertReceived(transport, clientB, {replyTo(b)});
+
+    TEST_ASSERT_TRUE(bridge.addClient(clientA));
+    TEST_ASSERT_TRUE(bridge.addClient((void *)0xC));
+    TEST_ASSERT_FALSE(bridge.addClient((void *)0xD));
+}
+
+void test_bridge_backpressure(void)
+{
+    FakeTransport transport;
+    MSPBRIDGE bridge(&transport);
+    FakeFC fc(bridge);
+    bridge.addClient(clientA);
+
+    // The socket is full, the replies are kept until it can take them, in order
+    transport.spaceFor[clientA] = 0;
+    bytes const first = mspV2('<', 101, {});
+    bytes const second = mspV2('<', 102, {});
+    send(bridge, clientA, first);
+    send(bridge, clientA, second);
+    run(bridge, fc, 100);
+    TEST_ASSERT_EQUAL(0, transport.received[clientA].size());
+    TEST_ASSERT_EQUAL(2, bridge.repliesCopied);
+
+    transport.spaceFor[clientA] = 4096;
+    run(bridge, fc, 1);
+    assertReceived(transport, clientA, {replyTo(first), replyTo(second)});
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_bridge_roundtrip);
+    RUN_TEST(test_bridge_stream_framing);
+    RUN_TEST(test_bridge_clients_get_their_replies);
+    RUN_TEST(test_bridge_shared_read);
+    RUN_TEST(test_bridge_pipelining);
+    RUN_TEST(test_bridge_in_flight_budget);
+    RUN_TEST(test_bridge_timeout);
+    RUN_TEST(test_bridge_disconnect);
+    RUN_TEST(test_bridge_backpressure);
+    UNITY_END();
+
+    return 0;
+}
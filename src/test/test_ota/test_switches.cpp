@@ -648,6 +648,243 @@ void test_decodingHybridWide_AUXX_low()
         test_decodingHybridWide(false, i, 0, CRSF_CHANNEL_VALUE_1000);
 }
 
+void test_schemaMatchesBitfields()
+{
+    // Set each schema field to all ones in an empty packet and check only that
+    // member of the rc bitfield struct is set
+    OTA_Packet_s otaPkt;
+    uint8_t * const buf = (uint8_t *)&otaPkt;
+
+    memset(&otaPkt, 0, sizeof(otaPkt));
+    OtaRcSchemaStd::type::set(buf, 0xff);
+    TEST_ASSERT_EQUAL(0b11, otaPkt.std.type);
+    TEST_ASSERT_EQUAL(0, otaPkt.std.crcHigh);
+    TEST_ASSERT_EQUAL(0, otaPkt.std.rc.switches);
+
+    memset(&otaPkt, 0, sizeof(otaPkt));
+    OtaRcSchemaStd::switches::set(buf, 0xff);
+    TEST_ASSERT_EQUAL(0b1111111, otaPkt.std.rc.switches);
+    TEST_ASSERT_EQUAL(0, otaPkt.std.rc.isArmed);
+    TEST_ASSERT_EQUAL(0, otaPkt.std.crcLow);
+
+    memset(&otaPkt, 0, sizeof(otaPkt));
+    OtaRcSchemaStd::isArmed::set(buf, 0xff);
+    TEST_ASSERT_EQUAL(1, otaPkt.std.rc.isArmed);
+    TEST_ASSERT_EQUAL(0, otaPkt.std.rc.switches);
+    TEST_ASSERT_EQUAL(0, otaPkt.std.crcLow);
+
+    memset(&otaPkt, 0, sizeof(otaPkt));
+    OtaRcSchemaFull::telemetryStatus::set(buf, 0xff);
+    TEST_ASSERT_EQUAL(1, otaPkt.full.rc.telemetryStatus);
+    TEST_ASSERT_EQUAL(0b00000100, buf[0]);
+
+    memset(&otaPkt, 0, sizeof(otaPkt));
+    OtaRcSchemaFull::uplinkPower::set(buf, 0xff);
+    TEST_ASSERT_EQUAL(0b111, otaPkt.full.rc.uplinkPower);
+    TEST_ASSERT_EQUAL(0b00111000, buf[0]);
+
+    memset(&otaPkt, 0, sizeof(otaPkt));
+    OtaRcSchemaFull::isHighAux::set(buf, 0xff);
+    TEST_ASSERT_EQUAL(1, otaPkt.full.rc.isHighAux);
+    TEST_ASSERT_EQUAL(0b01000000, buf[0]);
+
+    memset(&otaPkt, 0, sizeof(otaPkt));
+    OtaRcSchemaFull::isArmed::set(buf, 0xff);
+    TEST_ASSERT_EQUAL(1, otaPkt.full.rc.isArmed);
+    TEST_ASSERT_EQUAL(0b10000000, buf[0]);
+
+    // Fields must not disturb their neighbors when set in any order
+    memset(&otaPkt, 0xff, sizeof(otaPkt));
+    OtaRcSchemaFull::uplinkPower::set(buf, 0b010);
+    TEST_ASSERT_EQUAL(0b11010111, buf[0]);
+    TEST_ASSERT_EQUAL(0b010, OtaRcSchemaFull::uplinkPower::get(buf));
+
+    // A channel straddling bytes 6 and 7 of the 4x10 block
+    memset(&otaPkt, 0, sizeof(otaPkt));
+    OtaRcSchemaFull::chHigh::Channel<1>::set(buf, 0x3ff);
+    TEST_ASSERT_EQUAL(0b11111100, otaPkt.full.rc.chHigh.raw[1]);
+    TEST_ASSERT_EQUAL(0b00001111, otaPkt.full.rc.chHigh.raw[2]);
+    TEST_ASSERT_EQUAL(0x3ff, OtaRcSchemaFull::chHigh::Channel<1>::get(buf));
+    TEST_ASSERT_EQUAL(0, OtaRcSchemaFull::chHigh::Channel<0>::get(buf));
+    TEST_ASSERT_EQUAL(0, OtaRcSchemaFull::chHigh::Channel<2>::get(buf));
+}
+
+static void repairPacketCrc(uint8_t packetSize)
+{
+    OtaUpdateSerializers(smWideOr8ch, packetSize);
+    OtaCrcInitializer = 0x1234;
+    OtaRepairSnrMin = 0;
+
+    uint8_t original[OTA8_PACKET_SIZE];
+    OTA_Packet_s * const otaPktOrig = (OTA_Packet_s *)original;
+    for (unsigned i = 0; i < sizeof(original); ++i)
+        original[i] = i * 37 + 11;
+    // The std CRC is generated over the crcHigh bits, which the TX always has zeroed
+    original[0] = PACKET_TYPE_DATA;
+    OtaGeneratePacketCrc(otaPktOrig);
+    TEST_ASSERT_TRUE(OtaValidatePacketCrc(otaPktOrig));
+
+    uint8_t pkt[OTA8_PACKET_SIZE];
+    OTA_Packet_s * const otaPktPtr = (OTA_Packet_s *)pkt;
+    const unsigned bitCnt = packetSize * 8;
+
+    // Every single bit error, including in the CRC, is corrected
+    for (unsigned bit = 0; bit < bitCnt; ++bit)
+    {
+        memcpy(pkt, original, sizeof(pkt));
+        pkt[bit / 8] ^= 1 << (bit % 8);
+        TEST_ASSERT_FALSE(OtaValidatePacketCrc(otaPktPtr));
+        TEST_ASSERT_TRUE(OtaRepairPacketCrc(otaPktPtr, 0));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(original, pkt, packetSize);
+        TEST_ASSERT_TRUE(OtaValidatePacketCrc(otaPktPtr));
+    }
+
+    // Double bit errors are never turned into a packet which passes the CRC
+    unsigned miscorrected = 0;
+    for (unsigned bit1 = 0; bit1 < bitCnt; ++bit1)
+    {
+        for (unsigned bit2 = bit1 + 1; bit2 < bitCnt; ++bit2)
+        {
+            memcpy(pkt, original, sizeof(pkt));
+            pkt[bit1 / 8] ^= 1 << (bit1 % 8);
+            pkt[bit2 / 8] ^= 1 << (bit2 % 8);
+            if (OtaRepairPacketCrc(otaPktPtr, 0))
+                ++miscorrected;
+        }
+    }
+    printf("%u-byte packet double bit errors miscorrected: %u\n", packetSize, miscorrected);
+    TEST_ASSERT_EQUAL(0, miscorrected);
+}
+
+void test_repairPacketCrcStd()
+{
+    repairPacketCrc(OTA4_PACKET_SIZE);
+}
+
+void test_repairPacketCrcFull()
+{
+    repairPacketCrc(OTA8_PACKET_SIZE);
+}
+
+void test_repairPacketCrcSnrLimit()
+{
+    OtaUpdateSerializers(smWideOr8ch, OTA8_PACKET_SIZE);
+    uint8_t pkt[OTA8_PACKET_SIZE] = {PACKET_TYPE_DATA};
+    OTA_Packet_s * const otaPktPtr = (OTA_Packet_s *)pkt;
+    OtaGeneratePacketCrc(otaPktPtr);
+    pkt[3] ^= 0x10;
+
+    // Too noisy to trust the repair
+    OtaRepairSnrMin = -8;
+    TEST_ASSERT_FALSE(OtaRepairPacketCrc(otaPktPtr, -9));
+    TEST_ASSERT_EQUAL(0x10, pkt[3]);
+    // Or no SNR to go on
+    OtaRepairSnrMin = DYNPOWER_SNR_THRESH_NONE;
+    TEST_ASSERT_FALSE(OtaRepairPacketCrc(otaPktPtr, 20));
+    TEST_ASSERT_EQUAL(0x10, pkt[3]);
+
+    OtaRepairSnrMin = -8;
+    TEST_ASSERT_TRUE(OtaRepairPacketCrc(otaPktPtr, -8));
+    TEST_ASSERT_EQUAL(0, pkt[3]);
+}
+
+// Only DATA packets are repaired, and a packet which is not is left as it was received
+void test_repairPacketCrcDataOnly()
+{
+    OtaUpdateSerializers(smWideOr8ch, OTA4_PACKET_SIZE);
+    OtaRepairSnrMin = 0;
+
+    uint8_t types[] = {PACKET_TYPE_RCDATA, PACKET_TYPE_SYNC};
+    for (unsigned t = 0; t < sizeof(types); ++t)
+    {
+        // Sized as an OTA_Packet_s, only the first OTA4_PACKET_SIZE bytes are used
+        uint8_t pkt[OTA8_PACKET_SIZE] = {types[t], 0x55, 0xaa};
+        OTA_Packet_s * const otaPktPtr = (OTA_Packet_s *)pkt;
+        OtaGeneratePacketCrc(otaPktPtr);
+        pkt[2] ^= 0x08;
+        uint8_t received[OTA4_PACKET_SIZE];
+        memcpy(received, pkt, sizeof(received));
+
+        TEST_ASSERT_FALSE(OtaRepairPacketCrc(otaPktPtr, 0));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(received, pkt, sizeof(received));
+    }
+
+    // A DATA packet whose error is in the type bits is repaired back to DATA
+    uint8_t pkt[OTA8_PACKET_SIZE] = {PACKET_TYPE_DATA, 0x55, 0xaa};
+    OTA_Packet_s * const otaPktPtr = (OTA_Packet_s *)pkt;
+    OtaGeneratePacketCrc(otaPktPtr);
+    pkt[0] ^= PACKET_TYPE_DATA;
+    TEST_ASSERT_TRUE(OtaRepairPacketCrc(otaPktPtr, 0));
+    TEST_ASSERT_EQUAL(PACKET_TYPE_DATA, otaPktPtr->std.type);
+}
+
+// A staged packet packed again with newer channels carries the same switch or aux channels,
+// the next only moves on once it is committed
+void test_prepareChannelData()
+{
+    uint8_t first[OTA4_PACKET_SIZE] = {0};
+    uint8_t repacked[OTA4_PACKET_SIZE] = {0};
+    uint8_t next[OTA4_PACKET_SIZE] = {0};
+    for (int i = 0; i < 16; i++)
+        ChannelData[i] = CRSF_CHANNEL_VALUE_MID;
+
+    OtaUpdateSerializers(smHybridOr16ch, OTA4_PACKET_SIZE);
+    OtaSetHybrid8NextSwitchIndex(2);
+    OtaPrepareChannelData((OTA_Packet_s *)first, ChannelData, false, 0, OtaNonce);
+    ChannelData[0] = CRSF_CHANNEL_VALUE_2000;
+    OtaPrepareChannelData((OTA_Packet_s *)repacked, ChannelData, false, 0, OtaNonce);
+    OtaCommitChannelData();
+    OtaPackChannelData((OTA_Packet_s *)next, ChannelData, false, 0);
+
+    // Same switch index, newer CH1
+    TEST_ASSERT_EQUAL(2, (first[6] >> 3) & 0b111);
+    TEST_ASSERT_EQUAL(2, (repacked[6] >> 3) & 0b111);
+    TEST_ASSERT_EQUAL(3, (next[6] >> 3) & 0b111);
+    TEST_ASSERT_NOT_EQUAL(first[1], repacked[1]);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(&repacked[1], &next[1], 5);
+
+    // Full res 16ch alternates the aux channels on every pack
+    uint8_t full[OTA8_PACKET_SIZE] = {0};
+    OtaUpdateSerializers(smHybridOr16ch, OTA8_PACKET_SIZE);
+    OtaSetFullResNextChannelSet(true);
+    OtaPrepareChannelData((OTA_Packet_s *)full, ChannelData, false, 0, OtaNonce);
+    TEST_ASSERT_TRUE(OtaRcSchemaFull::isHighAux::get(full));
+    OtaPrepareChannelData((OTA_Packet_s *)full, ChannelData, false, 0, OtaNonce);
+    TEST_ASSERT_TRUE(OtaRcSchemaFull::isHighAux::get(full));
+    OtaCommitChannelData();
+    OtaPackChannelData((OTA_Packet_s *)full, ChannelData, false, 0);
+    TEST_ASSERT_FALSE(OtaRcSchemaFull::isHighAux::get(full));
+    OtaPackChannelData((OTA_Packet_s *)full, ChannelData, false, 0);
+    TEST_ASSERT_TRUE(OtaRcSchemaFull::isHighAux::get(full));
+}
+
+// Preparing a packet for a later nonce must match packing it once OtaNonce gets there,
+// without OtaNonce being touched
+void test_prepareChannelDataNonce()
+{
+    uint8_t staged[OTA4_PACKET_SIZE] = {0};
+    uint8_t packed[OTA4_PACKET_SIZE] = {0};
+    for (int i = 0; i < 16; i++)
+        ChannelData[i] = CRSF_CHANNEL_VALUE_MID;
+
+    OtaUpdateSerializers(smWideOr8ch, OTA4_PACKET_SIZE);
+    OtaNonce = 6;
+    OtaPrepareChannelData((OTA_Packet_s *)staged, ChannelData, false, 0, OtaNonce + 1);
+    OtaGenerateRCdataPacketCrc((OTA_Packet_s *)staged, OtaNonce + 1);
+    TEST_ASSERT_EQUAL(6, OtaNonce);
+
+    OtaNonce = 7;
+    OtaPackChannelData((OTA_Packet_s *)packed, ChannelData, false, 0);
+    OtaGeneratePacketCrc((OTA_Packet_s *)packed);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(packed, staged, sizeof(staged));
+
+    // and differ from the packet for the current nonce, which carries a different switch
+    uint8_t current[OTA4_PACKET_SIZE] = {0};
+    OtaNonce = 6;
+    OtaPrepareChannelData((OTA_Packet_s *)current, ChannelData, false, 0, OtaNonce);
+    TEST_ASSERT_NOT_EQUAL(staged[6], current[6]);
+}
+
 // Unity setup/teardown
 void setUp() {}
 void tearDown() {}
@@ -677,6 +914,16 @@ int main(int argc, char **argv)
     RUN_TEST(test_encodingFullres12ch);
     RUN_TEST(test_decodingFullres16chLow);
 
+    RUN_TEST(test_schemaMatchesBitfields);
+
+    RUN_TEST(test_repairPacketCrcStd);
+    RUN_TEST(test_repairPacketCrcFull);
+    RUN_TEST(test_repairPacketCrcSnrLimit);
+    RUN_TEST(test_repairPacketCrcDataOnly);
+
+    RUN_TEST(test_prepareChannelData);
+    RUN_TEST(test_prepareChannelDataNonce);
+
     UNITY_END();
 
     return 0;
@@ -0,0 +1,185 @@
+#include <cstdint>
+#include <cmath>
+#include <unity.h>
+#include "PLL.h"
+
+// Same units as the RX hwTimer
+#define TICKS_PER_US 5
+
+/**
+ * Run the PLL against a TX sending every intervalUs and an RX timer whose
+ * clock is off by ppm. Every lossEvery'th packet is lost (0 for none).
+ * Returns the number of updates until the PLL locked, or 0 if it didn't,
+ * and the final phase error and FreqOffset in the out params.
+ */
+static unsigned simulate(PLL &pll, uint32_t intervalUs, double ppm, double initialPhaseUs, unsigned lossEvery,
+    unsigned packets, int32_t *finalPhaseErr, int32_t *finalFreqOffset)
+{
+    pll.setInterval(intervalUs);
+    double rxTock = initialPhaseUs;
+    unsigned lockedAt = 0;
+    int32_t freqOffset = 0;
+    double phaseErr = 0;
+
+    for (unsigned k = 1; k <= packets; ++k)
+    {
+        // RX timer period in the RX clock, both halves get the FreqOffset
+        double rxInterval = intervalUs + 2.0 * freqOffset / TICKS_PER_US;
+        rxTock += rxInterval * (1.0 + ppm / 1e6);
+        double txTime = (double)k * intervalUs;
+
+        phaseErr = txTime - rxTock;
+        if (lossEvery && (k % lossEvery) == 0)
+        {
+            pll.missed();
+            continue;
+        }
+
+        pll.update((int32_t)lround(phaseErr));
+        rxTock += pll.getPhaseShift();
+        freqOffset = pll.getFreqOffset();
+        if (!lockedAt && pll.isLocked())
+            lockedAt = k;
+    }
+
+    *finalPhaseErr = (int32_t)lround(phaseErr);
+    *finalFreqOffset = freqOffset;
+    return lockedAt;
+}
+
+void test_pll_no_drift(void)
+{
+    PLL pll(TICKS_PER_US * 256 / 2);
+    int32_t phaseErr;
+    int32_t freqOffset;
+
+    unsigned lockedAt = simulate(pll, 4000, 0, 500, 0, 200, &phaseErr, &freqOffset);
+    TEST_ASSERT_NOT_EQUAL(0, lockedAt);
+    TEST_ASSERT_LESS_OR_EQUAL(40, lockedAt);
+    TEST_ASSERT_EQUAL(0, freqOffset);
+    TEST_ASSERT_INT32_WITHIN(2, 0, phaseErr);
+}
+
+void test_pll_drift(void)
+{
+    const uint32_t intervals[] = { 1000, 4000, 20000 };
+    const double ppms[] = { -100, -30, 30, 100 };
+
+    for (unsigned i = 0; i < sizeof(intervals) / sizeof(intervals[0]); ++i)
+    {
+        for (unsigned p = 0; p < sizeof(ppms) / sizeof(ppms[0]); ++p)
+        {
+            PLL pll(TICKS_PER_US * 256 / 2);
+            int32_t phaseErr;
+            int32_t freqOffset;
+
+            unsigned lockedAt = simulate(pll, intervals[i], ppms[p], -(double)intervals[i] / 4, 0, 500, &phaseErr, &freqOffset);
+            printf("interval %uus %+dppm: locked after %u, phase %dus, FreqOffset %d\n",
+                intervals[i], (int)ppms[p], lockedAt, phaseErr, freqOffset);
+
+            // Locks in a bounded number of packets regardless of the rate
+            TEST_ASSERT_NOT_EQUAL(0, lockedAt);
+            TEST_ASSERT_LESS_OR_EQUAL(40, lockedAt);
+            TEST_ASSERT_INT32_WITHIN(3, 0, phaseErr);
+            // RX clock fast (ppm < 0) must lengthen the RX timer interval, to within one FreqOffset step
+            double expected = -ppms[p] * intervals[i] / 1e6 * TICKS_PER_US / 2;
+            TEST_ASSERT_INT32_WITHIN(1, (int32_t)lround(expected), freqOffset);
+        }
+    }
+}
+
+void test_pll_packet_loss(void)
+{
+    PLL pll(TICKS_PER_US * 256 / 2);
+    int32_t phaseErr;
+    int32_t freqOffset;
+
+    // Every third packet lost, the frequency estimate must still be per interval
+    unsigned lockedAt = simulate(pll, 4000, 80, 800, 3, 600, &phaseErr, &freqOffset);
+    TEST_ASSERT_NOT_EQUAL(0, lockedAt);
+    TEST_ASSERT_LESS_OR_EQUAL(60, lockedAt);
+    TEST_ASSERT_INT32_WITHIN(1, (int32_t)lround(-80 * 4000 / 1e6 * TICKS_PER_US / 2), freqOffset);
+    TEST_ASSERT_INT32_WITHIN(3, 0, phaseErr);
+}
+
+void test_pll_reset(void)
+{
+    PLL pll(TICKS_PER_US * 256 / 2);
+    int32_t phaseErr;
+    int32_t freqOffset;
+
+    simulate(pll, 4000, 100, 0, 0, 200, &phaseErr, &freqOffset);
+    TEST_ASSERT_TRUE(pll.isLocked());
+    TEST_ASSERT_TRUE(pll.isSettled());
+    TEST_ASSERT_NOT_EQUAL(0, pll.getFreqOffset());
+
+    pll.reset();
+    TEST_ASSERT_FALSE(pll.isLocked());
+    TEST_ASSERT_EQUAL(0, pll.getFreqOffset());
+    TEST_ASSERT_EQUAL(0, pll.getPhaseShift());
+    TEST_ASSERT_EQUAL(0, pll.getPhaseError());
+}
+
+void test_pll_outlier_rejected(void)
+{
+    PLL pll(TICKS_PER_US * 256 / 2);
+    int32_t phaseErr;
+    int32_t freqOffset;
+
+    simulate(pll, 4000, 50, 0, 0, 200, &phaseErr, &freqOffset);
+    TEST_ASSERT_TRUE(pll.isLocked());
+    int32_t const freqQ8 = pll.getFreqEstimateQ8();
+
+    // A packet timestamped way off does not move the timer
+    pll.update(1500);
+    TEST_ASSERT_TRUE(pll.isLocked());
+    TEST_ASSERT_EQUAL(freqQ8, pll.getFreqEstimateQ8());
+    TEST_ASSERT_EQUAL(0, pll.getPhaseShift());
+    pll.update(phaseErr);
+    TEST_ASSERT_TRUE(pll.isLocked());
+
+    // But one that keeps being off is the TX moving, so it starts acquiring again
+    for (unsigned i = 0; i < PLL_UNLOCK_UPDATES; ++i)
+        pll.update(-800);
+    TEST_ASSERT_FALSE(pll.isLocked());
+    TEST_ASSERT_NOT_EQUAL(0, pll.getPhaseShift());
+}
+
+void test_pll_freq_limit(void)
+{
+    PLL pll(TICKS_PER_US * 256 / 2);
+    int32_t phaseErr;
+    int32_t freqOffset;
+
+    // Further off than any crystal, the correction stops at PLL_MAX_PPM
+    simulate(pll, 20000, 1000, 5000, 0, 500, &phaseErr, &freqOffset);
+    int32_t const maxOffset = (int32_t)lround(PLL_MAX_PPM * 20000 / 1e6 * TICKS_PER_US / 2);
+    TEST_ASSERT_INT32_WITHIN(1, -maxOffset, freqOffset);
+
+    // A huge error can not overflow the offset, and nothing is corrected without an interval
+    PLL unset(TICKS_PER_US * 256 / 2);
+    unset.update(INT32_MAX / 256);
+    TEST_ASSERT_EQUAL(0, unset.getFreqOffset());
+    unset.setInterval(20000);
+    for (unsigned i = 0; i < 10; ++i)
+        unset.update(INT32_MAX / 256);
+    TEST_ASSERT_INT32_WITHIN(1, maxOffset, unset.getFreqOffset());
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_pll_no_drift);
+    RUN_TEST(test_pll_drift);
+    RUN_TEST(test_pll_packet_loss);
+    RUN_TEST(test_pll_reset);
+    RUN_TEST(test_pll_outlier_rejected);
+    RUN_TEST(test_pll_freq_limit);
+    UNITY_END();
+
+    return 0;
+}
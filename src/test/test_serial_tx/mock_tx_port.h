@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include "SerialTxPort.h"
+
+// Host backend for SerialTxPort, keeps every frame sent so the tests can check them
+class MockTxPort : public SerialTxPort
+{
+public:
+    MockTxPort() : SerialTxPort(nullptr), sends(0), bytes(0), keep(true) {}
+
+    void send(uint8_t len) override
+    {
+        if (keep)
+        {
+            sent.assign((const char *)_buffer, len);
+        }
+        ++sends;
+        bytes += len;
+    }
+
+    std::string sent;
+    unsigned sends;
+    unsigned bytes;
+    // Only count the frames when benchmarking
+    bool keep;
+};
+
+// The Stream the protocols wrote to before, to compare against
+class CaptureStream : public Stream
+{
+public:
+    int available() { return 0; }
+    int read() { return -1; }
+    int peek() { return -1; }
+    void flush() {}
+
+    CaptureStream() : writes(0), bytes(0), keep(true) {}
+
+    size_t write(uint8_t c)
+    {
+        return write(&c, 1);
+    }
+    size_t write(const uint8_t *c, size_t l)
+    {
+        if (keep)
+        {
+            buf.append((const char *)c, l);
+        }
+        ++writes;
+        bytes += l;
+        return l;
+    }
+
+    std::string buf;
+    unsigned writes;
+    unsigned bytes;
+    bool keep;
+};
@@ -0,0 +1,232 @@
+#include <cstdint>
+#include <chrono>
+#include <unity.h>
+
+#include "targets.h"
+#include "crsf_protocol.h"
+#include "crc.h"
+#include "RCFrames.h"
+#include "mock_tx_port.h"
+
+static GENERIC_CRC8 crsf_crc(CRSF_CRC_POLY);
+static Crc2Byte crc2Byte;
+static uint32_t channels[16];
+
+static void fillChannels(uint32_t seed)
+{
+    for (unsigned ch = 0; ch < 16; ++ch)
+    {
+        channels[ch] = CRSF_CHANNEL_VALUE_MIN + (seed * 131 + ch * 97) % (CRSF_CHANNEL_VALUE_MAX - CRSF_CHANNEL_VALUE_MIN + 1);
+    }
+}
+
+static void packLegacy(crsf_channels_s &packed, const uint32_t *channelData)
+{
+    packed.ch0 = channelData[0];
+    packed.ch1 = channelData[1];
+    packed.ch2 = channelData[2];
+    packed.ch3 = channelData[3];
+    packed.ch4 = channelData[4];
+    packed.ch5 = channelData[5];
+    packed.ch6 = channelData[6];
+    packed.ch7 = channelData[7];
+    packed.ch8 = channelData[8];
+    packed.ch9 = channelData[9];
+    packed.ch10 = channelData[10];
+    packed.ch11 = channelData[11];
+    packed.ch12 = channelData[12];
+    packed.ch13 = channelData[13];
+    packed.ch14 = channelData[14];
+    packed.ch15 = channelData[15];
+}
+
+// The Stream based senders the RCFrames renderers replace
+static void sendCrsfLegacy(Stream *out, const uint32_t *channelData)
+{
+    crsf_channels_s PackedRCdataOut;
+    packLegacy(PackedRCdataOut, channelData);
+
+    constexpr uint8_t outBuffer[] = {
+        CRSF_ADDRESS_FLIGHT_CONTROLLER,
+        CRSF_FRAME_SIZE(sizeof(PackedRCdataOut)),
+        CRSF_FRAMETYPE_RC_CHANNELS_PACKED
+    };
+
+    uint8_t crc = crsf_crc.calc(outBuffer[2]);
+    crc = crsf_crc.calc((byte *)&PackedRCdataOut, sizeof(PackedRCdataOut), crc);
+
+    out->write(outBuffer, sizeof(outBuffer));
+    out->write((byte *)&PackedRCdataOut, sizeof(PackedRCdataOut));
+    out->write(crc);
+}
+
+static void sendSbusLegacy(Stream *out, const uint32_t *channelData, uint8_t extraData)
+{
+    crsf_channels_s PackedRCdataOut;
+    packLegacy(PackedRCdataOut, channelData);
+
+    out->write(0x0F);
+    out->write((byte *)&PackedRCdataOut, sizeof(PackedRCdataOut));
+    out->write((uint8_t)extraData);
+    out->write((uint8_t)0x00);
+}
+
+static void sendSumdLegacy(Stream *out, const uint32_t *channelData)
+{
+    static const uint8_t order[16] = { 0, 1, 2, 3, 7, 5, 6, 4, 8, 9, 10, 11, 12, 13, 14, 15 };
+    uint8_t outBuffer[RCFRAMES_SUMD_LEN];
+    outBuffer[0] = 0xA8;
+    outBuffer[1] = 0x01;
+    outBuffer[2] = 0x10;
+    for (unsigned i = 0; i < 16; ++i)
+    {
+        uint16_t us = (CRSF_to_US(channelData[order[i]]) << 3);
+        outBuffer[3 + i * 2] = us >> 8;
+        outBuffer[4 + i * 2] = us & 0x00ff;
+    }
+    uint16_t crc = crc2Byte.calc(outBuffer, RCFRAMES_SUMD_LEN - 2, 0);
+    outBuffer[35] = (uint8_t)(crc >> 8);
+    outBuffer[36] = (uint8_t)(crc & 0x00ff);
+    out->write(outBuffer, sizeof(outBuffer));
+}
+
+void test_serial_tx_crsf(void)
+{
+    for (uint32_t seed = 0; seed < 100; ++seed)
+    {
+        MockTxPort port;
+        CaptureStream legacy;
+        fillChannels(seed);
+
+        port.send(RCFrames::crsf(port.buffer(), channels));
+        sendCrsfLegacy(&legacy, channels);
+
+        TEST_ASSERT_EQUAL(1, port.sends);
+        TEST_ASSERT_EQUAL(RCFRAMES_CRSF_LEN, port.sent.size());
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(legacy.buf.data(), port.sent.data(), RCFRAMES_CRSF_LEN);
+        // CRC over the type and payload includes the CRC itself to 0
+        TEST_ASSERT_EQUAL(0, crsf_crc.calc((const uint8_t *)port.sent.data() + 2, RCFRAMES_CRSF_LEN - 2));
+    }
+}
+
+void test_serial_tx_sbus(void)
+{
+    for (uint32_t seed = 0; seed < 100; ++seed)
+    {
+        MockTxPort port;
+        CaptureStream legacy;
+        fillChannels(seed);
+        uint8_t const flags = seed & 0x0C;
+
+        port.send(RCFrames::sbus(port.buffer(), channels, flags));
+        sendSbusLegacy(&legacy, channels, flags);
+
+        TEST_ASSERT_EQUAL(RCFRAMES_SBUS_LEN, port.sent.size());
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(legacy.buf.data(), port.sent.data(), RCFRAMES_SBUS_LEN);
+    }
+}
+
+void test_serial_tx_sumd(void)
+{
+    for (uint32_t seed = 0; seed < 100; ++seed)
+    {
+        MockTxPort port;
+        CaptureStream legacy;
+        fillChannels(seed);
+
+        port.send(RCFrames::sumd(port.buffer(), channels, crc2Byte));
+        sendSumdLegacy(&legacy, channels);
+
+        TEST_ASSERT_EQUAL(RCFRAMES_SUMD_LEN, port.sent.size());
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(legacy.buf.data(), port.sent.data(), RCFRAMES_SUMD_LEN);
+    }
+}
+
+typedef std::chrono::steady_clock benchClock;
+
+static double nsPerFrame(benchClock::time_point start, unsigned frames)
+{
+    return std::chrono::duration<double, std::nano>(benchClock::now() - start).count() / frames;
+}
+
+// Per protocol frame build time through the Stream versus rendering into the port
+void test_serial_tx_benchmark(void)
+{
+    const unsigned FRAMES = 200000;
+    MockTxPort port;
+    CaptureStream legacy;
+    port.keep = false;
+    legacy.keep = false;
+
+    benchClock::time_point start = benchClock::now();
+    for (unsigned i = 0; i < FRAMES; ++i)
+    {
+        channels[i & 15] = i & 0x7ff;
+        sendCrsfLegacy(&legacy, channels);
+    }
+    double const crsfLegacy = nsPerFrame(start, FRAMES);
+    start = benchClock::now();
+    for (unsigned i = 0; i < FRAMES; ++i)
+    {
+        channels[i & 15] = i & 0x7ff;
+        port.send(RCFrames::crsf(port.buffer(), channels));
+    }
+    double const crsfPort = nsPerFrame(start, FRAMES);
+
+    start = benchClock::now();
+    for (unsigned i = 0; i < FRAMES; ++i)
+    {
+        channels[i & 15] = i & 0x7ff;
+        sendSbusLegacy(&legacy, channels, i & 0x0C);
+    }
+    double const sbusLegacy = nsPerFrame(start, FRAMES);
+    start = benchClock::now();
+    for (unsigned i = 0; i < FRAMES; ++i)
+    {
+        channels[i & 15] = i & 0x7ff;
+        port.send(RCFrames::sbus(port.buffer(), channels, i & 0x0C));
+    }
+    double const sbusPort = nsPerFrame(start, FRAMES);
+
+    start = benchClock::now();
+    for (unsigned i = 0; i < FRAMES; ++i)
+    {
+        channels[i & 15] = CRSF_CHANNEL_VALUE_MIN + (i & 0x3ff);
+        sendSumdLegacy(&legacy, channels);
+    }
+    double const sumdLegacy = nsPerFrame(start, FRAMES);
+    start = benchClock::now();
+    for (unsigned i = 0; i < FRAMES; ++i)
+    {
+        channels[i & 15] = CRSF_CHANNEL_VALUE_MIN + (i & 0x3ff);
+        port.send(RCFrames::sumd(port.buffer(), channels, crc2Byte));
+    }
+    double const sumdPort = nsPerFrame(start, FRAMES);
+
+    printf("frame build ns/frame (Stream -> port): CRSF %.1f -> %.1f, SBUS %.1f -> %.1f, SUMD %.1f -> %.1f\n",
+        crsfLegacy, crsfPort, sbusLegacy, sbusPort, sumdLegacy, sumdPort);
+    printf("Stream writes per frame: %.1f, port sends per frame: %.1f\n",
+        (double)legacy.writes / (3 * FRAMES), (double)port.sends / (3 * FRAMES));
+
+    // Every frame goes out in exactly one send, and the same bytes as through the Stream
+    TEST_ASSERT_EQUAL(3 * FRAMES, port.sends);
+    TEST_ASSERT_EQUAL(legacy.bytes, port.bytes);
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    crc2Byte.init(16, 0x1021);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_serial_tx_crsf);
+    RUN_TEST(test_serial_tx_sbus);
+    RUN_TEST(test_serial_tx_sumd);
+    RUN_TEST(test_serial_tx_benchmark);
+    UNITY_END();
+
+    return 0;
+}
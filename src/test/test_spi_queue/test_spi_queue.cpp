@@ -0,0 +1,421 @@
+#include <cstdint>
+#include <vector>
+#include <unity.h>
+
+#include "SPIQueue.h"
+
+typedef std::vector<uint8_t> bytes;
+
+// Records what SPIQueue::run() does with the bus
+struct MockBus {
+    struct transaction_t {
+        uint8_t csMask;
+        bytes data;
+        uint8_t waitedOn;   // the radios waited on before it
+        uint32_t busyUs;
+    };
+
+    std::vector<transaction_t> transactions;
+    uint8_t waitedOn;
+    unsigned waits;
+    bool aligned;
+
+    MockBus() : waitedOn(0), waits(0), aligned(true) {}
+
+    void waitBusy(uint8_t csMask)
+    {
+        waitedOn = csMask;
+        waits++;
+    }
+
+    void write(uint8_t csMask, uint8_t *data, uint32_t size)
+    {
+        aligned &= ((uintptr_t)data & 3) == 0;
+        transactions.push_back({csMask, bytes(data, data + size), waitedOn, 0});
+        waitedOn = 0;
+    }
+
+    void busyFor(uint8_t csMask, uint32_t us)
+    {
+        transactions.back().busyUs = us;
+    }
+
+    unsigned totalBytes() const
+    {
+        unsigned total = 0;
+        for (auto const &t : transactions)
+            total += t.data.size();
+        return total;
+    }
+};
+
+static SPIQueue queue;
+
+void setUp()
+{
+    queue.clear();
+}
+
+void tearDown() {}
+
+static void assertTransaction(const MockBus::transaction_t &t, uint8_t csMask, const bytes &expected)
+{
+    TEST_ASSERT_EQUAL(csMask, t.csMask);
+    TEST_ASSERT_EQUAL(expected.size(), t.data.size());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected.data(), t.data.data(), expected.size());
+}
+
+void test_spi_queue_in_order()
+{
+    uint8_t const a[] = {0x80, 0x01, 0x02};
+    uint8_t const b[] = {0x1A, 0x00, 0x11, 0x22, 0x33, 0x44, 0x55};
+    uint8_t const c[] = {0x83, 0x02, 0xFF, 0xFF};
+    TEST_ASSERT_TRUE(queue.add(1, a, sizeof(a), 70));
+    TEST_ASSERT_TRUE(queue.add(2, b, sizeof(b), 15));
+    TEST_ASSERT_TRUE(queue.add(3, c, sizeof(c), 100));
+    TEST_ASSERT_EQUAL(3, queue.size());
+
+    MockBus bus;
+    queue.run(bus);
+
+    TEST_ASSERT_TRUE(queue.empty());
+    TEST_ASSERT_EQUAL(3, bus.transactions.size());
+    assertTransaction(bus.transactions[0], 1, bytes(a, a + sizeof(a)));
+    assertTransaction(bus.transactions[1], 2, bytes(b, b + sizeof(b)));
+    assertTransaction(bus.transactions[2], 3, bytes(c, c + sizeof(c)));
+    // Each waits on the radios it is for, and says how long they are busy after
+    TEST_ASSERT_EQUAL(1, bus.transactions[0].waitedOn);
+    TEST_ASSERT_EQUAL(2, bus.transactions[1].waitedOn);
+    TEST_ASSERT_EQUAL(3, bus.transactions[2].waitedOn);
+    TEST_ASSERT_EQUAL(70, bus.transactions[0].busyUs);
+    TEST_ASSERT_EQUAL(15, bus.transactions[1].busyUs);
+    TEST_ASSERT_EQUAL(100, bus.transactions[2].busyUs);
+    // Straight from the pool to the SPI FIFO
+    TEST_ASSERT_TRUE(bus.aligned);
+}
+
+void test_spi_queue_merges_adjacent_registers()
+{
+    // SX127x: one byte of address with the write bit, then the values
+    uint8_t const txBase[] = {0x8E, 0x80};
+    uint8_t const rxBase[] = {0x8F, 0x00};
+    uint8_t const current[] = {0x90, 0x42};
+    TEST_ASSERT_TRUE(queue.addRegisterWrite(3, 0x0E, 1, txBase, sizeof(txBase)));
+    TEST_ASSERT_TRUE(queue.addRegisterWrite(3, 0x0F, 1, rxBase, sizeof(rxBase)));
+    TEST_ASSERT_TRUE(queue.addRegisterWrite(3, 0x10, 1, current, sizeof(current)));
+    TEST_ASSERT_EQUAL(1, queue.size());
+
+    // SX1280: opcode and a 16 bit address
+    uint8_t const first[] = {0x18, 0x09, 0x54, 0xAA, 0xBB};
+    uint8_t const second[] = {0x18, 0x09, 0x56, 0xCC};
+    TEST_ASSERT_TRUE(queue.addRegisterWrite(1, 0x0954, 3, first, sizeof(first), 15));
+    TEST_ASSERT_TRUE(queue.addRegisterWrite(1, 0x0956, 3, second, sizeof(second), 15));
+    TEST_ASSERT_EQUAL(2, queue.size());
+
+    MockBus bus;
+    queue.run(bus);
+    TEST_ASSERT_EQUAL(2, bus.transactions.size());
+    assertTransaction(bus.transactions[0], 3, {0x8E, 0x80, 0x00, 0x42});
+    assertTransaction(bus.transactions[1], 1, {0x18, 0x09, 0x54, 0xAA, 0xBB, 0xCC});
+    TEST_ASSERT_EQUAL(15, bus.transactions[1].busyUs);
+    TEST_ASSERT_EQUAL(2, bus.waits);
+}
+
+void test_spi_queue_keeps_separate_writes_apart()
+{
+    uint8_t const opMode[] = {0x81, 0x89};
+    uint8_t const frf[] = {0x86, 0xD9, 0x06, 0x8B};
+    uint8_t const pa[] = {0x89, 0xFF};
+    uint8_t const fifo[] = {0x80, 0x01, 0x02};
+    uint8_t const fifoPtr[] = {0x8D, 0x00};
+    uint8_t const fifoTxBase[] = {0x8E, 0x00};
+
+    // Not adjacent
+    queue.addRegisterWrite(3, 0x01, 1, opMode, sizeof(opMode));
+    queue.addRegisterWrite(3, 0x06, 1, frf, sizeof(frf));
+    // Adjacent, but to another radio
+    queue.addRegisterWrite(1, 0x09, 1, pa, sizeof(pa));
+    // The FIFO is queued as a plain write, and a register write after it doesn't merge into it
+    queue.add(1, fifo, sizeof(fifo));
+    queue.addRegisterWrite(1, 0x0D, 1, fifoPtr, sizeof(fifoPtr));
+    queue.add(1, fifoTxBase, sizeof(fifoTxBase));
+    TEST_ASSERT_EQUAL(6, queue.size());
+
+    MockBus bus;
+    queue.run(bus);
+    TEST_ASSERT_EQUAL(6, bus.transactions.size());
+    assertTransaction(bus.transactions[1], 3, {0x86, 0xD9, 0x06, 0x8B});
+    assertTransaction(bus.transactions[2], 1, {0x89, 0xFF});
+    assertTransaction(bus.transactions[5], 1, {0x8E, 0x00});
+}
+
+void test_spi_queue_limits()
+{
+    // A merge stops at what one transfer can carry
+    uint8_t reg[1 + 20] = {0x80};
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        reg[0] = 0x80 | (0x10 + i * 20);
+        TEST_ASSERT_TRUE(queue.addRegisterWrite(1, 0x10 + i * 20, 1, reg, sizeof(reg)));
+    }
+    TEST_ASSERT_EQUAL(1, queue.size());
+    reg[0] = 0x80 | 0x4C;
+    TEST_ASSERT_TRUE(queue.addRegisterWrite(1, 0x4C, 1, reg, sizeof(reg)));
+    TEST_ASSERT_EQUAL(2, queue.size());
+
+    // Too big to send at all
+    uint8_t big[SPIQUEUE_MAX_TRANSFER + 1] = {};
+    TEST_ASSERT_FALSE(queue.add(1, big, sizeof(big)));
+
+    // Out of transactions
+    queue.clear();
+    uint8_t const cmd[] = {0x80, 0x00};
+    for (uint8_t i = 0; i < SPIQUEUE_MAX_TRANSACTIONS; i++)
+    {
+        TEST_ASSERT_TRUE(queue.add(1, cmd, sizeof(cmd)));
+    }
+    TEST_ASSERT_FALSE(queue.add(1, cmd, sizeof(cmd)));
+    TEST_ASSERT_FALSE(queue.addRegisterWrite(2, 0x01, 1, cmd, sizeof(cmd)));
+
+    // Out of pool
+    queue.clear();
+    uint8_t const frame[SPIQUEUE_MAX_TRANSFER] = {};
+    for (unsigned i = 0; i < SPIQUEUE_POOL_SIZE / SPIQUEUE_MAX_TRANSFER; i++)
+    {
+        TEST_ASSERT_TRUE(queue.add(1, frame, sizeof(frame)));
+    }
+    TEST_ASSERT_FALSE(queue.add(1, cmd, sizeof(cmd)));
+    TEST_ASSERT_EQUAL(SPIQUEUE_POOL_SIZE / SPIQUEUE_MAX_TRANSFER, queue.size());
+}
+
+// The SPI for a Gemini TX on the SX1280, as SX1280Driver::TXnb() queues it with OTA8 packets
+void test_spi_queue_gemini_tx()
+{
+    uint8_t const setFs[] = {0xC1, 0x00};
+    uint8_t buffer1[2 + 13] = {0x1A, 0x00};
+    uint8_t buffer2[2 + 13] = {0x1A, 0x00};
+    uint8_t const setTx[] = {0x83, 0x02, 0xFF, 0xFF};
+    for (uint8_t i = 0; i < 13; i++)
+    {
+        buffer1[2 + i] = i;
+        buffer2[2 + i] = 0x80 | i;
+    }
+
+    queue.add(1, buffer1, sizeof(buffer1), 15);
+    queue.add(2, buffer2, sizeof(buffer2), 15);
+    queue.add(3, setTx, sizeof(setTx), 100);
+    MockBus gemini;
+    queue.run(gemini);
+    TEST_ASSERT_EQUAL(3, gemini.transactions.size());
+    TEST_ASSERT_EQUAL(2 * 15 + 4, gemini.totalBytes());
+    TEST_ASSERT_EQUAL(3, gemini.waits);
+    // Each buffer only waits on its own radio
+    TEST_ASSERT_EQUAL(1, gemini.transactions[0].waitedOn);
+    TEST_ASSERT_EQUAL(2, gemini.transactions[1].waitedOn);
+    TEST_ASSERT_EQUAL(3, gemini.transactions[2].waitedOn);
+
+    // Diversity TX on radio 2, the other is put in FS first
+    queue.add(1, setFs, sizeof(setFs), 70);
+    queue.add(2, buffer2, sizeof(buffer2), 15);
+    queue.add(2, setTx, sizeof(setTx), 100);
+    MockBus diversity;
+    queue.run(diversity);
+    TEST_ASSERT_EQUAL(3, diversity.transactions.size());
+    TEST_ASSERT_EQUAL(2 + 15 + 4, diversity.totalBytes());
+    TEST_ASSERT_EQUAL(1, diversity.transactions[0].waitedOn);
+    TEST_ASSERT_EQUAL(2, diversity.transactions[1].waitedOn);
+}
+
+// SX127xDriver::ConfigLoraDefaults() up to the first read, one transaction fewer than the writes
+void test_spi_queue_sx127x_config()
+{
+    struct { uint8_t reg; uint8_t value; } const writes[] = {
+        {0x01, 0x00}, // OP_MODE sleep
+        {0x01, 0x80}, // OP_MODE LoRa
+        {0x01, 0x81}, // OP_MODE standby
+        {0x22, 0x08}, // PAYLOAD_LENGTH
+        {0x39, 0x12}, // SYNC_WORD
+        {0x0E, 0x00}, // FIFO_TX_BASE_ADDR
+        {0x0F, 0x00}, // FIFO_RX_BASE_ADDR
+    };
+    unsigned const count = sizeof(writes) / sizeof(writes[0]);
+    for (unsigned i = 0; i < count; i++)
+    {
+        uint8_t const buf[] = {(uint8_t)(writes[i].reg | 0x80), writes[i].value};
+        TEST_ASSERT_TRUE(queue.addRegisterWrite(3, writes[i].reg, 1, buf, sizeof(buf)));
+    }
+
+    MockBus bus;
+    queue.run(bus);
+    TEST_ASSERT_EQUAL(count - 1, bus.transactions.size());
+    TEST_ASSERT_EQUAL(2 * count - 1, bus.totalBytes());
+    assertTransaction(bus.transactions.back(), 3, {0x8E, 0x00, 0x00});
+}
+
+// Simulated radios for SPIQueue::runReady(): each is busy for a while after a command, with a clock
+// that moves on with the SPI transfers and with any time spent spinning on BUSY
+struct SimBus : MockBus {
+    uint32_t now;
+    uint32_t busyUntil[2];
+    uint32_t spun;      // time spent in waitBusy()
+
+    SimBus() : now(0), busyUntil{0, 0}, spun(0) {}
+
+    bool isBusy(uint8_t radio) const { return busyUntil[radio] > now; }
+
+    bool ready(uint8_t csMask)
+    {
+        return !((csMask & 1) && isBusy(0)) && !((csMask & 2) && isBusy(1));
+    }
+
+    void waitBusy(uint8_t csMask)
+    {
+        MockBus::waitBusy(csMask);
+        while (!ready(csMask))
+        {
+            now++;
+            spun++;
+        }
+    }
+
+    void write(uint8_t csMask, uint8_t *data, uint32_t size)
+    {
+        MockBus::write(csMask, data, size);
+        now += (size + 1) / 2; // about 2 bytes a us at 17.5MHz
+    }
+
+    void busyFor(uint8_t csMask, uint32_t us)
+    {
+        MockBus::busyFor(csMask, us);
+        for (uint8_t radio = 0; radio < 2; radio++)
+        {
+            if (csMask & (1 << radio))
+                busyUntil[radio] = now + us;
+        }
+    }
+
+    // Move the clock on to the next BUSY falling edge, false if neither radio is busy
+    bool nextEdge()
+    {
+        uint32_t edge = UINT32_MAX;
+        for (uint8_t radio = 0; radio < 2; radio++)
+        {
+            if (isBusy(radio) && busyUntil[radio] < edge)
+                edge = busyUntil[radio];
+        }
+        if (edge == UINT32_MAX)
+            return false;
+        now = edge;
+        return true;
+    }
+};
+
+// Sends what the radios are ready for, then the rest from each BUSY falling edge as the interrupt would
+static unsigned runFromBusyInterrupt(SimBus &bus)
+{
+    unsigned interrupts = 0;
+    bool done = queue.runReady(bus);
+    while (!done && bus.nextEdge())
+    {
+        interrupts++;
+        done = queue.runReady(bus);
+    }
+    TEST_ASSERT_TRUE(done);
+    return interrupts;
+}
+
+// The Gemini TX again, with both radios still busy from putting them in FS
+static void queueGeminiTx(SimBus &bus)
+{
+    static uint8_t buffer1[2 + 13] = {0x1A, 0x00};
+    static uint8_t buffer2[2 + 13] = {0x1A, 0x00};
+    static uint8_t const setTx[] = {0x83, 0x02, 0xFF, 0xFF};
+    bus.busyUntil[0] = 50;
+    bus.busyUntil[1] = 70;
+    queue.add(1, buffer1, sizeof(buffer1), 15);
+    queue.add(2, buffer2, sizeof(buffer2), 15);
+    queue.add(3, setTx, sizeof(setTx), 100);
+}
+
+void test_spi_queue_busy_interrupt()
+{
+    SimBus spin;
+    queueGeminiTx(spin);
+    queue.run(spin);
+    TEST_ASSERT_TRUE(queue.empty());
+    uint32_t const txStart = spin.now;
+    // Every command waited out BUSY in the ISR
+    TEST_ASSERT_TRUE(spin.spun > 50);
+
+    SimBus sim;
+    queueGeminiTx(sim);
+    // The ISR that queued it has nothing to send yet and returns straight away
+    TEST_ASSERT_FALSE(queue.runReady(sim));
+    TEST_ASSERT_EQUAL(0, sim.transactions.size());
+    TEST_ASSERT_EQUAL(3, queue.size());
+
+    // Radio 1 then radio 2 come out of FS, then the TX waits on both of them being done with the buffers
+    TEST_ASSERT_EQUAL(3, runFromBusyInterrupt(sim));
+    TEST_ASSERT_TRUE(queue.empty());
+    TEST_ASSERT_EQUAL(0, sim.waits);
+    TEST_ASSERT_EQUAL(0, sim.spun);
+    // Same transactions in the same order, and the TX starts no later
+    TEST_ASSERT_EQUAL(spin.transactions.size(), sim.transactions.size());
+    for (unsigned i = 0; i < sim.transactions.size(); i++)
+    {
+        assertTransaction(sim.transactions[i], spin.transactions[i].csMask, spin.transactions[i].data);
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(txStart, sim.now);
+}
+
+void test_spi_queue_busy_interrupt_append()
+{
+    SimBus sim;
+    uint8_t const setFs[] = {0xC1, 0x00};
+    uint8_t const first[] = {0x18, 0x09, 0x54, 0xAA};
+    uint8_t const second[] = {0x18, 0x09, 0x55, 0xBB};
+    uint8_t const setRx[] = {0x82, 0x02, 0xFF, 0xFF};
+
+    queue.add(1, setFs, sizeof(setFs), 70);
+    queue.addRegisterWrite(1, 0x0954, 3, first, sizeof(first), 15);
+    // FS goes out now, the register write is left for BUSY
+    TEST_ASSERT_FALSE(queue.runReady(sim));
+    TEST_ASSERT_EQUAL(1, sim.transactions.size());
+    TEST_ASSERT_EQUAL(1, queue.size());
+
+    // Another batch before the edge goes on the end, and can still merge into what is unsent
+    TEST_ASSERT_TRUE(queue.addRegisterWrite(1, 0x0955, 3, second, sizeof(second), 15));
+    TEST_ASSERT_TRUE(queue.add(1, setRx, sizeof(setRx), 100));
+    TEST_ASSERT_EQUAL(2, queue.size());
+
+    TEST_ASSERT_EQUAL(2, runFromBusyInterrupt(sim));
+    TEST_ASSERT_EQUAL(3, sim.transactions.size());
+    assertTransaction(sim.transactions[0], 1, {0xC1, 0x00});
+    assertTransaction(sim.transactions[1], 1, {0x18, 0x09, 0x54, 0xAA, 0xBB});
+    assertTransaction(sim.transactions[2], 1, {0x82, 0x02, 0xFF, 0xFF});
+
+    // A synchronous read in the meantime sends the rest the old way
+    queue.add(1, setFs, sizeof(setFs), 70);
+    queue.add(1, setRx, sizeof(setRx), 100);
+    TEST_ASSERT_FALSE(queue.runReady(sim));
+    queue.run(sim);
+    TEST_ASSERT_TRUE(queue.empty());
+    TEST_ASSERT_EQUAL(5, sim.transactions.size());
+    TEST_ASSERT_EQUAL(2, sim.waits);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_spi_queue_in_order);
+    RUN_TEST(test_spi_queue_merges_adjacent_registers);
+    RUN_TEST(test_spi_queue_keeps_separate_writes_apart);
+    RUN_TEST(test_spi_queue_limits);
+    RUN_TEST(test_spi_queue_gemini_tx);
+    RUN_TEST(test_spi_queue_sx127x_config);
+    RUN_TEST(test_spi_queue_busy_interrupt);
+    RUN_TEST(test_spi_queue_busy_interrupt_append);
+    UNITY_END();
+
+    return 0;
+}
@@ -504,6 +504,223 @@ void test_stubborn_link_forlorn_receiver(void)
     receiver.Unlock();
 }
 
+#define WINDOW_FLAG STUBBORN_WINDOW_FLAG(ELRS4_MSP_INDEX_BITS)
+#define WINDOW_LAST STUBBORN_WINDOW_LAST(ELRS4_MSP_INDEX_BITS)
+
+static void windowSetup()
+{
+    sender.setMaxPackageIndex(ELRS_MSP_MAX_PACKAGES);
+    sender.SetWindowIndexBits(ELRS4_MSP_INDEX_BITS);
+    sender.ResetState();
+    receiver.setMaxPackageIndex(ELRS_MSP_MAX_PACKAGES);
+    receiver.setWindowIndexBits(ELRS4_MSP_INDEX_BITS);
+    receiver.ResetState();
+    // The first ack from the receiver switches the sender to windowed
+    sender.ConfirmWindow(receiver.GetCurrentConfirm(), receiver.GetWindowAck());
+}
+
+void test_stubborn_window_selective_repeat(void)
+{
+    uint8_t sequence[23];
+    for (unsigned i = 0; i < sizeof(sequence); ++i)
+        sequence[i] = i + 1;
+    uint8_t dataReceiver[ELRS_MSP_BUFFER] = {0};
+    uint8_t dataOta[ELRS4_MSP_BYTES_PER_CALL];
+    uint8_t packageIndex;
+
+    windowSetup();
+    receiver.SetDataToReceive(dataReceiver, sizeof(dataReceiver));
+    sender.SetDataToTransmit(sequence, sizeof(sequence));
+    TEST_ASSERT_TRUE(sender.IsWindowed());
+    bool const parity = sender.GetCurrentParity();
+
+    // The whole window goes out without waiting for an ack, chunk 2 is lost
+    for (uint8_t chunk = 1; chunk <= STUBBORN_WINDOW_SIZE; ++chunk)
+    {
+        packageIndex = sender.GetCurrentPayload(dataOta, sizeof(dataOta));
+        TEST_ASSERT_EQUAL(WINDOW_FLAG | chunk, packageIndex);
+        TEST_ASSERT_TRUE(receiver.IsWindowIndex(packageIndex));
+        if (chunk != 2)
+            receiver.ReceiveWindowData(packageIndex, parity, dataOta, sizeof(dataOta));
+    }
+    TEST_ASSERT_EQUAL(parity, receiver.GetCurrentConfirm());
+    // 1 in sequence, then 3 and 4
+    TEST_ASSERT_EQUAL(1 | (0b011 << STUBBORN_WINDOW_ACK_BITS_SHIFT), receiver.GetWindowAck());
+    sender.ConfirmWindow(receiver.GetCurrentConfirm(), receiver.GetWindowAck());
+
+    // Only the lost chunk is resent, then the window moves on to the last
+    packageIndex = sender.GetCurrentPayload(dataOta, sizeof(dataOta));
+    TEST_ASSERT_EQUAL(WINDOW_FLAG | 2, packageIndex);
+    receiver.ReceiveWindowData(packageIndex, parity, dataOta, sizeof(dataOta));
+    packageIndex = sender.GetCurrentPayload(dataOta, sizeof(dataOta));
+    TEST_ASSERT_EQUAL(WINDOW_FLAG | WINDOW_LAST | 5, packageIndex);
+    TEST_ASSERT_FALSE(receiver.HasFinishedData());
+    receiver.ReceiveWindowData(packageIndex, parity, dataOta, sizeof(dataOta));
+
+    TEST_ASSERT_TRUE(receiver.HasFinishedData());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(sequence, dataReceiver, sizeof(sequence));
+    TEST_ASSERT_EQUAL(5, receiver.GetWindowAck());
+    TEST_ASSERT_TRUE(sender.IsActive());
+    sender.ConfirmWindow(receiver.GetCurrentConfirm(), receiver.GetWindowAck());
+    TEST_ASSERT_FALSE(sender.IsActive());
+
+    // A resend of the finished message is not taken as a new one
+    receiver.Unlock();
+    receiver.ReceiveWindowData(WINDOW_FLAG | WINDOW_LAST | 5, parity, dataOta, sizeof(dataOta));
+    TEST_ASSERT_FALSE(receiver.HasFinishedData());
+}
+
+void test_stubborn_window_abandoned_message(void)
+{
+    uint8_t sequence1[] = {1, 2, 3, 4, 5, 6, 7};
+    uint8_t sequence2[] = {11, 12, 13, 14, 15, 16, 17, 18};
+    uint8_t dataReceiver[ELRS_MSP_BUFFER] = {0};
+    uint8_t dataOta[ELRS4_MSP_BYTES_PER_CALL];
+    uint8_t packageIndex;
+
+    windowSetup();
+    receiver.SetDataToReceive(dataReceiver, sizeof(dataReceiver));
+
+    // The receiver only gets the first chunk of the first message, which is then abandoned
+    sender.SetDataToTransmit(sequence1, sizeof(sequence1));
+    bool const parity1 = sender.GetCurrentParity();
+    packageIndex = sender.GetCurrentPayload(dataOta, sizeof(dataOta));
+    receiver.ReceiveWindowData(packageIndex, parity1, dataOta, sizeof(dataOta));
+    for (unsigned i = 0; i <= 2 * sender.GetMaxPacketsBeforeResync() && sender.IsActive(); ++i)
+    {
+        sender.GetCurrentPayload(dataOta, sizeof(dataOta));
+        sender.ConfirmWindow(receiver.GetCurrentConfirm(), receiver.GetWindowAck());
+    }
+    TEST_ASSERT_FALSE(sender.IsActive());
+
+    // The next message takes the other parity, so the receiver starts over without a resync
+    sender.SetDataToTransmit(sequence2, sizeof(sequence2));
+    TEST_ASSERT_NOT_EQUAL(parity1, sender.GetCurrentParity());
+    while (sender.IsActive())
+    {
+        packageIndex = sender.GetCurrentPayload(dataOta, sizeof(dataOta));
+        receiver.ReceiveWindowData(packageIndex, sender.GetCurrentParity(), dataOta, sizeof(dataOta));
+        sender.ConfirmWindow(receiver.GetCurrentConfirm(), receiver.GetWindowAck());
+    }
+    TEST_ASSERT_TRUE(receiver.HasFinishedData());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(sequence2, dataReceiver, sizeof(sequence2));
+    receiver.Unlock();
+}
+
+void test_stubborn_window_legacy_peer(void)
+{
+    uint8_t sequence[] = {1, 2, 3, 4, 5, 6, 7};
+    uint8_t dataOta[ELRS4_MSP_BYTES_PER_CALL];
+
+    windowSetup();
+    // A receiver that does not advertise windowing gets stop-and-wait indexes
+    sender.SetPeerWindowed(false);
+    sender.SetDataToTransmit(sequence, sizeof(sequence));
+    TEST_ASSERT_FALSE(sender.IsWindowed());
+    TEST_ASSERT_EQUAL(1, sender.GetCurrentPayload(dataOta, sizeof(dataOta)));
+}
+
+/*
+ * Simulated MSP uplink at a 1:8 telemetry ratio, the TX alternates MSP and RC
+ * packets and the RX acks in every telemetry slot. Both directions lose packets
+ * at the same rate. Returns the number of messages delivered intact in `slots`
+ */
+static unsigned simulateMspLink(bool windowed, unsigned lossPct, unsigned slots)
+{
+    const unsigned tlmDenom = 8;
+    const uint8_t msgLen = 40;
+    uint8_t txMessage[msgLen];
+    uint8_t dataReceiver[ELRS_MSP_BUFFER];
+    uint8_t dataOta[ELRS4_MSP_BYTES_PER_CALL];
+    uint32_t rng = 0x1234567;
+    auto lost = [&rng, lossPct]() {
+        rng = rng * 1103515245 + 12345;
+        return ((rng >> 16) % 100) < lossPct;
+    };
+
+    sender.setMaxPackageIndex(ELRS_MSP_MAX_PACKAGES);
+    sender.SetWindowIndexBits(ELRS4_MSP_INDEX_BITS);
+    sender.ResetState();
+    receiver.setMaxPackageIndex(ELRS_MSP_MAX_PACKAGES);
+    receiver.setWindowIndexBits(ELRS4_MSP_INDEX_BITS);
+    receiver.ResetState();
+    receiver.SetDataToReceive(dataReceiver, sizeof(dataReceiver));
+
+    uint8_t nextSeq = 0;
+    uint8_t lastSeq = 0xff;
+    unsigned delivered = 0;
+    bool nextIsMsp = true;
+    for (unsigned slot = 0; slot < slots; ++slot)
+    {
+        // Main loops
+        if (!sender.IsActive())
+        {
+            txMessage[0] = nextSeq;
+            for (unsigned i = 1; i < msgLen; ++i)
+                txMessage[i] = nextSeq * 7 + i;
+            ++nextSeq;
+            sender.SetDataToTransmit(txMessage, msgLen);
+        }
+        if (receiver.HasFinishedData())
+        {
+            uint8_t const seq = dataReceiver[0];
+            for (unsigned i = 1; i < msgLen; ++i)
+                TEST_ASSERT_EQUAL_UINT8((uint8_t)(seq * 7 + i), dataReceiver[i]);
+            // Abandoned messages are skipped, but none are delivered twice or out of order
+            TEST_ASSERT_LESS_THAN(0x80, (uint8_t)(seq - lastSeq - 1));
+            lastSeq = seq;
+            ++delivered;
+            receiver.Unlock();
+            receiver.SetDataToReceive(dataReceiver, sizeof(dataReceiver));
+        }
+
+        if (slot % tlmDenom == tlmDenom - 1)
+        {
+            bool const confirm = receiver.GetCurrentConfirm();
+            uint8_t const ack = receiver.GetWindowAck();
+            if (lost())
+                continue;
+            sender.ConfirmCurrentPayload(confirm);
+            if (windowed)
+                sender.ConfirmWindow(confirm, ack);
+            else
+                sender.SetPeerWindowed(false);
+        }
+        else if (nextIsMsp && sender.IsActive())
+        {
+            nextIsMsp = false;
+            uint8_t const packageIndex = sender.GetCurrentPayload(dataOta, sizeof(dataOta));
+            bool const parity = sender.GetCurrentParity();
+            if (lost())
+                continue;
+            if (receiver.IsWindowIndex(packageIndex))
+                receiver.ReceiveWindowData(packageIndex, parity, dataOta, sizeof(dataOta));
+            else
+                receiver.ReceiveData(packageIndex, dataOta, sizeof(dataOta));
+        }
+        else
+        {
+            nextIsMsp = true;
+        }
+    }
+    return delivered;
+}
+
+void test_stubborn_window_throughput_vs_loss(void)
+{
+    const unsigned slots = 20000;
+    const unsigned lossPcts[] = {0, 5, 10, 20, 30};
+    for (unsigned lossPct : lossPcts)
+    {
+        unsigned const stopAndWait = simulateMspLink(false, lossPct, slots);
+        unsigned const windowed = simulateMspLink(true, lossPct, slots);
+        std::cout << "loss " << lossPct << "%: stop-and-wait " << stopAndWait
+                  << " msgs, windowed " << windowed << " msgs" << std::endl;
+        TEST_ASSERT_GREATER_THAN(0, stopAndWait);
+        TEST_ASSERT_GREATER_THAN(stopAndWait, windowed);
+    }
+}
+
 // Unity setup/teardown
 void setUp() {}
 void tearDown() {}
@@ -524,6 +741,10 @@ int main(int argc, char **argv)
     RUN_TEST(test_stubborn_link_variable_size_per_call);
     RUN_TEST(test_stubborn_link_premature_advance);
     RUN_TEST(test_stubborn_link_forlorn_receiver);
+    RUN_TEST(test_stubborn_window_selective_repeat);
+    RUN_TEST(test_stubborn_window_abandoned_message);
+    RUN_TEST(test_stubborn_window_legacy_peer);
+    RUN_TEST(test_stubborn_window_throughput_vs_loss);
     UNITY_END();
 
     return 0;
@@ -1,4 +1,5 @@
 #include <cstdint>
+#include <cstring>
 #include <unity.h>
 
 #include <telemetry.h>
@@ -270,6 +271,32 @@ void test_only_one_device_info(void)
     TEST_ASSERT_FALSE(hasData);
 }
 
+// A resent adaptive hopping proposal replaces the one still waiting to go out
+void test_only_one_adaptive_hopping_mask(void)
+{
+    telemetry.ResetState();
+    uint8_t sequence[] = {
+        0xc8,                   // device addr
+        15,                     // frame size
+        0x32,                   // frame type (command)
+        'a',                    // dest addr
+        'f',                    // source addr
+        0x01,                   // generation
+        0x03, 0, 0, 0, 0, 0, 0, 0, 0, 0, // channel mask
+        0x00                    // CRC
+    };
+
+    telemetry.AppendTelemetryPackage(sequence);
+    sequence[6] = 0x07;
+    telemetry.AppendTelemetryPackage(sequence);
+
+    uint8_t data[CRSF_MAX_PACKET_LEN];
+    uint8_t receivedLength;
+    TEST_ASSERT_TRUE(telemetry.GetNextPayload(&receivedLength, data));
+    TEST_ASSERT_EQUAL(0x07, data[6]);
+    TEST_ASSERT_FALSE(telemetry.GetNextPayload(&receivedLength, data));
+}
+
 void test_only_one_device_info_per_source(void)
 {
     telemetry.ResetState();
@@ -333,6 +360,116 @@ void test_prioritised_settings_entry_messages(void)
     TEST_ASSERT_EQUAL(CRSF_FRAMETYPE_BATTERY_SENSOR, payload[CRSF_TELEMETRY_TYPE_INDEX]);
 }
 
+void test_store_full_drops_oldest(void)
+{
+    telemetry.ResetState();
+    // MSP responses are all sent, so each takes its own slot
+    uint8_t mspSequence[] = {0xEC,0,0,0,0,0,0,0,0};
+    for (int i = 0; i < TELEMETRY_SLOT_COUNT + 4; i++)
+    {
+        mspSequence[5] = i;
+        CRSF::SetExtendedHeaderAndCrc(mspSequence, CRSF_FRAMETYPE_MSP_RESP, sizeof(mspSequence)-CRSF_FRAME_NOT_COUNTED_BYTES, CRSF_ADDRESS_RADIO_TRANSMITTER, CRSF_ADDRESS_CRSF_RECEIVER);
+        telemetry.AppendTelemetryPackage(mspSequence);
+    }
+    TEST_ASSERT_EQUAL(TELEMETRY_SLOT_COUNT, telemetry.UpdatedPayloadCount());
+
+    uint8_t payloadSize;
+    uint8_t payload[CRSF_MAX_PACKET_LEN];
+    for (int i = 4; i < TELEMETRY_SLOT_COUNT + 4; i++)
+    {
+        TEST_ASSERT_TRUE(telemetry.GetNextPayload(&payloadSize, payload));
+        TEST_ASSERT_EQUAL(i, payload[5]);
+    }
+    TEST_ASSERT_FALSE(telemetry.GetNextPayload(&payloadSize, payload));
+}
+
+static void appendMspResp(uint8_t *package, uint8_t size, uint8_t id)
+{
+    memset(package, 0, size);
+    package[0] = 0xEC;
+    package[5] = id;
+    CRSF::SetExtendedHeaderAndCrc(package, CRSF_FRAMETYPE_MSP_RESP, size-CRSF_FRAME_NOT_COUNTED_BYTES, CRSF_ADDRESS_RADIO_TRANSMITTER, CRSF_ADDRESS_CRSF_RECEIVER);
+    telemetry.AppendTelemetryPackage(package);
+}
+
+void test_store_pool_full_drops_oldest(void)
+{
+    telemetry.ResetState();
+    // Full size frames run out of pool bytes before they run out of slots
+    uint8_t mspSequence[CRSF_MAX_PACKET_LEN];
+    const int fit = TELEMETRY_POOL_SIZE / CRSF_MAX_PACKET_LEN;
+    for (int i = 0; i < fit + 2; i++)
+    {
+        appendMspResp(mspSequence, CRSF_MAX_PACKET_LEN, i);
+    }
+    TEST_ASSERT_EQUAL(fit, telemetry.UpdatedPayloadCount());
+    TEST_ASSERT_EQUAL(fit * CRSF_MAX_PACKET_LEN * 100 / TELEMETRY_POOL_SIZE, telemetry.GetFifoFullPct());
+
+    uint8_t payloadSize;
+    uint8_t payload[CRSF_MAX_PACKET_LEN];
+    for (int i = 2; i < fit + 2; i++)
+    {
+        TEST_ASSERT_TRUE(telemetry.GetNextPayload(&payloadSize, payload));
+        TEST_ASSERT_EQUAL(CRSF_MAX_PACKET_LEN, payloadSize);
+        TEST_ASSERT_EQUAL(i, payload[5]);
+    }
+    TEST_ASSERT_FALSE(telemetry.GetNextPayload(&payloadSize, payload));
+    TEST_ASSERT_EQUAL(0, telemetry.GetFifoFullPct());
+}
+
+void test_store_pool_reuses_freed_space(void)
+{
+    telemetry.ResetState();
+    uint8_t mspSequence[CRSF_MAX_PACKET_LEN];
+    const int fit = TELEMETRY_POOL_SIZE / CRSF_MAX_PACKET_LEN;
+    for (int i = 0; i < fit; i++)
+    {
+        appendMspResp(mspSequence, CRSF_MAX_PACKET_LEN, i);
+    }
+
+    // Sending from the front leaves the free space below the frames still waiting,
+    // the next frames have to go there without dropping any
+    uint8_t payloadSize;
+    uint8_t payload[CRSF_MAX_PACKET_LEN];
+    for (int i = 0; i < 2; i++)
+    {
+        TEST_ASSERT_TRUE(telemetry.GetNextPayload(&payloadSize, payload));
+    }
+    for (int i = fit; i < fit + 2; i++)
+    {
+        appendMspResp(mspSequence, CRSF_MAX_PACKET_LEN, i);
+    }
+    TEST_ASSERT_EQUAL(fit, telemetry.UpdatedPayloadCount());
+
+    for (int i = 2; i < fit + 2; i++)
+    {
+        TEST_ASSERT_TRUE(telemetry.GetNextPayload(&payloadSize, payload));
+        TEST_ASSERT_EQUAL(i, payload[5]);
+        TEST_ASSERT_EQUAL(CRSF_FRAMETYPE_MSP_RESP, payload[CRSF_TELEMETRY_TYPE_INDEX]);
+    }
+    TEST_ASSERT_FALSE(telemetry.GetNextPayload(&payloadSize, payload));
+}
+
+void test_store_full_keeps_settings_entry(void)
+{
+    telemetry.ResetState();
+    uint8_t settingsSequence[] = {0xEC,0,0,0,0,0,0,0,0,0,0,0};
+    CRSF::SetExtendedHeaderAndCrc(settingsSequence, CRSF_FRAMETYPE_PARAMETER_SETTINGS_ENTRY, sizeof(settingsSequence)-CRSF_FRAME_NOT_COUNTED_BYTES, CRSF_ADDRESS_CRSF_RECEIVER, CRSF_ADDRESS_RADIO_TRANSMITTER);
+    telemetry.AppendTelemetryPackage(settingsSequence);
+
+    // The oldest frame is the parameter one, but the MSP frames are dropped instead
+    uint8_t mspSequence[CRSF_MAX_PACKET_LEN];
+    for (int i = 0; i < TELEMETRY_POOL_SIZE / CRSF_MAX_PACKET_LEN + 2; i++)
+    {
+        appendMspResp(mspSequence, CRSF_MAX_PACKET_LEN, i);
+    }
+
+    uint8_t payloadSize;
+    uint8_t payload[CRSF_MAX_PACKET_LEN];
+    TEST_ASSERT_TRUE(telemetry.GetNextPayload(&payloadSize, payload));
+    TEST_ASSERT_EQUAL(CRSF_FRAMETYPE_PARAMETER_SETTINGS_ENTRY, payload[CRSF_TELEMETRY_TYPE_INDEX]);
+}
+
 // Unity setup/teardown
 void setUp() {}
 void tearDown() {}
@@ -353,7 +490,12 @@ int main(int argc, char **argv)
     RUN_TEST(test_function_add_type_with_zero_crc);
     RUN_TEST(test_only_one_device_info);
     RUN_TEST(test_only_one_device_info_per_source);
+    RUN_TEST(test_only_one_adaptive_hopping_mask);
     RUN_TEST(test_prioritised_settings_entry_messages);
+    RUN_TEST(test_store_full_drops_oldest);
+    RUN_TEST(test_store_pool_full_drops_oldest);
+    RUN_TEST(test_store_pool_reuses_freed_space);
+    RUN_TEST(test_store_full_keeps_settings_entry);
     UNITY_END();
 
     return 0;
@@ -0,0 +1,188 @@
+#include <cstdint>
+#include <cstdlib>
+#include <unity.h>
+
+#include "TimerHeap.h"
+
+void test_timer_heap_empty(void)
+{
+    TimerHeap timers(4);
+
+    TEST_ASSERT_TRUE(timers.empty());
+    TEST_ASSERT_EQUAL(-1, timers.popDue(0));
+    TEST_ASSERT_EQUAL(-1, timers.popDue(0xFFFFFFFF));
+    TEST_ASSERT_FALSE(timers.isScheduled(0));
+    // Out of range ids are ignored
+    timers.schedule(4, 0);
+    TEST_ASSERT_TRUE(timers.empty());
+    TEST_ASSERT_FALSE(timers.isScheduled(4));
+}
+
+void test_timer_heap_order(void)
+{
+    TimerHeap timers(5);
+    timers.schedule(0, 50);
+    timers.schedule(1, 10);
+    timers.schedule(2, 40);
+    timers.schedule(3, 20);
+    timers.schedule(4, 30);
+
+    TEST_ASSERT_EQUAL(5, timers.size());
+    TEST_ASSERT_EQUAL(10, timers.nextDeadline());
+    // Only what is due comes out
+    TEST_ASSERT_EQUAL(-1, timers.popDue(9));
+    TEST_ASSERT_EQUAL(1, timers.popDue(25));
+    TEST_ASSERT_EQUAL(3, timers.popDue(25));
+    TEST_ASSERT_EQUAL(-1, timers.popDue(25));
+    TEST_ASSERT_EQUAL(4, timers.popDue(30));
+    TEST_ASSERT_EQUAL(2, timers.popDue(100));
+    TEST_ASSERT_EQUAL(0, timers.popDue(100));
+    TEST_ASSERT_TRUE(timers.empty());
+}
+
+void test_timer_heap_ties_lowest_id_first(void)
+{
+    TimerHeap timers(6);
+    for (int id = 5; id >= 0; --id)
+    {
+        timers.schedule(id, 7);
+    }
+    for (int id = 0; id < 6; ++id)
+    {
+        TEST_ASSERT_EQUAL(id, timers.popDue(7));
+    }
+}
+
+void test_timer_heap_reschedule_and_cancel(void)
+{
+    TimerHeap timers(4);
+    timers.schedule(0, 100);
+    timers.schedule(1, 200);
+    timers.schedule(2, 300);
+    timers.schedule(3, 400);
+
+    // Scheduling again moves the timer rather than adding it twice
+    timers.schedule(3, 50);
+    timers.schedule(0, 500);
+    TEST_ASSERT_EQUAL(4, timers.size());
+    timers.cancel(2);
+    timers.cancel(2);
+    TEST_ASSERT_EQUAL(3, timers.size());
+    TEST_ASSERT_FALSE(timers.isScheduled(2));
+
+    TEST_ASSERT_EQUAL(3, timers.popDue(1000));
+    TEST_ASSERT_EQUAL(1, timers.popDue(1000));
+    TEST_ASSERT_EQUAL(0, timers.popDue(1000));
+    TEST_ASSERT_EQUAL(-1, timers.popDue(1000));
+}
+
+void test_timer_heap_wrap(void)
+{
+    TimerHeap timers(3);
+    uint32_t const now = 0xFFFFFF00;
+    timers.schedule(0, now + 0x200); // wraps to 0x100
+    timers.schedule(1, now + 0x10);
+    timers.schedule(2, now - 0x10);  // overdue
+
+    TEST_ASSERT_EQUAL(2, timers.popDue(now));
+    TEST_ASSERT_EQUAL(-1, timers.popDue(now));
+    TEST_ASSERT_EQUAL(1, timers.popDue(now + 0x10));
+    TEST_ASSERT_EQUAL(-1, timers.popDue(0x50));
+    TEST_ASSERT_EQUAL(0, timers.popDue(0x100));
+}
+
+void test_timer_heap_resize(void)
+{
+    TimerHeap timers(2);
+    timers.schedule(0, 1);
+    timers.resize(20);
+    TEST_ASSERT_TRUE(timers.empty());
+    for (int id = 0; id < 20; ++id)
+    {
+        timers.schedule(id, 100 - id);
+    }
+    TEST_ASSERT_EQUAL(20, timers.size());
+    TEST_ASSERT_EQUAL(19, timers.popDue(100));
+}
+
+// Drive the heap the way the device framework does, against a linear scan of every timer
+void test_timer_heap_matches_polling(void)
+{
+    const int COUNT = 24;
+    TimerHeap timers(COUNT);
+    uint32_t deadline[COUNT];
+    bool scheduled[COUNT] = {false};
+    unsigned popped = 0;
+
+    srand(1);
+    uint32_t now = 0xFFFF0000; // run across the wrap
+    for (int id = 0; id < COUNT; ++id)
+    {
+        deadline[id] = now + rand() % 100;
+        scheduled[id] = true;
+        timers.schedule(id, deadline[id]);
+    }
+
+    for (int step = 0; step < 20000; ++step)
+    {
+        now += rand() % 3;
+
+        // Random reschedules and cancels, like device events
+        int const id = rand() % COUNT;
+        switch (rand() % 8)
+        {
+        case 0:
+            deadline[id] = now + rand() % 200;
+            scheduled[id] = true;
+            timers.schedule(id, deadline[id]);
+            break;
+        case 1:
+            scheduled[id] = false;
+            timers.cancel(id);
+            break;
+        default:
+            break;
+        }
+
+        // Lowest id first among equal deadlines, the same as the heap
+        for (;;)
+        {
+            int expected = -1;
+            for (int i = 0; i < COUNT; ++i)
+            {
+                if (scheduled[i] && (int32_t)(now - deadline[i]) >= 0 &&
+                    (expected == -1 || (int32_t)(deadline[i] - deadline[expected]) < 0))
+                {
+                    expected = i;
+                }
+            }
+            int const due = timers.popDue(now);
+            TEST_ASSERT_EQUAL(expected, due);
+            if (due == -1)
+                break;
+            ++popped;
+            deadline[due] = now + 1 + rand() % 50;
+            timers.schedule(due, deadline[due]);
+        }
+    }
+    TEST_ASSERT_GREATER_THAN(1000, popped);
+}
+
+// Unity setup/teardown
+void setUp() {}
+void tearDown() {}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_timer_heap_empty);
+    RUN_TEST(test_timer_heap_order);
+    RUN_TEST(test_timer_heap_ties_lowest_id_first);
+    RUN_TEST(test_timer_heap_reschedule_and_cancel);
+    RUN_TEST(test_timer_heap_wrap);
+    RUN_TEST(test_timer_heap_resize);
+    RUN_TEST(test_timer_heap_matches_polling);
+    UNITY_END();
+
+    return 0;
+}